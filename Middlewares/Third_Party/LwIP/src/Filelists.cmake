@@ -42,12 +42,14 @@ set(lwipcore_SRCS
     ${LWIP_DIR}/src/core/netif.c
     ${LWIP_DIR}/src/core/pbuf.c
     ${LWIP_DIR}/src/core/raw.c
+    ${LWIP_DIR}/src/core/spsc_ring.c
     ${LWIP_DIR}/src/core/stats.c
     ${LWIP_DIR}/src/core/sys.c
     ${LWIP_DIR}/src/core/altcp.c
     ${LWIP_DIR}/src/core/altcp_alloc.c
     ${LWIP_DIR}/src/core/altcp_tcp.c
     ${LWIP_DIR}/src/core/tcp.c
+    ${LWIP_DIR}/src/core/tcp_cc.c
     ${LWIP_DIR}/src/core/tcp_in.c
     ${LWIP_DIR}/src/core/tcp_out.c
     ${LWIP_DIR}/src/core/timeouts.c
@@ -60,6 +62,7 @@ set(lwipcore4_SRCS
     ${LWIP_DIR}/src/core/ipv4/icmp.c
     ${LWIP_DIR}/src/core/ipv4/igmp.c
     ${LWIP_DIR}/src/core/ipv4/ip4_frag.c
+    ${LWIP_DIR}/src/core/ipv4/ip4_gro.c
     ${LWIP_DIR}/src/core/ipv4/ip4.c
     ${LWIP_DIR}/src/core/ipv4/ip4_addr.c
 )
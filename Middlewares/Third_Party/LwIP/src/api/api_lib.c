@@ -956,6 +956,43 @@ netconn_send(struct netconn *conn, struct netbuf *buf)
   return err;
 }
 
+/**
+ * @ingroup netconn_udp
+ * Send several netbufs over a UDP or RAW netconn with a single API message,
+ * i.e. one tcpip_thread round-trip (or core lock acquisition) for all of them.
+ * Each netbuf carries its own destination like for netconn_send().
+ *
+ * @param conn the UDP or RAW netconn over which to send data
+ * @param bufs array of netbufs containing the data to send
+ * @param cnt number of netbufs in 'bufs'
+ * @param sent the number of netbufs sent is stored here (sending stops at the
+ *             first error)
+ * @return ERR_OK if all netbufs were sent, the error of the first failing
+ *         netbuf otherwise
+ */
+err_t
+netconn_send_batch(struct netconn *conn, struct netbuf *bufs, u16_t cnt, u16_t *sent)
+{
+  API_MSG_VAR_DECLARE(msg);
+  err_t err;
+
+  LWIP_ERROR("netconn_send_batch: invalid conn", (conn != NULL), return ERR_ARG;);
+  LWIP_ERROR("netconn_send_batch: invalid bufs", (bufs != NULL) && (sent != NULL), return ERR_ARG;);
+
+  LWIP_DEBUGF(API_LIB_DEBUG, ("netconn_send_batch: sending %"U16_F" netbufs\n", cnt));
+
+  API_MSG_VAR_ALLOC(msg);
+  API_MSG_VAR_REF(msg).conn = conn;
+  API_MSG_VAR_REF(msg).msg.bb.bufs = bufs;
+  API_MSG_VAR_REF(msg).msg.bb.cnt = cnt;
+  API_MSG_VAR_REF(msg).msg.bb.sent = 0;
+  err = netconn_apimsg(lwip_netconn_do_send_batch, &API_MSG_VAR_REF(msg));
+  *sent = API_MSG_VAR_REF(msg).msg.bb.sent;
+  API_MSG_VAR_FREE(msg);
+
+  return err;
+}
+
 /**
  * @ingroup netconn_tcp
  * Send data over a TCP netconn.
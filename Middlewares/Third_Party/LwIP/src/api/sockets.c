@@ -259,6 +259,12 @@ static void lwip_socket_drop_registered_mld6_memberships(int s);
 /** The global array of available sockets */
 static struct lwip_sock sockets[NUM_SOCKETS];
 
+#if LWIP_SOCKET_EPOLL
+/** The global array of epoll instances, their descriptors follow the sockets */
+static struct lwip_epoll epolls[LWIP_SOCKET_MAX_EPOLL];
+#define LWIP_EPOLL_OFFSET (LWIP_SOCKET_OFFSET + NUM_SOCKETS)
+#endif /* LWIP_SOCKET_EPOLL */
+
 #if LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL
 #if LWIP_TCPIP_CORE_LOCKING
 /* protect the select_cb_list using core lock */
@@ -291,6 +297,11 @@ static void select_check_waiters(int s, int has_recvevent, int has_sendevent, in
 #else
 #define DEFAULT_SOCKET_EVENTCB NULL
 #endif
+#if LWIP_SOCKET_EPOLL
+static void lwip_epoll_notify(struct lwip_sock *sock);
+static void lwip_epoll_drop_socket(struct lwip_sock *sock);
+static int lwip_epoll_close(int epfd);
+#endif /* LWIP_SOCKET_EPOLL */
 #if !LWIP_TCPIP_CORE_LOCKING
 static void lwip_getsockopt_callback(void *arg);
 static void lwip_setsockopt_callback(void *arg);
@@ -530,6 +541,12 @@ alloc_socket(struct netconn *newconn, int accepted)
       sockets[i].sendevent  = (NETCONNTYPE_GROUP(newconn->type) == NETCONN_TCP ? (accepted != 0) : 1);
       sockets[i].errevent   = 0;
 #endif /* LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL */
+#if LWIP_SOCKET_EPOLL
+      LWIP_ASSERT("sockets[i].epoll_items == NULL", sockets[i].epoll_items == NULL);
+#endif /* LWIP_SOCKET_EPOLL */
+#if LWIP_SOCKET_RECV_ZC
+      memset(sockets[i].zc_held, 0, sizeof(sockets[i].zc_held));
+#endif /* LWIP_SOCKET_RECV_ZC */
       return i + LWIP_SOCKET_OFFSET;
     }
     SYS_ARCH_UNPROTECT(lev);
@@ -777,6 +794,12 @@ lwip_close(int s)
 
   LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_close(%d)\n", s));
 
+#if LWIP_SOCKET_EPOLL
+  if ((s >= LWIP_EPOLL_OFFSET) && (s < LWIP_EPOLL_OFFSET + LWIP_SOCKET_MAX_EPOLL)) {
+    return lwip_epoll_close(s);
+  }
+#endif /* LWIP_SOCKET_EPOLL */
+
   sock = get_socket(s);
   if (!sock) {
     return -1;
@@ -804,6 +827,11 @@ lwip_close(int s)
     return -1;
   }
 
+#if LWIP_SOCKET_EPOLL
+  /* closing a socket removes it from all epoll instances */
+  lwip_epoll_drop_socket(sock);
+#endif /* LWIP_SOCKET_EPOLL */
+
   free_socket(sock, is_tcp);
   set_errno(0);
   return 0;
@@ -1277,6 +1305,27 @@ lwip_recv(int s, void *mem, size_t len, int flags)
   return lwip_recvfrom(s, mem, len, flags, NULL, NULL);
 }
 
+/** Check the IO vectors of a message to receive into
+ *
+ * @return total length of the vectors, -1 if a vector is invalid
+ */
+static ssize_t
+lwip_recvmsg_iov_len(const struct msghdr *message)
+{
+  int i;
+  ssize_t buflen = 0;
+
+  for (i = 0; i < message->msg_iovlen; i++) {
+    if ((message->msg_iov[i].iov_base == NULL) || ((ssize_t)message->msg_iov[i].iov_len <= 0) ||
+        ((size_t)(ssize_t)message->msg_iov[i].iov_len != message->msg_iov[i].iov_len) ||
+        ((ssize_t)(buflen + (ssize_t)message->msg_iov[i].iov_len) <= 0)) {
+      return -1;
+    }
+    buflen = (ssize_t)(buflen + (ssize_t)message->msg_iov[i].iov_len);
+  }
+  return buflen;
+}
+
 ssize_t
 lwip_recvmsg(int s, struct msghdr *message, int flags)
 {
@@ -1300,16 +1349,11 @@ lwip_recvmsg(int s, struct msghdr *message, int flags)
   }
 
   /* check for valid vectors */
-  buflen = 0;
-  for (i = 0; i < message->msg_iovlen; i++) {
-    if ((message->msg_iov[i].iov_base == NULL) || ((ssize_t)message->msg_iov[i].iov_len <= 0) ||
-        ((size_t)(ssize_t)message->msg_iov[i].iov_len != message->msg_iov[i].iov_len) ||
-        ((ssize_t)(buflen + (ssize_t)message->msg_iov[i].iov_len) <= 0)) {
-      sock_set_errno(sock, err_to_errno(ERR_VAL));
-      done_socket(sock);
-      return -1;
-    }
-    buflen = (ssize_t)(buflen + (ssize_t)message->msg_iov[i].iov_len);
+  buflen = lwip_recvmsg_iov_len(message);
+  if (buflen < 0) {
+    sock_set_errno(sock, err_to_errno(ERR_VAL));
+    done_socket(sock);
+    return -1;
   }
 
   if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
@@ -1378,218 +1422,700 @@ lwip_recvmsg(int s, struct msghdr *message, int flags)
 #endif /* LWIP_UDP || LWIP_RAW */
 }
 
-ssize_t
-lwip_send(int s, const void *data, size_t size, int flags)
+
+/**
+ * @ingroup socket
+ * Receive several messages with one call: for UDP and RAW sockets, the
+ * socket is looked up and checked once for all datagrams. With MSG_WAITFORONE,
+ * only the first datagram is waited for. TCP sockets receive the messages one
+ * by one.
+ *
+ * @param timeout unsupported, must be NULL (use SO_RCVTIMEO instead)
+ * @return the number of messages received (their msg_len is set), -1 if the
+ *         first one failed
+ */
+int
+lwip_recvmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags, struct timeval *timeout)
 {
   struct lwip_sock *sock;
-  err_t err;
-  u8_t write_flags;
-  size_t written;
+  unsigned int received = 0;
+  int recv_flags = flags & ~MSG_WAITFORONE;
+  err_t err = ERR_OK;
 
-  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send(%d, data=%p, size=%"SZT_F", flags=0x%x)\n",
-                              s, data, size, flags));
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvmmsg(%d, msgvec=%p, vlen=%u, flags=0x%x)\n", s, (void *)msgvec, vlen, flags));
+  LWIP_ERROR("lwip_recvmmsg: invalid msgvec", (msgvec != NULL) || (vlen == 0),
+             set_errno(EFAULT); return -1;);
+  LWIP_ERROR("lwip_recvmmsg: unsupported flags", (flags & ~(MSG_PEEK | MSG_DONTWAIT | MSG_WAITFORONE)) == 0,
+             set_errno(EOPNOTSUPP); return -1;);
+  LWIP_ERROR("lwip_recvmmsg: timeout not supported", timeout == NULL,
+             set_errno(EINVAL); return -1;);
 
   sock = get_socket(s);
   if (!sock) {
     return -1;
   }
 
-  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) != NETCONN_TCP) {
-#if (LWIP_UDP || LWIP_RAW)
-    done_socket(sock);
-    return lwip_sendto(s, data, size, flags, NULL, 0);
-#else /* (LWIP_UDP || LWIP_RAW) */
-    sock_set_errno(sock, err_to_errno(ERR_ARG));
+  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
     done_socket(sock);
-    return -1;
-#endif /* (LWIP_UDP || LWIP_RAW) */
+    for (received = 0; received < vlen; received++) {
+      ssize_t ret = lwip_recvmsg(s, &msgvec[received].msg_hdr, recv_flags);
+      if (ret < 0) {
+        break;
+      }
+      msgvec[received].msg_len = (unsigned int)ret;
+      if (ret == 0) {
+        /* connection closed */
+        received++;
+        break;
+      }
+      if (flags & MSG_WAITFORONE) {
+        recv_flags |= MSG_DONTWAIT;
+      }
+    }
+    return ((received > 0) || (vlen == 0)) ? (int)received : -1;
   }
+  /* else, UDP and RAW NETCONNs */
+#if LWIP_UDP || LWIP_RAW
+  for (received = 0; received < vlen; received++) {
+    struct msghdr *message = &msgvec[received].msg_hdr;
+    u16_t datagram_len = 0;
+    ssize_t buflen;
 
-  write_flags = (u8_t)(NETCONN_COPY |
-                       ((flags & MSG_MORE)     ? NETCONN_MORE      : 0) |
-                       ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0));
-  written = 0;
-  err = netconn_write_partly(sock->conn, data, size, write_flags, &written);
+    if ((message->msg_iovlen <= 0) || (message->msg_iovlen > IOV_MAX)) {
+      err = ERR_VAL;
+      break;
+    }
+    buflen = lwip_recvmsg_iov_len(message);
+    if (buflen < 0) {
+      err = ERR_VAL;
+      break;
+    }
+    err = lwip_recvfrom_udp_raw(sock, recv_flags, message, &datagram_len, s);
+    if (err != ERR_OK) {
+      break;
+    }
+    if (datagram_len > buflen) {
+      message->msg_flags |= MSG_TRUNC;
+    }
+    msgvec[received].msg_len = datagram_len;
+    if (flags & MSG_PEEK) {
+      /* peeking again would return the same datagram */
+      received++;
+      break;
+    }
+    if (flags & MSG_WAITFORONE) {
+      recv_flags |= MSG_DONTWAIT;
+    }
+  }
+#else /* LWIP_UDP || LWIP_RAW */
+  err = ERR_ARG;
+#endif /* LWIP_UDP || LWIP_RAW */
 
-  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send(%d) err=%d written=%"SZT_F"\n", s, err, written));
-  sock_set_errno(sock, err_to_errno(err));
+  if ((received == 0) && (vlen > 0)) {
+    LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvmmsg(%d): error is \"%s\"!\n", s, lwip_strerr(err)));
+    sock_set_errno(sock, err_to_errno(err));
+    done_socket(sock);
+    return -1;
+  }
+  sock_set_errno(sock, 0);
   done_socket(sock);
-  /* casting 'written' to ssize_t is OK here since the netconn API limits it to SSIZE_MAX */
-  return (err == ERR_OK ? (ssize_t)written : -1);
+  return (int)received;
 }
 
-ssize_t
-lwip_sendmsg(int s, const struct msghdr *msg, int flags)
-{
-  struct lwip_sock *sock;
+#if LWIP_SOCKET_RECV_ZC
 #if LWIP_TCP
-  u8_t write_flags;
-  size_t written;
-#endif
-  err_t err = ERR_OK;
+/* Helper function for lwip_recv_tcp_zc: detach the first "len" bytes of the
+ * chain "*p" into "*head" and leave the rest in "*p" (NULL if all was taken).
+ * Whole pbufs are handed over as they are; only a pbuf straddling "len" has
+ * its first part copied.
+ */
+static err_t
+lwip_recv_zc_split(struct pbuf **p, u16_t len, struct pbuf **head)
+{
+  struct pbuf *q, *last = NULL, *rest;
+  u16_t taken = 0;
 
-  sock = get_socket(s);
-  if (!sock) {
-    return -1;
+  for (q = *p; (q != NULL) && (q->len <= len - taken); q = q->next) {
+    taken = (u16_t)(taken + q->len);
+    last = q;
+  }
+  if (q == NULL) {
+    *head = *p;
+    *p = NULL;
+    return ERR_OK;
+  }
+  rest = q;
+  if (last != NULL) {
+    /* cut the chain behind 'last': the reference 'last' held on 'rest'
+       now belongs to the caller's rest pointer */
+    for (q = *p; q != rest; q = q->next) {
+      q->tot_len = (u16_t)(q->tot_len - rest->tot_len);
+    }
+    last->next = NULL;
+    *head = *p;
+  } else {
+    *head = NULL;
+  }
+  if (taken < len) {
+    u16_t part = (u16_t)(len - taken);
+    struct pbuf *copy = pbuf_alloc(PBUF_RAW, part, PBUF_RAM);
+    if (copy == NULL) {
+      if (*head == NULL) {
+        return ERR_MEM;
+      }
+    } else {
+      pbuf_copy_partial(rest, copy->payload, part, 0);
+      rest = pbuf_free_header(rest, part);
+      if (*head == NULL) {
+        *head = copy;
+      } else {
+        pbuf_cat(*head, copy);
+      }
+    }
   }
+  *p = rest;
+  return ERR_OK;
+}
 
-  LWIP_ERROR("lwip_sendmsg: invalid msghdr", msg != NULL,
-             sock_set_errno(sock, err_to_errno(ERR_ARG)); done_socket(sock); return -1;);
-  LWIP_ERROR("lwip_sendmsg: invalid msghdr iov", msg->msg_iov != NULL,
-             sock_set_errno(sock, err_to_errno(ERR_ARG)); done_socket(sock); return -1;);
-  LWIP_ERROR("lwip_sendmsg: maximum iovs exceeded", (msg->msg_iovlen > 0) && (msg->msg_iovlen <= IOV_MAX),
-             sock_set_errno(sock, EMSGSIZE); done_socket(sock); return -1;);
-  LWIP_ERROR("lwip_sendmsg: unsupported flags", (flags & ~(MSG_DONTWAIT | MSG_MORE)) == 0,
-             sock_set_errno(sock, EOPNOTSUPP); done_socket(sock); return -1;);
+/* Give back a zc_held entry reserved by lwip_recv_tcp_zc() that ends up
+ * not holding a chain */
+static void
+lwip_recv_zc_unreserve(struct lwip_sock_zc_held *held)
+{
+  SYS_ARCH_DECL_PROTECT(lev);
 
-  LWIP_UNUSED_ARG(msg->msg_control);
-  LWIP_UNUSED_ARG(msg->msg_controllen);
-  LWIP_UNUSED_ARG(msg->msg_flags);
+  SYS_ARCH_PROTECT(lev);
+  held->in_use = 0;
+  SYS_ARCH_UNPROTECT(lev);
+}
 
-  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
-#if LWIP_TCP
-    write_flags = (u8_t)(NETCONN_COPY |
-                         ((flags & MSG_MORE)     ? NETCONN_MORE      : 0) |
-                         ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0));
+/* Zero-copy variant of lwip_recv_tcp: chains up to "len" received bytes into
+ * "*out" without copying them and without updating the receive window.
+ */
+static ssize_t
+lwip_recv_tcp_zc(struct lwip_sock *sock, struct pbuf **out, size_t len, int flags)
+{
+  u8_t apiflags = NETCONN_NOAUTORCVD;
+  u16_t recvd = 0;
+  u16_t recv_left = (len <= 0xFFFF) ? (u16_t)len : 0xFFFF;
+  struct lwip_sock_zc_held *held = NULL;
+  int i;
+  SYS_ARCH_DECL_PROTECT(lev);
 
-    written = 0;
-    err = netconn_write_vectors_partly(sock->conn, (struct netvector *)msg->msg_iov, (u16_t)msg->msg_iovlen, write_flags, &written);
-    sock_set_errno(sock, err_to_errno(err));
-    done_socket(sock);
-    /* casting 'written' to ssize_t is OK here since the netconn API limits it to SSIZE_MAX */
-    return (err == ERR_OK ? (ssize_t)written : -1);
-#else /* LWIP_TCP */
-    sock_set_errno(sock, err_to_errno(ERR_ARG));
-    done_socket(sock);
+  /* reserve the entry right away so concurrent receivers don't pick it too */
+  SYS_ARCH_PROTECT(lev);
+  for (i = 0; i < LWIP_SOCKET_RECV_ZC_MAX; i++) {
+    if (!sock->zc_held[i].in_use) {
+      held = &sock->zc_held[i];
+      held->in_use = 1;
+      break;
+    }
+  }
+  SYS_ARCH_UNPROTECT(lev);
+  if (held == NULL) {
+    sock_set_errno(sock, ENOBUFS);
     return -1;
-#endif /* LWIP_TCP */
   }
-  /* else, UDP and RAW NETCONNs */
-#if LWIP_UDP || LWIP_RAW
-  {
-    struct netbuf chain_buf;
-    int i;
-    ssize_t size = 0;
 
-    LWIP_UNUSED_ARG(flags);
-    LWIP_ERROR("lwip_sendmsg: invalid msghdr name", (((msg->msg_name == NULL) && (msg->msg_namelen == 0)) ||
-               IS_SOCK_ADDR_LEN_VALID(msg->msg_namelen)),
-               sock_set_errno(sock, err_to_errno(ERR_ARG)); done_socket(sock); return -1;);
+  if (flags & MSG_DONTWAIT) {
+    apiflags |= NETCONN_DONTBLOCK;
+  }
 
-    /* initialize chain buffer with destination */
-    memset(&chain_buf, 0, sizeof(struct netbuf));
-    if (msg->msg_name) {
-      u16_t remote_port;
-      SOCKADDR_TO_IPADDR_PORT((const struct sockaddr *)msg->msg_name, &chain_buf.addr, remote_port);
-      netbuf_fromport(&chain_buf) = remote_port;
-    }
-#if LWIP_NETIF_TX_SINGLE_PBUF
-    for (i = 0; i < msg->msg_iovlen; i++) {
-      size += msg->msg_iov[i].iov_len;
-      if ((msg->msg_iov[i].iov_len > INT_MAX) || (size < (int)msg->msg_iov[i].iov_len)) {
-        /* overflow */
-        goto sendmsg_emsgsize;
-      }
-    }
-    if (size > 0xFFFF) {
-      /* overflow */
-      goto sendmsg_emsgsize;
-    }
-    /* Allocate a new netbuf and copy the data into it. */
-    if (netbuf_alloc(&chain_buf, (u16_t)size) == NULL) {
-      err = ERR_MEM;
+  while (recv_left > 0) {
+    struct pbuf *p, *part;
+    err_t err;
+
+    if (sock->lastdata.pbuf) {
+      p = sock->lastdata.pbuf;
     } else {
-      /* flatten the IO vectors */
-      size_t offset = 0;
-      for (i = 0; i < msg->msg_iovlen; i++) {
-        MEMCPY(&((u8_t *)chain_buf.p->payload)[offset], msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
-        offset += msg->msg_iov[i].iov_len;
-      }
-#if LWIP_CHECKSUM_ON_COPY
-      {
-        /* This can be improved by using LWIP_CHKSUM_COPY() and aggregating the checksum for each IO vector */
-        u16_t chksum = ~inet_chksum_pbuf(chain_buf.p);
-        netbuf_set_chksum(&chain_buf, chksum);
-      }
-#endif /* LWIP_CHECKSUM_ON_COPY */
-      err = ERR_OK;
-    }
-#else /* LWIP_NETIF_TX_SINGLE_PBUF */
-    /* create a chained netbuf from the IO vectors. NOTE: we assemble a pbuf chain
-       manually to avoid having to allocate, chain, and delete a netbuf for each iov */
-    for (i = 0; i < msg->msg_iovlen; i++) {
-      struct pbuf *p;
-      if (msg->msg_iov[i].iov_len > 0xFFFF) {
-        /* overflow */
-        goto sendmsg_emsgsize;
-      }
-      p = pbuf_alloc(PBUF_TRANSPORT, 0, PBUF_REF);
-      if (p == NULL) {
-        err = ERR_MEM; /* let netbuf_delete() cleanup chain_buf */
-        break;
-      }
-      p->payload = msg->msg_iov[i].iov_base;
-      p->len = p->tot_len = (u16_t)msg->msg_iov[i].iov_len;
-      /* netbuf empty, add new pbuf */
-      if (chain_buf.p == NULL) {
-        chain_buf.p = chain_buf.ptr = p;
-        /* add pbuf to existing pbuf chain */
-      } else {
-        if (chain_buf.p->tot_len + p->len > 0xffff) {
-          /* overflow */
-          pbuf_free(p);
-          goto sendmsg_emsgsize;
+      err = netconn_recv_tcp_pbuf_flags(sock->conn, &p, apiflags);
+      LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_tcp_zc: netconn_recv err=%d, pbuf=%p\n",
+                                  err, (void *)p));
+      if (err != ERR_OK) {
+        if (recvd > 0) {
+          break;
         }
-        pbuf_cat(chain_buf.p, p);
+        lwip_recv_zc_unreserve(held);
+        sock_set_errno(sock, err_to_errno(err));
+        return (err == ERR_CLSD) ? 0 : -1;
       }
+      LWIP_ASSERT("p != NULL", p != NULL);
     }
-    /* save size of total chain */
-    if (err == ERR_OK) {
-      size = netbuf_len(&chain_buf);
-    }
-#endif /* LWIP_NETIF_TX_SINGLE_PBUF */
 
-    if (err == ERR_OK) {
-#if LWIP_IPV4 && LWIP_IPV6
-      /* Dual-stack: Unmap IPv4 mapped IPv6 addresses */
-      if (IP_IS_V6_VAL(chain_buf.addr) && ip6_addr_isipv4mappedipv6(ip_2_ip6(&chain_buf.addr))) {
-        unmap_ipv4_mapped_ipv6(ip_2_ip4(&chain_buf.addr), ip_2_ip6(&chain_buf.addr));
-        IP_SET_TYPE_VAL(chain_buf.addr, IPADDR_TYPE_V4);
+    err = lwip_recv_zc_split(&p, recv_left, &part);
+    sock->lastdata.pbuf = p;
+    if (err != ERR_OK) {
+      if (recvd > 0) {
+        break;
       }
-#endif /* LWIP_IPV4 && LWIP_IPV6 */
-
-      /* send the data */
-      err = netconn_send(sock->conn, &chain_buf);
+      lwip_recv_zc_unreserve(held);
+      sock_set_errno(sock, err_to_errno(err));
+      return -1;
     }
+    if (*out == NULL) {
+      *out = part;
+    } else {
+      pbuf_cat(*out, part);
+    }
+    recvd = (u16_t)(recvd + part->tot_len);
+    recv_left = (u16_t)(recv_left - part->tot_len);
+    /* once we have some data to return, only add more if we don't need to wait */
+    apiflags |= NETCONN_DONTBLOCK | NETCONN_NOFIN;
+  }
 
-    /* deallocated the buffer */
-    netbuf_free(&chain_buf);
-
-    sock_set_errno(sock, err_to_errno(err));
-    done_socket(sock);
-    return (err == ERR_OK ? size : -1);
-sendmsg_emsgsize:
-    sock_set_errno(sock, EMSGSIZE);
-    netbuf_free(&chain_buf);
-    done_socket(sock);
-    return -1;
+  if (recvd == 0) {
+    lwip_recv_zc_unreserve(held);
+  } else {
+    /* the window is updated by lwip_recv_zc_release() */
+    SYS_ARCH_PROTECT(lev);
+    held->p = *out;
+    held->len = recvd;
+    SYS_ARCH_UNPROTECT(lev);
   }
-#else /* LWIP_UDP || LWIP_RAW */
-  sock_set_errno(sock, err_to_errno(ERR_ARG));
-  done_socket(sock);
-  return -1;
-#endif /* LWIP_UDP || LWIP_RAW */
+  sock_set_errno(sock, 0);
+  return recvd;
 }
+#endif /* LWIP_TCP */
 
+/**
+ * @ingroup socket
+ * Zero-copy receive: instead of copying into a user buffer, the received
+ * pbuf chain is handed to the caller, who owns it until passing it back to
+ * lwip_recv_zc_release(). The pbufs are read-only and must be returned as
+ * they are.
+ * For TCP, up to "len" bytes (at most 0xFFFF) are returned and they stay
+ * accounted against the receive window until released, so holding them
+ * throttles the peer just like an unread socket buffer would. At most
+ * LWIP_SOCKET_RECV_ZC_MAX chains can be held per TCP socket, further calls
+ * fail with ENOBUFS. For UDP and RAW, one whole datagram is returned and
+ * "len" is ignored.
+ *
+ * @param p receives the pbuf chain (NULL if nothing was received)
+ * @param flags only MSG_DONTWAIT is supported
+ * @return the number of bytes in *p, 0 if the connection is closed, -1 on error
+ */
 ssize_t
-lwip_sendto(int s, const void *data, size_t size, int flags,
-            const struct sockaddr *to, socklen_t tolen)
+lwip_recv_zc(int s, struct pbuf **p, size_t len, int flags)
 {
   struct lwip_sock *sock;
-  err_t err;
-  u16_t short_size;
-  u16_t remote_port;
-  struct netbuf buf;
+  ssize_t ret;
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_zc(%d, %p, %"SZT_F", 0x%x)\n", s, (void *)p, len, flags));
+  LWIP_ERROR("lwip_recv_zc: invalid p", p != NULL, set_errno(EFAULT); return -1;);
+  LWIP_ERROR("lwip_recv_zc: unsupported flags", (flags & ~MSG_DONTWAIT) == 0,
+             set_errno(EOPNOTSUPP); return -1;);
+  *p = NULL;
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+#if LWIP_TCP
+  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
+    ret = lwip_recv_tcp_zc(sock, p, len, flags);
+    done_socket(sock);
+    return ret;
+  }
+#endif /* LWIP_TCP */
+#if LWIP_UDP || LWIP_RAW
+  {
+    struct netbuf *buf = sock->lastdata.netbuf;
+    if (buf == NULL) {
+      err_t err = netconn_recv_udp_raw_netbuf_flags(sock->conn, &buf,
+                  (flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0);
+      if (err != ERR_OK) {
+        LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_zc[UDP/RAW](%d): error is \"%s\"!\n",
+                                    s, lwip_strerr(err)));
+        sock_set_errno(sock, err_to_errno(err));
+        done_socket(sock);
+        return -1;
+      }
+    }
+    sock->lastdata.netbuf = NULL;
+    /* take the pbuf out of the netbuf before deleting it */
+    *p = buf->p;
+    buf->p = buf->ptr = NULL;
+    netbuf_delete(buf);
+    ret = (*p)->tot_len;
+  }
+#else /* LWIP_UDP || LWIP_RAW */
+  LWIP_UNUSED_ARG(len);
+  ret = -1;
+  sock_set_errno(sock, EOPNOTSUPP);
+#endif /* LWIP_UDP || LWIP_RAW */
+  if (ret >= 0) {
+    sock_set_errno(sock, 0);
+  }
+  done_socket(sock);
+  return ret;
+}
+
+/**
+ * @ingroup socket
+ * Give back a pbuf chain returned by lwip_recv_zc(): the pbufs are freed and,
+ * for TCP, their bytes are returned to the receive window. The chain is
+ * freed even if the socket has been closed in the meantime, and a chain of
+ * a closed socket does not open the window of a new socket reusing "s".
+ */
+int
+lwip_recv_zc_release(int s, struct pbuf *p)
+{
+  struct lwip_sock *sock;
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_zc_release(%d, %p)\n", s, (void *)p));
+  sock = get_socket(s);
+  if (!sock) {
+    if (p != NULL) {
+      pbuf_free(p);
+    }
+    return -1;
+  }
+  if (p != NULL) {
+#if LWIP_TCP
+    if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
+      u16_t released = 0;
+      int i;
+      SYS_ARCH_DECL_PROTECT(lev);
+
+      /* only chains handed out by this socket are credited */
+      SYS_ARCH_PROTECT(lev);
+      for (i = 0; i < LWIP_SOCKET_RECV_ZC_MAX; i++) {
+        if (sock->zc_held[i].p == p) {
+          released = sock->zc_held[i].len;
+          sock->zc_held[i].p = NULL;
+          sock->zc_held[i].in_use = 0;
+          break;
+        }
+      }
+      SYS_ARCH_UNPROTECT(lev);
+      pbuf_free(p);
+      if (released > 0) {
+        netconn_tcp_recvd(sock->conn, released);
+      }
+    } else
+#endif /* LWIP_TCP */
+    {
+      pbuf_free(p);
+    }
+  }
+  sock_set_errno(sock, 0);
+  done_socket(sock);
+  return 0;
+}
+#endif /* LWIP_SOCKET_RECV_ZC */
+
+ssize_t
+lwip_send(int s, const void *data, size_t size, int flags)
+{
+  struct lwip_sock *sock;
+  err_t err;
+  u8_t write_flags;
+  size_t written;
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send(%d, data=%p, size=%"SZT_F", flags=0x%x)\n",
+                              s, data, size, flags));
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+
+  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) != NETCONN_TCP) {
+#if (LWIP_UDP || LWIP_RAW)
+    done_socket(sock);
+    return lwip_sendto(s, data, size, flags, NULL, 0);
+#else /* (LWIP_UDP || LWIP_RAW) */
+    sock_set_errno(sock, err_to_errno(ERR_ARG));
+    done_socket(sock);
+    return -1;
+#endif /* (LWIP_UDP || LWIP_RAW) */
+  }
+
+  write_flags = (u8_t)(NETCONN_COPY |
+                       ((flags & MSG_MORE)     ? NETCONN_MORE      : 0) |
+                       ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0));
+  written = 0;
+  err = netconn_write_partly(sock->conn, data, size, write_flags, &written);
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send(%d) err=%d written=%"SZT_F"\n", s, err, written));
+  sock_set_errno(sock, err_to_errno(err));
+  done_socket(sock);
+  /* casting 'written' to ssize_t is OK here since the netconn API limits it to SSIZE_MAX */
+  return (err == ERR_OK ? (ssize_t)written : -1);
+}
+
+#if LWIP_UDP || LWIP_RAW
+/** Build the netbuf for a UDP or RAW datagram described by 'msg' (which must
+ * have valid IO vectors). 'chain_buf' has to be freed with netbuf_free()
+ * in any case.
+ *
+ * @return 0 on success, an errno value otherwise
+ */
+static int
+lwip_sendmsg_udp_raw_netbuf(const struct msghdr *msg, struct netbuf *chain_buf, ssize_t *size)
+{
+  err_t err = ERR_OK;
+  int i;
+
+  /* initialize chain buffer with destination */
+  memset(chain_buf, 0, sizeof(struct netbuf));
+  LWIP_ERROR("lwip_sendmsg: invalid msghdr name", (((msg->msg_name == NULL) && (msg->msg_namelen == 0)) ||
+             IS_SOCK_ADDR_LEN_VALID(msg->msg_namelen)),
+             return err_to_errno(ERR_ARG););
+
+  if (msg->msg_name) {
+    u16_t remote_port;
+    SOCKADDR_TO_IPADDR_PORT((const struct sockaddr *)msg->msg_name, &chain_buf->addr, remote_port);
+    netbuf_fromport(chain_buf) = remote_port;
+  }
+  *size = 0;
+#if LWIP_NETIF_TX_SINGLE_PBUF
+  for (i = 0; i < msg->msg_iovlen; i++) {
+    *size += msg->msg_iov[i].iov_len;
+    if ((msg->msg_iov[i].iov_len > INT_MAX) || (*size < (int)msg->msg_iov[i].iov_len)) {
+      /* overflow */
+      return EMSGSIZE;
+    }
+  }
+  if (*size > 0xFFFF) {
+    /* overflow */
+    return EMSGSIZE;
+  }
+  /* Allocate a new netbuf and copy the data into it. */
+  if (netbuf_alloc(chain_buf, (u16_t)*size) == NULL) {
+    err = ERR_MEM;
+  } else {
+    /* flatten the IO vectors */
+    size_t offset = 0;
+    for (i = 0; i < msg->msg_iovlen; i++) {
+      MEMCPY(&((u8_t *)chain_buf->p->payload)[offset], msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
+      offset += msg->msg_iov[i].iov_len;
+    }
+#if LWIP_CHECKSUM_ON_COPY
+    {
+      /* This can be improved by using LWIP_CHKSUM_COPY() and aggregating the checksum for each IO vector */
+      u16_t chksum = ~inet_chksum_pbuf(chain_buf->p);
+      netbuf_set_chksum(chain_buf, chksum);
+    }
+#endif /* LWIP_CHECKSUM_ON_COPY */
+    err = ERR_OK;
+  }
+#else /* LWIP_NETIF_TX_SINGLE_PBUF */
+  /* create a chained netbuf from the IO vectors. NOTE: we assemble a pbuf chain
+     manually to avoid having to allocate, chain, and delete a netbuf for each iov */
+  for (i = 0; i < msg->msg_iovlen; i++) {
+    struct pbuf *p;
+    if (msg->msg_iov[i].iov_len > 0xFFFF) {
+      /* overflow */
+      return EMSGSIZE;
+    }
+    p = pbuf_alloc(PBUF_TRANSPORT, 0, PBUF_REF);
+    if (p == NULL) {
+      err = ERR_MEM; /* let netbuf_free() cleanup chain_buf */
+      break;
+    }
+    p->payload = msg->msg_iov[i].iov_base;
+    p->len = p->tot_len = (u16_t)msg->msg_iov[i].iov_len;
+    /* netbuf empty, add new pbuf */
+    if (chain_buf->p == NULL) {
+      chain_buf->p = chain_buf->ptr = p;
+      /* add pbuf to existing pbuf chain */
+    } else {
+      if (chain_buf->p->tot_len + p->len > 0xffff) {
+        /* overflow */
+        pbuf_free(p);
+        return EMSGSIZE;
+      }
+      pbuf_cat(chain_buf->p, p);
+    }
+  }
+  /* save size of total chain */
+  if (err == ERR_OK) {
+    *size = netbuf_len(chain_buf);
+  }
+#endif /* LWIP_NETIF_TX_SINGLE_PBUF */
+
+#if LWIP_IPV4 && LWIP_IPV6
+  /* Dual-stack: Unmap IPv4 mapped IPv6 addresses */
+  if (IP_IS_V6_VAL(chain_buf->addr) && ip6_addr_isipv4mappedipv6(ip_2_ip6(&chain_buf->addr))) {
+    unmap_ipv4_mapped_ipv6(ip_2_ip4(&chain_buf->addr), ip_2_ip6(&chain_buf->addr));
+    IP_SET_TYPE_VAL(chain_buf->addr, IPADDR_TYPE_V4);
+  }
+#endif /* LWIP_IPV4 && LWIP_IPV6 */
+  return err_to_errno(err);
+}
+#endif /* LWIP_UDP || LWIP_RAW */
+
+ssize_t
+lwip_sendmsg(int s, const struct msghdr *msg, int flags)
+{
+  struct lwip_sock *sock;
+#if LWIP_TCP
+  u8_t write_flags;
+  size_t written;
+#endif
+  err_t err = ERR_OK;
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+
+  LWIP_ERROR("lwip_sendmsg: invalid msghdr", msg != NULL,
+             sock_set_errno(sock, err_to_errno(ERR_ARG)); done_socket(sock); return -1;);
+  LWIP_ERROR("lwip_sendmsg: invalid msghdr iov", msg->msg_iov != NULL,
+             sock_set_errno(sock, err_to_errno(ERR_ARG)); done_socket(sock); return -1;);
+  LWIP_ERROR("lwip_sendmsg: maximum iovs exceeded", (msg->msg_iovlen > 0) && (msg->msg_iovlen <= IOV_MAX),
+             sock_set_errno(sock, EMSGSIZE); done_socket(sock); return -1;);
+  LWIP_ERROR("lwip_sendmsg: unsupported flags", (flags & ~(MSG_DONTWAIT | MSG_MORE)) == 0,
+             sock_set_errno(sock, EOPNOTSUPP); done_socket(sock); return -1;);
+
+  LWIP_UNUSED_ARG(msg->msg_control);
+  LWIP_UNUSED_ARG(msg->msg_controllen);
+  LWIP_UNUSED_ARG(msg->msg_flags);
+
+  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
+#if LWIP_TCP
+    write_flags = (u8_t)(NETCONN_COPY |
+                         ((flags & MSG_MORE)     ? NETCONN_MORE      : 0) |
+                         ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0));
+
+    written = 0;
+    err = netconn_write_vectors_partly(sock->conn, (struct netvector *)msg->msg_iov, (u16_t)msg->msg_iovlen, write_flags, &written);
+    sock_set_errno(sock, err_to_errno(err));
+    done_socket(sock);
+    /* casting 'written' to ssize_t is OK here since the netconn API limits it to SSIZE_MAX */
+    return (err == ERR_OK ? (ssize_t)written : -1);
+#else /* LWIP_TCP */
+    sock_set_errno(sock, err_to_errno(ERR_ARG));
+    done_socket(sock);
+    return -1;
+#endif /* LWIP_TCP */
+  }
+  /* else, UDP and RAW NETCONNs */
+#if LWIP_UDP || LWIP_RAW
+  {
+    struct netbuf chain_buf;
+    ssize_t size = 0;
+    int errval;
+
+    LWIP_UNUSED_ARG(flags);
+    errval = lwip_sendmsg_udp_raw_netbuf(msg, &chain_buf, &size);
+    if (errval == 0) {
+      /* send the data */
+      err = netconn_send(sock->conn, &chain_buf);
+      errval = err_to_errno(err);
+    }
+
+    /* deallocated the buffer */
+    netbuf_free(&chain_buf);
+
+    sock_set_errno(sock, errval);
+    done_socket(sock);
+    return (errval == 0 ? size : -1);
+  }
+#else /* LWIP_UDP || LWIP_RAW */
+  sock_set_errno(sock, err_to_errno(ERR_ARG));
+  done_socket(sock);
+  return -1;
+#endif /* LWIP_UDP || LWIP_RAW */
+}
+
+/**
+ * @ingroup socket
+ * Send several messages with one call. For UDP and RAW sockets, up to
+ * LWIP_SOCKET_MMSG_BATCH datagrams are passed to the tcpip_thread with one
+ * API message. TCP sockets send the messages one by one.
+ *
+ * @return the number of messages sent (their msg_len is set), -1 if the first
+ *         one failed
+ */
+int
+lwip_sendmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags)
+{
+  struct lwip_sock *sock;
+  unsigned int sent = 0;
+  int errval = 0;
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_sendmmsg(%d, msgvec=%p, vlen=%u, flags=0x%x)\n", s, (void *)msgvec, vlen, flags));
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+
+  LWIP_ERROR("lwip_sendmmsg: invalid msgvec", (msgvec != NULL) || (vlen == 0),
+             sock_set_errno(sock, err_to_errno(ERR_ARG)); done_socket(sock); return -1;);
+  LWIP_ERROR("lwip_sendmmsg: unsupported flags", (flags & ~(MSG_DONTWAIT | MSG_MORE)) == 0,
+             sock_set_errno(sock, EOPNOTSUPP); done_socket(sock); return -1;);
+
+  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
+    done_socket(sock);
+    for (sent = 0; sent < vlen; sent++) {
+      ssize_t ret = lwip_sendmsg(s, &msgvec[sent].msg_hdr, flags);
+      if (ret < 0) {
+        break;
+      }
+      msgvec[sent].msg_len = (unsigned int)ret;
+    }
+    return ((sent > 0) || (vlen == 0)) ? (int)sent : -1;
+  }
+  /* else, UDP and RAW NETCONNs */
+#if LWIP_UDP || LWIP_RAW
+  while ((sent < vlen) && (errval == 0)) {
+    struct netbuf bufs[LWIP_SOCKET_MMSG_BATCH];
+    u16_t cnt, batch_sent, i;
+
+    /* prepare a batch of datagrams... */
+    for (cnt = 0; (cnt < LWIP_SOCKET_MMSG_BATCH) && (sent + cnt < vlen); cnt++) {
+      struct mmsghdr *m = &msgvec[sent + cnt];
+      ssize_t size = 0;
+      if ((m->msg_hdr.msg_iov == NULL) || (m->msg_hdr.msg_iovlen <= 0) || (m->msg_hdr.msg_iovlen > IOV_MAX)) {
+        errval = EMSGSIZE;
+        break;
+      }
+      errval = lwip_sendmsg_udp_raw_netbuf(&m->msg_hdr, &bufs[cnt], &size);
+      if (errval != 0) {
+        netbuf_free(&bufs[cnt]);
+        break;
+      }
+      m->msg_len = (unsigned int)size;
+    }
+    /* ... and send it with one API message */
+    if (cnt > 0) {
+      err_t err = netconn_send_batch(sock->conn, bufs, cnt, &batch_sent);
+      if (err != ERR_OK) {
+        errval = err_to_errno(err);
+      }
+      sent += batch_sent;
+      for (i = 0; i < cnt; i++) {
+        netbuf_free(&bufs[i]);
+      }
+    }
+  }
+#else /* LWIP_UDP || LWIP_RAW */
+  errval = err_to_errno(ERR_ARG);
+#endif /* LWIP_UDP || LWIP_RAW */
+
+  if ((sent == 0) && (errval != 0)) {
+    sock_set_errno(sock, errval);
+    done_socket(sock);
+    return -1;
+  }
+  sock_set_errno(sock, 0);
+  done_socket(sock);
+  return (int)sent;
+}
+
+ssize_t
+lwip_sendto(int s, const void *data, size_t size, int flags,
+            const struct sockaddr *to, socklen_t tolen)
+{
+  struct lwip_sock *sock;
+  err_t err;
+  u16_t short_size;
+  u16_t remote_port;
+  struct netbuf buf;
 
   sock = get_socket(s);
   if (!sock) {
@@ -2545,6 +3071,13 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
       break;
   }
 
+#if LWIP_SOCKET_EPOLL
+  if ((sock->epoll_items != NULL) && (evt != NETCONN_EVT_RCVMINUS) && (evt != NETCONN_EVT_SENDMINUS)) {
+    /* queue the socket on the ready list of interested epoll instances */
+    lwip_epoll_notify(sock);
+  }
+#endif /* LWIP_SOCKET_EPOLL */
+
   if (sock->select_waiting && check_waiters) {
     /* Save which events are active */
     int has_recvevent, has_sendevent, has_errevent;
@@ -2648,6 +3181,415 @@ again:
 }
 #endif /* LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL */
 
+#if LWIP_SOCKET_EPOLL
+/** Readiness of a socket in EPOLL* flags, call under SYS_ARCH_PROTECT */
+static u32_t
+lwip_epoll_sock_events(const struct lwip_sock *sock)
+{
+  u32_t events = 0;
+  if ((sock->lastdata.pbuf != NULL) || (sock->rcvevent > 0)) {
+    events |= EPOLLIN;
+  }
+  if (sock->sendevent != 0) {
+    events |= EPOLLOUT;
+  }
+  if (sock->errevent != 0) {
+    events |= EPOLLERR;
+  }
+  return events;
+}
+
+/** Events of an item to report right now, call under SYS_ARCH_PROTECT */
+static u32_t
+lwip_epoll_item_events(const struct lwip_epoll_item *item)
+{
+  if (!item->armed) {
+    return 0;
+  }
+  /* like POLLERR, EPOLLERR is always reported */
+  return lwip_epoll_sock_events(item->sock) & ((item->events & (EPOLLIN | EPOLLOUT)) | EPOLLERR);
+}
+
+/** Append an item to the ready list, call under SYS_ARCH_PROTECT */
+static void
+lwip_epoll_ready_enqueue(struct lwip_epoll *ep, struct lwip_epoll_item *item)
+{
+  LWIP_ASSERT("item not queued", !item->queued);
+  item->ready_next = NULL;
+  item->ready_prev = ep->ready_tail;
+  if (ep->ready_tail != NULL) {
+    ep->ready_tail->ready_next = item;
+  } else {
+    ep->ready_head = item;
+  }
+  ep->ready_tail = item;
+  ep->ready_cnt++;
+  item->queued = 1;
+}
+
+/** Remove an item from the ready list, call under SYS_ARCH_PROTECT */
+static void
+lwip_epoll_ready_dequeue(struct lwip_epoll *ep, struct lwip_epoll_item *item)
+{
+  LWIP_ASSERT("item queued", item->queued);
+  if (item->ready_prev != NULL) {
+    item->ready_prev->ready_next = item->ready_next;
+  } else {
+    ep->ready_head = item->ready_next;
+  }
+  if (item->ready_next != NULL) {
+    item->ready_next->ready_prev = item->ready_prev;
+  } else {
+    ep->ready_tail = item->ready_prev;
+  }
+  LWIP_ASSERT("ready_cnt > 0", ep->ready_cnt > 0);
+  ep->ready_cnt--;
+  item->queued = 0;
+}
+
+/** Queue an item if it is ready and wake up a waiting thread,
+ * call under SYS_ARCH_PROTECT */
+static void
+lwip_epoll_item_check(struct lwip_epoll_item *item)
+{
+  struct lwip_epoll *ep = item->ep;
+  if (!item->queued && (lwip_epoll_item_events(item) != 0)) {
+    lwip_epoll_ready_enqueue(ep, item);
+    if (ep->waiting && !ep->sem_signalled) {
+      ep->sem_signalled = 1;
+      /* signal while still protected: closing the instance frees the semaphore */
+      sys_sem_signal(&ep->sem);
+    }
+  }
+}
+
+/** Called from event_callback() under SYS_ARCH_PROTECT when a socket may
+ * have become ready: only the epoll instances watching it are touched. */
+static void
+lwip_epoll_notify(struct lwip_sock *sock)
+{
+  struct lwip_epoll_item *item;
+  for (item = sock->epoll_items; item != NULL; item = item->next) {
+    lwip_epoll_item_check(item);
+  }
+}
+
+/** Unlink all epoll registrations of a socket that is being closed */
+static void
+lwip_epoll_drop_socket(struct lwip_sock *sock)
+{
+  struct lwip_epoll_item *items, *item;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  items = sock->epoll_items;
+  sock->epoll_items = NULL;
+  for (item = items; item != NULL; item = item->next) {
+    if (item->queued) {
+      lwip_epoll_ready_dequeue(item->ep, item);
+    }
+  }
+  SYS_ARCH_UNPROTECT(lev);
+
+  while (items != NULL) {
+    item = items;
+    items = item->next;
+    memp_free(MEMP_EPOLL_ITEM, item);
+  }
+}
+
+static struct lwip_epoll *
+get_epoll(int epfd)
+{
+  int i = epfd - LWIP_EPOLL_OFFSET;
+  if ((i < 0) || (i >= LWIP_SOCKET_MAX_EPOLL) || !epolls[i].used) {
+    LWIP_DEBUGF(SOCKETS_DEBUG, ("get_epoll(%d): invalid\n", epfd));
+    set_errno(EBADF);
+    return NULL;
+  }
+  return &epolls[i];
+}
+
+/**
+ * @ingroup socket
+ * Create an epoll instance. Close it with lwip_close().
+ *
+ * @param size ignored, but must be greater than 0 (as with Linux)
+ * @return the epoll descriptor or -1 on error
+ */
+int
+lwip_epoll_create(int size)
+{
+  int i;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_epoll_create(%d)\n", size));
+  LWIP_ERROR("lwip_epoll_create: invalid size", size > 0, set_errno(EINVAL); return -1;);
+
+  for (i = 0; i < LWIP_SOCKET_MAX_EPOLL; i++) {
+    SYS_ARCH_PROTECT(lev);
+    if (!epolls[i].used) {
+      epolls[i].used = 1;
+      SYS_ARCH_UNPROTECT(lev);
+      epolls[i].ready_head = NULL;
+      epolls[i].ready_tail = NULL;
+      epolls[i].ready_cnt = 0;
+      epolls[i].sem_signalled = 0;
+      epolls[i].waiting = 0;
+      if (sys_sem_new(&epolls[i].sem, 0) != ERR_OK) {
+        epolls[i].used = 0;
+        set_errno(ENOMEM);
+        return -1;
+      }
+      set_errno(0);
+      return i + LWIP_EPOLL_OFFSET;
+    }
+    SYS_ARCH_UNPROTECT(lev);
+  }
+  set_errno(EMFILE);
+  return -1;
+}
+
+/** Close an epoll instance, called from lwip_close(). No thread may be waiting
+ * on it. The registrations are found via the sockets (closing is rare). */
+static int
+lwip_epoll_close(int epfd)
+{
+  int i;
+  struct lwip_epoll_item *unlinked = NULL;
+  struct lwip_epoll *ep = get_epoll(epfd);
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (ep == NULL) {
+    return -1;
+  }
+  LWIP_ASSERT("no thread waiting", ep->waiting == 0);
+
+  for (i = 0; i < NUM_SOCKETS; i++) {
+    struct lwip_epoll_item **pitem;
+    SYS_ARCH_PROTECT(lev);
+    pitem = &sockets[i].epoll_items;
+    while (*pitem != NULL) {
+      struct lwip_epoll_item *item = *pitem;
+      if (item->ep == ep) {
+        *pitem = item->next;
+        if (item->queued) {
+          lwip_epoll_ready_dequeue(ep, item);
+        }
+        item->next = unlinked;
+        unlinked = item;
+      } else {
+        pitem = &item->next;
+      }
+    }
+    SYS_ARCH_UNPROTECT(lev);
+  }
+  LWIP_ASSERT("ready list empty", ep->ready_head == NULL);
+
+  while (unlinked != NULL) {
+    struct lwip_epoll_item *item = unlinked;
+    unlinked = item->next;
+    memp_free(MEMP_EPOLL_ITEM, item);
+  }
+  sys_sem_free(&ep->sem);
+  ep->used = 0;
+  set_errno(0);
+  return 0;
+}
+
+/**
+ * @ingroup socket
+ * Add, modify or remove the registration of socket 'fd' with an epoll
+ * instance. Supported events are EPOLLIN and EPOLLOUT, EPOLLERR is always
+ * reported. EPOLLET and EPOLLONESHOT work like on Linux.
+ */
+int
+lwip_epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+  struct lwip_epoll *ep;
+  struct lwip_sock *sock;
+  struct lwip_epoll_item *item, *newitem = NULL;
+  struct lwip_epoll_item **pitem;
+  int err = 0;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_epoll_ctl(%d, %d, %d)\n", epfd, op, fd));
+
+  ep = get_epoll(epfd);
+  if (ep == NULL) {
+    return -1;
+  }
+  LWIP_ERROR("lwip_epoll_ctl: invalid op", (op == EPOLL_CTL_ADD) || (op == EPOLL_CTL_MOD) || (op == EPOLL_CTL_DEL),
+             set_errno(EINVAL); return -1;);
+  LWIP_ERROR("lwip_epoll_ctl: invalid event", (op == EPOLL_CTL_DEL) || (event != NULL),
+             set_errno(EFAULT); return -1;);
+
+  sock = get_socket(fd);
+  if (sock == NULL) {
+    return -1;
+  }
+
+  if (op == EPOLL_CTL_ADD) {
+    /* allocate outside the protection, freed again if already registered */
+    newitem = (struct lwip_epoll_item *)memp_malloc(MEMP_EPOLL_ITEM);
+    if (newitem == NULL) {
+      done_socket(sock);
+      set_errno(ENOMEM);
+      return -1;
+    }
+    memset(newitem, 0, sizeof(struct lwip_epoll_item));
+    newitem->ep = ep;
+    newitem->sock = sock;
+    newitem->events = event->events;
+    newitem->data = event->data;
+    newitem->armed = 1;
+  }
+
+  SYS_ARCH_PROTECT(lev);
+  for (pitem = &sock->epoll_items; *pitem != NULL; pitem = &(*pitem)->next) {
+    if ((*pitem)->ep == ep) {
+      break;
+    }
+  }
+  item = *pitem;
+  if (op == EPOLL_CTL_ADD) {
+    if (item != NULL) {
+      err = EEXIST;
+    } else {
+      *pitem = newitem;
+      /* report a socket that is ready already */
+      lwip_epoll_item_check(newitem);
+      newitem = NULL;
+    }
+  } else if (item == NULL) {
+    err = ENOENT;
+  } else if (op == EPOLL_CTL_MOD) {
+    item->events = event->events;
+    item->data = event->data;
+    item->armed = 1;
+    lwip_epoll_item_check(item);
+  } else {
+    /* EPOLL_CTL_DEL */
+    *pitem = item->next;
+    if (item->queued) {
+      lwip_epoll_ready_dequeue(ep, item);
+    }
+    newitem = item;
+  }
+  SYS_ARCH_UNPROTECT(lev);
+
+  if (newitem != NULL) {
+    memp_free(MEMP_EPOLL_ITEM, newitem);
+  }
+  done_socket(sock);
+  if (err != 0) {
+    set_errno(err);
+    return -1;
+  }
+  set_errno(0);
+  return 0;
+}
+
+/** Report up to 'maxevents' items from the ready list. Each item is looked at
+ * only once: level-triggered items that are still ready are moved to the tail
+ * (so all ready sockets are served in turn), the rest is dropped from the list
+ * until event_callback() queues it again. Call under SYS_ARCH_PROTECT. */
+static int
+lwip_epoll_collect(struct lwip_epoll *ep, struct epoll_event *events, int maxevents)
+{
+  int nready = 0;
+  u16_t cnt = ep->ready_cnt;
+
+  while ((cnt-- > 0) && (nready < maxevents)) {
+    struct lwip_epoll_item *item = ep->ready_head;
+    u32_t revents;
+
+    lwip_epoll_ready_dequeue(ep, item);
+    revents = lwip_epoll_item_events(item);
+    if (revents == 0) {
+      /* no longer ready */
+      continue;
+    }
+    events[nready].events = revents;
+    events[nready].data = item->data;
+    nready++;
+    if (item->events & EPOLLONESHOT) {
+      item->armed = 0;
+    } else if (!(item->events & EPOLLET)) {
+      lwip_epoll_ready_enqueue(ep, item);
+    }
+  }
+  return nready;
+}
+
+/**
+ * @ingroup socket
+ * Wait for events on an epoll instance. Unlike select/poll, the cost does not
+ * depend on the number of registered sockets, only on the number of ready ones.
+ *
+ * @param timeout in milliseconds, 0 to return immediately, < 0 to wait forever
+ * @return number of events stored in 'events', -1 on error
+ */
+int
+lwip_epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+  struct lwip_epoll *ep;
+  int nready;
+  u32_t start = 0;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_epoll_wait(%d, %p, %d, %d)\n", epfd, (void *)events, maxevents, timeout));
+
+  ep = get_epoll(epfd);
+  if (ep == NULL) {
+    return -1;
+  }
+  LWIP_ERROR("lwip_epoll_wait: invalid events", (events != NULL) && (maxevents > 0),
+             set_errno(EINVAL); return -1;);
+
+  if (timeout > 0) {
+    start = sys_now();
+  }
+
+  SYS_ARCH_PROTECT(lev);
+  for (;;) {
+    u32_t msectimeout = 0;
+    u32_t waitres;
+
+    nready = lwip_epoll_collect(ep, events, maxevents);
+    if ((nready > 0) || (timeout == 0)) {
+      break;
+    }
+    if (timeout > 0) {
+      u32_t elapsed = sys_now() - start;
+      if (elapsed >= (u32_t)timeout) {
+        break;
+      }
+      msectimeout = (u32_t)timeout - elapsed;
+    }
+    ep->waiting++;
+    LWIP_ASSERT("too many threads waiting", ep->waiting != 0);
+    SYS_ARCH_UNPROTECT(lev);
+
+    waitres = sys_arch_sem_wait(&ep->sem, msectimeout);
+
+    SYS_ARCH_PROTECT(lev);
+    ep->waiting--;
+    ep->sem_signalled = 0;
+    if (waitres == SYS_ARCH_TIMEOUT) {
+      /* a signal after the timeout only leads to a spurious wakeup later */
+      nready = lwip_epoll_collect(ep, events, maxevents);
+      break;
+    }
+  }
+  SYS_ARCH_UNPROTECT(lev);
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_epoll_wait: nready=%d\n", nready));
+  set_errno(0);
+  return nready;
+}
+#endif /* LWIP_SOCKET_EPOLL */
+
 /**
  * Close one end of a full-duplex connection.
  */
@@ -2869,6 +3811,8 @@ lwip_sockopt_to_ipopt(int optname)
     return SOF_KEEPALIVE;
   case SO_REUSEADDR:
     return SOF_REUSEADDR;
+  case SO_REUSEPORT:
+    return SOF_REUSEPORT;
   default:
     LWIP_ASSERT("Unknown socket option", 0);
     return 0;
@@ -2920,7 +3864,10 @@ lwip_getsockopt_impl(int s, int level, int optname, void *optval, socklen_t *opt
 #if SO_REUSE
         case SO_REUSEADDR:
 #endif /* SO_REUSE */
-          if ((optname == SO_BROADCAST) &&
+#if SO_REUSE_PORT
+        case SO_REUSEPORT:
+#endif /* SO_REUSE_PORT */
+          if (((optname == SO_BROADCAST) || (optname == SO_REUSEPORT)) &&
               (NETCONNTYPE_GROUP(sock->conn->type) != NETCONN_UDP)) {
             done_socket(sock);
             return ENOPROTOOPT;
@@ -3328,7 +4275,10 @@ lwip_setsockopt_impl(int s, int level, int optname, const void *optval, socklen_
 #if SO_REUSE
         case SO_REUSEADDR:
 #endif /* SO_REUSE */
-          if ((optname == SO_BROADCAST) &&
+#if SO_REUSE_PORT
+        case SO_REUSEPORT:
+#endif /* SO_REUSE_PORT */
+          if (((optname == SO_BROADCAST) || (optname == SO_REUSEPORT)) &&
               (NETCONNTYPE_GROUP(sock->conn->type) != NETCONN_UDP)) {
             done_socket(sock);
             return ENOPROTOOPT;
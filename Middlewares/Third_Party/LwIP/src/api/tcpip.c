@@ -46,6 +46,7 @@
 #include "lwip/mem.h"
 #include "lwip/init.h"
 #include "lwip/ip.h"
+#include "lwip/ip4_gro.h"
 #include "lwip/pbuf.h"
 #include "lwip/etharp.h"
 #include "netif/ethernet.h"
@@ -66,6 +67,7 @@ sys_mutex_t lock_tcpip_core;
 #endif /* LWIP_TCPIP_CORE_LOCKING */
 
 static void tcpip_thread_handle_msg(struct tcpip_msg *msg);
+static void tcpip_thread_handle_batch(struct tcpip_msg *msg);
 
 #if !LWIP_TIMERS
 /* wait for a message with timers disabled (e.g. pass a timer-check trigger into tcpip_thread) */
@@ -140,12 +142,51 @@ tcpip_thread(void *arg)
     LWIP_TCPIP_THREAD_ALIVE();
     /* wait for a message, timeouts are processed while waiting */
     TCPIP_MBOX_FETCH(&tcpip_mbox, (void **)&msg);
+    tcpip_thread_handle_batch(msg);
+  }
+}
+
+/* Handle a fetched message and up to TCPIP_MBOX_BATCH_SIZE-1 messages that
+ * are already queued behind it (one wakeup of tcpip_thread).
+ */
+static void
+tcpip_thread_handle_batch(struct tcpip_msg *msg)
+{
+  u16_t batch = TCPIP_MBOX_BATCH_SIZE;
+
+  do {
     if (msg == NULL) {
       LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: invalid message: NULL\n"));
       LWIP_ASSERT("tcpip_thread: invalid message", 0);
       continue;
     }
     tcpip_thread_handle_msg(msg);
+    /* handle messages that are already queued without waiting again */
+  } while ((--batch > 0) &&
+           (sys_arch_mbox_tryfetch(&tcpip_mbox, (void **)&msg) != SYS_ARCH_TIMEOUT));
+#if LWIP_IPV4 && IP_GRO
+  /* end of the batch: process the segments merged so far */
+  ip4_gro_flush();
+#endif /* LWIP_IPV4 && IP_GRO */
+}
+
+/* Pass each packet of a packet queue to input_fn. Packets are linked via
+ * the 'next' pointer of their last pbuf (the one with tot_len == len). */
+static void
+tcpip_inpkt_queue(struct pbuf *p, struct netif *inp, netif_input_fn input_fn)
+{
+  while (p != NULL) {
+    struct pbuf *q, *next;
+
+    for (q = p; q->tot_len != q->len; q = q->next) {
+      LWIP_ASSERT("tcpip_inpkt_batch: invalid packet queue", q->next != NULL);
+    }
+    next = q->next;
+    q->next = NULL;
+    if (input_fn(p, inp) != ERR_OK) {
+      pbuf_free(p);
+    }
+    p = next;
   }
 }
 
@@ -155,6 +196,12 @@ tcpip_thread(void *arg)
 static void
 tcpip_thread_handle_msg(struct tcpip_msg *msg)
 {
+#if LWIP_IPV4 && IP_GRO && !LWIP_TCPIP_CORE_LOCKING_INPUT
+  if ((msg->type != TCPIP_MSG_INPKT) && (msg->type != TCPIP_MSG_INPKT_BATCH)) {
+    /* held segments are processed before anything else happens */
+    ip4_gro_flush();
+  }
+#endif /* LWIP_IPV4 && IP_GRO && !LWIP_TCPIP_CORE_LOCKING_INPUT */
   switch (msg->type) {
 #if !LWIP_TCPIP_CORE_LOCKING
     case TCPIP_MSG_API:
@@ -176,6 +223,12 @@ tcpip_thread_handle_msg(struct tcpip_msg *msg)
       }
       memp_free(MEMP_TCPIP_MSG_INPKT, msg);
       break;
+
+    case TCPIP_MSG_INPKT_BATCH:
+      LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: PACKET BATCH %p\n", (void *)msg));
+      tcpip_inpkt_queue(msg->msg.inp.p, msg->msg.inp.netif, msg->msg.inp.input_fn);
+      memp_free(MEMP_TCPIP_MSG_INPKT, msg);
+      break;
 #endif /* !LWIP_TCPIP_CORE_LOCKING_INPUT */
 
 #if LWIP_TCPIP_TIMEOUT && LWIP_TIMERS
@@ -221,12 +274,31 @@ tcpip_thread_poll_one(void)
     LOCK_TCPIP_CORE();
     if (msg != NULL) {
       tcpip_thread_handle_msg(msg);
+#if LWIP_IPV4 && IP_GRO
+      ip4_gro_flush();
+#endif /* LWIP_IPV4 && IP_GRO */
       ret = 1;
     }
     UNLOCK_TCPIP_CORE();
   }
   return ret;
 }
+
+/** Work on queued items like one wakeup of tcpip_thread (up to
+ * TCPIP_MBOX_BATCH_SIZE messages) in single-threaded test mode */
+int
+tcpip_thread_poll_batch(void)
+{
+  struct tcpip_msg *msg;
+
+  if (sys_arch_mbox_tryfetch(&tcpip_mbox, (void **)&msg) == SYS_ARCH_TIMEOUT) {
+    return 0;
+  }
+  LOCK_TCPIP_CORE();
+  tcpip_thread_handle_batch(msg);
+  UNLOCK_TCPIP_CORE();
+  return 1;
+}
 #endif
 
 /**
@@ -244,6 +316,9 @@ tcpip_inpkt(struct pbuf *p, struct netif *inp, netif_input_fn input_fn)
   LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_inpkt: PACKET %p/%p\n", (void *)p, (void *)inp));
   LOCK_TCPIP_CORE();
   ret = input_fn(p, inp);
+#if LWIP_IPV4 && IP_GRO
+  ip4_gro_flush();
+#endif /* LWIP_IPV4 && IP_GRO */
   UNLOCK_TCPIP_CORE();
   return ret;
 #else /* LWIP_TCPIP_CORE_LOCKING_INPUT */
@@ -290,6 +365,183 @@ tcpip_input(struct pbuf *p, struct netif *inp)
     return tcpip_inpkt(p, inp, ip_input);
 }
 
+/**
+ * Pass a queue of received packets to tcpip_thread for input processing
+ * with a single message.
+ *
+ * The packets are linked through the 'next' pointer of the last pbuf of
+ * each packet (i.e. the pbuf with tot_len == len), so a driver can hand
+ * over everything it received in one interrupt with one mbox post.
+ * Packets rejected by input_fn are freed by the stack.
+ *
+ * @param p the first packet of the queue
+ * @param inp the network interface on which the packets were received
+ * @param input_fn input function to call for each packet
+ * @return ERR_OK if the queue was taken over, ERR_MEM if it could not be
+ *         posted (the caller still owns all packets then)
+ */
+err_t
+tcpip_inpkt_batch(struct pbuf *p, struct netif *inp, netif_input_fn input_fn)
+{
+#if LWIP_TCPIP_CORE_LOCKING_INPUT
+  LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_inpkt_batch: PACKETS %p/%p\n", (void *)p, (void *)inp));
+  LOCK_TCPIP_CORE();
+  tcpip_inpkt_queue(p, inp, input_fn);
+#if LWIP_IPV4 && IP_GRO
+  ip4_gro_flush();
+#endif /* LWIP_IPV4 && IP_GRO */
+  UNLOCK_TCPIP_CORE();
+  return ERR_OK;
+#else /* LWIP_TCPIP_CORE_LOCKING_INPUT */
+  struct tcpip_msg *msg;
+
+  LWIP_ASSERT("Invalid mbox", sys_mbox_valid_val(tcpip_mbox));
+
+  msg = (struct tcpip_msg *)memp_malloc(MEMP_TCPIP_MSG_INPKT);
+  if (msg == NULL) {
+    return ERR_MEM;
+  }
+
+  msg->type = TCPIP_MSG_INPKT_BATCH;
+  msg->msg.inp.p = p;
+  msg->msg.inp.netif = inp;
+  msg->msg.inp.input_fn = input_fn;
+  if (sys_mbox_trypost(&tcpip_mbox, msg) != ERR_OK) {
+    memp_free(MEMP_TCPIP_MSG_INPKT, msg);
+    return ERR_MEM;
+  }
+  return ERR_OK;
+#endif /* LWIP_TCPIP_CORE_LOCKING_INPUT */
+}
+
+/**
+ * @ingroup lwip_os
+ * Pass a queue of received packets to tcpip_thread for input processing
+ * with ethernet_input or ip_input (see tcpip_inpkt_batch()).
+ *
+ * @param p the first packet of the queue
+ * @param inp the network interface on which the packets were received
+ */
+err_t
+tcpip_input_batch(struct pbuf *p, struct netif *inp)
+{
+#if LWIP_ETHERNET
+  if (inp->flags & (NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET)) {
+    return tcpip_inpkt_batch(p, inp, ethernet_input);
+  } else
+#endif /* LWIP_ETHERNET */
+    return tcpip_inpkt_batch(p, inp, ip_input);
+}
+
+#if LWIP_SPSC_RING
+/* Callback of a tcpip_rxring's message: pass all packets in the ring to the
+ * input function, then re-arm the doorbell. */
+static void
+tcpip_rxring_drain(void *arg)
+{
+  struct tcpip_rxring *rxr = (struct tcpip_rxring *)arg;
+  void *items[8];
+  u32_t n, i;
+
+  do {
+    while ((n = spsc_ring_get_batch(&rxr->ring, items, LWIP_ARRAYSIZE(items))) > 0) {
+      for (i = 0; i < n; i++) {
+        struct pbuf *p = (struct pbuf *)items[i];
+        if (rxr->input_fn(p, rxr->inp) != ERR_OK) {
+          pbuf_free(p);
+        }
+      }
+    }
+    if (!spsc_ring_consumer_done(&rxr->ring)) {
+      break;
+    }
+    /* more packets arrived while draining: handle them after the messages
+       queued in the meantime (or right away if the mbox is full) */
+  } while (tcpip_callbackmsg_trycallback(rxr->msg) != ERR_OK);
+}
+
+/**
+ * @ingroup lwip_os
+ * Initialize a receive ring for a netif driver. The driver (the only
+ * producer) adds received packets with spsc_ring_put() or
+ * spsc_ring_put_batch() on rxr->ring and calls tcpip_rxring_doorbell() once
+ * per batch; tcpip_thread (the only consumer) passes them to input_fn.
+ * Compared to tcpip_input(), no message is allocated per packet and the
+ * mbox is posted at most once per batch.
+ *
+ * @param rxr the ring to initialize
+ * @param slots storage for "size" packet pointers
+ * @param size number of slots, must be a power of two
+ * @param inp the network interface on which the packets are received
+ * @param input_fn input function to call for each packet
+ * @return ERR_OK, ERR_ARG for an invalid size or ERR_MEM if the notification
+ *         message could not be allocated
+ */
+err_t
+tcpip_rxring_init(struct tcpip_rxring *rxr, void **slots, u32_t size,
+                  struct netif *inp, netif_input_fn input_fn)
+{
+  err_t err;
+
+  LWIP_ERROR("tcpip_rxring_init: invalid arguments", (rxr != NULL) && (input_fn != NULL), return ERR_ARG;);
+  err = spsc_ring_init(&rxr->ring, slots, size);
+  if (err != ERR_OK) {
+    return err;
+  }
+  rxr->inp = inp;
+  rxr->input_fn = input_fn;
+  rxr->msg = tcpip_callbackmsg_new(tcpip_rxring_drain, rxr);
+  if (rxr->msg == NULL) {
+    return ERR_MEM;
+  }
+  return ERR_OK;
+}
+
+/**
+ * @ingroup lwip_os
+ * Free the resources of a receive ring and the packets still in it. The
+ * driver must have stopped adding packets and no notification may be
+ * pending (e.g. call this from tcpip_thread after the netif was removed).
+ */
+void
+tcpip_rxring_free(struct tcpip_rxring *rxr)
+{
+  struct pbuf *p;
+
+  LWIP_ASSERT("tcpip_rxring_free: notification pending", rxr->ring.doorbell == 0);
+  while ((p = (struct pbuf *)spsc_ring_get(&rxr->ring)) != NULL) {
+    pbuf_free(p);
+  }
+  if (rxr->msg != NULL) {
+    tcpip_callbackmsg_delete(rxr->msg);
+    rxr->msg = NULL;
+  }
+}
+
+/**
+ * @ingroup lwip_os
+ * Notify tcpip_thread after adding a batch of packets to a receive ring.
+ * Only posts to the mbox if tcpip_thread is not already notified, so it is
+ * cheap to call after every batch. Must not be called from interrupt
+ * context.
+ *
+ * @return ERR_OK or ERR_MEM if the mbox is full; the packets stay in the
+ *         ring and are handled after the next successful doorbell
+ */
+err_t
+tcpip_rxring_doorbell(struct tcpip_rxring *rxr)
+{
+  if (spsc_ring_doorbell(&rxr->ring)) {
+    if (tcpip_callbackmsg_trycallback(rxr->msg) != ERR_OK) {
+      /* tcpip_thread is not notified: let the next doorbell try again */
+      rxr->ring.doorbell = 0;
+      return ERR_MEM;
+    }
+  }
+  return ERR_OK;
+}
+#endif /* LWIP_SPSC_RING */
+
 /**
  * @ingroup lwip_os
  * Call a specific function in the thread context of
@@ -53,8 +53,16 @@ int fs_read_custom(struct fs_file *file, char *buffer, int count);
 #endif /* LWIP_HTTPD_CUSTOM_FILES */
 
 /*-----------------------------------------------------------------------------------*/
+#if LWIP_HTTPD_PRECOMPRESSED
+/** Like fs_open(), but open the first (smallest) precompressed variant of the
+ * file whose content coding is in 'encodings' (FS_FILE_ENCODING_* bits).
+ */
+err_t
+fs_open_encoded(struct fs_file *file, const char *name, u8_t encodings)
+#else /* LWIP_HTTPD_PRECOMPRESSED */
 err_t
 fs_open(struct fs_file *file, const char *name)
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
 {
   const struct fsdata_file *f;
 
@@ -62,6 +70,10 @@ fs_open(struct fs_file *file, const char *name)
     return ERR_ARG;
   }
 
+#if LWIP_HTTPD_PRECOMPRESSED
+  file->encoding = FS_FILE_ENCODING_IDENTITY;
+  file->etag = NULL;
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
 #if LWIP_HTTPD_CUSTOM_FILES
   if (fs_open_custom(file, name)) {
     file->is_custom_file = 1;
@@ -72,11 +84,28 @@ fs_open(struct fs_file *file, const char *name)
 
   for (f = FS_ROOT; f != NULL; f = f->next) {
     if (!strcmp(name, (const char *)f->name)) {
+#if LWIP_HTTPD_PRECOMPRESSED
+      const struct fsdata_file *v;
+      u8_t flags = f->flags;
+      if (f->variant != NULL) {
+        flags |= FS_FILE_FLAGS_VARIANTS;
+      }
+      for (v = f->variant; v != NULL; v = v->variant) {
+        if (v->encoding & encodings) {
+          f = v;
+          break;
+        }
+      }
+      file->flags = (u8_t)(flags | f->flags);
+      file->encoding = f->encoding;
+      file->etag = f->etag;
+#else /* LWIP_HTTPD_PRECOMPRESSED */
+      file->flags = f->flags;
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
       file->data = (const char *)f->data;
       file->len = f->len;
       file->index = f->len;
       file->pextension = NULL;
-      file->flags = f->flags;
 #if HTTPD_PRECALCULATED_CHECKSUM
       file->chksum_count = f->chksum_count;
       file->chksum = f->chksum;
@@ -91,6 +120,15 @@ fs_open(struct fs_file *file, const char *name)
   return ERR_VAL;
 }
 
+#if LWIP_HTTPD_PRECOMPRESSED
+/*-----------------------------------------------------------------------------------*/
+err_t
+fs_open(struct fs_file *file, const char *name)
+{
+  return fs_open_encoded(file, name, FS_FILE_ENCODING_IDENTITY);
+}
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+
 /*-----------------------------------------------------------------------------------*/
 void
 fs_close(struct fs_file *file)
@@ -114,6 +114,13 @@
 
 #if LWIP_TCP && LWIP_CALLBACK_API
 
+#if LWIP_HTTPD_PRECOMPRESSED && !LWIP_HTTPD_DYNAMIC_HEADERS
+#error "LWIP_HTTPD_PRECOMPRESSED needs LWIP_HTTPD_DYNAMIC_HEADERS (for 304 responses)"
+#endif
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING && (!LWIP_HTTPD_SUPPORT_11_KEEPALIVE || !LWIP_HTTPD_SUPPORT_REQUESTLIST)
+#error "LWIP_HTTPD_SUPPORT_11_PIPELINING needs LWIP_HTTPD_SUPPORT_11_KEEPALIVE and LWIP_HTTPD_SUPPORT_REQUESTLIST"
+#endif
+
 /** Minimum length for a valid HTTP/0.9 request: "GET /\r\n" -> 7 bytes */
 #define MIN_REQ_LEN   7
 
@@ -180,16 +187,41 @@ static char httpd_req_buf[LWIP_HTTPD_MAX_REQ_LENGTH + 1];
 static char http_uri_buf[LWIP_HTTPD_URI_BUF_LEN + 1];
 #endif
 
+#if LWIP_HTTPD_PRECOMPRESSED
+/* "If-None-Match" value of the request passed to http_find_file() */
+static const char *http_if_none_match;
+static u16_t http_if_none_match_len;
+/* Open the variant of a file matching the encodings accepted by the client */
+#define http_fs_open(hs, file, name) fs_open_encoded(file, name, (hs)->accept_encoding)
+#else /* LWIP_HTTPD_PRECOMPRESSED */
+#define http_fs_open(hs, file, name) fs_open(file, name)
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING
+/* The connection answering pipelined requests in http_serve_pipelined() */
+static struct http_state *http_pipelined_hs;
+#endif /* LWIP_HTTPD_SUPPORT_11_PIPELINING */
+
 #if LWIP_HTTPD_DYNAMIC_HEADERS
 /* The number of individual strings that comprise the headers sent before each
  * requested file.
  */
-#define NUM_FILE_HDR_STRINGS 5
 #define HDR_STRINGS_IDX_HTTP_STATUS           0 /* e.g. "HTTP/1.0 200 OK\r\n" */
 #define HDR_STRINGS_IDX_SERVER_NAME           1 /* e.g. "Server: "HTTPD_SERVER_AGENT"\r\n" */
 #define HDR_STRINGS_IDX_CONTENT_LEN_KEEPALIVE 2 /* e.g. "Content-Length: xy\r\n" and/or "Connection: keep-alive\r\n" */
 #define HDR_STRINGS_IDX_CONTENT_LEN_NR        3 /* the byte count, when content-length is used */
+#if LWIP_HTTPD_PRECOMPRESSED
+#define HDR_STRINGS_IDX_CONTENT_ENCODING      4 /* e.g. "Content-Encoding: gzip\r\n" */
+#define HDR_STRINGS_IDX_VARY                  5 /* "Vary: Accept-Encoding\r\n" if the file has variants */
+#define HDR_STRINGS_IDX_ETAG                  6 /* "ETag: " */
+#define HDR_STRINGS_IDX_ETAG_VALUE            7 /* the quoted entity tag of the file */
+#define HDR_STRINGS_IDX_ETAG_END              8 /* CRLF */
+#define HDR_STRINGS_IDX_CONTENT_TYPE          9 /* the content type (or default answer content type including default document) */
+#define NUM_FILE_HDR_STRINGS 10
+#else /* LWIP_HTTPD_PRECOMPRESSED */
 #define HDR_STRINGS_IDX_CONTENT_TYPE          4 /* the content type (or default answer content type including default document) */
+#define NUM_FILE_HDR_STRINGS 5
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
 
 /* The dynamically generated Content-Length buffer needs space for CRLF + NULL */
 #define LWIP_HTTPD_MAX_CONTENT_LEN_OFFSET 3
@@ -249,6 +281,10 @@ struct http_state {
   struct altcp_pcb *pcb;
 #if LWIP_HTTPD_SUPPORT_REQUESTLIST
   struct pbuf *req;
+  u16_t req_scanned; /* bytes of req searched for the end of the headers */
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING
+  u16_t req_len;     /* length of the GET request in req, the rest is pipelined */
+#endif /* LWIP_HTTPD_SUPPORT_11_PIPELINING */
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
 
 #if LWIP_HTTPD_DYNAMIC_FILE_READ
@@ -260,6 +296,9 @@ struct http_state {
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
   u8_t keepalive;
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if LWIP_HTTPD_PRECOMPRESSED
+  u8_t accept_encoding; /* FS_FILE_ENCODING_* bits from "Accept-Encoding" */
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
 #if LWIP_HTTPD_SSI
   struct http_ssi_state *ssi;
 #endif /* LWIP_HTTPD_SSI */
@@ -287,6 +326,13 @@ struct http_state {
 #endif /* LWIP_HTTPD_SUPPORT_POST*/
 };
 
+/** A response is being sent on this connection (the file or dynamic headers) */
+#if LWIP_HTTPD_DYNAMIC_HEADERS
+#define http_response_pending(hs) (((hs)->handle != NULL) || ((hs)->hdr_index < NUM_FILE_HDR_STRINGS))
+#else /* LWIP_HTTPD_DYNAMIC_HEADERS */
+#define http_response_pending(hs) ((hs)->handle != NULL)
+#endif /* LWIP_HTTPD_DYNAMIC_HEADERS */
+
 #if HTTPD_USE_MEM_POOL
 LWIP_MEMPOOL_DECLARE(HTTPD_STATE,     MEMP_NUM_PARALLEL_HTTPD_CONNS,     sizeof(struct http_state),     "HTTPD_STATE")
 #if LWIP_HTTPD_SSI
@@ -311,6 +357,9 @@ static err_t http_find_file(struct http_state *hs, const char *uri, int is_09);
 static err_t http_init_file(struct http_state *hs, struct fs_file *file, int is_09, const char *uri, u8_t tag_check, char *params);
 static err_t http_poll(void *arg, struct altcp_pcb *pcb);
 static u8_t http_check_eof(struct altcp_pcb *pcb, struct http_state *hs);
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING
+static void http_serve_pipelined(struct altcp_pcb *pcb, struct http_state *hs);
+#endif /* LWIP_HTTPD_SUPPORT_11_PIPELINING */
 #if LWIP_HTTPD_FS_ASYNC_READ
 static void http_continue(void *connection);
 #endif /* LWIP_HTTPD_FS_ASYNC_READ */
@@ -382,6 +431,9 @@ http_kill_oldest_connection(u8_t ssi_required)
 {
   struct http_state *hs = http_connections;
   struct http_state *hs_free_next = NULL;
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  struct http_state *hs_free_idle = NULL;
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
   while (hs && hs->next) {
 #if LWIP_HTTPD_SSI
     if (ssi_required) {
@@ -394,10 +446,26 @@ http_kill_oldest_connection(u8_t ssi_required)
 #endif /* LWIP_HTTPD_SSI */
     {
       hs_free_next = hs;
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+      /* a persistent connection waiting for its next request costs the
+         client least (it just reconnects) */
+      if (hs->next->keepalive && !http_response_pending(hs->next)
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+          && (hs->next->req == NULL)
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+         ) {
+        hs_free_idle = hs;
+      }
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
     }
     LWIP_ASSERT("broken list", hs != hs->next);
     hs = hs->next;
   }
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  if (hs_free_idle != NULL) {
+    hs_free_next = hs_free_idle;
+  }
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
   if (hs_free_next != NULL) {
     LWIP_ASSERT("hs_free_next->next != NULL", hs_free_next->next != NULL);
     LWIP_ASSERT("hs_free_next->next->pcb != NULL", hs_free_next->next->pcb != NULL);
@@ -516,6 +584,12 @@ http_state_free(struct http_state *hs)
   if (hs != NULL) {
     http_state_eof(hs);
     http_remove_connection(hs);
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING
+    if (http_pipelined_hs == hs) {
+      /* tell http_serve_pipelined() to stop */
+      http_pipelined_hs = NULL;
+    }
+#endif /* LWIP_HTTPD_SUPPORT_11_PIPELINING */
     HTTP_FREE_HTTP_STATE(hs);
   }
 }
@@ -657,6 +731,11 @@ http_eof(struct altcp_pcb *pcb, struct http_state *hs)
   /* HTTP/1.1 persistent connection? (Not supported for SSI) */
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
   if (hs->keepalive) {
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING
+    /* requests received while sending this response */
+    struct pbuf *pipelined = hs->req;
+    hs->req = NULL;
+#endif /* LWIP_HTTPD_SUPPORT_11_PIPELINING */
     http_remove_connection(hs);
 
     http_state_eof(hs);
@@ -667,6 +746,12 @@ http_eof(struct altcp_pcb *pcb, struct http_state *hs)
     http_add_connection(hs);
     /* ensure nagle doesn't interfere with sending all data as fast as possible: */
     altcp_nagle_disable(pcb);
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING
+    if (pipelined != NULL) {
+      hs->req = pipelined;
+      http_serve_pipelined(pcb, hs);
+    }
+#endif /* LWIP_HTTPD_SUPPORT_11_PIPELINING */
   } else
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
   {
@@ -834,6 +919,38 @@ get_tag_insert(struct http_state *hs)
 #endif /* LWIP_HTTPD_SSI */
 
 #if LWIP_HTTPD_DYNAMIC_HEADERS
+#if LWIP_HTTPD_PRECOMPRESSED
+/** Set up the Content-Encoding, Vary and ETag headers of a file
+ * (file may be NULL to clear them)
+ */
+static void
+get_http_encoding_headers(struct http_state *hs, const struct fs_file *file)
+{
+  hs->hdrs[HDR_STRINGS_IDX_CONTENT_ENCODING] = NULL;
+  hs->hdrs[HDR_STRINGS_IDX_VARY] = NULL;
+  hs->hdrs[HDR_STRINGS_IDX_ETAG] = NULL;
+  hs->hdrs[HDR_STRINGS_IDX_ETAG_VALUE] = NULL;
+  hs->hdrs[HDR_STRINGS_IDX_ETAG_END] = NULL;
+  if (file == NULL) {
+    return;
+  }
+  if (file->encoding == FS_FILE_ENCODING_GZIP) {
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_ENCODING] = HTTP_HDR_ENCODING_GZIP;
+  } else if (file->encoding == FS_FILE_ENCODING_DEFLATE) {
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_ENCODING] = HTTP_HDR_ENCODING_DEFLATE;
+  }
+  if (file->flags & FS_FILE_FLAGS_VARIANTS) {
+    /* caches must not serve this variant to clients accepting other codings */
+    hs->hdrs[HDR_STRINGS_IDX_VARY] = HTTP_HDR_VARY_ENCODING;
+  }
+  if (file->etag != NULL) {
+    hs->hdrs[HDR_STRINGS_IDX_ETAG] = HTTP_HDR_ETAG;
+    hs->hdrs[HDR_STRINGS_IDX_ETAG_VALUE] = file->etag;
+    hs->hdrs[HDR_STRINGS_IDX_ETAG_END] = CRLF;
+  }
+}
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+
 /**
  * Generate the relevant HTTP headers for the given filename and write
  * them into the supplied buffer.
@@ -851,6 +968,9 @@ get_http_headers(struct http_state *hs, const char *uri)
   hs->hdrs[HDR_STRINGS_IDX_SERVER_NAME] = g_psHTTPHeaderStrings[HTTP_HDR_SERVER];
   hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_KEEPALIVE] = NULL;
   hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_NR] = NULL;
+#if LWIP_HTTPD_PRECOMPRESSED
+  get_http_encoding_headers(hs, hs->handle);
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
 
   /* Is this a normal file or the special case we use to send back the
      default "404: Page not found" response? */
@@ -986,6 +1106,69 @@ get_http_content_length(struct http_state *hs)
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
 }
 
+#if LWIP_HTTPD_PRECOMPRESSED
+/** Check if the value of an "If-None-Match" header matches an entity tag
+ * ("*" or one of the listed tags, compared weakly as required by RFC 7232)
+ */
+static u8_t
+http_etag_match(const char *inm, u16_t inm_len, const char *etag)
+{
+  const char *end = inm + inm_len;
+  size_t etag_len = strlen(etag);
+
+  while (inm < end) {
+    if (*inm == '*') {
+      return 1;
+    }
+    if (*inm == '"') {
+      /* a quoted tag, "W/" prefixes are ignored (weak comparison) */
+      const char *tag_end = (const char *)memchr(inm + 1, '"', (size_t)(end - inm - 1));
+      if (tag_end == NULL) {
+        break;
+      }
+      if (((size_t)(tag_end + 1 - inm) == etag_len) && !memcmp(inm, etag, etag_len)) {
+        return 1;
+      }
+      inm = tag_end;
+    }
+    inm++;
+  }
+  return 0;
+}
+
+/** Answer a conditional request for an unchanged file with a header-only
+ * "304 Not Modified" response. The file is closed, the ETag and encoding
+ * headers point to the (persistent) file system data.
+ */
+static err_t
+http_init_not_modified(struct http_state *hs, struct fs_file *file)
+{
+  hs->hdrs[HDR_STRINGS_IDX_HTTP_STATUS] = HTTP_HDR_NOT_MODIFIED;
+  hs->hdrs[HDR_STRINGS_IDX_SERVER_NAME] = g_psHTTPHeaderStrings[HTTP_HDR_SERVER];
+  /* a 304 response never has a body, so no Content-Length is needed to keep the connection */
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  if (hs->keepalive) {
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_KEEPALIVE] = g_psHTTPHeaderStrings[HTTP_HDR_CONN_KEEPALIVE];
+  } else
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+  {
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_KEEPALIVE] = g_psHTTPHeaderStrings[HTTP_HDR_CONN_CLOSE];
+  }
+  hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_NR] = NULL;
+  get_http_encoding_headers(hs, file);
+  hs->hdrs[HDR_STRINGS_IDX_CONTENT_TYPE] = CRLF;
+  hs->hdr_index = 0;
+  hs->hdr_pos = 0;
+
+  fs_close(file);
+  hs->handle = NULL;
+  hs->file = NULL;
+  hs->left = 0;
+  hs->retries = 0;
+  return ERR_OK;
+}
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+
 /** Sub-function of http_send(): send dynamic headers
  *
  * @returns: - HTTP_NO_DATA_TO_SEND: no new data has been enqueued
@@ -1645,11 +1828,11 @@ http_find_error_file(struct http_state *hs, u16_t error_nr)
     uri2 = "/400.htm";
     uri3 = "/400.shtml";
   }
-  if (fs_open(&hs->file_handle, uri1) == ERR_OK) {
+  if (http_fs_open(hs, &hs->file_handle, uri1) == ERR_OK) {
     uri = uri1;
-  } else if (fs_open(&hs->file_handle, uri2) == ERR_OK) {
+  } else if (http_fs_open(hs, &hs->file_handle, uri2) == ERR_OK) {
     uri = uri2;
-  } else if (fs_open(&hs->file_handle, uri3) == ERR_OK) {
+  } else if (http_fs_open(hs, &hs->file_handle, uri3) == ERR_OK) {
     uri = uri3;
   } else {
     LWIP_DEBUGF(HTTPD_DEBUG, ("Error page for error %"U16_F" not found\n",
@@ -1675,15 +1858,15 @@ http_get_404_file(struct http_state *hs, const char **uri)
   err_t err;
 
   *uri = "/404.html";
-  err = fs_open(&hs->file_handle, *uri);
+  err = http_fs_open(hs, &hs->file_handle, *uri);
   if (err != ERR_OK) {
     /* 404.html doesn't exist. Try 404.htm instead. */
     *uri = "/404.htm";
-    err = fs_open(&hs->file_handle, *uri);
+    err = http_fs_open(hs, &hs->file_handle, *uri);
     if (err != ERR_OK) {
       /* 404.htm doesn't exist either. Try 404.shtml instead. */
       *uri = "/404.shtml";
-      err = fs_open(&hs->file_handle, *uri);
+      err = http_fs_open(hs, &hs->file_handle, *uri);
       if (err != ERR_OK) {
         /* 404.htm doesn't exist either. Indicate to the caller that it should
          * send back a default 404 page.
@@ -1693,6 +1876,10 @@ http_get_404_file(struct http_state *hs, const char **uri)
       }
     }
   }
+#if LWIP_HTTPD_PRECOMPRESSED
+  /* error pages are never answered with "304 Not Modified" */
+  hs->file_handle.etag = NULL;
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
 
   return &hs->file_handle;
 }
@@ -1937,6 +2124,106 @@ http_continue(void *connection)
 }
 #endif /* LWIP_HTTPD_FS_ASYNC_READ */
 
+#if LWIP_HTTPD_PRECOMPRESSED || LWIP_HTTPD_SUPPORT_11_PIPELINING
+/** Find a request header in the header lines starting at 'hdrs'.
+ *
+ * @param name header name including the ':' (compared case-insensitively)
+ * @param value_len receives the length of the value (up to the CRLF)
+ * @return the value (without leading whitespace) or NULL if not found
+ */
+static const char *
+http_get_request_header(const char *hdrs, const char *end, const char *name, u16_t *value_len)
+{
+  size_t name_len = strlen(name);
+  const char *line = hdrs;
+
+  while (line < end) {
+    const char *line_end = lwip_strnstr(line, CRLF, (size_t)(end - line));
+    if ((line_end == NULL) || (line_end == line)) {
+      /* incomplete line or end of headers */
+      break;
+    }
+    if (((size_t)(line_end - line) >= name_len) && !lwip_strnicmp(line, name, name_len)) {
+      const char *value = line + name_len;
+      while ((value < line_end) && ((*value == ' ') || (*value == '\t'))) {
+        value++;
+      }
+      *value_len = (u16_t)(line_end - value);
+      return value;
+    }
+    line = line_end + 2;
+  }
+  return NULL;
+}
+#endif /* LWIP_HTTPD_PRECOMPRESSED || LWIP_HTTPD_SUPPORT_11_PIPELINING */
+
+#if LWIP_HTTPD_PRECOMPRESSED
+/** Check if the parameters of an "Accept-Encoding" entry contain "q=0" */
+static u8_t
+http_qvalue_is_zero(const char *param, const char *end)
+{
+  for (; param + 2 < end; param++) {
+    if (((param[0] == 'q') || (param[0] == 'Q')) && (param[1] == '=')) {
+      const char *q = param + 2;
+      if (*q != '0') {
+        return 0;
+      }
+      q++;
+      if ((q < end) && (*q == '.')) {
+        q++;
+        while ((q < end) && (*q == '0')) {
+          q++;
+        }
+      }
+      return (q == end) || (*q == ' ') || (*q == ';');
+    }
+  }
+  return 0;
+}
+
+/** Parse the value of an "Accept-Encoding" header into FS_FILE_ENCODING_* bits */
+static u8_t
+http_parse_accept_encoding(const char *value, u16_t value_len)
+{
+  const char *end = value + value_len;
+  u8_t accepted = 0;
+  u8_t refused = 0;
+
+  while (value < end) {
+    const char *token;
+    size_t token_len;
+    u8_t coding = 0;
+
+    while ((value < end) && ((*value == ' ') || (*value == ','))) {
+      value++;
+    }
+    token = value;
+    while ((value < end) && (*value != ',') && (*value != ';') && (*value != ' ')) {
+      value++;
+    }
+    token_len = (size_t)(value - token);
+    if (((token_len == 4) && !lwip_strnicmp(token, "gzip", 4)) ||
+        ((token_len == 6) && !lwip_strnicmp(token, "x-gzip", 6))) {
+      coding = FS_FILE_ENCODING_GZIP;
+    } else if ((token_len == 7) && !lwip_strnicmp(token, "deflate", 7)) {
+      coding = FS_FILE_ENCODING_DEFLATE;
+    } else if ((token_len == 1) && (*token == '*')) {
+      coding = FS_FILE_ENCODING_GZIP | FS_FILE_ENCODING_DEFLATE;
+    }
+    token = value;
+    while ((value < end) && (*value != ',')) {
+      value++;
+    }
+    if (http_qvalue_is_zero(token, value)) {
+      refused |= coding;
+    } else {
+      accepted |= coding;
+    }
+  }
+  return (u8_t)(accepted & ~refused);
+}
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+
 /**
  * When data has been received in the correct state, try to parse it
  * as a HTTP request.
@@ -1957,6 +2244,7 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
   struct pbuf *p = inp;
 #if LWIP_HTTPD_SUPPORT_REQUESTLIST
   u16_t clen;
+  u16_t hdr_end;
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
 #if LWIP_HTTPD_SUPPORT_POST
   err_t err;
@@ -1990,9 +2278,20 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
   /* increase pbuf ref counter as it is freed when we return but we want to
      keep it on the req list */
   pbuf_ref(p);
-
-  if (hs->req->next != NULL) {
-    data_len = LWIP_MIN(hs->req->tot_len, LWIP_HTTPD_MAX_REQ_LENGTH);
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING
+  hs->req_len = 0;
+#endif /* LWIP_HTTPD_SUPPORT_11_PIPELINING */
+
+  /* Only search the new data (and the last 3 bytes before it) for the end
+     of the headers: the request is copied and parsed once it is complete,
+     not again for every pbuf received. */
+  hdr_end = pbuf_memfind(hs->req, CRLF CRLF, 4, hs->req_scanned);
+  if (hdr_end == 0xFFFF) {
+    hs->req_scanned = (u16_t)(LWIP_MAX(hs->req->tot_len, 3) - 3);
+    data = NULL;
+    data_len = 0;
+  } else if (hs->req->next != NULL) {
+    data_len = (u16_t)LWIP_MIN(hdr_end + 4, (int)LWIP_HTTPD_MAX_REQ_LENGTH);
     pbuf_copy_partial(hs->req, httpd_req_buf, data_len, 0);
     data = httpd_req_buf;
   } else
@@ -2000,6 +2299,10 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
   {
     data = (char *)p->payload;
     data_len = p->len;
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+    /* the request ends with the headers, pipelined requests may follow */
+    data_len = (u16_t)(hdr_end + 4);
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
     if (p->len != p->tot_len) {
       LWIP_DEBUGF(HTTPD_DEBUG, ("Warning: incomplete header due to chained pbufs\n"));
     }
@@ -2059,7 +2362,23 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
         /* wait for CRLFCRLF (indicating end of HTTP headers) before parsing anything */
         if (lwip_strnstr(data, CRLF CRLF, data_len) != NULL) {
           char *uri = sp1 + 1;
-#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING
+          /* HTTP/1.1 connections are persistent unless "close" is specified,
+             HTTP/1.0 connections only if "keep-alive" is specified */
+          hs->keepalive = 0;
+          if (!is_09) {
+            u16_t conn_len;
+            const char *conn = http_get_request_header(crlf + 2, data + data_len,
+                                                       "Connection:", &conn_len);
+            if ((conn != NULL) && (conn_len >= 5) && !lwip_strnicmp(conn, "close", 5)) {
+              hs->keepalive = 0;
+            } else if ((conn != NULL) && (conn_len >= 10) && !lwip_strnicmp(conn, "keep-alive", 10)) {
+              hs->keepalive = 1;
+            } else if ((crlf - sp2 > 8) && !strncmp(sp2 + 1, "HTTP/1.1", 8)) {
+              hs->keepalive = 1;
+            }
+          }
+#elif LWIP_HTTPD_SUPPORT_11_KEEPALIVE
           /* This is HTTP/1.0 compatible: for strict 1.1, a connection
              would always be persistent unless "close" was specified. */
           if (!is_09 && (lwip_strnstr(data, HTTP11_CONNECTIONKEEPALIVE, data_len) ||
@@ -2068,7 +2387,7 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
           } else {
             hs->keepalive = 0;
           }
-#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#endif /* LWIP_HTTPD_SUPPORT_11_PIPELINING */
           /* null-terminate the METHOD (pbuf is freed anyway wen returning) */
           *sp1 = 0;
           uri[uri_len] = 0;
@@ -2095,6 +2414,19 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
           } else
 #endif /* LWIP_HTTPD_SUPPORT_POST */
           {
+#if LWIP_HTTPD_PRECOMPRESSED
+            u16_t accept_len;
+            const char *accept = http_get_request_header(crlf + 2, data + data_len,
+                                                         "Accept-Encoding:", &accept_len);
+            if (accept != NULL) {
+              hs->accept_encoding = http_parse_accept_encoding(accept, accept_len);
+            }
+            http_if_none_match = http_get_request_header(crlf + 2, data + data_len,
+                                                         "If-None-Match:", &http_if_none_match_len);
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING
+            hs->req_len = data_len;
+#endif /* LWIP_HTTPD_SUPPORT_11_PIPELINING */
             return http_find_file(hs, uri, is_09);
           }
         }
@@ -2182,6 +2514,10 @@ http_find_file(struct http_state *hs, const char *uri, int is_09)
 #if LWIP_HTTPD_CGI
   int i;
 #endif /* LWIP_HTTPD_CGI */
+#if LWIP_HTTPD_PRECOMPRESSED
+  const char *if_none_match = http_if_none_match;
+  u16_t if_none_match_len = http_if_none_match_len;
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
 #if !LWIP_HTTPD_SSI
   const
 #endif /* !LWIP_HTTPD_SSI */
@@ -2221,7 +2557,7 @@ http_find_file(struct http_state *hs, const char *uri, int is_09)
         file_name = httpd_default_filenames[loop].name;
       }
       LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Looking for %s...\n", file_name));
-      err = fs_open(&hs->file_handle, file_name);
+      err = http_fs_open(hs, &hs->file_handle, file_name);
       if (err == ERR_OK) {
         uri = file_name;
         file = &hs->file_handle;
@@ -2264,7 +2600,7 @@ http_find_file(struct http_state *hs, const char *uri, int is_09)
 
     LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Opening %s\n", uri));
 
-    err = fs_open(&hs->file_handle, uri);
+    err = http_fs_open(hs, &hs->file_handle, uri);
     if (err == ERR_OK) {
       file = &hs->file_handle;
     } else {
@@ -2286,6 +2622,14 @@ http_find_file(struct http_state *hs, const char *uri, int is_09)
     /* None of the default filenames exist so send back a 404 page */
     file = http_get_404_file(hs, &uri);
   }
+#if LWIP_HTTPD_PRECOMPRESSED
+  /* the If-None-Match header is only valid for this request */
+  http_if_none_match = NULL;
+  if ((if_none_match != NULL) && (file != NULL) && (file->etag != NULL) &&
+      !is_09 && !tag_check && http_etag_match(if_none_match, if_none_match_len, file->etag)) {
+    return http_init_not_modified(hs, file);
+  }
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
   return http_init_file(hs, file, is_09, uri, tag_check, params);
 }
 
@@ -2508,6 +2852,77 @@ http_poll(void *arg, struct altcp_pcb *pcb)
   return ERR_OK;
 }
 
+/**
+ * Parse (the next part of) a request and start sending the response.
+ * The pbuf is freed or kept on the request list.
+ */
+static err_t
+http_handle_request(struct altcp_pcb *pcb, struct http_state *hs, struct pbuf *p)
+{
+  err_t parsed = http_parse_request(p, hs, pcb);
+  LWIP_ASSERT("http_parse_request: unexpected return value", parsed == ERR_OK
+              || parsed == ERR_INPROGRESS || parsed == ERR_ARG || parsed == ERR_USE);
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+  if (parsed != ERR_INPROGRESS) {
+    /* request fully parsed or error */
+    if (hs->req != NULL) {
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING
+      if ((parsed == ERR_OK) && hs->keepalive && (hs->req_len != 0) &&
+          (hs->req_len < hs->req->tot_len)) {
+        /* keep the pipelined requests following this one */
+        hs->req = pbuf_free_header(hs->req, hs->req_len);
+      } else
+#endif /* LWIP_HTTPD_SUPPORT_11_PIPELINING */
+      {
+        pbuf_free(hs->req);
+        hs->req = NULL;
+      }
+    }
+    hs->req_scanned = 0;
+  }
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+  pbuf_free(p);
+  if (parsed == ERR_OK) {
+#if LWIP_HTTPD_SUPPORT_POST
+    if (hs->post_content_len_left == 0)
+#endif /* LWIP_HTTPD_SUPPORT_POST */
+    {
+      LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("http_recv: data %p len %"S32_F"\n", (const void *)hs->file, hs->left));
+      http_send(pcb, hs);
+    }
+  } else if (parsed == ERR_ARG) {
+    /* @todo: close on ERR_USE? */
+    http_close_conn(pcb, hs);
+  }
+  /* hs may have been freed here */
+  return parsed;
+}
+
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING
+/** The response has been sent completely: answer the requests received
+ * in the meantime (in order) */
+static void
+http_serve_pipelined(struct altcp_pcb *pcb, struct http_state *hs)
+{
+  if (http_pipelined_hs == hs) {
+    /* called from http_eof() below, the loop continues */
+    return;
+  }
+  LWIP_ASSERT("http_serve_pipelined: nested call", http_pipelined_hs == NULL);
+  http_pipelined_hs = hs;
+  while ((http_pipelined_hs == hs) && (hs->req != NULL) && !http_response_pending(hs)) {
+    struct pbuf *p = hs->req;
+    hs->req = NULL;
+    if (http_handle_request(pcb, hs, p) != ERR_OK) {
+      /* incomplete request or error */
+      break;
+    }
+    /* http_state_free() resets http_pipelined_hs if the connection was closed */
+  }
+  http_pipelined_hs = NULL;
+}
+#endif /* LWIP_HTTPD_SUPPORT_11_PIPELINING */
+
 /**
  * Data has been received on this pcb.
  * For HTTP 1.0, this should normally only happen once (if the request fits in one packet).
@@ -2534,6 +2949,28 @@ http_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t err)
     return ERR_OK;
   }
 
+#if LWIP_HTTPD_SUPPORT_11_PIPELINING
+  if (hs->keepalive && http_response_pending(hs)
+#if LWIP_HTTPD_SUPPORT_POST
+      && (hs->post_content_len_left == 0)
+#endif /* LWIP_HTTPD_SUPPORT_POST */
+     ) {
+    /* still sending a response: queue the next request(s) */
+    if (hs->req != NULL) {
+      if ((hs->req->tot_len + p->tot_len > LWIP_HTTPD_REQ_BUFSIZE) ||
+          (pbuf_clen(hs->req) >= LWIP_HTTPD_REQ_QUEUELEN)) {
+        /* too much pipelined, let TCP hold the data until we're done */
+        return ERR_MEM;
+      }
+      pbuf_cat(hs->req, p);
+    } else {
+      hs->req = p;
+    }
+    altcp_recved(pcb, p->tot_len);
+    return ERR_OK;
+  }
+#endif /* LWIP_HTTPD_SUPPORT_11_PIPELINING */
+
 #if LWIP_HTTPD_SUPPORT_POST && LWIP_HTTPD_POST_MANUAL_WND
   if (hs->no_auto_wnd) {
     hs->unrecved_bytes += p->tot_len;
@@ -2560,31 +2997,7 @@ http_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t err)
 #endif /* LWIP_HTTPD_SUPPORT_POST */
   {
     if (hs->handle == NULL) {
-      err_t parsed = http_parse_request(p, hs, pcb);
-      LWIP_ASSERT("http_parse_request: unexpected return value", parsed == ERR_OK
-                  || parsed == ERR_INPROGRESS || parsed == ERR_ARG || parsed == ERR_USE);
-#if LWIP_HTTPD_SUPPORT_REQUESTLIST
-      if (parsed != ERR_INPROGRESS) {
-        /* request fully parsed or error */
-        if (hs->req != NULL) {
-          pbuf_free(hs->req);
-          hs->req = NULL;
-        }
-      }
-#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
-      pbuf_free(p);
-      if (parsed == ERR_OK) {
-#if LWIP_HTTPD_SUPPORT_POST
-        if (hs->post_content_len_left == 0)
-#endif /* LWIP_HTTPD_SUPPORT_POST */
-        {
-          LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("http_recv: data %p len %"S32_F"\n", (const void *)hs->file, hs->left));
-          http_send(pcb, hs);
-        }
-      } else if (parsed == ERR_ARG) {
-        /* @todo: close on ERR_USE? */
-        http_close_conn(pcb, hs);
-      }
+      http_handle_request(pcb, hs, p);
     } else {
       LWIP_DEBUGF(HTTPD_DEBUG, ("http_recv: already sending data\n"));
       /* already sending but still receiving data, we might want to RST here? */
@@ -52,6 +52,13 @@ static const char *const g_psHTTPHeaderStrings[] = {
 #define DEFAULT_404_HTML_PERSISTENT 14 /* default 404 body, but including Connection: keep-alive */
 #endif
 
+/* Headers for precompressed files and conditional requests */
+#define HTTP_HDR_NOT_MODIFIED     "HTTP/1.0 304 Not Modified\r\n"
+#define HTTP_HDR_ENCODING_GZIP    "Content-Encoding: gzip\r\n"
+#define HTTP_HDR_ENCODING_DEFLATE "Content-Encoding: deflate\r\n"
+#define HTTP_HDR_VARY_ENCODING    "Vary: Accept-Encoding\r\n"
+#define HTTP_HDR_ETAG             "ETag: "
+
 #define HTTP_CONTENT_TYPE(contenttype) "Content-Type: "contenttype"\r\n\r\n"
 #define HTTP_CONTENT_TYPE_ENCODING(contenttype, encoding) "Content-Type: "contenttype"\r\nContent-Encoding: "encoding"\r\n\r\n"
 
@@ -115,7 +115,8 @@ struct file_entry {
 int process_sub(FILE *data_file, FILE *struct_file);
 int process_file(FILE *data_file, FILE *struct_file, const char *filename);
 int file_write_http_header(FILE *data_file, const char *filename, int file_size, u16_t *http_hdr_len,
-                           u16_t *http_hdr_chksum, u8_t provide_content_len, int is_compressed);
+                           u16_t *http_hdr_chksum, u8_t provide_content_len, const char *encoding,
+                           u8_t vary, const char *etag);
 int file_put_ascii(FILE *file, const char *ascii_string, int len, int *i);
 int s_put_ascii(char *buf, const char *ascii_string, int len, int *i);
 void concat_files(const char *file1, const char *file2, const char *targetfile);
@@ -124,6 +125,7 @@ static int checkSsiByFilelist(const char* filename_listfile);
 static int ext_in_list(const char* filename, const char *ext_list);
 static int file_to_exclude(const char* filename);
 static int file_can_be_compressed(const char* filename);
+static int is_precompressed_variant(const char *filename);
 
 /* 5 bytes per char + 3 bytes per line */
 static char file_buffer_c[COPY_BUFSIZE * 5 + ((COPY_BUFSIZE / HEX_BYTES_PER_LINE) * 3)];
@@ -138,6 +140,8 @@ unsigned char useHttp11 = 0;
 unsigned char supportSsi = 1;
 unsigned char precalcChksum = 0;
 unsigned char includeLastModified = 0;
+unsigned char precompressedVariants = 0;
+unsigned char includeETag = 0;
 #if MAKEFS_SUPPORT_DEFLATE
 unsigned char deflateNonSsiFiles = 0;
 size_t deflatedBytesReduced = 0;
@@ -146,6 +150,17 @@ size_t overallDataBytes = 0;
 const char *exclude_list = NULL;
 const char *ncompress_list = NULL;
 
+/** Precompressed siblings of a file that are attached as variants ("-pre") */
+static const struct {
+  const char *ext;
+  const char *encoding;
+  const char *define;
+} precompressed_exts[] = {
+  { ".gz",      "gzip",    "FS_FILE_ENCODING_GZIP" },
+  { ".deflate", "deflate", "FS_FILE_ENCODING_DEFLATE" }
+};
+#define NUM_PRECOMPRESSED_EXTS LWIP_ARRAYSIZE(precompressed_exts)
+
 struct file_entry *first_file = NULL;
 struct file_entry *last_file = NULL;
 
@@ -155,7 +170,7 @@ static size_t ssi_file_num_lines;
 
 static void print_usage(void)
 {
-  printf(" Usage: htmlgen [targetdir] [-s] [-e] [-11] [-nossi] [-ssi:<filename>] [-c] [-f:<filename>] [-m] [-svr:<name>] [-x:<ext_list>] [-xc:<ext_list>" USAGE_ARG_DEFLATE NEWLINE NEWLINE);
+  printf(" Usage: htmlgen [targetdir] [-s] [-e] [-11] [-nossi] [-ssi:<filename>] [-c] [-f:<filename>] [-m] [-pre] [-etag] [-svr:<name>] [-x:<ext_list>] [-xc:<ext_list>" USAGE_ARG_DEFLATE NEWLINE NEWLINE);
   printf("   targetdir: relative or absolute path to files to convert" NEWLINE);
   printf("   switch -s: toggle processing of subdirectories (default is on)" NEWLINE);
   printf("   switch -e: exclude HTTP header from file (header is created at runtime, default is off)" NEWLINE);
@@ -165,6 +180,9 @@ static void print_usage(void)
   printf("   switch -c: precalculate checksums for all pages (default is off)" NEWLINE);
   printf("   switch -f: target filename (default is \"fsdata.c\")" NEWLINE);
   printf("   switch -m: include \"Last-Modified\" header based on file time" NEWLINE);
+  printf("   switch -pre: attach precompressed siblings (file.gz, file.deflate) as variants" NEWLINE);
+  printf("                selected by httpd via Accept-Encoding (LWIP_HTTPD_PRECOMPRESSED)" NEWLINE);
+  printf("   switch -etag: include a strong \"ETag\" header based on the file contents" NEWLINE);
   printf("   switch -svr: server identifier sent in HTTP response header ('Server' field)" NEWLINE);
   printf("   switch -x: comma separated list of extensions of files to exclude (e.g., -x:json,txt)" NEWLINE);
   printf("   switch -xc: comma separated list of extensions of files to not compress (e.g., -xc:mp3,jpg)" NEWLINE);
@@ -229,6 +247,10 @@ int main(int argc, char *argv[])
         printf("Writing to file \"%s\"\n", targetfile);
       } else if (!strcmp(argv[i], "-m")) {
         includeLastModified = 1;
+      } else if (!strcmp(argv[i], "-pre")) {
+        precompressedVariants = 1;
+      } else if (!strcmp(argv[i], "-etag")) {
+        includeETag = 1;
       } else if (!strcmp(argv[i], "-defl")) {
 #if MAKEFS_SUPPORT_DEFLATE
         char *colon = strstr(argv[i], ":");
@@ -512,6 +534,10 @@ int process_sub(FILE *data_file, FILE *struct_file)
               printf("skipping %s/%s by exclude list (-x option)..." NEWLINE, curSubdir, curName);
               continue;
             }
+            if (precompressedVariants && is_precompressed_variant(curName)) {
+              printf("skipping %s/%s as precompressed variant (-pre option)..." NEWLINE, curSubdir, curName);
+              continue;
+            }
 
             printf("processing %s/%s..." NEWLINE, curSubdir, curName);
 
@@ -902,30 +928,82 @@ static int file_can_be_compressed(const char *filename)
     return (ncompress_list == NULL) || !ext_in_list(filename, ncompress_list);
 }
 
-int process_file(FILE *data_file, FILE *struct_file, const char *filename)
+/** A file is a precompressed variant if it has a "-pre" extension and the
+ * file without that extension exists */
+static int is_precompressed_variant(const char *filename)
+{
+  size_t e;
+  size_t len = strlen(filename);
+  for (e = 0; e < NUM_PRECOMPRESSED_EXTS; e++) {
+    size_t ext_len = strlen(precompressed_exts[e].ext);
+    if ((len > ext_len) && (len - ext_len < MAX_PATH_LEN) &&
+        !strcmp(&filename[len - ext_len], precompressed_exts[e].ext)) {
+      char base[MAX_PATH_LEN];
+      FILE *f;
+      memcpy(base, filename, len - ext_len);
+      base[len - ext_len] = 0;
+      f = fopen(base, "rb");
+      if (f != NULL) {
+        fclose(f);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+static int is_error_page(const char *filename)
+{
+  return (strstr(filename, "404") == filename) ||
+         (strstr(filename, "400") == filename) ||
+         (strstr(filename, "501") == filename);
+}
+
+/** Strong ETag (without the quotes): FNV-1a hash and length of the data sent */
+static void make_etag(char *etag, size_t etag_size, const u8_t *file_data, int file_size)
+{
+  u32_t hash = 2166136261UL;
+  int i;
+  for (i = 0; i < file_size; i++) {
+    hash ^= file_data[i];
+    hash *= 16777619UL;
+  }
+  snprintf(etag, etag_size, "%08x-%x", (unsigned int)hash, (unsigned int)file_size);
+}
+
+static const char *encoding_define(const char *encoding)
+{
+  size_t e;
+  if (encoding != NULL) {
+    for (e = 0; e < NUM_PRECOMPRESSED_EXTS; e++) {
+      if (!strcmp(encoding, precompressed_exts[e].encoding)) {
+        return precompressed_exts[e].define;
+      }
+    }
+  }
+  return "FS_FILE_ENCODING_IDENTITY";
+}
+
+/** Write the data array and the struct fsdata_file of a file or of a
+ * precompressed variant (these are linked via 'variant', not via 'next') */
+static void write_file_entry(FILE *data_file, FILE *struct_file, const char *filename,
+                             const char *qualifiedName, const char *varname, const char *next_var,
+                             u8_t *file_data, int file_size, u8_t flags,
+                             const char *encoding, u8_t vary, const char *variant_var)
 {
-  char varname[MAX_PATH_LEN];
   int i = 0;
-  char qualifiedName[MAX_PATH_LEN];
-  int file_size;
   u16_t http_hdr_chksum = 0;
   u16_t http_hdr_len = 0;
   int chksum_count = 0;
-  u8_t flags = 0;
   u8_t has_content_len;
-  u8_t *file_data;
-  int is_ssi;
-  int can_be_compressed;
-  int is_compressed = 0;
   int flags_printed;
+  char etag[32];
+
+  etag[0] = 0;
+  if (includeETag && !(flags & FS_FILE_FLAGS_SSI) && !is_error_page(filename)) {
+    make_etag(etag, sizeof(etag), file_data, file_size);
+  }
 
-  /* create qualified name (@todo: prepend slash or not?) */
-  sprintf(qualifiedName, "%s/%s", curSubdir, filename);
-  /* create C variable name */
-  strcpy(varname, qualifiedName);
-  /* convert slashes & dots to underscores */
-  fix_filename_for_c(varname, MAX_PATH_LEN);
-  register_filename(varname);
 #if ALIGN_PAYLOAD
   /* to force even alignment of array, type 1 */
   fprintf(data_file, "#if FSDATA_FILE_ALIGNMENT==1" NEWLINE);
@@ -945,15 +1023,10 @@ int process_file(FILE *data_file, FILE *struct_file, const char *filename)
 #endif /* ALIGN_PAYLOAD */
   fprintf(data_file, NEWLINE);
 
-  is_ssi = is_ssi_file(filename);
-  if (is_ssi) {
-    flags |= FS_FILE_FLAGS_SSI;
-  }
-  has_content_len = !is_ssi;
-  can_be_compressed = includeHttpHeader && !is_ssi && file_can_be_compressed(filename);
-  file_data = get_file_data(filename, &file_size, can_be_compressed, &is_compressed);
+  has_content_len = !(flags & FS_FILE_FLAGS_SSI);
   if (includeHttpHeader) {
-    file_write_http_header(data_file, filename, file_size, &http_hdr_len, &http_hdr_chksum, has_content_len, is_compressed);
+    file_write_http_header(data_file, filename, file_size, &http_hdr_len, &http_hdr_chksum, has_content_len,
+                           encoding, vary, etag[0] ? etag : NULL);
     flags |= FS_FILE_FLAGS_HEADER_INCLUDED;
     if (has_content_len) {
       flags |= FS_FILE_FLAGS_HEADER_PERSISTENT;
@@ -968,7 +1041,7 @@ int process_file(FILE *data_file, FILE *struct_file, const char *filename)
 
   /* build declaration of struct fsdata_file in temp file */
   fprintf(struct_file, "const struct fsdata_file file_%s[] = { {" NEWLINE, varname);
-  fprintf(struct_file, "file_%s," NEWLINE, lastFileVar);
+  fprintf(struct_file, "file_%s," NEWLINE, next_var);
   fprintf(struct_file, "data_%s," NEWLINE, varname);
   fprintf(struct_file, "data_%s + %d," NEWLINE, varname, i);
   fprintf(struct_file, "sizeof(data_%s) - %d," NEWLINE, varname, i);
@@ -1007,21 +1080,159 @@ int process_file(FILE *data_file, FILE *struct_file, const char *filename)
     fprintf(struct_file, "#if HTTPD_PRECALCULATED_CHECKSUM" NEWLINE);
     fprintf(struct_file, "%d, chksums_%s," NEWLINE, chksum_count, varname);
     fprintf(struct_file, "#endif /* HTTPD_PRECALCULATED_CHECKSUM */" NEWLINE);
+  } else if (precompressedVariants || includeETag) {
+    /* the members below are initialized by position */
+    fprintf(struct_file, "#if HTTPD_PRECALCULATED_CHECKSUM" NEWLINE);
+    fprintf(struct_file, "0, NULL," NEWLINE);
+    fprintf(struct_file, "#endif /* HTTPD_PRECALCULATED_CHECKSUM */" NEWLINE);
+  }
+  if (precompressedVariants || includeETag) {
+    fprintf(struct_file, "#if LWIP_HTTPD_PRECOMPRESSED" NEWLINE);
+    fprintf(struct_file, "file_%s," NEWLINE, variant_var);
+    if (etag[0]) {
+      fprintf(struct_file, "\"\\\"%s\\\"\"," NEWLINE, etag);
+    } else {
+      fprintf(struct_file, "NULL," NEWLINE);
+    }
+    fprintf(struct_file, "%s," NEWLINE, encoding_define(encoding));
+    fprintf(struct_file, "#endif /* LWIP_HTTPD_PRECOMPRESSED */" NEWLINE);
   }
   fprintf(struct_file, "}};" NEWLINE NEWLINE);
-  strcpy(lastFileVar, varname);
 
   /* write actual file contents */
-  i = 0;
   fprintf(data_file, NEWLINE "/* raw file data (%d bytes) */" NEWLINE, file_size);
   process_file_data(data_file, file_data, file_size);
   fprintf(data_file, "};" NEWLINE NEWLINE);
+}
+
+/** Write the precompressed siblings of a file ("-pre") that are smaller
+ * than the file, largest first so that the list of variants starting at
+ * the last one written (returned in 'variant_var') is sorted by size.
+ * @return the number of variants written
+ */
+static int process_variants(FILE *data_file, FILE *struct_file, const char *filename,
+                            const char *qualifiedName, int file_size, u8_t flags, char *variant_var)
+{
+  u8_t *variant_data[NUM_PRECOMPRESSED_EXTS];
+  int variant_size[NUM_PRECOMPRESSED_EXTS];
+  size_t variant_ext[NUM_PRECOMPRESSED_EXTS];
+  int num_variants = 0;
+  size_t e;
+  int i, j;
+
+  for (e = 0; e < NUM_PRECOMPRESSED_EXTS; e++) {
+    char variant_filename[MAX_PATH_LEN];
+    int is_compressed;
+    FILE *f;
+    snprintf(variant_filename, sizeof(variant_filename), "%s%s", filename, precompressed_exts[e].ext);
+    f = fopen(variant_filename, "rb");
+    if (f == NULL) {
+      continue;
+    }
+    fclose(f);
+    variant_data[num_variants] = get_file_data(variant_filename, &variant_size[num_variants], 0, &is_compressed);
+    if (variant_size[num_variants] >= file_size) {
+      printf(" - %s variant skipped (not smaller than the file)" NEWLINE, precompressed_exts[e].encoding);
+      free(variant_data[num_variants]);
+      continue;
+    }
+    variant_ext[num_variants] = e;
+    num_variants++;
+  }
+  /* sort by size, largest first */
+  for (i = 0; i < num_variants; i++) {
+    for (j = i + 1; j < num_variants; j++) {
+      if (variant_size[j] > variant_size[i]) {
+        u8_t *tmp_data = variant_data[i];
+        int tmp_size = variant_size[i];
+        size_t tmp_ext = variant_ext[i];
+        variant_data[i] = variant_data[j];
+        variant_size[i] = variant_size[j];
+        variant_ext[i] = variant_ext[j];
+        variant_data[j] = tmp_data;
+        variant_size[j] = tmp_size;
+        variant_ext[j] = tmp_ext;
+      }
+    }
+  }
+  for (i = 0; i < num_variants; i++) {
+    char varname[MAX_PATH_LEN];
+    const char *encoding = precompressed_exts[variant_ext[i]].encoding;
+    printf(" - %s variant: %d bytes -> %d bytes" NEWLINE, encoding, file_size, variant_size[i]);
+    snprintf(varname, sizeof(varname), "%s%s", qualifiedName, precompressed_exts[variant_ext[i]].ext);
+    fix_filename_for_c(varname, MAX_PATH_LEN);
+    register_filename(varname);
+    /* variants can only be linked if struct fsdata_file has a 'variant' member */
+    fprintf(data_file, "#if LWIP_HTTPD_PRECOMPRESSED" NEWLINE);
+    fprintf(struct_file, "#if LWIP_HTTPD_PRECOMPRESSED" NEWLINE);
+    write_file_entry(data_file, struct_file, filename, qualifiedName, varname, "NULL",
+                     variant_data[i], variant_size[i], flags, encoding, 1, variant_var);
+    fprintf(data_file, "#endif /* LWIP_HTTPD_PRECOMPRESSED */" NEWLINE NEWLINE);
+    fprintf(struct_file, "#endif /* LWIP_HTTPD_PRECOMPRESSED */" NEWLINE NEWLINE);
+    strcpy(variant_var, varname);
+    free(variant_data[i]);
+  }
+  return num_variants;
+}
+
+int process_file(FILE *data_file, FILE *struct_file, const char *filename)
+{
+  char varname[MAX_PATH_LEN];
+  char qualifiedName[MAX_PATH_LEN];
+  char variant_var[MAX_PATH_LEN];
+  int file_size;
+  u8_t flags = 0;
+  u8_t *file_data;
+  int is_ssi;
+  int can_be_compressed;
+  int is_compressed = 0;
+  int num_variants = 0;
+
+  /* create qualified name (@todo: prepend slash or not?) */
+  sprintf(qualifiedName, "%s/%s", curSubdir, filename);
+  /* create C variable name */
+  strcpy(varname, qualifiedName);
+  /* convert slashes & dots to underscores */
+  fix_filename_for_c(varname, MAX_PATH_LEN);
+  register_filename(varname);
+
+  is_ssi = is_ssi_file(filename);
+  if (is_ssi) {
+    flags |= FS_FILE_FLAGS_SSI;
+  }
+  can_be_compressed = includeHttpHeader && !is_ssi && file_can_be_compressed(filename);
+  file_data = get_file_data(filename, &file_size, can_be_compressed, &is_compressed);
+
+  strcpy(variant_var, "NULL");
+  if (precompressedVariants && !is_ssi && !is_compressed) {
+    num_variants = process_variants(data_file, struct_file, filename, qualifiedName, file_size, flags, variant_var);
+  }
+  write_file_entry(data_file, struct_file, filename, qualifiedName, varname, lastFileVar,
+                   file_data, file_size, flags, is_compressed ? "deflate" : NULL,
+                   num_variants > 0, variant_var);
+  strcpy(lastFileVar, varname);
+
   free(file_data);
   return 0;
 }
 
+/** Write one complete header line (and add it to hdr_buf for the checksum) */
+static int file_put_http_header_line(FILE *data_file, const char *cur_string, size_t *hdr_len)
+{
+  int i = 0;
+  size_t cur_len = strlen(cur_string);
+  fprintf(data_file, NEWLINE "/* \"%s\" (%"SZT_F" bytes) */" NEWLINE, cur_string, cur_len);
+  if (precalcChksum) {
+    LWIP_ASSERT("hdr_len + cur_len <= sizeof(hdr_buf)", *hdr_len + cur_len <= sizeof(hdr_buf));
+    memcpy(&hdr_buf[*hdr_len], cur_string, cur_len);
+    *hdr_len += cur_len;
+  }
+  return file_put_ascii(data_file, cur_string, (int)cur_len, &i);
+}
+
 int file_write_http_header(FILE *data_file, const char *filename, int file_size, u16_t *http_hdr_len,
-                           u16_t *http_hdr_chksum, u8_t provide_content_len, int is_compressed)
+                           u16_t *http_hdr_chksum, u8_t provide_content_len, const char *encoding,
+                           u8_t vary, const char *etag)
 {
   int i = 0;
   int response_type = HTTP_HDR_OK;
@@ -1184,19 +1395,20 @@ int file_write_http_header(FILE *data_file, const char *filename, int file_size,
     }
   }
 
-#if MAKEFS_SUPPORT_DEFLATE
-  if (is_compressed) {
-    /* tell the client about the deflate encoding */
-    LWIP_ASSERT("error", deflateNonSsiFiles);
-    cur_string = "Content-Encoding: deflate\r\n";
-    cur_len = strlen(cur_string);
-    fprintf(data_file, NEWLINE "/* \"%s\" (%d bytes) */" NEWLINE, cur_string, cur_len);
-    written += file_put_ascii(data_file, cur_string, cur_len, &i);
-    i = 0;
+  if (encoding != NULL) {
+    /* tell the client about the content encoding (deflate or precompressed variant) */
+    char encbuf[64];
+    snprintf(encbuf, sizeof(encbuf), "Content-Encoding: %s\r\n", encoding);
+    written += file_put_http_header_line(data_file, encbuf, &hdr_len);
+  }
+  if (vary) {
+    written += file_put_http_header_line(data_file, HTTP_HDR_VARY_ENCODING, &hdr_len);
+  }
+  if (etag != NULL) {
+    char etagbuf[64];
+    snprintf(etagbuf, sizeof(etagbuf), HTTP_HDR_ETAG "\"%s\"\r\n", etag);
+    written += file_put_http_header_line(data_file, etagbuf, &hdr_len);
   }
-#else
-  LWIP_UNUSED_ARG(is_compressed);
-#endif
 
   /* write content-type, ATTENTION: this includes the double-CRLF! */
   cur_string = file_type;
@@ -330,14 +330,14 @@ mdns_domain_add_label(struct mdns_domain *domain, const char *label, u8_t len)
  * Add a label part to a domain (@see mdns_domain_add_label but copy directly from pbuf)
  */
 static err_t
-mdns_domain_add_label_pbuf(struct mdns_domain *domain, const struct pbuf *p, u16_t offset, u8_t len)
+mdns_domain_add_label_pbuf(struct mdns_domain *domain, struct pbuf_cursor *cur, u8_t len)
 {
   err_t err = mdns_domain_add_label_base(domain, len);
   if (err != ERR_OK) {
     return err;
   }
   if (len) {
-    if (pbuf_copy_partial(p, &domain->name[domain->length], len, offset) != len) {
+    if (pbuf_cursor_read(cur, &domain->name[domain->length], len) != len) {
       /* take back the ++ done before */
       domain->length--;
       return ERR_ARG;
@@ -349,64 +349,60 @@ mdns_domain_add_label_pbuf(struct mdns_domain *domain, const struct pbuf *p, u16
 
 /**
  * Internal readname function with max 6 levels of recursion following jumps
- * while decompressing name
+ * while decompressing name. The cursor is moved behind the name (a jump is
+ * followed with a copy of it).
  */
-static u16_t
-mdns_readname_loop(struct pbuf *p, u16_t offset, struct mdns_domain *domain, unsigned depth)
+static err_t
+mdns_readname_loop(struct pbuf_cursor *cur, struct mdns_domain *domain, unsigned depth)
 {
-  u8_t c;
+  int c;
 
   do {
     if (depth > 5) {
       /* Too many jumps */
-      return MDNS_READNAME_ERROR;
+      return ERR_VAL;
     }
 
-    c = pbuf_get_at(p, offset);
-    offset++;
+    c = pbuf_cursor_get(cur);
+    if (c < 0) {
+      /* name runs past the end of the packet */
+      return ERR_VAL;
+    }
 
     /* is this a compressed label? */
     if ((c & 0xc0) == 0xc0) {
       u16_t jumpaddr;
-      if (offset >= p->tot_len) {
+      int c2 = pbuf_cursor_get(cur);
+      if (c2 < 0) {
         /* Make sure both jump bytes fit in the packet */
-        return MDNS_READNAME_ERROR;
+        return ERR_VAL;
       }
-      jumpaddr = (((c & 0x3f) << 8) | (pbuf_get_at(p, offset) & 0xff));
-      offset++;
-      if (jumpaddr >= SIZEOF_DNS_HDR && jumpaddr < p->tot_len) {
-        u16_t res;
-        /* Recursive call, maximum depth will be checked */
-        res = mdns_readname_loop(p, jumpaddr, domain, depth + 1);
-        /* Dont return offset since new bytes were not read (jumped to somewhere in packet) */
-        if (res == MDNS_READNAME_ERROR) {
-          return res;
-        }
-      } else {
-        return MDNS_READNAME_ERROR;
+      jumpaddr = (u16_t)(((c & 0x3f) << 8) | c2);
+      if (jumpaddr >= SIZEOF_DNS_HDR && jumpaddr < cur->head->tot_len) {
+        /* Recursive call, maximum depth will be checked. The cursor stays
+           here since new bytes were not read (jumped to somewhere in packet) */
+        struct pbuf_cursor jump = *cur;
+        pbuf_cursor_seek(&jump, jumpaddr);
+        return mdns_readname_loop(&jump, domain, depth + 1);
       }
-      break;
+      return ERR_VAL;
     }
 
     /* normal label */
     if (c <= MDNS_LABEL_MAXLEN) {
-      err_t res;
-
       if (c + domain->length >= MDNS_DOMAIN_MAXLEN) {
-        return MDNS_READNAME_ERROR;
+        return ERR_VAL;
       }
-      res = mdns_domain_add_label_pbuf(domain, p, offset, c);
-      if (res != ERR_OK) {
-        return MDNS_READNAME_ERROR;
+      if (mdns_domain_add_label_pbuf(domain, cur, (u8_t)c) != ERR_OK) {
+        return ERR_VAL;
       }
-      offset += c;
     } else {
       /* bad length byte */
-      return MDNS_READNAME_ERROR;
+      return ERR_VAL;
     }
   } while (c != 0);
 
-  return offset;
+  return ERR_OK;
 }
 
 /**
@@ -420,8 +416,14 @@ mdns_readname_loop(struct pbuf *p, u16_t offset, struct mdns_domain *domain, uns
 u16_t
 mdns_readname(struct pbuf *p, u16_t offset, struct mdns_domain *domain)
 {
+  struct pbuf_cursor cur;
+
   memset(domain, 0, sizeof(struct mdns_domain));
-  return mdns_readname_loop(p, offset, domain, 0);
+  pbuf_cursor_init(&cur, p, offset);
+  if (mdns_readname_loop(&cur, domain, 0) != ERR_OK) {
+    return MDNS_READNAME_ERROR;
+  }
+  return pbuf_cursor_pos(&cur);
 }
 
 /**
@@ -61,6 +61,10 @@
 
 #if LWIP_TCP && LWIP_CALLBACK_API
 
+#if MQTT_PUBLISH_ZEROCOPY && !LWIP_ALTCP && !TCP_WRITE_ZEROCOPY
+#error "MQTT_PUBLISH_ZEROCOPY needs TCP_WRITE_ZEROCOPY (or LWIP_ALTCP)"
+#endif
+
 /**
  * MQTT_DEBUG: Default is off.
  */
@@ -161,19 +165,38 @@ mqtt_msg_type_to_str(u8_t msg_type)
 #endif
 
 
+/** Request timeout in cyclic timer intervals */
+#define MQTT_REQ_TIMEOUT_TICKS ((MQTT_REQ_TIMEOUT + MQTT_CYCLIC_TIMER_INTERVAL - 1) / MQTT_CYCLIC_TIMER_INTERVAL)
+
+/** Request item of a packet identifier */
+#define mqtt_request_slot(r_objs, r_objs_len, pkt_id) (&(r_objs)[(pkt_id) % (r_objs_len)])
+
+/** Request item is not in use */
+#define mqtt_request_is_free(r) ((r)->next == (r))
+
 /**
  * Generate MQTT packet identifier
+ * The identifier is chosen so that its request item is unused, i.e. no other
+ * request with this identifier is pending and the request can be found by
+ * mqtt_take_request() without searching.
  * @param client MQTT client
- * @return New packet identifier, range 1 to 65535
+ * @return New packet identifier, range 1 to 65535, 0 if all request items are in use
  */
 static u16_t
 msg_generate_packet_id(mqtt_client_t *client)
 {
-  client->pkt_id_seq++;
-  if (client->pkt_id_seq == 0) {
+  u16_t n;
+  /* One extra try as the sequence skips 0 when wrapping */
+  for (n = 0; n <= LWIP_ARRAYSIZE(client->req_list); n++) {
     client->pkt_id_seq++;
+    if (client->pkt_id_seq == 0) {
+      client->pkt_id_seq++;
+    }
+    if (mqtt_request_is_free(mqtt_request_slot(client->req_list, LWIP_ARRAYSIZE(client->req_list), client->pkt_id_seq))) {
+      return client->pkt_id_seq;
+    }
   }
-  return client->pkt_id_seq;
+  return 0;
 }
 
 /*--------------------------------------------------------------------------------------------------------------------- */
@@ -225,46 +248,264 @@ mqtt_ringbuf_len(struct mqtt_ringbuf_t *rb)
 /** Return number of bytes possible to read without wrapping around */
 #define mqtt_ringbuf_linear_read_length(rb) LWIP_MIN(mqtt_ringbuf_len(rb), (MQTT_OUTPUT_RINGBUF_SIZE - (rb)->get))
 
+#if MQTT_PUBLISH_ZEROCOPY
 /**
- * Try send as many bytes as possible from output ring buffer
- * @param rb Output ring buffer
- * @param tpcb TCP connection handle
+ * Referenced payload states
+ */
+enum {
+  MQTT_REF_ALLOCATED = 1,
+  /** The request is complete (acknowledged, timed out or failed) */
+  MQTT_REF_REQ_DONE = 2,
+  /** The connection does not reference the payload any more */
+  MQTT_REF_RELEASED = 4
+};
+#define MQTT_REF_COMPLETE (MQTT_REF_ALLOCATED | MQTT_REF_REQ_DONE | MQTT_REF_RELEASED)
+
+/** Milliseconds between checks for payloads released after the connection was closed */
+#define MQTT_REF_POLL_INTERVAL 100
+
+/**
+ * Free a referenced payload and notify the upper layer if both the request
+ * is complete and the payload has been released by the connection
+ * @param ref Referenced payload
  */
 static void
-mqtt_output_send(struct mqtt_ringbuf_t *rb, struct altcp_pcb *tpcb)
+mqtt_output_ref_complete(struct mqtt_output_ref_t *ref)
 {
-  err_t err;
-  u8_t wrap = 0;
-  u16_t ringbuf_lin_len = mqtt_ringbuf_linear_read_length(rb);
-  u16_t send_len = altcp_sndbuf(tpcb);
-  LWIP_ASSERT("mqtt_output_send: tpcb != NULL", tpcb != NULL);
+  if (ref->state == MQTT_REF_COMPLETE) {
+    ref->state = 0;
+    if (ref->cb != NULL) {
+      ref->cb(ref->arg, ref->err);
+    }
+  }
+}
 
-  if (send_len == 0 || ringbuf_lin_len == 0) {
-    return;
+/**
+ * Request callback of publish messages with a referenced payload
+ * @param arg Referenced payload
+ * @param err Result of the request
+ */
+static void
+mqtt_output_ref_request_cb(void *arg, err_t err)
+{
+  struct mqtt_output_ref_t *ref = (struct mqtt_output_ref_t *)arg;
+  ref->err = err;
+  ref->state |= MQTT_REF_REQ_DONE;
+  mqtt_output_ref_complete(ref);
+}
+
+#if !LWIP_ALTCP
+/**
+ * tcp_write_zc() completion callback: this must not call back into the
+ * connection, so the upper layer is notified from mqtt_output_ref_poll()
+ * @param zc Write handle
+ * @param arg Referenced payload
+ */
+static void
+mqtt_output_ref_zc_done(struct tcp_zc_write *zc, void *arg)
+{
+  struct mqtt_output_ref_t *ref = (struct mqtt_output_ref_t *)arg;
+  LWIP_UNUSED_ARG(zc);
+  ref->state |= MQTT_REF_RELEASED;
+}
+#endif /* !LWIP_ALTCP */
+
+/**
+ * Notify the upper layer of all publish messages with a referenced payload
+ * that are complete
+ * @param client MQTT client
+ */
+static void
+mqtt_output_ref_poll(mqtt_client_t *client)
+{
+  u8_t n;
+  for (n = 0; n < LWIP_ARRAYSIZE(client->output_ref_list); n++) {
+    mqtt_output_ref_complete(&client->output_ref_list[n]);
   }
+}
 
-  LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_output_send: tcp_sndbuf: %d bytes, ringbuf_linear_available: %d, get %d, put %d\n",
-                                 send_len, ringbuf_lin_len, rb->get, rb->put));
+/**
+ * Check if the connection references any payload
+ * @param client MQTT client
+ * @return 1 if a payload has been written but not released yet
+ */
+static u8_t
+mqtt_output_ref_pending(mqtt_client_t *client)
+{
+  u8_t n;
+  for (n = 0; n < LWIP_ARRAYSIZE(client->output_ref_list); n++) {
+    struct mqtt_output_ref_t *ref = &client->output_ref_list[n];
+    if ((ref->state & MQTT_REF_ALLOCATED) && !(ref->state & MQTT_REF_RELEASED) && (ref->written > 0)) {
+      return 1;
+    }
+  }
+  return 0;
+}
 
-  if (send_len > ringbuf_lin_len) {
-    /* Space in TCP output buffer is larger than available in ring buffer linear portion */
-    send_len = ringbuf_lin_len;
-    /* Wrap around if more data in ring buffer after linear portion */
-    wrap = (mqtt_ringbuf_len(rb) > ringbuf_lin_len);
+/**
+ * Timer polling for referenced payloads the stack still held when the
+ * connection was closed
+ * @param arg MQTT client
+ */
+static void
+mqtt_output_ref_timer(void *arg)
+{
+  mqtt_client_t *client = (mqtt_client_t *)arg;
+  mqtt_output_ref_poll(client);
+  if (mqtt_output_ref_pending(client)) {
+    sys_timeout(MQTT_REF_POLL_INTERVAL, mqtt_output_ref_timer, client);
   }
-  err = altcp_write(tpcb, mqtt_ringbuf_get_ptr(rb), send_len, TCP_WRITE_FLAG_COPY | (wrap ? TCP_WRITE_FLAG_MORE : 0));
-  if ((err == ERR_OK) && wrap) {
-    mqtt_ringbuf_advance_get_idx(rb, send_len);
-    /* Use the lesser one of ring buffer linear length and TCP send buffer size */
-    send_len = LWIP_MIN(altcp_sndbuf(tpcb), mqtt_ringbuf_linear_read_length(rb));
-    err = altcp_write(tpcb, mqtt_ringbuf_get_ptr(rb), send_len, TCP_WRITE_FLAG_COPY);
+}
+
+/**
+ * End all referenced payloads after the connection has been closed.
+ * Payloads not written to the connection are given back at once, the others
+ * stay allocated until the stack (or the netif driver) has released them.
+ * @param client MQTT client
+ */
+static void
+mqtt_output_ref_clear(mqtt_client_t *client)
+{
+  u8_t n;
+  client->output_refs = NULL;
+  for (n = 0; n < LWIP_ARRAYSIZE(client->output_ref_list); n++) {
+    struct mqtt_output_ref_t *ref = &client->output_ref_list[n];
+    if (ref->state & MQTT_REF_ALLOCATED) {
+      if (!(ref->state & MQTT_REF_REQ_DONE)) {
+        ref->err = ERR_CONN;
+        ref->state |= MQTT_REF_REQ_DONE;
+      }
+#if !LWIP_ALTCP
+      if (ref->written == 0)
+#endif /* !LWIP_ALTCP */
+      {
+        /* not referenced by the connection */
+        ref->state |= MQTT_REF_RELEASED;
+      }
+      mqtt_output_ref_complete(ref);
+    }
   }
+  sys_untimeout(mqtt_output_ref_timer, client);
+  if (mqtt_output_ref_pending(client)) {
+    sys_timeout(MQTT_REF_POLL_INTERVAL, mqtt_output_ref_timer, client);
+  }
+}
 
-  if (err == ERR_OK) {
+/**
+ * Write (a part of) the first referenced payload to the connection
+ * @param client MQTT client
+ * @param ref First referenced payload in output queue
+ * @param send_len Space in TCP output buffer
+ * @return ERR_OK if data has been written
+ */
+static err_t
+mqtt_output_write_ref(mqtt_client_t *client, struct mqtt_output_ref_t *ref, u16_t send_len)
+{
+  err_t err;
+#if LWIP_ALTCP
+  /* altcp has no zero-copy write (e.g. TLS encrypts the data anyway),
+     so the payload is copied into the connection, not the ring buffer */
+  send_len = LWIP_MIN(send_len, ref->len - ref->written);
+  if (send_len == 0) {
+    return ERR_MEM;
+  }
+  err = altcp_write(client->conn, ref->data + ref->written, send_len,
+                    TCP_WRITE_FLAG_COPY | (ref->written + send_len < ref->len ? TCP_WRITE_FLAG_MORE : 0));
+  if (err != ERR_OK) {
+    return err;
+  }
+  ref->written += send_len;
+  if (ref->written == ref->len) {
+    ref->state |= MQTT_REF_RELEASED;
+  }
+#else /* LWIP_ALTCP */
+  struct tcp_zc_iovec iov;
+  if (send_len < ref->len) {
+    /* the payload is written at once */
+    return ERR_MEM;
+  }
+  iov.base = ref->data;
+  iov.len = ref->len;
+  ref->zc.done_fn = mqtt_output_ref_zc_done;
+  ref->zc.done_arg = ref;
+  err = tcp_write_zc(client->conn, &ref->zc, &iov, 1, 0);
+  if (err != ERR_OK) {
+    return err;
+  }
+  ref->written = ref->len;
+#endif /* LWIP_ALTCP */
+  if (ref->written == ref->len) {
+    /* Continue with the ring buffer data after this message */
+    client->output_refs = ref->next;
+    ref->next = NULL;
+  }
+  return ERR_OK;
+}
+#endif /* MQTT_PUBLISH_ZEROCOPY */
+
+/**
+ * Try send as many bytes as possible from output ring buffer (and the
+ * referenced payloads in between), all in one burst
+ * @param client MQTT client
+ */
+static void
+mqtt_output_send(mqtt_client_t *client)
+{
+  struct mqtt_ringbuf_t *rb = &client->output;
+  struct altcp_pcb *tpcb = client->conn;
+  err_t err = ERR_OK;
+  u8_t written = 0;
+  LWIP_ASSERT("mqtt_output_send: tpcb != NULL", tpcb != NULL);
+
+  for (;;) {
+    u16_t send_len = altcp_sndbuf(tpcb);
+    u16_t ringbuf_len = mqtt_ringbuf_len(rb);
+    u16_t ringbuf_lin_len;
+    u8_t more;
+#if MQTT_PUBLISH_ZEROCOPY
+    struct mqtt_output_ref_t *ref = client->output_refs;
+    if (ref != NULL) {
+      /* Only the ring buffer data up to the header of the next referenced payload */
+      ringbuf_len = (u16_t)((ref->ring_pos + MQTT_OUTPUT_RINGBUF_SIZE - rb->get) % MQTT_OUTPUT_RINGBUF_SIZE);
+      if (ringbuf_len == 0) {
+        err = mqtt_output_write_ref(client, ref, send_len);
+        if (err != ERR_OK) {
+          break;
+        }
+        written = 1;
+        continue;
+      }
+    }
+#endif /* MQTT_PUBLISH_ZEROCOPY */
+    ringbuf_lin_len = LWIP_MIN(ringbuf_len, MQTT_OUTPUT_RINGBUF_SIZE - rb->get);
+
+    if (send_len == 0 || ringbuf_lin_len == 0) {
+      break;
+    }
+
+    LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_output_send: tcp_sndbuf: %d bytes, ringbuf_linear_available: %d, get %d, put %d\n",
+                                   send_len, ringbuf_lin_len, rb->get, rb->put));
+
+    /* Use the lesser one of ring buffer linear length and TCP send buffer size */
+    send_len = LWIP_MIN(send_len, ringbuf_lin_len);
+    /* Wrap around (or a referenced payload) if more data after linear portion */
+    more = (send_len < mqtt_ringbuf_len(rb));
+#if MQTT_PUBLISH_ZEROCOPY
+    more |= (client->output_refs != NULL);
+#endif /* MQTT_PUBLISH_ZEROCOPY */
+    err = altcp_write(tpcb, mqtt_ringbuf_get_ptr(rb), send_len, TCP_WRITE_FLAG_COPY | (more ? TCP_WRITE_FLAG_MORE : 0));
+    if (err != ERR_OK) {
+      break;
+    }
     mqtt_ringbuf_advance_get_idx(rb, send_len);
+    written = 1;
+  }
+
+  if (written) {
     /* Flush */
     altcp_output(tpcb);
-  } else {
+  }
+  if ((err != ERR_OK) && (err != ERR_MEM)) {
     LWIP_DEBUGF(MQTT_DEBUG_WARN, ("mqtt_output_send: Send failed with err %d (\"%s\")\n", err, lwip_strerr(err)));
   }
 }
@@ -278,7 +519,7 @@ mqtt_output_send(struct mqtt_ringbuf_t *rb, struct altcp_pcb *tpcb)
  * Create request item
  * @param r_objs Pointer to request objects
  * @param r_objs_len Number of array entries
- * @param pkt_id Packet identifier of request
+ * @param pkt_id Packet identifier of request, from msg_generate_packet_id(), or 0 for QoS 0 publish
  * @param cb Packet callback to call when requests lifetime ends
  * @param arg Parameter following callback
  * @return Request or NULL if failed to create
@@ -287,49 +528,57 @@ static struct mqtt_request_t *
 mqtt_create_request(struct mqtt_request_t *r_objs, size_t r_objs_len, u16_t pkt_id, mqtt_request_cb_t cb, void *arg)
 {
   struct mqtt_request_t *r = NULL;
-  u8_t n;
+  u16_t n;
   LWIP_ASSERT("mqtt_create_request: r_objs != NULL", r_objs != NULL);
-  for (n = 0; n < r_objs_len; n++) {
-    /* Item point to itself if not in use */
-    if (r_objs[n].next == &r_objs[n]) {
-      r = &r_objs[n];
-      r->next = NULL;
-      r->cb = cb;
-      r->arg = arg;
-      r->pkt_id = pkt_id;
-      break;
+  if (pkt_id != 0) {
+    /* Requests with packet identifier live in the item indexed by it */
+    r = mqtt_request_slot(r_objs, r_objs_len, pkt_id);
+    if (!mqtt_request_is_free(r)) {
+      r = NULL;
+    }
+  } else {
+    for (n = 0; n < r_objs_len; n++) {
+      if (mqtt_request_is_free(&r_objs[n])) {
+        r = &r_objs[n];
+        break;
+      }
     }
   }
+  if (r != NULL) {
+    r->next = NULL;
+    r->prev = NULL;
+    r->cb = cb;
+    r->arg = arg;
+    r->pkt_id = pkt_id;
+    r->publish = 0;
+  }
   return r;
 }
 
 
 /**
  * Append request to pending request queue
- * @param tail Pointer to request queue tail pointer
+ * All requests have the same timeout, so appending keeps the queue ordered by timeout.
+ * @param q Request queue
  * @param r Request to append
+ * @param now Current request tick
  */
 static void
-mqtt_append_request(struct mqtt_request_t **tail, struct mqtt_request_t *r)
+mqtt_append_request(struct mqtt_request_queue_t *q, struct mqtt_request_t *r, u16_t now)
 {
-  struct mqtt_request_t *head = NULL;
-  s16_t time_before = 0;
-  struct mqtt_request_t *iter;
-
-  LWIP_ASSERT("mqtt_append_request: tail != NULL", tail != NULL);
-
-  /* Iterate trough queue to find head, and count total timeout time */
-  for (iter = *tail; iter != NULL; iter = iter->next) {
-    time_before += iter->timeout_diff;
-    head = iter;
-  }
+  LWIP_ASSERT("mqtt_append_request: q != NULL", q != NULL);
 
-  LWIP_ASSERT("mqtt_append_request: time_before <= MQTT_REQ_TIMEOUT", time_before <= MQTT_REQ_TIMEOUT);
-  r->timeout_diff = MQTT_REQ_TIMEOUT - time_before;
-  if (head == NULL) {
-    *tail = r;
+  r->timeout_tick = (u16_t)(now + MQTT_REQ_TIMEOUT_TICKS);
+  r->next = NULL;
+  r->prev = q->tail;
+  if (q->tail == NULL) {
+    q->head = r;
   } else {
-    head->next = r;
+    q->tail->next = r;
+  }
+  q->tail = r;
+  if (r->publish) {
+    q->publish_count++;
   }
 }
 
@@ -346,86 +595,98 @@ mqtt_delete_request(struct mqtt_request_t *r)
   }
 }
 
+/**
+ * Unchain a request item from request queue
+ * @param q Request queue
+ * @param r Request item in queue
+ */
+static void
+mqtt_unlink_request(struct mqtt_request_queue_t *q, struct mqtt_request_t *r)
+{
+  if (r->prev == NULL) {
+    q->head = r->next;
+  } else {
+    r->prev->next = r->next;
+  }
+  if (r->next == NULL) {
+    q->tail = r->prev;
+  } else {
+    r->next->prev = r->prev;
+  }
+  if (r->publish) {
+    LWIP_ASSERT("mqtt_unlink_request: publish_count > 0", q->publish_count > 0);
+    q->publish_count--;
+  }
+  r->next = NULL;
+  r->prev = NULL;
+}
+
 /**
  * Remove a request item with a specific packet identifier from request queue
- * @param tail Pointer to request queue tail pointer
- * @param pkt_id Packet identifier of request to take
+ * @param q Request queue
+ * @param r_objs Pointer to request objects
+ * @param r_objs_len Number of array entries
+ * @param pkt_id Packet identifier of request to take, 0 takes the oldest request of the queue
  * @return Request item if found, NULL if not
  */
 static struct mqtt_request_t *
-mqtt_take_request(struct mqtt_request_t **tail, u16_t pkt_id)
+mqtt_take_request(struct mqtt_request_queue_t *q, struct mqtt_request_t *r_objs, size_t r_objs_len, u16_t pkt_id)
 {
-  struct mqtt_request_t *iter = NULL, *prev = NULL;
-  LWIP_ASSERT("mqtt_take_request: tail != NULL", tail != NULL);
-  /* Search all request for pkt_id */
-  for (iter = *tail; iter != NULL; iter = iter->next) {
-    if (iter->pkt_id == pkt_id) {
-      break;
+  struct mqtt_request_t *r;
+  LWIP_ASSERT("mqtt_take_request: q != NULL", q != NULL);
+  if (pkt_id == 0) {
+    r = q->head;
+  } else {
+    r = mqtt_request_slot(r_objs, r_objs_len, pkt_id);
+    if (mqtt_request_is_free(r) || (r->pkt_id != pkt_id)) {
+      r = NULL;
     }
-    prev = iter;
   }
-
-  /* If request was found */
-  if (iter != NULL) {
-    /* unchain */
-    if (prev == NULL) {
-      *tail = iter->next;
-    } else {
-      prev->next = iter->next;
-    }
-    /* If exists, add remaining timeout time for the request to next */
-    if (iter->next != NULL) {
-      iter->next->timeout_diff += iter->timeout_diff;
-    }
-    iter->next = NULL;
+  if (r != NULL) {
+    mqtt_unlink_request(q, r);
   }
-  return iter;
+  return r;
 }
 
 /**
  * Handle requests timeout
- * @param tail Pointer to request queue tail pointer
- * @param t Time since last call in seconds
+ * @param q Request queue
+ * @param now Current request tick
  */
 static void
-mqtt_request_time_elapsed(struct mqtt_request_t **tail, u8_t t)
+mqtt_request_time_elapsed(struct mqtt_request_queue_t *q, u16_t now)
 {
   struct mqtt_request_t *r;
-  LWIP_ASSERT("mqtt_request_time_elapsed: tail != NULL", tail != NULL);
-  r = *tail;
-  while (t > 0 && r != NULL) {
-    if (t >= r->timeout_diff) {
-      t -= (u8_t)r->timeout_diff;
-      /* Unchain */
-      *tail = r->next;
-      /* Notify upper layer about timeout */
-      if (r->cb != NULL) {
-        r->cb(r->arg, ERR_TIMEOUT);
-      }
-      mqtt_delete_request(r);
-      /* Tail might be be modified in callback, so re-read it in every iteration */
-      r = *(struct mqtt_request_t *const volatile *)tail;
-    } else {
-      r->timeout_diff -= t;
-      t = 0;
+  LWIP_ASSERT("mqtt_request_time_elapsed: q != NULL", q != NULL);
+  /* Queue is ordered by timeout, so only the oldest requests need to be checked.
+     Queue might be be modified in callback, so re-read head in every iteration */
+  while (((r = *(struct mqtt_request_t *const volatile *)&q->head) != NULL) &&
+         ((s16_t)(now - r->timeout_tick) >= 0)) {
+    mqtt_unlink_request(q, r);
+    /* Notify upper layer about timeout */
+    if (r->cb != NULL) {
+      r->cb(r->arg, ERR_TIMEOUT);
     }
+    mqtt_delete_request(r);
   }
 }
 
 /**
  * Free all request items
- * @param tail Pointer to request queue tail pointer
+ * @param q Request queue
  */
 static void
-mqtt_clear_requests(struct mqtt_request_t **tail)
+mqtt_clear_requests(struct mqtt_request_queue_t *q)
 {
   struct mqtt_request_t *iter, *next;
-  LWIP_ASSERT("mqtt_clear_requests: tail != NULL", tail != NULL);
-  for (iter = *tail; iter != NULL; iter = next) {
+  LWIP_ASSERT("mqtt_clear_requests: q != NULL", q != NULL);
+  for (iter = q->head; iter != NULL; iter = next) {
     next = iter->next;
     mqtt_delete_request(iter);
   }
-  *tail = NULL;
+  q->head = NULL;
+  q->tail = NULL;
+  q->publish_count = 0;
 }
 /**
  * Initialize all request items
@@ -435,7 +696,7 @@ mqtt_clear_requests(struct mqtt_request_t **tail)
 static void
 mqtt_init_requests(struct mqtt_request_t *r_objs, size_t r_objs_len)
 {
-  u8_t n;
+  u16_t n;
   LWIP_ASSERT("mqtt_init_requests: r_objs != NULL", r_objs != NULL);
   for (n = 0; n < r_objs_len; n++) {
     /* Item pointing to itself indicates unused */
@@ -508,15 +769,17 @@ mqtt_output_append_fixed_header(struct mqtt_ringbuf_t *rb, u8_t msg_type, u8_t f
  * Check output buffer space
  * @param rb Output ring buffer
  * @param r_length Remaining length after fixed header
+ * @param unbuffered Bytes at the end of the message that are not put into the ring buffer
  * @return 1 if message will fit, 0 if not enough buffer space
  */
 static u8_t
-mqtt_output_check_space(struct mqtt_ringbuf_t *rb, u16_t r_length)
+mqtt_output_check_space_unbuffered(struct mqtt_ringbuf_t *rb, u16_t r_length, u16_t unbuffered)
 {
   /* Start with length of type byte + remaining length */
-  u16_t total_len = 1 + r_length;
+  u16_t total_len = 1 + r_length - unbuffered;
 
   LWIP_ASSERT("mqtt_output_check_space: rb != NULL", rb != NULL);
+  LWIP_ASSERT("mqtt_output_check_space: unbuffered <= r_length", unbuffered <= r_length);
 
   /* Calculate number of required bytes to contain the remaining bytes field and add to total*/
   do {
@@ -527,6 +790,14 @@ mqtt_output_check_space(struct mqtt_ringbuf_t *rb, u16_t r_length)
   return (total_len <= mqtt_ringbuf_free(rb));
 }
 
+/**
+ * Check output buffer space
+ * @param rb Output ring buffer
+ * @param r_length Remaining length after fixed header
+ * @return 1 if message will fit, 0 if not enough buffer space
+ */
+#define mqtt_output_check_space(rb, r_length) mqtt_output_check_space_unbuffered(rb, r_length, 0)
+
 
 /**
  * Close connection to server
@@ -544,7 +815,15 @@ mqtt_close(mqtt_client_t *client, mqtt_connection_status_t reason)
     altcp_recv(client->conn, NULL);
     altcp_err(client->conn,  NULL);
     altcp_sent(client->conn, NULL);
-    res = altcp_close(client->conn);
+#if MQTT_PUBLISH_ZEROCOPY
+    if (mqtt_output_ref_pending(client)) {
+      /* Let the stack release referenced payloads as soon as possible, so don't linger */
+      res = ERR_ABRT;
+    } else
+#endif /* MQTT_PUBLISH_ZEROCOPY */
+    {
+      res = altcp_close(client->conn);
+    }
     if (res != ERR_OK) {
       altcp_abort(client->conn);
       LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_close: Close err=%s\n", lwip_strerr(res)));
@@ -554,6 +833,11 @@ mqtt_close(mqtt_client_t *client, mqtt_connection_status_t reason)
 
   /* Remove all pending requests */
   mqtt_clear_requests(&client->pend_req_queue);
+  mqtt_clear_requests(&client->pend_qos0_queue);
+#if MQTT_PUBLISH_ZEROCOPY
+  /* Give referenced payloads back to the upper layer */
+  mqtt_output_ref_clear(client);
+#endif /* MQTT_PUBLISH_ZEROCOPY */
   /* Stop cyclic timer */
   sys_untimeout(mqtt_cyclic_timer, client);
 
@@ -589,7 +873,9 @@ mqtt_cyclic_timer(void *arg)
     }
   } else if (client->conn_state == MQTT_CONNECTED) {
     /* Handle timeout for pending requests */
-    mqtt_request_time_elapsed(&client->pend_req_queue, MQTT_CYCLIC_TIMER_INTERVAL);
+    client->req_tick++;
+    mqtt_request_time_elapsed(&client->pend_req_queue, client->req_tick);
+    mqtt_request_time_elapsed(&client->pend_qos0_queue, client->req_tick);
 
     /* keep_alive > 0 means keep alive functionality shall be used */
     if (client->keep_alive > 0) {
@@ -638,7 +924,7 @@ pub_ack_rec_rel_response(mqtt_client_t *client, u8_t msg, u16_t pkt_id, u8_t qos
   if (mqtt_output_check_space(&client->output, 2)) {
     mqtt_output_append_fixed_header(&client->output, msg, 0, qos, 0, 2);
     mqtt_output_append_u16(&client->output, pkt_id);
-    mqtt_output_send(&client->output, client->conn);
+    mqtt_output_send(client);
   } else {
     LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("pub_ack_rec_rel_response: OOM creating response: %s with pkt_id: %d\n",
                                    mqtt_msg_type_to_str(msg), pkt_id));
@@ -801,7 +1087,7 @@ mqtt_message_received(mqtt_client_t *client, u8_t fixed_hdr_idx, u16_t length, u
 
     } else if (pkt_type == MQTT_MSG_TYPE_SUBACK || pkt_type == MQTT_MSG_TYPE_UNSUBACK ||
                pkt_type == MQTT_MSG_TYPE_PUBCOMP || pkt_type == MQTT_MSG_TYPE_PUBACK) {
-      struct mqtt_request_t *r = mqtt_take_request(&client->pend_req_queue, pkt_id);
+      struct mqtt_request_t *r = mqtt_take_request(&client->pend_req_queue, client->req_list, LWIP_ARRAYSIZE(client->req_list), pkt_id);
       if (r != NULL) {
         LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_message_received: %s response with id %d\n", mqtt_msg_type_to_str(pkt_type), pkt_id));
         if (pkt_type == MQTT_MSG_TYPE_SUBACK) {
@@ -987,15 +1273,19 @@ mqtt_tcp_sent_cb(void *arg, struct altcp_pcb *tpcb, u16_t len)
     client->cyclic_tick = 0;
     client->server_watchdog = 0;
     /* QoS 0 publish has no response from server, so call its callbacks here */
-    while ((r = mqtt_take_request(&client->pend_req_queue, 0)) != NULL) {
+    while ((r = mqtt_take_request(&client->pend_qos0_queue, client->req_list, LWIP_ARRAYSIZE(client->req_list), 0)) != NULL) {
       LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_tcp_sent_cb: Calling QoS 0 publish complete callback\n"));
       if (r->cb != NULL) {
         r->cb(r->arg, ERR_OK);
       }
       mqtt_delete_request(r);
     }
+#if MQTT_PUBLISH_ZEROCOPY
+    /* Referenced payloads might have been released */
+    mqtt_output_ref_poll(client);
+#endif /* MQTT_PUBLISH_ZEROCOPY */
     /* Try send any remaining buffers from output queue */
-    mqtt_output_send(&client->output, client->conn);
+    mqtt_output_send(client);
   }
   return ERR_OK;
 }
@@ -1027,9 +1317,14 @@ static err_t
 mqtt_tcp_poll_cb(void *arg, struct altcp_pcb *tpcb)
 {
   mqtt_client_t *client = (mqtt_client_t *)arg;
+  LWIP_UNUSED_ARG(tpcb);
   if (client->conn_state == MQTT_CONNECTED) {
+#if MQTT_PUBLISH_ZEROCOPY
+    /* Referenced payloads might have been released by the netif driver */
+    mqtt_output_ref_poll(client);
+#endif /* MQTT_PUBLISH_ZEROCOPY */
     /* Try send any remaining buffers from output queue */
-    mqtt_output_send(&client->output, tpcb);
+    mqtt_output_send(client);
   }
   return ERR_OK;
 }
@@ -1067,7 +1362,7 @@ mqtt_tcp_connect_cb(void *arg, struct altcp_pcb *tpcb, err_t err)
   client->cyclic_tick = 0;
 
   /* Start transmission from output queue, connect message is the first one out*/
-  mqtt_output_send(&client->output, client->conn);
+  mqtt_output_send(client);
 
   return ERR_OK;
 }
@@ -1079,8 +1374,7 @@ mqtt_tcp_connect_cb(void *arg, struct altcp_pcb *tpcb, err_t err)
 
 
 /**
- * @ingroup mqtt
- * MQTT publish function.
+ * Append a publish message to the output ring buffer (without sending it)
  * @param client MQTT client
  * @param topic Publish topic string
  * @param payload Data to publish (NULL is allowed)
@@ -1089,13 +1383,13 @@ mqtt_tcp_connect_cb(void *arg, struct altcp_pcb *tpcb, err_t err)
  * @param retain MQTT retain flag
  * @param cb Callback to call when publish is complete or has timed out
  * @param arg User supplied argument to publish callback
+ * @param copy_payload 1 to append the payload, 0 if it is referenced
  * @return ERR_OK if successful
- *         ERR_CONN if client is disconnected
  *         ERR_MEM if short on memory
  */
-err_t
-mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length, u8_t qos, u8_t retain,
-             mqtt_request_cb_t cb, void *arg)
+static err_t
+mqtt_publish_append(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length, u8_t qos, u8_t retain,
+                    mqtt_request_cb_t cb, void *arg, u8_t copy_payload)
 {
   struct mqtt_request_t *r;
   u16_t pkt_id;
@@ -1104,10 +1398,7 @@ mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_
   u16_t topic_len;
   u16_t remaining_length;
 
-  LWIP_ASSERT_CORE_LOCKED();
-  LWIP_ASSERT("mqtt_publish: client != NULL", client);
   LWIP_ASSERT("mqtt_publish: topic != NULL", topic);
-  LWIP_ERROR("mqtt_publish: TCP disconnected", (client->conn_state != TCP_DISCONNECTED), return ERR_CONN);
 
   topic_strlen = strlen(topic);
   LWIP_ERROR("mqtt_publish: topic length overflow", (topic_strlen <= (0xFFFF - 2)), return ERR_ARG);
@@ -1116,14 +1407,24 @@ mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_
 
   if (qos > 0) {
     total_len += 2;
+  }
+  LWIP_ERROR("mqtt_publish: total length overflow", (total_len <= 0xFFFF), return ERR_ARG);
+  remaining_length = (u16_t)total_len;
+
+  if (qos > 0) {
+    if ((client->receive_max != 0) && (client->pend_req_queue.publish_count >= client->receive_max)) {
+      LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_publish: Receive maximum of server reached\n"));
+      return ERR_MEM;
+    }
     /* Generate pkt_id id for QoS1 and 2 */
     pkt_id = msg_generate_packet_id(client);
+    if (pkt_id == 0) {
+      return ERR_MEM;
+    }
   } else {
     /* Use reserved value pkt_id 0 for QoS 0 in request handle */
     pkt_id = 0;
   }
-  LWIP_ERROR("mqtt_publish: total length overflow", (total_len <= 0xFFFF), return ERR_ARG);
-  remaining_length = (u16_t)total_len;
 
   LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_publish: Publish with payload length %d to topic \"%s\"\n", payload_length, topic));
 
@@ -1131,8 +1432,9 @@ mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_
   if (r == NULL) {
     return ERR_MEM;
   }
+  r->publish = (qos > 0);
 
-  if (mqtt_output_check_space(&client->output, remaining_length) == 0) {
+  if (mqtt_output_check_space_unbuffered(&client->output, remaining_length, copy_payload ? 0 : payload_length) == 0) {
     mqtt_delete_request(r);
     return ERR_MEM;
   }
@@ -1148,15 +1450,163 @@ mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_
   }
 
   /* Append optional publish payload */
-  if ((payload != NULL) && (payload_length > 0)) {
+  if (copy_payload && (payload != NULL) && (payload_length > 0)) {
     mqtt_output_append_buf(&client->output, payload, payload_length);
   }
 
-  mqtt_append_request(&client->pend_req_queue, r);
-  mqtt_output_send(&client->output, client->conn);
+  mqtt_append_request((qos > 0) ? &client->pend_req_queue : &client->pend_qos0_queue, r, client->req_tick);
   return ERR_OK;
 }
 
+/**
+ * @ingroup mqtt
+ * MQTT publish function.
+ * @param client MQTT client
+ * @param topic Publish topic string
+ * @param payload Data to publish (NULL is allowed)
+ * @param payload_length Length of payload (0 is allowed)
+ * @param qos Quality of service, 0 1 or 2
+ * @param retain MQTT retain flag
+ * @param cb Callback to call when publish is complete or has timed out
+ * @param arg User supplied argument to publish callback
+ * @return ERR_OK if successful
+ *         ERR_CONN if client is disconnected
+ *         ERR_MEM if short on memory
+ */
+err_t
+mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length, u8_t qos, u8_t retain,
+             mqtt_request_cb_t cb, void *arg)
+{
+  err_t err;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ASSERT("mqtt_publish: client != NULL", client);
+  LWIP_ERROR("mqtt_publish: TCP disconnected", (client->conn_state != TCP_DISCONNECTED), return ERR_CONN);
+
+  err = mqtt_publish_append(client, topic, payload, payload_length, qos, retain, cb, arg, 1);
+  if (err == ERR_OK) {
+    mqtt_output_send(client);
+  }
+  return err;
+}
+
+/**
+ * @ingroup mqtt
+ * Publish several messages at once: all messages are put into the output
+ * ring buffer before it is written to the connection, so many small messages
+ * are sent in as few segments as possible.
+ * Messages are queued in order until one fails.
+ * @param client MQTT client
+ * @param msgs Messages to publish
+ * @param num_msgs Number of messages
+ * @param num_queued Returns the number of messages queued (may be NULL)
+ * @return ERR_OK if all messages have been queued, else the error of the
+ *         first message not queued (see mqtt_publish())
+ */
+err_t
+mqtt_publish_batch(mqtt_client_t *client, const struct mqtt_publish_msg_t *msgs, u16_t num_msgs, u16_t *num_queued)
+{
+  err_t err = ERR_OK;
+  u16_t n;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ASSERT("mqtt_publish_batch: client != NULL", client);
+  LWIP_ASSERT("mqtt_publish_batch: msgs != NULL", msgs != NULL || num_msgs == 0);
+  if (num_queued != NULL) {
+    *num_queued = 0;
+  }
+  LWIP_ERROR("mqtt_publish_batch: TCP disconnected", (client->conn_state != TCP_DISCONNECTED), return ERR_CONN);
+
+  for (n = 0; n < num_msgs; n++) {
+    err = mqtt_publish_append(client, msgs[n].topic, msgs[n].payload, msgs[n].payload_length,
+                              msgs[n].qos, msgs[n].retain, msgs[n].cb, msgs[n].arg, 1);
+    if (err != ERR_OK) {
+      break;
+    }
+  }
+  if (num_queued != NULL) {
+    *num_queued = n;
+  }
+  if (n > 0) {
+    mqtt_output_send(client);
+  }
+  return err;
+}
+
+#if MQTT_PUBLISH_ZEROCOPY
+/**
+ * @ingroup mqtt
+ * MQTT publish function referencing the payload instead of copying it.
+ * The payload is written to the connection directly (not through the output
+ * ring buffer, so it may be larger than MQTT_OUTPUT_RINGBUF_SIZE) and must
+ * not be changed until the callback has been called.
+ * @param client MQTT client
+ * @param topic Publish topic string (copied)
+ * @param payload Data to publish
+ * @param payload_length Length of payload
+ * @param qos Quality of service, 0 1 or 2
+ * @param retain MQTT retain flag
+ * @param cb Callback to call when publish is complete or has timed out and
+ *           the payload is not referenced any more. It is also called with
+ *           ERR_CONN if the connection is closed before, later than the
+ *           connection callback if the stack still holds the payload then.
+ *           The client must not be freed before this callback.
+ * @param arg User supplied argument to publish callback
+ * @return ERR_OK if successful
+ *         ERR_CONN if client is disconnected
+ *         ERR_MEM if short on memory
+ */
+err_t
+mqtt_publish_ref(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length, u8_t qos, u8_t retain,
+                 mqtt_request_cb_t cb, void *arg)
+{
+  struct mqtt_output_ref_t *ref = NULL;
+  struct mqtt_output_ref_t **tail;
+  err_t err;
+  u8_t n;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ASSERT("mqtt_publish_ref: client != NULL", client);
+  LWIP_ERROR("mqtt_publish_ref: TCP disconnected", (client->conn_state != TCP_DISCONNECTED), return ERR_CONN);
+  if ((payload == NULL) || (payload_length == 0)) {
+    return mqtt_publish(client, topic, payload, payload_length, qos, retain, cb, arg);
+  }
+#if !LWIP_ALTCP
+  LWIP_ERROR("mqtt_publish_ref: payload does not fit into TCP_SND_BUF", (payload_length <= TCP_SND_BUF), return ERR_ARG);
+#endif /* !LWIP_ALTCP */
+
+  for (n = 0; n < LWIP_ARRAYSIZE(client->output_ref_list); n++) {
+    if (client->output_ref_list[n].state == 0) {
+      ref = &client->output_ref_list[n];
+      break;
+    }
+  }
+  if (ref == NULL) {
+    return ERR_MEM;
+  }
+
+  err = mqtt_publish_append(client, topic, payload, payload_length, qos, retain, mqtt_output_ref_request_cb, ref, 0);
+  if (err != ERR_OK) {
+    return err;
+  }
+  ref->next = NULL;
+  ref->data = (const u8_t *)payload;
+  ref->len = payload_length;
+  ref->written = 0;
+  /* The payload is sent after the header just appended */
+  ref->ring_pos = client->output.put;
+  ref->state = MQTT_REF_ALLOCATED;
+  ref->err = ERR_OK;
+  ref->cb = cb;
+  ref->arg = arg;
+  for (tail = &client->output_refs; *tail != NULL; tail = &(*tail)->next);
+  *tail = ref;
+
+  mqtt_output_send(client);
+  return ERR_OK;
+}
+#endif /* MQTT_PUBLISH_ZEROCOPY */
+
 
 /**
  * @ingroup mqtt
@@ -1198,6 +1648,9 @@ mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_request_
   }
 
   pkt_id = msg_generate_packet_id(client);
+  if (pkt_id == 0) {
+    return ERR_MEM;
+  }
   r = mqtt_create_request(client->req_list, LWIP_ARRAYSIZE(client->req_list), pkt_id, cb, arg);
   if (r == NULL) {
     return ERR_MEM;
@@ -1220,8 +1673,8 @@ mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_request_
     mqtt_output_append_u8(&client->output, LWIP_MIN(qos, 2));
   }
 
-  mqtt_append_request(&client->pend_req_queue, r);
-  mqtt_output_send(&client->output, client->conn);
+  mqtt_append_request(&client->pend_req_queue, r, client->req_tick);
+  mqtt_output_send(client);
   return ERR_OK;
 }
 
@@ -1265,6 +1718,10 @@ mqtt_client_new(void)
 void
 mqtt_client_free(mqtt_client_t *client)
 {
+#if MQTT_PUBLISH_ZEROCOPY
+  LWIP_ASSERT("mqtt_client_free: referenced payload not released", !mqtt_output_ref_pending(client));
+  sys_untimeout(mqtt_output_ref_timer, client);
+#endif /* MQTT_PUBLISH_ZEROCOPY */
   mem_free(client);
 }
 
@@ -1303,10 +1760,18 @@ mqtt_client_connect(mqtt_client_t *client, const ip_addr_t *ip_addr, u16_t port,
   }
 
   /* Wipe clean */
+#if MQTT_PUBLISH_ZEROCOPY
+  /* but keep the payloads the stack may still reference from the last connection */
+  LWIP_ASSERT("mqtt_client_connect: output_ref_list must be the last member",
+              offsetof(mqtt_client_t, output_ref_list) + sizeof(client->output_ref_list) == sizeof(mqtt_client_t));
+  memset(client, 0, offsetof(mqtt_client_t, output_ref_list));
+#else /* MQTT_PUBLISH_ZEROCOPY */
   memset(client, 0, sizeof(mqtt_client_t));
+#endif /* MQTT_PUBLISH_ZEROCOPY */
   client->connect_arg = arg;
   client->connect_cb = cb;
   client->keep_alive = client_info->keep_alive;
+  client->receive_max = client_info->receive_maximum;
   mqtt_init_requests(client->req_list, LWIP_ARRAYSIZE(client->req_list));
 
   /* Build connect message */
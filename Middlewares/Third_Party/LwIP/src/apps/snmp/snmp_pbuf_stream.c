@@ -49,6 +49,7 @@ snmp_pbuf_stream_init(struct snmp_pbuf_stream *pbuf_stream, struct pbuf *p, u16_
   pbuf_stream->offset = offset;
   pbuf_stream->length = length;
   pbuf_stream->pbuf   = p;
+  pbuf_cursor_init(&pbuf_stream->cursor, p, offset);
 
   return ERR_OK;
 }
@@ -60,7 +61,8 @@ snmp_pbuf_stream_read(struct snmp_pbuf_stream *pbuf_stream, u8_t *data)
     return ERR_BUF;
   }
 
-  if (pbuf_copy_partial(pbuf_stream->pbuf, data, 1, pbuf_stream->offset) == 0) {
+  pbuf_cursor_seek(&pbuf_stream->cursor, pbuf_stream->offset);
+  if (pbuf_cursor_read(&pbuf_stream->cursor, data, 1) == 0) {
     return ERR_BUF;
   }
 
@@ -111,15 +113,15 @@ snmp_pbuf_stream_writeto(struct snmp_pbuf_stream *pbuf_stream, struct snmp_pbuf_
   while (len > 0) {
     u16_t chunk_len;
     err_t err;
-    u16_t target_offset;
-    struct pbuf *pbuf = pbuf_skip(pbuf_stream->pbuf, pbuf_stream->offset, &target_offset);
+    struct pbuf_cursor *cur = &pbuf_stream->cursor;
 
-    if ((pbuf == NULL) || (pbuf->len == 0)) {
+    pbuf_cursor_seek(cur, pbuf_stream->offset);
+    if (cur->p == NULL) {
       return ERR_BUF;
     }
 
-    chunk_len = LWIP_MIN(len, pbuf->len);
-    err = snmp_pbuf_stream_writebuf(target_pbuf_stream, &((u8_t *)pbuf->payload)[target_offset], chunk_len);
+    chunk_len = (u16_t)LWIP_MIN(len, cur->p->len - cur->off);
+    err = snmp_pbuf_stream_writebuf(target_pbuf_stream, &((const u8_t *)cur->p->payload)[cur->off], chunk_len);
     if (err != ERR_OK) {
       return err;
     }
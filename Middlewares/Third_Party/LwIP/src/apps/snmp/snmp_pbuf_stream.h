@@ -53,6 +53,8 @@ struct snmp_pbuf_stream {
   struct pbuf *pbuf;
   u16_t offset;
   u16_t length;
+  /** read position, follows 'offset' without walking the chain from its head */
+  struct pbuf_cursor cursor;
 };
 
 err_t snmp_pbuf_stream_init(struct snmp_pbuf_stream *pbuf_stream, struct pbuf *p, u16_t offset, u16_t length);
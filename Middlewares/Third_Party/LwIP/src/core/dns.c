@@ -125,6 +125,9 @@ static u16_t dns_txid;
 #if DNS_MAX_SERVERS > 255
 #error DNS_MAX_SERVERS must fit into an u8_t
 #endif
+#if LWIP_DNS_CACHE && (DNS_CACHE_SIZE > 255)
+#error DNS_CACHE_SIZE must fit into an u8_t
+#endif
 
 /* The number of parallel requests (i.e. calls to dns_gethostbyname
  * that cannot be answered from the DNS table.
@@ -253,6 +256,45 @@ struct dns_req_entry {
 #endif /* LWIP_IPV4 && LWIP_IPV6 */
 };
 
+#if LWIP_DNS_CACHE
+/* DNS cache entry states */
+typedef enum {
+  DNS_CACHE_UNUSED           = 0,
+  DNS_CACHE_POSITIVE         = 1,
+  DNS_CACHE_NEGATIVE         = 2
+} dns_cache_state_enum_t;
+
+/** DNS cache entry: one per name and address family */
+struct dns_cache_entry {
+  /* next entry in the same hash bucket */
+  struct dns_cache_entry *next;
+  /* remaining time to live in seconds */
+  u32_t ttl;
+  ip_addr_t ipaddr;
+  u16_t name_hash;
+  u8_t  state;
+  u8_t  seqno;
+  /* lookups served since the entry was (re)filled */
+  u8_t  hits;
+  u8_t  prefetched;
+#if LWIP_IPV4 && LWIP_IPV6
+  /* LWIP_DNS_ADDRTYPE_IPV4 or LWIP_DNS_ADDRTYPE_IPV6 */
+  u8_t  family;
+#endif /* LWIP_IPV4 && LWIP_IPV6 */
+#if LWIP_DNS_SUPPORT_MDNS_QUERIES
+  u8_t  is_mdns;
+#endif
+  char name[DNS_MAX_NAME_LENGTH];
+};
+
+#if LWIP_IPV4 && LWIP_IPV6
+#define DNS_CACHE_FAMILY(t)           (LWIP_DNS_ADDRTYPE_IS_IPV6(t) ? LWIP_DNS_ADDRTYPE_IPV6 : LWIP_DNS_ADDRTYPE_IPV4)
+#define DNS_CACHE_FAMILY_MATCH(e, f)  ((e)->family == (f))
+#else /* LWIP_IPV4 && LWIP_IPV6 */
+#define DNS_CACHE_FAMILY_MATCH(e, f)  1
+#endif /* LWIP_IPV4 && LWIP_IPV6 */
+#endif /* LWIP_DNS_CACHE */
+
 #if DNS_LOCAL_HOSTLIST
 
 #if DNS_LOCAL_HOSTLIST_IS_DYNAMIC
@@ -285,6 +327,10 @@ static err_t dns_lookup_local(const char *hostname, ip_addr_t *addr LWIP_DNS_ADD
 static void dns_recv(void *s, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port);
 static void dns_check_entries(void);
 static void dns_call_found(u8_t idx, ip_addr_t *addr);
+#if LWIP_DNS_CACHE && DNS_CACHE_PREFETCH_TTL
+static err_t dns_enqueue(const char *name, size_t hostnamelen, dns_found_callback found,
+                         void *callback_arg LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addrtype) LWIP_DNS_ISMDNS_ARG(u8_t is_mdns));
+#endif /* LWIP_DNS_CACHE && DNS_CACHE_PREFETCH_TTL */
 
 /*-----------------------------------------------------------------------------
  * Globals
@@ -299,6 +345,11 @@ static u8_t                   dns_seqno;
 static struct dns_table_entry dns_table[DNS_TABLE_SIZE];
 static struct dns_req_entry   dns_requests[DNS_MAX_REQUESTS];
 static ip_addr_t              dns_servers[DNS_MAX_SERVERS];
+#if LWIP_DNS_CACHE
+static struct dns_cache_entry dns_cache[DNS_CACHE_SIZE];
+static struct dns_cache_entry *dns_cache_hash[DNS_CACHE_HASH_SIZE];
+static u8_t                   dns_cache_seqno;
+#endif /* LWIP_DNS_CACHE */
 
 #if LWIP_IPV4
 const ip_addr_t dns_mquery_v4group = DNS_MQUERY_IPV4_GROUP_INIT;
@@ -387,6 +438,231 @@ dns_getserver(u8_t numdns)
   }
 }
 
+#if LWIP_DNS_CACHE
+/** Case-insensitive hash of a host name */
+static u16_t
+dns_cache_hash_name(const char *name)
+{
+  u32_t h = 2166136261UL;
+  for (; *name != 0; name++) {
+    char c = *name;
+    if ((c >= 'A') && (c <= 'Z')) {
+      c = (char)(c + ('a' - 'A'));
+    }
+    h = (h ^ (u8_t)c) * 16777619UL;
+  }
+  return (u16_t)(h ^ (h >> 16));
+}
+
+#define DNS_CACHE_BUCKET(hash) (&dns_cache_hash[(hash) % DNS_CACHE_HASH_SIZE])
+
+/** Find the cache entry of a name and address family */
+static struct dns_cache_entry *
+dns_cache_find(const char *name, u16_t hash LWIP_DNS_ADDRTYPE_ARG(u8_t family))
+{
+  struct dns_cache_entry *entry;
+
+  for (entry = *DNS_CACHE_BUCKET(hash); entry != NULL; entry = entry->next) {
+    if ((entry->name_hash == hash) && DNS_CACHE_FAMILY_MATCH(entry, family) &&
+        (lwip_strnicmp(name, entry->name, sizeof(entry->name)) == 0)) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+/** Unlink an entry from its hash bucket and mark it unused */
+static void
+dns_cache_remove(struct dns_cache_entry *entry)
+{
+  struct dns_cache_entry **pentry;
+
+  for (pentry = DNS_CACHE_BUCKET(entry->name_hash); *pentry != NULL; pentry = &(*pentry)->next) {
+    if (*pentry == entry) {
+      *pentry = entry->next;
+      break;
+    }
+  }
+  entry->next = NULL;
+  entry->state = DNS_CACHE_UNUSED;
+}
+
+/**
+ * Get the cache entry to store a name in: the existing entry for that name
+ * and address family, an unused one or the least recently used one.
+ */
+static struct dns_cache_entry *
+dns_cache_get(const char *name LWIP_DNS_ADDRTYPE_ARG(u8_t family))
+{
+  struct dns_cache_entry *entry;
+  u16_t hash = dns_cache_hash_name(name);
+  size_t namelen;
+  u8_t i, age, lage;
+
+  entry = dns_cache_find(name, hash LWIP_DNS_ADDRTYPE_ARG(family));
+  if (entry == NULL) {
+    lage = 0;
+    entry = &dns_cache[0];
+    for (i = 0; i < DNS_CACHE_SIZE; i++) {
+      if (dns_cache[i].state == DNS_CACHE_UNUSED) {
+        entry = &dns_cache[i];
+        break;
+      }
+      age = (u8_t)(dns_cache_seqno - dns_cache[i].seqno);
+      if (age > lage) {
+        lage = age;
+        entry = &dns_cache[i];
+      }
+    }
+    if (entry->state != DNS_CACHE_UNUSED) {
+      LWIP_DEBUGF(DNS_DEBUG, ("dns_cache_get: \"%s\": evicted for \"%s\"\n", entry->name, name));
+      dns_cache_remove(entry);
+    }
+    entry->name_hash = hash;
+    namelen = LWIP_MIN(strlen(name), DNS_MAX_NAME_LENGTH - 1);
+    MEMCPY(entry->name, name, namelen);
+    entry->name[namelen] = 0;
+    LWIP_DNS_SET_ADDRTYPE(entry->family, family);
+    entry->next = *DNS_CACHE_BUCKET(hash);
+    *DNS_CACHE_BUCKET(hash) = entry;
+  }
+  entry->seqno = dns_cache_seqno++;
+  entry->hits = 0;
+  entry->prefetched = 0;
+  return entry;
+}
+
+/** Store a resolved address for its TTL */
+static void
+dns_cache_add(const char *name, const ip_addr_t *addr, u32_t ttl LWIP_DNS_ISMDNS_ARG(u8_t is_mdns))
+{
+  struct dns_cache_entry *entry;
+
+  entry = dns_cache_get(name LWIP_DNS_ADDRTYPE_ARG(IP_IS_V6(addr) ? LWIP_DNS_ADDRTYPE_IPV6 : LWIP_DNS_ADDRTYPE_IPV4));
+  entry->state = DNS_CACHE_POSITIVE;
+  entry->ttl = ttl;
+  ip_addr_copy(entry->ipaddr, *addr);
+#if LWIP_DNS_SUPPORT_MDNS_QUERIES
+  entry->is_mdns = is_mdns;
+#endif
+}
+
+/** Remember that a name has no address of the given family */
+static void
+dns_cache_add_negative(const char *name, u32_t ttl LWIP_DNS_ADDRTYPE_ARG(u8_t family))
+{
+  struct dns_cache_entry *entry;
+
+  entry = dns_cache_get(name LWIP_DNS_ADDRTYPE_ARG(family));
+  entry->state = DNS_CACHE_NEGATIVE;
+  entry->ttl = ttl;
+#if LWIP_DNS_SUPPORT_MDNS_QUERIES
+  entry->is_mdns = 0;
+#endif
+}
+
+/**
+ * Look up a cached address.
+ *
+ * @return ERR_OK if found (addr is set), ERR_VAL if the name is cached as
+ *         having no address of that type, ERR_ARG if the name is not cached
+ */
+static err_t
+dns_cache_lookup(const char *name, ip_addr_t *addr LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addrtype))
+{
+  struct dns_cache_entry *entry;
+
+  entry = dns_cache_find(name, dns_cache_hash_name(name) LWIP_DNS_ADDRTYPE_ARG(DNS_CACHE_FAMILY(dns_addrtype)));
+  if (entry == NULL) {
+    return ERR_ARG;
+  }
+  if (entry->state == DNS_CACHE_NEGATIVE) {
+    return ERR_VAL;
+  }
+  entry->seqno = dns_cache_seqno++;
+  if (entry->hits < 0xFF) {
+    entry->hits++;
+  }
+  if (addr) {
+    ip_addr_copy(*addr, entry->ipaddr);
+  }
+  return ERR_OK;
+}
+
+/** Is the name known to have no address of the requested type(s)? */
+static u8_t
+dns_cache_is_negative(const char *name LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addrtype))
+{
+#if LWIP_IPV4 && LWIP_IPV6
+  if ((dns_addrtype == LWIP_DNS_ADDRTYPE_IPV4_IPV6) || (dns_addrtype == LWIP_DNS_ADDRTYPE_IPV6_IPV4)) {
+    return (dns_cache_lookup(name, NULL, LWIP_DNS_ADDRTYPE_IPV4) == ERR_VAL) &&
+           (dns_cache_lookup(name, NULL, LWIP_DNS_ADDRTYPE_IPV6) == ERR_VAL);
+  }
+#endif /* LWIP_IPV4 && LWIP_IPV6 */
+  return dns_cache_lookup(name, NULL LWIP_DNS_ADDRTYPE_ARG(dns_addrtype)) == ERR_VAL;
+}
+
+#if DNS_CACHE_PREFETCH_TTL
+/** Query a cached name again before it expires */
+static void
+dns_cache_prefetch(struct dns_cache_entry *entry)
+{
+#if LWIP_DNS_SUPPORT_MDNS_QUERIES
+  if (!entry->is_mdns)
+#endif /* LWIP_DNS_SUPPORT_MDNS_QUERIES */
+  {
+    if (ip_addr_isany_val(dns_servers[0])) {
+      return;
+    }
+  }
+  LWIP_DEBUGF(DNS_DEBUG, ("dns_cache_prefetch: \"%s\"\n", entry->name));
+  if (dns_enqueue(entry->name, strlen(entry->name), NULL, NULL LWIP_DNS_ADDRTYPE_ARG(entry->family)
+                  LWIP_DNS_ISMDNS_ARG(entry->is_mdns)) == ERR_INPROGRESS) {
+    entry->prefetched = 1;
+  }
+}
+#endif /* DNS_CACHE_PREFETCH_TTL */
+
+/**
+ * Age the cache by one second: drop expired entries and refresh the ones
+ * that have been used since they were cached before they expire.
+ */
+static void
+dns_cache_tmr(void)
+{
+  u8_t i;
+
+  for (i = 0; i < DNS_CACHE_SIZE; i++) {
+    struct dns_cache_entry *entry = &dns_cache[i];
+    if (entry->state == DNS_CACHE_UNUSED) {
+      continue;
+    }
+    if ((entry->ttl == 0) || (--entry->ttl == 0)) {
+      LWIP_DEBUGF(DNS_DEBUG, ("dns_cache_tmr: \"%s\": expired\n", entry->name));
+      dns_cache_remove(entry);
+      continue;
+    }
+#if DNS_CACHE_PREFETCH_TTL
+    if ((entry->state == DNS_CACHE_POSITIVE) && (entry->hits > 0) && !entry->prefetched &&
+        (entry->ttl <= DNS_CACHE_PREFETCH_TTL)) {
+      dns_cache_prefetch(entry);
+    }
+#endif /* DNS_CACHE_PREFETCH_TTL */
+  }
+}
+
+/**
+ * @ingroup dns
+ * Remove all names from the DNS cache, e.g. after the DNS servers changed.
+ */
+void
+dns_cache_flush(void)
+{
+  memset(dns_cache, 0, sizeof(dns_cache));
+  memset(dns_cache_hash, 0, sizeof(dns_cache_hash));
+}
+#endif /* LWIP_DNS_CACHE */
+
 /**
  * The DNS resolver client timer - handle retries and timeouts and should
  * be called every DNS_TMR_INTERVAL milliseconds (every second by default).
@@ -396,6 +672,9 @@ dns_tmr(void)
 {
   LWIP_DEBUGF(DNS_DEBUG, ("dns_tmr: dns_check_entries\n"));
   dns_check_entries();
+#if LWIP_DNS_CACHE
+  dns_cache_tmr();
+#endif /* LWIP_DNS_CACHE */
 }
 
 #if DNS_LOCAL_HOSTLIST
@@ -601,7 +880,9 @@ dns_local_addhost(const char *hostname, const ip_addr_t *addr)
 static err_t
 dns_lookup(const char *name, ip_addr_t *addr LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addrtype))
 {
+#if !LWIP_DNS_CACHE
   u8_t i;
+#endif /* !LWIP_DNS_CACHE */
 #if DNS_LOCAL_HOSTLIST
   if (dns_lookup_local(name, addr LWIP_DNS_ADDRTYPE_ARG(dns_addrtype)) == ERR_OK) {
     return ERR_OK;
@@ -613,6 +894,12 @@ dns_lookup(const char *name, ip_addr_t *addr LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addr
   }
 #endif /* DNS_LOOKUP_LOCAL_EXTERN */
 
+#if LWIP_DNS_CACHE
+  if (dns_cache_lookup(name, addr LWIP_DNS_ADDRTYPE_ARG(dns_addrtype)) == ERR_OK) {
+    LWIP_DEBUGF(DNS_DEBUG, ("dns_lookup: \"%s\": found in cache\n", name));
+    return ERR_OK;
+  }
+#else /* LWIP_DNS_CACHE */
   /* Walk through name list, return entry if found. If not, return NULL. */
   for (i = 0; i < DNS_TABLE_SIZE; ++i) {
     if ((dns_table[i].state == DNS_STATE_DONE) &&
@@ -627,6 +914,7 @@ dns_lookup(const char *name, ip_addr_t *addr LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addr
       return ERR_OK;
     }
   }
+#endif /* LWIP_DNS_CACHE */
 
   return ERR_ARG;
 }
@@ -643,99 +931,78 @@ dns_lookup(const char *name, ip_addr_t *addr LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addr
  * Currently, the request is sent exactly as passed in by he user request.
  *
  * @param query hostname (not encoded) from the dns_table
- * @param p pbuf containing the encoded hostname in the DNS response
- * @param start_offset offset into p where the name starts
- * @return 0xFFFF: names differ, other: names equal -> offset behind name
+ * @param c cursor at the encoded hostname in the DNS response, moved behind
+ *        the name if it matches
+ * @return ERR_OK: names equal, ERR_VAL: names differ
  */
-static u16_t
-dns_compare_name(const char *query, struct pbuf *p, u16_t start_offset)
+static err_t
+dns_compare_name(const char *query, struct pbuf_cursor *c)
 {
   int n;
-  u16_t response_offset = start_offset;
 
+  n = pbuf_cursor_get(c);
   do {
-    n = pbuf_try_get_at(p, response_offset);
-    if ((n < 0) || (response_offset == 0xFFFF)) {
-      /* error or overflow */
-      return 0xFFFF;
+    if (n < 0) {
+      /* error or end of packet */
+      return ERR_VAL;
     }
-    response_offset++;
     /** @see RFC 1035 - 4.1.4. Message compression */
     if ((n & 0xc0) == 0xc0) {
       /* Compressed name: cannot be equal since we don't send them */
-      return 0xFFFF;
+      return ERR_VAL;
     } else {
       /* Not compressed name */
       while (n > 0) {
-        int c = pbuf_try_get_at(p, response_offset);
-        if (c < 0) {
-          return 0xFFFF;
-        }
-        if (lwip_tolower((*query)) != lwip_tolower((u8_t)c)) {
-          return 0xFFFF;
+        int ch = pbuf_cursor_get(c);
+        if (ch < 0) {
+          return ERR_VAL;
         }
-        if (response_offset == 0xFFFF) {
-          /* would overflow */
-          return 0xFFFF;
+        if (lwip_tolower((*query)) != lwip_tolower((u8_t)ch)) {
+          return ERR_VAL;
         }
-        response_offset++;
         ++query;
         --n;
       }
       ++query;
     }
-    n = pbuf_try_get_at(p, response_offset);
-    if (n < 0) {
-      return 0xFFFF;
-    }
+    n = pbuf_cursor_get(c);
   } while (n != 0);
 
-  if (response_offset == 0xFFFF) {
-    /* would overflow */
-    return 0xFFFF;
-  }
-  return (u16_t)(response_offset + 1);
+  return ERR_OK;
 }
 
 /**
- * Walk through a compact encoded DNS name and return the end of the name.
+ * Walk through a compact encoded DNS name and move the cursor behind it.
  *
- * @param p pbuf containing the name
- * @param query_idx start index into p pointing to encoded DNS name in the DNS server response
- * @return index to end of the name
+ * @param c cursor at the encoded DNS name in the DNS server response
+ * @return ERR_OK or ERR_VAL if the name is invalid or truncated
  */
-static u16_t
-dns_skip_name(struct pbuf *p, u16_t query_idx)
+static err_t
+dns_skip_name(struct pbuf_cursor *c)
 {
   int n;
-  u16_t offset = query_idx;
 
+  n = pbuf_cursor_get(c);
   do {
-    n = pbuf_try_get_at(p, offset++);
-    if ((n < 0) || (offset == 0)) {
-      return 0xFFFF;
+    if (n < 0) {
+      return ERR_VAL;
     }
     /** @see RFC 1035 - 4.1.4. Message compression */
     if ((n & 0xc0) == 0xc0) {
-      /* Compressed name: since we only want to skip it (not check it), stop here */
-      break;
+      /* Compressed name: since we only want to skip it (not check it), stop
+         behind the second byte of the pointer */
+      return pbuf_cursor_skip(c, 1) == ERR_OK ? ERR_OK : ERR_VAL;
     } else {
       /* Not compressed name */
-      if (offset + n >= p->tot_len) {
-        return 0xFFFF;
+      if ((u32_t)pbuf_cursor_pos(c) + n >= c->head->tot_len) {
+        return ERR_VAL;
       }
-      offset = (u16_t)(offset + n);
-    }
-    n = pbuf_try_get_at(p, offset);
-    if (n < 0) {
-      return 0xFFFF;
+      pbuf_cursor_skip(c, (u16_t)n);
     }
+    n = pbuf_cursor_get(c);
   } while (n != 0);
 
-  if (offset == 0xFFFF) {
-    return 0xFFFF;
-  }
-  return (u16_t)(offset + 1);
+  return ERR_OK;
 }
 
 /**
@@ -1149,8 +1416,19 @@ dns_correct_response(u8_t idx, u32_t ttl)
   if (entry->ttl > DNS_MAX_TTL) {
     entry->ttl = DNS_MAX_TTL;
   }
+#if LWIP_DNS_CACHE
+  if (entry->ttl != 0) {
+    dns_cache_add(entry->name, &entry->ipaddr, entry->ttl LWIP_DNS_ISMDNS_ARG(entry->is_mdns));
+  }
+#endif /* LWIP_DNS_CACHE */
   dns_call_found(idx, &entry->ipaddr);
 
+#if LWIP_DNS_CACHE
+  /* the answer lives on in the cache, dns_table only holds pending queries */
+  if (entry->state == DNS_STATE_DONE) {
+    entry->state = DNS_STATE_UNUSED;
+  }
+#else /* LWIP_DNS_CACHE */
   if (entry->ttl == 0) {
     /* RFC 883, page 29: "Zero values are
        interpreted to mean that the RR can only be used for the
@@ -1161,7 +1439,86 @@ dns_correct_response(u8_t idx, u32_t ttl)
       entry->state = DNS_STATE_UNUSED;
     }
   }
+#endif /* LWIP_DNS_CACHE */
+}
+
+#if LWIP_DNS_CACHE
+/**
+ * Negative caching (RFC 2308): the time a failed lookup may be cached is
+ * the minimum of the SOA record's TTL and its MINIMUM field, limited
+ * to DNS_CACHE_NEG_TTL.
+ *
+ * @param c cursor at the first record behind the question
+ * @param nrecords number of answer and authority records
+ */
+static u32_t
+dns_negative_ttl(struct pbuf_cursor *c, u16_t nrecords)
+{
+  struct dns_answer ans;
+  u32_t ttl = DNS_CACHE_NEG_TTL;
+  u32_t minimum;
+  u16_t len;
+
+  for (; (nrecords > 0) && (pbuf_cursor_pos(c) < c->head->tot_len); nrecords--) {
+    if ((dns_skip_name(c) != ERR_OK) ||
+        (pbuf_cursor_read(c, &ans, SIZEOF_DNS_ANSWER) != SIZEOF_DNS_ANSWER)) {
+      break;
+    }
+    len = lwip_htons(ans.len);
+    if ((u32_t)pbuf_cursor_pos(c) + len > 0xFFFF) {
+      break;
+    }
+    if ((ans.type == PP_HTONS(DNS_RRTYPE_SOA)) && (len >= sizeof(minimum))) {
+      /* MINIMUM is the last field of the SOA RDATA */
+      if ((pbuf_cursor_skip(c, (u16_t)(len - sizeof(minimum))) == ERR_OK) &&
+          (pbuf_cursor_read(c, &minimum, sizeof(minimum)) == sizeof(minimum))) {
+        ttl = LWIP_MIN(ttl, lwip_ntohl(ans.ttl));
+        ttl = LWIP_MIN(ttl, lwip_ntohl(minimum));
+      }
+      break;
+    }
+    pbuf_cursor_seek(c, (u16_t)(pbuf_cursor_pos(c) + len));
+  }
+  return ttl;
+}
+
+/**
+ * Cache a failed lookup.
+ *
+ * @param entry the dns_table entry the response belongs to
+ * @param c cursor at the first record behind the question (moved)
+ * @param nrecords number of answer and authority records
+ * @param nxdomain 1 if the name does not exist at all, 0 if it only has no
+ *        address of the requested type
+ */
+static void
+dns_cache_failed_response(struct dns_table_entry *entry, struct pbuf_cursor *c, u16_t nrecords, u8_t nxdomain)
+{
+  u32_t ttl;
+
+#if LWIP_DNS_SUPPORT_MDNS_QUERIES
+  if (entry->is_mdns) {
+    return;
+  }
+#endif /* LWIP_DNS_SUPPORT_MDNS_QUERIES */
+  ttl = dns_negative_ttl(c, nrecords);
+  if (ttl == 0) {
+    return;
+  }
+  LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": negative for %"U32_F" s\n", entry->name, ttl));
+#if LWIP_IPV4 && LWIP_IPV6
+  if (nxdomain) {
+    dns_cache_add_negative(entry->name, ttl, LWIP_DNS_ADDRTYPE_IPV4);
+    dns_cache_add_negative(entry->name, ttl, LWIP_DNS_ADDRTYPE_IPV6);
+  } else {
+    dns_cache_add_negative(entry->name, ttl, DNS_CACHE_FAMILY(entry->reqaddrtype));
+  }
+#else /* LWIP_IPV4 && LWIP_IPV6 */
+  LWIP_UNUSED_ARG(nxdomain);
+  dns_cache_add_negative(entry->name, ttl);
+#endif /* LWIP_IPV4 && LWIP_IPV6 */
 }
+#endif /* LWIP_DNS_CACHE */
 
 /**
  * Receive input function for DNS response packets arriving for the dns UDP pcb.
@@ -1171,11 +1528,15 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
 {
   u8_t i;
   u16_t txid;
-  u16_t res_idx;
+  struct pbuf_cursor cur;
   struct dns_hdr hdr;
   struct dns_answer ans;
   struct dns_query qry;
   u16_t nquestions, nanswers;
+#if LWIP_DNS_CACHE
+  struct pbuf_cursor rr;
+  u16_t nrecords;
+#endif /* LWIP_DNS_CACHE */
 
   LWIP_UNUSED_ARG(arg);
   LWIP_UNUSED_ARG(pcb);
@@ -1189,7 +1550,8 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
   }
 
   /* copy dns payload inside static buffer for processing */
-  if (pbuf_copy_partial(p, &hdr, SIZEOF_DNS_HDR, 0) == SIZEOF_DNS_HDR) {
+  pbuf_cursor_init(&cur, p, 0);
+  if (pbuf_cursor_read(&cur, &hdr, SIZEOF_DNS_HDR) == SIZEOF_DNS_HDR) {
     /* Match the ID in the DNS header with the name table. */
     txid = lwip_htons(hdr.id);
     for (i = 0; i < DNS_TABLE_SIZE; i++) {
@@ -1225,14 +1587,13 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
 
         /* Check if the name in the "question" part match with the name in the entry and
            skip it if equal. */
-        res_idx = dns_compare_name(entry->name, p, SIZEOF_DNS_HDR);
-        if (res_idx == 0xFFFF) {
+        if (dns_compare_name(entry->name, &cur) != ERR_OK) {
           LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": response not match to query\n", entry->name));
           goto ignore_packet; /* ignore this packet */
         }
 
         /* check if "question" part matches the request */
-        if (pbuf_copy_partial(p, &qry, SIZEOF_DNS_QUERY, res_idx) != SIZEOF_DNS_QUERY) {
+        if (pbuf_cursor_read(&cur, &qry, SIZEOF_DNS_QUERY) != SIZEOF_DNS_QUERY) {
           goto ignore_packet; /* ignore this packet */
         }
         if ((qry.cls != PP_HTONS(DNS_RRCLASS_IN)) ||
@@ -1241,11 +1602,10 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
           LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": response not match to query\n", entry->name));
           goto ignore_packet; /* ignore this packet */
         }
-        /* skip the rest of the "question" part */
-        if (res_idx + SIZEOF_DNS_QUERY > 0xFFFF) {
-          goto ignore_packet;
-        }
-        res_idx = (u16_t)(res_idx + SIZEOF_DNS_QUERY);
+#if LWIP_DNS_CACHE
+        rr = cur;
+        nrecords = (u16_t)(nanswers + lwip_htons(hdr.numauthrr));
+#endif /* LWIP_DNS_CACHE */
 
         /* Check for error. If so, call callback to inform. */
         if (hdr.flags2 & DNS_FLAG2_ERR_MASK) {
@@ -1264,22 +1624,22 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
 
             goto ignore_packet;
           }
+#if LWIP_DNS_CACHE
+          if ((hdr.flags2 & DNS_FLAG2_ERR_MASK) == DNS_FLAG2_ERR_NAME) {
+            dns_cache_failed_response(entry, &rr, nrecords, 1);
+          }
+#endif /* LWIP_DNS_CACHE */
         } else {
-          while ((nanswers > 0) && (res_idx < p->tot_len)) {
+          while ((nanswers > 0) && (pbuf_cursor_pos(&cur) < p->tot_len)) {
             /* skip answer resource record's host name */
-            res_idx = dns_skip_name(p, res_idx);
-            if (res_idx == 0xFFFF) {
+            if (dns_skip_name(&cur) != ERR_OK) {
               goto ignore_packet; /* ignore this packet */
             }
 
             /* Check for IP address type and Internet class. Others are discarded. */
-            if (pbuf_copy_partial(p, &ans, SIZEOF_DNS_ANSWER, res_idx) != SIZEOF_DNS_ANSWER) {
+            if (pbuf_cursor_read(&cur, &ans, SIZEOF_DNS_ANSWER) != SIZEOF_DNS_ANSWER) {
               goto ignore_packet; /* ignore this packet */
             }
-            if (res_idx + SIZEOF_DNS_ANSWER > 0xFFFF) {
-              goto ignore_packet;
-            }
-            res_idx = (u16_t)(res_idx + SIZEOF_DNS_ANSWER);
 
             if (ans.cls == PP_HTONS(DNS_RRCLASS_IN)) {
 #if LWIP_IPV4
@@ -1290,7 +1650,7 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
                 {
                   ip4_addr_t ip4addr;
                   /* read the IP address after answer resource record's header */
-                  if (pbuf_copy_partial(p, &ip4addr, sizeof(ip4_addr_t), res_idx) != sizeof(ip4_addr_t)) {
+                  if (pbuf_cursor_read(&cur, &ip4addr, sizeof(ip4_addr_t)) != sizeof(ip4_addr_t)) {
                     goto ignore_packet; /* ignore this packet */
                   }
                   ip_addr_copy_from_ip4(dns_table[i].ipaddr, ip4addr);
@@ -1309,7 +1669,7 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
                 {
                   ip6_addr_p_t ip6addr;
                   /* read the IP address after answer resource record's header */
-                  if (pbuf_copy_partial(p, &ip6addr, sizeof(ip6_addr_p_t), res_idx) != sizeof(ip6_addr_p_t)) {
+                  if (pbuf_cursor_read(&cur, &ip6addr, sizeof(ip6_addr_p_t)) != sizeof(ip6_addr_p_t)) {
                     goto ignore_packet; /* ignore this packet */
                   }
                   /* @todo: scope ip6addr? Might be required for link-local addresses at least? */
@@ -1323,12 +1683,18 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
 #endif /* LWIP_IPV6 */
             }
             /* skip this answer */
-            if ((int)(res_idx + lwip_htons(ans.len)) > 0xFFFF) {
+            if ((int)(pbuf_cursor_pos(&cur) + lwip_htons(ans.len)) > 0xFFFF) {
               goto ignore_packet; /* ignore this packet */
             }
-            res_idx = (u16_t)(res_idx + lwip_htons(ans.len));
+            pbuf_cursor_seek(&cur, (u16_t)(pbuf_cursor_pos(&cur) + lwip_htons(ans.len)));
             --nanswers;
           }
+#if LWIP_DNS_CACHE
+          if (nanswers == 0) {
+            /* all answers parsed, none for the requested type */
+            dns_cache_failed_response(entry, &rr, nrecords, 0);
+          }
+#endif /* LWIP_DNS_CACHE */
 #if LWIP_IPV4 && LWIP_IPV6
           if ((entry->reqaddrtype == LWIP_DNS_ADDRTYPE_IPV4_IPV6) ||
               (entry->reqaddrtype == LWIP_DNS_ADDRTYPE_IPV6_IPV4)) {
@@ -1513,6 +1879,8 @@ dns_enqueue(const char *name, size_t hostnamelen, dns_found_callback found,
  * - ERR_INPROGRESS enqueue a request to be sent to the DNS server
  *   for resolution if no errors are present.
  * - ERR_ARG: dns client not initialized or invalid hostname
+ * - ERR_VAL: no DNS server configured, or (with LWIP_DNS_CACHE) the
+ *   hostname is cached as not resolvable
  *
  * @param hostname the hostname that is to be queried
  * @param addr pointer to a ip_addr_t where to store the address if it is already
@@ -1602,10 +1970,23 @@ dns_gethostbyname_addrtype(const char *hostname, ip_addr_t *addr, dns_found_call
     if (dns_lookup(hostname, addr LWIP_DNS_ADDRTYPE_ARG(fallback)) == ERR_OK) {
       return ERR_OK;
     }
+#if LWIP_DNS_CACHE
+    if (dns_cache_lookup(hostname, NULL, dns_addrtype) == ERR_VAL) {
+      /* 1st IP type is known to fail, only ask for the 2nd one */
+      dns_addrtype = fallback;
+    }
+#endif /* LWIP_DNS_CACHE */
   }
 #else /* LWIP_IPV4 && LWIP_IPV6 */
   LWIP_UNUSED_ARG(dns_addrtype);
 #endif /* LWIP_IPV4 && LWIP_IPV6 */
+#if LWIP_DNS_CACHE
+  /* known not to resolve? fail without asking again */
+  if (dns_cache_is_negative(hostname LWIP_DNS_ADDRTYPE_ARG(dns_addrtype))) {
+    LWIP_DEBUGF(DNS_DEBUG, ("dns_gethostbyname: \"%s\": negative cache hit\n", hostname));
+    return ERR_VAL;
+  }
+#endif /* LWIP_DNS_CACHE */
 
 #if LWIP_DNS_SUPPORT_MDNS_QUERIES
   if (strstr(hostname, ".local") == &hostname[hostnamelen] - 6) {
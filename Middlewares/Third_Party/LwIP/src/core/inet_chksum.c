@@ -10,7 +10,21 @@
  * \#define LWIP_CHKSUM your_checksum_routine
  *
  * Or you can select from the implementations below by defining
- * LWIP_CHKSUM_ALGORITHM to 1, 2 or 3.
+ * LWIP_CHKSUM_ALGORITHM to 1, 2, 3 or 4:
+ * - 1: reads one byte at a time, smallest code, up to 64k of data
+ * - 2: 16 bits at a time (the default), suits 8- and 16-bit CPUs
+ * - 3: 32 bits at a time, unrolled to 8 bytes per loop
+ * - 4: 32 bits at a time into a 64-bit accumulator, unrolled to 32 bytes per
+ *   loop (or GCC vector extensions with LWIP_CHKSUM_GCC_VECTOR==1). Choose it
+ *   on 32- and 64-bit CPUs that checksum large segments in software, where it
+ *   is fastest; it costs more code than 2 or 3 and needs u64_t.
+ *
+ * With LWIP_CHECKSUM_ON_COPY, LWIP_CHKSUM_COPY_ALGORITHM selects
+ * lwip_chksum_copy():
+ * - 1: MEMCPY, then LWIP_CHKSUM over the copy (the default)
+ * - 2: copy and checksum in one pass, 16 bytes per loop into a 64-bit
+ *   accumulator. It touches the data once and needs u64_t; it does not use
+ *   LWIP_CHKSUM_GCC_VECTOR, which only applies to LWIP_CHKSUM_ALGORITHM 4.
  */
 
 /*
@@ -64,6 +78,11 @@ u16_t lwip_standard_chksum(const void *dataptr, int len);
 #ifndef LWIP_CHKSUM_ALGORITHM
 # define LWIP_CHKSUM_ALGORITHM 0
 #endif
+/* Let algorithm #4 use GCC vector extensions for the bulk of the data
+   (useful on hosts with SIMD units, pointless on Cortex-M) */
+#ifndef LWIP_CHKSUM_GCC_VECTOR
+# define LWIP_CHKSUM_GCC_VECTOR 0
+#endif
 
 #if (LWIP_CHKSUM_ALGORITHM == 1) /* Version #1 */
 /**
@@ -255,6 +274,120 @@ lwip_standard_chksum(const void *dataptr, int len)
 }
 #endif
 
+#if (LWIP_CHKSUM_ALGORITHM == 4) || (LWIP_CHKSUM_COPY_ALGORITHM == 2)
+/** Fold a 64-bit one's complement accumulator down to 16 bits */
+static u16_t
+lwip_chksum_fold64(u64_t sum)
+{
+  u32_t acc;
+
+  sum = (sum >> 32) + (sum & 0xffffffffUL);
+  sum = (sum >> 32) + (sum & 0xffffffffUL);
+  acc = (u32_t)sum;
+  acc = FOLD_U32T(acc);
+  acc = FOLD_U32T(acc);
+  return (u16_t)acc;
+}
+#endif
+
+#if (LWIP_CHKSUM_ALGORITHM == 4) /* Alternative version #4 */
+/**
+ * Checksum routine for 32- and 64-bit CPUs: after aligning to a u32_t
+ * boundary, 32-bit words are added into a 64-bit accumulator so that the
+ * unrolled inner loop (32 bytes per iteration) needs no carry handling.
+ * With LWIP_CHKSUM_GCC_VECTOR==1, the bulk of the data is summed 64 bytes
+ * at a time using GCC vector extensions instead.
+ *
+ * @param dataptr points to start of data to be summed at any boundary
+ * @param len length of data to be summed
+ * @return host order (!) lwip checksum (non-inverted Internet sum)
+ */
+u16_t
+lwip_standard_chksum(const void *dataptr, int len)
+{
+  const u8_t *pb = (const u8_t *)dataptr;
+  const u32_t *pl;
+  u16_t t = 0;
+  u16_t sum16;
+  u64_t sum = 0;
+  /* starts at odd byte address? */
+  int odd = ((mem_ptr_t)pb & 1);
+
+  if (odd && len > 0) {
+    ((u8_t *)&t)[1] = *pb++;
+    len--;
+  }
+
+  /* Get aligned to u32_t */
+  if (((mem_ptr_t)pb & 2) && len > 1) {
+    sum += *(const u16_t *)(const void *)pb;
+    pb += 2;
+    len -= 2;
+  }
+
+  pl = (const u32_t *)(const void *)pb;
+
+#if LWIP_CHKSUM_GCC_VECTOR
+  {
+    typedef u32_t lwip_v4u32_t __attribute__((vector_size(16)));
+    const lwip_v4u32_t mask = {0xffff, 0xffff, 0xffff, 0xffff};
+    lwip_v4u32_t v[4], vsum;
+    int i, blocks;
+
+    while (len >= 64) {
+      /* each lane adds up to 8 * 0xffff per iteration: flush to the
+         64-bit accumulator before the lanes can overflow */
+      vsum = mask ^ mask;
+      for (blocks = 0; (len >= 64) && (blocks < 8192); blocks++) {
+        MEMCPY(v, pl, sizeof(v));
+        for (i = 0; i < 4; i++) {
+          vsum += (v[i] & mask) + (v[i] >> 16);
+        }
+        pl += 16;
+        len -= 64;
+      }
+      sum += (u64_t)vsum[0] + vsum[1] + vsum[2] + vsum[3];
+    }
+  }
+#endif /* LWIP_CHKSUM_GCC_VECTOR */
+
+  while (len > 31) {
+    sum += (u64_t)pl[0] + pl[1] + pl[2] + pl[3] +
+           (u64_t)pl[4] + pl[5] + pl[6] + pl[7];
+    pl += 8;
+    len -= 32;
+  }
+
+  while (len > 3) {
+    sum += *pl++;
+    len -= 4;
+  }
+
+  pb = (const u8_t *)pl;
+
+  /* 16-bit aligned word remaining? */
+  if (len > 1) {
+    sum += *(const u16_t *)(const void *)pb;
+    pb += 2;
+    len -= 2;
+  }
+
+  /* dangling tail byte remaining? */
+  if (len > 0) {                /* include odd byte */
+    ((u8_t *)&t)[0] = *pb;
+  }
+
+  sum += t;                     /* add end bytes */
+
+  sum16 = lwip_chksum_fold64(sum);
+  if (odd) {
+    sum16 = (u16_t)SWAP_BYTES_IN_WORD(sum16);
+  }
+
+  return sum16;
+}
+#endif
+
 /** Parts of the pseudo checksum which are common to IPv4 and IPv6 */
 static u16_t
 inet_cksum_pseudo_base(struct pbuf *p, u8_t proto, u16_t proto_len, u32_t acc)
@@ -606,3 +739,63 @@ lwip_chksum_copy(void *dst, const void *src, u16_t len)
   return LWIP_CHKSUM(dst, len);
 }
 #endif /* (LWIP_CHKSUM_COPY_ALGORITHM == 1) */
+
+#if (LWIP_CHKSUM_COPY_ALGORITHM == 2) /* Version #2 */
+/** Fused copy and checksum: every 32-bit word is loaded once, stored to
+ * dst and added to a 64-bit accumulator, so the data is only touched once.
+ * Words are moved with SMEMCPY, so src and dst may have any (and different)
+ * alignment; compilers turn this into plain loads and stores on CPUs that
+ * support unaligned access.
+ */
+u16_t
+lwip_chksum_copy(void *dst, const void *src, u16_t len)
+{
+  const u8_t *s = (const u8_t *)src;
+  u8_t *d = (u8_t *)dst;
+  u64_t sum = 0;
+  u32_t w0, w1, w2, w3;
+  u16_t h;
+  u16_t t = 0;
+
+  while (len > 15) {
+    SMEMCPY(&w0, s, 4);
+    SMEMCPY(&w1, s + 4, 4);
+    SMEMCPY(&w2, s + 8, 4);
+    SMEMCPY(&w3, s + 12, 4);
+    SMEMCPY(d, &w0, 4);
+    SMEMCPY(d + 4, &w1, 4);
+    SMEMCPY(d + 8, &w2, 4);
+    SMEMCPY(d + 12, &w3, 4);
+    sum += (u64_t)w0 + w1 + w2 + w3;
+    s += 16;
+    d += 16;
+    len = (u16_t)(len - 16);
+  }
+
+  while (len > 3) {
+    SMEMCPY(&w0, s, 4);
+    SMEMCPY(d, &w0, 4);
+    sum += w0;
+    s += 4;
+    d += 4;
+    len = (u16_t)(len - 4);
+  }
+
+  if (len > 1) {
+    SMEMCPY(&h, s, 2);
+    SMEMCPY(d, &h, 2);
+    sum += h;
+    s += 2;
+    d += 2;
+    len = (u16_t)(len - 2);
+  }
+
+  if (len > 0) {
+    *d = *s;
+    ((u8_t *)&t)[0] = *s;
+  }
+  sum += t;
+
+  return lwip_chksum_fold64(sum);
+}
+#endif /* (LWIP_CHKSUM_COPY_ALGORITHM == 2) */
@@ -169,6 +169,33 @@ PACK_STRUCT_END
 #if (LWIP_TCP && LWIP_TCP_SACK_OUT && (LWIP_TCP_MAX_SACK_NUM < 1))
 #error "LWIP_TCP_MAX_SACK_NUM must be greater than 0"
 #endif
+#if (LWIP_TCP && TCP_OOSEQ_RANGES && !TCP_QUEUE_OOSEQ)
+#error "To use TCP_OOSEQ_RANGES, TCP_QUEUE_OOSEQ needs to be enabled"
+#endif
+#if (LWIP_TCP && (TCP_OOSEQ_RANGES < 0 || TCP_OOSEQ_RANGES > 0xff))
+#error "TCP_OOSEQ_RANGES must fit into an u8_t"
+#endif
+#if (MEMP_LOCKFREE && (MEMP_MEM_MALLOC || MEMP_SANITY_CHECK))
+#error "MEMP_LOCKFREE cannot be used together with MEMP_MEM_MALLOC or MEMP_SANITY_CHECK"
+#endif
+#if (MEMP_LOCKFREE && !defined SYS_ARCH_CAS_U32)
+#error "MEMP_LOCKFREE needs SYS_ARCH_CAS_U32 defined in your sys_arch.h"
+#endif
+#if (LWIP_SPSC_RING && (!defined SYS_ARCH_CAS_U32 || !defined SYS_ARCH_MEMORY_BARRIER))
+#error "LWIP_SPSC_RING needs SYS_ARCH_CAS_U32 and SYS_ARCH_MEMORY_BARRIER defined in your sys_arch.h"
+#endif
+#if (LWIP_TCP && TCP_WRITE_ZEROCOPY && !LWIP_SUPPORT_CUSTOM_PBUF)
+#error "TCP_WRITE_ZEROCOPY needs LWIP_SUPPORT_CUSTOM_PBUF enabled in your lwipopts.h"
+#endif
+#if (LWIP_TCP && TCP_WRITE_ZEROCOPY && LWIP_NETIF_TX_SINGLE_PBUF)
+#error "TCP_WRITE_ZEROCOPY cannot be used together with LWIP_NETIF_TX_SINGLE_PBUF"
+#endif
+#if (LWIP_TCP && TCP_TSO && !LWIP_IPV4)
+#error "TCP_TSO needs LWIP_IPV4 enabled in your lwipopts.h"
+#endif
+#if (LWIP_TCP && TCP_TSO && !LWIP_SUPPORT_CUSTOM_PBUF && !LWIP_NETIF_TX_SINGLE_PBUF)
+#error "TCP_TSO needs LWIP_SUPPORT_CUSTOM_PBUF or LWIP_NETIF_TX_SINGLE_PBUF enabled in your lwipopts.h"
+#endif
 #if (LWIP_NETIF_API && (NO_SYS==1))
 #error "If you want to use NETIF API, you have to define NO_SYS=0 in your lwipopts.h"
 #endif
@@ -238,6 +265,9 @@ PACK_STRUCT_END
 #endif
 #endif /* LWIP_NETCONN && LWIP_TCP */
 #if LWIP_SOCKET
+#if LWIP_SOCKET_EPOLL && !(LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL)
+#error "LWIP_SOCKET_EPOLL needs the socket event callback: enable LWIP_SOCKET_SELECT or LWIP_SOCKET_POLL in your lwipopts.h"
+#endif
 #endif /* LWIP_SOCKET */
 
 
@@ -104,9 +104,15 @@ struct etharp_entry {
 
 static struct etharp_entry arp_table[ARP_TABLE_SIZE];
 
-#if !LWIP_NETIF_HWADDRHINT
+#if ETHARP_TABLE_HASH
+/** Open addressing index into arp_table by IP address: each slot holds an
+ * arp_table index + 1, 0 marks a free slot. Collisions probe linearly. */
+static netif_addr_idx_t arp_table_hash[ETHARP_TABLE_HASH_SIZE];
+#endif /* ETHARP_TABLE_HASH */
+
+#if !LWIP_NETIF_HWADDRHINT && !ETHARP_TABLE_HASH
 static netif_addr_idx_t etharp_cached_entry;
-#endif /* !LWIP_NETIF_HWADDRHINT */
+#endif /* !LWIP_NETIF_HWADDRHINT && !ETHARP_TABLE_HASH */
 
 /** Try hard to create a new entry - we want the IP address to appear in
     the cache (even if this means removing an active entry or so). */
@@ -119,6 +125,8 @@ static netif_addr_idx_t etharp_cached_entry;
 #if LWIP_NETIF_HWADDRHINT
 #define ETHARP_SET_ADDRHINT(netif, addrhint)  do { if (((netif) != NULL) && ((netif)->hints != NULL)) { \
                                               (netif)->hints->addr_hint = (addrhint); }} while(0)
+#elif ETHARP_TABLE_HASH
+#define ETHARP_SET_ADDRHINT(netif, addrhint)  ((netif)->arp_hint = (addrhint))
 #else /* LWIP_NETIF_HWADDRHINT */
 #define ETHARP_SET_ADDRHINT(netif, addrhint)  (etharp_cached_entry = (addrhint))
 #endif /* LWIP_NETIF_HWADDRHINT */
@@ -128,6 +136,9 @@ static netif_addr_idx_t etharp_cached_entry;
 #if (ARP_TABLE_SIZE > NETIF_ADDR_IDX_MAX)
 #error "ARP_TABLE_SIZE must fit in an s16_t, you have to reduce it in your lwipopts.h"
 #endif
+#if ETHARP_TABLE_HASH && (ETHARP_TABLE_HASH_SIZE <= ARP_TABLE_SIZE)
+#error "ETHARP_TABLE_HASH_SIZE must be bigger than ARP_TABLE_SIZE, you have to increase it in your lwipopts.h"
+#endif
 
 
 static err_t etharp_request_dst(struct netif *netif, const ip4_addr_t *ipaddr, const struct eth_addr *hw_dst_addr);
@@ -163,10 +174,86 @@ free_etharp_q(struct etharp_q_entry *q)
 
 #endif /* ARP_QUEUEING */
 
+#if ETHARP_TABLE_HASH
+/** Home slot of an IP address in arp_table_hash */
+static u16_t
+etharp_hash_slot(const ip4_addr_t *ipaddr)
+{
+  u32_t h = ip4_addr_get_u32(ipaddr);
+  h ^= h >> 16;
+  h *= 0x45d9f3bUL;
+  h ^= h >> 16;
+  return (u16_t)(h % ETHARP_TABLE_HASH_SIZE);
+}
+
+/** Add arp_table[i] to the index (its IP address must be set) */
+static void
+etharp_hash_add(netif_addr_idx_t i)
+{
+  u16_t slot = etharp_hash_slot(&arp_table[i].ipaddr);
+  while (arp_table_hash[slot] != 0) {
+    slot = (u16_t)((slot + 1) % ETHARP_TABLE_HASH_SIZE);
+  }
+  arp_table_hash[slot] = (netif_addr_idx_t)(i + 1);
+}
+
+/** Remove arp_table[i] from the index, if it is in there */
+static void
+etharp_hash_remove(netif_addr_idx_t i)
+{
+  u16_t slot = etharp_hash_slot(&arp_table[i].ipaddr);
+  u16_t next;
+
+  while (arp_table_hash[slot] != (netif_addr_idx_t)(i + 1)) {
+    if (arp_table_hash[slot] == 0) {
+      return;
+    }
+    slot = (u16_t)((slot + 1) % ETHARP_TABLE_HASH_SIZE);
+  }
+  /* close the gap: move back entries whose probe sequence passes it */
+  for (next = (u16_t)((slot + 1) % ETHARP_TABLE_HASH_SIZE); arp_table_hash[next] != 0;
+       next = (u16_t)((next + 1) % ETHARP_TABLE_HASH_SIZE)) {
+    u16_t home = etharp_hash_slot(&arp_table[arp_table_hash[next] - 1].ipaddr);
+    if ((slot < next) ? ((home <= slot) || (home > next)) : ((home <= slot) && (home > next))) {
+      arp_table_hash[slot] = arp_table_hash[next];
+      slot = next;
+    }
+  }
+  arp_table_hash[slot] = 0;
+}
+
+/** Look up the entry for ipaddr (on netif, if given and ETHARP_TABLE_MATCH_NETIF)
+ * @return arp_table index or -1 if not found
+ */
+static s16_t
+etharp_hash_find(const ip4_addr_t *ipaddr, struct netif *netif)
+{
+  u16_t slot = etharp_hash_slot(ipaddr);
+
+  LWIP_UNUSED_ARG(netif);
+
+  for (; arp_table_hash[slot] != 0; slot = (u16_t)((slot + 1) % ETHARP_TABLE_HASH_SIZE)) {
+    s16_t i = (s16_t)(arp_table_hash[slot] - 1);
+    if ((arp_table[i].state != ETHARP_STATE_EMPTY) &&
+        ip4_addr_cmp(ipaddr, &arp_table[i].ipaddr)
+#if ETHARP_TABLE_MATCH_NETIF
+        && ((netif == NULL) || (netif == arp_table[i].netif))
+#endif /* ETHARP_TABLE_MATCH_NETIF */
+       ) {
+      return i;
+    }
+  }
+  return -1;
+}
+#endif /* ETHARP_TABLE_HASH */
+
 /** Clean up ARP table entries */
 static void
 etharp_free_entry(int i)
 {
+#if ETHARP_TABLE_HASH
+  etharp_hash_remove((netif_addr_idx_t)i);
+#endif /* ETHARP_TABLE_HASH */
   /* remove from SNMP ARP index tree */
   mib2_remove_arp_entry(arp_table[i].netif, &arp_table[i].ipaddr);
   /* and empty packet queue */
@@ -280,6 +367,20 @@ etharp_find_entry(const ip4_addr_t *ipaddr, u8_t flags, struct netif *netif)
    *    until 5 matches, or all entries are searched for.
    */
 
+#if ETHARP_TABLE_HASH
+  /* 5) is answered by the index, the sweep is only needed to create entries */
+  if (ipaddr != NULL) {
+    i = etharp_hash_find(ipaddr, netif);
+    if (i >= 0) {
+      LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_find_entry: found matching entry %d\n", (int)i));
+      return i;
+    }
+  }
+  if ((flags & ETHARP_FLAG_FIND_ONLY) != 0) {
+    return (s16_t)ERR_MEM;
+  }
+#endif /* ETHARP_TABLE_HASH */
+
   for (i = 0; i < ARP_TABLE_SIZE; ++i) {
     u8_t state = arp_table[i].state;
     /* no empty entry found yet and now we do find one? */
@@ -287,6 +388,10 @@ etharp_find_entry(const ip4_addr_t *ipaddr, u8_t flags, struct netif *netif)
       LWIP_DEBUGF(ETHARP_DEBUG, ("etharp_find_entry: found empty entry %d\n", (int)i));
       /* remember first empty entry */
       empty = i;
+#if ETHARP_TABLE_HASH
+      /* no need to look for matches or recycling candidates any more */
+      break;
+#endif /* ETHARP_TABLE_HASH */
     } else if (state != ETHARP_STATE_EMPTY) {
       LWIP_ASSERT("state == ETHARP_STATE_PENDING || state >= ETHARP_STATE_STABLE",
                   state == ETHARP_STATE_PENDING || state >= ETHARP_STATE_STABLE);
@@ -392,6 +497,9 @@ etharp_find_entry(const ip4_addr_t *ipaddr, u8_t flags, struct netif *netif)
   if (ipaddr != NULL) {
     /* set IP address */
     ip4_addr_copy(arp_table[i].ipaddr, *ipaddr);
+#if ETHARP_TABLE_HASH
+    etharp_hash_add((netif_addr_idx_t)i);
+#endif /* ETHARP_TABLE_HASH */
   }
   arp_table[i].ctime = 0;
 #if ETHARP_TABLE_MATCH_NETIF
@@ -819,7 +927,14 @@ etharp_output(struct netif *netif, struct pbuf *q, const ip4_addr_t *ipaddr)
     dest = &mcastaddr;
     /* unicast destination IP address? */
   } else {
+#if ETHARP_TABLE_HASH
+    s16_t i;
+#if !LWIP_NETIF_HWADDRHINT
+    netif_addr_idx_t etharp_cached_entry = netif->arp_hint;
+#endif /* !LWIP_NETIF_HWADDRHINT */
+#else /* ETHARP_TABLE_HASH */
     netif_addr_idx_t i;
+#endif /* ETHARP_TABLE_HASH */
     /* outside local network? if so, this can neither be a global broadcast nor
        a subnet broadcast. */
     if (!ip4_addr_netcmp(ipaddr, netif_ip4_addr(netif), netif_ip4_netmask(netif)) &&
@@ -874,6 +989,14 @@ etharp_output(struct netif *netif, struct pbuf *q, const ip4_addr_t *ipaddr)
 
     /* find stable entry: do this here since this is a critical path for
        throughput and etharp_find_entry() is kind of slow */
+#if ETHARP_TABLE_HASH
+    i = etharp_hash_find(dst_addr, netif);
+    if ((i >= 0) && (arp_table[i].state >= ETHARP_STATE_STABLE)) {
+      /* found an existing, stable entry */
+      ETHARP_SET_ADDRHINT(netif, (netif_addr_idx_t)i);
+      return etharp_output_to_arp_index(netif, q, (netif_addr_idx_t)i);
+    }
+#else /* ETHARP_TABLE_HASH */
     for (i = 0; i < ARP_TABLE_SIZE; i++) {
       if ((arp_table[i].state >= ETHARP_STATE_STABLE) &&
 #if ETHARP_TABLE_MATCH_NETIF
@@ -885,6 +1008,7 @@ etharp_output(struct netif *netif, struct pbuf *q, const ip4_addr_t *ipaddr)
         return etharp_output_to_arp_index(netif, q, i);
       }
     }
+#endif /* ETHARP_TABLE_HASH */
     /* no stable entry found, use the (slower) query function:
        queue on destination Ethernet address belonging to ipaddr */
     return etharp_query(netif, dst_addr, q);
@@ -932,6 +932,12 @@ ip4_output_if_opt_src(struct pbuf *p, const ip4_addr_t *src, const ip4_addr_t *d
     chk_sum += iphdr->_id;
 #endif /* CHECKSUM_GEN_IP_INLINE */
     ++ip_id;
+#if TCP_TSO
+    if (p->tso_mss != 0) {
+      /* ip4_tso_output() numbers the frames of a super-segment consecutively */
+      ip_id = (u16_t)(ip_id + (p->tot_len - ip_hlen) / p->tso_mss);
+    }
+#endif /* TCP_TSO */
 
     if (src == NULL) {
       ip4_addr_copy(iphdr->src, *IP4_ADDR_ANY4);
@@ -996,6 +1002,16 @@ ip4_output_if_opt_src(struct pbuf *p, const ip4_addr_t *src, const ip4_addr_t *d
   }
 #endif /* LWIP_MULTICAST_TX_OPTIONS */
 #endif /* ENABLE_LOOPBACK */
+#if TCP_TSO
+  if (p->tso_mss != 0) {
+    if (!(netif->flags & NETIF_FLAG_TSO)) {
+      return ip4_tso_output(p, netif, dest);
+    }
+    /* the netif cuts super-segments itself, don't fragment them */
+    LWIP_DEBUGF(IP_DEBUG, ("ip4_output_if: call netif->output() for TSO\n"));
+    return netif->output(netif, p, dest);
+  }
+#endif /* TCP_TSO */
 #if IP_FRAG
   /* don't fragment if interface has mtu set to 0 [loopif] */
   if (netif->mtu && (p->tot_len > netif->mtu)) {
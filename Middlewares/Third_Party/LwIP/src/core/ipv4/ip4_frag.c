@@ -48,6 +48,9 @@
 #include "lwip/netif.h"
 #include "lwip/stats.h"
 #include "lwip/icmp.h"
+#include "lwip/sys.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/tcp.h"
 
 #include <string.h>
 
@@ -58,6 +61,8 @@
  * - fragments must not overlap (e.g. due to different routes),
  *   currently, overlapping or duplicate fragments are thrown away
  *   if IP_REASS_CHECK_OVERLAP=1 (the default)!
+ *   With IP_REASS_TREE=1, overlapping fragments are trimmed to the data
+ *   not received yet instead.
  *
  * @todo: work with IP header options
  */
@@ -82,6 +87,10 @@
 #define IP_REASS_VALIDATE_TELEGRAM_FINISHED  1
 #define IP_REASS_VALIDATE_PBUF_QUEUED        0
 #define IP_REASS_VALIDATE_PBUF_DROPPED       -1
+#if IP_REASS_TREE
+/* the fragment was not enqueued but its MF==0 completed the datagram */
+#define IP_REASS_VALIDATE_PBUF_DROPPED_FINISHED  2
+#endif /* IP_REASS_TREE */
 
 /** This is a helper struct which holds the starting
  * offset and the ending offset of this fragment to
@@ -95,16 +104,35 @@
 #  include "arch/bpstruct.h"
 #endif
 PACK_STRUCT_BEGIN
+#if IP_REASS_TREE
+/* In tree mode, next_pbuf/prev_pbuf are the right/left children in the splay
+ * tree (next_pbuf only links the list when the tree has been flattened).
+ * 'skip' bytes have been trimmed from the head of the fragment data, so the
+ * data starts at IP_HLEN + skip and the end is derived from p->tot_len. */
+struct ip_reass_helper {
+  PACK_STRUCT_FIELD(struct pbuf *next_pbuf);
+  PACK_STRUCT_FIELD(struct pbuf *prev_pbuf);
+  PACK_STRUCT_FIELD(u16_t start);
+  PACK_STRUCT_FIELD(u16_t skip);
+} PACK_STRUCT_STRUCT;
+#else /* IP_REASS_TREE */
 struct ip_reass_helper {
   PACK_STRUCT_FIELD(struct pbuf *next_pbuf);
   PACK_STRUCT_FIELD(u16_t start);
   PACK_STRUCT_FIELD(u16_t end);
 } PACK_STRUCT_STRUCT;
+#endif /* IP_REASS_TREE */
 PACK_STRUCT_END
 #ifdef PACK_STRUCT_USE_INCLUDES
 #  include "arch/epstruct.h"
 #endif
 
+#define IP_REASS_HELPER(p) ((struct ip_reass_helper *)(p)->payload)
+#if IP_REASS_TREE
+#define IP_REASS_HELPER_END(p) \
+  ((u16_t)(IP_REASS_HELPER(p)->start + (p)->tot_len - IP_HLEN - IP_REASS_HELPER(p)->skip))
+#endif /* IP_REASS_TREE */
+
 #define IP_ADDRESSES_AND_ID_MATCH(iphdrA, iphdrB)  \
   (ip4_addr_cmp(&(iphdrA)->src, &(iphdrB)->src) && \
    ip4_addr_cmp(&(iphdrA)->dest, &(iphdrB)->dest) && \
@@ -117,6 +145,9 @@ static u16_t ip_reass_pbufcount;
 /* function prototypes */
 static void ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev);
 static int ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev);
+#if IP_REASS_TREE
+static struct pbuf *ip_reass_tree_to_list(struct pbuf *root);
+#endif /* IP_REASS_TREE */
 
 /**
  * Reassembly timer base function
@@ -142,6 +173,7 @@ ip_reass_tmr(void)
       /* reassembly timed out */
       struct ip_reassdata *tmp;
       LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_tmr: timer timed out\n"));
+      IPREASS_STATS_INC(ip_reass.timeout);
       tmp = r;
       /* get the next pointer before freeing */
       r = r->next;
@@ -174,6 +206,9 @@ ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_reassdata *p
   }
 
   MIB2_STATS_INC(mib2.ipreasmfails);
+#if IP_REASS_TREE
+  ipr->p = ip_reass_tree_to_list(ipr->p);
+#endif /* IP_REASS_TREE */
 #if LWIP_ICMP
   iprh = (struct ip_reass_helper *)ipr->p->payload;
   if (iprh->start == 0) {
@@ -260,6 +295,7 @@ ip_reass_remove_oldest_datagram(struct ip_hdr *fraghdr, int pbufs_needed)
       r = r->next;
     }
     if (oldest != NULL) {
+      IPREASS_STATS_INC(ip_reass.evicted);
       pbufs_freed_current = ip_reass_free_complete_datagram(oldest, oldest_prev);
       pbufs_freed += pbufs_freed_current;
     }
@@ -299,6 +335,9 @@ ip_reass_enqueue_new_datagram(struct ip_hdr *fraghdr, int clen)
   }
   memset(ipr, 0, sizeof(struct ip_reassdata));
   ipr->timer = IP_REASS_MAXAGE;
+#if IPREASS_STATS
+  ipr->start_time = sys_now();
+#endif /* IPREASS_STATS */
 
   /* enqueue the new structure to the front of the list */
   ipr->next = reassdatagrams;
@@ -330,6 +369,275 @@ ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev)
   memp_free(MEMP_REASSDATA, ipr);
 }
 
+#if IP_REASS_TREE
+/**
+ * Top-down splay of a fragment tree: returns the new root, which is the
+ * fragment starting at 'start' or, if there is none, the last fragment
+ * visited before falling off the tree (its predecessor or successor).
+ */
+static struct pbuf *
+ip_reass_splay(struct pbuf *t, u16_t start)
+{
+  struct pbuf *l = NULL, *r = NULL, *l_tail = NULL, *r_tail = NULL;
+  struct pbuf *y;
+  struct ip_reass_helper *iprh;
+
+  if (t == NULL) {
+    return NULL;
+  }
+  for (;;) {
+    iprh = IP_REASS_HELPER(t);
+    if (start < iprh->start) {
+      y = iprh->prev_pbuf;
+      if (y == NULL) {
+        break;
+      }
+      if (start < IP_REASS_HELPER(y)->start) {
+        /* rotate right */
+        iprh->prev_pbuf = IP_REASS_HELPER(y)->next_pbuf;
+        IP_REASS_HELPER(y)->next_pbuf = t;
+        t = y;
+        iprh = IP_REASS_HELPER(t);
+        if (iprh->prev_pbuf == NULL) {
+          break;
+        }
+      }
+      /* link right */
+      if (r_tail == NULL) {
+        r = t;
+      } else {
+        IP_REASS_HELPER(r_tail)->prev_pbuf = t;
+      }
+      r_tail = t;
+      t = iprh->prev_pbuf;
+    } else if (start > iprh->start) {
+      y = iprh->next_pbuf;
+      if (y == NULL) {
+        break;
+      }
+      if (start > IP_REASS_HELPER(y)->start) {
+        /* rotate left */
+        iprh->next_pbuf = IP_REASS_HELPER(y)->prev_pbuf;
+        IP_REASS_HELPER(y)->prev_pbuf = t;
+        t = y;
+        iprh = IP_REASS_HELPER(t);
+        if (iprh->next_pbuf == NULL) {
+          break;
+        }
+      }
+      /* link left */
+      if (l_tail == NULL) {
+        l = t;
+      } else {
+        IP_REASS_HELPER(l_tail)->next_pbuf = t;
+      }
+      l_tail = t;
+      t = iprh->next_pbuf;
+    } else {
+      break;
+    }
+  }
+  /* assemble */
+  iprh = IP_REASS_HELPER(t);
+  if (l_tail != NULL) {
+    IP_REASS_HELPER(l_tail)->next_pbuf = iprh->prev_pbuf;
+    iprh->prev_pbuf = l;
+  }
+  if (r_tail != NULL) {
+    IP_REASS_HELPER(r_tail)->prev_pbuf = iprh->next_pbuf;
+    iprh->next_pbuf = r;
+  }
+  return t;
+}
+
+/**
+ * Flatten a fragment tree into a list sorted by offset and linked via
+ * next_pbuf (right rotations only, no recursion).
+ */
+static struct pbuf *
+ip_reass_tree_to_list(struct pbuf *root)
+{
+  struct pbuf *head = NULL, *tail = NULL, *l;
+  struct ip_reass_helper *iprh;
+
+  while (root != NULL) {
+    iprh = IP_REASS_HELPER(root);
+    l = iprh->prev_pbuf;
+    if (l != NULL) {
+      /* rotate right until the root has no left child */
+      iprh->prev_pbuf = IP_REASS_HELPER(l)->next_pbuf;
+      IP_REASS_HELPER(l)->next_pbuf = root;
+      root = l;
+    } else {
+      if (tail == NULL) {
+        head = root;
+      } else {
+        IP_REASS_HELPER(tail)->next_pbuf = root;
+      }
+      tail = root;
+      root = iprh->next_pbuf;
+    }
+  }
+  return head;
+}
+
+/** Free an enqueued fragment that has been trimmed away completely */
+static void
+ip_reass_free_frag(struct ip_reassdata *ipr, struct pbuf *q)
+{
+  u16_t clen = pbuf_clen(q);
+
+  LWIP_ASSERT("ip_reass_pbufcount >= clen", ip_reass_pbufcount >= clen);
+  LWIP_ASSERT("ipr->pbufs >= clen", ipr->pbufs >= clen);
+  ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount - clen);
+  ipr->pbufs = (u16_t)(ipr->pbufs - clen);
+  ipr->recvd = (u16_t)(ipr->recvd - (IP_REASS_HELPER_END(q) - IP_REASS_HELPER(q)->start));
+  pbuf_free(q);
+}
+
+/**
+ * Result for a fragment that is not enqueued because its data has been
+ * received already: an MF==0 duplicate may still be what completes the
+ * datagram.
+ */
+static int
+ip_reass_drop_duplicate(struct ip_reassdata *ipr)
+{
+  if (((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0) && (ipr->recvd == ipr->datagram_len)) {
+    ipr->p = ip_reass_tree_to_list(ipr->p);
+    return IP_REASS_VALIDATE_PBUF_DROPPED_FINISHED;
+  }
+  return IP_REASS_VALIDATE_PBUF_DROPPED;
+}
+
+/**
+ * Insert a new fragment into the splay tree of a datagram.
+ * Data already received wins: the new fragment is trimmed at its head and
+ * tail, and enqueued fragments it covers completely are freed.
+ * @param ipr points to the reassembly state
+ * @param new_p points to the pbuf for the current fragment
+ * @param is_last is 1 if this pbuf has MF==0 (ipr->flags not updated yet)
+ * @return see IP_REASS_VALIDATE_* defines
+ */
+static int
+ip_reass_chain_frag_into_datagram_and_validate(struct ip_reassdata *ipr, struct pbuf *new_p, int is_last)
+{
+  struct ip_reass_helper *iprh;
+  struct pbuf *l, *r, *q;
+  u16_t frag_offset, offset, len, end;
+  struct ip_hdr *fraghdr;
+
+  /* Extract length and fragment offset from current fragment */
+  fraghdr = (struct ip_hdr *)new_p->payload;
+  len = lwip_ntohs(IPH_LEN(fraghdr));
+  if ((IPH_HL_BYTES(fraghdr) != IP_HLEN) || (len <= IP_HLEN) || (new_p->tot_len != len)) {
+    /* invalid or empty fragment */
+    return IP_REASS_VALIDATE_PBUF_DROPPED;
+  }
+  len = (u16_t)(len - IP_HLEN);
+  frag_offset = IPH_OFFSET_BYTES(fraghdr);
+  offset = frag_offset;
+  end = (u16_t)(offset + len);
+  if (end < offset) {
+    /* u16_t overflow, cannot handle this */
+    return IP_REASS_VALIDATE_PBUF_DROPPED;
+  }
+
+  /* drop fragments contradicting the last fragment */
+  if ((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0) {
+    if ((end > ipr->datagram_len) || (is_last && (end != ipr->datagram_len))) {
+      return IP_REASS_VALIDATE_PBUF_DROPPED;
+    }
+  } else if (is_last && (ipr->max_end > end)) {
+    return IP_REASS_VALIDATE_PBUF_DROPPED;
+  }
+  if (is_last) {
+    /* record the length even if the data turns out to be a duplicate */
+    ipr->datagram_len = end;
+    ipr->flags |= IP_REASS_FLAG_LASTFRAG;
+  }
+
+  /* make sure the struct ip_reass_helper fits into the IP header */
+  LWIP_ASSERT("sizeof(struct ip_reass_helper) <= IP_HLEN",
+              sizeof(struct ip_reass_helper) <= IP_HLEN);
+
+  /* split the tree into fragments starting at or before 'offset' (l, its
+   * maximum at the root) and fragments starting after it (r, its minimum at
+   * the root) */
+  l = ip_reass_splay(ipr->p, offset);
+  r = NULL;
+  if (l != NULL) {
+    iprh = IP_REASS_HELPER(l);
+    if (iprh->start <= offset) {
+      r = ip_reass_splay(iprh->next_pbuf, 0);
+      iprh->next_pbuf = NULL;
+    } else {
+      r = l;
+      l = ip_reass_splay(iprh->prev_pbuf, 0xFFFF);
+      iprh->prev_pbuf = NULL;
+    }
+  }
+
+  /* trim the head against the predecessor */
+  if (l != NULL) {
+    u16_t l_end = IP_REASS_HELPER_END(l);
+    if (l_end > offset) {
+      IPREASS_STATS_INC(ip_reass.overlap);
+      if (l_end >= end) {
+        /* duplicate or completely covered: no need to keep the fragment */
+        IP_REASS_HELPER(l)->next_pbuf = r;
+        ipr->p = l;
+        return ip_reass_drop_duplicate(ipr);
+      }
+      offset = l_end;
+    }
+  }
+
+  /* free successors covered completely, trim the tail against the next one */
+  while (r != NULL) {
+    iprh = IP_REASS_HELPER(r);
+    if (iprh->start >= end) {
+      break;
+    }
+    IPREASS_STATS_INC(ip_reass.overlap);
+    if (IP_REASS_HELPER_END(r) > end) {
+      if (iprh->start <= offset) {
+        /* covered by predecessor and successor */
+        IP_REASS_HELPER(l)->next_pbuf = r;
+        ipr->p = l;
+        return ip_reass_drop_duplicate(ipr);
+      }
+      pbuf_realloc(new_p, (u16_t)(new_p->tot_len - (end - iprh->start)));
+      end = iprh->start;
+      break;
+    }
+    q = r;
+    r = ip_reass_splay(iprh->next_pbuf, 0);
+    ip_reass_free_frag(ipr, q);
+  }
+
+  /* overwrite the fragment's ip header with our helper struct: the new
+   * fragment becomes the root */
+  iprh = (struct ip_reass_helper *)new_p->payload;
+  iprh->prev_pbuf = l;
+  iprh->next_pbuf = r;
+  iprh->skip = (u16_t)(offset - frag_offset);
+  iprh->start = offset;
+  ipr->p = new_p;
+  ipr->recvd = (u16_t)(ipr->recvd + (end - offset));
+  if (end > ipr->max_end) {
+    ipr->max_end = end;
+  }
+
+  /* fragments never overlap and never exceed the last fragment, so the
+   * datagram is complete once the bytes received add up to its length */
+  if (((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0) && (ipr->recvd == ipr->datagram_len)) {
+    ipr->p = ip_reass_tree_to_list(ipr->p);
+    return IP_REASS_VALIDATE_TELEGRAM_FINISHED;
+  }
+  return IP_REASS_VALIDATE_PBUF_QUEUED;
+}
+#else /* IP_REASS_TREE */
 /**
  * Chain a new pbuf into the pbuf list that composes the datagram.  The pbuf list
  * will grow over time as  new pbufs are rx.
@@ -492,6 +800,24 @@ ip_reass_chain_frag_into_datagram_and_validate(struct ip_reassdata *ipr, struct
   /* If we come here, not all fragments were received, yet! */
   return IP_REASS_VALIDATE_PBUF_QUEUED; /* not yet valid! */
 }
+#endif /* IP_REASS_TREE */
+
+#if IP_REASS_MAX_PBUFS_PER_SRC < IP_REASS_MAX_PBUFS
+/** Count the pbufs enqueued for datagrams from the source of 'fraghdr' */
+static u16_t
+ip_reass_src_pbufcount(struct ip_hdr *fraghdr)
+{
+  struct ip_reassdata *r;
+  u16_t pbufs = 0;
+
+  for (r = reassdatagrams; r != NULL; r = r->next) {
+    if (ip4_addr_cmp(&r->iphdr.src, &fraghdr->src)) {
+      pbufs = (u16_t)(pbufs + r->pbufs);
+    }
+  }
+  return pbufs;
+}
+#endif /* IP_REASS_MAX_PBUFS_PER_SRC < IP_REASS_MAX_PBUFS */
 
 /**
  * Reassembles incoming IP fragments into an IP datagram.
@@ -533,6 +859,14 @@ ip4_reass(struct pbuf *p)
 
   /* Check if we are allowed to enqueue more datagrams. */
   clen = pbuf_clen(p);
+#if IP_REASS_MAX_PBUFS_PER_SRC < IP_REASS_MAX_PBUFS
+  if ((ip_reass_src_pbufcount(fraghdr) + clen) > IP_REASS_MAX_PBUFS_PER_SRC) {
+    /* don't let one source evict the datagrams of others */
+    LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: per-source limit reached\n"));
+    IPREASS_STATS_INC(ip_reass.quota);
+    goto nullreturn;
+  }
+#endif /* IP_REASS_MAX_PBUFS_PER_SRC < IP_REASS_MAX_PBUFS */
   if ((ip_reass_pbufcount + clen) > IP_REASS_MAX_PBUFS) {
 #if IP_REASS_FREE_OLDEST
     if (!ip_reass_remove_oldest_datagram(fraghdr, clen) ||
@@ -594,17 +928,29 @@ ip4_reass(struct pbuf *p)
     }
   }
   /* find the right place to insert this pbuf */
-  /* @todo: trim pbufs if fragments are overlapping */
   valid = ip_reass_chain_frag_into_datagram_and_validate(ipr, p, is_last);
   if (valid == IP_REASS_VALIDATE_PBUF_DROPPED) {
     goto nullreturn_ipr;
   }
+#if IP_REASS_TREE
+  if (valid == IP_REASS_VALIDATE_PBUF_DROPPED_FINISHED) {
+    /* the duplicate is not needed, but the datagram is complete now */
+    pbuf_free(p);
+    clen = 0;
+    valid = IP_REASS_VALIDATE_TELEGRAM_FINISHED;
+  } else {
+    /* the pbuf has been enqueued; trimming its tail may have freed pbufs */
+    clen = pbuf_clen(p);
+  }
+#else /* IP_REASS_TREE */
   /* if we come here, the pbuf has been enqueued */
+#endif /* IP_REASS_TREE */
 
   /* Track the current number of pbufs current 'in-flight', in order to limit
      the number of fragments that may be enqueued at any one time
      (overflow checked by testing against IP_REASS_MAX_PBUFS) */
   ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount + clen);
+  ipr->pbufs = (u16_t)(ipr->pbufs + clen);
   if (is_last) {
     u16_t datagram_len = (u16_t)(offset + len);
     ipr->datagram_len = datagram_len;
@@ -640,12 +986,19 @@ ip4_reass(struct pbuf *p)
 
     /* chain together the pbufs contained within the reass_data list. */
     while (r != NULL) {
+      struct pbuf *next;
       iprh = (struct ip_reass_helper *)r->payload;
+      next = iprh->next_pbuf;
 
       /* hide the ip header for every succeeding fragment */
+#if IP_REASS_TREE
+      /* and the data trimmed from its head */
+      r = pbuf_free_header(r, (u16_t)(IP_HLEN + iprh->skip));
+#else /* IP_REASS_TREE */
       pbuf_remove_header(r, IP_HLEN);
+#endif /* IP_REASS_TREE */
       pbuf_cat(p, r);
-      r = iprh->next_pbuf;
+      r = next;
     }
 
     /* find the previous entry in the linked list */
@@ -659,14 +1012,25 @@ ip4_reass(struct pbuf *p)
       }
     }
 
-    /* release the sources allocate for the fragment queue entry */
-    ip_reass_dequeue_datagram(ipr, ipr_prev);
-
-    /* and adjust the number of pbufs currently queued for reassembly. */
-    clen = pbuf_clen(p);
+    /* adjust the number of pbufs currently queued for reassembly. */
+    clen = ipr->pbufs;
     LWIP_ASSERT("ip_reass_pbufcount >= clen", ip_reass_pbufcount >= clen);
     ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount - clen);
 
+#if IPREASS_STATS
+    {
+      u32_t latency = sys_now() - ipr->start_time;
+      IPREASS_STATS_INC(ip_reass.completed);
+      lwip_stats.ip_reass.latency_total += latency;
+      if (latency > lwip_stats.ip_reass.latency_max) {
+        lwip_stats.ip_reass.latency_max = latency;
+      }
+    }
+#endif /* IPREASS_STATS */
+
+    /* release the sources allocate for the fragment queue entry */
+    ip_reass_dequeue_datagram(ipr, ipr_prev);
+
     MIB2_STATS_INC(mib2.ipreasmoks);
 
     /* Return the pbuf chain */
@@ -692,7 +1056,7 @@ nullreturn:
 }
 #endif /* IP_REASSEMBLY */
 
-#if IP_FRAG
+#if IP_FRAG || TCP_TSO
 #if !LWIP_NETIF_TX_SINGLE_PBUF
 /** Allocate a new struct pbuf_custom_ref */
 static struct pbuf_custom_ref *
@@ -723,7 +1087,9 @@ ipfrag_free_pbuf_custom(struct pbuf *p)
   ip_frag_free_pbuf_custom_ref(pcr);
 }
 #endif /* !LWIP_NETIF_TX_SINGLE_PBUF */
+#endif /* IP_FRAG || TCP_TSO */
 
+#if IP_FRAG
 /**
  * Fragment an IP datagram if too large for the netif.
  *
@@ -891,4 +1257,177 @@ memerr:
 }
 #endif /* IP_FRAG */
 
+#if TCP_TSO
+/**
+ * Cut a TCP super-segment (p->tso_mss != 0) into frames carrying p->tso_mss
+ * bytes of payload and send them in order.
+ *
+ * Every frame gets a copy of the IP and TCP headers, the payload is mirrored
+ * by PBUF_REFs into p (as in ip4_frag()). The IP id counts up per frame
+ * (ip4_output_if() reserved the range), the sequence number advances and
+ * PSH/FIN are only kept on the last frame. The TCP header is summed once;
+ * per frame only length, sequence number, flags and payload are added.
+ *
+ * @param p ip packet to send, IP and TCP header in the first pbuf
+ * @param netif the netif on which to send
+ * @param dest destination ip address to which to send
+ *
+ * @return ERR_OK if sent successfully, err_t otherwise
+ */
+err_t
+ip4_tso_output(struct pbuf *p, struct netif *netif, const ip4_addr_t *dest)
+{
+  struct pbuf *rambuf;
+#if !LWIP_NETIF_TX_SINGLE_PBUF
+  struct pbuf *newpbuf;
+  u16_t newpbuflen = 0;
+  u16_t left_to_copy;
+#endif
+  const struct ip_hdr *original_iphdr;
+  const struct tcp_hdr *original_tcphdr;
+  struct ip_hdr *iphdr;
+  struct tcp_hdr *tcphdr;
+  const u16_t mss = p->tso_mss;
+  u16_t iphlen, tcphlen, left, framesize, id, poff;
+  u8_t flags;
+  u32_t seqno;
+#if CHECKSUM_GEN_TCP
+  u32_t hdrsum, acc;
+#endif /* CHECKSUM_GEN_TCP */
+
+  LWIP_ASSERT("p->tso_mss != 0", mss != 0);
+  original_iphdr = (const struct ip_hdr *)p->payload;
+  iphlen = IPH_HL_BYTES(original_iphdr);
+  LWIP_ERROR("ip4_tso_output(): pbuf too short", p->len >= iphlen + TCP_HLEN, return ERR_VAL);
+  original_tcphdr = (const struct tcp_hdr *)((const u8_t *)p->payload + iphlen);
+  tcphlen = TCPH_HDRLEN_BYTES(original_tcphdr);
+  LWIP_ERROR("ip4_tso_output(): headers not in first pbuf", p->len >= iphlen + tcphlen, return ERR_VAL);
+
+  id = lwip_ntohs(IPH_ID(original_iphdr));
+  seqno = lwip_ntohl(original_tcphdr->seqno);
+  flags = TCPH_FLAGS(original_tcphdr);
+#if CHECKSUM_GEN_TCP
+  /* pseudo header without length plus the TCP header without the fields
+     that change per frame (sequence number, flags and the checksum itself) */
+  hdrsum = (u16_t)~inet_chksum(&original_iphdr->src, 2 * sizeof(ip4_addr_p_t));
+  hdrsum += PP_HTONS(IP_PROTO_TCP);
+  hdrsum += (u16_t)~inet_chksum(original_tcphdr, tcphlen);
+  hdrsum += (u16_t)~original_tcphdr->chksum;
+  hdrsum += (u16_t)~(original_tcphdr->seqno & 0xFFFFUL);
+  hdrsum += (u16_t)~(original_tcphdr->seqno >> 16);
+  hdrsum += (u16_t)~original_tcphdr->_hdrlen_rsvd_flags;
+  hdrsum = FOLD_U32T(hdrsum);
+#endif /* CHECKSUM_GEN_TCP */
+
+  poff = (u16_t)(iphlen + tcphlen);
+  left = (u16_t)(p->tot_len - poff);
+
+  while (left) {
+    framesize = LWIP_MIN(left, mss);
+
+#if LWIP_NETIF_TX_SINGLE_PBUF
+    rambuf = pbuf_alloc(PBUF_LINK, (u16_t)(iphlen + tcphlen + framesize), PBUF_RAM);
+    if (rambuf == NULL) {
+      goto memerr;
+    }
+    LWIP_ASSERT("this needs a pbuf in one piece!",
+                (rambuf->len == rambuf->tot_len) && (rambuf->next == NULL));
+    MEMCPY(rambuf->payload, original_iphdr, iphlen + tcphlen);
+    poff = (u16_t)(poff + pbuf_copy_partial(p, (u8_t *)rambuf->payload + iphlen + tcphlen, framesize, poff));
+#else /* LWIP_NETIF_TX_SINGLE_PBUF */
+    /* The first pbuf is a PBUF_RAM holding the link, IP and TCP header,
+     * the rest are PBUF_REFs mirroring up to mss bytes of the payload.
+     */
+    rambuf = pbuf_alloc(PBUF_LINK, (u16_t)(iphlen + tcphlen), PBUF_RAM);
+    if (rambuf == NULL) {
+      goto memerr;
+    }
+    MEMCPY(rambuf->payload, original_iphdr, iphlen + tcphlen);
+
+    left_to_copy = framesize;
+    while (left_to_copy) {
+      struct pbuf_custom_ref *pcr;
+      u16_t plen = (u16_t)(p->len - poff);
+      LWIP_ASSERT("p->len >= poff", p->len >= poff);
+      newpbuflen = LWIP_MIN(left_to_copy, plen);
+      /* Is this pbuf already empty? */
+      if (!newpbuflen) {
+        poff = 0;
+        p = p->next;
+        continue;
+      }
+      pcr = ip_frag_alloc_pbuf_custom_ref();
+      if (pcr == NULL) {
+        pbuf_free(rambuf);
+        goto memerr;
+      }
+      newpbuf = pbuf_alloced_custom(PBUF_RAW, newpbuflen, PBUF_REF, &pcr->pc,
+                                    (u8_t *)p->payload + poff, newpbuflen);
+      if (newpbuf == NULL) {
+        ip_frag_free_pbuf_custom_ref(pcr);
+        pbuf_free(rambuf);
+        goto memerr;
+      }
+      pbuf_ref(p);
+      pcr->original = p;
+      pcr->pc.custom_free_function = ipfrag_free_pbuf_custom;
+      pbuf_cat(rambuf, newpbuf);
+      left_to_copy = (u16_t)(left_to_copy - newpbuflen);
+      if (left_to_copy) {
+        poff = 0;
+        p = p->next;
+      }
+    }
+    poff = (u16_t)(poff + newpbuflen);
+#endif /* LWIP_NETIF_TX_SINGLE_PBUF */
+
+    iphdr = (struct ip_hdr *)rambuf->payload;
+    tcphdr = (struct tcp_hdr *)((u8_t *)rambuf->payload + iphlen);
+
+    /* Correct the TCP header */
+    tcphdr->seqno = lwip_htonl(seqno);
+    if (left > framesize) {
+      TCPH_FLAGS_SET(tcphdr, flags & ~(TCP_PSH | TCP_FIN));
+    }
+    tcphdr->chksum = 0;
+#if CHECKSUM_GEN_TCP
+    IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_TCP) {
+      acc = hdrsum + lwip_htons((u16_t)(tcphlen + framesize));
+      acc += tcphdr->seqno & 0xFFFFUL;
+      acc += tcphdr->seqno >> 16;
+      acc += tcphdr->_hdrlen_rsvd_flags;
+#if LWIP_NETIF_TX_SINGLE_PBUF
+      acc += (u16_t)~inet_chksum((u8_t *)rambuf->payload + iphlen + tcphlen, framesize);
+#else /* LWIP_NETIF_TX_SINGLE_PBUF */
+      acc += (u16_t)~inet_chksum_pbuf(rambuf->next);
+#endif /* LWIP_NETIF_TX_SINGLE_PBUF */
+      acc = FOLD_U32T(acc);
+      acc = FOLD_U32T(acc);
+      tcphdr->chksum = (u16_t)~acc;
+    }
+#endif /* CHECKSUM_GEN_TCP */
+
+    /* Correct the IP header */
+    IPH_LEN_SET(iphdr, lwip_htons((u16_t)(iphlen + tcphlen + framesize)));
+    IPH_ID_SET(iphdr, lwip_htons(id));
+    IPH_CHKSUM_SET(iphdr, 0);
+#if CHECKSUM_GEN_IP
+    IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_IP) {
+      IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, iphlen));
+    }
+#endif /* CHECKSUM_GEN_IP */
+
+    netif->output(netif, rambuf, dest);
+    pbuf_free(rambuf);
+
+    left = (u16_t)(left - framesize);
+    seqno += framesize;
+    id++;
+  }
+  return ERR_OK;
+memerr:
+  return ERR_MEM;
+}
+#endif /* TCP_TSO */
+
 #endif /* LWIP_IPV4 */
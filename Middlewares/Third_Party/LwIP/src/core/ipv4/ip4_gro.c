@@ -0,0 +1,364 @@
+/**
+ * @file
+ * IPv4 receive segment coalescing for TCP (software GRO)
+ *
+ * In-order TCP segments of the same flow that arrive in one receive batch are
+ * merged into a single packet (one IP and TCP header followed by the chained
+ * payloads of all segments), so IP and TCP input processing runs once per
+ * batch instead of once per segment.
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_IPV4 && IP_GRO /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/ip4_gro.h"
+#include "lwip/ip4.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/def.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/tcp.h"
+
+#include <string.h>
+
+#if IP_GRO_MAX_SEGS > 255
+#error "IP_GRO_MAX_SEGS must fit into an u8_t"
+#endif
+
+/** A TCP flow whose segments are being merged */
+struct ip4_gro_flow {
+  /** the merged packet (IP header at payload), NULL if the slot is unused */
+  struct pbuf *p;
+  struct netif *netif;
+  /** sequence number the next segment must have to be merged */
+  u32_t seqno;
+  /** payload length of the first segment, a shorter segment ends the flow */
+  u16_t mss;
+  /** TCP payload length merged so far */
+  u16_t len;
+  /** number of segments merged so far */
+  u8_t segs;
+#if CHECKSUM_CHECK_TCP
+  /** one's complement sum of the merged payload */
+  u32_t chksum;
+#endif /* CHECKSUM_CHECK_TCP */
+};
+
+static struct ip4_gro_flow ip4_gro_flows[IP_GRO_MAX_FLOWS];
+/** next slot to flush if all slots are in use */
+static u8_t ip4_gro_evict;
+
+#define IP4_GRO_TCPHDR(iphdr) ((struct tcp_hdr *)((u8_t *)(iphdr) + IP_HLEN))
+
+#if CHECKSUM_CHECK_TCP
+/** Sum of the pseudo header and the TCP header of a segment with 'len' bytes
+ * of payload */
+static u32_t
+ip4_gro_hdr_sum(const struct ip_hdr *iphdr, const struct tcp_hdr *tcphdr, u16_t tcphlen, u16_t len)
+{
+  u32_t acc, addr;
+
+  addr = ip4_addr_get_u32(&iphdr->src);
+  acc = (addr & 0xffffUL) + ((addr >> 16) & 0xffffUL);
+  addr = ip4_addr_get_u32(&iphdr->dest);
+  acc += (addr & 0xffffUL) + ((addr >> 16) & 0xffffUL);
+  acc += (u32_t)lwip_htons((u16_t)IP_PROTO_TCP);
+  acc += (u32_t)lwip_htons((u16_t)(tcphlen + len));
+  acc += (u16_t)~inet_chksum(tcphdr, tcphlen);
+  return acc;
+}
+
+/** Sum of the payload of a segment, derived from its headers only: if the
+ * checksum is correct, the sum over the whole segment is 0xffff. If it is not,
+ * the checksum computed for the merged packet does not match its data either,
+ * so tcp_input() still drops it. This way, the payload is only summed once
+ * (by tcp_input). */
+static u16_t
+ip4_gro_data_sum(const struct ip_hdr *iphdr, const struct tcp_hdr *tcphdr, u16_t tcphlen, u16_t len)
+{
+  u32_t acc = ip4_gro_hdr_sum(iphdr, tcphdr, tcphlen, len);
+  acc = FOLD_U32T(acc);
+  acc = FOLD_U32T(acc);
+  return (u16_t)~acc;
+}
+#endif /* CHECKSUM_CHECK_TCP */
+
+/** Pass the merged packet of a flow to ip4_input() and free the slot */
+static void
+ip4_gro_flush_flow(struct ip4_gro_flow *flow)
+{
+  struct pbuf *p = flow->p;
+  struct netif *netif = flow->netif;
+
+  flow->p = NULL;
+  if (flow->segs > 1) {
+    struct ip_hdr *iphdr = (struct ip_hdr *)p->payload;
+    struct tcp_hdr *tcphdr = IP4_GRO_TCPHDR(iphdr);
+    u16_t tcphlen = TCPH_HDRLEN_BYTES(tcphdr);
+
+    LWIP_DEBUGF(IP_DEBUG | LWIP_DBG_TRACE, ("ip4_gro: merged %"U16_F" segments, %"U16_F" bytes\n",
+                                            (u16_t)flow->segs, flow->len));
+    IPH_LEN_SET(iphdr, lwip_htons((u16_t)(IP_HLEN + tcphlen + flow->len)));
+#if CHECKSUM_CHECK_IP
+    IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_CHECK_IP) {
+      IPH_CHKSUM_SET(iphdr, 0);
+      IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+    }
+#endif /* CHECKSUM_CHECK_IP */
+#if CHECKSUM_CHECK_TCP
+    IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_CHECK_TCP) {
+      u32_t acc;
+      tcphdr->chksum = 0;
+      acc = ip4_gro_hdr_sum(iphdr, tcphdr, tcphlen, flow->len) + flow->chksum;
+      acc = FOLD_U32T(acc);
+      acc = FOLD_U32T(acc);
+      tcphdr->chksum = (u16_t)~acc;
+    }
+#endif /* CHECKSUM_CHECK_TCP */
+  }
+  ip4_input(p, netif);
+}
+
+/** Check whether 'flow' holds segments of the connection 'iphdr' belongs to */
+static int
+ip4_gro_match(const struct ip4_gro_flow *flow, const struct ip_hdr *iphdr, struct netif *inp)
+{
+  const struct ip_hdr *fiphdr = (const struct ip_hdr *)flow->p->payload;
+  const struct tcp_hdr *ftcphdr = IP4_GRO_TCPHDR(fiphdr);
+  const struct tcp_hdr *tcphdr = IP4_GRO_TCPHDR(iphdr);
+
+  return (flow->netif == inp) &&
+         ip4_addr_cmp(&fiphdr->src, &iphdr->src) &&
+         ip4_addr_cmp(&fiphdr->dest, &iphdr->dest) &&
+         (ftcphdr->src == tcphdr->src) &&
+         (ftcphdr->dest == tcphdr->dest);
+}
+
+/** Check whether 'dest' is the address of one of our netifs (the receiving one
+ * first): only segments addressed to us are merged, forwarded segments must
+ * leave the way they came in */
+static int
+ip4_gro_is_local(const ip4_addr_t *dest, struct netif *inp)
+{
+  struct netif *netif;
+
+  if (ip4_addr_cmp(dest, netif_ip4_addr(inp))) {
+    return !ip4_addr_isany_val(*netif_ip4_addr(inp));
+  }
+  NETIF_FOREACH(netif) {
+    if ((netif != inp) && netif_is_up(netif) &&
+        !ip4_addr_isany_val(*netif_ip4_addr(netif)) &&
+        ip4_addr_cmp(dest, netif_ip4_addr(netif))) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/** Check whether a segment of the flow's connection directly continues it and
+ * differs in nothing but sequence number and payload */
+static int
+ip4_gro_can_merge(const struct ip4_gro_flow *flow, const struct ip_hdr *iphdr, u16_t tcphlen, u16_t len)
+{
+  const struct ip_hdr *fiphdr = (const struct ip_hdr *)flow->p->payload;
+  const struct tcp_hdr *ftcphdr = IP4_GRO_TCPHDR(fiphdr);
+  const struct tcp_hdr *tcphdr = IP4_GRO_TCPHDR(iphdr);
+
+  return (lwip_ntohl(tcphdr->seqno) == flow->seqno) &&
+         (len <= flow->mss) &&
+         ((u32_t)IP_HLEN + tcphlen + flow->len + len <= 0xFFFF) &&
+         (tcphdr->ackno == ftcphdr->ackno) &&
+         (tcphdr->wnd == ftcphdr->wnd) &&
+         (TCPH_HDRLEN_BYTES(ftcphdr) == tcphlen) &&
+         (memcmp(ftcphdr + 1, tcphdr + 1, (size_t)(tcphlen - TCP_HLEN)) == 0) &&
+         (IPH_TOS(fiphdr) == IPH_TOS(iphdr)) &&
+         (IPH_TTL(fiphdr) == IPH_TTL(iphdr));
+}
+
+/**
+ * Receive an IPv4 packet: in-order TCP data segments are held back and merged
+ * with the following segments of the same connection, everything else is
+ * passed to ip4_input() directly (after the held segments of its connection,
+ * so that the order within a connection is kept).
+ * Held segments are passed on by ip4_gro_flush().
+ *
+ * @param p the received IP packet (p->payload points to the IP header)
+ * @param inp the netif on which this packet was received
+ * @return ERR_OK (the packet is always taken over, like ip4_input() does)
+ */
+err_t
+ip4_gro_input(struct pbuf *p, struct netif *inp)
+{
+  struct ip_hdr *iphdr;
+  struct tcp_hdr *tcphdr;
+  struct ip4_gro_flow *flow = NULL;
+  ip4_addr_t dest;
+  u16_t iplen, tcphlen, len;
+  u8_t flags;
+  int hdr_ok = 1;
+  int i;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  /* only TCP without IP options or fragmentation, headers in the first pbuf */
+  if (p->len < IP_HLEN + TCP_HLEN) {
+    return ip4_input(p, inp);
+  }
+  iphdr = (struct ip_hdr *)p->payload;
+  if ((IPH_V(iphdr) != 4) || (IPH_HL_BYTES(iphdr) != IP_HLEN) ||
+      (IPH_PROTO(iphdr) != IP_PROTO_TCP) ||
+      ((IPH_OFFSET(iphdr) & PP_HTONS(IP_OFFMASK | IP_MF)) != 0)) {
+    return ip4_input(p, inp);
+  }
+
+  for (i = 0; i < IP_GRO_MAX_FLOWS; i++) {
+    if ((ip4_gro_flows[i].p != NULL) && ip4_gro_match(&ip4_gro_flows[i], iphdr, inp)) {
+      flow = &ip4_gro_flows[i];
+      break;
+    }
+  }
+
+  tcphdr = IP4_GRO_TCPHDR(iphdr);
+  iplen = lwip_ntohs(IPH_LEN(iphdr));
+  tcphlen = TCPH_HDRLEN_BYTES(tcphdr);
+  flags = TCPH_FLAGS(tcphdr);
+#if CHECKSUM_CHECK_IP
+  IF__NETIF_CHECKSUM_ENABLED(inp, NETIF_CHECKSUM_CHECK_IP) {
+    hdr_ok = (inet_chksum(iphdr, IP_HLEN) == 0);
+  }
+#endif /* CHECKSUM_CHECK_IP */
+  if (!hdr_ok || (tcphlen < TCP_HLEN) || (p->len < IP_HLEN + tcphlen) ||
+      (iplen <= IP_HLEN + tcphlen) || (iplen > p->tot_len) ||
+      ((flags & (u8_t)~TCP_PSH) != TCP_ACK)) {
+    /* no data, control flags or invalid: don't merge, but keep the order */
+    if (flow != NULL) {
+      ip4_gro_flush_flow(flow);
+    }
+    return ip4_input(p, inp);
+  }
+  len = (u16_t)(iplen - IP_HLEN - tcphlen);
+  if (p->tot_len > iplen) {
+    /* remove link layer padding */
+    pbuf_realloc(p, iplen);
+  }
+
+  if (flow != NULL) {
+    if (ip4_gro_can_merge(flow, iphdr, tcphlen, len)) {
+      struct pbuf *q;
+#if CHECKSUM_CHECK_TCP
+      u16_t sum = ip4_gro_data_sum(iphdr, tcphdr, tcphlen, len);
+      /* payload at an odd offset contributes byte-swapped */
+      flow->chksum += (flow->len & 1) ? (u16_t)(SWAP_BYTES_IN_WORD(sum)) : sum;
+#endif /* CHECKSUM_CHECK_TCP */
+      flow->seqno += len;
+      flow->len = (u16_t)(flow->len + len);
+      flow->segs++;
+      /* chain the payload only */
+      q = pbuf_free_header(p, (u16_t)(IP_HLEN + tcphlen));
+      pbuf_cat(flow->p, q);
+      if ((flags & TCP_PSH) || (len < flow->mss) || (flow->segs >= IP_GRO_MAX_SEGS)) {
+        ip4_gro_flush_flow(flow);
+      }
+      return ERR_OK;
+    }
+    ip4_gro_flush_flow(flow);
+  }
+  ip4_addr_copy(dest, iphdr->dest);
+  if ((flags & TCP_PSH) || !ip4_gro_is_local(&dest, inp)) {
+    /* nothing to merge this with, or not for us */
+    return ip4_input(p, inp);
+  }
+
+  /* start a new flow with this segment */
+  if (flow == NULL) {
+    for (i = 0; i < IP_GRO_MAX_FLOWS; i++) {
+      if (ip4_gro_flows[i].p == NULL) {
+        flow = &ip4_gro_flows[i];
+        break;
+      }
+    }
+    if (flow == NULL) {
+      flow = &ip4_gro_flows[ip4_gro_evict];
+      ip4_gro_evict = (u8_t)((ip4_gro_evict + 1) % IP_GRO_MAX_FLOWS);
+      ip4_gro_flush_flow(flow);
+    }
+  }
+  flow->p = p;
+  flow->netif = inp;
+  flow->seqno = lwip_ntohl(tcphdr->seqno) + len;
+  flow->mss = len;
+  flow->len = len;
+  flow->segs = 1;
+#if CHECKSUM_CHECK_TCP
+  flow->chksum = ip4_gro_data_sum(iphdr, tcphdr, tcphlen, len);
+#endif /* CHECKSUM_CHECK_TCP */
+  return ERR_OK;
+}
+
+/**
+ * Pass all segments held back by ip4_gro_input() on to ip4_input().
+ * Called by tcpip_thread after each batch of received packets; with NO_SYS=1,
+ * call it after each round of passing received packets to netif->input().
+ */
+void
+ip4_gro_flush(void)
+{
+  int i;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  for (i = 0; i < IP_GRO_MAX_FLOWS; i++) {
+    if (ip4_gro_flows[i].p != NULL) {
+      ip4_gro_flush_flow(&ip4_gro_flows[i]);
+    }
+  }
+}
+
+/**
+ * Pass the segments received on 'netif' on to ip4_input(), e.g. before the
+ * netif is removed.
+ */
+void
+ip4_gro_flush_netif(struct netif *netif)
+{
+  int i;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  for (i = 0; i < IP_GRO_MAX_FLOWS; i++) {
+    if ((ip4_gro_flows[i].p != NULL) && (ip4_gro_flows[i].netif == netif)) {
+      ip4_gro_flush_flow(&ip4_gro_flows[i]);
+    }
+  }
+}
+
+#endif /* LWIP_IPV4 && IP_GRO */
@@ -93,6 +93,80 @@ const struct memp_desc *const memp_pools[MEMP_MAX] = {
 #define MEMP_OVERFLOW_CHECK 1
 #endif
 
+#if MEMP_LOCKFREE
+/* Size of one element including the overflow check regions */
+#if MEMP_OVERFLOW_CHECK
+#define MEMP_ELEMENT_SIZE(desc) (MEMP_SIZE + (desc)->size + MEM_SANITY_REGION_AFTER_ALIGNED)
+#else /* MEMP_OVERFLOW_CHECK */
+#define MEMP_ELEMENT_SIZE(desc) (MEMP_SIZE + (desc)->size)
+#endif /* MEMP_OVERFLOW_CHECK */
+
+#define MEMP_LOCKFREE_IDX(head)       ((u16_t)((head) & 0xFFFFU))
+#define MEMP_LOCKFREE_HEAD(idx, tag)  ((((u32_t)(tag) & 0xFFFFU) << 16) | (u32_t)(idx))
+#define MEMP_LOCKFREE_NEXT_TAG(head)  (((head) >> 16) + 1)
+#define MEMP_HEAD_IS_EMPTY(head)      (MEMP_LOCKFREE_IDX(head) == MEMP_LOCKFREE_NIL)
+
+static struct memp *
+memp_lockfree_element(const struct memp_desc *desc, u16_t idx)
+{
+  if (idx == MEMP_LOCKFREE_NIL) {
+    return NULL;
+  }
+  return (struct memp *)(void *)((u8_t *)LWIP_MEM_ALIGN(desc->base) + (size_t)idx * MEMP_ELEMENT_SIZE(desc));
+}
+
+static u16_t
+memp_lockfree_index(const struct memp_desc *desc, const struct memp *memp)
+{
+  if (memp == NULL) {
+    return MEMP_LOCKFREE_NIL;
+  }
+  return (u16_t)((size_t)((const u8_t *)memp - (const u8_t *)LWIP_MEM_ALIGN(desc->base)) / MEMP_ELEMENT_SIZE(desc));
+}
+
+/**
+ * Take the first element off a lock-free free list (Treiber stack).
+ * Reading memp->next may race with another thread taking the same element,
+ * but then the tag of the head has changed and the compare-and-swap fails.
+ */
+static struct memp *
+memp_lockfree_pop(const struct memp_desc *desc)
+{
+  memp_head_t head, next;
+  struct memp *memp;
+
+  do {
+    head = *desc->tab;
+    memp = memp_lockfree_element(desc, MEMP_LOCKFREE_IDX(head));
+    if (memp == NULL) {
+      return NULL;
+    }
+    next = MEMP_LOCKFREE_HEAD(memp_lockfree_index(desc, memp->next), MEMP_LOCKFREE_NEXT_TAG(head));
+  } while (!SYS_ARCH_CAS_U32(desc->tab, head, next));
+
+  return memp;
+}
+
+/**
+ * Put an element on top of a lock-free free list.
+ */
+static void
+memp_lockfree_push(const struct memp_desc *desc, struct memp *memp)
+{
+  memp_head_t head;
+  u16_t idx = memp_lockfree_index(desc, memp);
+
+  LWIP_ASSERT("memp_free: element belongs to pool",
+              (idx < desc->num) && (memp_lockfree_element(desc, idx) == memp));
+  do {
+    head = *desc->tab;
+    memp->next = memp_lockfree_element(desc, MEMP_LOCKFREE_IDX(head));
+  } while (!SYS_ARCH_CAS_U32(desc->tab, head, MEMP_LOCKFREE_HEAD(idx, MEMP_LOCKFREE_NEXT_TAG(head))));
+}
+#else /* MEMP_LOCKFREE */
+#define MEMP_HEAD_IS_EMPTY(head)      ((head) == NULL)
+#endif /* MEMP_LOCKFREE */
+
 #if MEMP_SANITY_CHECK && !MEMP_MEM_MALLOC
 /**
  * Check that memp-lists don't form a circle, using "Floyd's cycle-finding algorithm".
@@ -180,7 +254,12 @@ memp_init_pool(const struct memp_desc *desc)
   int i;
   struct memp *memp;
 
+#if MEMP_LOCKFREE
+  LWIP_ASSERT("memp_init_pool: too many elements for MEMP_LOCKFREE", desc->num < MEMP_LOCKFREE_NIL);
+  *desc->tab = MEMP_LOCKFREE_HEAD(MEMP_LOCKFREE_NIL, 0);
+#else /* MEMP_LOCKFREE */
   *desc->tab = NULL;
+#endif /* MEMP_LOCKFREE */
   memp = (struct memp *)LWIP_MEM_ALIGN(desc->base);
 #if MEMP_MEM_INIT
   /* force memset on pool memory */
@@ -192,8 +271,12 @@ memp_init_pool(const struct memp_desc *desc)
 #endif
   /* create a linked list of memp elements */
   for (i = 0; i < desc->num; ++i) {
+#if MEMP_LOCKFREE
+    memp_lockfree_push(desc, memp);
+#else /* MEMP_LOCKFREE */
     memp->next = *desc->tab;
     *desc->tab = memp;
+#endif /* MEMP_LOCKFREE */
 #if MEMP_OVERFLOW_CHECK
     memp_overflow_init_element(memp, desc);
 #endif /* MEMP_OVERFLOW_CHECK */
@@ -248,6 +331,35 @@ do_memp_malloc_pool_fn(const struct memp_desc *desc, const char *file, const int
 #endif
 {
   struct memp *memp;
+
+#if MEMP_LOCKFREE
+  memp = memp_lockfree_pop(desc);
+  if (memp != NULL) {
+#if MEMP_OVERFLOW_CHECK == 1
+    memp_overflow_check_element(memp, desc);
+#endif /* MEMP_OVERFLOW_CHECK */
+#if MEMP_OVERFLOW_CHECK
+    memp->next = NULL;
+    memp->file = file;
+    memp->line = line;
+#endif /* MEMP_OVERFLOW_CHECK */
+    LWIP_ASSERT("memp_malloc: memp properly aligned",
+                ((mem_ptr_t)memp % MEM_ALIGNMENT) == 0);
+#if MEMP_STATS
+    desc->stats->used++;
+    if (desc->stats->used > desc->stats->max) {
+      desc->stats->max = desc->stats->used;
+    }
+#endif
+    /* cast through u8_t* to get rid of alignment warnings */
+    return ((u8_t *)memp + MEMP_SIZE);
+  }
+#if MEMP_STATS
+  desc->stats->err++;
+#endif
+  LWIP_DEBUGF(MEMP_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("memp_malloc: out of memory in pool %s\n", desc->desc));
+  return NULL;
+#else /* MEMP_LOCKFREE */
   SYS_ARCH_DECL_PROTECT(old_level);
 
 #if MEMP_MEM_MALLOC
@@ -297,6 +409,7 @@ do_memp_malloc_pool_fn(const struct memp_desc *desc, const char *file, const int
   }
 
   return NULL;
+#endif /* MEMP_LOCKFREE */
 }
 
 /**
@@ -359,7 +472,9 @@ static void
 do_memp_free_pool(const struct memp_desc *desc, void *mem)
 {
   struct memp *memp;
+#if !MEMP_LOCKFREE
   SYS_ARCH_DECL_PROTECT(old_level);
+#endif /* !MEMP_LOCKFREE */
 
   LWIP_ASSERT("memp_free: mem properly aligned",
               ((mem_ptr_t)mem % MEM_ALIGNMENT) == 0);
@@ -367,6 +482,15 @@ do_memp_free_pool(const struct memp_desc *desc, void *mem)
   /* cast through void* to get rid of alignment warnings */
   memp = (struct memp *)(void *)((u8_t *)mem - MEMP_SIZE);
 
+#if MEMP_LOCKFREE
+#if MEMP_OVERFLOW_CHECK == 1
+  memp_overflow_check_element(memp, desc);
+#endif /* MEMP_OVERFLOW_CHECK */
+#if MEMP_STATS
+  desc->stats->used--;
+#endif
+  memp_lockfree_push(desc, memp);
+#else /* MEMP_LOCKFREE */
   SYS_ARCH_PROTECT(old_level);
 
 #if MEMP_OVERFLOW_CHECK == 1
@@ -391,6 +515,7 @@ do_memp_free_pool(const struct memp_desc *desc, void *mem)
 
   SYS_ARCH_UNPROTECT(old_level);
 #endif /* !MEMP_MEM_MALLOC */
+#endif /* MEMP_LOCKFREE */
 }
 
 /**
@@ -420,7 +545,7 @@ void
 memp_free(memp_t type, void *mem)
 {
 #ifdef LWIP_HOOK_MEMP_AVAILABLE
-  struct memp *old_first;
+  memp_head_t old_first;
 #endif
 
   LWIP_ERROR("memp_free: type < MEMP_MAX", (type < MEMP_MAX), return;);
@@ -440,7 +565,7 @@ memp_free(memp_t type, void *mem)
   do_memp_free_pool(memp_pools[type], mem);
 
 #ifdef LWIP_HOOK_MEMP_AVAILABLE
-  if (old_first == NULL) {
+  if (MEMP_HEAD_IS_EMPTY(old_first)) {
     LWIP_HOOK_MEMP_AVAILABLE(type);
   }
 #endif
@@ -66,6 +66,7 @@
 #include "lwip/stats.h"
 #include "lwip/sys.h"
 #include "lwip/ip.h"
+#include "lwip/ip4_gro.h"
 #if ENABLE_LOOPBACK
 #if LWIP_NETIF_LOOPBACK_MULTITHREADING
 #include "lwip/tcpip.h"
@@ -359,6 +360,9 @@ netif_add(struct netif *netif,
   netif->input = input;
 
   NETIF_RESET_HINTS(netif);
+#if LWIP_IPV4 && LWIP_ARP && ETHARP_TABLE_HASH && !LWIP_NETIF_HWADDRHINT
+  netif->arp_hint = 0;
+#endif /* LWIP_IPV4 && LWIP_ARP && ETHARP_TABLE_HASH && !LWIP_NETIF_HWADDRHINT */
 #if ENABLE_LOOPBACK && LWIP_LOOPBACK_MAX_PBUFS
   netif->loop_cnt_current = 0;
 #endif /* ENABLE_LOOPBACK && LWIP_LOOPBACK_MAX_PBUFS */
@@ -749,6 +753,10 @@ netif_remove(struct netif *netif)
   netif_invoke_ext_callback(netif, LWIP_NSC_NETIF_REMOVED, NULL);
 
 #if LWIP_IPV4
+#if IP_GRO
+  /* process segments still held back for this netif */
+  ip4_gro_flush_netif(netif);
+#endif /* IP_GRO */
   if (!ip4_addr_isany_val(*netif_ip4_addr(netif))) {
     netif_do_ip_addr_changed(netif_ip_addr4(netif), NULL);
   }
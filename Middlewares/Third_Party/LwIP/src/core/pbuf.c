@@ -132,9 +132,16 @@ pbuf_free_ooseq(void)
 
   for (pcb = tcp_active_pcbs; NULL != pcb; pcb = pcb->next) {
     if (pcb->ooseq != NULL) {
+#if TCP_OOSEQ_RANGES
+      /** Free the highest ooseq range of one PCB only, keeping the data
+          closest to rcv_nxt */
+      LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_free_ooseq: freeing highest out-of-sequence range\n"));
+      tcp_free_ooseq_tail(pcb);
+#else /* TCP_OOSEQ_RANGES */
       /** Free the ooseq pbufs of one PCB only */
       LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_free_ooseq: freeing out-of-sequence pbufs\n"));
       tcp_free_ooseq(pcb);
+#endif /* TCP_OOSEQ_RANGES */
       return;
     }
   }
@@ -186,6 +193,9 @@ pbuf_init_alloced_pbuf(struct pbuf *p, void *payload, u16_t tot_len, u16_t len,
   p->flags = flags;
   p->ref = 1;
   p->if_idx = NETIF_NO_INDEX;
+#if TCP_TSO
+  p->tso_mss = 0;
+#endif /* TCP_TSO */
 }
 
 /**
@@ -1433,31 +1443,10 @@ pbuf_put_at(struct pbuf *p, u16_t offset, u8_t data)
 u16_t
 pbuf_memcmp(const struct pbuf *p, u16_t offset, const void *s2, u16_t n)
 {
-  u16_t start = offset;
-  const struct pbuf *q = p;
-  u16_t i;
-
-  /* pbuf long enough to perform check? */
-  if (p->tot_len < (offset + n)) {
-    return 0xffff;
-  }
-
-  /* get the correct pbuf from chain. We know it succeeds because of p->tot_len check above. */
-  while ((q != NULL) && (q->len <= start)) {
-    start = (u16_t)(start - q->len);
-    q = q->next;
-  }
+  struct pbuf_cursor c;
 
-  /* return requested data if pbuf is OK */
-  for (i = 0; i < n; i++) {
-    /* We know pbuf_get_at() succeeds because of p->tot_len check above. */
-    u8_t a = pbuf_get_at(q, (u16_t)(start + i));
-    u8_t b = ((const u8_t *)s2)[i];
-    if (a != b) {
-      return (u16_t)LWIP_MIN(i + 1, 0xFFFF);
-    }
-  }
-  return 0;
+  pbuf_cursor_init(&c, p, offset);
+  return pbuf_cursor_memcmp(&c, s2, n);
 }
 
 /**
@@ -1512,3 +1501,195 @@ pbuf_strstr(const struct pbuf *p, const char *substr)
   }
   return pbuf_memfind(p, substr, (u16_t)substr_len, 0);
 }
+
+/* Move a cursor's pbuf forward until it contains the position */
+static void
+pbuf_cursor_walk(struct pbuf_cursor *c)
+{
+  while ((c->p != NULL) && (c->off >= c->p->len)) {
+    c->off = (u16_t)(c->off - c->p->len);
+    c->start = (u16_t)(c->start + c->p->len);
+    c->p = c->p->next;
+  }
+}
+
+/**
+ * @ingroup pbuf
+ * Initialize a cursor for reading a pbuf chain sequentially.
+ *
+ * @param c the cursor to initialize
+ * @param p the pbuf chain to read
+ * @param offset initial position in p
+ */
+void
+pbuf_cursor_init(struct pbuf_cursor *c, const struct pbuf *p, u16_t offset)
+{
+  c->head = p;
+  c->p = p;
+  c->start = 0;
+  c->off = offset;
+  pbuf_cursor_walk(c);
+}
+
+/**
+ * @ingroup pbuf
+ * Move a cursor to an absolute position in its chain. Moving forward
+ * continues from the current pbuf, moving backwards restarts at the head.
+ *
+ * @param c the cursor
+ * @param offset the new position
+ * @return ERR_OK or ERR_BUF if the position is behind the end of the chain
+ *         (the cursor is not moved then)
+ */
+err_t
+pbuf_cursor_seek(struct pbuf_cursor *c, u16_t offset)
+{
+  if ((c->head == NULL) || (offset > c->head->tot_len)) {
+    return ERR_BUF;
+  }
+  if (offset < c->start) {
+    c->p = c->head;
+    c->start = 0;
+  }
+  c->off = (u16_t)(offset - c->start);
+  pbuf_cursor_walk(c);
+  return ERR_OK;
+}
+
+/**
+ * @ingroup pbuf
+ * Advance a cursor by a number of bytes.
+ *
+ * @return ERR_OK or ERR_BUF if the new position would be behind the end of
+ *         the chain (the cursor is not moved then)
+ */
+err_t
+pbuf_cursor_skip(struct pbuf_cursor *c, u16_t len)
+{
+  u32_t offset = (u32_t)pbuf_cursor_pos(c) + len;
+
+  if (offset > 0xFFFF) {
+    return ERR_BUF;
+  }
+  return pbuf_cursor_seek(c, (u16_t)offset);
+}
+
+/**
+ * @ingroup pbuf
+ * Read the byte at a cursor's position and advance the cursor.
+ *
+ * @return the byte [0..0xFF] or negative if the cursor is at the end of the chain
+ */
+int
+pbuf_cursor_get(struct pbuf_cursor *c)
+{
+  u8_t b;
+
+  if (c->p == NULL) {
+    return -1;
+  }
+  b = ((const u8_t *)c->p->payload)[c->off];
+  c->off++;
+  pbuf_cursor_walk(c);
+  return b;
+}
+
+/**
+ * @ingroup pbuf
+ * Copy bytes from a cursor's position into a buffer and advance the cursor
+ * behind them (see pbuf_copy_partial()).
+ *
+ * @return the number of bytes copied (less than len at the end of the chain)
+ */
+u16_t
+pbuf_cursor_read(struct pbuf_cursor *c, void *dataptr, u16_t len)
+{
+  u16_t copied = 0;
+
+  while ((copied < len) && (c->p != NULL)) {
+    u16_t chunk = (u16_t)LWIP_MIN(len - copied, c->p->len - c->off);
+    MEMCPY((u8_t *)dataptr + copied, (const u8_t *)c->p->payload + c->off, chunk);
+    copied = (u16_t)(copied + chunk);
+    c->off = (u16_t)(c->off + chunk);
+    pbuf_cursor_walk(c);
+  }
+  return copied;
+}
+
+/**
+ * @ingroup pbuf
+ * Compare the bytes at a cursor's position with memory s2 (see
+ * pbuf_memcmp()). The cursor is not moved.
+ *
+ * @return zero if equal, nonzero otherwise
+ *         (0xffff if the chain is too short, diffoffset+1 otherwise)
+ */
+u16_t
+pbuf_cursor_memcmp(const struct pbuf_cursor *c, const void *s2, u16_t n)
+{
+  const struct pbuf *q = c->p;
+  u16_t off = c->off;
+  u16_t i = 0;
+
+  if ((c->head == NULL) || ((u32_t)pbuf_cursor_pos(c) + n > c->head->tot_len)) {
+    return 0xffff;
+  }
+  while (i < n) {
+    const u8_t *a;
+    u16_t chunk, j;
+
+    LWIP_ASSERT("tot_len/len mismatch", q != NULL);
+    if (off >= q->len) {
+      off = (u16_t)(off - q->len);
+      q = q->next;
+      continue;
+    }
+    a = (const u8_t *)q->payload + off;
+    chunk = (u16_t)LWIP_MIN(n - i, q->len - off);
+    for (j = 0; j < chunk; j++) {
+      if (a[j] != ((const u8_t *)s2)[i + j]) {
+        return (u16_t)LWIP_MIN(i + j + 1, 0xFFFF);
+      }
+    }
+    i = (u16_t)(i + chunk);
+    off = 0;
+    q = q->next;
+  }
+  return 0;
+}
+
+/**
+ * @ingroup pbuf
+ * Get bytes at a cursor's position as contiguous memory and advance the
+ * cursor behind them: a pointer into the payload if they are in one pbuf, a
+ * copy into the supplied buffer only if they straddle pbufs (see
+ * pbuf_get_contiguous()). This is meant for protocol headers, which are
+ * usually not split.
+ *
+ * @param c the cursor
+ * @param buffer the application supplied buffer
+ * @param bufsize size of the application supplied buffer
+ * @param len number of bytes needed
+ * @return pointer to the data or NULL if the chain is too short (the cursor
+ *         is not moved then)
+ */
+void *
+pbuf_cursor_get_contiguous(struct pbuf_cursor *c, void *buffer, size_t bufsize, u16_t len)
+{
+  void *ret;
+
+  LWIP_ERROR("pbuf_cursor_get_contiguous: invalid buffer", (buffer != NULL) && (bufsize >= len), return NULL;);
+
+  if ((c->head == NULL) || ((u32_t)pbuf_cursor_pos(c) + len > c->head->tot_len)) {
+    return NULL;
+  }
+  if ((c->p != NULL) && (c->p->len - c->off >= len)) {
+    /* all data in this pbuf, return zero-copy */
+    ret = (u8_t *)c->p->payload + c->off;
+    c->off = (u16_t)(c->off + len);
+    pbuf_cursor_walk(c);
+    return ret;
+  }
+  pbuf_cursor_read(c, buffer, len);
+  return buffer;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file
+ * Lock-free single-producer/single-consumer descriptor rings
+ *
+ * A ring hands pointers (typically pbufs) from exactly one producer context
+ * to exactly one consumer context, e.g. from a netif driver's RX interrupt or
+ * thread to tcpip_thread, or from tcpip_thread to a driver's TX DMA. The
+ * producer only writes the head index and the consumer only writes the tail
+ * index, so no lock is needed; memory barriers order the slot accesses
+ * against the index updates.
+ *
+ * Entries can be added and removed in batches, publishing the index only once
+ * per batch. The doorbell lets the producer notify the consumer once per batch
+ * instead of once per entry: spsc_ring_doorbell() returns nonzero only if the
+ * consumer is not already notified, and the consumer calls
+ * spsc_ring_consumer_done() after draining to re-arm it.
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_SPSC_RING /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/spsc_ring.h"
+#include "lwip/sys.h"
+#include "lwip/debug.h"
+
+/**
+ * Initialize a ring.
+ *
+ * @param ring the ring to initialize
+ * @param slots storage for "size" entries, must stay valid while the ring is used
+ * @param size number of entries, must be a power of two
+ * @return ERR_OK or ERR_ARG if the size is invalid
+ */
+err_t
+spsc_ring_init(struct spsc_ring *ring, void **slots, u32_t size)
+{
+  LWIP_ERROR("spsc_ring_init: invalid ring", (ring != NULL) && (slots != NULL), return ERR_ARG;);
+  LWIP_ERROR("spsc_ring_init: size must be a power of two",
+             (size != 0) && ((size & (size - 1)) == 0), return ERR_ARG;);
+
+  ring->slots = slots;
+  ring->mask = size - 1;
+  ring->head = 0;
+  ring->tail = 0;
+  ring->doorbell = 0;
+  return ERR_OK;
+}
+
+/**
+ * Get the number of entries in the ring. The result is only exact when
+ * called from the producer or the consumer while the other side is idle.
+ */
+u32_t
+spsc_ring_count(const struct spsc_ring *ring)
+{
+  return ring->head - ring->tail;
+}
+
+/**
+ * Producer: add up to "n" entries and publish them with one index update.
+ *
+ * @return the number of entries added (less than "n" if the ring is full)
+ */
+u32_t
+spsc_ring_put_batch(struct spsc_ring *ring, void *const *items, u32_t n)
+{
+  u32_t head = ring->head;
+  u32_t space = (ring->mask + 1) - (head - ring->tail);
+  u32_t i;
+
+  if (n > space) {
+    n = space;
+  }
+  /* the consumer must be done reading the slots before they are reused */
+  SYS_ARCH_MEMORY_BARRIER();
+  for (i = 0; i < n; i++) {
+    ring->slots[(head + i) & ring->mask] = items[i];
+  }
+  /* the slots must be written before the consumer can see them */
+  SYS_ARCH_MEMORY_BARRIER();
+  ring->head = head + n;
+  return n;
+}
+
+/**
+ * Consumer: remove up to "n" entries and release their slots with one index
+ * update.
+ *
+ * @return the number of entries removed (0 if the ring is empty)
+ */
+u32_t
+spsc_ring_get_batch(struct spsc_ring *ring, void **items, u32_t n)
+{
+  u32_t tail = ring->tail;
+  u32_t avail = ring->head - tail;
+  u32_t i;
+
+  if (n > avail) {
+    n = avail;
+  }
+  /* the slots must not be read before the head index announcing them */
+  SYS_ARCH_MEMORY_BARRIER();
+  for (i = 0; i < n; i++) {
+    items[i] = ring->slots[(tail + i) & ring->mask];
+  }
+  /* the slots must be read before the producer can reuse them */
+  SYS_ARCH_MEMORY_BARRIER();
+  ring->tail = tail + n;
+  return n;
+}
+
+/**
+ * Producer: add one entry.
+ *
+ * @return ERR_OK or ERR_MEM if the ring is full
+ */
+err_t
+spsc_ring_put(struct spsc_ring *ring, void *item)
+{
+  return (spsc_ring_put_batch(ring, &item, 1) == 1) ? ERR_OK : ERR_MEM;
+}
+
+/**
+ * Consumer: remove one entry.
+ *
+ * @return the entry or NULL if the ring is empty
+ */
+void *
+spsc_ring_get(struct spsc_ring *ring)
+{
+  void *item;
+  if (spsc_ring_get_batch(ring, &item, 1) == 1) {
+    return item;
+  }
+  return NULL;
+}
+
+/**
+ * Producer: ring the doorbell after adding a batch of entries.
+ *
+ * @return nonzero if the caller has to notify the consumer, 0 if the consumer
+ *         is already notified and will see the new entries
+ */
+int
+spsc_ring_doorbell(struct spsc_ring *ring)
+{
+  SYS_ARCH_MEMORY_BARRIER();
+  if (ring->doorbell) {
+    return 0;
+  }
+  return SYS_ARCH_CAS_U32(&ring->doorbell, 0, 1) ? 1 : 0;
+}
+
+/**
+ * Consumer: re-arm the doorbell after the ring has been drained.
+ *
+ * @return nonzero if entries were added in the meantime without a new
+ *         notification: the consumer has to drain again (and call this
+ *         function again afterwards)
+ */
+int
+spsc_ring_consumer_done(struct spsc_ring *ring)
+{
+  ring->doorbell = 0;
+  SYS_ARCH_MEMORY_BARRIER();
+  if (ring->head == ring->tail) {
+    return 0;
+  }
+  /* take the doorbell back unless the producer has just rung it */
+  return SYS_ARCH_CAS_U32(&ring->doorbell, 0, 1) ? 1 : 0;
+}
+
+#endif /* LWIP_SPSC_RING */
@@ -100,6 +100,21 @@ stats_display_igmp(struct stats_igmp *igmp, const char *name)
 }
 #endif /* IGMP_STATS || MLD6_STATS */
 
+#if IPREASS_STATS
+void
+stats_display_ip_reass(struct stats_ip_reass *reass)
+{
+  LWIP_PLATFORM_DIAG(("\nIP_REASS\n\t"));
+  LWIP_PLATFORM_DIAG(("completed: %"STAT_COUNTER_F"\n\t", reass->completed));
+  LWIP_PLATFORM_DIAG(("timeout: %"STAT_COUNTER_F"\n\t", reass->timeout));
+  LWIP_PLATFORM_DIAG(("evicted: %"STAT_COUNTER_F"\n\t", reass->evicted));
+  LWIP_PLATFORM_DIAG(("overlap: %"STAT_COUNTER_F"\n\t", reass->overlap));
+  LWIP_PLATFORM_DIAG(("quota: %"STAT_COUNTER_F"\n\t", reass->quota));
+  LWIP_PLATFORM_DIAG(("latency_max: %"U32_F"\n\t", reass->latency_max));
+  LWIP_PLATFORM_DIAG(("latency_total: %"U32_F"\n", reass->latency_total));
+}
+#endif /* IPREASS_STATS */
+
 #if MEM_STATS || MEMP_STATS
 void
 stats_display_mem(struct stats_mem *mem, const char *name)
@@ -147,6 +162,7 @@ stats_display(void)
   LINK_STATS_DISPLAY();
   ETHARP_STATS_DISPLAY();
   IPFRAG_STATS_DISPLAY();
+  IPREASS_STATS_DISPLAY();
   IP6_FRAG_STATS_DISPLAY();
   IP_STATS_DISPLAY();
   ND6_STATS_DISPLAY();
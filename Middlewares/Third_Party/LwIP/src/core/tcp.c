@@ -111,6 +111,7 @@
 #include "lwip/ip6.h"
 #include "lwip/ip6_addr.h"
 #include "lwip/nd6.h"
+#include "lwip/sys.h"
 
 #include <string.h>
 
@@ -182,6 +183,13 @@ struct tcp_pcb **const tcp_pcb_lists[] = {&tcp_listen_pcbs.pcbs, &tcp_bound_pcbs
          &tcp_active_pcbs, &tcp_tw_pcbs
 };
 
+#if TCP_PCB_HASH
+/** Active and TIME-WAIT PCBs hashed by their 4-tuple */
+static struct tcp_pcb *tcp_pcb_hash[TCP_PCB_HASH_SIZE];
+/** Listening PCBs hashed by their local port */
+static struct tcp_pcb *tcp_listen_pcb_hash[TCP_LISTEN_PCB_HASH_SIZE];
+#endif /* TCP_PCB_HASH */
+
 u8_t tcp_active_pcbs_changed;
 
 /** Timer counter to handle calling slow-timer from tcp_tmr() */
@@ -1192,7 +1200,6 @@ void
 tcp_slowtmr(void)
 {
   struct tcp_pcb *pcb, *prev;
-  tcpwnd_size_t eff_wnd;
   u8_t pcb_remove;      /* flag if a PCB should be removed */
   u8_t pcb_reset;       /* flag if a RST should be sent when removing */
   err_t err;
@@ -1293,16 +1300,10 @@ tcp_slowtmr_start:
             pcb->rtime = 0;
 
             /* Reduce congestion window and ssthresh. */
-            eff_wnd = LWIP_MIN(pcb->cwnd, pcb->snd_wnd);
-            pcb->ssthresh = eff_wnd >> 1;
-            if (pcb->ssthresh < (tcpwnd_size_t)(pcb->mss << 1)) {
-              pcb->ssthresh = (tcpwnd_size_t)(pcb->mss << 1);
-            }
-            pcb->cwnd = pcb->mss;
+            TCP_CC_OPS(pcb)->loss(pcb, TCP_CC_LOSS_RTO);
             LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_slowtmr: cwnd %"TCPWNDSIZE_F
                                          " ssthresh %"TCPWNDSIZE_F"\n",
                                          pcb->cwnd, pcb->ssthresh));
-            pcb->bytes_acked = 0;
 
             /* The following needs to be called AFTER cwnd is set to one
                mss - STJ */
@@ -1393,6 +1394,7 @@ tcp_slowtmr_start:
         LWIP_ASSERT("tcp_slowtmr: first pcb == tcp_active_pcbs", tcp_active_pcbs == pcb);
         tcp_active_pcbs = pcb->next;
       }
+      TCP_HASH_RMV(&tcp_active_pcbs, pcb);
 
       if (pcb_reset) {
         tcp_rst(pcb, pcb->snd_nxt, pcb->rcv_nxt, &pcb->local_ip, &pcb->remote_ip,
@@ -1459,6 +1461,7 @@ tcp_slowtmr_start:
         LWIP_ASSERT("tcp_slowtmr: first pcb == tcp_tw_pcbs", tcp_tw_pcbs == pcb);
         tcp_tw_pcbs = pcb->next;
       }
+      TCP_HASH_RMV(&tcp_tw_pcbs, pcb);
       pcb2 = pcb;
       pcb = pcb->next;
       tcp_free(pcb2);
@@ -1496,6 +1499,13 @@ tcp_fasttmr_start:
         tcp_output(pcb);
         tcp_clear_flags(pcb, TF_ACK_DELAY | TF_ACK_NOW);
       }
+#if LWIP_TCP_SACK_IN
+      /* RACK reordering timer: check the suspected segments again */
+      if ((pcb->rack_flags & TCP_RACK_TMR) && ((s32_t)(sys_now() - pcb->rack_tmr) >= 0)) {
+        tcp_rexmit_sack(pcb);
+        tcp_output(pcb);
+      }
+#endif /* LWIP_TCP_SACK_IN */
       /* send pending FIN */
       if (pcb->flags & TF_CLOSEPEND) {
         LWIP_DEBUGF(TCP_DEBUG, ("tcp_fasttmr: pending FIN\n"));
@@ -1911,6 +1921,9 @@ tcp_alloc(u8_t prio)
     connection is established. To avoid these complications, we set ssthresh to the
     largest effective cwnd (amount of in-flight data) that the sender can have. */
     pcb->ssthresh = TCP_SND_BUF;
+#if LWIP_TCP_CC
+    pcb->cc = TCP_CC_DEFAULT;
+#endif /* LWIP_TCP_CC */
 
 #if LWIP_CALLBACK_API
     pcb->recv = tcp_recv_null;
@@ -2206,6 +2219,170 @@ tcp_pcb_remove(struct tcp_pcb **pcblist, struct tcp_pcb *pcb)
   LWIP_ASSERT("tcp_pcb_remove: tcp_pcbs_sane()", tcp_pcbs_sane());
 }
 
+#if TCP_PCB_HASH
+/** Fold an IP address into 32 bits for hashing */
+static u32_t
+tcp_pcb_hash_addr(const ip_addr_t *addr)
+{
+#if LWIP_IPV6
+  if (IP_IS_V6(addr)) {
+    const u32_t *a = ip_2_ip6(addr)->addr;
+    return a[0] ^ a[1] ^ a[2] ^ a[3];
+  }
+#endif /* LWIP_IPV6 */
+#if LWIP_IPV4
+  return ip4_addr_get_u32(ip_2_ip4(addr));
+#else /* LWIP_IPV4 */
+  return 0;
+#endif /* LWIP_IPV4 */
+}
+
+/** Calculate the 4-tuple bucket of a connection.
+ * The local address is left out since most hosts only have a few of them.
+ */
+static u16_t
+tcp_pcb_hash_idx(u16_t local_port, u16_t remote_port, const ip_addr_t *remote_ip)
+{
+  u32_t h = tcp_pcb_hash_addr(remote_ip) ^ (((u32_t)local_port << 16) | remote_port);
+  h ^= h >> 16;
+  h *= 0x45d9f3bUL;
+  h ^= h >> 16;
+  return (u16_t)(h % TCP_PCB_HASH_SIZE);
+}
+
+#define TCP_LISTEN_PCB_HASH_IDX(port) ((port) % TCP_LISTEN_PCB_HASH_SIZE)
+
+/** Returns the hash bucket a pcb registered to 'pcbs' belongs to or NULL
+ * if that list is not indexed (bound pcbs are never looked up by tcp_input) */
+static struct tcp_pcb **
+tcp_pcb_hash_bucket(struct tcp_pcb **pcbs, struct tcp_pcb *pcb)
+{
+  if ((pcbs == &tcp_active_pcbs) || (pcbs == &tcp_tw_pcbs)) {
+    return &tcp_pcb_hash[tcp_pcb_hash_idx(pcb->local_port, pcb->remote_port, &pcb->remote_ip)];
+  } else if (pcbs == &tcp_listen_pcbs.pcbs) {
+    return &tcp_listen_pcb_hash[TCP_LISTEN_PCB_HASH_IDX(pcb->local_port)];
+  }
+  return NULL;
+}
+
+/**
+ * Add a pcb to the hash table matching the list it has just been
+ * registered with (called from TCP_REG).
+ *
+ * @param pcbs PCB list the pcb has been added to
+ * @param pcb the tcp_pcb to index
+ */
+void
+tcp_pcb_hash_reg(struct tcp_pcb **pcbs, struct tcp_pcb *pcb)
+{
+  struct tcp_pcb **bucket = tcp_pcb_hash_bucket(pcbs, pcb);
+  if (bucket != NULL) {
+    pcb->hash_next = *bucket;
+    *bucket = pcb;
+  }
+}
+
+/**
+ * Remove a pcb from the hash table matching the list it has just been
+ * removed from (called from TCP_RMV).
+ *
+ * @param pcbs PCB list the pcb has been removed from
+ * @param pcb the tcp_pcb to unlink
+ */
+void
+tcp_pcb_hash_rmv(struct tcp_pcb **pcbs, struct tcp_pcb *pcb)
+{
+  struct tcp_pcb **bucket = tcp_pcb_hash_bucket(pcbs, pcb);
+  if (bucket != NULL) {
+    for (; *bucket != NULL; bucket = &(*bucket)->hash_next) {
+      if (*bucket == pcb) {
+        *bucket = pcb->hash_next;
+        break;
+      }
+    }
+  }
+  pcb->hash_next = NULL;
+}
+
+/**
+ * Find the active or TIME-WAIT pcb an incoming segment belongs to.
+ *
+ * @param local_port destination port of the segment
+ * @param remote_port source port of the segment
+ * @param local_ip destination address of the segment
+ * @param remote_ip source address of the segment
+ * @param inp netif the segment was received on
+ * @return the matching pcb (check its state for TIME_WAIT) or NULL
+ */
+struct tcp_pcb *
+tcp_pcb_hash_lookup(u16_t local_port, u16_t remote_port,
+                    const ip_addr_t *local_ip, const ip_addr_t *remote_ip,
+                    struct netif *inp)
+{
+  struct tcp_pcb *pcb;
+
+  pcb = tcp_pcb_hash[tcp_pcb_hash_idx(local_port, remote_port, remote_ip)];
+  for (; pcb != NULL; pcb = pcb->hash_next) {
+    LWIP_ASSERT("tcp_pcb_hash_lookup: pcb->state != CLOSED", pcb->state != CLOSED);
+    LWIP_ASSERT("tcp_pcb_hash_lookup: pcb->state != LISTEN", pcb->state != LISTEN);
+    /* check if PCB is bound to specific netif */
+    if ((pcb->netif_idx != NETIF_NO_INDEX) &&
+        (pcb->netif_idx != netif_get_index(inp))) {
+      continue;
+    }
+    if (pcb->remote_port == remote_port &&
+        pcb->local_port == local_port &&
+        ip_addr_cmp(&pcb->remote_ip, remote_ip) &&
+        ip_addr_cmp(&pcb->local_ip, local_ip)) {
+      return pcb;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Find the listening pcb an incoming segment should be passed to.
+ * A pcb listening on the exact local address is preferred over one
+ * listening on an ANY address (like the list scan does with SO_REUSE).
+ *
+ * @param local_port destination port of the segment
+ * @param local_ip destination address of the segment
+ * @param inp netif the segment was received on
+ * @return the matching listening pcb or NULL
+ */
+struct tcp_pcb_listen *
+tcp_listen_pcb_hash_lookup(u16_t local_port, const ip_addr_t *local_ip, struct netif *inp)
+{
+  struct tcp_pcb *pcb;
+  struct tcp_pcb_listen *lpcb_any = NULL;
+
+  pcb = tcp_listen_pcb_hash[TCP_LISTEN_PCB_HASH_IDX(local_port)];
+  for (; pcb != NULL; pcb = pcb->hash_next) {
+    struct tcp_pcb_listen *lpcb = (struct tcp_pcb_listen *)pcb;
+    /* check if PCB is bound to specific netif */
+    if ((lpcb->netif_idx != NETIF_NO_INDEX) &&
+        (lpcb->netif_idx != netif_get_index(inp))) {
+      continue;
+    }
+    if (lpcb->local_port == local_port) {
+      if (IP_IS_ANY_TYPE_VAL(lpcb->local_ip)) {
+        /* found an ANY TYPE (IPv4/IPv6) match */
+        lpcb_any = lpcb;
+      } else if (IP_ADDR_PCB_VERSION_MATCH_EXACT(lpcb, local_ip)) {
+        if (ip_addr_cmp(&lpcb->local_ip, local_ip)) {
+          /* found an exact match */
+          return lpcb;
+        } else if (ip_addr_isany(&lpcb->local_ip)) {
+          /* found an ANY-match */
+          lpcb_any = lpcb;
+        }
+      }
+    }
+  }
+  return lpcb_any;
+}
+#endif /* TCP_PCB_HASH */
+
 /**
  * Calculates a new initial sequence number for new connections.
  *
@@ -2388,6 +2565,9 @@ tcp_free_ooseq(struct tcp_pcb *pcb)
   if (pcb->ooseq) {
     tcp_segs_free(pcb->ooseq);
     pcb->ooseq = NULL;
+#if TCP_OOSEQ_RANGES
+    pcb->ooseq_num = 0;
+#endif /* TCP_OOSEQ_RANGES */
 #if LWIP_TCP_SACK_OUT
     memset(pcb->rcv_sacks, 0, sizeof(pcb->rcv_sacks));
 #endif /* LWIP_TCP_SACK_OUT */
@@ -0,0 +1,496 @@
+/**
+ * @file
+ * TCP congestion control algorithms
+ *
+ * The congestion control decisions of TCP (initial window, window growth on
+ * ACKs, reaction to loss) are made by a struct tcp_cc_ops. NewReno is always
+ * available and used by all pcbs unless LWIP_TCP_CC is enabled, which makes
+ * the algorithm selectable per pcb and adds:
+ * - CUBIC (RFC 8312): after a loss, cwnd follows a cubic function of the
+ *   time since the loss, so it regains the previous window independently of
+ *   the RTT instead of growing by one mss per RTT.
+ * - bbrlite: a cut-down BBR which measures the delivery rate and minimum
+ *   RTT per round trip and sets cwnd to their product (the bandwidth-delay
+ *   product) times a gain cycling through probing phases, ignoring isolated
+ *   losses. lwIP has no per-connection transmit timer, so there is no pacing:
+ *   sending stays ACK-clocked and the rate is only controlled through cwnd.
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_TCP /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/tcp_cc.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/sys.h"
+#include "lwip/def.h"
+
+#include <string.h>
+
+/* RFC 3465, section 2.2 Slow Start */
+static void
+tcp_cc_slow_start(struct tcp_pcb *pcb, tcpwnd_size_t acked)
+{
+  tcpwnd_size_t increase;
+  /* limit to 1 SMSS segment during period following RTO */
+  u8_t num_seg = (pcb->flags & TF_RTO) ? 1 : 2;
+  increase = LWIP_MIN(acked, (tcpwnd_size_t)(num_seg * pcb->mss));
+  TCP_WND_INC(pcb->cwnd, increase);
+  LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: slow start cwnd %"TCPWNDSIZE_F"\n", pcb->cwnd));
+}
+
+/* NewReno */
+
+static void
+tcp_newreno_init(struct tcp_pcb *pcb)
+{
+  pcb->cwnd = LWIP_TCP_CALC_INITIAL_CWND(pcb->mss);
+}
+
+static void
+tcp_newreno_cong_avoid(struct tcp_pcb *pcb, tcpwnd_size_t acked)
+{
+  if (pcb->cwnd < pcb->ssthresh) {
+    tcp_cc_slow_start(pcb, acked);
+  } else {
+    /* RFC 3465, section 2.1 Congestion Avoidance */
+    TCP_WND_INC(pcb->bytes_acked, acked);
+    if (pcb->bytes_acked >= pcb->cwnd) {
+      pcb->bytes_acked = (tcpwnd_size_t)(pcb->bytes_acked - pcb->cwnd);
+      TCP_WND_INC(pcb->cwnd, pcb->mss);
+    }
+    LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: congestion avoidance cwnd %"TCPWNDSIZE_F"\n", pcb->cwnd));
+  }
+}
+
+static void
+tcp_newreno_loss(struct tcp_pcb *pcb, u8_t event)
+{
+  /* Set ssthresh to half of the minimum of the current
+   * cwnd and the advertised window */
+  pcb->ssthresh = LWIP_MIN(pcb->cwnd, pcb->snd_wnd) / 2;
+
+  /* The minimum value for ssthresh should be 2 MSS */
+  if (pcb->ssthresh < (2U * pcb->mss)) {
+    LWIP_DEBUGF(TCP_FR_DEBUG,
+                ("tcp_receive: The minimum value for ssthresh %"TCPWNDSIZE_F
+                 " should be min 2 mss %"U16_F"...\n",
+                 pcb->ssthresh, (u16_t)(2 * pcb->mss)));
+    pcb->ssthresh = (tcpwnd_size_t)(2 * pcb->mss);
+  }
+
+  if (event == TCP_CC_LOSS_FAST) {
+    pcb->cwnd = (tcpwnd_size_t)(pcb->ssthresh + 3 * pcb->mss);
+  } else {
+    pcb->cwnd = pcb->mss;
+    pcb->bytes_acked = 0;
+  }
+}
+
+static void
+tcp_newreno_recovered(struct tcp_pcb *pcb)
+{
+  pcb->cwnd = pcb->ssthresh;
+  pcb->bytes_acked = 0;
+}
+
+const struct tcp_cc_ops tcp_cc_newreno = {
+  "newreno",
+  tcp_newreno_init,
+  tcp_newreno_cong_avoid,
+  tcp_newreno_loss,
+  tcp_newreno_recovered
+};
+
+#if LWIP_TCP_CC
+
+/**
+ * @ingroup tcp_raw
+ * Select the congestion control algorithm of a pcb (see @ref LWIP_TCP_CC).
+ * If the connection is already established, the algorithm starts over from
+ * its initial window.
+ *
+ * @param pcb the tcp_pcb to change
+ * @param cc the algorithm, e.g. &tcp_cc_cubic
+ */
+void
+tcp_set_cc(struct tcp_pcb *pcb, const struct tcp_cc_ops *cc)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("tcp_set_cc: invalid pcb", pcb != NULL, return);
+  LWIP_ERROR("tcp_set_cc: invalid cc", cc != NULL, return);
+  LWIP_ERROR("tcp_set_cc: cannot be called for listen pcbs",
+             pcb->state != LISTEN, return);
+
+  pcb->cc = cc;
+  if (pcb->state >= ESTABLISHED) {
+    pcb->bytes_acked = 0;
+    cc->init(pcb);
+  }
+}
+
+/** Grow cwnd by one mss for every 'per_mss' bytes acked */
+static void
+tcp_cc_grow(struct tcp_pcb *pcb, tcpwnd_size_t acked, u32_t per_mss)
+{
+  TCP_WND_INC(pcb->bytes_acked, acked);
+  while (pcb->bytes_acked >= per_mss) {
+    pcb->bytes_acked = (tcpwnd_size_t)(pcb->bytes_acked - per_mss);
+    TCP_WND_INC(pcb->cwnd, pcb->mss);
+  }
+}
+
+/** a * num / 1024 without overflowing for big a */
+#define TCP_CC_SCALE(a, num) ((((a) >> 10) * (num)) + ((((a) & 0x3ff) * (num)) >> 10))
+
+/* CUBIC */
+
+/** multiplicative decrease factor (0.7), in 1/1024 */
+#define TCP_CUBIC_BETA          717
+/** Reno-friendly additive increase 3 * (1 - beta) / (1 + beta), in 1/1024 */
+#define TCP_CUBIC_ALPHA         542
+/** time from the epoch start (in ms) up to which the cubic function is
+ * evaluated; the window gained beyond that is not needed */
+#define TCP_CUBIC_MAX_T         20000
+
+struct tcp_cubic {
+  /** cwnd before the last reduction */
+  u32_t w_max;
+  /** w_max of the reduction before, for fast convergence */
+  u32_t w_last_max;
+  /** sys_now() when the current congestion avoidance epoch started */
+  u32_t epoch_start;
+  /** time (ms) from epoch_start until the cubic function reaches origin */
+  u32_t k;
+  /** plateau of the cubic function */
+  u32_t origin;
+  /** window Reno would have reached in this epoch */
+  u32_t w_est;
+  /** bytes acked towards the next increase of w_est */
+  u32_t est_acked;
+  /** nonzero while an epoch is running */
+  u32_t in_epoch;
+};
+
+/** C * (t / 1000)^3 segments (C = 0.4), in bytes, for t in ms */
+#if !LWIP_TESTMODE
+static
+#endif
+u32_t
+tcp_cubic_delta(u32_t t, u16_t mss)
+{
+  u32_t x;
+  t = LWIP_MIN(t, TCP_CUBIC_MAX_T);
+  /* (t / 1000)^3 * 1000, in steps to stay within 32 bit
+     (x * t would overflow for t > 16 s) */
+  x = (t * t) / 1000;
+  x = ((x / 1000) * t) + (((x % 1000) * t) / 1000);
+  /* times C: 1000 * segments */
+  x = (x * 2) / 5;
+  return (x / 1000) * mss + ((x % 1000) * mss) / 1000;
+}
+
+/** The time (ms) after which the cubic function has grown by 'diff' bytes */
+#if !LWIP_TESTMODE
+static
+#endif
+u32_t
+tcp_cubic_k(u32_t diff, u16_t mss)
+{
+  u32_t lo = 0, hi = TCP_CUBIC_MAX_T;
+  while (lo < hi) {
+    u32_t mid = (lo + hi) / 2;
+    if (tcp_cubic_delta(mid, mss) < diff) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static void
+tcp_cubic_init(struct tcp_pcb *pcb)
+{
+  LWIP_ASSERT("cc_priv too small", sizeof(struct tcp_cubic) <= sizeof(pcb->cc_priv));
+  memset(pcb->cc_priv, 0, sizeof(pcb->cc_priv));
+  pcb->cwnd = LWIP_TCP_CALC_INITIAL_CWND(pcb->mss);
+}
+
+static void
+tcp_cubic_cong_avoid(struct tcp_pcb *pcb, tcpwnd_size_t acked)
+{
+  struct tcp_cubic *c = tcp_cc_priv(pcb, struct tcp_cubic);
+  u32_t now, t, delta, target, cwnd;
+
+  if (pcb->cwnd < pcb->ssthresh) {
+    tcp_cc_slow_start(pcb, acked);
+    return;
+  }
+  cwnd = pcb->cwnd;
+  now = sys_now();
+  if (!c->in_epoch) {
+    c->in_epoch = 1;
+    c->epoch_start = now;
+    c->w_est = cwnd;
+    c->est_acked = 0;
+    if (cwnd < c->w_max) {
+      c->k = tcp_cubic_k(c->w_max - cwnd, pcb->mss);
+      c->origin = c->w_max;
+    } else {
+      c->k = 0;
+      c->origin = cwnd;
+    }
+  }
+
+  /* W_cubic(t) = C * (t - K)^3 + W_max */
+  t = now - c->epoch_start;
+  if (t < c->k) {
+    delta = tcp_cubic_delta(c->k - t, pcb->mss);
+    target = (delta < c->origin) ? c->origin - delta : 0;
+  } else {
+    delta = tcp_cubic_delta(t - c->k, pcb->mss);
+    target = c->origin + delta;
+  }
+
+  /* never grow slower than Reno would */
+  c->est_acked += acked;
+  while (c->est_acked >= cwnd) {
+    c->est_acked -= cwnd;
+    c->w_est += TCP_CC_SCALE((u32_t)pcb->mss, TCP_CUBIC_ALPHA);
+  }
+  target = LWIP_MAX(target, c->w_est);
+
+  if (target > cwnd) {
+    /* at most 1.5 * cwnd per RTT */
+    target = LWIP_MIN(target, cwnd + cwnd / 2);
+    tcp_cc_grow(pcb, acked, (cwnd / (target - cwnd)) * pcb->mss);
+  } else {
+    /* plateau: grow very slowly */
+    tcp_cc_grow(pcb, acked, (cwnd < 0xFFFFFFFFUL / 100) ? 100 * cwnd : 0xFFFFFFFFUL);
+  }
+  LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: cubic cwnd %"TCPWNDSIZE_F" target %"U32_F"\n", pcb->cwnd, target));
+}
+
+static void
+tcp_cubic_loss(struct tcp_pcb *pcb, u8_t event)
+{
+  struct tcp_cubic *c = tcp_cc_priv(pcb, struct tcp_cubic);
+  u32_t cwnd = LWIP_MIN(pcb->cwnd, pcb->snd_wnd);
+
+  c->in_epoch = 0;
+  /* fast convergence: release bandwidth to newer flows sooner */
+  if (cwnd < c->w_last_max) {
+    c->w_last_max = cwnd;
+    c->w_max = TCP_CC_SCALE(cwnd, 1024 + TCP_CUBIC_BETA) / 2;
+  } else {
+    c->w_last_max = cwnd;
+    c->w_max = cwnd;
+  }
+  pcb->ssthresh = (tcpwnd_size_t)LWIP_MAX(TCP_CC_SCALE(cwnd, TCP_CUBIC_BETA), 2U * pcb->mss);
+
+  if (event == TCP_CC_LOSS_FAST) {
+    pcb->cwnd = (tcpwnd_size_t)(pcb->ssthresh + 3 * pcb->mss);
+  } else {
+    pcb->cwnd = pcb->mss;
+  }
+  pcb->bytes_acked = 0;
+}
+
+const struct tcp_cc_ops tcp_cc_cubic = {
+  "cubic",
+  tcp_cubic_init,
+  tcp_cubic_cong_avoid,
+  tcp_cubic_loss,
+  tcp_newreno_recovered
+};
+
+/* bbrlite */
+
+#define TCP_BBR_STARTUP         0
+#define TCP_BBR_DRAIN           1
+#define TCP_BBR_PROBE_BW        2
+
+/** rounds a bandwidth sample stays the maximum */
+#define TCP_BBR_BW_ROUNDS       10
+/** time (ms) after which the minimum RTT is measured anew */
+#define TCP_BBR_MIN_RTT_TIME    10000
+/** rounds without 25% bandwidth growth that end STARTUP */
+#define TCP_BBR_FULL_BW_ROUNDS  3
+
+/** cwnd gain while searching for the bottleneck rate (2 / ln(2) = 2.89), in 1/256 */
+#define TCP_BBR_STARTUP_GAIN    739
+/** cwnd gain while draining the queue built up in STARTUP (1 / 2.89), in 1/256 */
+#define TCP_BBR_DRAIN_GAIN      89
+/** cwnd gains cycled through in PROBE_BW (one per round), in 1/256 */
+static const u16_t tcp_bbr_probe_gain[8] = {320, 192, 256, 256, 256, 256, 256, 256};
+
+struct tcp_bbrlite {
+  /** maximum recent delivery rate, in bytes per ms * 256 */
+  u32_t bw;
+  /** minimum round trip time (ms) */
+  u32_t min_rtt;
+  /** sys_now() when min_rtt was measured */
+  u32_t min_rtt_stamp;
+  /** sys_now() when the current round started */
+  u32_t round_start;
+  /** the round ends when data sent after this sequence number is acked */
+  u32_t round_end;
+  /** bytes acked in the current round */
+  u32_t delivered;
+  /** bw at the last significant growth in STARTUP */
+  u32_t full_bw;
+  u8_t mode;
+  u8_t full_bw_cnt;
+  u8_t bw_age;
+  u8_t cycle;
+};
+
+static void
+tcp_bbrlite_init(struct tcp_pcb *pcb)
+{
+  struct tcp_bbrlite *b = tcp_cc_priv(pcb, struct tcp_bbrlite);
+
+  LWIP_ASSERT("cc_priv too small", sizeof(struct tcp_bbrlite) <= sizeof(pcb->cc_priv));
+  memset(pcb->cc_priv, 0, sizeof(pcb->cc_priv));
+  b->mode = TCP_BBR_STARTUP;
+  b->round_start = sys_now();
+  b->round_end = pcb->snd_nxt;
+  pcb->cwnd = LWIP_TCP_CALC_INITIAL_CWND(pcb->mss);
+}
+
+/** Update the model at the end of a round */
+static void
+tcp_bbrlite_round(struct tcp_pcb *pcb, struct tcp_bbrlite *b, u32_t now)
+{
+  u32_t rtt = LWIP_MAX(now - b->round_start, 1);
+  u32_t sample;
+
+  if (b->delivered > 0xffffff) {
+    sample = (b->delivered / rtt) << 8;
+  } else {
+    sample = (b->delivered << 8) / rtt;
+  }
+  b->bw_age++;
+  if ((sample >= b->bw) || (b->bw_age > TCP_BBR_BW_ROUNDS)) {
+    b->bw = sample;
+    b->bw_age = 0;
+  }
+  if ((b->min_rtt == 0) || (rtt <= b->min_rtt) ||
+      ((u32_t)(now - b->min_rtt_stamp) > TCP_BBR_MIN_RTT_TIME)) {
+    b->min_rtt = rtt;
+    b->min_rtt_stamp = now;
+  }
+
+  switch (b->mode) {
+    case TCP_BBR_STARTUP:
+      if (b->bw >= TCP_CC_SCALE(b->full_bw, 1280)) {
+        b->full_bw = b->bw;
+        b->full_bw_cnt = 0;
+      } else if (++b->full_bw_cnt >= TCP_BBR_FULL_BW_ROUNDS) {
+        b->mode = TCP_BBR_DRAIN;
+      }
+      break;
+    case TCP_BBR_DRAIN:
+      b->mode = TCP_BBR_PROBE_BW;
+      b->cycle = 0;
+      break;
+    default:
+      b->cycle = (u8_t)((b->cycle + 1) & (LWIP_ARRAYSIZE(tcp_bbr_probe_gain) - 1));
+      break;
+  }
+
+  b->delivered = 0;
+  b->round_start = now;
+  b->round_end = pcb->snd_nxt;
+}
+
+static void
+tcp_bbrlite_cong_avoid(struct tcp_pcb *pcb, tcpwnd_size_t acked)
+{
+  struct tcp_bbrlite *b = tcp_cc_priv(pcb, struct tcp_bbrlite);
+  u32_t bdp, target, gain;
+
+  b->delivered += acked;
+  if (TCP_SEQ_GT(pcb->lastack, b->round_end)) {
+    tcp_bbrlite_round(pcb, b, sys_now());
+  }
+
+  /* bandwidth-delay product: bw * min_rtt */
+  bdp = (b->bw >> 8) * b->min_rtt + (((b->bw & 0xff) * b->min_rtt) >> 8);
+  if (b->mode == TCP_BBR_STARTUP) {
+    gain = TCP_BBR_STARTUP_GAIN;
+  } else if (b->mode == TCP_BBR_DRAIN) {
+    gain = TCP_BBR_DRAIN_GAIN;
+  } else {
+    gain = tcp_bbr_probe_gain[b->cycle];
+  }
+  target = (bdp >> 8) * gain + (((bdp & 0xff) * gain) >> 8);
+  /* headroom for delayed and stretched ACKs */
+  target = LWIP_MAX(target + 2U * pcb->mss, 4U * pcb->mss);
+
+  if (pcb->cwnd < target) {
+    /* grows exponentially, in STARTUP until the delivery rate stops increasing */
+    TCP_WND_INC(pcb->cwnd, LWIP_MIN(acked, target - pcb->cwnd));
+  } else {
+    pcb->cwnd = (tcpwnd_size_t)LWIP_MIN(target, TCPWND_MAX);
+  }
+  LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: bbrlite cwnd %"TCPWNDSIZE_F" bw %"U32_F" min_rtt %"U32_F"\n",
+                               pcb->cwnd, b->bw, b->min_rtt));
+}
+
+static void
+tcp_bbrlite_loss(struct tcp_pcb *pcb, u8_t event)
+{
+  /* the model does not change on loss: keep the window (remembered in
+     ssthresh and restored when recovery ends) */
+  pcb->ssthresh = LWIP_MAX(pcb->cwnd, 2U * pcb->mss);
+  if (event == TCP_CC_LOSS_RTO) {
+    /* everything in flight is presumed lost: start over with one segment,
+       cong_avoid() grows back to the modelled window within a round */
+    pcb->cwnd = pcb->mss;
+  }
+  pcb->bytes_acked = 0;
+}
+
+const struct tcp_cc_ops tcp_cc_bbrlite = {
+  "bbrlite",
+  tcp_bbrlite_init,
+  tcp_bbrlite_cong_avoid,
+  tcp_bbrlite_loss,
+  tcp_newreno_recovered
+};
+
+#endif /* LWIP_TCP_CC */
+
+#endif /* LWIP_TCP */
@@ -58,6 +58,7 @@
 #if LWIP_ND6_TCP_REACHABILITY_HINTS
 #include "lwip/nd6.h"
 #endif /* LWIP_ND6_TCP_REACHABILITY_HINTS */
+#include "lwip/sys.h"
 
 #include <string.h>
 
@@ -65,9 +66,6 @@
 #include LWIP_HOOK_FILENAME
 #endif
 
-/** Initial CWND calculation as defined RFC 2581 */
-#define LWIP_TCP_CALC_INITIAL_CWND(mss) ((tcpwnd_size_t)LWIP_MIN((4U * (mss)), LWIP_MAX((2U * (mss)), 4380U)))
-
 /* These variables are global to all functions involved in the input
    processing of TCP segments. They are set by the tcp_input()
    function. */
@@ -85,6 +83,13 @@ static u8_t flags;
 static u8_t recv_flags;
 static struct pbuf *recv_data;
 
+#if LWIP_TCP_SACK_IN
+/* The SACK blocks of the incoming segment (at most 4 fit into the options) */
+#define TCP_IN_SACK_MAX 4
+static struct tcp_sack_range tcp_in_sacks[TCP_IN_SACK_MAX];
+static u8_t tcp_in_sack_num;
+#endif /* LWIP_TCP_SACK_IN */
+
 struct tcp_pcb *tcp_input_pcb;
 
 /* Forward declarations. */
@@ -100,11 +105,24 @@ static int tcp_input_delayed_close(struct tcp_pcb *pcb);
 #if LWIP_TCP_SACK_OUT
 static void tcp_add_sack(struct tcp_pcb *pcb, u32_t left, u32_t right);
 static void tcp_remove_sacks_lt(struct tcp_pcb *pcb, u32_t seq);
-#if defined(TCP_OOSEQ_BYTES_LIMIT) || defined(TCP_OOSEQ_PBUFS_LIMIT)
+#if defined(TCP_OOSEQ_BYTES_LIMIT) || defined(TCP_OOSEQ_PBUFS_LIMIT) || TCP_OOSEQ_RANGES
 static void tcp_remove_sacks_gt(struct tcp_pcb *pcb, u32_t seq);
-#endif /* TCP_OOSEQ_BYTES_LIMIT || TCP_OOSEQ_PBUFS_LIMIT */
+#endif /* TCP_OOSEQ_BYTES_LIMIT || TCP_OOSEQ_PBUFS_LIMIT || TCP_OOSEQ_RANGES */
 #endif /* LWIP_TCP_SACK_OUT */
 
+#if LWIP_TCP_SACK_IN
+static void tcp_rack_delivered(struct tcp_pcb *pcb, struct tcp_seg *seg, u32_t now);
+static void tcp_sack_receive(struct tcp_pcb *pcb);
+/* ACKs carrying SACK blocks are left to SACK loss detection */
+#define TCP_DUPACK_REXMIT()    (tcp_in_sack_num == 0)
+/* SACK recovery lasts until all data outstanding at its start is acked */
+#define TCP_RECOVERY_DONE(pcb) (!((pcb)->rack_flags & TCP_SACK_RECOVERY) || \
+                                TCP_SEQ_GEQ(ackno, (pcb)->sack_recover))
+#else /* LWIP_TCP_SACK_IN */
+#define TCP_DUPACK_REXMIT()    1
+#define TCP_RECOVERY_DONE(pcb) 1
+#endif /* LWIP_TCP_SACK_IN */
+
 /**
  * The initial input processing of TCP. It verifies the TCP header, demultiplexes
  * the segment between the PCBs and passes it on to tcp_process(), which implements
@@ -117,12 +135,17 @@ static void tcp_remove_sacks_gt(struct tcp_pcb *pcb, u32_t seq);
 void
 tcp_input(struct pbuf *p, struct netif *inp)
 {
-  struct tcp_pcb *pcb, *prev;
+  struct tcp_pcb *pcb;
   struct tcp_pcb_listen *lpcb;
+#if TCP_PCB_HASH
+  struct tcp_pcb *twpcb = NULL;
+#else /* TCP_PCB_HASH */
+  struct tcp_pcb *prev;
 #if SO_REUSE
   struct tcp_pcb *lpcb_prev = NULL;
   struct tcp_pcb_listen *lpcb_any = NULL;
 #endif /* SO_REUSE */
+#endif /* TCP_PCB_HASH */
   u8_t hdrlen_bytes;
   err_t err;
 
@@ -245,6 +268,14 @@ tcp_input(struct pbuf *p, struct netif *inp)
 
   /* Demultiplex an incoming segment. First, we check if it is destined
      for an active connection. */
+#if TCP_PCB_HASH
+  pcb = tcp_pcb_hash_lookup(tcphdr->dest, tcphdr->src, ip_current_dest_addr(),
+                            ip_current_src_addr(), ip_data.current_input_netif);
+  if ((pcb != NULL) && (pcb->state == TIME_WAIT)) {
+    twpcb = pcb;
+    pcb = NULL;
+  }
+#else /* TCP_PCB_HASH */
   prev = NULL;
 
   for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
@@ -279,10 +310,14 @@ tcp_input(struct pbuf *p, struct netif *inp)
     }
     prev = pcb;
   }
+#endif /* TCP_PCB_HASH */
 
   if (pcb == NULL) {
     /* If it did not go to an active connection, we check the connections
        in the TIME-WAIT state. */
+#if TCP_PCB_HASH
+    pcb = twpcb;
+#else /* TCP_PCB_HASH */
     for (pcb = tcp_tw_pcbs; pcb != NULL; pcb = pcb->next) {
       LWIP_ASSERT("tcp_input: TIME-WAIT pcb->state == TIME-WAIT", pcb->state == TIME_WAIT);
 
@@ -299,21 +334,29 @@ tcp_input(struct pbuf *p, struct netif *inp)
         /* We don't really care enough to move this PCB to the front
            of the list since we are not very likely to receive that
            many segments for connections in TIME-WAIT. */
-        LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_input: packed for TIME_WAITing connection.\n"));
+        break;
+      }
+    }
+#endif /* TCP_PCB_HASH */
+    if (pcb != NULL) {
+      LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_input: packed for TIME_WAITing connection.\n"));
 #ifdef LWIP_HOOK_TCP_INPACKET_PCB
-        if (LWIP_HOOK_TCP_INPACKET_PCB(pcb, tcphdr, tcphdr_optlen, tcphdr_opt1len,
-                                       tcphdr_opt2, p) == ERR_OK)
+      if (LWIP_HOOK_TCP_INPACKET_PCB(pcb, tcphdr, tcphdr_optlen, tcphdr_opt1len,
+                                     tcphdr_opt2, p) == ERR_OK)
 #endif
-        {
-          tcp_timewait_input(pcb);
-        }
-        pbuf_free(p);
-        return;
+      {
+        tcp_timewait_input(pcb);
       }
+      pbuf_free(p);
+      return;
     }
 
     /* Finally, if we still did not get a match, we check all PCBs that
        are LISTENing for incoming connections. */
+#if TCP_PCB_HASH
+    lpcb = tcp_listen_pcb_hash_lookup(tcphdr->dest, ip_current_dest_addr(),
+                                      ip_data.current_input_netif);
+#else /* TCP_PCB_HASH */
     prev = NULL;
     for (lpcb = tcp_listen_pcbs.listen_pcbs; lpcb != NULL; lpcb = lpcb->next) {
       /* check if PCB is bound to specific netif */
@@ -357,7 +400,9 @@ tcp_input(struct pbuf *p, struct netif *inp)
       prev = lpcb_prev;
     }
 #endif /* SO_REUSE */
+#endif /* TCP_PCB_HASH */
     if (lpcb != NULL) {
+#if !TCP_PCB_HASH
       /* Move this PCB to the front of the list so that subsequent
          lookups will be faster (we exploit locality in TCP segment
          arrivals). */
@@ -370,6 +415,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
       } else {
         TCP_STATS_INC(tcp.cachehit);
       }
+#endif /* !TCP_PCB_HASH */
 
       LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_input: packed for LISTENing connection.\n"));
 #ifdef LWIP_HOOK_TCP_INPACKET_PCB
@@ -869,7 +915,7 @@ tcp_process(struct tcp_pcb *pcb)
         pcb->mss = tcp_eff_send_mss(pcb->mss, &pcb->local_ip, &pcb->remote_ip);
 #endif /* TCP_CALCULATE_EFF_SEND_MSS */
 
-        pcb->cwnd = LWIP_TCP_CALC_INITIAL_CWND(pcb->mss);
+        TCP_CC_OPS(pcb)->init(pcb);
         LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_process (SENT): cwnd %"TCPWNDSIZE_F
                                      " ssthresh %"TCPWNDSIZE_F"\n",
                                      pcb->cwnd, pcb->ssthresh));
@@ -957,7 +1003,7 @@ tcp_process(struct tcp_pcb *pcb)
             recv_acked--;
           }
 
-          pcb->cwnd = LWIP_TCP_CALC_INITIAL_CWND(pcb->mss);
+          TCP_CC_OPS(pcb)->init(pcb);
           LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_process (SYN_RCVD): cwnd %"TCPWNDSIZE_F
                                        " ssthresh %"TCPWNDSIZE_F"\n",
                                        pcb->cwnd, pcb->ssthresh));
@@ -1041,7 +1087,7 @@ tcp_process(struct tcp_pcb *pcb)
   return ERR_OK;
 }
 
-#if TCP_QUEUE_OOSEQ
+#if TCP_QUEUE_OOSEQ && !TCP_OOSEQ_RANGES
 /**
  * Insert segment into the list (segments covered with new one will be deleted)
  *
@@ -1081,7 +1127,263 @@ tcp_oos_insert_segment(struct tcp_seg *cseg, struct tcp_seg *next)
   }
   cseg->next = next;
 }
-#endif /* TCP_QUEUE_OOSEQ */
+#endif /* TCP_QUEUE_OOSEQ && !TCP_OOSEQ_RANGES */
+
+#if TCP_QUEUE_OOSEQ && TCP_OOSEQ_RANGES
+/** Return the number of indexed ooseq segments starting at or before 'seq' */
+static u8_t
+tcp_oos_idx_find(const struct tcp_pcb *pcb, u32_t seq)
+{
+  u8_t lo = 0;
+  u8_t hi = pcb->ooseq_num;
+
+  while (lo < hi) {
+    u8_t mid = (u8_t)((lo + hi) / 2);
+    if (TCP_SEQ_LEQ(pcb->ooseq_idx[mid]->tcphdr->seqno, seq)) {
+      lo = (u8_t)(mid + 1);
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/** Remove 'n' entries from the ooseq index, starting at 'pos' */
+static void
+tcp_oos_idx_remove(struct tcp_pcb *pcb, u8_t pos, u8_t n)
+{
+  LWIP_ASSERT("tcp_oos_idx_remove: invalid range", pos + n <= pcb->ooseq_num);
+  pcb->ooseq_num = (u8_t)(pcb->ooseq_num - n);
+  memmove(&pcb->ooseq_idx[pos], &pcb->ooseq_idx[pos + n],
+          (size_t)(pcb->ooseq_num - pos) * sizeof(struct tcp_seg *));
+}
+
+/* drop the index entry of the first ooseq segment */
+#define TCP_OOSEQ_IDX_POP(pcb) tcp_oos_idx_remove(pcb, 0, 1)
+
+/** Link 'seg' into pcb->ooseq behind the indexed segment at 'pos' - 1 */
+static void
+tcp_oos_idx_link(struct tcp_pcb *pcb, u8_t pos, struct tcp_seg *seg)
+{
+  if (pos == 0) {
+    pcb->ooseq = seg;
+  } else {
+    pcb->ooseq_idx[pos - 1]->next = seg;
+  }
+}
+
+/** Free the indexed ooseq segments from 'pos' to the end of the queue */
+static void
+tcp_oos_idx_truncate(struct tcp_pcb *pcb, u8_t pos)
+{
+  if (pos < pcb->ooseq_num) {
+#if LWIP_TCP_SACK_OUT
+    if (pcb->flags & TF_SACK) {
+      tcp_remove_sacks_gt(pcb, pcb->ooseq_idx[pos]->tcphdr->seqno);
+    }
+#endif /* LWIP_TCP_SACK_OUT */
+    tcp_segs_free(pcb->ooseq_idx[pos]);
+    tcp_oos_idx_link(pcb, pos, NULL);
+    pcb->ooseq_num = pos;
+  }
+}
+
+/* the data of 'next' directly follows 'seg' */
+#define TCP_OOSEQ_CONTIGUOUS(seg, next) \
+  ((seg)->tcphdr->seqno + (seg)->len == (next)->tcphdr->seqno)
+
+/** Check if the data of 'next' directly follows 'seg' and fits into it */
+static int
+tcp_oos_joinable(const struct tcp_seg *seg, const struct tcp_seg *next)
+{
+  return ((TCPH_FLAGS(seg->tcphdr) & TCP_FIN) == 0) &&
+         TCP_OOSEQ_CONTIGUOUS(seg, next) &&
+         ((u32_t)seg->len + next->len <= 0xFFFF);
+}
+
+/** Move the data of the queued segment 'next' onto the end of 'seg' and free
+ * 'next' (its index entry must already be removed) */
+static void
+tcp_oos_join(struct tcp_seg *seg, struct tcp_seg *next)
+{
+  pbuf_cat(seg->p, next->p);
+  next->p = NULL;
+  seg->len = (u16_t)(seg->len + next->len);
+  if (TCPH_FLAGS(next->tcphdr) & TCP_FIN) {
+    TCPH_SET_FLAG(seg->tcphdr, TCP_FIN);
+  }
+  seg->next = next->next;
+  tcp_seg_free(next);
+}
+
+/**
+ * Insert the out-of-sequence segment 'inseg' into pcb->ooseq. The insertion
+ * point is found by binary search on the ooseq index, overlapping data is
+ * trimmed and contiguous data is merged into one segment per range.
+ * If the index is full, the highest range is dropped first.
+ *
+ * Called from tcp_receive()
+ */
+static void
+tcp_oos_insert_range(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *prev = NULL;
+  struct tcp_seg *next = NULL;
+  struct tcp_seg *cseg;
+  u8_t pos;
+
+  /* check if the remote side overruns our receive window */
+  if (TCP_SEQ_GT((u32_t)tcplen + seqno, pcb->rcv_nxt + (u32_t)pcb->rcv_wnd)) {
+    LWIP_DEBUGF(TCP_INPUT_DEBUG,
+                ("tcp_receive: other end overran receive window"
+                 "seqno %"U32_F" len %"U16_F" right edge %"U32_F"\n",
+                 seqno, tcplen, pcb->rcv_nxt + pcb->rcv_wnd));
+    if (TCPH_FLAGS(inseg.tcphdr) & TCP_FIN) {
+      /* Must remove the FIN from the header as we're trimming
+       * that byte of sequence-space from the packet */
+      TCPH_FLAGS_SET(inseg.tcphdr, TCPH_FLAGS(inseg.tcphdr) & ~TCP_FIN);
+    }
+    inseg.len = (u16_t)(pcb->rcv_nxt + pcb->rcv_wnd - seqno);
+    pbuf_realloc(inseg.p, inseg.len);
+    tcplen = TCP_TCPLEN(&inseg);
+  }
+
+  pos = tcp_oos_idx_find(pcb, seqno);
+  if (pos > 0) {
+    u32_t prev_end;
+    prev = pcb->ooseq_idx[pos - 1];
+    prev_end = prev->tcphdr->seqno + TCP_TCPLEN(prev);
+    if ((TCPH_FLAGS(prev->tcphdr) & TCP_FIN) ||
+        TCP_SEQ_GEQ(prev_end, seqno + tcplen)) {
+      /* the segment holds no new data */
+      return;
+    }
+    if (prev->tcphdr->seqno == seqno) {
+      /* the segment covers all of 'prev': replace it */
+      pos--;
+      tcp_oos_idx_link(pcb, pos, prev->next);
+      tcp_oos_idx_remove(pcb, pos, 1);
+      tcp_seg_free(prev);
+      prev = (pos > 0) ? pcb->ooseq_idx[pos - 1] : NULL;
+    } else if (TCP_SEQ_GT(prev_end, seqno)) {
+      /* We need to trim the prev segment. */
+      prev->len = (u16_t)(seqno - prev->tcphdr->seqno);
+      pbuf_realloc(prev->p, prev->len);
+    }
+  }
+
+  if (TCPH_FLAGS(inseg.tcphdr) & TCP_FIN) {
+    /* received segment overlaps all following segments */
+    tcp_oos_idx_truncate(pcb, pos);
+  } else {
+    /* delete the following segments covered by the new one */
+    while (pos < pcb->ooseq_num &&
+           TCP_SEQ_GEQ(seqno + inseg.len,
+                       pcb->ooseq_idx[pos]->tcphdr->seqno + pcb->ooseq_idx[pos]->len)) {
+      next = pcb->ooseq_idx[pos];
+      if (TCPH_FLAGS(next->tcphdr) & TCP_FIN) {
+        TCPH_SET_FLAG(inseg.tcphdr, TCP_FIN);
+      }
+      tcp_oos_idx_link(pcb, pos, next->next);
+      tcp_oos_idx_remove(pcb, pos, 1);
+      tcp_seg_free(next);
+    }
+    next = (pos < pcb->ooseq_num) ? pcb->ooseq_idx[pos] : NULL;
+    if (next != NULL &&
+        TCP_SEQ_GT(seqno + inseg.len, next->tcphdr->seqno)) {
+      /* We need to trim the incoming segment. */
+      inseg.len = (u16_t)(next->tcphdr->seqno - seqno);
+      pbuf_realloc(inseg.p, inseg.len);
+    }
+    tcplen = TCP_TCPLEN(&inseg);
+  }
+
+  if (prev != NULL && tcp_oos_joinable(prev, &inseg)) {
+    /* append the data to the range ending at seqno */
+    pbuf_chain(prev->p, inseg.p);
+    prev->len = (u16_t)(prev->len + inseg.len);
+    if (TCPH_FLAGS(inseg.tcphdr) & TCP_FIN) {
+      TCPH_SET_FLAG(prev->tcphdr, TCP_FIN);
+    }
+    cseg = prev;
+    pos--;
+    if (next != NULL && tcp_oos_joinable(cseg, next)) {
+      /* the new data closes the hole to the next range */
+      tcp_oos_idx_remove(pcb, (u8_t)(pos + 1), 1);
+      tcp_oos_join(cseg, next);
+    }
+  } else {
+    if (next == NULL || !tcp_oos_joinable(&inseg, next)) {
+      if (pcb->ooseq_num >= TCP_OOSEQ_RANGES) {
+        if (pos == pcb->ooseq_num) {
+          /* index full, keep the lower ranges */
+          return;
+        }
+        tcp_oos_idx_truncate(pcb, (u8_t)(pcb->ooseq_num - 1));
+        if (pos == pcb->ooseq_num) {
+          next = NULL;
+        }
+      }
+    }
+    cseg = tcp_seg_copy(&inseg);
+    if (cseg == NULL) {
+      return;
+    }
+    tcp_oos_idx_link(pcb, pos, cseg);
+    if (next != NULL && tcp_oos_joinable(cseg, next)) {
+      /* the new data is the start of the next range: take its place */
+      pcb->ooseq_idx[pos] = cseg;
+      tcp_oos_join(cseg, next);
+    } else {
+      cseg->next = next;
+      memmove(&pcb->ooseq_idx[pos + 1], &pcb->ooseq_idx[pos],
+              (size_t)(pcb->ooseq_num - pos) * sizeof(struct tcp_seg *));
+      pcb->ooseq_idx[pos] = cseg;
+      pcb->ooseq_num++;
+    }
+  }
+
+#if LWIP_TCP_SACK_OUT
+  if (pcb->flags & TF_SACK) {
+    /* SACK the contiguous data around the new segment */
+    u8_t first = pos;
+    u8_t last = pos;
+    while (first > 0 && TCP_OOSEQ_CONTIGUOUS(pcb->ooseq_idx[first - 1], pcb->ooseq_idx[first])) {
+      first--;
+    }
+    while (last + 1 < pcb->ooseq_num && TCP_OOSEQ_CONTIGUOUS(pcb->ooseq_idx[last], pcb->ooseq_idx[last + 1])) {
+      last++;
+    }
+    tcp_add_sack(pcb, pcb->ooseq_idx[first]->tcphdr->seqno,
+                 pcb->ooseq_idx[last]->tcphdr->seqno + pcb->ooseq_idx[last]->len);
+  }
+#endif /* LWIP_TCP_SACK_OUT */
+}
+
+/**
+ * Free the highest range on pcb->ooseq: reclaims memory without dropping the
+ * out-of-sequence data that is closest to rcv_nxt.
+ *
+ * @param pcb the tcp_pcb to free ooseq data from
+ */
+void
+tcp_free_ooseq_tail(struct tcp_pcb *pcb)
+{
+  u8_t pos;
+
+  if (pcb->ooseq_num == 0) {
+    return;
+  }
+  pos = (u8_t)(pcb->ooseq_num - 1);
+  /* a range longer than 64 KByte spans several segments */
+  while (pos > 0 && TCP_OOSEQ_CONTIGUOUS(pcb->ooseq_idx[pos - 1], pcb->ooseq_idx[pos])) {
+    pos--;
+  }
+  tcp_oos_idx_truncate(pcb, pos);
+}
+#else /* TCP_QUEUE_OOSEQ && TCP_OOSEQ_RANGES */
+#define TCP_OOSEQ_IDX_POP(pcb)
+#endif /* TCP_QUEUE_OOSEQ && TCP_OOSEQ_RANGES */
 
 /** Remove segments from a list if the incoming ACK acknowledges them */
 static struct tcp_seg *
@@ -1112,6 +1414,11 @@ tcp_free_acked_segments(struct tcp_pcb *pcb, struct tcp_seg *seg_list, const cha
 
     pcb->snd_queuelen = (u16_t)(pcb->snd_queuelen - clen);
     recv_acked = (tcpwnd_size_t)(recv_acked + next->len);
+#if LWIP_TCP_SACK_IN
+    if ((pcb->flags & TF_SACK) && !(next->flags & TF_SEG_SACKED)) {
+      tcp_rack_delivered(pcb, next, sys_now());
+    }
+#endif /* LWIP_TCP_SACK_IN */
     tcp_seg_free(next);
 
     LWIP_DEBUGF(TCP_QLEN_DEBUG, ("%"TCPWNDSIZE_F" (after freeing %s)\n",
@@ -1212,7 +1519,7 @@ tcp_receive(struct tcp_pcb *pcb)
                 /* Inflate the congestion window */
                 TCP_WND_INC(pcb->cwnd, pcb->mss);
               }
-              if (pcb->dupacks >= 3) {
+              if ((pcb->dupacks >= 3) && TCP_DUPACK_REXMIT()) {
                 /* Do fast retransmit (checked via TF_INFR, not via dupacks count) */
                 tcp_rexmit_fast(pcb);
               }
@@ -1232,10 +1539,12 @@ tcp_receive(struct tcp_pcb *pcb)
       /* Reset the "IN Fast Retransmit" flag, since we are no longer
          in fast retransmit. Also reset the congestion window to the
          slow start threshold. */
-      if (pcb->flags & TF_INFR) {
+      if ((pcb->flags & TF_INFR) && TCP_RECOVERY_DONE(pcb)) {
         tcp_clear_flags(pcb, TF_INFR);
-        pcb->cwnd = pcb->ssthresh;
-        pcb->bytes_acked = 0;
+#if LWIP_TCP_SACK_IN
+        pcb->rack_flags &= (u8_t)~TCP_SACK_RECOVERY;
+#endif /* LWIP_TCP_SACK_IN */
+        TCP_CC_OPS(pcb)->recovered(pcb);
       }
 
       /* Reset the number of retransmissions. */
@@ -1252,25 +1561,9 @@ tcp_receive(struct tcp_pcb *pcb)
       pcb->lastack = ackno;
 
       /* Update the congestion control variables (cwnd and
-         ssthresh). */
-      if (pcb->state >= ESTABLISHED) {
-        if (pcb->cwnd < pcb->ssthresh) {
-          tcpwnd_size_t increase;
-          /* limit to 1 SMSS segment during period following RTO */
-          u8_t num_seg = (pcb->flags & TF_RTO) ? 1 : 2;
-          /* RFC 3465, section 2.2 Slow Start */
-          increase = LWIP_MIN(acked, (tcpwnd_size_t)(num_seg * pcb->mss));
-          TCP_WND_INC(pcb->cwnd, increase);
-          LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: slow start cwnd %"TCPWNDSIZE_F"\n", pcb->cwnd));
-        } else {
-          /* RFC 3465, section 2.1 Congestion Avoidance */
-          TCP_WND_INC(pcb->bytes_acked, acked);
-          if (pcb->bytes_acked >= pcb->cwnd) {
-            pcb->bytes_acked = (tcpwnd_size_t)(pcb->bytes_acked - pcb->cwnd);
-            TCP_WND_INC(pcb->cwnd, pcb->mss);
-          }
-          LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: congestion avoidance cwnd %"TCPWNDSIZE_F"\n", pcb->cwnd));
-        }
+         ssthresh), unless still in (SACK) recovery. */
+      if ((pcb->state >= ESTABLISHED) && !(pcb->flags & TF_INFR)) {
+        TCP_CC_OPS(pcb)->cong_avoid(pcb, acked);
       }
       LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_receive: ACK for %"U32_F", unacked->seqno %"U32_F":%"U32_F"\n",
                                     ackno,
@@ -1282,6 +1575,22 @@ tcp_receive(struct tcp_pcb *pcb)
       /* Remove segment from the unacknowledged list if the incoming
          ACK acknowledges them. */
       pcb->unacked = tcp_free_acked_segments(pcb, pcb->unacked, "unacked", pcb->unsent);
+#if TCP_TSO
+      if ((pcb->unacked != NULL) &&
+          TCP_SEQ_LT(lwip_ntohl(pcb->unacked->tcphdr->seqno), ackno)) {
+        /* A super-segment has been acknowledged in part: remove the acked
+           frames, so that a retransmission only carries the missing ones. */
+        u16_t trim = (u16_t)(ackno - lwip_ntohl(pcb->unacked->tcphdr->seqno));
+        if (tcp_trim_unacked_seg(pcb, pcb->unacked, trim) == ERR_OK) {
+          recv_acked = (tcpwnd_size_t)(recv_acked + trim);
+#if LWIP_TCP_SACK_IN
+          if ((pcb->flags & TF_SACK) && !(pcb->unacked->flags & TF_SEG_SACKED)) {
+            tcp_rack_delivered(pcb, pcb->unacked, sys_now());
+          }
+#endif /* LWIP_TCP_SACK_IN */
+        }
+      }
+#endif /* TCP_TSO */
       /* We go through the ->unsent list to see if any of the segments
          on the list are acknowledged by the ACK. This may seem
          strange since an "unsent" segment shouldn't be acked. The
@@ -1335,6 +1644,14 @@ tcp_receive(struct tcp_pcb *pcb)
       tcp_send_empty_ack(pcb);
     }
 
+#if LWIP_TCP_SACK_IN
+    /* Update the scoreboard with the SACK blocks of an acceptable ACK */
+    if ((pcb->flags & TF_SACK) && (pcb->unacked != NULL) && TCP_SEQ_LEQ(ackno, pcb->lastack) &&
+        ((tcp_in_sack_num > 0) || (pcb->rack_flags & TCP_SACK_RECOVERY))) {
+      tcp_sack_receive(pcb);
+    }
+#endif /* LWIP_TCP_SACK_IN */
+
     LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_receive: pcb->rttest %"U32_F" rtseq %"U32_F" ackno %"U32_F"\n",
                                 pcb->rttest, pcb->rtseq, ackno));
 
@@ -1497,6 +1814,7 @@ tcp_receive(struct tcp_pcb *pcb)
             while (pcb->ooseq != NULL) {
               struct tcp_seg *old_ooseq = pcb->ooseq;
               pcb->ooseq = pcb->ooseq->next;
+              TCP_OOSEQ_IDX_POP(pcb);
               tcp_seg_free(old_ooseq);
             }
           } else {
@@ -1515,6 +1833,7 @@ tcp_receive(struct tcp_pcb *pcb)
               }
               tmp = next;
               next = next->next;
+              TCP_OOSEQ_IDX_POP(pcb);
               tcp_seg_free(tmp);
             }
             /* Now trim right side of inseg if it overlaps with the first
@@ -1604,6 +1923,7 @@ tcp_receive(struct tcp_pcb *pcb)
           }
 
           pcb->ooseq = cseg->next;
+          TCP_OOSEQ_IDX_POP(pcb);
           tcp_seg_free(cseg);
         }
 #if LWIP_TCP_SACK_OUT
@@ -1645,6 +1965,10 @@ tcp_receive(struct tcp_pcb *pcb)
         /* We get here if the incoming segment is out-of-sequence. */
 
 #if TCP_QUEUE_OOSEQ
+#if TCP_OOSEQ_RANGES
+        /* We merge the segment into the ranges on the ->ooseq queue. */
+        tcp_oos_insert_range(pcb);
+#else /* TCP_OOSEQ_RANGES */
         /* We queue the segment on the ->ooseq queue. */
         if (pcb->ooseq == NULL) {
           pcb->ooseq = tcp_seg_copy(&inseg);
@@ -1816,6 +2140,7 @@ tcp_receive(struct tcp_pcb *pcb)
           }
 #endif /* LWIP_TCP_SACK_OUT */
         }
+#endif /* TCP_OOSEQ_RANGES */
 #if defined(TCP_OOSEQ_BYTES_LIMIT) || defined(TCP_OOSEQ_PBUFS_LIMIT)
         {
           /* Check that the data on ooseq doesn't exceed one of the limits
@@ -1851,6 +2176,9 @@ tcp_receive(struct tcp_pcb *pcb)
                 tcp_remove_sacks_gt(pcb, next->tcphdr->seqno);
               }
 #endif /* LWIP_TCP_SACK_OUT */
+#if TCP_OOSEQ_RANGES
+              pcb->ooseq_num = tcp_oos_idx_find(pcb, next->tcphdr->seqno - 1);
+#endif /* TCP_OOSEQ_RANGES */
               /* too much ooseq data, dump this and everything after it */
               tcp_segs_free(next);
               if (prev == NULL) {
@@ -1897,6 +2225,17 @@ tcp_get_next_optbyte(void)
   }
 }
 
+#if LWIP_TCP_SACK_IN
+static u32_t
+tcp_get_next_optu32(void)
+{
+  u32_t val = tcp_get_next_optbyte();
+  val = (val << 8) | tcp_get_next_optbyte();
+  val = (val << 8) | tcp_get_next_optbyte();
+  return (val << 8) | tcp_get_next_optbyte();
+}
+#endif /* LWIP_TCP_SACK_IN */
+
 /**
  * Parses the options contained in the incoming segment.
  *
@@ -1916,6 +2255,10 @@ tcp_parseopt(struct tcp_pcb *pcb)
 
   LWIP_ASSERT("tcp_parseopt: invalid pcb", pcb != NULL);
 
+#if LWIP_TCP_SACK_IN
+  tcp_in_sack_num = 0;
+#endif /* LWIP_TCP_SACK_IN */
+
   /* Parse the TCP MSS option, if present. */
   if (tcphdr_optlen != 0) {
     for (tcp_optidx = 0; tcp_optidx < tcphdr_optlen; ) {
@@ -1993,7 +2336,7 @@ tcp_parseopt(struct tcp_pcb *pcb)
           tcp_optidx += LWIP_TCP_OPT_LEN_TS - 6;
           break;
 #endif /* LWIP_TCP_TIMESTAMPS */
-#if LWIP_TCP_SACK_OUT
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
         case LWIP_TCP_OPT_SACK_PERM:
           LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: SACK_PERM\n"));
           if (tcp_get_next_optbyte() != LWIP_TCP_OPT_LEN_SACK_PERM || (tcp_optidx - 2 + LWIP_TCP_OPT_LEN_SACK_PERM) > tcphdr_optlen) {
@@ -2007,7 +2350,29 @@ tcp_parseopt(struct tcp_pcb *pcb)
             tcp_set_flags(pcb, TF_SACK);
           }
           break;
-#endif /* LWIP_TCP_SACK_OUT */
+#endif /* LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN */
+#if LWIP_TCP_SACK_IN
+        case LWIP_TCP_OPT_SACK:
+          LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: SACK\n"));
+          data = tcp_get_next_optbyte();
+          if ((data < 10) || (((data - 2) & 7) != 0) || (tcp_optidx - 2 + data) > tcphdr_optlen) {
+            /* Bad length */
+            LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+            return;
+          }
+          /* Only use the blocks if SACK was negotiated */
+          for (data = (u8_t)((data - 2) / 8); data > 0; data--) {
+            u32_t left = tcp_get_next_optu32();
+            u32_t right = tcp_get_next_optu32();
+            if ((pcb->flags & TF_SACK) && (tcp_in_sack_num < TCP_IN_SACK_MAX) &&
+                TCP_SEQ_LT(left, right)) {
+              tcp_in_sacks[tcp_in_sack_num].left = left;
+              tcp_in_sacks[tcp_in_sack_num].right = right;
+              tcp_in_sack_num++;
+            }
+          }
+          break;
+#endif /* LWIP_TCP_SACK_IN */
         default:
           LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: other\n"));
           data = tcp_get_next_optbyte();
@@ -2132,7 +2497,7 @@ tcp_remove_sacks_lt(struct tcp_pcb *pcb, u32_t seq)
   }
 }
 
-#if defined(TCP_OOSEQ_BYTES_LIMIT) || defined(TCP_OOSEQ_PBUFS_LIMIT)
+#if defined(TCP_OOSEQ_BYTES_LIMIT) || defined(TCP_OOSEQ_PBUFS_LIMIT) || TCP_OOSEQ_RANGES
 /**
  * Called to remove a range of SACKs.
  *
@@ -2171,8 +2536,100 @@ tcp_remove_sacks_gt(struct tcp_pcb *pcb, u32_t seq)
     pcb->rcv_sacks[i].left = pcb->rcv_sacks[i].right = 0;
   }
 }
-#endif /* TCP_OOSEQ_BYTES_LIMIT || TCP_OOSEQ_PBUFS_LIMIT */
+#endif /* TCP_OOSEQ_BYTES_LIMIT || TCP_OOSEQ_PBUFS_LIMIT || TCP_OOSEQ_RANGES */
 
 #endif /* LWIP_TCP_SACK_OUT */
 
+#if LWIP_TCP_SACK_IN
+/**
+ * Update the RACK state (RFC 8985, section 6.2) for a segment that has been
+ * delivered, i.e. cumulatively acknowledged or SACKed.
+ *
+ * @param pcb the tcp_pcb the segment belongs to
+ * @param seg the delivered segment
+ * @param now the current time (sys_now())
+ */
+static void
+tcp_rack_delivered(struct tcp_pcb *pcb, struct tcp_seg *seg, u32_t now)
+{
+  u32_t end = lwip_ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg);
+  u32_t rtt = now - seg->xmit_time;
+
+  if (seg->flags & TF_SEG_REXMIT) {
+    /* The ACK may be for the original transmission: don't use it unless the
+       RTT is plausible for the retransmission. */
+    if (!(pcb->rack_flags & TCP_RACK_VALID) || (rtt < pcb->rack_min_rtt)) {
+      return;
+    }
+  } else if ((pcb->rack_flags & TCP_RACK_VALID) && TCP_SEQ_LT(end, pcb->rack_fack)) {
+    /* delivered after data sent later */
+    pcb->rack_flags |= TCP_RACK_REORDER;
+  }
+
+  if (!(pcb->rack_flags & TCP_RACK_VALID) || (rtt < pcb->rack_min_rtt)) {
+    pcb->rack_min_rtt = rtt;
+  }
+  pcb->rack_rtt = rtt;
+  if (!(pcb->rack_flags & TCP_RACK_VALID) ||
+      ((s32_t)(seg->xmit_time - pcb->rack_xmit_ts) > 0) ||
+      ((seg->xmit_time == pcb->rack_xmit_ts) && TCP_SEQ_GT(end, pcb->rack_end_seq))) {
+    pcb->rack_xmit_ts = seg->xmit_time;
+    pcb->rack_end_seq = end;
+  }
+  if (!(pcb->rack_flags & TCP_RACK_VALID) || TCP_SEQ_GT(end, pcb->rack_fack)) {
+    pcb->rack_fack = end;
+  }
+  pcb->rack_flags |= TCP_RACK_VALID;
+}
+
+/**
+ * Called by tcp_receive() for ACKs carrying SACK blocks (or during SACK
+ * recovery): marks the unacked segments covered by a SACK block on the
+ * scoreboard and runs loss detection.
+ * Super-segments (TCP_TSO) partly covered by a SACK block are split at the
+ * block edge, so that only the missing frames are retransmitted.
+ *
+ * @param pcb the tcp_pcb for which an ACK arrived
+ */
+static void
+tcp_sack_receive(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg;
+  u32_t left, right, now;
+  u8_t i;
+
+  now = sys_now();
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    if (seg->flags & TF_SEG_SACKED) {
+      continue;
+    }
+    left = lwip_ntohl(seg->tcphdr->seqno);
+    right = left + TCP_TCPLEN(seg);
+    for (i = 0; i < tcp_in_sack_num; i++) {
+      if (TCP_SEQ_LEQ(tcp_in_sacks[i].left, left) && TCP_SEQ_GEQ(tcp_in_sacks[i].right, right)) {
+        seg->flags = (u8_t)((seg->flags & ~TF_SEG_LOST) | TF_SEG_SACKED);
+        tcp_rack_delivered(pcb, seg, now);
+        break;
+      }
+#if TCP_TSO
+      if (TCP_SEQ_BETWEEN(tcp_in_sacks[i].left, left + 1, right - 1)) {
+        right = tcp_in_sacks[i].left;
+      } else if (TCP_SEQ_BETWEEN(tcp_in_sacks[i].right, left + 1, right - 1)) {
+        right = tcp_in_sacks[i].right;
+      } else {
+        continue;
+      }
+      /* The head part is checked again against all blocks, the remainder
+         is the next segment in the loop */
+      if (tcp_split_unacked_seg(pcb, seg, (u16_t)(right - left)) != ERR_OK) {
+        break;
+      }
+      i = (u8_t)-1;
+#endif /* TCP_TSO */
+    }
+  }
+  tcp_rexmit_sack(pcb);
+}
+#endif /* LWIP_TCP_SACK_IN */
+
 #endif /* LWIP_TCP */
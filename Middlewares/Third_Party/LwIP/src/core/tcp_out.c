@@ -74,7 +74,7 @@
 #include "lwip/stats.h"
 #include "lwip/ip6.h"
 #include "lwip/ip6_addr.h"
-#if LWIP_TCP_TIMESTAMPS
+#if LWIP_TCP_TIMESTAMPS || TCP_WRITE_ZEROCOPY
 #include "lwip/sys.h"
 #endif
 
@@ -124,8 +124,14 @@
 #endif
 #endif
 
+#if TCP_TSO
+/** Payload bytes of each frame a super-segment is cut into */
+#define TCP_TSO_FRAME_LEN(seg, pcb) ((u16_t)((pcb)->mss - LWIP_TCP_OPT_LENGTH_SEGMENT((seg)->flags, pcb)))
+#endif /* TCP_TSO */
+
 /* Forward declarations.*/
 static err_t tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif);
+static int tcp_output_segment_busy(const struct tcp_seg *seg);
 
 /* tcp_route: common code that returns a fixed bound netif or calls ip_route */
 static struct netif *
@@ -143,7 +149,7 @@ tcp_route(const struct tcp_pcb *pcb, const ip_addr_t *src, const ip_addr_t *dst)
 /**
  * Create a TCP segment with prefilled header.
  *
- * Called by @ref tcp_write, @ref tcp_enqueue_flags and @ref tcp_split_unsent_seg
+ * Called by @ref tcp_write, @ref tcp_enqueue_flags and tcp_split_seg
  *
  * @param pcb Protocol control block for the TCP connection.
  * @param p pbuf that is used to hold the TCP header.
@@ -237,7 +243,12 @@ tcp_pbuf_prealloc(pbuf_layer layer, u16_t length, u16_t max_length,
   LWIP_UNUSED_ARG(pcb);
   LWIP_UNUSED_ARG(apiflags);
   LWIP_UNUSED_ARG(first_seg);
+#if TCP_TSO
+  /* don't reserve a whole super-segment for every small write */
+  alloc = LWIP_MIN(max_length, LWIP_MEM_ALIGN_SIZE(TCP_OVERSIZE_CALC_LENGTH(length)));
+#else /* TCP_TSO */
   alloc = max_length;
+#endif /* TCP_TSO */
 #else /* LWIP_NETIF_TX_SINGLE_PBUF */
   if (length < max_length) {
     /* Should we allocate an oversized pbuf, or just the minimum
@@ -295,6 +306,37 @@ tcp_seg_add_chksum(u16_t chksum, u16_t len, u16_t *seg_chksum,
 }
 #endif /* TCP_CHECKSUM_ON_COPY */
 
+#if TCP_TSO
+/** Size (data and options) of the segments tcp_write() creates with TCP_TSO:
+ * a multiple of the frame payload, at most TCP_TSO_MAX_SEGS frames and half
+ * of the congestion and send windows (so two super-segments can be in flight).
+ * Only IPv4 output knows how to cut super-segments.
+ *
+ * @param pcb the tcp pcb to write to
+ * @param mss_local segment size tcp_write() would use without TSO
+ * @param optlen length of the options in each segment
+ * @return the segment size to use
+ */
+static u16_t
+tcp_tso_seg_size(const struct tcp_pcb *pcb, u16_t mss_local, u8_t optlen)
+{
+  u32_t frame, size;
+
+  if ((mss_local < pcb->mss) || (pcb->mss <= optlen) || !IP_IS_V4(&pcb->remote_ip)) {
+    return mss_local;
+  }
+  frame = (u32_t)(pcb->mss - optlen);
+  size = LWIP_MIN(pcb->snd_wnd_max, pcb->cwnd) / 2;
+  size = LWIP_MIN(size, (u32_t)TCP_TSO_MAX_SEGS * frame);
+  size = LWIP_MIN(size, 0xFFFFUL - IP_HLEN - TCP_HLEN - optlen);
+  size -= size % frame;
+  if (size <= frame) {
+    return mss_local;
+  }
+  return (u16_t)(size + optlen);
+}
+#endif /* TCP_TSO */
+
 /** Checks if tcp_write is allowed or not (checks state, snd_buf and snd_queuelen).
  *
  * @param pcb the tcp pcb to check for
@@ -448,6 +490,9 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
   {
     optlen = LWIP_TCP_OPT_LENGTH_SEGMENT(0, pcb);
   }
+#if TCP_TSO
+  mss_local = tcp_tso_seg_size(pcb, mss_local, optlen);
+#endif /* TCP_TSO */
 
 
   /*
@@ -483,6 +528,15 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
 
     /* Usable space at the end of the last unsent segment */
     unsent_optlen = LWIP_TCP_OPT_LENGTH_SEGMENT(last_unsent->flags, pcb);
+#if TCP_TSO
+    /* the super-segment size follows cwnd, which may have shrunk since
+       last_unsent was allocated: keep using the space reserved there */
+    space = (u16_t)(last_unsent->len + unsent_optlen);
+#if TCP_OVERSIZE
+    space = (u16_t)(space + pcb->unsent_oversize);
+#endif /* TCP_OVERSIZE */
+    mss_local = LWIP_MAX(mss_local, space);
+#endif /* TCP_TSO */
     LWIP_ASSERT("mss_local is too small", mss_local >= last_unsent->len + unsent_optlen);
     space = mss_local - (last_unsent->len + unsent_optlen);
 
@@ -557,6 +611,7 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
         struct pbuf *p;
         for (p = last_unsent->p; p->next != NULL; p = p->next);
         if (((p->type_internal & (PBUF_TYPE_FLAG_STRUCT_DATA_CONTIGUOUS | PBUF_TYPE_FLAG_DATA_VOLATILE)) == 0) &&
+            ((p->flags & PBUF_FLAG_IS_CUSTOM) == 0) &&
             (const u8_t *)p->payload + p->len == (const u8_t *)arg) {
           LWIP_ASSERT("tcp_write: ROM pbufs cannot be oversized", pos == 0);
           extendlen = seglen;
@@ -811,22 +866,272 @@ memerr:
   return ERR_MEM;
 }
 
+#if TCP_WRITE_ZEROCOPY
+/** Custom free function of the pbufs created by tcp_write_zc(): drops one
+ * reference from the write handle and reports completion once the last
+ * reference is gone. */
+static void
+tcp_zc_pbuf_free(struct pbuf *p)
+{
+  struct tcp_zc_pbuf *zp = (struct tcp_zc_pbuf *)p;
+  struct tcp_zc_write *zc = zp->zc;
+  u16_t refcnt;
+  SYS_ARCH_DECL_PROTECT(old_level);
+
+  memp_free(MEMP_TCP_ZC_PBUF, zp);
+
+  /* the driver may free its last reference from another context */
+  SYS_ARCH_PROTECT(old_level);
+  LWIP_ASSERT("tcp_zc_pbuf_free: refcnt underflow", zc->refcnt > 0);
+  refcnt = --zc->refcnt;
+  SYS_ARCH_UNPROTECT(old_level);
+
+  if ((refcnt == 0) && (zc->done_fn != NULL)) {
+    zc->done_fn(zc, zc->done_arg);
+  }
+}
+
+/** Allocate a PBUF_ROM custom pbuf referencing len bytes at data and account
+ * it to the write handle. */
+static struct pbuf *
+tcp_zc_pbuf_alloc(struct tcp_zc_write *zc, const u8_t *data, u16_t len)
+{
+  struct tcp_zc_pbuf *zp;
+  struct pbuf *p;
+
+  zp = (struct tcp_zc_pbuf *)memp_malloc(MEMP_TCP_ZC_PBUF);
+  if (zp == NULL) {
+    LWIP_DEBUGF(TCP_OUTPUT_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("tcp_write_zc: could not allocate memory for data reference\n"));
+    return NULL;
+  }
+  zp->pc.custom_free_function = tcp_zc_pbuf_free;
+  zp->zc = zc;
+  p = pbuf_alloced_custom(PBUF_RAW, len, PBUF_ROM, &zp->pc, LWIP_CONST_CAST(u8_t *, data), len);
+  LWIP_ASSERT("tcp_write_zc: pbuf_alloced_custom failed", p != NULL);
+  /* no reference can be dropped concurrently before tcp_write_zc() returns */
+  zc->refcnt++;
+  return p;
+}
+
 /**
- * Split segment on the head of the unsent queue.  If return is not
- * ERR_OK, existing head remains intact
+ * @ingroup tcp_raw
+ * Write data for sending without copying it (but does not send it immediately).
+ *
+ * Like tcp_write() without TCP_WRITE_FLAG_COPY, the data is only referenced.
+ * In addition, the data may be scattered over several buffers described by
+ * an iovec array, and the application is notified through zc->done_fn as soon
+ * as the stack has released all references to the data. Until then, none of
+ * the buffers may be changed and the handle zc must stay valid.
+ *
+ * Data passed to one call always starts a new segment; segments are filled
+ * up to the MSS across iovec boundaries by chaining one reference pbuf per
+ * slice. The call either enqueues all data or nothing: on error, done_fn is
+ * not called and the application keeps ownership of its buffers.
+ *
+ * @param pcb Protocol control block for the TCP connection to enqueue data for.
+ * @param zc Write handle with done_fn/done_arg set, owned by the application.
+ *           It must not be reused before done_fn has been called.
+ * @param iov Array of data chunks to enqueue in order
+ * @param iovcnt Number of entries in iov
+ * @param apiflags TCP_WRITE_FLAG_MORE (0x02): PSH flag will not be set on the
+ *        last segment (TCP_WRITE_FLAG_COPY is ignored)
+ * @return ERR_OK if enqueued, another err_t on error
+ */
+err_t
+tcp_write_zc(struct tcp_pcb *pcb, struct tcp_zc_write *zc,
+             const struct tcp_zc_iovec *iov, u16_t iovcnt, u8_t apiflags)
+{
+  struct tcp_seg *last_unsent = NULL, *seg = NULL, *prev_seg = NULL, *queue = NULL;
+  u32_t total = 0;
+  u16_t len;
+  u16_t pos = 0; /* position in the data described by 'iov' */
+  u16_t idx = 0; /* current iovec */
+  u16_t off = 0; /* position in the current iovec */
+  u16_t queuelen;
+  u8_t optlen;
+  u8_t optflags = 0;
+  err_t err;
+  u16_t mss_local;
+  u16_t i;
+
+  LWIP_ERROR("tcp_write_zc: invalid pcb", pcb != NULL, return ERR_ARG);
+  LWIP_ERROR("tcp_write_zc: invalid zc", zc != NULL, return ERR_ARG);
+  LWIP_ERROR("tcp_write_zc: invalid iov", (iov != NULL) || (iovcnt == 0), return ERR_ARG);
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  for (i = 0; i < iovcnt; i++) {
+    LWIP_ERROR("tcp_write_zc: iov base == NULL (programmer violates API)",
+               (iov[i].base != NULL) || (iov[i].len == 0), return ERR_ARG);
+    total += iov[i].len;
+  }
+  LWIP_ERROR("tcp_write_zc: invalid total length", (total > 0) && (total <= 0xFFFF), return ERR_ARG);
+  len = (u16_t)total;
+
+  /* don't allocate segments bigger than half the maximum window we ever received */
+  mss_local = LWIP_MIN(pcb->mss, TCPWND_MIN16(pcb->snd_wnd_max / 2));
+  mss_local = mss_local ? mss_local : pcb->mss;
+
+  LWIP_DEBUGF(TCP_OUTPUT_DEBUG, ("tcp_write_zc(pcb=%p, zc=%p, len=%"U16_F", iovcnt=%"U16_F", apiflags=%"U16_F")\n",
+                                 (void *)pcb, (void *)zc, len, iovcnt, (u16_t)apiflags));
+
+  err = tcp_write_checks(pcb, len);
+  if (err != ERR_OK) {
+    return err;
+  }
+  queuelen = pcb->snd_queuelen;
+
+#if LWIP_TCP_TIMESTAMPS
+  if ((pcb->flags & TF_TIMESTAMP)) {
+    optflags = TF_SEG_OPTS_TS;
+    optlen = LWIP_TCP_OPT_LENGTH_SEGMENT(TF_SEG_OPTS_TS, pcb);
+    /* ensure that segments can hold at least one data byte... */
+    mss_local = LWIP_MAX(mss_local, LWIP_TCP_OPT_LEN_TS + 1);
+  } else
+#endif /* LWIP_TCP_TIMESTAMPS */
+  {
+    optlen = LWIP_TCP_OPT_LENGTH_SEGMENT(0, pcb);
+  }
+
+  if (pcb->unsent != NULL) {
+    for (last_unsent = pcb->unsent; last_unsent->next != NULL;
+         last_unsent = last_unsent->next);
+  }
+
+  /* This call holds a reference itself, so that done_fn cannot be called
+     while segments are built (or freed again on error). */
+  zc->refcnt = 1;
+
+  while (pos < len) {
+    struct pbuf *p;
+    u16_t left = len - pos;
+    u16_t max_len = mss_local - optlen;
+    u16_t seglen = LWIP_MIN(left, max_len);
+    u16_t filled = 0;
+#if TCP_CHECKSUM_ON_COPY
+    u16_t chksum = 0;
+    u8_t chksum_swapped = 0;
+#endif /* TCP_CHECKSUM_ON_COPY */
+
+    /* The header pbuf is followed by one reference per iovec slice. */
+    if ((p = pbuf_alloc(PBUF_TRANSPORT, optlen, PBUF_RAM)) == NULL) {
+      LWIP_DEBUGF(TCP_OUTPUT_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("tcp_write_zc: could not allocate memory for header pbuf\n"));
+      goto memerr;
+    }
+    while (filled < seglen) {
+      struct pbuf *d;
+      u16_t chunk;
+
+      while (off == iov[idx].len) {
+        idx++;
+        off = 0;
+      }
+      chunk = (u16_t)LWIP_MIN(seglen - filled, iov[idx].len - off);
+      d = tcp_zc_pbuf_alloc(zc, (const u8_t *)iov[idx].base + off, chunk);
+      if (d == NULL) {
+        pbuf_free(p);
+        goto memerr;
+      }
+#if TCP_CHECKSUM_ON_COPY
+      /* calculate the checksum of nocopy-data */
+      tcp_seg_add_chksum(~inet_chksum((const u8_t *)iov[idx].base + off, chunk), chunk,
+                         &chksum, &chksum_swapped);
+#endif /* TCP_CHECKSUM_ON_COPY */
+      pbuf_cat(p/*header*/, d/*data*/);
+      filled = (u16_t)(filled + chunk);
+      off = (u16_t)(off + chunk);
+    }
+
+    queuelen += pbuf_clen(p);
+    if (queuelen > LWIP_MIN(TCP_SND_QUEUELEN, TCP_SNDQUEUELEN_OVERFLOW)) {
+      LWIP_DEBUGF(TCP_OUTPUT_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("tcp_write_zc: queue too long %"U16_F" (%d)\n",
+                  queuelen, (int)TCP_SND_QUEUELEN));
+      pbuf_free(p);
+      goto memerr;
+    }
+
+    if ((seg = tcp_create_segment(pcb, p, 0, pcb->snd_lbb + pos, optflags)) == NULL) {
+      goto memerr;
+    }
+#if TCP_CHECKSUM_ON_COPY
+    seg->chksum = chksum;
+    seg->chksum_swapped = chksum_swapped;
+    seg->flags |= TF_SEG_DATA_CHECKSUMMED;
+#endif /* TCP_CHECKSUM_ON_COPY */
+
+    if (queue == NULL) {
+      queue = seg;
+    } else {
+      LWIP_ASSERT("prev_seg != NULL", prev_seg != NULL);
+      prev_seg->next = seg;
+    }
+    prev_seg = seg;
+
+    LWIP_DEBUGF(TCP_OUTPUT_DEBUG | LWIP_DBG_TRACE, ("tcp_write_zc: queueing %"U32_F":%"U32_F"\n",
+                lwip_ntohl(seg->tcphdr->seqno),
+                lwip_ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg)));
+
+    pos += seglen;
+  }
+
+  /* All segments were created, commit the transaction. */
+  if (last_unsent == NULL) {
+    pcb->unsent = queue;
+  } else {
+    last_unsent->next = queue;
+  }
+#if TCP_OVERSIZE
+  /* the new last segment has no space left behind its data */
+  pcb->unsent_oversize = 0;
+#endif /* TCP_OVERSIZE */
+  pcb->snd_lbb += len;
+  pcb->snd_buf -= len;
+  pcb->snd_queuelen = queuelen;
+
+  LWIP_DEBUGF(TCP_QLEN_DEBUG, ("tcp_write_zc: %"S16_F" (after enqueued)\n",
+                               pcb->snd_queuelen));
+
+  /* Set the PSH flag in the last segment that we enqueued. */
+  if (seg != NULL && seg->tcphdr != NULL && ((apiflags & TCP_WRITE_FLAG_MORE) == 0)) {
+    TCPH_SET_FLAG(seg->tcphdr, TCP_PSH);
+  }
+
+  /* Drop the reference of this call: the segments keep the data alive. */
+  LWIP_ASSERT("tcp_write_zc: data references queued", zc->refcnt > 1);
+  zc->refcnt--;
+  return ERR_OK;
+memerr:
+  tcp_set_flags(pcb, TF_NAGLEMEMERR);
+  TCP_STATS_INC(tcp.memerr);
+
+  if (queue != NULL) {
+    tcp_segs_free(queue);
+  }
+  /* All data references are gone again, the application keeps its buffers. */
+  LWIP_ASSERT("tcp_write_zc: stale data references", zc->refcnt == 1);
+  zc->refcnt = 0;
+  LWIP_DEBUGF(TCP_QLEN_DEBUG | LWIP_DBG_STATE, ("tcp_write_zc: %"S16_F" (with mem err)\n", pcb->snd_queuelen));
+  return ERR_MEM;
+}
+#endif /* TCP_WRITE_ZEROCOPY */
+
+/**
+ * Split a queued segment.  If return is not ERR_OK, the segment remains
+ * intact
  *
  * The split is accomplished by creating a new TCP segment and pbuf
  * which holds the remainder payload after the split.  The original
  * pbuf is trimmed to new length.  This allows splitting of read-only
  * pbufs
  *
- * @param pcb the tcp_pcb for which to split the unsent head
- * @param split the amount of payload to remain in the head
+ * @param pcb the tcp_pcb the segment belongs to
+ * @param useg the segment to split (the remainder is queued after it)
+ * @param split the amount of payload to remain in useg
  */
-err_t
-tcp_split_unsent_seg(struct tcp_pcb *pcb, u16_t split)
+static err_t
+tcp_split_seg(struct tcp_pcb *pcb, struct tcp_seg *useg, u16_t split)
 {
-  struct tcp_seg *seg = NULL, *useg = NULL;
+  struct tcp_seg *seg = NULL;
   struct pbuf *p = NULL;
   u8_t optlen;
   u8_t optflags;
@@ -840,9 +1145,8 @@ tcp_split_unsent_seg(struct tcp_pcb *pcb, u16_t split)
   struct pbuf *q;
 #endif /* TCP_CHECKSUM_ON_COPY */
 
-  LWIP_ASSERT("tcp_split_unsent_seg: invalid pcb", pcb != NULL);
+  LWIP_ASSERT("tcp_split_seg: invalid pcb", pcb != NULL);
 
-  useg = pcb->unsent;
   if (useg == NULL) {
     return ERR_MEM;
   }
@@ -856,7 +1160,8 @@ tcp_split_unsent_seg(struct tcp_pcb *pcb, u16_t split)
     return ERR_OK;
   }
 
-  LWIP_ASSERT("split <= mss", split <= pcb->mss);
+  /* with TCP_TSO, super-segments are also split to fit the window */
+  LWIP_ASSERT("split <= mss", TCP_TSO || (split <= pcb->mss));
   LWIP_ASSERT("useg->len > 0", useg->len > 0);
 
   /* We should check that we don't exceed TCP_SND_QUEUELEN but we need
@@ -877,7 +1182,7 @@ tcp_split_unsent_seg(struct tcp_pcb *pcb, u16_t split)
   p = pbuf_alloc(PBUF_TRANSPORT, remainder + optlen, PBUF_RAM);
   if (p == NULL) {
     LWIP_DEBUGF(TCP_OUTPUT_DEBUG | LWIP_DBG_LEVEL_SERIOUS,
-                ("tcp_split_unsent_seg: could not allocate memory for pbuf remainder %u\n", remainder));
+                ("tcp_split_seg: could not allocate memory for pbuf remainder %u\n", remainder));
     goto memerr;
   }
 
@@ -886,7 +1191,7 @@ tcp_split_unsent_seg(struct tcp_pcb *pcb, u16_t split)
   /* Copy remainder into new pbuf, headers and options will not be filled out */
   if (pbuf_copy_partial(useg->p, (u8_t *)p->payload + optlen, remainder, offset ) != remainder) {
     LWIP_DEBUGF(TCP_OUTPUT_DEBUG | LWIP_DBG_LEVEL_SERIOUS,
-                ("tcp_split_unsent_seg: could not copy pbuf remainder %u\n", remainder));
+                ("tcp_split_seg: could not copy pbuf remainder %u\n", remainder));
     goto memerr;
   }
 #if TCP_CHECKSUM_ON_COPY
@@ -914,7 +1219,7 @@ tcp_split_unsent_seg(struct tcp_pcb *pcb, u16_t split)
   seg = tcp_create_segment(pcb, p, remainder_flags, lwip_ntohl(useg->tcphdr->seqno) + split, optflags);
   if (seg == NULL) {
     LWIP_DEBUGF(TCP_OUTPUT_DEBUG | LWIP_DBG_LEVEL_SERIOUS,
-                ("tcp_split_unsent_seg: could not create new TCP segment\n"));
+                ("tcp_split_seg: could not create new TCP segment\n"));
     goto memerr;
   }
 
@@ -965,14 +1270,19 @@ tcp_split_unsent_seg(struct tcp_pcb *pcb, u16_t split)
    * because the total amount of data is constant when packet is split */
   pcb->snd_queuelen += pbuf_clen(seg->p);
 
-  /* Finally insert remainder into queue after split (which stays head) */
+#if LWIP_TCP_SACK_IN
+  /* the remainder shares the scoreboard state (optflags) and send time */
+  seg->xmit_time = useg->xmit_time;
+#endif /* LWIP_TCP_SACK_IN */
+
+  /* Finally insert remainder into queue after split */
   seg->next = useg->next;
   useg->next = seg;
 
 #if TCP_OVERSIZE
   /* If remainder is last segment on the unsent, ensure we clear the oversize amount
    * because the remainder is always sized to the exact remaining amount */
-  if (seg->next == NULL) {
+  if ((seg->next == NULL) && (useg == pcb->unsent)) {
     pcb->unsent_oversize = 0;
   }
 #endif /* TCP_OVERSIZE */
@@ -989,6 +1299,141 @@ memerr:
   return ERR_MEM;
 }
 
+/**
+ * Split segment on the head of the unsent queue.  If return is not
+ * ERR_OK, existing head remains intact
+ *
+ * @param pcb the tcp_pcb for which to split the unsent head
+ * @param split the amount of payload to remain in the head
+ */
+err_t
+tcp_split_unsent_seg(struct tcp_pcb *pcb, u16_t split)
+{
+  LWIP_ASSERT("tcp_split_unsent_seg: invalid pcb", pcb != NULL);
+
+  return tcp_split_seg(pcb, pcb->unsent, split);
+}
+
+#if TCP_TSO
+/**
+ * Remove the acknowledged head of a segment on the unacked queue, so that a
+ * retransmission of a partially acknowledged super-segment only carries the
+ * missing frames. This is done in place (the headers are moved up, acked
+ * pbufs of the chain are freed), nothing is copied. Segments still
+ * referenced by the netif driver are not trimmed.
+ *
+ * @param pcb the tcp_pcb the segment belongs to
+ * @param useg the unacked segment to trim
+ * @param trim the amount of payload to remove from the head of useg
+ * @return ERR_OK if useg has been trimmed
+ */
+err_t
+tcp_trim_unacked_seg(struct tcp_pcb *pcb, struct tcp_seg *useg, u16_t trim)
+{
+  struct pbuf *p, *q;
+  u16_t hdrlen, len;
+#if TCP_CHECKSUM_ON_COPY
+  u16_t chksum = 0;
+  u8_t chksum_swapped = 0;
+  u32_t acc;
+#endif /* TCP_CHECKSUM_ON_COPY */
+
+  LWIP_ASSERT("tcp_trim_unacked_seg: invalid pcb", pcb != NULL);
+  LWIP_ASSERT("tcp_trim_unacked_seg: invalid seg", useg != NULL);
+
+  if ((trim == 0) || (trim >= useg->len) || (TCPH_FLAGS(useg->tcphdr) & TCP_SYN) ||
+      tcp_output_segment_busy(useg)) {
+    return ERR_VAL;
+  }
+  p = useg->p;
+  /* IP (if sent before), TCP header and options are in the first pbuf */
+  hdrlen = (u16_t)(p->tot_len - useg->len);
+  LWIP_ASSERT("headers in first pbuf", p->len >= hdrlen);
+
+  /* data in the first pbuf: move the headers up */
+  len = (u16_t)LWIP_MIN(trim, p->len - hdrlen);
+  if (len > 0) {
+#if TCP_CHECKSUM_ON_COPY
+    tcp_seg_add_chksum(~inet_chksum((const u8_t *)p->payload + hdrlen, len), len,
+                       &chksum, &chksum_swapped);
+#endif /* TCP_CHECKSUM_ON_COPY */
+    MEMMOVE((u8_t *)p->payload + len, p->payload, hdrlen);
+    pbuf_remove_header(p, len);
+    useg->tcphdr = (struct tcp_hdr *)(void *)((u8_t *)useg->tcphdr + len);
+  }
+  /* data in the rest of the chain: free or trim the pbufs */
+  for (len = (u16_t)(trim - len); len > 0; ) {
+    q = p->next;
+    LWIP_ASSERT("tcp_trim_unacked_seg: chain too short", q != NULL);
+#if TCP_CHECKSUM_ON_COPY
+    tcp_seg_add_chksum(~inet_chksum(q->payload, LWIP_MIN(len, q->len)), LWIP_MIN(len, q->len),
+                       &chksum, &chksum_swapped);
+#endif /* TCP_CHECKSUM_ON_COPY */
+    if (q->len <= len) {
+      len = (u16_t)(len - q->len);
+      p->next = q->next;
+      q->next = NULL;
+      LWIP_ASSERT("pcb->snd_queuelen > 0", pcb->snd_queuelen > 0);
+      pcb->snd_queuelen--;
+      pbuf_free(q);
+    } else {
+      pbuf_remove_header(q, len);
+      len = 0;
+    }
+  }
+  p->tot_len = (u16_t)(p->len + ((p->next != NULL) ? p->next->tot_len : 0));
+  useg->len = (u16_t)(useg->len - trim);
+  useg->tcphdr->seqno = lwip_htonl(lwip_ntohl(useg->tcphdr->seqno) + trim);
+#if TCP_OVERSIZE_DBGCHECK
+  useg->oversize_left = 0;
+#endif /* TCP_OVERSIZE_DBGCHECK */
+
+#if TCP_CHECKSUM_ON_COPY
+  if (useg->flags & TF_SEG_DATA_CHECKSUMMED) {
+    /* subtract the sum of the removed data (its swapped state equals the
+       parity of trim) from the sum of all data, both aligned to the start */
+    if (useg->chksum_swapped) {
+      useg->chksum = SWAP_BYTES_IN_WORD(useg->chksum);
+    }
+    if (chksum_swapped) {
+      chksum = SWAP_BYTES_IN_WORD(chksum);
+    }
+    acc = (u32_t)useg->chksum + (u16_t)~chksum;
+    chksum = FOLD_U32T(acc);
+    /* the remaining data now starts at an odd offset of the old sum */
+    if (trim & 1) {
+      chksum = SWAP_BYTES_IN_WORD(chksum);
+    }
+    useg->chksum_swapped = (u8_t)(useg->len & 1);
+    useg->chksum = useg->chksum_swapped ? SWAP_BYTES_IN_WORD(chksum) : chksum;
+  }
+#endif /* TCP_CHECKSUM_ON_COPY */
+  return ERR_OK;
+}
+#endif /* TCP_TSO */
+
+#if LWIP_TCP_SACK_IN && TCP_TSO
+/**
+ * Split a segment on the unacked queue, used to mark the parts of a
+ * super-segment on the SACK scoreboard separately. Segments still referenced
+ * by the netif driver are not split.
+ *
+ * @param pcb the tcp_pcb the segment belongs to
+ * @param useg the unacked segment to split
+ * @param split the amount of payload to remain in useg
+ */
+err_t
+tcp_split_unacked_seg(struct tcp_pcb *pcb, struct tcp_seg *useg, u16_t split)
+{
+  LWIP_ASSERT("tcp_split_unacked_seg: invalid seg", useg != NULL);
+
+  if (tcp_output_segment_busy(useg)) {
+    return ERR_VAL;
+  }
+  return tcp_split_seg(pcb, useg, split);
+}
+#endif /* LWIP_TCP_SACK_IN && TCP_TSO */
+
 /**
  * Called by tcp_close() to send a segment including FIN flag but not data.
  * This FIN may be added to an existing segment or a new, otherwise empty
@@ -1055,13 +1500,13 @@ tcp_enqueue_flags(struct tcp_pcb *pcb, u8_t flags)
       optflags |= TF_SEG_OPTS_WND_SCALE;
     }
 #endif /* LWIP_WND_SCALE */
-#if LWIP_TCP_SACK_OUT
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
     if ((pcb->state != SYN_RCVD) || (pcb->flags & TF_SACK)) {
       /* In a <SYN,ACK> (sent in state SYN_RCVD), the SACK_PERM option may only
          be sent if we received a SACK_PERM option from the remote host. */
       optflags |= TF_SEG_OPTS_SACK_PERM;
     }
-#endif /* LWIP_TCP_SACK_OUT */
+#endif /* LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN */
   }
 #if LWIP_TCP_TIMESTAMPS
   if ((pcb->flags & TF_TIMESTAMP) || ((flags & TCP_SYN) && (pcb->state != SYN_RCVD))) {
@@ -1225,6 +1670,69 @@ tcp_build_wnd_scale_option(u32_t *opts)
 }
 #endif
 
+#if TCP_TSO
+/** Split the first unsent segment if it is a super-segment that does not
+ * fit into the window but starts at the left edge of it (i.e. it is sent
+ * for the first time with nothing in flight, or it is retransmitted, maybe
+ * after having been acknowledged partially).
+ * Other super-segments wait for ACKs to open the window instead of being
+ * copied apart.
+ *
+ * @param pcb the tcp_pcb to check
+ * @param wnd the usable window (min of send and congestion window)
+ */
+static void
+tcp_tso_fit_window(struct tcp_pcb *pcb, u32_t wnd)
+{
+  struct tcp_seg *seg = pcb->unsent;
+  u16_t frame;
+
+  if ((seg == NULL) || TCP_SEQ_GT(lwip_ntohl(seg->tcphdr->seqno), pcb->lastack)) {
+    return;
+  }
+  /* the acknowledged head of the segment does not count against the window */
+  wnd += pcb->lastack - lwip_ntohl(seg->tcphdr->seqno);
+  if (seg->len <= wnd) {
+    return;
+  }
+  frame = TCP_TSO_FRAME_LEN(seg, pcb);
+  if ((frame > 0) && (seg->len > frame) && (wnd >= frame)) {
+    tcp_split_unsent_seg(pcb, (u16_t)(wnd - (wnd % frame)));
+  }
+}
+
+#if CHECKSUM_GEN_TCP
+/** Check whether ip4_output_if() cuts a super-segment into frames (and
+ * checksums each of them): not if the netif cuts it itself, nor if it is
+ * looped back to this host as it is.
+ *
+ * @param p the segment to send, with tso_mss set
+ * @param netif the netif it is sent on
+ * @param dest the destination address
+ * @return 1 if the segment is cut by ip4_tso_output(), 0 otherwise
+ */
+static int
+tcp_tso_cut_by_ip(const struct pbuf *p, const struct netif *netif, const ip_addr_t *dest)
+{
+  if ((p->tso_mss == 0) || (netif->flags & NETIF_FLAG_TSO)) {
+    return 0;
+  }
+#if ENABLE_LOOPBACK
+  if (ip4_addr_cmp(ip_2_ip4(dest), netif_ip4_addr(netif))
+#if !LWIP_HAVE_LOOPIF
+      || ip4_addr_isloopback(ip_2_ip4(dest))
+#endif /* !LWIP_HAVE_LOOPIF */
+     ) {
+    return 0;
+  }
+#else /* ENABLE_LOOPBACK */
+  LWIP_UNUSED_ARG(dest);
+#endif /* ENABLE_LOOPBACK */
+  return 1;
+}
+#endif /* CHECKSUM_GEN_TCP */
+#endif /* TCP_TSO */
+
 /**
  * @ingroup tcp_raw
  * Find out what we can send and send it
@@ -1301,6 +1809,10 @@ tcp_output(struct tcp_pcb *pcb)
     ip_addr_copy(pcb->local_ip, *local_ip);
   }
 
+#if TCP_TSO
+  tcp_tso_fit_window(pcb, wnd);
+#endif /* TCP_TSO */
+
   /* Handle the current segment not fitting within the window */
   if (lwip_ntohl(seg->tcphdr->seqno) - pcb->lastack + seg->len > wnd) {
     /* We need to start the persistent timer when the next unsent segment does not fit
@@ -1518,7 +2030,7 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
     opts += 1;
   }
 #endif
-#if LWIP_TCP_SACK_OUT
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
   if (seg->flags & TF_SEG_OPTS_SACK_PERM) {
     /* Pad with two NOP options to make everything nicely aligned
      * NOTE: When we send both timestamp and SACK_PERM options,
@@ -1541,6 +2053,14 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
 
     LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_output_segment: rtseq %"U32_F"\n", pcb->rtseq));
   }
+#if LWIP_TCP_SACK_IN
+  /* (re)start the scoreboard entry of this segment */
+  seg->flags &= (u8_t)~(TF_SEG_SACKED | TF_SEG_LOST);
+  if (TCP_SEQ_LT(lwip_ntohl(seg->tcphdr->seqno), pcb->snd_nxt)) {
+    seg->flags |= TF_SEG_REXMIT;
+  }
+  seg->xmit_time = sys_now();
+#endif /* LWIP_TCP_SACK_IN */
   LWIP_DEBUGF(TCP_OUTPUT_DEBUG, ("tcp_output_segment: %"U32_F":%"U32_F"\n",
                                  lwip_htonl(seg->tcphdr->seqno), lwip_htonl(seg->tcphdr->seqno) +
                                  seg->len));
@@ -1555,6 +2075,10 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
   seg->p->tot_len -= len;
 
   seg->p->payload = seg->tcphdr;
+#if TCP_TSO
+  /* have super-segments cut into frames at the netif */
+  seg->p->tso_mss = (seg->len > TCP_TSO_FRAME_LEN(seg, pcb)) ? TCP_TSO_FRAME_LEN(seg, pcb) : 0;
+#endif /* TCP_TSO */
 
   seg->tcphdr->chksum = 0;
 
@@ -1564,6 +2088,10 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
   LWIP_ASSERT("options not filled", (u8_t *)opts == ((u8_t *)(seg->tcphdr + 1)) + LWIP_TCP_OPT_LENGTH_SEGMENT(seg->flags, pcb));
 
 #if CHECKSUM_GEN_TCP
+#if TCP_TSO
+  /* super-segments cut by ip4_tso_output() are checksummed per frame there */
+  if (!tcp_tso_cut_by_ip(seg->p, netif, &pcb->remote_ip))
+#endif /* TCP_TSO */
   IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_TCP) {
 #if TCP_CHECKSUM_ON_COPY
     u32_t acc;
@@ -1665,6 +2193,15 @@ tcp_rexmit_rto_prepare(struct tcp_pcb *pcb)
   /* unacked queue is now empty */
   pcb->unacked = NULL;
 
+#if LWIP_TCP_SACK_IN
+  /* The remote host may have discarded SACKed data (RFC 2018, section 8),
+     so everything is resent and SACK recovery ends here. */
+  if (pcb->rack_flags & TCP_SACK_RECOVERY) {
+    tcp_clear_flags(pcb, TF_INFR);
+  }
+  pcb->rack_flags &= (u8_t)~(TCP_RACK_TMR | TCP_SACK_RECOVERY);
+#endif /* LWIP_TCP_SACK_IN */
+
   /* Mark RTO in-progress */
   tcp_set_flags(pcb, TF_RTO);
   /* Record the next byte following retransmit */
@@ -1792,20 +2329,8 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
                  (u16_t)pcb->dupacks, pcb->lastack,
                  lwip_ntohl(pcb->unacked->tcphdr->seqno)));
     if (tcp_rexmit(pcb) == ERR_OK) {
-      /* Set ssthresh to half of the minimum of the current
-       * cwnd and the advertised window */
-      pcb->ssthresh = LWIP_MIN(pcb->cwnd, pcb->snd_wnd) / 2;
-
-      /* The minimum value for ssthresh should be 2 MSS */
-      if (pcb->ssthresh < (2U * pcb->mss)) {
-        LWIP_DEBUGF(TCP_FR_DEBUG,
-                    ("tcp_receive: The minimum value for ssthresh %"TCPWNDSIZE_F
-                     " should be min 2 mss %"U16_F"...\n",
-                     pcb->ssthresh, (u16_t)(2 * pcb->mss)));
-        pcb->ssthresh = 2 * pcb->mss;
-      }
-
-      pcb->cwnd = pcb->ssthresh + 3 * pcb->mss;
+      /* Reduce congestion window and ssthresh. */
+      TCP_CC_OPS(pcb)->loss(pcb, TCP_CC_LOSS_FAST);
       tcp_set_flags(pcb, TF_INFR);
 
       /* Reset the retransmission timer to prevent immediate rto retransmissions */
@@ -1814,6 +2339,125 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
   }
 }
 
+#if LWIP_TCP_SACK_IN
+/**
+ * RACK loss detection (RFC 8985) on the SACK scoreboard: a segment that has
+ * not been SACKed is lost if a segment sent after it has been delivered and
+ * it has not been delivered within RTT plus reordering window since its own
+ * transmission. Lost segments are requeued for retransmission (fast recovery
+ * is entered if not already in progress), the remaining suspects start the
+ * reordering timer.
+ *
+ * Called by tcp_receive() for ACKs carrying SACK blocks and by tcp_fasttmr()
+ * when the reordering timer has expired.
+ *
+ * @param pcb the tcp_pcb for which to check the unacked segments
+ */
+void
+tcp_rexmit_sack(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg, **cur_seg, **lost_seg;
+  tcpwnd_size_t sacked = 0;
+  u32_t now, reo_wnd, timeout = 0;
+  s32_t remaining;
+  u8_t lost = 0;
+
+  LWIP_ASSERT("tcp_rexmit_sack: invalid pcb", pcb != NULL);
+
+  pcb->rack_flags &= (u8_t)~TCP_RACK_TMR;
+  if ((pcb->unacked == NULL) || !(pcb->rack_flags & TCP_RACK_VALID)) {
+    return;
+  }
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    if (seg->flags & TF_SEG_SACKED) {
+      TCP_WND_INC(sacked, seg->len);
+    }
+  }
+  /* Without observed reordering, a loss is assumed as soon as three segments
+     worth of data above it have been SACKed (like three duplicate ACKs).
+     Otherwise, allow for a quarter of the minimum RTT of reordering. */
+  if (!(pcb->rack_flags & TCP_RACK_REORDER) &&
+      ((pcb->flags & TF_INFR) || ((u32_t)sacked >= 3U * pcb->mss))) {
+    reo_wnd = 0;
+  } else {
+    reo_wnd = pcb->rack_min_rtt / 4;
+  }
+
+  now = sys_now();
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    if (seg->flags & (TF_SEG_SACKED | TF_SEG_LOST)) {
+      continue;
+    }
+    /* only segments sent before the most recently delivered one */
+    if (((s32_t)(seg->xmit_time - pcb->rack_xmit_ts) > 0) ||
+        ((seg->xmit_time == pcb->rack_xmit_ts) &&
+         TCP_SEQ_GEQ(lwip_ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg), pcb->rack_end_seq))) {
+      continue;
+    }
+    remaining = (s32_t)(seg->xmit_time + pcb->rack_rtt + reo_wnd - now);
+    if (remaining <= 0) {
+      seg->flags |= TF_SEG_LOST;
+      lost = 1;
+    } else if ((u32_t)remaining > timeout) {
+      timeout = (u32_t)remaining;
+    }
+  }
+  if (timeout > 0) {
+    pcb->rack_tmr = now + timeout;
+    pcb->rack_flags |= TCP_RACK_TMR;
+  }
+
+  /* Move the lost segments to the unsent queue, keeping it sorted. Segments
+     still referenced by the netif driver stay marked and are retried later. */
+  cur_seg = &(pcb->unsent);
+  for (lost_seg = &(pcb->unacked); *lost_seg != NULL; ) {
+    seg = *lost_seg;
+    if (!(seg->flags & TF_SEG_LOST) || tcp_output_segment_busy(seg)) {
+      lost_seg = &(seg->next);
+      continue;
+    }
+    *lost_seg = seg->next;
+    while (*cur_seg &&
+           TCP_SEQ_LT(lwip_ntohl((*cur_seg)->tcphdr->seqno), lwip_ntohl(seg->tcphdr->seqno))) {
+      cur_seg = &((*cur_seg)->next);
+    }
+    seg->next = *cur_seg;
+    *cur_seg = seg;
+#if TCP_OVERSIZE
+    if (seg->next == NULL) {
+      /* the retransmitted segment is last in unsent, so reset unsent_oversize */
+      pcb->unsent_oversize = 0;
+    }
+#endif /* TCP_OVERSIZE */
+    MIB2_STATS_INC(mib2.tcpretranssegs);
+  }
+
+  if (lost) {
+    LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_rexmit_sack: loss detected, %"TCPWNDSIZE_F" bytes SACKed\n", sacked));
+    if (pcb->nrtx < 0xFF) {
+      ++pcb->nrtx;
+    }
+    /* Don't take any rtt measurements after retransmitting. */
+    pcb->rttest = 0;
+    if (!(pcb->flags & TF_INFR)) {
+      /* Reduce congestion window and ssthresh once per window of data. */
+      TCP_CC_OPS(pcb)->loss(pcb, TCP_CC_LOSS_FAST);
+      tcp_set_flags(pcb, TF_INFR);
+      pcb->rack_flags |= TCP_SACK_RECOVERY;
+      pcb->sack_recover = pcb->snd_nxt;
+      /* Reset the retransmission timer to prevent immediate rto retransmissions */
+      pcb->rtime = 0;
+    }
+  }
+  if (pcb->rack_flags & TCP_SACK_RECOVERY) {
+    /* SACKed data has left the network: let the window (measured from
+       lastack by tcp_output()) cover it in addition to ssthresh */
+    pcb->cwnd = pcb->ssthresh;
+    TCP_WND_INC(pcb->cwnd, sacked);
+  }
+}
+#endif /* LWIP_TCP_SACK_IN */
+
 static struct pbuf *
 tcp_output_alloc_header_common(u32_t ackno, u16_t optlen, u16_t datalen,
                         u32_t seqno_be /* already in network byte order */,
@@ -118,17 +118,166 @@ const int lwip_num_cyclic_timers = LWIP_ARRAYSIZE(lwip_cyclic_timers);
 
 #if LWIP_TIMERS && !LWIP_TIMERS_CUSTOM
 
+#if LWIP_TIMERS_WHEEL
+#define TIMEO_WHEEL_MASK          (SYS_TIMEO_WHEEL_SLOTS - 1)
+#define TIMEO_WHEEL_SHIFT(level)  ((level) * SYS_TIMEO_WHEEL_BITS)
+#define TIMEO_WHEEL_INDEX(t, level) ((u8_t)(((t) >> TIMEO_WHEEL_SHIFT(level)) & TIMEO_WHEEL_MASK))
+
+/** The one and only timing wheel */
+static struct sys_timeo_wheel timeo_wheel;
+/** Set while sys_check_timeouts() walks the wheel */
+static u8_t timeo_wheel_busy;
+
+static int
+timeo_wheel_empty(void)
+{
+  u8_t level;
+  for (level = 0; level < SYS_TIMEO_WHEEL_LEVELS; level++) {
+    if (timeo_wheel.count[level] != 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/** Link a timeout into the lowest level whose range covers its due time.
+ * Timeouts that are already due go to the slot processed next. */
+static void
+timeo_wheel_link(struct sys_timeo *t)
+{
+  struct sys_timeo **head;
+  u32_t delta = (u32_t)(t->time - timeo_wheel.time);
+  u8_t level = 0;
+
+  if (TIME_LESS_THAN(t->time, timeo_wheel.time)) {
+    t->slot = TIMEO_WHEEL_INDEX(timeo_wheel.time, 0);
+  } else {
+    while ((level < SYS_TIMEO_WHEEL_LEVELS - 1) &&
+           (delta >= ((u32_t)1 << TIMEO_WHEEL_SHIFT(level + 1)))) {
+      level++;
+    }
+    t->slot = TIMEO_WHEEL_INDEX(t->time, level);
+  }
+  t->level = level;
+
+  head = &timeo_wheel.slots[level][t->slot];
+  if (*head == NULL) {
+    t->next = t;
+    t->prev = t;
+    *head = t;
+  } else {
+    /* append at the tail to keep insertion order */
+    t->next = *head;
+    t->prev = (*head)->prev;
+    t->prev->next = t;
+    (*head)->prev = t;
+  }
+  timeo_wheel.count[level]++;
+}
+
+static void
+timeo_wheel_unlink(struct sys_timeo *t)
+{
+  struct sys_timeo **head = &timeo_wheel.slots[t->level][t->slot];
+
+  if (t->next == t) {
+    *head = NULL;
+  } else {
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    if (*head == t) {
+      *head = t->next;
+    }
+  }
+  timeo_wheel.count[t->level]--;
+}
+
+/** The wheel reached the start of the current slot of 'level': move its
+ * timeouts down to the level matching their remaining time. */
+static void
+timeo_wheel_cascade(u8_t level)
+{
+  struct sys_timeo **head = &timeo_wheel.slots[level][TIMEO_WHEEL_INDEX(timeo_wheel.time, level)];
+  struct sys_timeo *t = *head;
+
+  if (t == NULL) {
+    return;
+  }
+  /* detach the whole slot first: relinking may put a timeout back here */
+  *head = NULL;
+  t->prev->next = NULL;
+  while (t != NULL) {
+    struct sys_timeo *next = t->next;
+    timeo_wheel.count[level]--;
+    timeo_wheel_link(t);
+    t = next;
+  }
+}
+
+/** Take all timeouts off the wheel. Returns them as a NULL-terminated list and
+ * the earliest due time in 'base'. */
+static struct sys_timeo *
+timeo_wheel_take_all(u32_t *base)
+{
+  struct sys_timeo *list = NULL;
+  struct sys_timeo *t;
+  u8_t level;
+  u16_t slot;
+
+  for (level = 0; level < SYS_TIMEO_WHEEL_LEVELS; level++) {
+    for (slot = 0; (slot < SYS_TIMEO_WHEEL_SLOTS) && (timeo_wheel.count[level] != 0); slot++) {
+      while ((t = timeo_wheel.slots[level][slot]) != NULL) {
+        timeo_wheel_unlink(t);
+        if ((list == NULL) || TIME_LESS_THAN(t->time, *base)) {
+          *base = t->time;
+        }
+        t->next = list;
+        list = t;
+      }
+    }
+  }
+  return list;
+}
+
+/** Keep the wheel in step with sys_now(): an empty wheel simply jumps to now,
+ * a wheel that is ahead of now (sys_now() went backwards) is rebuilt. */
+static void
+timeo_wheel_sync(u32_t now)
+{
+  if (timeo_wheel_empty()) {
+    timeo_wheel.time = now;
+  } else if (TIME_LESS_THAN((u32_t)(now + 1), timeo_wheel.time)) {
+    u32_t base;
+    struct sys_timeo *list = timeo_wheel_take_all(&base);
+    timeo_wheel.time = now;
+    while (list != NULL) {
+      struct sys_timeo *t = list;
+      list = t->next;
+      timeo_wheel_link(t);
+    }
+  }
+}
+#else /* LWIP_TIMERS_WHEEL */
 /** The one and only timeout list */
 static struct sys_timeo *next_timeout;
+#endif /* LWIP_TIMERS_WHEEL */
 
 static u32_t current_timeout_due_time;
 
 #if LWIP_TESTMODE
+#if LWIP_TIMERS_WHEEL
+struct sys_timeo_wheel*
+sys_timeouts_get_wheel(void)
+{
+  return &timeo_wheel;
+}
+#else /* LWIP_TIMERS_WHEEL */
 struct sys_timeo**
 sys_timeouts_get_next_timeout(void)
 {
   return &next_timeout;
 }
+#endif /* LWIP_TIMERS_WHEEL */
 #endif
 
 #if LWIP_TCP
@@ -183,7 +332,10 @@ sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg, const ch
 sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg)
 #endif
 {
-  struct sys_timeo *timeout, *t;
+  struct sys_timeo *timeout;
+#if !LWIP_TIMERS_WHEEL
+  struct sys_timeo *t;
+#endif /* !LWIP_TIMERS_WHEEL */
 
   timeout = (struct sys_timeo *)memp_malloc(MEMP_SYS_TIMEOUT);
   if (timeout == NULL) {
@@ -202,6 +354,12 @@ sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg)
                              (void *)timeout, abs_time, handler_name, (void *)arg));
 #endif /* LWIP_DEBUG_TIMERNAMES */
 
+#if LWIP_TIMERS_WHEEL
+  if (!timeo_wheel_busy) {
+    timeo_wheel_sync(sys_now());
+  }
+  timeo_wheel_link(timeout);
+#else /* LWIP_TIMERS_WHEEL */
   if (next_timeout == NULL) {
     next_timeout = timeout;
     return;
@@ -218,6 +376,7 @@ sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg)
       }
     }
   }
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /**
@@ -316,6 +475,38 @@ sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
 void
 sys_untimeout(sys_timeout_handler handler, void *arg)
 {
+#if LWIP_TIMERS_WHEEL
+  struct sys_timeo *match = NULL;
+  u8_t level;
+  u16_t slot;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  for (level = 0; level < SYS_TIMEO_WHEEL_LEVELS; level++) {
+    if (timeo_wheel.count[level] == 0) {
+      continue;
+    }
+    for (slot = 0; slot < SYS_TIMEO_WHEEL_SLOTS; slot++) {
+      struct sys_timeo *head = timeo_wheel.slots[level][slot];
+      struct sys_timeo *t = head;
+      if (t == NULL) {
+        continue;
+      }
+      do {
+        /* remove the entry that would expire first */
+        if ((t->h == handler) && (t->arg == arg) &&
+            ((match == NULL) || TIME_LESS_THAN(t->time, match->time))) {
+          match = t;
+        }
+        t = t->next;
+      } while (t != head);
+    }
+  }
+  if (match != NULL) {
+    timeo_wheel_unlink(match);
+    memp_free(MEMP_SYS_TIMEOUT, match);
+  }
+#else /* LWIP_TIMERS_WHEEL */
   struct sys_timeo *prev_t, *t;
 
   LWIP_ASSERT_CORE_LOCKED();
@@ -338,6 +529,7 @@ sys_untimeout(sys_timeout_handler handler, void *arg)
     }
   }
   return;
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /**
@@ -358,6 +550,56 @@ sys_check_timeouts(void)
   /* Process only timers expired at the start of the function. */
   now = sys_now();
 
+#if LWIP_TIMERS_WHEEL
+  PBUF_CHECK_FREE_OOSEQ();
+
+  timeo_wheel_sync(now);
+  timeo_wheel_busy = 1;
+  while (!TIME_LESS_THAN(now, timeo_wheel.time)) {
+    struct sys_timeo **head;
+    u8_t level;
+
+    /* reached the start of a higher level slot? */
+    for (level = SYS_TIMEO_WHEEL_LEVELS - 1; level > 0; level--) {
+      if ((timeo_wheel.time & (((u32_t)1 << TIMEO_WHEEL_SHIFT(level)) - 1)) == 0) {
+        timeo_wheel_cascade(level);
+      }
+    }
+
+    /* everything in this slot is due now (handlers may add more) */
+    head = &timeo_wheel.slots[0][TIMEO_WHEEL_INDEX(timeo_wheel.time, 0)];
+    while (*head != NULL) {
+      struct sys_timeo *tmptimeout = *head;
+      sys_timeout_handler handler = tmptimeout->h;
+      void *arg = tmptimeout->arg;
+
+      timeo_wheel_unlink(tmptimeout);
+      current_timeout_due_time = tmptimeout->time;
+#if LWIP_DEBUG_TIMERNAMES
+      if (handler != NULL) {
+        LWIP_DEBUGF(TIMERS_DEBUG, ("sct calling h=%s t=%"U32_F" arg=%p\n",
+                                   tmptimeout->handler_name, sys_now() - tmptimeout->time, arg));
+      }
+#endif /* LWIP_DEBUG_TIMERNAMES */
+      memp_free(MEMP_SYS_TIMEOUT, tmptimeout);
+      if (handler != NULL) {
+        handler(arg);
+      }
+      LWIP_TCPIP_THREAD_ALIVE();
+      PBUF_CHECK_FREE_OOSEQ();
+    }
+
+    /* skip ahead to the next cascade of the lowest non-empty level */
+    for (level = 0; (level < SYS_TIMEO_WHEEL_LEVELS) && (timeo_wheel.count[level] == 0); level++);
+    if ((level == 0) || (level == SYS_TIMEO_WHEEL_LEVELS)) {
+      timeo_wheel.time = (level == 0) ? (u32_t)(timeo_wheel.time + 1) : (u32_t)(now + 1);
+    } else {
+      u32_t next = (u32_t)(((timeo_wheel.time >> TIMEO_WHEEL_SHIFT(level)) + 1) << TIMEO_WHEEL_SHIFT(level));
+      timeo_wheel.time = TIME_LESS_THAN(now, next) ? (u32_t)(now + 1) : next;
+    }
+  }
+  timeo_wheel_busy = 0;
+#else /* LWIP_TIMERS_WHEEL */
   do {
     struct sys_timeo *tmptimeout;
     sys_timeout_handler handler;
@@ -393,6 +635,7 @@ sys_check_timeouts(void)
 
     /* Repeat until all expired timers have been called */
   } while (1);
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /** Rebase the timeout times to the current time.
@@ -406,6 +649,23 @@ sys_restart_timeouts(void)
   u32_t now;
   u32_t base;
   struct sys_timeo *t;
+#if LWIP_TIMERS_WHEEL
+  struct sys_timeo *list;
+
+  if (timeo_wheel_empty()) {
+    return;
+  }
+
+  list = timeo_wheel_take_all(&base);
+  now = sys_now();
+  timeo_wheel.time = now;
+  while (list != NULL) {
+    t = list;
+    list = t->next;
+    t->time = (t->time - base) + now;
+    timeo_wheel_link(t);
+  }
+#else /* LWIP_TIMERS_WHEEL */
 
   if (next_timeout == NULL) {
     return;
@@ -417,6 +677,7 @@ sys_restart_timeouts(void)
   for (t = next_timeout; t != NULL; t = t->next) {
     t->time = (t->time - base) + now;
   }
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /** Return the time left before the next timeout is due. If no timeouts are
@@ -426,6 +687,50 @@ u32_t
 sys_timeouts_sleeptime(void)
 {
   u32_t now;
+#if LWIP_TIMERS_WHEEL
+  struct sys_timeo *first = NULL;
+  u8_t level;
+  u16_t i;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  now = sys_now();
+  timeo_wheel_sync(now);
+  for (level = 0; level < SYS_TIMEO_WHEEL_LEVELS; level++) {
+    /* start at the current slot unless it has already been cascaded */
+    u8_t start = TIMEO_WHEEL_INDEX(timeo_wheel.time, level);
+    if ((timeo_wheel.time & (((u32_t)1 << TIMEO_WHEEL_SHIFT(level)) - 1)) != 0) {
+      start++;
+    }
+    if (timeo_wheel.count[level] == 0) {
+      continue;
+    }
+    /* the first non-empty slot holds the earliest timeout of this level */
+    for (i = 0; i < SYS_TIMEO_WHEEL_SLOTS; i++) {
+      struct sys_timeo *head = timeo_wheel.slots[level][(start + i) & TIMEO_WHEEL_MASK];
+      struct sys_timeo *t = head;
+      if (t != NULL) {
+        do {
+          if ((first == NULL) || TIME_LESS_THAN(t->time, first->time)) {
+            first = t;
+          }
+          t = t->next;
+        } while (t != head);
+        break;
+      }
+    }
+  }
+  if (first == NULL) {
+    return SYS_TIMEOUTS_SLEEPTIME_INFINITE;
+  }
+  if (TIME_LESS_THAN(first->time, now)) {
+    return 0;
+  } else {
+    u32_t ret = (u32_t)(first->time - now);
+    LWIP_ASSERT("invalid sleeptime", ret <= LWIP_MAX_TIMEOUT);
+    return ret;
+  }
+#else /* LWIP_TIMERS_WHEEL */
 
   LWIP_ASSERT_CORE_LOCKED();
 
@@ -440,6 +745,7 @@ sys_timeouts_sleeptime(void)
     LWIP_ASSERT("invalid sleeptime", ret <= LWIP_MAX_TIMEOUT);
     return ret;
   }
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 #else /* LWIP_TIMERS && !LWIP_TIMERS_CUSTOM */
@@ -80,6 +80,19 @@ static u16_t udp_port = UDP_LOCAL_PORT_RANGE_START;
 /* exported in udp.h (was static) */
 struct udp_pcb *udp_pcbs;
 
+#if UDP_PCB_HASH
+/** Bound PCBs indexed by their local port */
+static struct udp_pcb *udp_pcb_hash[UDP_PCB_HASH_SIZE];
+#define UDP_PCB_HASH_IDX(port)    ((port) % UDP_PCB_HASH_SIZE)
+/** First pcb that might be bound to 'port' */
+#define UDP_PCBS_FOR_PORT(port)   udp_pcb_hash[UDP_PCB_HASH_IDX(port)]
+/** Next pcb that might be bound to the same port as 'pcb' */
+#define UDP_PCB_PORT_NEXT(pcb)    ((pcb)->hash_next)
+#else /* UDP_PCB_HASH */
+#define UDP_PCBS_FOR_PORT(port)   udp_pcbs
+#define UDP_PCB_PORT_NEXT(pcb)    ((pcb)->next)
+#endif /* UDP_PCB_HASH */
+
 /**
  * Initialize this module.
  */
@@ -107,7 +120,7 @@ again:
     udp_port = UDP_LOCAL_PORT_RANGE_START;
   }
   /* Check all PCBs. */
-  for (pcb = udp_pcbs; pcb != NULL; pcb = pcb->next) {
+  for (pcb = UDP_PCBS_FOR_PORT(udp_port); pcb != NULL; pcb = UDP_PCB_PORT_NEXT(pcb)) {
     if (pcb->local_port == udp_port) {
       if (++n > (UDP_LOCAL_PORT_RANGE_END - UDP_LOCAL_PORT_RANGE_START)) {
         return 0;
@@ -118,6 +131,36 @@ again:
   return udp_port;
 }
 
+#if UDP_PCB_HASH
+/** Add a pcb to the local-port index (after it has been put on udp_pcbs) */
+static void
+udp_pcb_hash_reg(struct udp_pcb *pcb)
+{
+  struct udp_pcb **bucket = &UDP_PCBS_FOR_PORT(pcb->local_port);
+  pcb->hash_next = *bucket;
+  *bucket = pcb;
+}
+
+/** Remove a pcb from the local-port index (before its local port changes) */
+static void
+udp_pcb_hash_rmv(struct udp_pcb *pcb)
+{
+  struct udp_pcb **bucket;
+  for (bucket = &UDP_PCBS_FOR_PORT(pcb->local_port); *bucket != NULL; bucket = &(*bucket)->hash_next) {
+    if (*bucket == pcb) {
+      *bucket = pcb->hash_next;
+      break;
+    }
+  }
+  pcb->hash_next = NULL;
+}
+#define UDP_HASH_REG(pcb) udp_pcb_hash_reg(pcb)
+#define UDP_HASH_RMV(pcb) udp_pcb_hash_rmv(pcb)
+#else /* UDP_PCB_HASH */
+#define UDP_HASH_REG(pcb)
+#define UDP_HASH_RMV(pcb)
+#endif /* UDP_PCB_HASH */
+
 /** Common code to see if the current input packet matches the pcb
  * (current input packet is accessed via ip(4/6)_current_* macros)
  *
@@ -178,6 +221,81 @@ udp_input_local_match(struct udp_pcb *pcb, struct netif *inp, u8_t broadcast)
   return 0;
 }
 
+#if SO_REUSE_PORT
+/** Fold the remote address and ports of the current input packet into 32 bits */
+static u32_t
+udp_reuseport_hash(u16_t src, u16_t dest)
+{
+  u32_t h = ((u32_t)src << 16) | dest;
+#if LWIP_IPV6
+  if (ip_current_is_v6()) {
+    const u32_t *a = ip6_current_src_addr()->addr;
+    h ^= a[0] ^ a[1] ^ a[2] ^ a[3];
+  }
+#endif /* LWIP_IPV6 */
+#if LWIP_IPV4
+  if (!ip_current_is_v6()) {
+    h ^= ip4_addr_get_u32(ip4_current_src_addr());
+  }
+#endif /* LWIP_IPV4 */
+  h ^= h >> 16;
+  h *= 0x45d9f3bUL;
+  h ^= h >> 16;
+  return h;
+}
+
+/** Is 'pcb' a member of the SO_REUSEPORT group of 'first' (unconnected,
+ * bound to the same address and port and accepting the current packet)? */
+static u8_t
+udp_reuseport_member(struct udp_pcb *pcb, struct udp_pcb *first, struct netif *inp)
+{
+  return (pcb->local_port == first->local_port) &&
+         ((pcb->flags & UDP_FLAGS_CONNECTED) == 0) &&
+         ip_get_option(pcb, SOF_REUSEPORT) &&
+         ip_addr_cmp(&pcb->local_ip, &first->local_ip) &&
+         udp_input_local_match(pcb, inp, 0);
+}
+
+/**
+ * Spread unicast datagrams among the pcbs of a SO_REUSEPORT group.
+ * The member is chosen by hashing the remote address and ports, so every
+ * remote flow is delivered to the same pcb as long as the group does not
+ * change.
+ *
+ * @param first the unconnected pcb matched by udp_input()
+ * @param inp network interface on which the datagram was received
+ * @param src remote port of the current input packet
+ * @param dest local port of the current input packet
+ * @return the pcb to deliver the datagram to
+ */
+static struct udp_pcb *
+udp_reuseport_select(struct udp_pcb *first, struct netif *inp, u16_t src, u16_t dest)
+{
+  struct udp_pcb *pcb;
+  u32_t idx;
+  u16_t cnt = 0;
+
+  for (pcb = UDP_PCBS_FOR_PORT(dest); pcb != NULL; pcb = UDP_PCB_PORT_NEXT(pcb)) {
+    if (udp_reuseport_member(pcb, first, inp)) {
+      cnt++;
+    }
+  }
+  if (cnt <= 1) {
+    return first;
+  }
+  idx = udp_reuseport_hash(src, dest) % cnt;
+  for (pcb = UDP_PCBS_FOR_PORT(dest); pcb != NULL; pcb = UDP_PCB_PORT_NEXT(pcb)) {
+    if (udp_reuseport_member(pcb, first, inp)) {
+      if (idx == 0) {
+        return pcb;
+      }
+      idx--;
+    }
+  }
+  return first;
+}
+#endif /* SO_REUSE_PORT */
+
 /**
  * Process an incoming UDP datagram.
  *
@@ -250,7 +368,7 @@ udp_input(struct pbuf *p, struct netif *inp)
    * 'Perfect match' pcbs (connected to the remote port & ip address) are
    * preferred. If no perfect match is found, the first unconnected pcb that
    * matches the local port and ip address gets the datagram. */
-  for (pcb = udp_pcbs; pcb != NULL; pcb = pcb->next) {
+  for (pcb = UDP_PCBS_FOR_PORT(dest); pcb != NULL; pcb = UDP_PCB_PORT_NEXT(pcb)) {
     /* print the PCB local and remote address */
     LWIP_DEBUGF(UDP_DEBUG, ("pcb ("));
     ip_addr_debug_print_val(UDP_DEBUG, pcb->local_ip);
@@ -291,11 +409,11 @@ udp_input(struct pbuf *p, struct netif *inp)
            ip_addr_cmp(&pcb->remote_ip, ip_current_src_addr()))) {
         /* the first fully matching PCB */
         if (prev != NULL) {
-          /* move the pcb to the front of udp_pcbs so that is
-             found faster next time */
-          prev->next = pcb->next;
-          pcb->next = udp_pcbs;
-          udp_pcbs = pcb;
+          /* move the pcb to the front of udp_pcbs (or its hash bucket)
+             so that is found faster next time */
+          UDP_PCB_PORT_NEXT(prev) = UDP_PCB_PORT_NEXT(pcb);
+          UDP_PCB_PORT_NEXT(pcb) = UDP_PCBS_FOR_PORT(dest);
+          UDP_PCBS_FOR_PORT(dest) = pcb;
         } else {
           UDP_STATS_INC(udp.cachehit);
         }
@@ -308,6 +426,12 @@ udp_input(struct pbuf *p, struct netif *inp)
   /* no fully matching pcb found? then look for an unconnected pcb */
   if (pcb == NULL) {
     pcb = uncon_pcb;
+#if SO_REUSE_PORT
+    if ((pcb != NULL) && ip_get_option(pcb, SOF_REUSEPORT) &&
+        !broadcast && !ip_addr_ismulticast(ip_current_dest_addr())) {
+      pcb = udp_reuseport_select(pcb, inp, src, dest);
+    }
+#endif /* SO_REUSE_PORT */
   }
 
   /* Check checksum if this is a match or if it was directed at us. */
@@ -380,7 +504,7 @@ udp_input(struct pbuf *p, struct netif *inp)
         /* pass broadcast- or multicast packets to all multicast pcbs
            if SOF_REUSEADDR is set on the first match */
         struct udp_pcb *mpcb;
-        for (mpcb = udp_pcbs; mpcb != NULL; mpcb = mpcb->next) {
+        for (mpcb = UDP_PCBS_FOR_PORT(dest); mpcb != NULL; mpcb = UDP_PCB_PORT_NEXT(mpcb)) {
           if (mpcb != pcb) {
             /* compare PCB local addr+port to UDP destination addr+port */
             if ((mpcb->local_port == dest) &&
@@ -985,15 +1109,19 @@ udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
       return ERR_USE;
     }
   } else {
-    for (ipcb = udp_pcbs; ipcb != NULL; ipcb = ipcb->next) {
+    for (ipcb = UDP_PCBS_FOR_PORT(port); ipcb != NULL; ipcb = UDP_PCB_PORT_NEXT(ipcb)) {
       if (pcb != ipcb) {
         /* By default, we don't allow to bind to a port that any other udp
            PCB is already bound to, unless *all* PCBs with that port have tha
-           REUSEADDR flag set. */
+           REUSEADDR (or REUSEPORT) flag set. */
 #if SO_REUSE
         if (!ip_get_option(pcb, SOF_REUSEADDR) ||
             !ip_get_option(ipcb, SOF_REUSEADDR))
 #endif /* SO_REUSE */
+#if SO_REUSE_PORT
+        if (!ip_get_option(pcb, SOF_REUSEPORT) ||
+            !ip_get_option(ipcb, SOF_REUSEPORT))
+#endif /* SO_REUSE_PORT */
         {
           /* port matches that of PCB in list and REUSEADDR not set -> reject */
           if ((ipcb->local_port == port) &&
@@ -1012,6 +1140,9 @@ udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
 
   ip_addr_set_ipaddr(&pcb->local_ip, ipaddr);
 
+  if (rebind != 0) {
+    UDP_HASH_RMV(pcb);
+  }
   pcb->local_port = port;
   mib2_udp_bind(pcb);
   /* pcb not active yet? */
@@ -1020,6 +1151,7 @@ udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
     pcb->next = udp_pcbs;
     udp_pcbs = pcb;
   }
+  UDP_HASH_REG(pcb);
   LWIP_DEBUGF(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, ("udp_bind: bound to "));
   ip_addr_debug_print_val(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, pcb->local_ip);
   LWIP_DEBUGF(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, (", port %"U16_F")\n", pcb->local_port));
@@ -1112,6 +1244,7 @@ udp_connect(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
   /* PCB not yet on the list, add PCB now */
   pcb->next = udp_pcbs;
   udp_pcbs = pcb;
+  UDP_HASH_REG(pcb);
   return ERR_OK;
 }
 
@@ -1185,6 +1318,7 @@ udp_remove(struct udp_pcb *pcb)
   LWIP_ERROR("udp_remove: invalid pcb", pcb != NULL, return);
 
   mib2_udp_unbind(pcb);
+  UDP_HASH_RMV(pcb);
   /* pcb to be removed is first in list? */
   if (udp_pcbs == pcb) {
     /* make list start at 2nd pcb */
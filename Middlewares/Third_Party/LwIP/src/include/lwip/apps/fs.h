@@ -54,6 +54,14 @@ struct fsdata_chksum {
 #define FS_FILE_FLAGS_HEADER_PERSISTENT   0x02
 #define FS_FILE_FLAGS_HEADER_HTTPVER_1_1  0x04
 #define FS_FILE_FLAGS_SSI                 0x08
+/** set by fs_open_encoded(): other content codings of this file exist */
+#define FS_FILE_FLAGS_VARIANTS            0x10
+
+/** Content codings of precompressed files (fsdata_file::encoding) and
+ * accepted codings passed to fs_open_encoded() */
+#define FS_FILE_ENCODING_IDENTITY         0x00
+#define FS_FILE_ENCODING_DEFLATE          0x01
+#define FS_FILE_ENCODING_GZIP             0x02
 
 /** Define FS_FILE_EXTENSION_T_DEFINED if you have typedef'ed to your private
  * pointer type (defaults to 'void' so the default usage is 'void*')
@@ -74,6 +82,12 @@ struct fs_file {
   u16_t chksum_count;
 #endif /* HTTPD_PRECALCULATED_CHECKSUM */
   u8_t flags;
+#if LWIP_HTTPD_PRECOMPRESSED
+  /* content coding of data (FS_FILE_ENCODING_*) */
+  u8_t encoding;
+  /* strong entity tag (including the quotes) or NULL */
+  const char *etag;
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
 #if LWIP_HTTPD_CUSTOM_FILES
   u8_t is_custom_file;
 #endif /* LWIP_HTTPD_CUSTOM_FILES */
@@ -87,6 +101,9 @@ typedef void (*fs_wait_cb)(void *arg);
 #endif /* LWIP_HTTPD_FS_ASYNC_READ */
 
 err_t fs_open(struct fs_file *file, const char *name);
+#if LWIP_HTTPD_PRECOMPRESSED
+err_t fs_open_encoded(struct fs_file *file, const char *name, u8_t encodings);
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
 void fs_close(struct fs_file *file);
 #if LWIP_HTTPD_DYNAMIC_FILE_READ
 #if LWIP_HTTPD_FS_ASYNC_READ
@@ -117,6 +134,13 @@ struct fsdata_file {
   u16_t chksum_count;
   const struct fsdata_chksum *chksum;
 #endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_PRECOMPRESSED
+  /* next precompressed variant of this file (not linked via 'next'),
+     makefsdata sorts the variants by size */
+  const struct fsdata_file *variant;
+  const char *etag;
+  u8_t encoding;
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
 };
 
 #ifdef __cplusplus
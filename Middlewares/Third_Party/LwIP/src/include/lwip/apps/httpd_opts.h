@@ -171,6 +171,16 @@
 #define LWIP_HTTPD_DYNAMIC_HEADERS 0
 #endif
 
+/** Set this to 1 to serve the precompressed (gzip/deflate) variants and
+ * strong ETags generated by makefsdata ("-pre" and "-etag"): the variant is
+ * selected by the request's "Accept-Encoding" and a matching "If-None-Match"
+ * is answered with "304 Not Modified".
+ * Requires LWIP_HTTPD_DYNAMIC_HEADERS (the 304 headers are built at runtime).
+ */
+#if !defined LWIP_HTTPD_PRECOMPRESSED || defined __DOXYGEN__
+#define LWIP_HTTPD_PRECOMPRESSED 0
+#endif
+
 #if !defined HTTPD_DEBUG || defined __DOXYGEN__
 #define HTTPD_DEBUG         LWIP_DBG_OFF
 #endif
@@ -248,6 +258,16 @@
 #define LWIP_HTTPD_SUPPORT_11_KEEPALIVE     0
 #endif
 
+/** Set this to 1 to support pipelined HTTP/1.1 requests: requests received
+ * while a response is being sent are queued and answered in order after it.
+ * HTTP/1.1 connections are persistent unless "Connection: close" is sent
+ * (instead of requiring "Connection: keep-alive").
+ * Requires LWIP_HTTPD_SUPPORT_11_KEEPALIVE and LWIP_HTTPD_SUPPORT_REQUESTLIST.
+ */
+#if !defined LWIP_HTTPD_SUPPORT_11_PIPELINING || defined __DOXYGEN__
+#define LWIP_HTTPD_SUPPORT_11_PIPELINING    0
+#endif
+
 /** Set this to 1 to support HTTP request coming in in multiple packets/pbufs */
 #if !defined LWIP_HTTPD_SUPPORT_REQUESTLIST || defined __DOXYGEN__
 #define LWIP_HTTPD_SUPPORT_REQUESTLIST      1
@@ -305,6 +325,7 @@
 
 /** Set this to 1 to kill the oldest connection when running out of
  * memory for 'struct http_state' or 'struct http_ssi_state'.
+ * Persistent connections idle between two requests are killed first.
  * ATTENTION: This puts all connections on a linked list, so may be kind of slow.
  */
 #if !defined LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED || defined __DOXYGEN__
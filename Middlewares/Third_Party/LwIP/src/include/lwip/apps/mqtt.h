@@ -87,6 +87,9 @@ struct mqtt_connect_client_info_t {
   /** TLS configuration for secure connections */
   struct altcp_tls_config *tls_config;
 #endif
+  /** Maximum number of QoS 1 and 2 publish messages awaiting acknowledge from the
+      server (like the MQTT 5 Receive Maximum), 0 to only limit by MQTT_REQ_MAX_IN_FLIGHT */
+  u16_t receive_maximum;
 };
 
 /**
@@ -198,6 +201,33 @@ err_t mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_re
 err_t mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length, u8_t qos, u8_t retain,
                                     mqtt_request_cb_t cb, void *arg);
 
+/**
+ * @ingroup mqtt
+ * One publish message for mqtt_publish_batch() */
+struct mqtt_publish_msg_t {
+  /** Publish topic string */
+  const char *topic;
+  /** Data to publish (NULL is allowed) */
+  const void *payload;
+  /** Length of payload (0 is allowed) */
+  u16_t payload_length;
+  /** Quality of service, 0 1 or 2 */
+  u8_t qos;
+  /** MQTT retain flag */
+  u8_t retain;
+  /** Callback to call when publish is complete or has timed out */
+  mqtt_request_cb_t cb;
+  /** User supplied argument to publish callback */
+  void *arg;
+};
+
+err_t mqtt_publish_batch(mqtt_client_t *client, const struct mqtt_publish_msg_t *msgs, u16_t num_msgs, u16_t *num_queued);
+
+#if MQTT_PUBLISH_ZEROCOPY
+err_t mqtt_publish_ref(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length, u8_t qos, u8_t retain,
+                       mqtt_request_cb_t cb, void *arg);
+#endif /* MQTT_PUBLISH_ZEROCOPY */
+
 #ifdef __cplusplus
 }
 #endif
@@ -66,11 +66,34 @@ extern "C" {
 
 /**
  * Maximum number of pending subscribe, unsubscribe and publish requests to server .
+ * Requests are kept in a table indexed by packet identifier, so acknowledges are
+ * matched in constant time and this may be raised to keep a larger window of
+ * QoS 1 and 2 publish messages in flight (see also
+ * mqtt_connect_client_info_t.receive_maximum).
  */
 #ifndef MQTT_REQ_MAX_IN_FLIGHT
 #define MQTT_REQ_MAX_IN_FLIGHT 4
 #endif
 
+/**
+ * Enable mqtt_publish_ref(): the payload of a publish message is referenced
+ * (sent without copying it into the output ring-buffer, so it may be larger
+ * than the ring-buffer) until the publish is complete.
+ * Without LWIP_ALTCP, this uses tcp_write_zc() and needs TCP_WRITE_ZEROCOPY.
+ * With LWIP_ALTCP (e.g. TLS), the payload is copied into the connection
+ * instead of the ring-buffer.
+ */
+#ifndef MQTT_PUBLISH_ZEROCOPY
+#define MQTT_PUBLISH_ZEROCOPY 0
+#endif
+
+/**
+ * Maximum number of publish payloads referenced at a time by mqtt_publish_ref()
+ */
+#ifndef MQTT_PUBLISH_REF_MAX
+#define MQTT_PUBLISH_REF_MAX 4
+#endif
+
 /**
  * Seconds between each cyclic timer call.
  */
@@ -50,15 +50,55 @@ struct mqtt_request_t
   /** Next item in list, NULL means this is the last in chain,
       next pointing at itself means request is unallocated */
   struct mqtt_request_t *next;
+  /** Previous item in list, NULL means this is the first in chain */
+  struct mqtt_request_t *prev;
   /** Callback to upper layer */
   mqtt_request_cb_t cb;
   void *arg;
   /** MQTT packet identifier */
   u16_t pkt_id;
-  /** Expire time relative to element before this  */
-  u16_t timeout_diff;
+  /** Request tick at which the request times out */
+  u16_t timeout_tick;
+  /** 1 for a QoS 1 or 2 publish, counted against the receive maximum */
+  u8_t publish;
 };
 
+/** Queue of pending requests, ordered by timeout */
+struct mqtt_request_queue_t
+{
+  struct mqtt_request_t *head;
+  struct mqtt_request_t *tail;
+  /** Number of QoS 1 and 2 publish requests in queue */
+  u16_t publish_count;
+};
+
+#if MQTT_PUBLISH_ZEROCOPY
+/** Publish payload referenced by the output queue, see mqtt_publish_ref() */
+struct mqtt_output_ref_t
+{
+  /** Next payload to write, NULL means this is the last in chain */
+  struct mqtt_output_ref_t *next;
+  /** Referenced payload */
+  const u8_t *data;
+  u16_t len;
+  /** Number of payload bytes written to the connection */
+  u16_t written;
+  /** Output ring-buffer put index after the message header (topic and packet id) */
+  u16_t ring_pos;
+  /** Completion state, 0 means unallocated */
+  u8_t state;
+  /** Result of the request */
+  err_t err;
+  /** Callback to upper layer */
+  mqtt_request_cb_t cb;
+  void *arg;
+#if !LWIP_ALTCP
+  /** Write handle of tcp_write_zc() */
+  struct tcp_zc_write zc;
+#endif /* !LWIP_ALTCP */
+};
+#endif /* MQTT_PUBLISH_ZEROCOPY */
+
 /** Ring buffer */
 struct mqtt_ringbuf_t {
   u16_t put;
@@ -83,9 +123,16 @@ struct mqtt_client_s
   /** Connection callback */
   void *connect_arg;
   mqtt_connection_cb_t connect_cb;
-  /** Pending requests to server */
-  struct mqtt_request_t *pend_req_queue;
+  /** Requests waiting for a response from server */
+  struct mqtt_request_queue_t pend_req_queue;
+  /** QoS 0 publish requests waiting for the data to be sent */
+  struct mqtt_request_queue_t pend_qos0_queue;
+  /** Request items, indexed by packet identifier modulo MQTT_REQ_MAX_IN_FLIGHT */
   struct mqtt_request_t req_list[MQTT_REQ_MAX_IN_FLIGHT];
+  /** Request timeout clock, counts cyclic timer intervals while connected */
+  u16_t req_tick;
+  /** Maximum number of QoS 1 and 2 publish requests in pend_req_queue, 0 for no limit */
+  u16_t receive_max;
   void *inpub_arg;
   /** Incoming data callback */
   mqtt_incoming_data_cb_t data_cb;
@@ -95,6 +142,13 @@ struct mqtt_client_s
   u8_t rx_buffer[MQTT_VAR_HEADER_BUFFER_LEN];
   /** Output ring-buffer */
   struct mqtt_ringbuf_t output;
+#if MQTT_PUBLISH_ZEROCOPY
+  /** Referenced payloads not completely written to the connection yet */
+  struct mqtt_output_ref_t *output_refs;
+  /** Must stay the last member: mqtt_client_connect() wipes everything
+      before it and keeps the payloads of the last connection */
+  struct mqtt_output_ref_t output_ref_list[MQTT_PUBLISH_REF_MAX];
+#endif /* MQTT_PUBLISH_ZEROCOPY */
 };
 
 #ifdef __cplusplus
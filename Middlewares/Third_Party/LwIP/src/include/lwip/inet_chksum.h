@@ -57,6 +57,11 @@
     as u16_t */
 # ifndef LWIP_CHKSUM_COPY
 #  define LWIP_CHKSUM_COPY(dst, src, len) lwip_chksum_copy(dst, src, len)
+/** LWIP_CHKSUM_COPY_ALGORITHM selects lwip_chksum_copy():
+    1: MEMCPY, then LWIP_CHKSUM over the copy
+    2: copy and checksum fused into one pass over the data (32-bit words into
+       a 64-bit accumulator, needs u64_t); LWIP_CHKSUM_ALGORITHM and
+       LWIP_CHKSUM_GCC_VECTOR don't apply to it */
 #  ifndef LWIP_CHKSUM_COPY_ALGORITHM
 #   define LWIP_CHKSUM_COPY_ALGORITHM 1
 #  endif /* LWIP_CHKSUM_COPY_ALGORITHM */
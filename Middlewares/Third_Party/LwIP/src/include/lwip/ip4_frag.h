@@ -65,6 +65,18 @@ struct ip_reassdata {
   u16_t datagram_len;
   u8_t flags;
   u8_t timer;
+  /** number of pbufs enqueued for this datagram */
+  u16_t pbufs;
+#if IP_REASS_TREE
+  /** number of bytes received (enqueued fragments never overlap) */
+  u16_t recvd;
+  /** highest end offset seen */
+  u16_t max_end;
+#endif /* IP_REASS_TREE */
+#if IPREASS_STATS
+  /** sys_now() when the first fragment arrived */
+  u32_t start_time;
+#endif /* IPREASS_STATS */
 };
 
 void ip_reass_init(void);
@@ -72,7 +84,7 @@ void ip_reass_tmr(void);
 struct pbuf * ip4_reass(struct pbuf *p);
 #endif /* IP_REASSEMBLY */
 
-#if IP_FRAG
+#if IP_FRAG || TCP_TSO
 #if !LWIP_NETIF_TX_SINGLE_PBUF
 #ifndef LWIP_PBUF_CUSTOM_REF_DEFINED
 #define LWIP_PBUF_CUSTOM_REF_DEFINED
@@ -87,10 +99,16 @@ struct pbuf_custom_ref {
 };
 #endif /* LWIP_PBUF_CUSTOM_REF_DEFINED */
 #endif /* !LWIP_NETIF_TX_SINGLE_PBUF */
+#endif /* IP_FRAG || TCP_TSO */
 
+#if IP_FRAG
 err_t ip4_frag(struct pbuf *p, struct netif *netif, const ip4_addr_t *dest);
 #endif /* IP_FRAG */
 
+#if TCP_TSO
+err_t ip4_tso_output(struct pbuf *p, struct netif *netif, const ip4_addr_t *dest);
+#endif /* TCP_TSO */
+
 #ifdef __cplusplus
 }
 #endif
@@ -97,7 +97,7 @@ extern const struct memp_desc* const memp_pools[MEMP_MAX];
     \
   LWIP_MEMPOOL_DECLARE_STATS_INSTANCE(memp_stats_ ## name) \
     \
-  static struct memp *memp_tab_ ## name; \
+  static memp_head_t memp_tab_ ## name; \
     \
   const struct memp_desc memp_ ## name = { \
     DECLARE_LWIP_MEMPOOL_DESC(desc) \
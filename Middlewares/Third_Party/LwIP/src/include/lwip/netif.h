@@ -105,6 +105,10 @@ extern "C" {
 /** If set, the netif has MLD6 capability.
  * Set by the netif driver in its init function. */
 #define NETIF_FLAG_MLD6         0x40U
+/** If set, the netif accepts TCP super-segments (see TCP_TSO) and cuts
+ * them into p->tso_mss sized frames itself (hardware TSO).
+ * Set by the netif driver in its init function. */
+#define NETIF_FLAG_TSO          0x80U
 
 /**
  * @}
@@ -379,6 +383,10 @@ struct netif {
 #if LWIP_NETIF_USE_HINTS
   struct netif_hint *hints;
 #endif /* LWIP_NETIF_USE_HINTS */
+#if LWIP_IPV4 && LWIP_ARP && ETHARP_TABLE_HASH && !LWIP_NETIF_HWADDRHINT
+  /** ARP table entry last used for sending on this netif */
+  netif_addr_idx_t arp_hint;
+#endif /* LWIP_IPV4 && LWIP_ARP && ETHARP_TABLE_HASH && !LWIP_NETIF_HWADDRHINT */
 #if ENABLE_LOOPBACK
   /* List of packets to be queued for ourselves. */
   struct pbuf *loop_first;
@@ -120,6 +120,17 @@
 #if !defined LWIP_TIMERS_CUSTOM || defined __DOXYGEN__
 #define LWIP_TIMERS_CUSTOM              0
 #endif
+
+/**
+ * LWIP_TIMERS_WHEEL==1: Keep pending timeouts in a hierarchical timing wheel
+ * instead of a sorted list. sys_timeout() and expiry become O(1) instead of
+ * O(n), which pays off with many concurrent timeouts. Costs
+ * SYS_TIMEO_WHEEL_LEVELS * SYS_TIMEO_WHEEL_SLOTS pointers of RAM plus one
+ * pointer per struct sys_timeo. sys_untimeout() still has to search.
+ */
+#if !defined LWIP_TIMERS_WHEEL || defined __DOXYGEN__
+#define LWIP_TIMERS_WHEEL               0
+#endif
 /**
  * @}
  */
@@ -318,6 +329,19 @@
 #define MEMP_SANITY_CHECK               0
 #endif
 
+/**
+ * MEMP_LOCKFREE==1: keep the free elements of each pool on a lock-free
+ * stack updated with SYS_ARCH_CAS_U32() instead of protecting memp_malloc()
+ * and memp_free() with SYS_ARCH_PROTECT. The list head carries a
+ * modification tag next to the element index to detect ABA races, which
+ * limits pools to 65534 elements. Pool statistics are not updated atomically
+ * in this mode.
+ * Not compatible with MEMP_MEM_MALLOC and MEMP_SANITY_CHECK.
+ */
+#if !defined MEMP_LOCKFREE || defined __DOXYGEN__
+#define MEMP_LOCKFREE                   0
+#endif
+
 /**
  * MEM_OVERFLOW_CHECK: mem overflow protection reserves a configurable
  * amount of bytes before and after each heap allocation chunk and fills
@@ -452,6 +476,16 @@
 #define MEMP_NUM_TCP_SEG                16
 #endif
 
+/**
+ * MEMP_NUM_TCP_ZC_PBUF: the number of simultaneously queued application data
+ * references created by tcp_write_zc(). Each segment needs one per iovec
+ * slice it covers.
+ * (requires the TCP_WRITE_ZEROCOPY option)
+ */
+#if !defined MEMP_NUM_TCP_ZC_PBUF || defined __DOXYGEN__
+#define MEMP_NUM_TCP_ZC_PBUF            MEMP_NUM_TCP_SEG
+#endif
+
 /**
  * MEMP_NUM_ALTCP_PCB: the number of simultaneously active altcp layer pcbs.
  * (requires the LWIP_ALTCP option)
@@ -472,7 +506,8 @@
 
 /**
  * MEMP_NUM_FRAG_PBUF: the number of IP fragments simultaneously sent
- * (fragments, not whole packets!).
+ * (fragments, not whole packets!). TCP_TSO frames cut in software take
+ * these from the same pool.
  * This is only used with LWIP_NETIF_TX_SINGLE_PBUF==0 and only has to be > 1
  * with DMA-enabled MACs where the packet is not yet sent when netif->output
  * returns.
@@ -541,6 +576,15 @@
 #define MEMP_NUM_SELECT_CB              4
 #endif
 
+/**
+ * MEMP_NUM_EPOLL_ITEM: the number of sockets that can be registered with
+ * epoll instances at the same time (one per lwip_epoll_ctl(EPOLL_CTL_ADD)).
+ * (requires LWIP_SOCKET_EPOLL)
+ */
+#if !defined MEMP_NUM_EPOLL_ITEM || defined __DOXYGEN__
+#define MEMP_NUM_EPOLL_ITEM             MEMP_NUM_NETCONN
+#endif
+
 /**
  * MEMP_NUM_TCPIP_MSG_API: the number of struct tcpip_msg, which are used
  * for callback/timeout API communication.
@@ -706,6 +750,26 @@
 #if !defined ETHARP_TABLE_MATCH_NETIF || defined __DOXYGEN__
 #define ETHARP_TABLE_MATCH_NETIF        !LWIP_SINGLE_NETIF
 #endif
+
+/**
+ * ETHARP_TABLE_HASH==1: Index the ARP table by IP address (open addressing),
+ * so that etharp_output() and ARP input find an entry without scanning the
+ * whole table. Allocation and eviction of entries are unchanged.
+ * Without LWIP_NETIF_HWADDRHINT, this also keeps the last used entry per netif
+ * instead of a single global one.
+ */
+#if !defined ETHARP_TABLE_HASH || defined __DOXYGEN__
+#define ETHARP_TABLE_HASH               0
+#endif
+
+/**
+ * ETHARP_TABLE_HASH_SIZE: Number of slots of the ARP table index. Must be
+ * bigger than ARP_TABLE_SIZE; about twice its size keeps probe chains short.
+ * Only used if ETHARP_TABLE_HASH==1.
+ */
+#if !defined ETHARP_TABLE_HASH_SIZE || defined __DOXYGEN__
+#define ETHARP_TABLE_HASH_SIZE          (2 * ARP_TABLE_SIZE)
+#endif
 /**
  * @}
  */
@@ -794,6 +858,26 @@
 #define IP_REASS_MAX_PBUFS              10
 #endif
 
+/**
+ * IP_REASS_MAX_PBUFS_PER_SRC: Maximum amount of pbufs waiting to be
+ * reassembled for one source address, so that a single sender cannot occupy
+ * the whole reassembly buffer. Fragments exceeding it are dropped.
+ */
+#if !defined IP_REASS_MAX_PBUFS_PER_SRC || defined __DOXYGEN__
+#define IP_REASS_MAX_PBUFS_PER_SRC      IP_REASS_MAX_PBUFS
+#endif
+
+/**
+ * IP_REASS_TREE==1: Keep the fragments of a datagram in a splay tree ordered
+ * by offset instead of a sorted list, so that enqueueing fragments arriving
+ * out of order costs O(log n) (amortized) instead of O(n). Overlapping
+ * fragments are trimmed to the data not received yet instead of being
+ * dropped; data received first wins.
+ */
+#if !defined IP_REASS_TREE || defined __DOXYGEN__
+#define IP_REASS_TREE                   0
+#endif
+
 /**
  * IP_DEFAULT_TTL: Default value for Time-To-Live used by transport layers.
  */
@@ -828,6 +912,37 @@
 #if !defined IP_FORWARD_ALLOW_TX_ON_RX_NETIF || defined __DOXYGEN__
 #define IP_FORWARD_ALLOW_TX_ON_RX_NETIF 0
 #endif
+
+/**
+ * IP_GRO==1: Merge in-order TCP segments of the same connection received in
+ * one batch into a single packet before IP and TCP input processing
+ * (software GRO). Only segments addressed to one of our netifs are merged,
+ * forwarded traffic (IP_FORWARD) is passed on unchanged. ethernet_input()
+ * passes IPv4 packets to ip4_gro_input(), which holds back mergeable segments
+ * until ip4_gro_flush() is called.
+ * tcpip_thread flushes after each batch of messages (see
+ * TCPIP_MBOX_BATCH_SIZE and tcpip_inpkt_batch()); with NO_SYS==1, call
+ * ip4_gro_flush() after each round of passing packets to netif->input().
+ */
+#if !defined IP_GRO || defined __DOXYGEN__
+#define IP_GRO                          0
+#endif
+
+/**
+ * IP_GRO_MAX_FLOWS: Number of TCP connections whose segments can be merged
+ * at the same time.
+ */
+#if !defined IP_GRO_MAX_FLOWS || defined __DOXYGEN__
+#define IP_GRO_MAX_FLOWS                4
+#endif
+
+/**
+ * IP_GRO_MAX_SEGS: Maximum number of segments merged into one packet
+ * (at most 255).
+ */
+#if !defined IP_GRO_MAX_SEGS || defined __DOXYGEN__
+#define IP_GRO_MAX_SEGS                 16
+#endif
 /**
  * @}
  */
@@ -1159,6 +1274,40 @@
 #if !defined LWIP_DNS_SUPPORT_MDNS_QUERIES || defined __DOXYGEN__
 #define LWIP_DNS_SUPPORT_MDNS_QUERIES   0
 #endif
+
+/** LWIP_DNS_CACHE==1: Keep resolved names in a separate hashed cache.
+ *  dns_table then only holds the queries in flight. The cache honours the
+ *  TTL of answers, remembers failed lookups (negative caching, RFC 2308) and
+ *  refreshes names that were looked up before they expire. */
+#if !defined LWIP_DNS_CACHE || defined __DOXYGEN__
+#define LWIP_DNS_CACHE                  0
+#endif
+
+/** DNS_CACHE_SIZE: Number of names (per address family) the cache can hold.
+ *  The least recently used entry is replaced when the cache is full. */
+#if !defined DNS_CACHE_SIZE || defined __DOXYGEN__
+#define DNS_CACHE_SIZE                  16
+#endif
+
+/** DNS_CACHE_HASH_SIZE: Number of hash buckets of the cache.
+ *  Should be a power of two. */
+#if !defined DNS_CACHE_HASH_SIZE || defined __DOXYGEN__
+#define DNS_CACHE_HASH_SIZE             8
+#endif
+
+/** DNS_CACHE_NEG_TTL: Maximum time in seconds a failed lookup (NXDOMAIN or
+ *  no address of the requested type) is cached. Shortened to the SOA
+ *  minimum of the response if that is smaller. 0 disables negative caching. */
+#if !defined DNS_CACHE_NEG_TTL || defined __DOXYGEN__
+#define DNS_CACHE_NEG_TTL               60
+#endif
+
+/** DNS_CACHE_PREFETCH_TTL: Names that have been looked up since they were
+ *  cached are queried again once their remaining TTL drops to this many
+ *  seconds, so frequently used names do not expire. 0 disables prefetching. */
+#if !defined DNS_CACHE_PREFETCH_TTL || defined __DOXYGEN__
+#define DNS_CACHE_PREFETCH_TTL          10
+#endif
 /**
  * @}
  */
@@ -1200,6 +1349,24 @@
 #if !defined LWIP_NETBUF_RECVINFO || defined __DOXYGEN__
 #define LWIP_NETBUF_RECVINFO            0
 #endif
+
+/**
+ * UDP_PCB_HASH==1: Index bound UDP pcbs by their local port, so that
+ * udp_input() and udp_bind() only walk the pcbs sharing a hash bucket
+ * instead of the whole udp_pcbs list.
+ * Costs one pointer per pcb plus the bucket array.
+ */
+#if !defined UDP_PCB_HASH || defined __DOXYGEN__
+#define UDP_PCB_HASH                    0
+#endif
+
+/**
+ * UDP_PCB_HASH_SIZE: Number of buckets of the local-port index.
+ * Only used if UDP_PCB_HASH==1. Should be a power of two.
+ */
+#if !defined UDP_PCB_HASH_SIZE || defined __DOXYGEN__
+#define UDP_PCB_HASH_SIZE               16
+#endif
 /**
  * @}
  */
@@ -1268,6 +1435,17 @@
 #define LWIP_TCP_SACK_OUT               0
 #endif
 
+/**
+ * LWIP_TCP_SACK_IN==1: TCP will process selective acknowledgements (SACKs)
+ * received from the remote host. The unacked queue is used as scoreboard so
+ * that only segments detected as lost are retransmitted, and losses are
+ * detected by the time-based RACK algorithm (RFC 8985) instead of counting
+ * duplicate ACKs. Costs 4 bytes per segment and some 30 bytes per pcb.
+ */
+#if !defined LWIP_TCP_SACK_IN || defined __DOXYGEN__
+#define LWIP_TCP_SACK_IN                0
+#endif
+
 /**
  * LWIP_TCP_MAX_SACK_NUM: The maximum number of SACK values to include in TCP segments.
  * Must be at least 1, but is only used if LWIP_TCP_SACK_OUT is enabled.
@@ -1386,6 +1564,21 @@
 #endif
 #endif
 
+/**
+ * TCP_OOSEQ_RANGES: Maximum number of segments per pcb in the sorted index of
+ * out-of-sequence data. If > 0, received data that is contiguous with a
+ * queued segment is merged into it (up to 64 KByte per segment), so the ooseq
+ * queue holds one segment per range and the insertion point is found by
+ * binary search instead of walking the list. When the index is full, the
+ * highest range is dropped first, and pbuf_free_ooseq() frees only the
+ * highest range of a pcb instead of its whole queue.
+ * Default is 0 (unsorted list, per-segment walk).
+ * Only valid for TCP_QUEUE_OOSEQ==1.
+ */
+#if !defined TCP_OOSEQ_RANGES || defined __DOXYGEN__
+#define TCP_OOSEQ_RANGES                0
+#endif
+
 /**
  * TCP_LISTEN_BACKLOG: Enable the backlog option for tcp listen pcb.
  */
@@ -1479,6 +1672,85 @@
 #define LWIP_TCP_PCB_NUM_EXT_ARGS       0
 #endif
 
+/**
+ * TCP_PCB_HASH==1: Index active and TIME-WAIT pcbs by their 4-tuple and
+ * listening pcbs by their local port, so that tcp_input() demultiplexes
+ * incoming segments without walking the pcb lists.
+ * Costs one pointer per pcb plus the bucket arrays below.
+ */
+#if !defined TCP_PCB_HASH || defined __DOXYGEN__
+#define TCP_PCB_HASH                    0
+#endif
+
+/**
+ * TCP_PCB_HASH_SIZE: Number of buckets of the 4-tuple hash table used for
+ * active and TIME-WAIT pcbs. Only used if TCP_PCB_HASH==1.
+ * Should be a power of two.
+ */
+#if !defined TCP_PCB_HASH_SIZE || defined __DOXYGEN__
+#define TCP_PCB_HASH_SIZE               64
+#endif
+
+/**
+ * TCP_LISTEN_PCB_HASH_SIZE: Number of buckets of the local-port index used
+ * for listening pcbs. Only used if TCP_PCB_HASH==1.
+ * Should be a power of two.
+ */
+#if !defined TCP_LISTEN_PCB_HASH_SIZE || defined __DOXYGEN__
+#define TCP_LISTEN_PCB_HASH_SIZE        16
+#endif
+
+/**
+ * TCP_WRITE_ZEROCOPY==1: Enable tcp_write_zc(), which enqueues application
+ * buffers described by an iovec array by reference and notifies the
+ * application once the stack has released them (i.e. after they have been
+ * ACKed). Requires custom pbuf support (LWIP_SUPPORT_CUSTOM_PBUF).
+ */
+#if !defined TCP_WRITE_ZEROCOPY || defined __DOXYGEN__
+#define TCP_WRITE_ZEROCOPY              0
+#endif
+
+/**
+ * TCP_TSO==1: Enable TCP segmentation offload for IPv4. tcp_write() then
+ * queues segments of up to TCP_TSO_MAX_SEGS * MSS bytes, which pass through
+ * tcp_output() and ip4_output() as one packet. On the way to the netif such
+ * a super-segment is cut into MSS sized frames (replicating the IP and TCP
+ * headers and referencing the payload) unless the netif announces
+ * NETIF_FLAG_TSO, in which case the driver is handed the super-segment and
+ * p->tso_mss and does the cutting itself.
+ */
+#if !defined TCP_TSO || defined __DOXYGEN__
+#define TCP_TSO                         0
+#endif
+
+/**
+ * TCP_TSO_MAX_SEGS: Maximum number of MSS sized frames tcp_write() packs
+ * into one super-segment when TCP_TSO==1. Segments are further limited to
+ * half of the congestion and send windows.
+ */
+#if !defined TCP_TSO_MAX_SEGS || defined __DOXYGEN__
+#define TCP_TSO_MAX_SEGS                8
+#endif
+
+/**
+ * LWIP_TCP_CC==1: Make TCP congestion control selectable per pcb (see
+ * tcp_set_cc()). Besides NewReno, CUBIC (tcp_cc_cubic) and a lightweight
+ * model-based algorithm sizing cwnd from the measured bottleneck bandwidth
+ * and minimum RTT (tcp_cc_bbrlite) are provided; applications can add their
+ * own struct tcp_cc_ops. With LWIP_TCP_CC==0, all pcbs use NewReno.
+ */
+#if !defined LWIP_TCP_CC || defined __DOXYGEN__
+#define LWIP_TCP_CC                     0
+#endif
+
+/**
+ * TCP_CC_DEFAULT: The congestion control algorithm new pcbs start with
+ * (a pointer to a struct tcp_cc_ops). Only used if LWIP_TCP_CC==1.
+ */
+#if !defined TCP_CC_DEFAULT || defined __DOXYGEN__
+#define TCP_CC_DEFAULT                  (&tcp_cc_newreno)
+#endif
+
 /** LWIP_ALTCP==1: enable the altcp API.
  * altcp is an abstraction layer that prevents applications linking against the
  * tcp.h functions but provides the same functionality. It is used to e.g. add
@@ -1775,6 +2047,28 @@
 #define TCPIP_MBOX_SIZE                 0
 #endif
 
+/**
+ * TCPIP_MBOX_BATCH_SIZE: The maximum number of messages tcpip_thread handles
+ * per wakeup. After a blocking fetch returned, up to TCPIP_MBOX_BATCH_SIZE-1
+ * further messages that are already queued are handled without waiting and
+ * without releasing the core lock in between. Timeouts are checked between
+ * batches only, so keep this small (1 handles each message separately).
+ */
+#if !defined TCPIP_MBOX_BATCH_SIZE || defined __DOXYGEN__
+#define TCPIP_MBOX_BATCH_SIZE           1
+#endif
+
+/**
+ * LWIP_SPSC_RING==1: build the lock-free single-producer/single-consumer
+ * rings (lwip/spsc_ring.h) that netif drivers can use to hand RX and TX
+ * pbufs to and from the stack, including tcpip_rxring for passing received
+ * packets to tcpip_thread with one mbox post per batch.
+ * Needs SYS_ARCH_MEMORY_BARRIER and SYS_ARCH_CAS_U32 (see sys.h).
+ */
+#if !defined LWIP_SPSC_RING || defined __DOXYGEN__
+#define LWIP_SPSC_RING                  0
+#endif
+
 /**
  * Define this to something that triggers a watchdog. This is called from
  * tcpip_thread after processing a message.
@@ -2049,6 +2343,17 @@
 #define SO_REUSE_RXTOALL                0
 #endif
 
+/**
+ * SO_REUSE_PORT==1: Enable SO_REUSEPORT option for UDP. Unconnected pcbs
+ * that all have SOF_REUSEPORT set may bind the same local address and port;
+ * unicast datagrams are spread among them by a hash of the remote address
+ * and ports, so every remote flow sticks to one pcb (e.g. one worker task
+ * per socket).
+ */
+#if !defined SO_REUSE_PORT || defined __DOXYGEN__
+#define SO_REUSE_PORT                   0
+#endif
+
 /**
  * LWIP_FIONREAD_LINUXMODE==0 (default): ioctl/FIONREAD returns the amount of
  * pending data in the network buffer. This is the way windows does it. It's
@@ -2078,6 +2383,54 @@
 #if !defined LWIP_SOCKET_POLL || defined __DOXYGEN__
 #define LWIP_SOCKET_POLL                1
 #endif
+
+/**
+ * LWIP_SOCKET_EPOLL==1: enable lwip_epoll_create/ctl/wait(). Every socket
+ * keeps a list of the epoll instances interested in it and event_callback()
+ * queues it on their ready lists directly, so lwip_epoll_wait() only costs
+ * O(ready sockets) instead of rescanning all watched sockets.
+ * Requires LWIP_SOCKET_SELECT or LWIP_SOCKET_POLL for the socket events.
+ */
+#if !defined LWIP_SOCKET_EPOLL || defined __DOXYGEN__
+#define LWIP_SOCKET_EPOLL               0
+#endif
+
+/**
+ * LWIP_SOCKET_MAX_EPOLL: the number of epoll instances that can be open at
+ * the same time. Their descriptors follow the socket descriptors, starting at
+ * LWIP_SOCKET_OFFSET + MEMP_NUM_NETCONN.
+ */
+#if !defined LWIP_SOCKET_MAX_EPOLL || defined __DOXYGEN__
+#define LWIP_SOCKET_MAX_EPOLL           1
+#endif
+
+/**
+ * LWIP_SOCKET_MMSG_BATCH: maximum number of datagrams lwip_sendmmsg() passes
+ * to the tcpip_thread with one API message (or one core lock acquisition).
+ * The netbufs of a batch live on the stack of the calling thread.
+ */
+#if !defined LWIP_SOCKET_MMSG_BATCH || defined __DOXYGEN__
+#define LWIP_SOCKET_MMSG_BATCH          8
+#endif
+
+/**
+ * LWIP_SOCKET_RECV_ZC==1: enable lwip_recv_zc() and lwip_recv_zc_release().
+ * lwip_recv_zc() hands the received pbuf chain to the application instead of
+ * copying it. For TCP, the bytes handed out are only given back to the
+ * receive window when the chain is returned with lwip_recv_zc_release().
+ */
+#if !defined LWIP_SOCKET_RECV_ZC || defined __DOXYGEN__
+#define LWIP_SOCKET_RECV_ZC             0
+#endif
+
+/**
+ * LWIP_SOCKET_RECV_ZC_MAX: maximum number of chains a TCP socket can have
+ * handed out by lwip_recv_zc() and not released yet. Further calls fail with
+ * ENOBUFS until one of them is released.
+ */
+#if !defined LWIP_SOCKET_RECV_ZC_MAX || defined __DOXYGEN__
+#define LWIP_SOCKET_RECV_ZC_MAX         4
+#endif
 /**
  * @}
  */
@@ -2137,6 +2490,14 @@
 #define IPFRAG_STATS                    (IP_REASSEMBLY || IP_FRAG)
 #endif
 
+/**
+ * IPREASS_STATS==1: Enable IPv4 reassembly stats (completed, timed out and
+ * evicted datagrams, overlapping and over-quota fragments, latency).
+ */
+#if !defined IPREASS_STATS || defined __DOXYGEN__
+#define IPREASS_STATS                   (LWIP_IPV4 && IP_REASSEMBLY)
+#endif
+
 /**
  * ICMP_STATS==1: Enable ICMP stats.
  */
@@ -2236,6 +2597,7 @@
 #define ETHARP_STATS                    0
 #define IP_STATS                        0
 #define IPFRAG_STATS                    0
+#define IPREASS_STATS                   0
 #define ICMP_STATS                      0
 #define IGMP_STATS                      0
 #define UDP_STATS                       0
@@ -52,7 +52,8 @@ extern "C" {
  * Currently, the pbuf_custom code is only needed for one specific configuration
  * of IP_FRAG, unless required by external driver/application code. */
 #ifndef LWIP_SUPPORT_CUSTOM_PBUF
-#define LWIP_SUPPORT_CUSTOM_PBUF ((IP_FRAG && !LWIP_NETIF_TX_SINGLE_PBUF) || (LWIP_IPV6 && LWIP_IPV6_FRAG))
+#define LWIP_SUPPORT_CUSTOM_PBUF (((IP_FRAG || (LWIP_TCP && TCP_TSO)) && !LWIP_NETIF_TX_SINGLE_PBUF) || \
+                                  (LWIP_IPV6 && LWIP_IPV6_FRAG) || (LWIP_TCP && TCP_WRITE_ZEROCOPY))
 #endif
 
 /** @ingroup pbuf 
@@ -219,6 +220,12 @@ struct pbuf {
 
   /** For incoming packets, this contains the input netif's index */
   u8_t if_idx;
+
+#if TCP_TSO
+  /** For outgoing TCP super-segments, the payload size of the frames they
+   * have to be cut into (0 for normal packets) */
+  u16_t tso_mss;
+#endif /* TCP_TSO */
 };
 
 
@@ -247,6 +254,24 @@ struct pbuf_custom {
 };
 #endif /* LWIP_SUPPORT_CUSTOM_PBUF */
 
+/** A read position in a pbuf chain. Parsers reading a chain sequentially use
+ * it to continue where the last access stopped instead of walking the chain
+ * from its head for every byte or field (see pbuf_cursor_init()).
+ */
+struct pbuf_cursor {
+  /** first pbuf of the chain (used to seek backwards) */
+  const struct pbuf *head;
+  /** pbuf containing the position, NULL if the position is at or behind the end */
+  const struct pbuf *p;
+  /** offset of 'p' in the chain */
+  u16_t start;
+  /** offset of the position in 'p' */
+  u16_t off;
+};
+
+/** Get the offset of a cursor's position in the chain */
+#define pbuf_cursor_pos(c)  ((u16_t)((c)->start + (c)->off))
+
 /** Define this to 0 to prevent freeing ooseq pbufs when the PBUF_POOL is empty */
 #ifndef PBUF_POOL_FREE_OOSEQ
 #define PBUF_POOL_FREE_OOSEQ 1
@@ -315,6 +340,14 @@ u16_t pbuf_memcmp(const struct pbuf* p, u16_t offset, const void* s2, u16_t n);
 u16_t pbuf_memfind(const struct pbuf* p, const void* mem, u16_t mem_len, u16_t start_offset);
 u16_t pbuf_strstr(const struct pbuf* p, const char* substr);
 
+void pbuf_cursor_init(struct pbuf_cursor *c, const struct pbuf *p, u16_t offset);
+err_t pbuf_cursor_seek(struct pbuf_cursor *c, u16_t offset);
+err_t pbuf_cursor_skip(struct pbuf_cursor *c, u16_t len);
+int pbuf_cursor_get(struct pbuf_cursor *c);
+u16_t pbuf_cursor_read(struct pbuf_cursor *c, void *dataptr, u16_t len);
+u16_t pbuf_cursor_memcmp(const struct pbuf_cursor *c, const void *s2, u16_t n);
+void *pbuf_cursor_get_contiguous(struct pbuf_cursor *c, void *buffer, size_t bufsize, u16_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -75,6 +75,16 @@ struct memp {
 };
 #endif /* !MEMP_MEM_MALLOC || MEMP_OVERFLOW_CHECK */
 
+#if MEMP_LOCKFREE
+/* Head of a lock-free free list: index of the first free element in the
+   lower 16 bits, modification tag in the upper 16 bits */
+typedef u32_t memp_head_t;
+/* Element index marking an empty list */
+#define MEMP_LOCKFREE_NIL  0xFFFFU
+#else /* MEMP_LOCKFREE */
+typedef struct memp *memp_head_t;
+#endif /* MEMP_LOCKFREE */
+
 #if MEM_USE_POOLS && MEMP_USE_CUSTOM_POOLS
 /* Use a helper type to get the start and end of the user "memory pools" for mem_malloc */
 typedef enum {
@@ -126,7 +136,7 @@ struct memp_desc {
   u8_t *base;
 
   /** First free element of each pool. Elements form a linked list. */
-  struct memp **tab;
+  memp_head_t *tab;
 #endif /* MEMP_MEM_MALLOC */
 };
 
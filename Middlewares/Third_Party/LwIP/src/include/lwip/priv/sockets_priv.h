@@ -63,6 +63,62 @@ union lwip_sock_lastdata {
   struct pbuf *pbuf;
 };
 
+#if LWIP_SOCKET_EPOLL
+struct lwip_sock;
+struct lwip_epoll;
+
+/** One socket registered with one epoll instance */
+struct lwip_epoll_item {
+  /** next registration of the same socket */
+  struct lwip_epoll_item *next;
+  /** links in the epoll instance's ready list */
+  struct lwip_epoll_item *ready_next;
+  struct lwip_epoll_item *ready_prev;
+  /** the epoll instance this socket is registered with */
+  struct lwip_epoll *ep;
+  /** the registered socket */
+  struct lwip_sock *sock;
+  /** events passed to lwip_epoll_ctl */
+  u32_t events;
+  /** user data passed to lwip_epoll_ctl, returned by lwip_epoll_wait */
+  epoll_data_t data;
+  /** 1 while linked into ep's ready list */
+  u8_t queued;
+  /** 0 after an EPOLLONESHOT event has been reported (until EPOLL_CTL_MOD) */
+  u8_t armed;
+};
+
+/** An epoll instance: its registrations are linked to the sockets, it only
+ * keeps the ready list */
+struct lwip_epoll {
+  /** first and last item in the ready list */
+  struct lwip_epoll_item *ready_head;
+  struct lwip_epoll_item *ready_tail;
+  /** number of items in the ready list */
+  u16_t ready_cnt;
+  /** 1 while this instance is allocated */
+  u8_t used;
+  /** don't signal the semaphore twice: set to 1 when signalled */
+  u8_t sem_signalled;
+  /** number of threads waiting in lwip_epoll_wait */
+  SELWAIT_T waiting;
+  /** semaphore to wake up threads waiting in lwip_epoll_wait */
+  sys_sem_t sem;
+};
+#endif /* LWIP_SOCKET_EPOLL */
+
+#if LWIP_SOCKET_RECV_ZC
+/** A TCP pbuf chain handed out by lwip_recv_zc() and not released yet */
+struct lwip_sock_zc_held {
+  /** first pbuf of the chain, NULL while the entry is unused or reserved */
+  struct pbuf *p;
+  /** bytes kept out of the receive window for this chain */
+  u16_t len;
+  /** entry reserved by a receiving thread or holding a chain */
+  u8_t in_use;
+};
+#endif /* LWIP_SOCKET_RECV_ZC */
+
 /** Contains all internal pointers and states used for a socket */
 struct lwip_sock {
   /** sockets currently are built on netconns, each socket has one netconn */
@@ -81,6 +137,16 @@ struct lwip_sock {
   /** counter of how many threads are waiting for this socket using select */
   SELWAIT_T select_waiting;
 #endif /* LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL */
+#if LWIP_SOCKET_EPOLL
+  /** registrations of this socket with epoll instances */
+  struct lwip_epoll_item *epoll_items;
+#endif /* LWIP_SOCKET_EPOLL */
+#if LWIP_SOCKET_RECV_ZC
+  /** TCP chains handed out by lwip_recv_zc() and not released yet: their
+      bytes are kept out of the receive window. A chain is only credited to
+      the socket that handed it out, not to a later one reusing the fd. */
+  struct lwip_sock_zc_held zc_held[LWIP_SOCKET_RECV_ZC_MAX];
+#endif /* LWIP_SOCKET_RECV_ZC */
 #if LWIP_NETCONN_FULLDUPLEX
   /* counter of how many threads are using a struct lwip_sock (not the 'int') */
   u8_t fd_used;
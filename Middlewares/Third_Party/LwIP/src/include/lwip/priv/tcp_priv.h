@@ -42,6 +42,7 @@
 #if LWIP_TCP /* don't build if not configured for use in lwipopts.h */
 
 #include "lwip/tcp.h"
+#include "lwip/tcp_cc.h"
 #include "lwip/mem.h"
 #include "lwip/pbuf.h"
 #include "lwip/ip.h"
@@ -85,6 +86,9 @@ err_t            tcp_rexmit_rto_prepare(struct tcp_pcb *pcb);
 void             tcp_rexmit_rto_commit(struct tcp_pcb *pcb);
 void             tcp_rexmit_rto  (struct tcp_pcb *pcb);
 void             tcp_rexmit_fast (struct tcp_pcb *pcb);
+#if LWIP_TCP_SACK_IN
+void             tcp_rexmit_sack (struct tcp_pcb *pcb);
+#endif /* LWIP_TCP_SACK_IN */
 u32_t            tcp_update_rcv_ann_wnd(struct tcp_pcb *pcb);
 err_t            tcp_process_refused_data(struct tcp_pcb *pcb);
 
@@ -116,6 +120,16 @@ err_t            tcp_process_refused_data(struct tcp_pcb *pcb);
 #endif
 #define TCP_SEQ_BETWEEN(a,b,c) (TCP_SEQ_GEQ(a,b) && TCP_SEQ_LEQ(a,c))
 
+/** Initial CWND calculation as defined RFC 2581 */
+#define LWIP_TCP_CALC_INITIAL_CWND(mss) ((tcpwnd_size_t)LWIP_MIN((4U * (mss)), LWIP_MAX((2U * (mss)), 4380U)))
+
+/** The congestion control algorithm of a pcb */
+#if LWIP_TCP_CC
+#define TCP_CC_OPS(pcb) ((pcb)->cc)
+#else /* LWIP_TCP_CC */
+#define TCP_CC_OPS(pcb) (&tcp_cc_newreno)
+#endif /* LWIP_TCP_CC */
+
 #ifndef TCP_TMR_INTERVAL
 #define TCP_TMR_INTERVAL       250  /* The TCP timer interval in milliseconds. */
 #endif /* TCP_TMR_INTERVAL */
@@ -270,14 +284,29 @@ struct tcp_seg {
                                                checksummed into 'chksum' */
 #define TF_SEG_OPTS_WND_SCALE   (u8_t)0x08U /* Include WND SCALE option (only used in SYN segments) */
 #define TF_SEG_OPTS_SACK_PERM   (u8_t)0x10U /* Include SACK Permitted option (only used in SYN segments) */
+#if LWIP_TCP_SACK_IN
+#define TF_SEG_SACKED           (u8_t)0x20U /* Covered by a SACK block from the remote host */
+#define TF_SEG_LOST             (u8_t)0x40U /* Marked lost, to be retransmitted */
+#define TF_SEG_REXMIT           (u8_t)0x80U /* Has been retransmitted */
+  u32_t xmit_time;         /* sys_now() when last (re)transmitted */
+#endif /* LWIP_TCP_SACK_IN */
   struct tcp_hdr *tcphdr;  /* the TCP header */
 };
 
+#if TCP_WRITE_ZEROCOPY
+/* A custom pbuf referencing one slice of the data passed to tcp_write_zc() */
+struct tcp_zc_pbuf {
+  struct pbuf_custom pc;
+  struct tcp_zc_write *zc;
+};
+#endif /* TCP_WRITE_ZEROCOPY */
+
 #define LWIP_TCP_OPT_EOL        0
 #define LWIP_TCP_OPT_NOP        1
 #define LWIP_TCP_OPT_MSS        2
 #define LWIP_TCP_OPT_WS         3
 #define LWIP_TCP_OPT_SACK_PERM  4
+#define LWIP_TCP_OPT_SACK       5
 #define LWIP_TCP_OPT_TS         8
 
 #define LWIP_TCP_OPT_LEN_MSS    4
@@ -294,7 +323,7 @@ struct tcp_seg {
 #define LWIP_TCP_OPT_LEN_WS_OUT 0
 #endif
 
-#if LWIP_TCP_SACK_OUT
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
 #define LWIP_TCP_OPT_LEN_SACK_PERM     2
 #define LWIP_TCP_OPT_LEN_SACK_PERM_OUT 4 /* aligned for output (includes NOP padding) */
 #else
@@ -349,6 +378,22 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
    3) All PCBs in the tcp_listen_pcbs list is in LISTEN state.
    4) All PCBs in the tcp_tw_pcbs list is in TIME-WAIT state.
 */
+#if TCP_PCB_HASH
+/* Keep the demultiplexing hash tables in sync with the PCB lists */
+void tcp_pcb_hash_reg(struct tcp_pcb **pcbs, struct tcp_pcb *pcb);
+void tcp_pcb_hash_rmv(struct tcp_pcb **pcbs, struct tcp_pcb *pcb);
+struct tcp_pcb *tcp_pcb_hash_lookup(u16_t local_port, u16_t remote_port,
+                                    const ip_addr_t *local_ip, const ip_addr_t *remote_ip,
+                                    struct netif *inp);
+struct tcp_pcb_listen *tcp_listen_pcb_hash_lookup(u16_t local_port, const ip_addr_t *local_ip,
+                                                  struct netif *inp);
+#define TCP_HASH_REG(pcbs, npcb) tcp_pcb_hash_reg(pcbs, npcb)
+#define TCP_HASH_RMV(pcbs, npcb) tcp_pcb_hash_rmv(pcbs, npcb)
+#else /* TCP_PCB_HASH */
+#define TCP_HASH_REG(pcbs, npcb)
+#define TCP_HASH_RMV(pcbs, npcb)
+#endif /* TCP_PCB_HASH */
+
 /* Define two macros, TCP_REG and TCP_RMV that registers a TCP PCB
    with a PCB list or removes a PCB from a list, respectively. */
 #ifndef TCP_DEBUG_PCB_LISTS
@@ -367,6 +412,7 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
                             (npcb)->next = *(pcbs); \
                             LWIP_ASSERT("TCP_REG: npcb->next != npcb", (npcb)->next != (npcb)); \
                             *(pcbs) = (npcb); \
+                            TCP_HASH_REG(pcbs, npcb); \
                             LWIP_ASSERT("TCP_REG: tcp_pcbs sane", tcp_pcbs_sane()); \
               tcp_timer_needed(); \
                             } while(0)
@@ -383,6 +429,7 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
                                } \
                             } \
                             (npcb)->next = NULL; \
+                            TCP_HASH_RMV(pcbs, npcb); \
                             LWIP_ASSERT("TCP_RMV: tcp_pcbs sane", tcp_pcbs_sane()); \
                             LWIP_DEBUGF(TCP_DEBUG, ("TCP_RMV: removed %p from %p\n", (void *)(npcb), (void *)(*(pcbs)))); \
                             } while(0)
@@ -393,6 +440,7 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
   do {                                             \
     (npcb)->next = *pcbs;                          \
     *(pcbs) = (npcb);                              \
+    TCP_HASH_REG(pcbs, npcb);                      \
     tcp_timer_needed();                            \
   } while (0)
 
@@ -413,6 +461,7 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
       }                                            \
     }                                              \
     (npcb)->next = NULL;                           \
+    TCP_HASH_RMV(pcbs, npcb);                      \
   } while(0)
 
 #endif /* LWIP_DEBUG */
@@ -472,6 +521,12 @@ u32_t tcp_next_iss(struct tcp_pcb *pcb);
 
 err_t tcp_keepalive(struct tcp_pcb *pcb);
 err_t tcp_split_unsent_seg(struct tcp_pcb *pcb, u16_t split);
+#if TCP_TSO
+err_t tcp_trim_unacked_seg(struct tcp_pcb *pcb, struct tcp_seg *useg, u16_t trim);
+#endif /* TCP_TSO */
+#if LWIP_TCP_SACK_IN && TCP_TSO
+err_t tcp_split_unacked_seg(struct tcp_pcb *pcb, struct tcp_seg *useg, u16_t split);
+#endif /* LWIP_TCP_SACK_IN && TCP_TSO */
 err_t tcp_zero_window_probe(struct tcp_pcb *pcb);
 void  tcp_trigger_input_pcb_close(void);
 
@@ -508,6 +563,9 @@ void tcp_netif_ip_addr_changed(const ip_addr_t* old_addr, const ip_addr_t* new_a
 
 #if TCP_QUEUE_OOSEQ
 void tcp_free_ooseq(struct tcp_pcb *pcb);
+#if TCP_OOSEQ_RANGES
+void tcp_free_ooseq_tail(struct tcp_pcb *pcb);
+#endif /* TCP_OOSEQ_RANGES */
 #endif
 
 #if LWIP_TCP_PCB_NUM_EXT_ARGS
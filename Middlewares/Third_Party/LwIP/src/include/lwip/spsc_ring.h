@@ -0,0 +1,82 @@
+/**
+ * @file
+ * Lock-free single-producer/single-consumer descriptor rings
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#ifndef LWIP_HDR_SPSC_RING_H
+#define LWIP_HDR_SPSC_RING_H
+
+#include "lwip/opt.h"
+
+#if LWIP_SPSC_RING /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/arch.h"
+#include "lwip/err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** A ring of pointers (e.g. pbufs) passed from one producer to one consumer.
+ * Each index is written by one side only, so neither side needs a lock.
+ * The indices run freely and are masked on access.
+ */
+struct spsc_ring {
+  /** storage for the entries, provided by the user */
+  void **slots;
+  /** number of slots - 1 (the size is a power of two) */
+  u32_t mask;
+  /** next slot to fill, only written by the producer */
+  volatile u32_t head;
+  /** next slot to drain, only written by the consumer */
+  volatile u32_t tail;
+  /** nonzero while the consumer has been notified and not finished draining */
+  volatile u32_t doorbell;
+};
+
+err_t spsc_ring_init(struct spsc_ring *ring, void **slots, u32_t size);
+u32_t spsc_ring_count(const struct spsc_ring *ring);
+u32_t spsc_ring_put_batch(struct spsc_ring *ring, void *const *items, u32_t n);
+u32_t spsc_ring_get_batch(struct spsc_ring *ring, void **items, u32_t n);
+err_t spsc_ring_put(struct spsc_ring *ring, void *item);
+void *spsc_ring_get(struct spsc_ring *ring);
+int   spsc_ring_doorbell(struct spsc_ring *ring);
+int   spsc_ring_consumer_done(struct spsc_ring *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_SPSC_RING */
+
+#endif /* LWIP_HDR_SPSC_RING_H */
@@ -94,6 +94,17 @@ struct stats_igmp {
   STAT_COUNTER tx_report;        /* Sent reports. */
 };
 
+/** IPv4 reassembly stats */
+struct stats_ip_reass {
+  STAT_COUNTER completed;        /* Reassembled datagrams. */
+  STAT_COUNTER timeout;          /* Datagrams dropped because they timed out. */
+  STAT_COUNTER evicted;          /* Datagrams dropped to make room for others. */
+  STAT_COUNTER overlap;          /* Fragments overlapping data already received. */
+  STAT_COUNTER quota;            /* Fragments dropped by the per-source limit. */
+  u32_t latency_max;             /* Longest time from first fragment to completion (ms). */
+  u32_t latency_total;           /* Sum of those times (ms), divide by completed. */
+};
+
 /** Memory stats */
 struct stats_mem {
 #if defined(LWIP_DEBUG) || LWIP_STATS_DISPLAY
@@ -242,6 +253,10 @@ struct stats_ {
   /** Fragmentation */
   struct stats_proto ip_frag;
 #endif
+#if IPREASS_STATS
+  /** IPv4 reassembly */
+  struct stats_ip_reass ip_reass;
+#endif
 #if IP_STATS
   /** IP */
   struct stats_proto ip;
@@ -369,6 +384,14 @@ void stats_init(void);
 #define IPFRAG_STATS_DISPLAY()
 #endif
 
+#if IPREASS_STATS
+#define IPREASS_STATS_INC(x) STATS_INC(x)
+#define IPREASS_STATS_DISPLAY() stats_display_ip_reass(&lwip_stats.ip_reass)
+#else
+#define IPREASS_STATS_INC(x)
+#define IPREASS_STATS_DISPLAY()
+#endif
+
 #if ETHARP_STATS
 #define ETHARP_STATS_INC(x) STATS_INC(x)
 #define ETHARP_STATS_DISPLAY() stats_display_proto(&lwip_stats.etharp, "ETHARP")
@@ -472,6 +495,7 @@ void stats_init(void);
 void stats_display(void);
 void stats_display_proto(struct stats_proto *proto, const char *name);
 void stats_display_igmp(struct stats_igmp *igmp, const char *name);
+void stats_display_ip_reass(struct stats_ip_reass *reass);
 void stats_display_mem(struct stats_mem *mem, const char *name);
 void stats_display_memp(struct stats_mem *mem, int index);
 void stats_display_sys(struct stats_sys *sys);
@@ -479,6 +503,7 @@ void stats_display_sys(struct stats_sys *sys);
 #define stats_display()
 #define stats_display_proto(proto, name)
 #define stats_display_igmp(igmp, name)
+#define stats_display_ip_reass(reass)
 #define stats_display_mem(mem, name)
 #define stats_display_memp(mem, index)
 #define stats_display_sys(sys)
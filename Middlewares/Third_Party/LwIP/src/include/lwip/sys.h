@@ -552,6 +552,29 @@ void sys_arch_unprotect(sys_prot_t pval);
                               } while(0)
 #endif /* SYS_ARCH_LOCKED */
 
+#if !defined SYS_ARCH_CAS_U32 && defined __GNUC__
+/**
+ * @ingroup sys_prot
+ * SYS_ARCH_CAS_U32
+ * Atomically replace the u32_t at "ptr" by "newval" if it still equals
+ * "oldval". Evaluates to nonzero if the value was replaced. Required by
+ * MEMP_LOCKFREE; ports not compiled with GCC-compatible builtins have to
+ * provide it in sys_arch.h.
+ */
+#define SYS_ARCH_CAS_U32(ptr, oldval, newval) __sync_bool_compare_and_swap((ptr), (oldval), (newval))
+#endif /* !SYS_ARCH_CAS_U32 && __GNUC__ */
+
+#if !defined SYS_ARCH_MEMORY_BARRIER && defined __GNUC__
+/**
+ * @ingroup sys_prot
+ * SYS_ARCH_MEMORY_BARRIER
+ * Full memory barrier (compiler and CPU). Required by LWIP_SPSC_RING; ports
+ * not compiled with GCC-compatible builtins have to provide it in
+ * sys_arch.h.
+ */
+#define SYS_ARCH_MEMORY_BARRIER() __sync_synchronize()
+#endif /* !SYS_ARCH_MEMORY_BARRIER && __GNUC__ */
+
 
 #ifdef __cplusplus
 }
@@ -153,8 +153,8 @@ typedef err_t (*tcp_connected_fn)(void *arg, struct tcp_pcb *tpcb, err_t err);
                                   } \
                                 } while(0)
 
-#if LWIP_TCP_SACK_OUT
-/** SACK ranges to include in ACK packets.
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
+/** SACK ranges to include in ACK packets or received from the remote host.
  * SACK entry is invalid if left==right. */
 struct tcp_sack_range {
   /** Left edge of the SACK: the first acknowledged sequence number. */
@@ -162,7 +162,43 @@ struct tcp_sack_range {
   /** Right edge of the SACK: the last acknowledged sequence number +1 (so first NOT acknowledged). */
   u32_t right;
 };
-#endif /* LWIP_TCP_SACK_OUT */
+#endif /* LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN */
+
+#if TCP_WRITE_ZEROCOPY
+struct tcp_zc_write;
+
+/** Function prototype for zero-copy write completion callbacks. Called once
+ * the stack does not reference any of the data passed to tcp_write_zc()
+ * anymore: normally after all of it has been ACKed, or earlier if the
+ * connection was aborted or closed with data still queued.
+ * This is called from the context that frees the last reference (usually
+ * the tcpip thread while processing an ACK), so it must not call back into
+ * the pcb.
+ *
+ * @param zc The write handle passed to tcp_write_zc()
+ * @param arg The done_arg stored in the handle
+ */
+typedef void (*tcp_zc_done_fn)(struct tcp_zc_write *zc, void *arg);
+
+/** One chunk of application data for tcp_write_zc() */
+struct tcp_zc_iovec {
+  /** start of the data, must stay valid and unchanged until completion */
+  const void *base;
+  /** length of the data in bytes */
+  u16_t len;
+};
+
+/** Application-owned handle tracking the data of one tcp_write_zc() call.
+ * It must stay valid until done_fn has been called. */
+struct tcp_zc_write {
+  /** called when the stack has released all data of this write */
+  tcp_zc_done_fn done_fn;
+  /** argument passed to done_fn */
+  void *done_arg;
+  /** (private) number of pbufs still referencing the data */
+  u16_t refcnt;
+};
+#endif /* TCP_WRITE_ZEROCOPY */
 
 /** Function prototype for deallocation of arguments. Called *just before* the
  * pcb is freed, so don't expect to be able to do anything with this pcb!
@@ -203,6 +239,19 @@ struct tcp_pcb_ext_args {
 #define TCP_PCB_EXTARGS
 #endif
 
+#if TCP_PCB_HASH
+/* Chains pcbs sharing a bucket of the demultiplexing hash tables */
+#define TCP_PCB_HASH_NEXT(type) type *hash_next;
+#else
+#define TCP_PCB_HASH_NEXT(type)
+#endif
+
+#if LWIP_TCP_CC
+struct tcp_cc_ops;
+/** size of the per-pcb state of congestion control algorithms */
+#define TCP_CC_PRIV_WORDS 8
+#endif /* LWIP_TCP_CC */
+
 typedef u16_t tcpflags_t;
 #define TCP_ALLFLAGS 0xffffU
 
@@ -211,6 +260,7 @@ typedef u16_t tcpflags_t;
  */
 #define TCP_PCB_COMMON(type) \
   type *next; /* for the linked list */ \
+  TCP_PCB_HASH_NEXT(type) \
   void *callback_arg; \
   TCP_PCB_EXTARGS \
   enum tcp_state state; /* TCP state */ \
@@ -267,7 +317,7 @@ struct tcp_pcb {
 #define TF_TIMESTAMP   0x0400U   /* Timestamp option enabled */
 #endif
 #define TF_RTO         0x0800U /* RTO timer has fired, in-flight data moved to unsent and being retransmitted */
-#if LWIP_TCP_SACK_OUT
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
 #define TF_SACK        0x1000U /* Selective ACKs enabled */
 #endif
 
@@ -311,10 +361,31 @@ struct tcp_pcb {
   /* congestion avoidance/control variables */
   tcpwnd_size_t cwnd;
   tcpwnd_size_t ssthresh;
+#if LWIP_TCP_CC
+  /* congestion control algorithm and its per-connection state */
+  const struct tcp_cc_ops *cc;
+  u32_t cc_priv[TCP_CC_PRIV_WORDS];
+#endif /* LWIP_TCP_CC */
 
   /* first byte following last rto byte */
   u32_t rto_end;
 
+#if LWIP_TCP_SACK_IN
+  /* SACK loss recovery and RACK loss detection (times in ms, see sys_now()) */
+  u32_t sack_recover;  /* snd_nxt when SACK loss recovery was entered */
+  u32_t rack_xmit_ts;  /* send time of the most recently sent segment that was (s)acked */
+  u32_t rack_end_seq;  /* end of that segment */
+  u32_t rack_rtt;      /* RTT measured on that segment */
+  u32_t rack_min_rtt;  /* minimum RTT measured */
+  u32_t rack_fack;     /* highest (s)acked sequence number */
+  u32_t rack_tmr;      /* reordering timer deadline */
+  u8_t rack_flags;
+#define TCP_RACK_VALID    0x01U /* rack_* describe a delivered segment */
+#define TCP_RACK_REORDER  0x02U /* reordering has been observed */
+#define TCP_RACK_TMR      0x04U /* reordering timer is running */
+#define TCP_SACK_RECOVERY 0x08U /* TF_INFR was set by SACK loss detection */
+#endif /* LWIP_TCP_SACK_IN */
+
   /* sender variables */
   u32_t snd_nxt;   /* next new seqno to be sent */
   u32_t snd_wl1, snd_wl2; /* Sequence and acknowledgement numbers of last
@@ -339,6 +410,11 @@ struct tcp_pcb {
   struct tcp_seg *unacked;  /* Sent but unacknowledged segments. */
 #if TCP_QUEUE_OOSEQ
   struct tcp_seg *ooseq;    /* Received out of sequence segments. */
+#if TCP_OOSEQ_RANGES
+  /* ooseq segments sorted by seqno (binary search index) */
+  struct tcp_seg *ooseq_idx[TCP_OOSEQ_RANGES];
+  u8_t ooseq_num;
+#endif /* TCP_OOSEQ_RANGES */
 #endif /* TCP_QUEUE_OOSEQ */
 
   struct pbuf *refused_data; /* Data previously received but not yet taken by upper layer */
@@ -472,6 +548,11 @@ err_t            tcp_shutdown(struct tcp_pcb *pcb, int shut_rx, int shut_tx);
 
 err_t            tcp_write   (struct tcp_pcb *pcb, const void *dataptr, u16_t len,
                               u8_t apiflags);
+#if TCP_WRITE_ZEROCOPY
+err_t            tcp_write_zc(struct tcp_pcb *pcb, struct tcp_zc_write *zc,
+                              const struct tcp_zc_iovec *iov, u16_t iovcnt,
+                              u8_t apiflags);
+#endif /* TCP_WRITE_ZEROCOPY */
 
 void             tcp_setprio (struct tcp_pcb *pcb, u8_t prio);
 
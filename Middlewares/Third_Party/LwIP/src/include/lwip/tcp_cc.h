@@ -0,0 +1,98 @@
+/**
+ * @file
+ * TCP congestion control algorithms
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#ifndef LWIP_HDR_TCP_CC_H
+#define LWIP_HDR_TCP_CC_H
+
+#include "lwip/opt.h"
+
+#if LWIP_TCP /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/tcp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Loss events passed to tcp_cc_ops.loss */
+#define TCP_CC_LOSS_FAST    0 /* three duplicate ACKs: fast retransmit */
+#define TCP_CC_LOSS_RTO     1 /* retransmission timeout */
+
+/**
+ * A congestion control algorithm. All callbacks are mandatory and are called
+ * from the tcpip thread; cwnd and ssthresh are in bytes.
+ * Per-connection state can be kept in pcb->cc_priv (see tcp_cc_priv()).
+ */
+struct tcp_cc_ops {
+  /** name of the algorithm */
+  const char *name;
+  /** the connection has been established (or the algorithm attached to an
+   * established one): reset the private state and set the initial cwnd */
+  void (*init)(struct tcp_pcb *pcb);
+  /** 'acked' bytes of new data have been acknowledged (not in fast recovery) */
+  void (*cong_avoid)(struct tcp_pcb *pcb, tcpwnd_size_t acked);
+  /** loss detected (TCP_CC_LOSS_*): set ssthresh and cwnd. After
+   * TCP_CC_LOSS_FAST, cwnd is inflated by one mss for every further
+   * duplicate ACK until recovered() is called */
+  void (*loss)(struct tcp_pcb *pcb, u8_t event);
+  /** fast recovery has ended with an ACK for new data */
+  void (*recovered)(struct tcp_pcb *pcb);
+};
+
+extern const struct tcp_cc_ops tcp_cc_newreno;
+
+#if LWIP_TCP_CC
+extern const struct tcp_cc_ops tcp_cc_cubic;
+extern const struct tcp_cc_ops tcp_cc_bbrlite;
+
+/** Access the private state of the congestion control algorithm of a pcb,
+ * 'type' must not be bigger than TCP_CC_PRIV_WORDS u32_t */
+#define tcp_cc_priv(pcb, type) ((type *)(void *)(pcb)->cc_priv)
+
+void tcp_set_cc(struct tcp_pcb *pcb, const struct tcp_cc_ops *cc);
+
+#if LWIP_TESTMODE
+u32_t tcp_cubic_delta(u32_t t, u16_t mss);
+u32_t tcp_cubic_k(u32_t diff, u16_t mss);
+#endif /* LWIP_TESTMODE */
+#endif /* LWIP_TCP_CC */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_TCP */
+
+#endif /* LWIP_HDR_TCP_CC_H */
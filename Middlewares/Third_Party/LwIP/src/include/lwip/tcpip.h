@@ -44,6 +44,9 @@
 #include "lwip/err.h"
 #include "lwip/timeouts.h"
 #include "lwip/netif.h"
+#if LWIP_SPSC_RING
+#include "lwip/spsc_ring.h"
+#endif /* LWIP_SPSC_RING */
 
 #ifdef __cplusplus
 extern "C" {
@@ -78,6 +81,25 @@ void   tcpip_init(tcpip_init_done_fn tcpip_init_done, void *arg);
 
 err_t  tcpip_inpkt(struct pbuf *p, struct netif *inp, netif_input_fn input_fn);
 err_t  tcpip_input(struct pbuf *p, struct netif *inp);
+err_t  tcpip_inpkt_batch(struct pbuf *p, struct netif *inp, netif_input_fn input_fn);
+err_t  tcpip_input_batch(struct pbuf *p, struct netif *inp);
+
+#if LWIP_SPSC_RING
+/** A ring of received packets that a driver fills and tcpip_thread drains */
+struct tcpip_rxring {
+  /** the packets, filled by the driver with spsc_ring_put[_batch]() */
+  struct spsc_ring ring;
+  struct netif *inp;
+  netif_input_fn input_fn;
+  /** preallocated message used to notify tcpip_thread */
+  struct tcpip_callback_msg *msg;
+};
+
+err_t  tcpip_rxring_init(struct tcpip_rxring *rxr, void **slots, u32_t size,
+                         struct netif *inp, netif_input_fn input_fn);
+void   tcpip_rxring_free(struct tcpip_rxring *rxr);
+err_t  tcpip_rxring_doorbell(struct tcpip_rxring *rxr);
+#endif /* LWIP_SPSC_RING */
 
 err_t  tcpip_try_callback(tcpip_callback_fn function, void *ctx);
 err_t  tcpip_callback(tcpip_callback_fn function, void *ctx);
@@ -102,6 +124,7 @@ err_t  tcpip_untimeout(sys_timeout_handler h, void *arg);
 
 #ifdef TCPIP_THREAD_TEST
 int tcpip_thread_poll_one(void);
+int tcpip_thread_poll_batch(void);
 #endif
 
 #ifdef __cplusplus
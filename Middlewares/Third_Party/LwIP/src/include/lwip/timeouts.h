@@ -92,6 +92,12 @@ typedef void (* sys_timeout_handler)(void *arg);
 
 struct sys_timeo {
   struct sys_timeo *next;
+#if LWIP_TIMERS_WHEEL
+  struct sys_timeo *prev;
+  /* wheel slot this timeout is linked into */
+  u8_t level;
+  u8_t slot;
+#endif /* LWIP_TIMERS_WHEEL */
   u32_t time;
   sys_timeout_handler h;
   void *arg;
@@ -100,6 +106,25 @@ struct sys_timeo {
 #endif /* LWIP_DEBUG_TIMERNAMES */
 };
 
+#if LWIP_TIMERS_WHEEL
+/** log2 of the number of slots per wheel level */
+#define SYS_TIMEO_WHEEL_BITS   6
+#define SYS_TIMEO_WHEEL_SLOTS  (1U << SYS_TIMEO_WHEEL_BITS)
+/** Number of wheel levels: 5 levels of 64 slots cover LWIP_UINT32_MAX/4 msecs */
+#define SYS_TIMEO_WHEEL_LEVELS 5
+
+/** Hierarchical timing wheel: slot i of level n holds the timeouts due in the
+ * i-th block of SYS_TIMEO_WHEEL_SLOTS^n msecs. Every slot is a circular list
+ * (head->prev is the tail) in insertion order. */
+struct sys_timeo_wheel {
+  /** timeouts due before this time have been processed */
+  u32_t time;
+  /** number of timeouts linked into each level */
+  u16_t count[SYS_TIMEO_WHEEL_LEVELS];
+  struct sys_timeo *slots[SYS_TIMEO_WHEEL_LEVELS][SYS_TIMEO_WHEEL_SLOTS];
+};
+#endif /* LWIP_TIMERS_WHEEL */
+
 void sys_timeouts_init(void);
 
 #if LWIP_DEBUG_TIMERNAMES
@@ -115,7 +140,11 @@ void sys_check_timeouts(void);
 u32_t sys_timeouts_sleeptime(void);
 
 #if LWIP_TESTMODE
+#if LWIP_TIMERS_WHEEL
+struct sys_timeo_wheel* sys_timeouts_get_wheel(void);
+#else /* LWIP_TIMERS_WHEEL */
 struct sys_timeo** sys_timeouts_get_next_timeout(void);
+#endif /* LWIP_TIMERS_WHEEL */
 void lwip_cyclic_timer(void *arg);
 #endif
 
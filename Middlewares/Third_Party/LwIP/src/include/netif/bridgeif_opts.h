@@ -68,6 +68,22 @@
 #define BRIDGEIF_MAX_PORTS                  7
 #endif
 
+/** BRIDGEIF_FDB_PORT_MAX_ENTRIES: maximum number of addresses the default
+ * FDB implementation (bridgeif_fdb.c) learns per port, so that one port cannot
+ * fill the FDB (e.g. with random source addresses). 0 means no limit.
+ */
+#ifndef BRIDGEIF_FDB_PORT_MAX_ENTRIES
+#define BRIDGEIF_FDB_PORT_MAX_ENTRIES       0
+#endif
+
+/** BRIDGEIF_FDB_PORT_LEARN_RATE: maximum number of new addresses the default
+ * FDB implementation (bridgeif_fdb.c) learns per port and second. Frames to
+ * addresses not learnt are flooded. 0 means no limit.
+ */
+#ifndef BRIDGEIF_FDB_PORT_LEARN_RATE
+#define BRIDGEIF_FDB_PORT_LEARN_RATE        0
+#endif
+
 /** BRIDGEIF_DEBUG: Enable generic debugging in bridgeif.c. */
 #ifndef BRIDGEIF_DEBUG
 #define BRIDGEIF_DEBUG                      LWIP_DBG_OFF
@@ -44,149 +44,246 @@
 #include "netif/bridgeif.h"
 #include "lwip/sys.h"
 #include "lwip/mem.h"
-#include "lwip/timeouts.h"
 #include <string.h>
 
-#define BRIDGEIF_AGE_TIMER_MS 1000
-
 #define BR_FDB_TIMEOUT_SEC  (60*5) /* 5 minutes FDB timeout */
 
+/** Entry index marking the end of a hash chain or free list */
+#define BR_FDB_NONE         0xFFFF
+
 typedef struct bridgeif_dfdb_entry_s {
+  /** MAC address as halfwords, compared without byte loops */
+  u16_t addr[3];
+  /** Next entry in hash chain or free list */
+  u16_t next;
   u8_t used;
   u8_t port;
+  /** sys_now() when the address was last seen */
   u32_t ts;
-  struct eth_addr addr;
 } bridgeif_dfdb_entry_t;
 
 typedef struct bridgeif_dfdb_s {
   u16_t max_fdb_entries;
+  /** Number of hash buckets - 1 (buckets are a power of 2) */
+  u16_t hash_mask;
+  /** First free entry */
+  u16_t free;
+  /** Next entry to check for expiry when no entry is free */
+  u16_t sweep;
+#if BRIDGEIF_FDB_PORT_MAX_ENTRIES
+  /** Number of entries learned per port */
+  u16_t port_entries[BRIDGEIF_MAX_PORTS];
+#endif
+#if BRIDGEIF_FDB_PORT_LEARN_RATE
+  /** Second (of sys_now()) and number of addresses learned in it, per port */
+  u32_t port_learn_sec[BRIDGEIF_MAX_PORTS];
+  u16_t port_learned[BRIDGEIF_MAX_PORTS];
+#endif
+  /** First entry of each hash chain */
+  u16_t *hash;
   bridgeif_dfdb_entry_t *fdb;
 } bridgeif_dfdb_t;
 
+#define BR_FDB_EXPIRED(e, now)      ((u32_t)((now) - (e)->ts) >= (BR_FDB_TIMEOUT_SEC * 1000UL))
+#define BR_FDB_ADDR_MATCH(e, key)   ((((e)->addr[0] ^ (key)[0]) | ((e)->addr[1] ^ (key)[1]) | ((e)->addr[2] ^ (key)[2])) == 0)
+
+/** Copy an address into an aligned lookup key and return its hash bucket */
+static u16_t
+bridgeif_fdb_key(const bridgeif_dfdb_t *fdb, const struct eth_addr *addr, u16_t *key)
+{
+  u32_t h;
+  SMEMCPY(key, addr, sizeof(struct eth_addr));
+  /* The last bytes (NIC specific part) differ most, mix them into the top bits */
+  h = (((u32_t)key[1] << 16) | key[2]) ^ key[0];
+  h *= 0x9E3779B1UL;
+  return (u16_t)((h >> 16) & fdb->hash_mask);
+}
+
+/** Unchain an entry (following 'prev' in its hash chain) and put it on the free list */
+static void
+bridgeif_fdb_free_entry(bridgeif_dfdb_t *fdb, u16_t bucket, u16_t prev, u16_t idx)
+{
+  bridgeif_dfdb_entry_t *e = &fdb->fdb[idx];
+  if (prev == BR_FDB_NONE) {
+    fdb->hash[bucket] = e->next;
+  } else {
+    fdb->fdb[prev].next = e->next;
+  }
+#if BRIDGEIF_FDB_PORT_MAX_ENTRIES
+  fdb->port_entries[e->port]--;
+#endif
+  e->used = 0;
+  e->next = fdb->free;
+  fdb->free = idx;
+}
+
+/** Get a free entry, reclaiming an expired one if all are used */
+static u16_t
+bridgeif_fdb_alloc_entry(bridgeif_dfdb_t *fdb, u32_t now)
+{
+  u16_t i, idx;
+  if (fdb->free == BR_FDB_NONE) {
+    /* Expired entries are only removed when found in a hash chain, so look for
+       one, continuing where the last search stopped */
+    for (i = 0; i < fdb->max_fdb_entries; i++) {
+      bridgeif_dfdb_entry_t *e = &fdb->fdb[fdb->sweep];
+      idx = fdb->sweep;
+      if (++fdb->sweep == fdb->max_fdb_entries) {
+        fdb->sweep = 0;
+      }
+      if (e->used && BR_FDB_EXPIRED(e, now)) {
+        u16_t key[3];
+        u16_t bucket = bridgeif_fdb_key(fdb, (const struct eth_addr *)e->addr, key);
+        u16_t prev = BR_FDB_NONE, iter;
+        for (iter = fdb->hash[bucket]; iter != idx; iter = fdb->fdb[iter].next) {
+          prev = iter;
+        }
+        bridgeif_fdb_free_entry(fdb, bucket, prev, idx);
+        break;
+      }
+    }
+  }
+  idx = fdb->free;
+  if (idx != BR_FDB_NONE) {
+    fdb->free = fdb->fdb[idx].next;
+  }
+  return idx;
+}
+
+/** Check the learning limits of a port for a new address */
+static int
+bridgeif_fdb_may_learn(bridgeif_dfdb_t *fdb, u8_t port_idx, u32_t now)
+{
+  LWIP_UNUSED_ARG(fdb);
+  LWIP_UNUSED_ARG(port_idx);
+  LWIP_UNUSED_ARG(now);
+#if BRIDGEIF_FDB_PORT_MAX_ENTRIES
+  if (fdb->port_entries[port_idx] >= BRIDGEIF_FDB_PORT_MAX_ENTRIES) {
+    return 0;
+  }
+#endif
+#if BRIDGEIF_FDB_PORT_LEARN_RATE
+  if (fdb->port_learn_sec[port_idx] != now / 1000) {
+    fdb->port_learn_sec[port_idx] = now / 1000;
+    fdb->port_learned[port_idx] = 0;
+  }
+  if (fdb->port_learned[port_idx] >= BRIDGEIF_FDB_PORT_LEARN_RATE) {
+    return 0;
+  }
+#endif
+  return 1;
+}
+
 /**
  * @ingroup bridgeif_fdb
- * A real simple and slow implementation of an auto-learning forwarding database that
+ * A simple implementation of an auto-learning forwarding database that
  * remembers known src mac addresses to know which port to send frames destined for that
  * mac address.
- *
- * ATTENTION: This is meant as an example only, in real-world use, you should 
- * provide a better implementation :-)
+ * Addresses are hashed, entries expire BR_FDB_TIMEOUT_SEC after their address was last
+ * seen (checked when they are used, so no timer is needed) and learning new addresses
+ * may be limited per port (see BRIDGEIF_FDB_PORT_MAX_ENTRIES and BRIDGEIF_FDB_PORT_LEARN_RATE).
+ * Note that an entry not accessed for longer than the wrap-around time of sys_now()
+ * (~49 days) may appear valid again.
  */
 void
 bridgeif_fdb_update_src(void *fdb_ptr, struct eth_addr *src_addr, u8_t port_idx)
 {
-  int i;
+  u16_t key[3];
+  u16_t bucket, idx, prev, next;
+  u32_t now = sys_now();
   bridgeif_dfdb_t *fdb = (bridgeif_dfdb_t *)fdb_ptr;
   BRIDGEIF_DECL_PROTECT(lev);
+
+  LWIP_ASSERT("invalid port index", port_idx < BRIDGEIF_MAX_PORTS);
+  bucket = bridgeif_fdb_key(fdb, src_addr, key);
   BRIDGEIF_READ_PROTECT(lev);
-  for (i = 0; i < fdb->max_fdb_entries; i++) {
-    bridgeif_dfdb_entry_t *e = &fdb->fdb[i];
-    if (e->used && e->ts) {
-      if (!memcmp(&e->addr, src_addr, sizeof(struct eth_addr))) {
-        LWIP_DEBUGF(BRIDGEIF_FDB_DEBUG, ("br: update src %02x:%02x:%02x:%02x:%02x:%02x (from %d) @ idx %d\n",
-                                         src_addr->addr[0], src_addr->addr[1], src_addr->addr[2], src_addr->addr[3], src_addr->addr[4], src_addr->addr[5],
-                                         port_idx, i));
-        BRIDGEIF_WRITE_PROTECT(lev);
-        e->ts = BR_FDB_TIMEOUT_SEC;
-        e->port = port_idx;
-        BRIDGEIF_WRITE_UNPROTECT(lev);
-        BRIDGEIF_READ_UNPROTECT(lev);
-        return;
-      }
+  prev = BR_FDB_NONE;
+  for (idx = fdb->hash[bucket]; idx != BR_FDB_NONE; idx = next) {
+    bridgeif_dfdb_entry_t *e = &fdb->fdb[idx];
+    next = e->next;
+    if (BR_FDB_EXPIRED(e, now)) {
+      /* reclaim expired entries on the way */
+      BRIDGEIF_WRITE_PROTECT(lev);
+      bridgeif_fdb_free_entry(fdb, bucket, prev, idx);
+      BRIDGEIF_WRITE_UNPROTECT(lev);
+      continue;
     }
-  }
-  /* not found, allocate new entry from free */
-  for (i = 0; i < fdb->max_fdb_entries; i++) {
-    bridgeif_dfdb_entry_t *e = &fdb->fdb[i];
-    if (!e->used || !e->ts) {
+    if (BR_FDB_ADDR_MATCH(e, key)) {
+      LWIP_DEBUGF(BRIDGEIF_FDB_DEBUG, ("br: update src %02x:%02x:%02x:%02x:%02x:%02x (from %d) @ idx %d\n",
+                                       src_addr->addr[0], src_addr->addr[1], src_addr->addr[2], src_addr->addr[3], src_addr->addr[4], src_addr->addr[5],
+                                       port_idx, idx));
       BRIDGEIF_WRITE_PROTECT(lev);
-      /* check again when protected */
-      if (!e->used || !e->ts) {
-        LWIP_DEBUGF(BRIDGEIF_FDB_DEBUG, ("br: create src %02x:%02x:%02x:%02x:%02x:%02x (from %d) @ idx %d\n",
-                                         src_addr->addr[0], src_addr->addr[1], src_addr->addr[2], src_addr->addr[3], src_addr->addr[4], src_addr->addr[5],
-                                         port_idx, i));
-        memcpy(&e->addr, src_addr, sizeof(struct eth_addr));
-        e->ts = BR_FDB_TIMEOUT_SEC;
-        e->port = port_idx;
-        e->used = 1;
-        BRIDGEIF_WRITE_UNPROTECT(lev);
-        BRIDGEIF_READ_UNPROTECT(lev);
-        return;
-      }
+      e->ts = now;
+#if BRIDGEIF_FDB_PORT_MAX_ENTRIES
+      fdb->port_entries[e->port]--;
+      fdb->port_entries[port_idx]++;
+#endif
+      e->port = port_idx;
       BRIDGEIF_WRITE_UNPROTECT(lev);
+      BRIDGEIF_READ_UNPROTECT(lev);
+      return;
     }
+    prev = idx;
   }
+  /* not found, allocate new entry */
+  BRIDGEIF_WRITE_PROTECT(lev);
+  if (bridgeif_fdb_may_learn(fdb, port_idx, now)) {
+    idx = bridgeif_fdb_alloc_entry(fdb, now);
+    if (idx != BR_FDB_NONE) {
+      bridgeif_dfdb_entry_t *e = &fdb->fdb[idx];
+      LWIP_DEBUGF(BRIDGEIF_FDB_DEBUG, ("br: create src %02x:%02x:%02x:%02x:%02x:%02x (from %d) @ idx %d\n",
+                                       src_addr->addr[0], src_addr->addr[1], src_addr->addr[2], src_addr->addr[3], src_addr->addr[4], src_addr->addr[5],
+                                       port_idx, idx));
+      memcpy(e->addr, key, sizeof(e->addr));
+      e->ts = now;
+      e->port = port_idx;
+      e->used = 1;
+#if BRIDGEIF_FDB_PORT_MAX_ENTRIES
+      fdb->port_entries[port_idx]++;
+#endif
+#if BRIDGEIF_FDB_PORT_LEARN_RATE
+      fdb->port_learned[port_idx]++;
+#endif
+      e->next = fdb->hash[bucket];
+      fdb->hash[bucket] = idx;
+    }
+  }
+  BRIDGEIF_WRITE_UNPROTECT(lev);
   BRIDGEIF_READ_UNPROTECT(lev);
-  /* not found, no free entry -> flood */
+  /* not learnt (limited or no free entry) -> frames to src_addr are flooded */
 }
 
-/** 
+/**
  * @ingroup bridgeif_fdb
- * Walk our list of auto-learnt fdb entries and return a port to forward or BR_FLOOD if unknown 
+ * Look up a destination address in our auto-learnt fdb entries and return a port to
+ * forward or BR_FLOOD if unknown
  */
 bridgeif_portmask_t
 bridgeif_fdb_get_dst_ports(void *fdb_ptr, struct eth_addr *dst_addr)
 {
-  int i;
+  u16_t key[3];
+  u16_t idx;
+  u32_t now = sys_now();
   bridgeif_dfdb_t *fdb = (bridgeif_dfdb_t *)fdb_ptr;
   BRIDGEIF_DECL_PROTECT(lev);
+
+  idx = bridgeif_fdb_key(fdb, dst_addr, key);
   BRIDGEIF_READ_PROTECT(lev);
-  for (i = 0; i < fdb->max_fdb_entries; i++) {
-    bridgeif_dfdb_entry_t *e = &fdb->fdb[i];
-    if (e->used && e->ts) {
-      if (!memcmp(&e->addr, dst_addr, sizeof(struct eth_addr))) {
+  for (idx = fdb->hash[idx]; idx != BR_FDB_NONE; idx = fdb->fdb[idx].next) {
+    bridgeif_dfdb_entry_t *e = &fdb->fdb[idx];
+    if (BR_FDB_ADDR_MATCH(e, key)) {
+      if (!BR_FDB_EXPIRED(e, now)) {
         bridgeif_portmask_t ret = (bridgeif_portmask_t)(1 << e->port);
         BRIDGEIF_READ_UNPROTECT(lev);
         return ret;
       }
+      break;
     }
   }
   BRIDGEIF_READ_UNPROTECT(lev);
   return BR_FLOOD;
 }
 
-/**
- * @ingroup bridgeif_fdb
- * Aging implementation of our simple fdb
- */
-static void
-bridgeif_fdb_age_one_second(void *fdb_ptr)
-{
-  int i;
-  bridgeif_dfdb_t *fdb;
-  BRIDGEIF_DECL_PROTECT(lev);
-
-  fdb = (bridgeif_dfdb_t *)fdb_ptr;
-  BRIDGEIF_READ_PROTECT(lev);
-
-  for (i = 0; i < fdb->max_fdb_entries; i++) {
-    bridgeif_dfdb_entry_t *e = &fdb->fdb[i];
-    if (e->used && e->ts) {
-      BRIDGEIF_WRITE_PROTECT(lev);
-      /* check again when protected */
-      if (e->used && e->ts) {
-        if (--e->ts == 0) {
-          e->used = 0;
-        }
-      }
-      BRIDGEIF_WRITE_UNPROTECT(lev);
-    }
-  }
-  BRIDGEIF_READ_UNPROTECT(lev);
-}
-
-/** Timer callback for fdb aging, called once per second */
-static void
-bridgeif_age_tmr(void *arg)
-{
-  bridgeif_dfdb_t *fdb = (bridgeif_dfdb_t *)arg;
-
-  LWIP_ASSERT("invalid arg", arg != NULL);
-
-  bridgeif_fdb_age_one_second(fdb);
-  sys_timeout(BRIDGEIF_AGE_TIMER_MS, bridgeif_age_tmr, arg);
-}
-
 /**
  * @ingroup bridgeif_fdb
  * Init our simple fdb list
@@ -195,8 +292,17 @@ void *
 bridgeif_fdb_init(u16_t max_fdb_entries)
 {
   bridgeif_dfdb_t *fdb;
-  size_t alloc_len_sizet = sizeof(bridgeif_dfdb_t) + (max_fdb_entries * sizeof(bridgeif_dfdb_entry_t));
-  mem_size_t alloc_len = (mem_size_t)alloc_len_sizet;
+  u32_t num_buckets = 1;
+  size_t alloc_len_sizet;
+  mem_size_t alloc_len;
+  u32_t i;
+
+  LWIP_ASSERT("max_fdb_entries < BR_FDB_NONE", max_fdb_entries < BR_FDB_NONE);
+  while (num_buckets < max_fdb_entries) {
+    num_buckets <<= 1;
+  }
+  alloc_len_sizet = sizeof(bridgeif_dfdb_t) + (max_fdb_entries * sizeof(bridgeif_dfdb_entry_t)) + (num_buckets * sizeof(u16_t));
+  alloc_len = (mem_size_t)alloc_len_sizet;
   LWIP_ASSERT("alloc_len == alloc_len_sizet", alloc_len == alloc_len_sizet);
   LWIP_DEBUGF(BRIDGEIF_DEBUG, ("bridgeif_fdb_init: allocating %d bytes for private FDB data\n", (int)alloc_len));
   fdb = (bridgeif_dfdb_t *)mem_calloc(1, alloc_len);
@@ -204,9 +310,18 @@ bridgeif_fdb_init(u16_t max_fdb_entries)
     return NULL;
   }
   fdb->max_fdb_entries = max_fdb_entries;
+  fdb->hash_mask = (u16_t)(num_buckets - 1);
   fdb->fdb = (bridgeif_dfdb_entry_t *)(fdb + 1);
-
-  sys_timeout(BRIDGEIF_AGE_TIMER_MS, bridgeif_age_tmr, fdb);
+  fdb->hash = (u16_t *)(fdb->fdb + max_fdb_entries);
+  for (i = 0; i < num_buckets; i++) {
+    fdb->hash[i] = BR_FDB_NONE;
+  }
+  /* chain all entries to the free list */
+  fdb->free = BR_FDB_NONE;
+  for (i = max_fdb_entries; i > 0; i--) {
+    fdb->fdb[i - 1].next = fdb->free;
+    fdb->free = (u16_t)(i - 1);
+  }
 
   return fdb;
 }
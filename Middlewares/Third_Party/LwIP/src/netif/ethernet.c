@@ -47,6 +47,7 @@
 #include "lwip/stats.h"
 #include "lwip/etharp.h"
 #include "lwip/ip.h"
+#include "lwip/ip4_gro.h"
 #include "lwip/snmp.h"
 
 #include <string.h>
@@ -183,7 +184,11 @@ ethernet_input(struct pbuf *p, struct netif *netif)
         goto free_and_return;
       } else {
         /* pass to IP layer */
+#if IP_GRO
+        ip4_gro_input(p, netif);
+#else /* IP_GRO */
         ip4_input(p, netif);
+#endif /* IP_GRO */
       }
       break;
 
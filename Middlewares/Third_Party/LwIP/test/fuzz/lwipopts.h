@@ -51,6 +51,10 @@
 
 #define LWIP_ALTCP                      1
 
+/* Reassemble IPv4 fragments in a splay tree (trims overlapping fragments) */
+#define IP_REASS_TREE                   1
+#define IP_REASS_MAX_PBUFS_PER_SRC      (IP_REASS_MAX_PBUFS / 2)
+
 /* Turn off checksum verification of fuzzed data */
 #define CHECKSUM_CHECK_IP               0
 #define CHECKSUM_CHECK_UDP              0
@@ -12,6 +12,10 @@
  *   (configure your lwipopts.h settings high enough)
  * - test should also be able to run in a real target
  *
+ * - with LWIP_SOCKET_EPOLL, about half of the server connections are served
+ *   by a single thread using lwip_epoll_wait(); define TEST_MAX_CONNECTIONS
+ *   and MEMP_NUM_TCP_PCB high enough to run this with hundreds of sockets
+ *
  * TODO:
  * - full duplex
  * - add asserts about internal socket/netconn/pcb state?
@@ -69,7 +73,9 @@
 #define TEST_TIME_SECONDS     10
 #define TEST_TXRX_BUFSIZE     (TCP_MSS * 2)
 #define TEST_MAX_RXWAIT_MS    50
+#ifndef TEST_MAX_CONNECTIONS
 #define TEST_MAX_CONNECTIONS  50
+#endif
 
 #define TEST_SOCK_READABLE    0x01
 #define TEST_SOCK_WRITABLE    0x02
@@ -506,6 +512,102 @@ sockets_stresstest_conn_client(void *arg)
   LWIP_ASSERT("", sockets_stresstest_numthreads >= 0);
 }
 
+#if LWIP_SOCKET_EPOLL
+/** One server connection handled by the epoll server thread */
+struct sockets_stresstest_epoll_conn {
+  int s;
+  size_t rxoff;
+  char rxbuf[TEST_TXRX_BUFSIZE];
+};
+
+/** epoll instance shared by the listener (adding sockets) and the epoll server */
+static int sockets_stresstest_epfd = -1;
+/** number of connections registered with sockets_stresstest_epfd */
+static int sockets_stresstest_epoll_conns;
+/** set by the listener after it accepted all clients */
+static volatile int sockets_stresstest_epoll_accept_done;
+
+static void
+sockets_stresstest_epoll_close(struct sockets_stresstest_epoll_conn *conn)
+{
+  /* closing the socket removes it from the epoll instance */
+  int ret = lwip_close(conn->s);
+  LWIP_ASSERT("ret == 0", ret == 0);
+  mem_free(conn);
+  SYS_ARCH_DEC(sockets_stresstest_epoll_conns, 1);
+  LWIP_ASSERT("", sockets_stresstest_epoll_conns >= 0);
+}
+
+/* One thread serving all connections registered with the epoll instance
+   (instead of one thread per connection) */
+static void
+sockets_stresstest_epoll_server(void *arg)
+{
+  struct epoll_event events[TEST_MAX_CONNECTIONS];
+  char txbuf[TEST_TXRX_BUFSIZE];
+  int i, n, ret;
+
+  LWIP_UNUSED_ARG(arg);
+
+  while (!sockets_stresstest_epoll_accept_done || (sockets_stresstest_epoll_conns > 0)) {
+    n = lwip_epoll_wait(sockets_stresstest_epfd, events, TEST_MAX_CONNECTIONS, TEST_MAX_RXWAIT_MS);
+    LWIP_ASSERT("epoll_wait error", n >= 0);
+    for (i = 0; i < n; i++) {
+      struct sockets_stresstest_epoll_conn *conn = (struct sockets_stresstest_epoll_conn *)events[i].data.ptr;
+      int closed;
+      if (events[i].events & EPOLLERR) {
+        sockets_stresstest_epoll_close(conn);
+        continue;
+      }
+      /* read some */
+      LWIP_ASSERT("readable", events[i].events == EPOLLIN);
+      conn->rxoff = recv_and_check_data_return_offset(conn->s, conn->rxbuf, sizeof(conn->rxbuf), conn->rxoff, &closed, "eps");
+      if (closed) {
+        sockets_stresstest_epoll_close(conn);
+        continue;
+      }
+      if (LWIP_RAND() & 1) {
+        /* answer with some data */
+        size_t send_len = (LWIP_RAND() % (sizeof(txbuf) - 4)) + 4;
+        fill_test_data(txbuf, send_len);
+        LWIP_DEBUGF(TEST_SOCKETS_STRESS | LWIP_DBG_TRACE, ("eps %d tx %d\n", conn->s, (int)send_len));
+        ret = lwip_write(conn->s, txbuf, send_len);
+        if (ret == -1) {
+          /* TODO: for this to work, 'errno' has to support multithreading... */
+          int err = errno;
+          LWIP_ASSERT("unknown error", (err == ECONNRESET) || (err == ENOTCONN));
+          sockets_stresstest_epoll_close(conn);
+          continue;
+        }
+        LWIP_ASSERT("ret == send_len", ret == (int)send_len);
+      }
+    }
+  }
+
+  SYS_ARCH_DEC(sockets_stresstest_numthreads, 1);
+  LWIP_ASSERT("", sockets_stresstest_numthreads >= 0);
+}
+
+static void
+sockets_stresstest_epoll_add(int s)
+{
+  struct epoll_event ev;
+  int ret;
+  struct sockets_stresstest_epoll_conn *conn;
+
+  conn = (struct sockets_stresstest_epoll_conn *)mem_malloc(sizeof(struct sockets_stresstest_epoll_conn));
+  LWIP_ASSERT("OOM", conn != NULL);
+  conn->s = s;
+  conn->rxoff = 0;
+
+  SYS_ARCH_INC(sockets_stresstest_epoll_conns, 1);
+  ev.events = EPOLLIN;
+  ev.data.ptr = conn;
+  ret = lwip_epoll_ctl(sockets_stresstest_epfd, EPOLL_CTL_ADD, s, &ev);
+  LWIP_ASSERT("ret == 0", ret == 0);
+}
+#endif /* LWIP_SOCKET_EPOLL */
+
 static void
 sockets_stresstest_conn_server(void *arg)
 {
@@ -599,25 +701,45 @@ sockets_stresstest_listener(void *arg)
   ret = lwip_getsockname(slisten, (struct sockaddr *)&addr, &addr_len);
   LWIP_ASSERT("ret == 0", ret == 0);
 
+#if LWIP_SOCKET_EPOLL
+  /* about half of the connections are served by one epoll thread */
+  if (sockets_stresstest_epfd < 0) {
+    sockets_stresstest_epfd = lwip_epoll_create(1);
+    LWIP_ASSERT("epfd >= 0", sockets_stresstest_epfd >= 0);
+  }
+  sockets_stresstest_epoll_accept_done = 0;
+  {
+    sys_thread_t t;
+    SYS_ARCH_INC(sockets_stresstest_numthreads, 1);
+    t = sys_thread_new("sockets_stresstest_epoll_server", sockets_stresstest_epoll_server, NULL, 0, 0);
+    LWIP_ASSERT("thread != NULL", t != 0);
+  }
+#endif /* LWIP_SOCKET_EPOLL */
+
   num_clients = sockets_stresstest_start_clients(&addr);
 
   while (num_servers < num_clients) {
     struct sockaddr_storage aclient;
     socklen_t aclient_len = sizeof(aclient);
     int sclient = lwip_accept(slisten, (struct sockaddr *)&aclient, &aclient_len);
-#if 1
+    num_servers++;
+#if LWIP_SOCKET_EPOLL
+    if (LWIP_RAND() & 1) {
+      /* using the epoll server */
+      sockets_stresstest_epoll_add(sclient);
+    } else
+#endif /* LWIP_SOCKET_EPOLL */
     /* using server threads */
     {
       sys_thread_t t;
       SYS_ARCH_INC(sockets_stresstest_numthreads, 1);
-      num_servers++;
       t = sys_thread_new("sockets_stresstest_conn_server", sockets_stresstest_conn_server, (void*)sclient, 0, 0);
       LWIP_ASSERT("thread != NULL", t != 0);
     }
-#else
-    /* using server select */
-#endif
   }
+#if LWIP_SOCKET_EPOLL
+  sockets_stresstest_epoll_accept_done = 1;
+#endif /* LWIP_SOCKET_EPOLL */
   LWIP_DEBUGF(TEST_SOCKETS_STRESS | LWIP_DBG_STATE, ("sockets_stresstest_listener: all %d connections established\n", num_clients));
 
   /* accepted all clients */
@@ -685,6 +685,443 @@ START_TEST(test_sockets_select)
 }
 END_TEST
 
+#if LWIP_SOCKET_EPOLL && LWIP_IPV4
+static void
+test_sockets_epoll_sendto(int s, const struct sockaddr_in *to)
+{
+  const char txbuf[] = "ep";
+  ssize_t ret = lwip_sendto(s, txbuf, sizeof(txbuf), 0, (const struct sockaddr *)to, sizeof(*to));
+  fail_unless(ret == sizeof(txbuf));
+  while (tcpip_thread_poll_one());
+}
+
+static void
+test_sockets_epoll_recv(int s)
+{
+  char rxbuf[4];
+  ssize_t ret = lwip_recv(s, rxbuf, sizeof(rxbuf), 0);
+  fail_unless(ret == 3);
+}
+#endif /* LWIP_SOCKET_EPOLL && LWIP_IPV4 */
+
+#if LWIP_IPV4
+START_TEST(test_sockets_mmsg)
+{
+  int s, i, ret;
+  struct sockaddr_in addr, from[12];
+  socklen_t addr_len;
+  u8_t txbuf[12][12];
+  u8_t rxbuf[12][12];
+  struct iovec txiov[12], rxiov[12];
+  struct mmsghdr txmsg[12], rxmsg[12];
+  LWIP_UNUSED_ARG(_i);
+
+  s = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_DGRAM);
+  fail_unless(s >= 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = PP_HTONL(INADDR_LOOPBACK);
+  ret = lwip_bind(s, (struct sockaddr *)&addr, sizeof(addr));
+  fail_unless(ret == 0);
+  addr_len = sizeof(addr);
+  ret = lwip_getsockname(s, (struct sockaddr *)&addr, &addr_len);
+  fail_unless(ret == 0);
+
+  /* more datagrams than fit into one batch, each with its own length */
+  memset(txmsg, 0, sizeof(txmsg));
+  memset(rxmsg, 0, sizeof(rxmsg));
+  for (i = 0; i < 12; i++) {
+    memset(txbuf[i], i, sizeof(txbuf[i]));
+    txiov[i].iov_base = txbuf[i];
+    txiov[i].iov_len = (size_t)(i + 1);
+    txmsg[i].msg_hdr.msg_iov = &txiov[i];
+    txmsg[i].msg_hdr.msg_iovlen = 1;
+    txmsg[i].msg_hdr.msg_name = &addr;
+    txmsg[i].msg_hdr.msg_namelen = sizeof(addr);
+    rxiov[i].iov_base = rxbuf[i];
+    rxiov[i].iov_len = sizeof(rxbuf[i]);
+    rxmsg[i].msg_hdr.msg_iov = &rxiov[i];
+    rxmsg[i].msg_hdr.msg_iovlen = 1;
+    rxmsg[i].msg_hdr.msg_name = &from[i];
+    rxmsg[i].msg_hdr.msg_namelen = sizeof(from[i]);
+  }
+  ret = lwip_sendmmsg(s, txmsg, 10, 0);
+  fail_unless(ret == 10);
+  for (i = 0; i < 10; i++) {
+    fail_unless(txmsg[i].msg_len == (unsigned int)(i + 1));
+  }
+  while (tcpip_thread_poll_one());
+
+  /* receive them in two calls */
+  ret = lwip_recvmmsg(s, rxmsg, 4, MSG_WAITFORONE, NULL);
+  fail_unless(ret == 4);
+  ret = lwip_recvmmsg(s, &rxmsg[4], 8, MSG_WAITFORONE, NULL);
+  fail_unless(ret == 6);
+  for (i = 0; i < 10; i++) {
+    fail_unless(rxmsg[i].msg_len == (unsigned int)(i + 1));
+    fail_unless(rxmsg[i].msg_hdr.msg_flags == 0);
+    fail_unless(!memcmp(rxbuf[i], txbuf[i], (size_t)(i + 1)));
+    fail_unless(rxmsg[i].msg_hdr.msg_namelen == sizeof(struct sockaddr_in));
+    fail_unless(from[i].sin_port == addr.sin_port);
+  }
+  ret = lwip_recvmmsg(s, rxmsg, 4, MSG_WAITFORONE, NULL);
+  fail_unless(ret == -1);
+  fail_unless(errno == EWOULDBLOCK);
+
+  /* an invalid message stops sending, the ones before it are sent */
+  txmsg[2].msg_hdr.msg_iovlen = 0;
+  ret = lwip_sendmmsg(s, txmsg, 4, 0);
+  fail_unless(ret == 2);
+  ret = lwip_sendmmsg(s, &txmsg[2], 2, 0);
+  fail_unless(ret == -1);
+  fail_unless(errno == EMSGSIZE);
+  while (tcpip_thread_poll_one());
+
+  /* truncation is reported per message */
+  rxiov[0].iov_len = 1;
+  ret = lwip_recvmmsg(s, rxmsg, 4, MSG_WAITFORONE, NULL);
+  fail_unless(ret == 2);
+  fail_unless(rxmsg[0].msg_len == 1);
+  fail_unless(rxmsg[0].msg_hdr.msg_flags == 0);
+  fail_unless(rxmsg[1].msg_len == 2);
+  fail_unless(rxmsg[1].msg_hdr.msg_flags == 0);
+
+  txiov[0].iov_len = 8;
+  ret = lwip_sendmmsg(s, txmsg, 1, 0);
+  fail_unless(ret == 1);
+  while (tcpip_thread_poll_one());
+  ret = lwip_recvmmsg(s, rxmsg, 4, 0, NULL);
+  fail_unless(ret == 1);
+  fail_unless(rxmsg[0].msg_len == 8);
+  fail_unless(rxmsg[0].msg_hdr.msg_flags & MSG_TRUNC);
+
+  ret = lwip_close(s);
+  fail_unless(ret == 0);
+}
+END_TEST
+#endif /* LWIP_IPV4 */
+
+#if LWIP_SOCKET_RECV_ZC && LWIP_IPV4
+static int
+test_sockets_zc_check(struct pbuf *p, const u8_t *expected, u16_t len)
+{
+  u8_t rxbuf[3000];
+  return (p != NULL) && (p->tot_len == len) &&
+         (pbuf_copy_partial(p, rxbuf, len, 0) == len) && !memcmp(rxbuf, expected, len);
+}
+
+START_TEST(test_sockets_recv_zc)
+{
+  int sl, s1, s2, su, ret, i;
+  struct sockaddr_in addr;
+  socklen_t addr_len;
+  struct tcp_pcb *pcb;
+  struct pbuf *p1, *p2, *p3;
+  struct pbuf *held[LWIP_SOCKET_RECV_ZC_MAX];
+  u8_t txbuf[3000];
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < (int)sizeof(txbuf); i++) {
+    txbuf[i] = (u8_t)i;
+  }
+
+  /* connect two TCP sockets over loopback */
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = PP_HTONL(INADDR_LOOPBACK);
+  sl = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_STREAM);
+  fail_unless(sl >= 0);
+  ret = lwip_bind(sl, (struct sockaddr *)&addr, sizeof(addr));
+  fail_unless(ret == 0);
+  ret = lwip_listen(sl, 0);
+  fail_unless(ret == 0);
+  addr_len = sizeof(addr);
+  ret = lwip_getsockname(sl, (struct sockaddr *)&addr, &addr_len);
+  fail_unless(ret == 0);
+  s1 = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_STREAM);
+  fail_unless(s1 >= 0);
+  ret = lwip_connect(s1, (struct sockaddr *)&addr, sizeof(addr));
+  fail_unless(ret == -1);
+  fail_unless(errno == EINPROGRESS);
+  while (tcpip_thread_poll_one());
+  s2 = lwip_accept(sl, NULL, NULL);
+  fail_unless(s2 >= 0);
+  pcb = lwip_socket_dbg_get_socket(s2)->conn->pcb.tcp;
+
+  ret = lwip_write(s1, txbuf, sizeof(txbuf));
+  fail_unless(ret == (int)sizeof(txbuf));
+  while (tcpip_thread_poll_one());
+  fail_unless(pcb->rcv_wnd == TCP_WND - sizeof(txbuf));
+
+  /* the data is handed out without updating the window */
+  ret = lwip_recv_zc(s2, &p1, 1000, 0);
+  fail_unless(ret == 1000);
+  fail_unless(test_sockets_zc_check(p1, txbuf, 1000));
+  ret = lwip_recv_zc(s2, &p2, 10000, 0);
+  fail_unless(ret == 2000);
+  fail_unless(test_sockets_zc_check(p2, &txbuf[1000], 2000));
+  /* failed receives don't keep an entry of the limited chain list */
+  for (i = 0; i < LWIP_SOCKET_RECV_ZC_MAX; i++) {
+    ret = lwip_recv_zc(s2, &p3, 10000, MSG_DONTWAIT);
+    fail_unless(ret == -1);
+    fail_unless(errno == EWOULDBLOCK);
+    fail_unless(p3 == NULL);
+  }
+  ret = lwip_recv_zc(s2, &p3, 10000, MSG_PEEK);
+  fail_unless(ret == -1);
+  fail_unless(errno == EOPNOTSUPP);
+  while (tcpip_thread_poll_one());
+  fail_unless(pcb->rcv_wnd == TCP_WND - sizeof(txbuf));
+
+  /* releasing the chains opens the window again */
+  ret = lwip_recv_zc_release(s2, p1);
+  fail_unless(ret == 0);
+  fail_unless(pcb->rcv_wnd == TCP_WND - 2000);
+  ret = lwip_recv_zc_release(s2, p2);
+  fail_unless(ret == 0);
+  fail_unless(pcb->rcv_wnd == TCP_WND);
+  while (tcpip_thread_poll_one());
+
+  /* a chain held across close is still freed by its release */
+  ret = lwip_write(s1, txbuf, 100);
+  fail_unless(ret == 100);
+  while (tcpip_thread_poll_one());
+  ret = lwip_recv_zc(s2, &p1, 10000, 0);
+  fail_unless(ret == 100);
+  ret = lwip_close(s1);
+  fail_unless(ret == 0);
+  while (tcpip_thread_poll_one());
+  ret = lwip_recv_zc(s2, &p2, 10000, 0);
+  fail_unless(ret == 0);
+  fail_unless(p2 == NULL);
+  ret = lwip_close(s2);
+  fail_unless(ret == 0);
+  while (tcpip_thread_poll_one());
+
+  /* ... and does not open the window of a new socket reusing the fd */
+  s1 = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_STREAM);
+  fail_unless(s1 >= 0);
+  ret = lwip_connect(s1, (struct sockaddr *)&addr, sizeof(addr));
+  fail_unless(ret == -1);
+  fail_unless(errno == EINPROGRESS);
+  while (tcpip_thread_poll_one());
+  ret = lwip_accept(sl, NULL, NULL);
+  fail_unless(ret == s2);
+  pcb = lwip_socket_dbg_get_socket(s2)->conn->pcb.tcp;
+  ret = lwip_write(s1, txbuf, 300);
+  fail_unless(ret == 300);
+  while (tcpip_thread_poll_one());
+  ret = lwip_recv_zc(s2, &p2, 200, 0);
+  fail_unless(ret == 200);
+  fail_unless(pcb->rcv_wnd == TCP_WND - 300);
+  ret = lwip_recv_zc_release(s2, p1);
+  fail_unless(ret == 0);
+  fail_unless(pcb->rcv_wnd == TCP_WND - 300);
+  ret = lwip_recv_zc_release(s2, p2);
+  fail_unless(ret == 0);
+  fail_unless(pcb->rcv_wnd == TCP_WND - 100);
+
+  /* the number of chains held per socket is limited */
+  for (i = 0; i < LWIP_SOCKET_RECV_ZC_MAX; i++) {
+    ret = lwip_recv_zc(s2, &held[i], 1, 0);
+    fail_unless(ret == 1);
+  }
+  ret = lwip_recv_zc(s2, &p1, 1, 0);
+  fail_unless(ret == -1);
+  fail_unless(errno == ENOBUFS);
+  fail_unless(p1 == NULL);
+  ret = lwip_recv_zc_release(s2, held[0]);
+  fail_unless(ret == 0);
+  ret = lwip_recv_zc(s2, &p1, 10000, 0);
+  fail_unless(ret == 100 - LWIP_SOCKET_RECV_ZC_MAX);
+  ret = lwip_recv_zc_release(s2, p1);
+  fail_unless(ret == 0);
+  for (i = 1; i < LWIP_SOCKET_RECV_ZC_MAX - 1; i++) {
+    ret = lwip_recv_zc_release(s2, held[i]);
+    fail_unless(ret == 0);
+  }
+  fail_unless(pcb->rcv_wnd == TCP_WND - 1);
+
+  /* a chain released after its socket is gone is only freed */
+  ret = lwip_close(s1);
+  fail_unless(ret == 0);
+  while (tcpip_thread_poll_one());
+  ret = lwip_close(s2);
+  fail_unless(ret == 0);
+  ret = lwip_close(sl);
+  fail_unless(ret == 0);
+  while (tcpip_thread_poll_one());
+  ret = lwip_recv_zc_release(s2, held[LWIP_SOCKET_RECV_ZC_MAX - 1]);
+  fail_unless(ret == -1);
+
+  /* datagrams are handed out whole */
+  su = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_DGRAM);
+  fail_unless(su >= 0);
+  addr.sin_port = 0;
+  ret = lwip_bind(su, (struct sockaddr *)&addr, sizeof(addr));
+  fail_unless(ret == 0);
+  addr_len = sizeof(addr);
+  ret = lwip_getsockname(su, (struct sockaddr *)&addr, &addr_len);
+  fail_unless(ret == 0);
+  ret = lwip_sendto(su, txbuf, 200, 0, (struct sockaddr *)&addr, sizeof(addr));
+  fail_unless(ret == 200);
+  while (tcpip_thread_poll_one());
+  ret = lwip_recv_zc(su, &p1, 1, 0);
+  fail_unless(ret == 200);
+  fail_unless(test_sockets_zc_check(p1, txbuf, 200));
+  ret = lwip_recv_zc_release(su, p1);
+  fail_unless(ret == 0);
+  ret = lwip_close(su);
+  fail_unless(ret == 0);
+}
+END_TEST
+#endif /* LWIP_SOCKET_RECV_ZC && LWIP_IPV4 */
+
+START_TEST(test_sockets_epoll)
+{
+#if LWIP_SOCKET_EPOLL && LWIP_IPV4
+  int ep, i, ret;
+  int s[3];
+  struct sockaddr_in addr[3];
+  socklen_t addr_len;
+  struct epoll_event ev;
+  struct epoll_event events[4];
+
+  ep = lwip_epoll_create(1);
+  fail_unless(ep >= 0);
+
+  for (i = 0; i < 3; i++) {
+    s[i] = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_DGRAM);
+    fail_unless(s[i] >= 0);
+    memset(&addr[i], 0, sizeof(addr[i]));
+    addr[i].sin_family = AF_INET;
+    addr[i].sin_addr.s_addr = PP_HTONL(INADDR_LOOPBACK);
+    ret = lwip_bind(s[i], (struct sockaddr *)&addr[i], sizeof(addr[i]));
+    fail_unless(ret == 0);
+    addr_len = sizeof(addr[i]);
+    ret = lwip_getsockname(s[i], (struct sockaddr *)&addr[i], &addr_len);
+    fail_unless(ret == 0);
+
+    ev.events = EPOLLIN;
+    ev.data.fd = s[i];
+    ret = lwip_epoll_ctl(ep, EPOLL_CTL_ADD, s[i], &ev);
+    fail_unless(ret == 0);
+  }
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_ADD, s[0], &ev);
+  fail_unless(ret == -1);
+  fail_unless(errno == EEXIST);
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_ADD, ep, &ev);
+  fail_unless(ret == -1);
+  fail_unless(errno == EBADF);
+
+  /* nothing received yet */
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == 0);
+
+  /* level-triggered: reported in order of arrival until read */
+  test_sockets_epoll_sendto(s[0], &addr[2]);
+  test_sockets_epoll_sendto(s[0], &addr[1]);
+  for (i = 0; i < 2; i++) {
+    ret = lwip_epoll_wait(ep, events, 4, 0);
+    fail_unless(ret == 2);
+    fail_unless(events[0].events == EPOLLIN);
+    fail_unless(events[0].data.fd == s[2]);
+    fail_unless(events[1].events == EPOLLIN);
+    fail_unless(events[1].data.fd == s[1]);
+  }
+  /* with fewer slots than ready sockets, they are served in turn */
+  ret = lwip_epoll_wait(ep, events, 1, 0);
+  fail_unless(ret == 1);
+  fail_unless(events[0].data.fd == s[2]);
+  ret = lwip_epoll_wait(ep, events, 1, 0);
+  fail_unless(ret == 1);
+  fail_unless(events[0].data.fd == s[1]);
+  test_sockets_epoll_recv(s[2]);
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == 1);
+  fail_unless(events[0].data.fd == s[1]);
+  test_sockets_epoll_recv(s[1]);
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == 0);
+
+  /* edge-triggered: reported once per received datagram */
+  ev.events = EPOLLIN | EPOLLET;
+  ev.data.fd = s[1];
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_MOD, s[1], &ev);
+  fail_unless(ret == 0);
+  test_sockets_epoll_sendto(s[0], &addr[1]);
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == 1);
+  fail_unless(events[0].data.fd == s[1]);
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == 0);
+  test_sockets_epoll_sendto(s[0], &addr[1]);
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == 1);
+  fail_unless(events[0].data.fd == s[1]);
+  test_sockets_epoll_recv(s[1]);
+  test_sockets_epoll_recv(s[1]);
+
+  /* one-shot: disabled after the first report until rearmed */
+  ev.events = EPOLLIN | EPOLLONESHOT;
+  ev.data.fd = s[2];
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_MOD, s[2], &ev);
+  fail_unless(ret == 0);
+  test_sockets_epoll_sendto(s[0], &addr[2]);
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == 1);
+  fail_unless(events[0].data.fd == s[2]);
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == 0);
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_MOD, s[2], &ev);
+  fail_unless(ret == 0);
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == 1);
+  fail_unless(events[0].data.fd == s[2]);
+  test_sockets_epoll_recv(s[2]);
+
+  /* UDP sockets are writable right away */
+  ev.events = EPOLLOUT;
+  ev.data.u32 = 0x12345678;
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_MOD, s[0], &ev);
+  fail_unless(ret == 0);
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == 1);
+  fail_unless(events[0].events == EPOLLOUT);
+  fail_unless(events[0].data.u32 == 0x12345678);
+
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_DEL, s[0], NULL);
+  fail_unless(ret == 0);
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_DEL, s[0], NULL);
+  fail_unless(ret == -1);
+  fail_unless(errno == ENOENT);
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == 0);
+
+  /* closing a ready socket removes it from the epoll instance */
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_MOD, s[1], &ev);
+  fail_unless(ret == 0);
+  ret = lwip_close(s[1]);
+  fail_unless(ret == 0);
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == 0);
+
+  /* closing the epoll instance frees the remaining registration (s[2]) */
+  ret = lwip_close(ep);
+  fail_unless(ret == 0);
+  ret = lwip_epoll_wait(ep, events, 4, 0);
+  fail_unless(ret == -1);
+  fail_unless(errno == EBADF);
+
+  ret = lwip_close(s[0]);
+  fail_unless(ret == 0);
+  ret = lwip_close(s[2]);
+  fail_unless(ret == 0);
+#endif /* LWIP_SOCKET_EPOLL && LWIP_IPV4 */
+  LWIP_UNUSED_ARG(_i);
+}
+END_TEST
+
 START_TEST(test_sockets_recv_after_rst)
 {
   int sl, sact;
@@ -838,6 +1275,13 @@ sockets_suite(void)
     TESTFUNC(test_sockets_msgapis),
     TESTFUNC(test_sockets_select),
     TESTFUNC(test_sockets_recv_after_rst),
+    TESTFUNC(test_sockets_epoll),
+#if LWIP_IPV4
+    TESTFUNC(test_sockets_mmsg),
+#endif
+#if LWIP_SOCKET_RECV_ZC && LWIP_IPV4
+    TESTFUNC(test_sockets_recv_zc),
+#endif
   };
   return create_suite("SOCKETS", tests, sizeof(tests)/sizeof(testfunc), sockets_setup, sockets_teardown);
 }
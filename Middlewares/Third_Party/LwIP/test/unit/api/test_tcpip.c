@@ -0,0 +1,316 @@
+#include "test_tcpip.h"
+
+#include "lwip/tcpip.h"
+#include "lwip/pbuf.h"
+#include "lwip/netif.h"
+#include "lwip/stats.h"
+
+#define TEST_TCPIP_MAX_PACKETS 4
+
+static struct netif test_netif;
+static u16_t test_input_lens[TEST_TCPIP_MAX_PACKETS];
+static int test_input_calls;
+static int test_input_reject;
+
+/* Setups/teardown functions */
+
+static void
+tcpip_setup(void)
+{
+  memset(test_input_lens, 0, sizeof(test_input_lens));
+  test_input_calls = 0;
+  test_input_reject = -1;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+tcpip_teardown(void)
+{
+  while (tcpip_thread_poll_one());
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static err_t
+test_tcpip_input(struct pbuf *p, struct netif *inp)
+{
+  struct pbuf *q;
+
+  fail_unless(inp == &test_netif);
+  /* each packet is passed on its own */
+  for (q = p; q->next != NULL; q = q->next);
+  fail_unless(q->tot_len == q->len);
+  if (test_input_calls < TEST_TCPIP_MAX_PACKETS) {
+    test_input_lens[test_input_calls] = p->tot_len;
+  }
+  if (test_input_calls++ == test_input_reject) {
+    /* the stack frees rejected packets */
+    return ERR_VAL;
+  }
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+
+/* Test functions */
+
+/** Post three packets (one of them a pbuf chain) with one message */
+START_TEST(test_tcpip_inpkt_batch)
+{
+  struct pbuf *p1, *p2, *p2b, *p3;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  p1 = pbuf_alloc(PBUF_RAW, 10, PBUF_RAM);
+  p2 = pbuf_alloc(PBUF_RAW, 20, PBUF_RAM);
+  p2b = pbuf_alloc(PBUF_RAW, 30, PBUF_RAM);
+  p3 = pbuf_alloc(PBUF_RAW, 5, PBUF_RAM);
+  fail_unless((p1 != NULL) && (p2 != NULL) && (p2b != NULL) && (p3 != NULL));
+  pbuf_cat(p2, p2b);
+  /* link the packets via the last pbuf of each packet */
+  p1->next = p2;
+  p2b->next = p3;
+
+  test_input_reject = 1;
+  err = tcpip_inpkt_batch(p1, &test_netif, test_tcpip_input);
+  fail_unless(err == ERR_OK);
+#if !LWIP_TCPIP_CORE_LOCKING_INPUT
+  fail_unless(test_input_calls == 0);
+  fail_unless(tcpip_thread_poll_one() == 1);
+#endif /* !LWIP_TCPIP_CORE_LOCKING_INPUT */
+  fail_unless(test_input_calls == 3);
+  fail_unless(test_input_lens[0] == 10);
+  fail_unless(test_input_lens[1] == 50);
+  fail_unless(test_input_lens[2] == 5);
+  fail_unless(tcpip_thread_poll_one() == 0);
+}
+END_TEST
+
+/** A single packet is a valid packet queue, too */
+START_TEST(test_tcpip_inpkt_batch_single)
+{
+  struct pbuf *p;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  p = pbuf_alloc(PBUF_RAW, 100, PBUF_POOL);
+  fail_unless(p != NULL);
+  err = tcpip_inpkt_batch(p, &test_netif, test_tcpip_input);
+  fail_unless(err == ERR_OK);
+#if !LWIP_TCPIP_CORE_LOCKING_INPUT
+  fail_unless(tcpip_thread_poll_one() == 1);
+#endif /* !LWIP_TCPIP_CORE_LOCKING_INPUT */
+  fail_unless(test_input_calls == 1);
+  fail_unless(test_input_lens[0] == 100);
+}
+END_TEST
+
+#define TEST_TCPIP_BATCH_MSGS (TCPIP_MBOX_BATCH_SIZE + 2)
+
+static int test_batch_order[TEST_TCPIP_BATCH_MSGS];
+static int test_batch_calls;
+
+static void
+test_tcpip_batch_callback(void *ctx)
+{
+  if (test_batch_calls < TEST_TCPIP_BATCH_MSGS) {
+    test_batch_order[test_batch_calls] = *(int *)ctx;
+  }
+  test_batch_calls++;
+}
+
+/** One wakeup of tcpip_thread handles up to TCPIP_MBOX_BATCH_SIZE queued
+ * messages, in the order they were posted */
+START_TEST(test_tcpip_mbox_batch)
+{
+  static int ids[TEST_TCPIP_BATCH_MSGS];
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  test_batch_calls = 0;
+  for (i = 0; i < TEST_TCPIP_BATCH_MSGS; i++) {
+    ids[i] = i;
+    fail_unless(tcpip_callback(test_tcpip_batch_callback, &ids[i]) == ERR_OK);
+  }
+  fail_unless(test_batch_calls == 0);
+
+  for (i = 0; i < TEST_TCPIP_BATCH_MSGS; i += TCPIP_MBOX_BATCH_SIZE) {
+    fail_unless(tcpip_thread_poll_batch() == 1);
+    fail_unless(test_batch_calls == LWIP_MIN(i + TCPIP_MBOX_BATCH_SIZE, TEST_TCPIP_BATCH_MSGS));
+  }
+  fail_unless(tcpip_thread_poll_batch() == 0);
+  for (i = 0; i < TEST_TCPIP_BATCH_MSGS; i++) {
+    fail_unless(test_batch_order[i] == i);
+  }
+}
+END_TEST
+
+#if LWIP_SPSC_RING
+/** Packets added to an rxring are delivered with one message per batch */
+START_TEST(test_tcpip_rxring)
+{
+  struct tcpip_rxring rxr;
+  void *slots[4];
+  struct pbuf *p[3];
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(tcpip_rxring_init(&rxr, slots, 3, &test_netif, test_tcpip_input) == ERR_ARG);
+  fail_unless(tcpip_rxring_init(&rxr, slots, LWIP_ARRAYSIZE(slots), &test_netif, test_tcpip_input) == ERR_OK);
+  for (i = 0; i < 3; i++) {
+    p[i] = pbuf_alloc(PBUF_RAW, (u16_t)(10 * (i + 1)), PBUF_RAM);
+    fail_unless(p[i] != NULL);
+  }
+
+  /* two batches before tcpip_thread runs: one notification */
+  test_input_reject = 1;
+  fail_unless(spsc_ring_put_batch(&rxr.ring, (void **)p, 2) == 2);
+  fail_unless(tcpip_rxring_doorbell(&rxr) == ERR_OK);
+  fail_unless(spsc_ring_put(&rxr.ring, p[2]) == ERR_OK);
+  fail_unless(tcpip_rxring_doorbell(&rxr) == ERR_OK);
+  fail_unless(test_input_calls == 0);
+  fail_unless(tcpip_thread_poll_one() == 1);
+  fail_unless(tcpip_thread_poll_one() == 0);
+  fail_unless(test_input_calls == 3);
+  fail_unless(test_input_lens[0] == 10);
+  fail_unless(test_input_lens[1] == 20);
+  fail_unless(test_input_lens[2] == 30);
+
+  /* the doorbell is armed again after draining */
+  p[0] = pbuf_alloc(PBUF_RAW, 40, PBUF_RAM);
+  fail_unless(p[0] != NULL);
+  fail_unless(spsc_ring_put(&rxr.ring, p[0]) == ERR_OK);
+  fail_unless(tcpip_rxring_doorbell(&rxr) == ERR_OK);
+  fail_unless(tcpip_thread_poll_one() == 1);
+  fail_unless(test_input_calls == 4);
+
+  /* packets left in the ring are freed with it */
+  p[0] = pbuf_alloc(PBUF_RAW, 50, PBUF_RAM);
+  fail_unless(p[0] != NULL);
+  fail_unless(spsc_ring_put(&rxr.ring, p[0]) == ERR_OK);
+  tcpip_rxring_free(&rxr);
+  fail_unless(test_input_calls == 4);
+}
+END_TEST
+
+#define TEST_RXRING_ITEMS 200000
+/* spins of the producer waiting for the ring to be drained */
+#define TEST_RXRING_WAIT  1000000
+
+static struct tcpip_rxring test_rxring;
+/* the last item handed to the input function, written by tcpip_thread */
+static volatile u32_t test_rxring_received;
+static u32_t test_rxring_errors;
+/* producer state */
+static volatile int test_rxring_done;
+static u32_t test_rxring_lost;
+
+/* The ring never looks at its entries: sequence numbers stand in for the
+ * packets here, they must arrive in order and each one exactly once */
+static err_t
+test_tcpip_rxring_seq_input(struct pbuf *p, struct netif *inp)
+{
+  u32_t seq = (u32_t)(size_t)p;
+
+  fail_unless(inp == &test_netif);
+  if (seq != test_rxring_received + 1) {
+    test_rxring_errors++;
+  }
+  test_rxring_received = seq;
+  return ERR_OK;
+}
+
+/* Driver side: add the items in batches of varying size and ring the
+ * doorbell after each batch. Every few batches, wait for tcpip_thread to
+ * catch up: if it does not, a notification was lost. */
+static void
+test_tcpip_rxring_producer(void *arg)
+{
+  void *items[8];
+  u32_t seq = 1;
+  u32_t rnd = 1;
+  LWIP_UNUSED_ARG(arg);
+
+  while (seq <= TEST_RXRING_ITEMS) {
+    u32_t n, put, i;
+
+    rnd = rnd * 1103515245 + 12345;
+    n = ((rnd >> 16) % LWIP_ARRAYSIZE(items)) + 1;
+    if (n > TEST_RXRING_ITEMS + 1 - seq) {
+      n = TEST_RXRING_ITEMS + 1 - seq;
+    }
+    for (i = 0; i < n; i++) {
+      items[i] = (void *)(size_t)(seq + i);
+    }
+    put = spsc_ring_put_batch(&test_rxring.ring, items, n);
+    seq += put;
+    /* ERR_MEM (mbox full) is retried with the next doorbell */
+    tcpip_rxring_doorbell(&test_rxring);
+    if ((put < n) || (rnd & 0x700000) == 0) {
+      u32_t spins = 0;
+      while ((test_rxring_received != seq - 1) && (spins++ < TEST_RXRING_WAIT)) {
+        test_sys_arch_thread_yield();
+        if (put < n) {
+          /* ring full: the doorbell may have failed on a full mbox */
+          tcpip_rxring_doorbell(&test_rxring);
+        }
+      }
+      if (test_rxring_received != seq - 1) {
+        test_rxring_lost++;
+        break;
+      }
+    }
+  }
+  test_rxring_done = 1;
+}
+
+/** A driver thread adds packets while tcpip_thread drains them: all of them
+ * arrive in order and no notification is lost when the ring runs empty
+ * while the driver adds to it */
+START_TEST(test_tcpip_rxring_threads)
+{
+  struct test_sys_arch_thread *producer;
+  void *slots[16];
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(tcpip_rxring_init(&test_rxring, slots, LWIP_ARRAYSIZE(slots), &test_netif,
+                                test_tcpip_rxring_seq_input) == ERR_OK);
+  test_rxring_received = 0;
+  test_rxring_errors = 0;
+  test_rxring_done = 0;
+  test_rxring_lost = 0;
+
+  producer = test_sys_arch_thread_new(test_tcpip_rxring_producer, NULL);
+  /* tcpip_thread */
+  while (!test_rxring_done) {
+    if (!tcpip_thread_poll_one()) {
+      test_sys_arch_thread_yield();
+    }
+  }
+  test_sys_arch_thread_join(producer);
+  while (tcpip_thread_poll_one());
+
+  fail_unless(test_rxring_lost == 0);
+  fail_unless(test_rxring_errors == 0);
+  fail_unless(test_rxring_received == TEST_RXRING_ITEMS);
+  fail_unless(spsc_ring_count(&test_rxring.ring) == 0);
+  fail_unless(test_rxring.ring.doorbell == 0);
+  tcpip_rxring_free(&test_rxring);
+}
+END_TEST
+#endif /* LWIP_SPSC_RING */
+
+/** Create the suite including all tests for this module */
+Suite *
+tcpip_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_tcpip_inpkt_batch),
+    TESTFUNC(test_tcpip_inpkt_batch_single),
+    TESTFUNC(test_tcpip_mbox_batch),
+#if LWIP_SPSC_RING
+    TESTFUNC(test_tcpip_rxring),
+    TESTFUNC(test_tcpip_rxring_threads),
+#endif /* LWIP_SPSC_RING */
+  };
+  return create_suite("TCPIP", tests, sizeof(tests)/sizeof(testfunc), tcpip_setup, tcpip_teardown);
+}
@@ -41,6 +41,8 @@
 #include <lwip/sys.h>
 
 #include <string.h>
+#include <pthread.h>
+#include <sched.h>
 
 u32_t lwip_sys_now;
 
@@ -64,6 +66,8 @@ sys_init(void)
 #if !NO_SYS
 
 test_sys_arch_waiting_fn the_waiting_fn;
+/* protects the contents of all mboxes against other test threads */
+static pthread_mutex_t mbox_lock = PTHREAD_MUTEX_INITIALIZER;
 
 void
 test_sys_arch_wait_callback(test_sys_arch_waiting_fn waiting_fn)
@@ -71,6 +75,62 @@ test_sys_arch_wait_callback(test_sys_arch_waiting_fn waiting_fn)
   the_waiting_fn = waiting_fn;
 }
 
+/* number of threads started by test_sys_arch_thread_new() still running */
+static volatile u32_t test_sys_arch_threads;
+
+struct test_sys_arch_thread {
+  pthread_t thread;
+  void (*function)(void *arg);
+  void *arg;
+};
+
+static void *
+test_sys_arch_thread_main(void *arg)
+{
+  struct test_sys_arch_thread *thread = (struct test_sys_arch_thread *)arg;
+  thread->function(thread->arg);
+  return NULL;
+}
+
+struct test_sys_arch_thread *
+test_sys_arch_thread_new(void (*function)(void *arg), void *arg)
+{
+  struct test_sys_arch_thread *thread;
+
+  thread = (struct test_sys_arch_thread *)malloc(sizeof(struct test_sys_arch_thread));
+  LWIP_ASSERT("thread != NULL", thread != NULL);
+  thread->function = function;
+  thread->arg = arg;
+  __sync_fetch_and_add(&test_sys_arch_threads, 1);
+  if (pthread_create(&thread->thread, NULL, test_sys_arch_thread_main, thread) != 0) {
+    LWIP_ASSERT("pthread_create failed", 0);
+  }
+  return thread;
+}
+
+void
+test_sys_arch_thread_join(struct test_sys_arch_thread *thread)
+{
+  pthread_join(thread->thread, NULL);
+  free(thread);
+  __sync_fetch_and_sub(&test_sys_arch_threads, 1);
+}
+
+void
+test_sys_arch_thread_yield(void)
+{
+  sched_yield();
+}
+
+void
+test_sys_arch_memory_barrier(void)
+{
+  __sync_synchronize();
+  if (test_sys_arch_threads > 0) {
+    sched_yield();
+  }
+}
+
 err_t
 sys_sem_new(sys_sem_t *sem, u8_t count)
 {
@@ -246,15 +306,9 @@ sys_mbox_set_invalid(sys_mbox_t *mbox)
   mbox->q_mem = NULL;
 }
 
-void
-sys_mbox_post(sys_mbox_t *q, void *msg)
+static void
+sys_mbox_post_locked(sys_mbox_t *q, void *msg)
 {
-  LWIP_ASSERT("q != SYS_MBOX_NULL", q != SYS_MBOX_NULL);
-  LWIP_ASSERT("q->sem == q", q->sem == q);
-  LWIP_ASSERT("q->q_mem != NULL", q->q_mem != NULL);
-  LWIP_ASSERT("q->used >= 0", q->used >= 0);
-  LWIP_ASSERT("q->size > 0", q->size > 0);
-
   LWIP_ASSERT("mbox already full", q->used < q->size);
 
   q->q_mem[q->head] = msg;
@@ -266,6 +320,20 @@ sys_mbox_post(sys_mbox_t *q, void *msg)
   q->used++;
 }
 
+void
+sys_mbox_post(sys_mbox_t *q, void *msg)
+{
+  LWIP_ASSERT("q != SYS_MBOX_NULL", q != SYS_MBOX_NULL);
+  LWIP_ASSERT("q->sem == q", q->sem == q);
+  LWIP_ASSERT("q->q_mem != NULL", q->q_mem != NULL);
+  LWIP_ASSERT("q->used >= 0", q->used >= 0);
+  LWIP_ASSERT("q->size > 0", q->size > 0);
+
+  pthread_mutex_lock(&mbox_lock);
+  sys_mbox_post_locked(q, msg);
+  pthread_mutex_unlock(&mbox_lock);
+}
+
 err_t
 sys_mbox_trypost(sys_mbox_t *q, void *msg)
 {
@@ -276,10 +344,13 @@ sys_mbox_trypost(sys_mbox_t *q, void *msg)
   LWIP_ASSERT("q->size > 0", q->size > 0);
   LWIP_ASSERT("q->used <= q->size", q->used <= q->size);
 
+  pthread_mutex_lock(&mbox_lock);
   if (q->used == q->size) {
+    pthread_mutex_unlock(&mbox_lock);
     return ERR_MEM;
   }
-  sys_mbox_post(q, msg);
+  sys_mbox_post_locked(q, msg);
+  pthread_mutex_unlock(&mbox_lock);
   return ERR_OK;
 }
 
@@ -348,7 +419,9 @@ sys_arch_mbox_tryfetch(sys_mbox_t *q, void **msg)
   LWIP_ASSERT("q->used >= 0", q->used >= 0);
   LWIP_ASSERT("q->size > 0", q->size > 0);
 
+  pthread_mutex_lock(&mbox_lock);
   if (!q->used) {
+    pthread_mutex_unlock(&mbox_lock);
     return SYS_ARCH_TIMEOUT;
   }
   if(msg) {
@@ -361,6 +434,7 @@ sys_arch_mbox_tryfetch(sys_mbox_t *q, void **msg)
   }
   q->used--;
   LWIP_ASSERT("q->used >= 0", q->used >= 0);
+  pthread_mutex_unlock(&mbox_lock);
   return 0;
 }
 
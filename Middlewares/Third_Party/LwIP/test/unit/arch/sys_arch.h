@@ -65,6 +65,20 @@ typedef u32_t sys_thread_t;
 typedef int (*test_sys_arch_waiting_fn)(sys_sem_t* wait_sem, sys_mbox_t* wait_mbox);
 void test_sys_arch_wait_callback(test_sys_arch_waiting_fn waiting_fn);
 
+/* real threads for tests of code that is called concurrently (e.g. lock-free
+ * pools and rings): the stack itself still runs in the test's thread only
+ * (see sys_thread_new()), but mboxes may be posted to from any thread
+ */
+struct test_sys_arch_thread;
+struct test_sys_arch_thread *test_sys_arch_thread_new(void (*function)(void *arg), void *arg);
+void test_sys_arch_thread_join(struct test_sys_arch_thread *thread);
+void test_sys_arch_thread_yield(void);
+
+/* lock-free code is most sensitive to being interrupted around its memory
+ * barriers: while test threads run, let the others run there */
+void test_sys_arch_memory_barrier(void);
+#define SYS_ARCH_MEMORY_BARRIER() test_sys_arch_memory_barrier()
+
 /* current time */
 extern u32_t lwip_sys_now;
 
@@ -0,0 +1,140 @@
+#include "test_inet_chksum.h"
+
+#include "lwip/inet_chksum.h"
+#include "lwip/pbuf.h"
+#include "lwip/stats.h"
+
+#define TEST_MAX_LEN    9000
+#define TEST_MAX_ALIGN  8
+
+static u8_t test_src[TEST_MAX_LEN + TEST_MAX_ALIGN];
+static u8_t test_dst[TEST_MAX_LEN + TEST_MAX_ALIGN];
+
+/* Setups/teardown functions */
+
+static void
+inet_chksum_setup(void)
+{
+  size_t i;
+  u32_t x = 0x12345678;
+
+  /* pseudo random data with plenty of 0xff bytes to provoke carries */
+  for (i = 0; i < sizeof(test_src); i++) {
+    x = x * 1103515245UL + 12345;
+    test_src[i] = (u8_t)((x >> 16) & 1 ? 0xff : (x >> 8));
+  }
+}
+
+static void
+inet_chksum_teardown(void)
+{
+}
+
+/** Straightforward RFC 1071 reference: inverted sum of big-endian words */
+static u16_t
+test_ref_chksum(const u8_t *data, size_t len)
+{
+  u32_t acc = 0;
+  size_t i;
+
+  for (i = 0; i + 1 < len; i += 2) {
+    acc += ((u32_t)data[i] << 8) | data[i + 1];
+  }
+  if (len & 1) {
+    acc += (u32_t)data[len - 1] << 8;
+  }
+  while (acc >> 16) {
+    acc = (acc & 0xffff) + (acc >> 16);
+  }
+  return lwip_htons((u16_t)~acc);
+}
+
+static const u16_t test_lens[] = {
+  0, 1, 2, 3, 4, 5, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129,
+  255, 256, 511, 576, 1023, 1460, 1500, 1514, 2048, 4095, 4096, 8191, 8192, 9000
+};
+
+/* Test functions */
+
+/** Check inet_chksum against the reference for all alignments and sizes */
+START_TEST(test_inet_chksum_sizes_alignments)
+{
+  size_t i, align;
+  LWIP_UNUSED_ARG(_i);
+
+  for (align = 0; align < TEST_MAX_ALIGN; align++) {
+    for (i = 0; i < LWIP_ARRAYSIZE(test_lens); i++) {
+      u16_t len = test_lens[i];
+      fail_unless(inet_chksum(&test_src[align], len) == test_ref_chksum(&test_src[align], len));
+    }
+  }
+}
+END_TEST
+
+/** Check inet_chksum_pbuf on chains split at odd and even offsets */
+START_TEST(test_inet_chksum_pbuf_chain)
+{
+  static const u16_t splits[] = { 1, 2, 3, 7, 64, 333, 749 };
+  size_t i, j;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < LWIP_ARRAYSIZE(splits); i++) {
+    for (j = 0; j < 3; j++) {
+      /* PBUF_REF chain: split | split | rest, starting at offset j */
+      u16_t total = 1500;
+      struct pbuf *p1, *p2, *p3;
+      p1 = pbuf_alloc(PBUF_RAW, splits[i], PBUF_REF);
+      p2 = pbuf_alloc(PBUF_RAW, splits[i], PBUF_REF);
+      p3 = pbuf_alloc(PBUF_RAW, (u16_t)(total - 2 * splits[i]), PBUF_REF);
+      fail_unless((p1 != NULL) && (p2 != NULL) && (p3 != NULL));
+      p1->payload = &test_src[j];
+      p2->payload = &test_src[j + splits[i]];
+      p3->payload = &test_src[j + 2 * splits[i]];
+      pbuf_cat(p1, p2);
+      pbuf_cat(p1, p3);
+      fail_unless(inet_chksum_pbuf(p1) == test_ref_chksum(&test_src[j], total));
+      pbuf_free(p1);
+    }
+  }
+}
+END_TEST
+
+#if LWIP_CHKSUM_COPY_ALGORITHM
+/** Check lwip_chksum_copy copies and sums correctly for any src/dst alignment */
+START_TEST(test_inet_chksum_copy)
+{
+  size_t i, salign, dalign;
+  LWIP_UNUSED_ARG(_i);
+
+  for (salign = 0; salign < 4; salign++) {
+    for (dalign = 0; dalign < 4; dalign++) {
+      for (i = 0; i < LWIP_ARRAYSIZE(test_lens); i++) {
+        u16_t len = test_lens[i];
+        u16_t chksum;
+        memset(test_dst, 0xa5, sizeof(test_dst));
+        /* lwip_chksum_copy returns the non-inverted sum */
+        chksum = (u16_t)~lwip_chksum_copy(&test_dst[dalign], &test_src[salign], len);
+        fail_unless(chksum == test_ref_chksum(&test_src[salign], len));
+        fail_unless(memcmp(&test_dst[dalign], &test_src[salign], len) == 0);
+        /* nothing written past the end */
+        fail_unless(test_dst[dalign + len] == 0xa5);
+      }
+    }
+  }
+}
+END_TEST
+#endif /* LWIP_CHKSUM_COPY_ALGORITHM */
+
+/** Create the suite including all tests for this module */
+Suite *
+inet_chksum_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_inet_chksum_sizes_alignments),
+    TESTFUNC(test_inet_chksum_pbuf_chain),
+#if LWIP_CHKSUM_COPY_ALGORITHM
+    TESTFUNC(test_inet_chksum_copy),
+#endif /* LWIP_CHKSUM_COPY_ALGORITHM */
+  };
+  return create_suite("INET_CHKSUM", tests, sizeof(tests)/sizeof(testfunc), inet_chksum_setup, inet_chksum_teardown);
+}
@@ -0,0 +1,243 @@
+#include "test_memp.h"
+
+#include "lwip/memp.h"
+#include "lwip/sys.h"
+#include "lwip/stats.h"
+
+#if !LWIP_STATS || !MEMP_STATS
+#error "This tests needs MEMP-statistics enabled"
+#endif
+
+#define TEST_POOL_NUM  5
+#define TEST_POOL_SIZE 20
+LWIP_MEMPOOL_DECLARE(test_pool, TEST_POOL_NUM, TEST_POOL_SIZE, "test pool")
+
+/* Setups/teardown functions */
+
+static void
+memp_setup(void)
+{
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+  memset(memp_test_pool.stats, 0, sizeof(*memp_test_pool.stats));
+  LWIP_MEMPOOL_INIT(test_pool);
+}
+
+static void
+memp_teardown(void)
+{
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+
+/* Test functions */
+
+/** Exhaust a private pool, free it in a different order and check stats */
+START_TEST(test_memp_private_pool)
+{
+  void *elems[TEST_POOL_NUM];
+  u8_t *base = (u8_t *)LWIP_MEM_ALIGN(memp_memory_test_pool_base);
+  int i, j;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < TEST_POOL_NUM; i++) {
+    elems[i] = LWIP_MEMPOOL_ALLOC(test_pool);
+    fail_unless(elems[i] != NULL);
+    fail_unless(((u8_t *)elems[i] >= base) &&
+                ((u8_t *)elems[i] + TEST_POOL_SIZE <= base + sizeof(memp_memory_test_pool_base)));
+    for (j = 0; j < i; j++) {
+      fail_unless(elems[i] != elems[j]);
+    }
+    memset(elems[i], 0xa5, TEST_POOL_SIZE);
+  }
+  fail_unless(memp_test_pool.stats->used == TEST_POOL_NUM);
+  fail_unless(LWIP_MEMPOOL_ALLOC(test_pool) == NULL);
+  fail_unless(memp_test_pool.stats->err == 1);
+
+  /* free every second element first */
+  for (i = 0; i < TEST_POOL_NUM; i += 2) {
+    LWIP_MEMPOOL_FREE(test_pool, elems[i]);
+  }
+  for (i = 1; i < TEST_POOL_NUM; i += 2) {
+    LWIP_MEMPOOL_FREE(test_pool, elems[i]);
+  }
+  fail_unless(memp_test_pool.stats->used == 0);
+  fail_unless(memp_test_pool.stats->max == TEST_POOL_NUM);
+
+  /* the most recently freed element is reused first */
+  fail_unless(LWIP_MEMPOOL_ALLOC(test_pool) == elems[TEST_POOL_NUM - 2]);
+  LWIP_MEMPOOL_FREE(test_pool, elems[TEST_POOL_NUM - 2]);
+}
+END_TEST
+
+#if MEMP_LOCKFREE
+/** Check the list head is tagged so a stale compare-and-swap fails even if
+ * the same element is on top of the list again (ABA) */
+START_TEST(test_memp_lockfree_aba)
+{
+  void *elems[TEST_POOL_NUM];
+  void *a, *b;
+  memp_head_t snapshot;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  snapshot = memp_tab_test_pool;
+  a = LWIP_MEMPOOL_ALLOC(test_pool);
+  b = LWIP_MEMPOOL_ALLOC(test_pool);
+  fail_unless((a != NULL) && (b != NULL));
+  LWIP_MEMPOOL_FREE(test_pool, b);
+  LWIP_MEMPOOL_FREE(test_pool, a);
+  /* a is on top of the list again, only the tag differs */
+  fail_unless((memp_tab_test_pool & 0xFFFF) == (snapshot & 0xFFFF));
+  fail_unless(memp_tab_test_pool != snapshot);
+  fail_unless(!SYS_ARCH_CAS_U32(&memp_tab_test_pool, snapshot, snapshot));
+
+  /* an exhausted pool has an empty head */
+  for (i = 0; i < TEST_POOL_NUM; i++) {
+    elems[i] = LWIP_MEMPOOL_ALLOC(test_pool);
+    fail_unless(elems[i] != NULL);
+  }
+  fail_unless((memp_tab_test_pool & 0xFFFF) == MEMP_LOCKFREE_NIL);
+  fail_unless(LWIP_MEMPOOL_ALLOC(test_pool) == NULL);
+  for (i = 0; i < TEST_POOL_NUM; i++) {
+    LWIP_MEMPOOL_FREE(test_pool, elems[i]);
+  }
+  fail_unless(memp_test_pool.stats->used == 0);
+}
+END_TEST
+
+#if !NO_SYS
+#define TEST_MEMP_THREADS    4
+#define TEST_MEMP_HOLD       3
+#define TEST_MEMP_ITERATIONS 1000000
+
+/* the elements of test_pool, to find the index of an allocated element */
+static void *test_memp_elems[TEST_POOL_NUM];
+/* nonzero while the element is handed out */
+static volatile u32_t test_memp_in_use[TEST_POOL_NUM];
+
+struct test_memp_thread_state {
+  u8_t id;
+  u32_t errors;
+};
+
+static int
+test_memp_index(void *elem)
+{
+  int i;
+  for (i = 0; i < TEST_POOL_NUM; i++) {
+    if (test_memp_elems[i] == elem) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* Allocate and free elements of test_pool in random order, holding up to
+ * TEST_MEMP_HOLD elements: all threads together hold more than the pool
+ * has, so it runs empty, too */
+static void
+test_memp_thread(void *arg)
+{
+  struct test_memp_thread_state *state = (struct test_memp_thread_state *)arg;
+  void *held[TEST_MEMP_HOLD];
+  u32_t rnd = state->id;
+  int num = 0;
+  int i, idx;
+
+  for (i = 0; i < TEST_MEMP_ITERATIONS; i++) {
+    rnd = rnd * 1103515245 + 12345;
+    if ((num < TEST_MEMP_HOLD) && ((num == 0) || (rnd & 0x10000))) {
+      void *elem = LWIP_MEMPOOL_ALLOC(test_pool);
+      if (elem != NULL) {
+        idx = test_memp_index(elem);
+        if ((idx < 0) || !SYS_ARCH_CAS_U32(&test_memp_in_use[idx], 0, 1)) {
+          /* not an element of the pool or handed out twice */
+          state->errors++;
+          continue;
+        }
+        memset(elem, state->id, TEST_POOL_SIZE);
+        held[num++] = elem;
+      }
+    } else if (num > 0) {
+      void *elem = held[--num];
+      u8_t *data = (u8_t *)elem;
+      int j;
+      for (j = 0; j < TEST_POOL_SIZE; j++) {
+        if (data[j] != state->id) {
+          /* written by someone else while we owned it */
+          state->errors++;
+          break;
+        }
+      }
+      idx = test_memp_index(elem);
+      test_memp_in_use[idx] = 0;
+      LWIP_MEMPOOL_FREE(test_pool, elem);
+    }
+  }
+  while (num > 0) {
+    void *elem = held[--num];
+    test_memp_in_use[test_memp_index(elem)] = 0;
+    LWIP_MEMPOOL_FREE(test_pool, elem);
+  }
+}
+
+/** Allocate and free from several threads at once: no element may be handed
+ * out twice and all of them must be back in the pool afterwards */
+START_TEST(test_memp_lockfree_threads)
+{
+  struct test_sys_arch_thread *threads[TEST_MEMP_THREADS];
+  struct test_memp_thread_state states[TEST_MEMP_THREADS];
+  void *elems[TEST_POOL_NUM];
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < TEST_POOL_NUM; i++) {
+    test_memp_elems[i] = LWIP_MEMPOOL_ALLOC(test_pool);
+    fail_unless(test_memp_elems[i] != NULL);
+    test_memp_in_use[i] = 0;
+  }
+  for (i = 0; i < TEST_POOL_NUM; i++) {
+    LWIP_MEMPOOL_FREE(test_pool, test_memp_elems[i]);
+  }
+
+  for (i = 0; i < TEST_MEMP_THREADS; i++) {
+    states[i].id = (u8_t)(i + 1);
+    states[i].errors = 0;
+    threads[i] = test_sys_arch_thread_new(test_memp_thread, &states[i]);
+  }
+  for (i = 0; i < TEST_MEMP_THREADS; i++) {
+    test_sys_arch_thread_join(threads[i]);
+    fail_unless(states[i].errors == 0);
+  }
+
+  /* the pool is full again: every element can be allocated once */
+  for (i = 0; i < TEST_POOL_NUM; i++) {
+    elems[i] = LWIP_MEMPOOL_ALLOC(test_pool);
+    fail_unless(test_memp_index(elems[i]) >= 0);
+    fail_unless(test_memp_in_use[test_memp_index(elems[i])] == 0);
+    test_memp_in_use[test_memp_index(elems[i])] = 1;
+  }
+  fail_unless(LWIP_MEMPOOL_ALLOC(test_pool) == NULL);
+  for (i = 0; i < TEST_POOL_NUM; i++) {
+    LWIP_MEMPOOL_FREE(test_pool, elems[i]);
+  }
+}
+END_TEST
+#endif /* !NO_SYS */
+#endif /* MEMP_LOCKFREE */
+
+/** Create the suite including all tests for this module */
+Suite *
+memp_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_memp_private_pool),
+#if MEMP_LOCKFREE
+    TESTFUNC(test_memp_lockfree_aba),
+#if !NO_SYS
+    TESTFUNC(test_memp_lockfree_threads),
+#endif /* !NO_SYS */
+#endif /* MEMP_LOCKFREE */
+  };
+  return create_suite("MEMP", tests, sizeof(tests)/sizeof(testfunc), memp_setup, memp_teardown);
+}
@@ -2,12 +2,13 @@
 
 #include "lwip/pbuf.h"
 #include "lwip/stats.h"
+#include "lwip/def.h"
 
 #if !LWIP_STATS || !MEM_STATS ||!MEMP_STATS
 #error "This tests needs MEM- and MEMP-statistics enabled"
 #endif
-#if LWIP_DNS
-#error "This test needs DNS turned off (as it mallocs on init)"
+#if LWIP_DNS && ((LWIP_DNS_SECURE & LWIP_DNS_SECURE_RAND_SRC_PORT) == 0)
+#error "This test needs DNS turned off or random source ports (as it mallocs on init otherwise)"
 #endif
 #if !LWIP_TCP || !TCP_QUEUE_OOSEQ || !LWIP_WND_SCALE
 #error "This test needs TCP OOSEQ queueing and window scaling enabled"
@@ -255,6 +256,93 @@ START_TEST(test_pbuf_get_put_at_edge)
 }
 END_TEST
 
+/* cursor walks chains of odd-sized pbufs (incl. 1-byte ones) transparently */
+START_TEST(test_pbuf_cursor)
+{
+  static const u16_t lens[] = {3, 1, 1, 7, 1, 2, 9};
+  struct pbuf *p = NULL;
+  struct pbuf_cursor c;
+  u8_t buf[16];
+  u8_t *ptr;
+  u16_t i, total = 0;
+  int ch;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < LWIP_ARRAYSIZE(lens); i++) {
+    struct pbuf *q = pbuf_alloc(PBUF_RAW, lens[i], PBUF_RAM);
+    u16_t j;
+    fail_unless(q != NULL);
+    for (j = 0; j < lens[i]; j++) {
+      ((u8_t *)q->payload)[j] = (u8_t)(total + j);
+    }
+    total = (u16_t)(total + lens[i]);
+    if (p == NULL) {
+      p = q;
+    } else {
+      pbuf_cat(p, q);
+    }
+  }
+  fail_unless(p->tot_len == total);
+
+  /* byte-wise */
+  pbuf_cursor_init(&c, p, 0);
+  for (i = 0; i < total; i++) {
+    fail_unless(pbuf_cursor_pos(&c) == i);
+    ch = pbuf_cursor_get(&c);
+    fail_unless(ch == i);
+  }
+  fail_unless(pbuf_cursor_get(&c) == -1);
+
+  /* reads spanning boundaries, backward and forward seeks */
+  pbuf_cursor_init(&c, p, 2);
+  fail_unless(pbuf_cursor_read(&c, buf, 6) == 6);
+  for (i = 0; i < 6; i++) {
+    fail_unless(buf[i] == i + 2);
+  }
+  fail_unless(pbuf_cursor_pos(&c) == 8);
+  fail_unless(pbuf_cursor_seek(&c, 1) == ERR_OK);
+  fail_unless(pbuf_cursor_get(&c) == 1);
+  fail_unless(pbuf_cursor_seek(&c, 17) == ERR_OK);
+  fail_unless(pbuf_cursor_get(&c) == 17);
+  /* a failed seek leaves the cursor where it was */
+  fail_unless(pbuf_cursor_seek(&c, (u16_t)(total + 1)) == ERR_BUF);
+  fail_unless(pbuf_cursor_pos(&c) == 18);
+  fail_unless(pbuf_cursor_get(&c) == 18);
+  fail_unless(pbuf_cursor_seek(&c, 18) == ERR_OK);
+  fail_unless(pbuf_cursor_skip(&c, (u16_t)(total - 18)) == ERR_OK);
+  fail_unless(pbuf_cursor_pos(&c) == total);
+  fail_unless(pbuf_cursor_skip(&c, 1) == ERR_BUF);
+  fail_unless(pbuf_cursor_pos(&c) == total);
+  fail_unless(pbuf_cursor_seek(&c, (u16_t)(total + 1)) == ERR_BUF);
+  fail_unless(pbuf_cursor_read(&c, buf, 1) == 0);
+
+  /* memcmp does not move the cursor */
+  pbuf_cursor_init(&c, p, 3);
+  buf[0] = 3; buf[1] = 4; buf[2] = 5; buf[3] = 0x55;
+  fail_unless(pbuf_cursor_memcmp(&c, buf, 3) == 0);
+  fail_unless(pbuf_cursor_memcmp(&c, buf, 4) == 4);
+  fail_unless(pbuf_cursor_pos(&c) == 3);
+  pbuf_cursor_init(&c, p, (u16_t)(total - 2));
+  fail_unless(pbuf_cursor_memcmp(&c, buf, 3) == 0xffff);
+  fail_unless(pbuf_memcmp(p, 4, &buf[1], 2) == 0);
+
+  /* contiguous access: pointer into the pbuf if possible, copy otherwise */
+  pbuf_cursor_init(&c, p, 0);
+  ptr = (u8_t *)pbuf_cursor_get_contiguous(&c, buf, sizeof(buf), 3);
+  fail_unless(ptr == (u8_t *)p->payload);
+  ptr = (u8_t *)pbuf_cursor_get_contiguous(&c, buf, sizeof(buf), 4);
+  fail_unless(ptr == buf);
+  for (i = 0; i < 4; i++) {
+    fail_unless(ptr[i] == i + 3);
+  }
+  fail_unless(pbuf_cursor_pos(&c) == 7);
+  pbuf_cursor_init(&c, p, (u16_t)(total - 4));
+  fail_unless(pbuf_cursor_get_contiguous(&c, buf, sizeof(buf), 5) == NULL);
+
+  pbuf_free(p);
+}
+END_TEST
+
 /** Create the suite including all tests for this module */
 Suite *
 pbuf_suite(void)
@@ -265,7 +353,8 @@ pbuf_suite(void)
     TESTFUNC(test_pbuf_split_64k_on_small_pbufs),
     TESTFUNC(test_pbuf_queueing_bigger_than_64k),
     TESTFUNC(test_pbuf_take_at_edge),
-    TESTFUNC(test_pbuf_get_put_at_edge)
+    TESTFUNC(test_pbuf_get_put_at_edge),
+    TESTFUNC(test_pbuf_cursor)
   };
   return create_suite("PBUF", tests, sizeof(tests)/sizeof(testfunc), pbuf_setup, pbuf_teardown);
 }
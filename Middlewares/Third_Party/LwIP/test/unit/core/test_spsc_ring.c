@@ -0,0 +1,146 @@
+#include "test_spsc_ring.h"
+
+#include "lwip/spsc_ring.h"
+#include "lwip/def.h"
+
+#if LWIP_SPSC_RING
+
+#define TEST_RING_SIZE 8
+
+static struct spsc_ring ring;
+static void *ring_slots[TEST_RING_SIZE];
+static u8_t items[2 * TEST_RING_SIZE];
+
+/* Setups/teardown functions */
+
+static void
+spsc_ring_setup(void)
+{
+  spsc_ring_init(&ring, ring_slots, TEST_RING_SIZE);
+}
+
+static void
+spsc_ring_teardown(void)
+{
+}
+
+
+/* Test functions */
+
+START_TEST(test_spsc_ring_init)
+{
+  struct spsc_ring r;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(spsc_ring_init(&r, ring_slots, 0) == ERR_ARG);
+  fail_unless(spsc_ring_init(&r, ring_slots, 6) == ERR_ARG);
+  fail_unless(spsc_ring_init(&r, ring_slots, 1) == ERR_OK);
+  fail_unless(spsc_ring_count(&r) == 0);
+  fail_unless(spsc_ring_get(&r) == NULL);
+}
+END_TEST
+
+/** Entries come out in order, a full ring refuses more */
+START_TEST(test_spsc_ring_batch)
+{
+  void *in[2 * TEST_RING_SIZE];
+  void *out[2 * TEST_RING_SIZE];
+  u32_t i, n;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < LWIP_ARRAYSIZE(in); i++) {
+    in[i] = &items[i];
+  }
+  n = spsc_ring_put_batch(&ring, in, 5);
+  fail_unless(n == 5);
+  fail_unless(spsc_ring_count(&ring) == 5);
+  /* only the free slots are filled */
+  n = spsc_ring_put_batch(&ring, &in[5], 5);
+  fail_unless(n == TEST_RING_SIZE - 5);
+  fail_unless(spsc_ring_put(&ring, in[0]) == ERR_MEM);
+
+  n = spsc_ring_get_batch(&ring, out, 3);
+  fail_unless(n == 3);
+  fail_unless(spsc_ring_get(&ring) == in[3]);
+  /* wrap around the end of the slot array */
+  n = spsc_ring_put_batch(&ring, &in[8], 4);
+  fail_unless(n == 4);
+  n = spsc_ring_get_batch(&ring, &out[3], LWIP_ARRAYSIZE(out));
+  fail_unless(n == TEST_RING_SIZE);
+  for (i = 0; i < 3; i++) {
+    fail_unless(out[i] == in[i]);
+  }
+  for (i = 3; i < 3 + TEST_RING_SIZE; i++) {
+    fail_unless(out[i] == in[i + 1]);
+  }
+  fail_unless(spsc_ring_get(&ring) == NULL);
+}
+END_TEST
+
+/** The free-running indices may overflow */
+START_TEST(test_spsc_ring_index_wrap)
+{
+  u32_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  ring.head = ring.tail = 0xFFFFFFFEUL;
+  for (i = 0; i < TEST_RING_SIZE; i++) {
+    fail_unless(spsc_ring_put(&ring, &items[i]) == ERR_OK);
+  }
+  fail_unless(spsc_ring_count(&ring) == TEST_RING_SIZE);
+  fail_unless(spsc_ring_put(&ring, &items[0]) == ERR_MEM);
+  for (i = 0; i < TEST_RING_SIZE; i++) {
+    fail_unless(spsc_ring_get(&ring) == &items[i]);
+  }
+  fail_unless(spsc_ring_count(&ring) == 0);
+}
+END_TEST
+
+/** The producer has to notify the consumer once per drain cycle only */
+START_TEST(test_spsc_ring_doorbell)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(spsc_ring_put(&ring, &items[0]) == ERR_OK);
+  fail_unless(spsc_ring_doorbell(&ring) != 0);
+  fail_unless(spsc_ring_put(&ring, &items[1]) == ERR_OK);
+  fail_unless(spsc_ring_doorbell(&ring) == 0);
+
+  /* consumer drains, the producer adds more before it re-arms */
+  fail_unless(spsc_ring_get(&ring) == &items[0]);
+  fail_unless(spsc_ring_get(&ring) == &items[1]);
+  fail_unless(spsc_ring_put(&ring, &items[2]) == ERR_OK);
+  fail_unless(spsc_ring_doorbell(&ring) == 0);
+  fail_unless(spsc_ring_consumer_done(&ring) != 0);
+  fail_unless(spsc_ring_get(&ring) == &items[2]);
+  fail_unless(spsc_ring_consumer_done(&ring) == 0);
+
+  /* re-armed: the next batch needs a notification again */
+  fail_unless(spsc_ring_put(&ring, &items[3]) == ERR_OK);
+  fail_unless(spsc_ring_doorbell(&ring) != 0);
+  fail_unless(spsc_ring_get(&ring) == &items[3]);
+  fail_unless(spsc_ring_consumer_done(&ring) == 0);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+spsc_ring_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_spsc_ring_init),
+    TESTFUNC(test_spsc_ring_batch),
+    TESTFUNC(test_spsc_ring_index_wrap),
+    TESTFUNC(test_spsc_ring_doorbell)
+  };
+  return create_suite("SPSC_RING", tests, sizeof(tests)/sizeof(testfunc), spsc_ring_setup, spsc_ring_teardown);
+}
+
+#else /* LWIP_SPSC_RING */
+
+Suite *
+spsc_ring_suite(void)
+{
+  return create_suite("SPSC_RING", NULL, 0, NULL, NULL);
+}
+#endif /* LWIP_SPSC_RING */
@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_SPSC_RING_H
+#define LWIP_HDR_TEST_SPSC_RING_H
+
+#include "../lwip_check.h"
+
+Suite *spsc_ring_suite(void);
+
+#endif
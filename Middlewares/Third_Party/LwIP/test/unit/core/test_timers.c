@@ -6,24 +6,49 @@
 
 /* Setups/teardown functions */
 
+#if LWIP_TIMERS_WHEEL
+static struct sys_timeo_wheel old_wheel;
+#else
 static struct sys_timeo* old_list_head;
+#endif
 
 static void
 timers_setup(void)
 {
+#if LWIP_TIMERS_WHEEL
+  struct sys_timeo_wheel* wheel = sys_timeouts_get_wheel();
+  old_wheel = *wheel;
+  memset(wheel, 0, sizeof(*wheel));
+#else
   struct sys_timeo** list_head = sys_timeouts_get_next_timeout();
   old_list_head = *list_head;
   *list_head = NULL;
+#endif
 }
 
 static void
 timers_teardown(void)
 {
+#if LWIP_TIMERS_WHEEL
+  *sys_timeouts_get_wheel() = old_wheel;
+#else
   struct sys_timeo** list_head = sys_timeouts_get_next_timeout();
   *list_head = old_list_head;
+#endif
   lwip_sys_now = 0;
 }
 
+/* due time of the first pending timeout */
+static u32_t
+next_timeout_time(void)
+{
+#if LWIP_TIMERS_WHEEL
+  return (u32_t)(lwip_sys_now + sys_timeouts_sleeptime());
+#else
+  return (*sys_timeouts_get_next_timeout())->time;
+#endif
+}
+
 static int fired[3];
 static void
 dummy_handler(void* arg)
@@ -46,8 +71,6 @@ struct lwip_cyclic_timer test_cyclic = {10, dummy_cyclic_handler};
 static void
 do_test_cyclic_timers(u32_t offset)
 {
-  struct sys_timeo** list_head = sys_timeouts_get_next_timeout();
-
   /* verify normal timer expiration */
   lwip_sys_now = offset + 0;
   sys_timeout(test_cyclic.interval_ms, lwip_cyclic_timer, &test_cyclic);
@@ -60,7 +83,7 @@ do_test_cyclic_timers(u32_t offset)
   sys_check_timeouts();
   fail_unless(cyclic_fired == 1);
 
-  fail_unless((*list_head)->time == (u32_t)(lwip_sys_now + test_cyclic.interval_ms - HANDLER_EXECUTION_TIME));
+  fail_unless(next_timeout_time() == (u32_t)(lwip_sys_now + test_cyclic.interval_ms - HANDLER_EXECUTION_TIME));
   
   sys_untimeout(lwip_cyclic_timer, &test_cyclic);
 
@@ -77,7 +100,7 @@ do_test_cyclic_timers(u32_t offset)
   sys_check_timeouts();
   fail_unless(cyclic_fired == 1);
 
-  fail_unless((*list_head)->time == (u32_t)(lwip_sys_now + test_cyclic.interval_ms));
+  fail_unless(next_timeout_time() == (u32_t)(lwip_sys_now + test_cyclic.interval_ms));
 }
 
 START_TEST(test_cyclic_timers)
@@ -127,8 +150,10 @@ END_TEST
 static void
 do_test_timers(u32_t offset)
 {
+#if !LWIP_TIMERS_WHEEL
   struct sys_timeo** list_head = sys_timeouts_get_next_timeout();
-  
+#endif
+
   lwip_sys_now = offset + 0;
 
   sys_timeout(10, dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 0));
@@ -138,10 +163,12 @@ do_test_timers(u32_t offset)
   sys_timeout( 5, dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 2));
   fail_unless(sys_timeouts_sleeptime() == 5);
 
+#if !LWIP_TIMERS_WHEEL
   /* linked list correctly sorted? */
   fail_unless((*list_head)->time             == (u32_t)(lwip_sys_now + 5));
   fail_unless((*list_head)->next->time       == (u32_t)(lwip_sys_now + 10));
   fail_unless((*list_head)->next->next->time == (u32_t)(lwip_sys_now + 20));
+#endif
   
   /* check timers expire in correct order */
   memset(&fired, 0, sizeof(fired));
@@ -219,6 +246,131 @@ START_TEST(test_long_timer)
 }
 END_TEST
 
+#define MANY_TIMEOUTS 2000
+static u32_t many_due[MANY_TIMEOUTS];
+static u8_t many_state[MANY_TIMEOUTS];
+static u32_t many_last_fired;
+static int many_fired;
+static int many_bad;
+static int many_exact;
+
+static void
+many_handler(void* arg)
+{
+  int index = LWIP_PTR_NUMERIC_CAST(int, arg);
+  /* must fire exactly once, not early and in order */
+  if ((many_state[index] != 1) ||
+      ((u32_t)(lwip_sys_now - many_due[index]) > 0x7fffffff) ||
+      (many_exact && (many_due[index] != lwip_sys_now)) ||
+      ((u32_t)(many_due[index] - many_last_fired) > 0x7fffffff)) {
+    many_bad++;
+  }
+  many_state[index] = 2;
+  many_last_fired = many_due[index];
+  many_fired++;
+}
+
+static void
+do_test_many_timeouts(u32_t offset)
+{
+  u32_t rnd = 0x12345678 ^ offset;
+  int i, pending = 0;
+  u32_t sleeptime;
+
+  memset(many_state, 0, sizeof(many_state));
+  many_fired = 0;
+  many_bad = 0;
+  many_exact = 0;
+  lwip_sys_now = offset;
+  many_last_fired = offset;
+
+  for (i = 0; i < MANY_TIMEOUTS; i++) {
+    u32_t msecs;
+    rnd = rnd * 1103515245 + 12345;
+    /* mostly short timeouts, some spanning all wheel levels */
+    msecs = (i % 16) ? ((rnd >> 8) % 5000) : ((rnd >> 2) % (LWIP_UINT32_MAX / 4));
+    many_due[i] = (u32_t)(lwip_sys_now + msecs);
+    many_state[i] = 1;
+    sys_timeout(msecs, many_handler, LWIP_PTR_NUMERIC_CAST(void*, i));
+    if ((i % 3) == 0) {
+      /* let time pass while adding */
+      lwip_sys_now += (rnd >> 16) % 7;
+      sys_check_timeouts();
+    }
+  }
+  /* cancel some */
+  for (i = 0; i < MANY_TIMEOUTS; i += 7) {
+    if (many_state[i] == 1) {
+      sys_untimeout(many_handler, LWIP_PTR_NUMERIC_CAST(void*, i));
+      many_state[i] = 3;
+    }
+  }
+  for (i = 0; i < MANY_TIMEOUTS; i++) {
+    if (many_state[i] == 2) {
+      many_fired--;
+    } else if (many_state[i] == 1) {
+      pending++;
+    }
+  }
+  fail_unless(many_fired == 0);
+
+  /* sleep exactly until the next timeout is due, every time */
+  many_exact = 1;
+  while ((sleeptime = sys_timeouts_sleeptime()) != SYS_TIMEOUTS_SLEEPTIME_INFINITE) {
+    u32_t next = 0;
+    int found = 0;
+    for (i = 0; i < MANY_TIMEOUTS; i++) {
+      if ((many_state[i] == 1) && (!found || ((u32_t)(many_due[i] - next) > 0x7fffffff))) {
+        next = many_due[i];
+        found = 1;
+      }
+    }
+    fail_unless(found);
+    fail_unless((u32_t)(lwip_sys_now + sleeptime) == next);
+    lwip_sys_now = next;
+    sys_check_timeouts();
+  }
+  fail_unless(many_fired == pending);
+  fail_unless(many_bad == 0);
+}
+
+START_TEST(test_many_timeouts)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  /* check without u32_t wraparound */
+  do_test_many_timeouts(0);
+
+  /* check with u32_t wraparound */
+  do_test_many_timeouts(0xfffff000);
+}
+END_TEST
+
+START_TEST(test_restart_timeouts)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&fired, 0, sizeof(fired));
+  lwip_sys_now = 100;
+  sys_timeout(10, dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 0));
+  sys_timeout(30, dummy_handler, LWIP_PTR_NUMERIC_CAST(void*, 1));
+
+  /* wake up late: the rebased timers keep their distance */
+  lwip_sys_now = 100000;
+  sys_restart_timeouts();
+  fail_unless(sys_timeouts_sleeptime() == 0);
+  sys_check_timeouts();
+  fail_unless(fired[0] == 1);
+  fail_unless(fired[1] == 0);
+  fail_unless(sys_timeouts_sleeptime() == 20);
+
+  lwip_sys_now += 20;
+  sys_check_timeouts();
+  fail_unless(fired[1] == 1);
+  fail_unless(sys_timeouts_sleeptime() == SYS_TIMEOUTS_SLEEPTIME_INFINITE);
+}
+END_TEST
+
 /** Create the suite including all tests for this module */
 Suite *
 timers_suite(void)
@@ -228,6 +380,8 @@ timers_suite(void)
     TESTFUNC(test_cyclic_timers),
     TESTFUNC(test_timers),
     TESTFUNC(test_long_timer),
+    TESTFUNC(test_many_timeouts),
+    TESTFUNC(test_restart_timeouts),
   };
   return create_suite("TIMERS", tests, LWIP_ARRAYSIZE(tests), timers_setup, timers_teardown);
 }
@@ -0,0 +1,492 @@
+#include "test_dns.h"
+
+#include "lwip/dns.h"
+#include "lwip/prot/dns.h"
+#include "lwip/ip4.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/netif.h"
+#include "lwip/udp.h"
+
+#if !LWIP_DNS || !LWIP_DNS_CACHE
+#error "This test needs DNS and the DNS cache enabled"
+#endif
+
+/* Fake DNS server answering the queries sent out on the test netif */
+
+static struct netif test_netif;
+static ip4_addr_t test_ipaddr, test_netmask, test_gw, test_dns_server;
+
+/* last query seen on the wire */
+static u32_t query_cnt;
+static u16_t query_port;
+static u16_t query_txid;
+static u16_t query_type;
+static u8_t query_question[DNS_MAX_NAME_LENGTH + SIZEOF_DNS_HDR];
+static u16_t query_question_len;
+
+/* results passed to the found callback */
+static u32_t found_cnt;
+static ip_addr_t found_addr;
+static u8_t found_addr_valid;
+/* if nonzero, responses are split into pbufs of this many bytes behind the UDP header */
+static u16_t response_frag_len;
+
+static err_t
+test_dns_netif_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  u8_t buf[512];
+  u16_t len, iphlen, idx;
+
+  LWIP_UNUSED_ARG(netif);
+  fail_unless(ip4_addr_cmp(ipaddr, &test_dns_server));
+
+  len = pbuf_copy_partial(p, buf, sizeof(buf), 0);
+  iphlen = (u16_t)((buf[0] & 0x0f) * 4);
+  fail_unless(len > iphlen + UDP_HLEN + SIZEOF_DNS_HDR);
+  fail_unless(buf[9] == IP_PROTO_UDP);
+  query_port = (u16_t)((buf[iphlen] << 8) | buf[iphlen + 1]);
+  fail_unless(((buf[iphlen + 2] << 8) | buf[iphlen + 3]) == DNS_SERVER_PORT);
+
+  idx = (u16_t)(iphlen + UDP_HLEN);
+  query_txid = (u16_t)((buf[idx] << 8) | buf[idx + 1]);
+  idx = (u16_t)(idx + SIZEOF_DNS_HDR);
+  /* question: encoded name, type and class */
+  query_question_len = 0;
+  while ((idx + query_question_len < len) && (buf[idx + query_question_len] != 0)) {
+    query_question_len = (u16_t)(query_question_len + buf[idx + query_question_len] + 1);
+  }
+  query_question_len = (u16_t)(query_question_len + 1 + 4);
+  fail_unless(idx + query_question_len <= len);
+  fail_unless(query_question_len <= sizeof(query_question));
+  MEMCPY(query_question, &buf[idx], query_question_len);
+  query_type = (u16_t)((query_question[query_question_len - 4] << 8) | query_question[query_question_len - 3]);
+  query_cnt++;
+  return ERR_OK;
+}
+
+static err_t
+test_dns_netif_init(struct netif *netif)
+{
+  netif->output = test_dns_netif_output;
+  netif->mtu = 1500;
+  netif->flags = NETIF_FLAG_LINK_UP;
+  return ERR_OK;
+}
+
+#define TEST_DNS_ANSWER_NONE 0
+#define TEST_DNS_ANSWER_ADDR 1
+#define TEST_DNS_ANSWER_SOA  2
+
+/**
+ * Answer the last query.
+ * @param rcode DNS_FLAG2_ERR_NONE or DNS_FLAG2_ERR_NAME
+ * @param answer TEST_DNS_ANSWER_ADDR: one A/AAAA record matching the query,
+ *        TEST_DNS_ANSWER_SOA: SOA record in the authority section
+ */
+static void
+test_dns_respond(u8_t rcode, u8_t answer, u32_t ttl, const ip_addr_t *addr, u32_t soa_minimum)
+{
+  u8_t buf[512];
+  u16_t idx, udplen;
+  struct pbuf *p;
+  err_t err;
+
+  memset(buf, 0, sizeof(buf));
+  /* IPv4 header */
+  buf[0] = 0x45;
+  buf[8] = 64;
+  buf[9] = IP_PROTO_UDP;
+  MEMCPY(&buf[12], &test_dns_server, 4);
+  MEMCPY(&buf[16], &test_ipaddr, 4);
+  /* UDP header, checksum 0 */
+  buf[20] = DNS_SERVER_PORT >> 8;
+  buf[21] = DNS_SERVER_PORT & 0xff;
+  buf[22] = (u8_t)(query_port >> 8);
+  buf[23] = (u8_t)query_port;
+  /* DNS header */
+  idx = 28;
+  buf[idx] = (u8_t)(query_txid >> 8);
+  buf[idx + 1] = (u8_t)query_txid;
+  buf[idx + 2] = DNS_FLAG1_RESPONSE | DNS_FLAG1_RD;
+  buf[idx + 3] = (u8_t)(DNS_FLAG2_RA | rcode);
+  buf[idx + 5] = 1;
+  buf[idx + 7] = (answer == TEST_DNS_ANSWER_ADDR) ? 1 : 0;
+  buf[idx + 9] = (answer == TEST_DNS_ANSWER_SOA) ? 1 : 0;
+  idx = (u16_t)(idx + SIZEOF_DNS_HDR);
+  MEMCPY(&buf[idx], query_question, query_question_len);
+  idx = (u16_t)(idx + query_question_len);
+  if (answer != TEST_DNS_ANSWER_NONE) {
+    /* owner: pointer to the question name */
+    buf[idx++] = 0xc0;
+    buf[idx++] = SIZEOF_DNS_HDR;
+    buf[idx++] = 0;
+    buf[idx++] = (u8_t)((answer == TEST_DNS_ANSWER_SOA) ? DNS_RRTYPE_SOA : query_type);
+    buf[idx++] = 0;
+    buf[idx++] = DNS_RRCLASS_IN;
+    buf[idx++] = (u8_t)(ttl >> 24);
+    buf[idx++] = (u8_t)(ttl >> 16);
+    buf[idx++] = (u8_t)(ttl >> 8);
+    buf[idx++] = (u8_t)ttl;
+    if (answer == TEST_DNS_ANSWER_SOA) {
+      /* root MNAME and RNAME, serial, refresh, retry, expire, minimum */
+      buf[idx++] = 0;
+      buf[idx++] = 22;
+      idx = (u16_t)(idx + 2 + 16);
+      buf[idx++] = (u8_t)(soa_minimum >> 24);
+      buf[idx++] = (u8_t)(soa_minimum >> 16);
+      buf[idx++] = (u8_t)(soa_minimum >> 8);
+      buf[idx++] = (u8_t)soa_minimum;
+    } else if (IP_IS_V6(addr)) {
+      fail_unless(query_type == DNS_RRTYPE_AAAA);
+      buf[idx++] = 0;
+      buf[idx++] = 16;
+      MEMCPY(&buf[idx], ip_2_ip6(addr)->addr, 16);
+      idx = (u16_t)(idx + 16);
+    } else {
+      fail_unless(query_type == DNS_RRTYPE_A);
+      buf[idx++] = 0;
+      buf[idx++] = 4;
+      MEMCPY(&buf[idx], ip_2_ip4(addr), 4);
+      idx = (u16_t)(idx + 4);
+    }
+  }
+  udplen = (u16_t)(idx - 20);
+  buf[24] = (u8_t)(udplen >> 8);
+  buf[25] = (u8_t)udplen;
+  buf[2] = (u8_t)(idx >> 8);
+  buf[3] = (u8_t)idx;
+  {
+    u16_t chksum = inet_chksum(buf, 20);
+    MEMCPY(&buf[10], &chksum, 2);
+  }
+
+  if (response_frag_len == 0) {
+    p = pbuf_alloc(PBUF_RAW, idx, PBUF_POOL);
+    fail_unless(p != NULL);
+    if (p != NULL) {
+      pbuf_take(p, buf, idx);
+    }
+  } else {
+    u16_t off;
+    p = pbuf_alloc(PBUF_RAW, 28, PBUF_RAM);
+    fail_unless(p != NULL);
+    pbuf_take(p, buf, 28);
+    for (off = 28; off < idx; off = (u16_t)(off + response_frag_len)) {
+      struct pbuf *q = pbuf_alloc(PBUF_RAW, LWIP_MIN(response_frag_len, idx - off), PBUF_RAM);
+      fail_unless(q != NULL);
+      pbuf_take(q, &buf[off], q->len);
+      pbuf_cat(p, q);
+    }
+  }
+  if (p != NULL) {
+    err = ip4_input(p, &test_netif);
+    fail_unless(err == ERR_OK);
+  }
+}
+
+static void
+test_dns_found(const char *name, const ip_addr_t *ipaddr, void *arg)
+{
+  LWIP_UNUSED_ARG(name);
+  LWIP_UNUSED_ARG(arg);
+  found_cnt++;
+  found_addr_valid = (ipaddr != NULL);
+  if (ipaddr != NULL) {
+    ip_addr_copy(found_addr, *ipaddr);
+  }
+}
+
+static void
+test_dns_tick(int seconds)
+{
+  for (; seconds > 0; seconds--) {
+    dns_tmr();
+  }
+}
+
+/* resolve a name through the fake server */
+static void
+test_dns_resolve(const char *name, const ip_addr_t *answer, u32_t ttl)
+{
+  ip_addr_t addr;
+  u32_t queries = query_cnt;
+  u32_t found = found_cnt;
+  err_t err;
+
+  err = dns_gethostbyname(name, &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_INPROGRESS);
+  fail_unless(query_cnt == queries + 1);
+  test_dns_respond(DNS_FLAG2_ERR_NONE, TEST_DNS_ANSWER_ADDR, ttl, answer, 0);
+  fail_unless(found_cnt == found + 1);
+  fail_unless(found_addr_valid);
+  fail_unless(ip_addr_cmp(&found_addr, answer));
+}
+
+/* Setups/teardown functions */
+
+static void
+dns_setup(void)
+{
+  ip_addr_t server;
+
+  IP4_ADDR(&test_ipaddr, 192, 168, 0, 1);
+  IP4_ADDR(&test_netmask, 255, 255, 255, 0);
+  IP4_ADDR(&test_gw, 192, 168, 0, 254);
+  IP4_ADDR(&test_dns_server, 192, 168, 0, 53);
+  fail_unless(netif_add(&test_netif, &test_ipaddr, &test_netmask, &test_gw,
+                        NULL, test_dns_netif_init, ip4_input) == &test_netif);
+  netif_set_default(&test_netif);
+  netif_set_up(&test_netif);
+
+  ip_addr_copy_from_ip4(server, test_dns_server);
+  dns_setserver(0, &server);
+  dns_cache_flush();
+  query_cnt = 0;
+  found_cnt = 0;
+  response_frag_len = 0;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+dns_teardown(void)
+{
+  dns_setserver(0, NULL);
+  dns_cache_flush();
+  netif_set_default(NULL);
+  netif_remove(&test_netif);
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* Test functions */
+
+/* answers are served from the cache until their TTL expires */
+START_TEST(test_dns_cache_ttl)
+{
+  ip_addr_t answer = IPADDR4_INIT_BYTES(10, 0, 0, 1);
+  ip_addr_t addr;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_dns_resolve("www.example.com", &answer, 600);
+
+  /* cached, also with different case */
+  err = dns_gethostbyname("www.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_OK);
+  fail_unless(ip_addr_cmp(&addr, &answer));
+  err = dns_gethostbyname("WWW.Example.COM", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_OK);
+  fail_unless(query_cnt == 1);
+
+  /* TTL 0: not cached */
+  test_dns_resolve("other.example.com", &answer, 0);
+  err = dns_gethostbyname("other.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_INPROGRESS);
+  test_dns_respond(DNS_FLAG2_ERR_NONE, TEST_DNS_ANSWER_ADDR, 0, &answer, 0);
+  fail_unless(query_cnt == 3);
+
+  /* used only in its last second: expires instead of being prefetched */
+  test_dns_resolve("ttl.example.com", &answer, 60);
+  test_dns_tick(59);
+  fail_unless(query_cnt == 4);
+  err = dns_gethostbyname("ttl.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_OK);
+  /* ...and expires */
+  test_dns_tick(1);
+  fail_unless(query_cnt == 4);
+  err = dns_gethostbyname("ttl.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_INPROGRESS);
+  fail_unless(query_cnt == 5);
+  test_dns_respond(DNS_FLAG2_ERR_NONE, TEST_DNS_ANSWER_ADDR, 60, &answer, 0);
+}
+END_TEST
+
+/* failed lookups are cached for the SOA minimum or DNS_CACHE_NEG_TTL */
+START_TEST(test_dns_cache_negative)
+{
+  ip_addr_t answer6 = IPADDR6_INIT_HOST(0x20010db8, 0, 0, 1);
+  ip_addr_t addr;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  /* NXDOMAIN with SOA */
+  err = dns_gethostbyname("nx.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_INPROGRESS);
+  test_dns_respond(DNS_FLAG2_ERR_NAME, TEST_DNS_ANSWER_SOA, 300, NULL, 20);
+  fail_unless(found_cnt == 1);
+  fail_unless(!found_addr_valid);
+  err = dns_gethostbyname("nx.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_VAL);
+  err = dns_gethostbyname_addrtype("nx.example.com", &addr, test_dns_found, NULL, LWIP_DNS_ADDRTYPE_IPV6);
+  fail_unless(err == ERR_VAL);
+  fail_unless(query_cnt == 1);
+  test_dns_tick(19);
+  err = dns_gethostbyname("nx.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_VAL);
+  test_dns_tick(1);
+
+  /* NXDOMAIN without SOA */
+  err = dns_gethostbyname("nx.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_INPROGRESS);
+  fail_unless(query_cnt == 2);
+  test_dns_respond(DNS_FLAG2_ERR_NAME, TEST_DNS_ANSWER_NONE, 0, NULL, 0);
+  test_dns_tick(DNS_CACHE_NEG_TTL - 1);
+  err = dns_gethostbyname("nx.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_VAL);
+  test_dns_tick(1);
+  err = dns_gethostbyname("nx.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_INPROGRESS);
+  fail_unless(query_cnt == 3);
+  test_dns_respond(DNS_FLAG2_ERR_NAME, TEST_DNS_ANSWER_NONE, 0, NULL, 0);
+
+  /* no IPv4 address: falls back to IPv6 */
+  err = dns_gethostbyname("v6.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_INPROGRESS);
+  fail_unless(query_type == DNS_RRTYPE_A);
+  test_dns_respond(DNS_FLAG2_ERR_NONE, TEST_DNS_ANSWER_NONE, 0, NULL, 0);
+  fail_unless(query_cnt == 5);
+  fail_unless(query_type == DNS_RRTYPE_AAAA);
+  test_dns_respond(DNS_FLAG2_ERR_NONE, TEST_DNS_ANSWER_ADDR, 5, &answer6, 0);
+  fail_unless(found_addr_valid);
+  fail_unless(ip_addr_cmp(&found_addr, &answer6));
+
+  /* the IPv6 address expired, IPv4 is still known to fail: only AAAA is asked */
+  test_dns_tick(5);
+  err = dns_gethostbyname("v6.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_INPROGRESS);
+  fail_unless(query_cnt == 6);
+  fail_unless(query_type == DNS_RRTYPE_AAAA);
+  test_dns_respond(DNS_FLAG2_ERR_NONE, TEST_DNS_ANSWER_ADDR, 30, &answer6, 0);
+  fail_unless(ip_addr_cmp(&found_addr, &answer6));
+
+  err = dns_gethostbyname("v6.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_OK);
+  fail_unless(ip_addr_cmp(&addr, &answer6));
+  err = dns_gethostbyname_addrtype("v6.example.com", &addr, test_dns_found, NULL, LWIP_DNS_ADDRTYPE_IPV4);
+  fail_unless(err == ERR_VAL);
+  fail_unless(query_cnt == 6);
+}
+END_TEST
+
+/* names used while cached are refreshed before they expire */
+START_TEST(test_dns_cache_prefetch)
+{
+  ip_addr_t answer1 = IPADDR4_INIT_BYTES(10, 0, 0, 1);
+  ip_addr_t answer2 = IPADDR4_INIT_BYTES(10, 0, 0, 2);
+  ip_addr_t addr;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_dns_resolve("hot.example.com", &answer1, 30);
+  err = dns_gethostbyname("hot.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_OK);
+
+  test_dns_tick(30 - DNS_CACHE_PREFETCH_TTL - 1);
+  fail_unless(query_cnt == 1);
+  test_dns_tick(1);
+  fail_unless(query_cnt == 2);
+  fail_unless(query_type == DNS_RRTYPE_A);
+  /* still served from the cache while the refresh is pending */
+  err = dns_gethostbyname("hot.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_OK);
+  fail_unless(ip_addr_cmp(&addr, &answer1));
+
+  test_dns_respond(DNS_FLAG2_ERR_NONE, TEST_DNS_ANSWER_ADDR, 30, &answer2, 0);
+  err = dns_gethostbyname("hot.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_OK);
+  fail_unless(ip_addr_cmp(&addr, &answer2));
+  fail_unless(query_cnt == 2);
+  fail_unless(found_cnt == 1);
+
+  /* refreshed TTL */
+  test_dns_tick(30 - DNS_CACHE_PREFETCH_TTL - 1);
+  fail_unless(query_cnt == 2);
+  test_dns_tick(1);
+  fail_unless(query_cnt == 3);
+  test_dns_respond(DNS_FLAG2_ERR_NONE, TEST_DNS_ANSWER_ADDR, 30, &answer2, 0);
+
+  /* not used any more: expires */
+  test_dns_tick(30);
+  fail_unless(query_cnt == 3);
+  err = dns_gethostbyname("hot.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_INPROGRESS);
+  test_dns_respond(DNS_FLAG2_ERR_NONE, TEST_DNS_ANSWER_ADDR, 30, &answer2, 0);
+}
+END_TEST
+
+/* a full cache replaces the least recently used name */
+START_TEST(test_dns_cache_evict)
+{
+  ip_addr_t answer = IPADDR4_INIT_BYTES(10, 0, 0, 1);
+  ip_addr_t addr;
+  char name[] = "host?.example.com";
+  err_t err;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < DNS_CACHE_SIZE; i++) {
+    name[4] = (char)('a' + i);
+    test_dns_resolve(name, &answer, 600);
+  }
+  err = dns_gethostbyname("hosta.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_OK);
+  test_dns_resolve("new.example.com", &answer, 600);
+
+  err = dns_gethostbyname("hosta.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_OK);
+  for (i = 2; i < DNS_CACHE_SIZE; i++) {
+    name[4] = (char)('a' + i);
+    err = dns_gethostbyname(name, &addr, test_dns_found, NULL);
+    fail_unless(err == ERR_OK);
+  }
+  err = dns_gethostbyname("new.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_OK);
+  fail_unless(query_cnt == DNS_CACHE_SIZE + 1);
+  /* hostb was evicted */
+  test_dns_resolve("hostb.example.com", &answer, 600);
+}
+END_TEST
+
+/* responses split over many pbufs are parsed like contiguous ones */
+START_TEST(test_dns_fragmented_response)
+{
+  ip_addr_t answer = IPADDR4_INIT_BYTES(10, 0, 0, 2);
+  ip_addr_t addr;
+  err_t err;
+  u16_t frag;
+  char name[] = "frag?.example.com";
+  LWIP_UNUSED_ARG(_i);
+
+  for (frag = 1; frag <= 7; frag++) {
+    response_frag_len = frag;
+    name[4] = (char)('0' + frag);
+    test_dns_resolve(name, &answer, 600);
+  }
+  /* negative answer: the SOA record is parsed, too */
+  response_frag_len = 1;
+  err = dns_gethostbyname("nx.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_INPROGRESS);
+  test_dns_respond(DNS_FLAG2_ERR_NAME, TEST_DNS_ANSWER_SOA, 300, NULL, 20);
+  fail_unless(!found_addr_valid);
+  test_dns_tick(19);
+  err = dns_gethostbyname("nx.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_VAL);
+  test_dns_tick(1);
+  err = dns_gethostbyname("nx.example.com", &addr, test_dns_found, NULL);
+  fail_unless(err == ERR_INPROGRESS);
+  test_dns_respond(DNS_FLAG2_ERR_NONE, TEST_DNS_ANSWER_ADDR, 600, &answer, 0);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+dns_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_dns_cache_ttl),
+    TESTFUNC(test_dns_cache_negative),
+    TESTFUNC(test_dns_cache_prefetch),
+    TESTFUNC(test_dns_cache_evict),
+    TESTFUNC(test_dns_fragmented_response)
+  };
+  return create_suite("DNS", tests, sizeof(tests)/sizeof(testfunc), dns_setup, dns_teardown);
+}
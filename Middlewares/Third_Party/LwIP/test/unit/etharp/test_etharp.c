@@ -260,13 +260,69 @@ START_TEST(test_etharp_table)
 }
 END_TEST
 
+#if ETHARP_SUPPORT_STATIC_ENTRIES
+/* add and remove entries in varying order and check every lookup */
+START_TEST(test_etharp_table_churn)
+{
+  ip4_addr_t adrs[ARP_TABLE_SIZE], adr;
+  u8_t present[ARP_TABLE_SIZE];
+  const ip4_addr_t *ip_ret;
+  struct eth_addr *eth_ret;
+  u32_t rnd = 4711;
+  int round, i, k;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(adrs, 0, sizeof(adrs));
+  memset(present, 0, sizeof(present));
+  for (round = 0; round < 200; round++) {
+    rnd = rnd * 1103515245 + 12345;
+    i = (int)((rnd >> 16) % ARP_TABLE_SIZE);
+    if (present[i]) {
+      fail_unless(etharp_remove_static_entry(&adrs[i]) == ERR_OK);
+      present[i] = 0;
+    } else {
+      /* few distinct host bits so that addresses collide in the index */
+      IP4_ADDR(&adr, 192, 168, (u8_t)((rnd >> 8) & 3), (u8_t)(2 + ((rnd >> 24) & 0x3f)));
+      for (k = 0; k < ARP_TABLE_SIZE; k++) {
+        if (ip4_addr_cmp(&adrs[k], &adr)) {
+          break;
+        }
+      }
+      if (k < ARP_TABLE_SIZE) {
+        continue;
+      }
+      ip4_addr_copy(adrs[i], adr);
+      fail_unless(etharp_add_static_entry(&adrs[i], &test_ethaddr3) == ERR_OK);
+      present[i] = 1;
+    }
+    for (k = 0; k < ARP_TABLE_SIZE; k++) {
+      ssize_t idx = etharp_find_addr(NULL, &adrs[k], &eth_ret, &ip_ret);
+      if (present[k]) {
+        fail_unless(idx >= 0);
+        fail_unless(ip4_addr_cmp(ip_ret, &adrs[k]));
+      } else {
+        fail_unless(idx == -1);
+      }
+    }
+  }
+  for (i = 0; i < ARP_TABLE_SIZE; i++) {
+    if (present[i]) {
+      fail_unless(etharp_remove_static_entry(&adrs[i]) == ERR_OK);
+    }
+  }
+}
+END_TEST
+#endif /* ETHARP_SUPPORT_STATIC_ENTRIES */
 
 /** Create the suite including all tests for this module */
 Suite *
 etharp_suite(void)
 {
   testfunc tests[] = {
-    TESTFUNC(test_etharp_table)
+    TESTFUNC(test_etharp_table),
+#if ETHARP_SUPPORT_STATIC_ENTRIES
+    TESTFUNC(test_etharp_table_churn),
+#endif /* ETHARP_SUPPORT_STATIC_ENTRIES */
   };
   return create_suite("ETHARP", tests, sizeof(tests)/sizeof(testfunc), etharp_setup, etharp_teardown);
 }
@@ -0,0 +1,548 @@
+#include "lwip/apps/fs.h"
+#include "lwip/def.h"
+
+
+#define file_NULL (struct fsdata_file *) NULL
+
+
+#ifndef FS_FILE_FLAGS_HEADER_INCLUDED
+#define FS_FILE_FLAGS_HEADER_INCLUDED 1
+#endif
+#ifndef FS_FILE_FLAGS_HEADER_PERSISTENT
+#define FS_FILE_FLAGS_HEADER_PERSISTENT 0
+#endif
+/* FSDATA_FILE_ALIGNMENT: 0=off, 1=by variable, 2=by include */
+#ifndef FSDATA_FILE_ALIGNMENT
+#define FSDATA_FILE_ALIGNMENT 0
+#endif
+#ifndef FSDATA_ALIGN_PRE
+#define FSDATA_ALIGN_PRE
+#endif
+#ifndef FSDATA_ALIGN_POST
+#define FSDATA_ALIGN_POST
+#endif
+#if FSDATA_FILE_ALIGNMENT==2
+#include "fsdata_alignment.h"
+#endif
+#if FSDATA_FILE_ALIGNMENT==1
+static const unsigned int dummy_align__404_html = 0;
+#endif
+static const unsigned char FSDATA_ALIGN_PRE data__404_html[] FSDATA_ALIGN_POST = {
+/* /404.html (10 chars) */
+0x2f,0x34,0x30,0x34,0x2e,0x68,0x74,0x6d,0x6c,0x00,0x00,0x00,
+
+/* HTTP header */
+/* "HTTP/1.1 404 File not found
+" (29 bytes) */
+0x48,0x54,0x54,0x50,0x2f,0x31,0x2e,0x31,0x20,0x34,0x30,0x34,0x20,0x46,0x69,0x6c,
+0x65,0x20,0x6e,0x6f,0x74,0x20,0x66,0x6f,0x75,0x6e,0x64,0x0d,0x0a,
+/* "Server: lwIP/2.1.2 (http://savannah.nongnu.org/projects/lwip)
+" (63 bytes) */
+0x53,0x65,0x72,0x76,0x65,0x72,0x3a,0x20,0x6c,0x77,0x49,0x50,0x2f,0x32,0x2e,0x31,
+0x2e,0x32,0x20,0x28,0x68,0x74,0x74,0x70,0x3a,0x2f,0x2f,0x73,0x61,0x76,0x61,0x6e,
+0x6e,0x61,0x68,0x2e,0x6e,0x6f,0x6e,0x67,0x6e,0x75,0x2e,0x6f,0x72,0x67,0x2f,0x70,
+0x72,0x6f,0x6a,0x65,0x63,0x74,0x73,0x2f,0x6c,0x77,0x69,0x70,0x29,0x0d,0x0a,
+/* "Content-Length: 50
+" (18+ bytes) */
+0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x4c,0x65,0x6e,0x67,0x74,0x68,0x3a,0x20,
+0x35,0x30,0x0d,0x0a,
+/* "Connection: keep-alive
+" (24 bytes) */
+0x43,0x6f,0x6e,0x6e,0x65,0x63,0x74,0x69,0x6f,0x6e,0x3a,0x20,0x6b,0x65,0x65,0x70,
+0x2d,0x61,0x6c,0x69,0x76,0x65,0x0d,0x0a,
+/* "Content-Type: text/html
+
+" (27 bytes) */
+0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x54,0x79,0x70,0x65,0x3a,0x20,0x74,0x65,
+0x78,0x74,0x2f,0x68,0x74,0x6d,0x6c,0x0d,0x0a,0x0d,0x0a,
+/* raw file data (50 bytes) */
+0x3c,0x68,0x74,0x6d,0x6c,0x3e,0x3c,0x62,0x6f,0x64,0x79,0x3e,0x3c,0x68,0x32,0x3e,
+0x34,0x30,0x34,0x3a,0x20,0x6e,0x6f,0x74,0x20,0x66,0x6f,0x75,0x6e,0x64,0x3c,0x2f,
+0x68,0x32,0x3e,0x3c,0x2f,0x62,0x6f,0x64,0x79,0x3e,0x3c,0x2f,0x68,0x74,0x6d,0x6c,
+0x3e,0x0a,};
+
+#if LWIP_HTTPD_PRECOMPRESSED
+#if FSDATA_FILE_ALIGNMENT==1
+static const unsigned int dummy_align__index_html_gz = 1;
+#endif
+static const unsigned char FSDATA_ALIGN_PRE data__index_html_gz[] FSDATA_ALIGN_POST = {
+/* /index.html (12 chars) */
+0x2f,0x69,0x6e,0x64,0x65,0x78,0x2e,0x68,0x74,0x6d,0x6c,0x00,
+
+/* HTTP header */
+/* "HTTP/1.1 200 OK
+" (17 bytes) */
+0x48,0x54,0x54,0x50,0x2f,0x31,0x2e,0x31,0x20,0x32,0x30,0x30,0x20,0x4f,0x4b,0x0d,
+0x0a,
+/* "Server: lwIP/2.1.2 (http://savannah.nongnu.org/projects/lwip)
+" (63 bytes) */
+0x53,0x65,0x72,0x76,0x65,0x72,0x3a,0x20,0x6c,0x77,0x49,0x50,0x2f,0x32,0x2e,0x31,
+0x2e,0x32,0x20,0x28,0x68,0x74,0x74,0x70,0x3a,0x2f,0x2f,0x73,0x61,0x76,0x61,0x6e,
+0x6e,0x61,0x68,0x2e,0x6e,0x6f,0x6e,0x67,0x6e,0x75,0x2e,0x6f,0x72,0x67,0x2f,0x70,
+0x72,0x6f,0x6a,0x65,0x63,0x74,0x73,0x2f,0x6c,0x77,0x69,0x70,0x29,0x0d,0x0a,
+/* "Content-Length: 274
+" (18+ bytes) */
+0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x4c,0x65,0x6e,0x67,0x74,0x68,0x3a,0x20,
+0x32,0x37,0x34,0x0d,0x0a,
+/* "Connection: keep-alive
+" (24 bytes) */
+0x43,0x6f,0x6e,0x6e,0x65,0x63,0x74,0x69,0x6f,0x6e,0x3a,0x20,0x6b,0x65,0x65,0x70,
+0x2d,0x61,0x6c,0x69,0x76,0x65,0x0d,0x0a,
+/* "Content-Encoding: gzip
+" (24 bytes) */
+0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x45,0x6e,0x63,0x6f,0x64,0x69,0x6e,0x67,
+0x3a,0x20,0x67,0x7a,0x69,0x70,0x0d,0x0a,
+/* "Vary: Accept-Encoding
+" (23 bytes) */
+0x56,0x61,0x72,0x79,0x3a,0x20,0x41,0x63,0x63,0x65,0x70,0x74,0x2d,0x45,0x6e,0x63,
+0x6f,0x64,0x69,0x6e,0x67,0x0d,0x0a,
+/* "ETag: "ae99c29b-112"
+" (22 bytes) */
+0x45,0x54,0x61,0x67,0x3a,0x20,0x22,0x61,0x65,0x39,0x39,0x63,0x32,0x39,0x62,0x2d,
+0x31,0x31,0x32,0x22,0x0d,0x0a,
+/* "Content-Type: text/html
+
+" (27 bytes) */
+0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x54,0x79,0x70,0x65,0x3a,0x20,0x74,0x65,
+0x78,0x74,0x2f,0x68,0x74,0x6d,0x6c,0x0d,0x0a,0x0d,0x0a,
+/* raw file data (274 bytes) */
+0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0xad,0xd6,0x3d,0x6e,0xc3,0x30,
+0x0c,0x86,0xe1,0x3d,0xa7,0x10,0x7c,0x80,0xb8,0x24,0xfb,0x0f,0x55,0x7b,0xb7,0x5c,
+0x41,0x8d,0x99,0xc8,0xa8,0x12,0x1b,0x22,0x91,0x22,0xb7,0xaf,0xeb,0x76,0xca,0x58,
+0x7c,0x8b,0x04,0x48,0xc0,0xab,0xe5,0x81,0xc0,0x58,0xfc,0x54,0x53,0x2c,0x9a,0x87,
+0x14,0x7d,0xf4,0xaa,0xa9,0x7e,0xbd,0xef,0xc2,0xdc,0x74,0x3f,0x9d,0x96,0xd5,0x4c,
+0x87,0xe0,0x6a,0x1e,0xfb,0xdf,0xeb,0x58,0xc7,0xf3,0x67,0x68,0x5a,0xdf,0x3a,0xf3,
+0x6b,0x55,0x2b,0xaa,0xde,0x85,0xd2,0xf4,0xf0,0x77,0xb2,0xdd,0x9b,0x75,0x29,0xf6,
+0x6b,0x74,0x13,0x3f,0xa6,0xe1,0xba,0x6c,0x73,0xda,0xe5,0x96,0x8f,0x2d,0xcf,0x25,
+0xdc,0xbd,0x86,0xf5,0x15,0xd3,0x76,0x51,0xbb,0x79,0xec,0x92,0xdb,0x98,0xcf,0x6e,
+0x61,0x3a,0x04,0x2f,0xe3,0x72,0x9d,0x8f,0xba,0x8d,0xfd,0x7c,0x13,0x21,0x44,0x84,
+0x11,0x11,0x41,0x44,0xee,0x11,0x91,0x07,0x44,0xe4,0x11,0x11,0x79,0x42,0x44,0x9e,
+0x11,0x91,0x17,0x08,0x36,0x0c,0x59,0x88,0x59,0x82,0xa0,0x25,0x88,0x5a,0x82,0xb0,
+0x25,0x88,0x5b,0x82,0xc0,0x25,0x88,0x5c,0x82,0xd0,0x25,0x88,0x5d,0x86,0xd8,0x65,
+0xcc,0x7f,0x0b,0xb1,0xcb,0x10,0xbb,0x0c,0xb1,0xcb,0x10,0xbb,0x0c,0xb1,0xcb,0x10,
+0xbb,0x0c,0xb1,0xcb,0x10,0xbb,0x02,0xb1,0x2b,0x10,0xbb,0x82,0x19,0x16,0x20,0x76,
+0x05,0x62,0x57,0x20,0x76,0x05,0x62,0x57,0x20,0x76,0x05,0x62,0x57,0xfe,0x6d,0xb7,
+0x5f,0xa7,0xdd,0x65,0xf6,0xfd,0x19,0xab,0x37,0xdf,0x55,0x6a,0x41,0xf4,0x5e,0x0b,
+0x00,0x00,};
+
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+
+#if LWIP_HTTPD_PRECOMPRESSED
+#if FSDATA_FILE_ALIGNMENT==1
+static const unsigned int dummy_align__index_html_deflate = 2;
+#endif
+static const unsigned char FSDATA_ALIGN_PRE data__index_html_deflate[] FSDATA_ALIGN_POST = {
+/* /index.html (12 chars) */
+0x2f,0x69,0x6e,0x64,0x65,0x78,0x2e,0x68,0x74,0x6d,0x6c,0x00,
+
+/* HTTP header */
+/* "HTTP/1.1 200 OK
+" (17 bytes) */
+0x48,0x54,0x54,0x50,0x2f,0x31,0x2e,0x31,0x20,0x32,0x30,0x30,0x20,0x4f,0x4b,0x0d,
+0x0a,
+/* "Server: lwIP/2.1.2 (http://savannah.nongnu.org/projects/lwip)
+" (63 bytes) */
+0x53,0x65,0x72,0x76,0x65,0x72,0x3a,0x20,0x6c,0x77,0x49,0x50,0x2f,0x32,0x2e,0x31,
+0x2e,0x32,0x20,0x28,0x68,0x74,0x74,0x70,0x3a,0x2f,0x2f,0x73,0x61,0x76,0x61,0x6e,
+0x6e,0x61,0x68,0x2e,0x6e,0x6f,0x6e,0x67,0x6e,0x75,0x2e,0x6f,0x72,0x67,0x2f,0x70,
+0x72,0x6f,0x6a,0x65,0x63,0x74,0x73,0x2f,0x6c,0x77,0x69,0x70,0x29,0x0d,0x0a,
+/* "Content-Length: 262
+" (18+ bytes) */
+0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x4c,0x65,0x6e,0x67,0x74,0x68,0x3a,0x20,
+0x32,0x36,0x32,0x0d,0x0a,
+/* "Connection: keep-alive
+" (24 bytes) */
+0x43,0x6f,0x6e,0x6e,0x65,0x63,0x74,0x69,0x6f,0x6e,0x3a,0x20,0x6b,0x65,0x65,0x70,
+0x2d,0x61,0x6c,0x69,0x76,0x65,0x0d,0x0a,
+/* "Content-Encoding: deflate
+" (27 bytes) */
+0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x45,0x6e,0x63,0x6f,0x64,0x69,0x6e,0x67,
+0x3a,0x20,0x64,0x65,0x66,0x6c,0x61,0x74,0x65,0x0d,0x0a,
+/* "Vary: Accept-Encoding
+" (23 bytes) */
+0x56,0x61,0x72,0x79,0x3a,0x20,0x41,0x63,0x63,0x65,0x70,0x74,0x2d,0x45,0x6e,0x63,
+0x6f,0x64,0x69,0x6e,0x67,0x0d,0x0a,
+/* "ETag: "11383878-106"
+" (22 bytes) */
+0x45,0x54,0x61,0x67,0x3a,0x20,0x22,0x31,0x31,0x33,0x38,0x33,0x38,0x37,0x38,0x2d,
+0x31,0x30,0x36,0x22,0x0d,0x0a,
+/* "Content-Type: text/html
+
+" (27 bytes) */
+0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x54,0x79,0x70,0x65,0x3a,0x20,0x74,0x65,
+0x78,0x74,0x2f,0x68,0x74,0x6d,0x6c,0x0d,0x0a,0x0d,0x0a,
+/* raw file data (262 bytes) */
+0x78,0xda,0xad,0xd6,0x3d,0x6e,0xc3,0x30,0x0c,0x86,0xe1,0x3d,0xa7,0x10,0x7c,0x80,
+0xb8,0x24,0xfb,0x0f,0x55,0x7b,0xb7,0x5c,0x41,0x8d,0x99,0xc8,0xa8,0x12,0x1b,0x22,
+0x91,0x22,0xb7,0xaf,0xeb,0x76,0xca,0x58,0x7c,0x8b,0x04,0x48,0xc0,0xab,0xe5,0x81,
+0xc0,0x58,0xfc,0x54,0x53,0x2c,0x9a,0x87,0x14,0x7d,0xf4,0xaa,0xa9,0x7e,0xbd,0xef,
+0xc2,0xdc,0x74,0x3f,0x9d,0x96,0xd5,0x4c,0x87,0xe0,0x6a,0x1e,0xfb,0xdf,0xeb,0x58,
+0xc7,0xf3,0x67,0x68,0x5a,0xdf,0x3a,0xf3,0x6b,0x55,0x2b,0xaa,0xde,0x85,0xd2,0xf4,
+0xf0,0x77,0xb2,0xdd,0x9b,0x75,0x29,0xf6,0x6b,0x74,0x13,0x3f,0xa6,0xe1,0xba,0x6c,
+0x73,0xda,0xe5,0x96,0x8f,0x2d,0xcf,0x25,0xdc,0xbd,0x86,0xf5,0x15,0xd3,0x76,0x51,
+0xbb,0x79,0xec,0x92,0xdb,0x98,0xcf,0x6e,0x61,0x3a,0x04,0x2f,0xe3,0x72,0x9d,0x8f,
+0xba,0x8d,0xfd,0x7c,0x13,0x21,0x44,0x84,0x11,0x11,0x41,0x44,0xee,0x11,0x91,0x07,
+0x44,0xe4,0x11,0x11,0x79,0x42,0x44,0x9e,0x11,0x91,0x17,0x08,0x36,0x0c,0x59,0x88,
+0x59,0x82,0xa0,0x25,0x88,0x5a,0x82,0xb0,0x25,0x88,0x5b,0x82,0xc0,0x25,0x88,0x5c,
+0x82,0xd0,0x25,0x88,0x5d,0x86,0xd8,0x65,0xcc,0x7f,0x0b,0xb1,0xcb,0x10,0xbb,0x0c,
+0xb1,0xcb,0x10,0xbb,0x0c,0xb1,0xcb,0x10,0xbb,0x0c,0xb1,0xcb,0x10,0xbb,0x02,0xb1,
+0x2b,0x10,0xbb,0x82,0x19,0x16,0x20,0x76,0x05,0x62,0x57,0x20,0x76,0x05,0x62,0x57,
+0x20,0x76,0x05,0x62,0x57,0xfe,0x6d,0xb7,0x5f,0xa7,0xdd,0x65,0xf6,0xfd,0x19,0xab,
+0x37,0xdf,0x7d,0x27,0xff,0x5a,};
+
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+
+#if FSDATA_FILE_ALIGNMENT==1
+static const unsigned int dummy_align__index_html = 3;
+#endif
+static const unsigned char FSDATA_ALIGN_PRE data__index_html[] FSDATA_ALIGN_POST = {
+/* /index.html (12 chars) */
+0x2f,0x69,0x6e,0x64,0x65,0x78,0x2e,0x68,0x74,0x6d,0x6c,0x00,
+
+/* HTTP header */
+/* "HTTP/1.1 200 OK
+" (17 bytes) */
+0x48,0x54,0x54,0x50,0x2f,0x31,0x2e,0x31,0x20,0x32,0x30,0x30,0x20,0x4f,0x4b,0x0d,
+0x0a,
+/* "Server: lwIP/2.1.2 (http://savannah.nongnu.org/projects/lwip)
+" (63 bytes) */
+0x53,0x65,0x72,0x76,0x65,0x72,0x3a,0x20,0x6c,0x77,0x49,0x50,0x2f,0x32,0x2e,0x31,
+0x2e,0x32,0x20,0x28,0x68,0x74,0x74,0x70,0x3a,0x2f,0x2f,0x73,0x61,0x76,0x61,0x6e,
+0x6e,0x61,0x68,0x2e,0x6e,0x6f,0x6e,0x67,0x6e,0x75,0x2e,0x6f,0x72,0x67,0x2f,0x70,
+0x72,0x6f,0x6a,0x65,0x63,0x74,0x73,0x2f,0x6c,0x77,0x69,0x70,0x29,0x0d,0x0a,
+/* "Content-Length: 2910
+" (18+ bytes) */
+0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x4c,0x65,0x6e,0x67,0x74,0x68,0x3a,0x20,
+0x32,0x39,0x31,0x30,0x0d,0x0a,
+/* "Connection: keep-alive
+" (24 bytes) */
+0x43,0x6f,0x6e,0x6e,0x65,0x63,0x74,0x69,0x6f,0x6e,0x3a,0x20,0x6b,0x65,0x65,0x70,
+0x2d,0x61,0x6c,0x69,0x76,0x65,0x0d,0x0a,
+/* "Vary: Accept-Encoding
+" (23 bytes) */
+0x56,0x61,0x72,0x79,0x3a,0x20,0x41,0x63,0x63,0x65,0x70,0x74,0x2d,0x45,0x6e,0x63,
+0x6f,0x64,0x69,0x6e,0x67,0x0d,0x0a,
+/* "ETag: "ff495129-b5e"
+" (22 bytes) */
+0x45,0x54,0x61,0x67,0x3a,0x20,0x22,0x66,0x66,0x34,0x39,0x35,0x31,0x32,0x39,0x2d,
+0x62,0x35,0x65,0x22,0x0d,0x0a,
+/* "Content-Type: text/html
+
+" (27 bytes) */
+0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x54,0x79,0x70,0x65,0x3a,0x20,0x74,0x65,
+0x78,0x74,0x2f,0x68,0x74,0x6d,0x6c,0x0d,0x0a,0x0d,0x0a,
+/* raw file data (2910 bytes) */
+0x3c,0x68,0x74,0x6d,0x6c,0x3e,0x3c,0x68,0x65,0x61,0x64,0x3e,0x3c,0x74,0x69,0x74,
+0x6c,0x65,0x3e,0x6c,0x77,0x49,0x50,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,
+0x65,0x73,0x73,0x65,0x64,0x20,0x74,0x65,0x73,0x74,0x3c,0x2f,0x74,0x69,0x74,0x6c,
+0x65,0x3e,0x3c,0x6c,0x69,0x6e,0x6b,0x20,0x72,0x65,0x6c,0x3d,0x22,0x73,0x74,0x79,
+0x6c,0x65,0x73,0x68,0x65,0x65,0x74,0x22,0x20,0x68,0x72,0x65,0x66,0x3d,0x22,0x73,
+0x74,0x79,0x6c,0x65,0x2e,0x63,0x73,0x73,0x22,0x3e,0x3c,0x2f,0x68,0x65,0x61,0x64,
+0x3e,0x0a,0x3c,0x62,0x6f,0x64,0x79,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,
+0x67,0x72,0x61,0x70,0x68,0x20,0x30,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,
+0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,
+0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,
+0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,
+0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x31,0x3a,0x20,0x6c,0x77,
+0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,
+0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,
+0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,
+0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,
+0x32,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,
+0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,
+0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,
+0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,
+0x72,0x61,0x70,0x68,0x20,0x33,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,
+0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,
+0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,
+0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,
+0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x34,0x3a,0x20,0x6c,0x77,0x49,
+0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,
+0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,
+0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,
+0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x35,
+0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,
+0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,
+0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,
+0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,
+0x61,0x70,0x68,0x20,0x36,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,
+0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,
+0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,
+0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,
+0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x37,0x3a,0x20,0x6c,0x77,0x49,0x50,
+0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,
+0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,
+0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,
+0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x38,0x3a,
+0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,
+0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,
+0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,
+0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,
+0x70,0x68,0x20,0x39,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,
+0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,
+0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,
+0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,
+0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x31,0x30,0x3a,0x20,0x6c,0x77,0x49,0x50,
+0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,
+0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,
+0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,
+0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x31,0x31,
+0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,
+0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,
+0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,
+0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,
+0x61,0x70,0x68,0x20,0x31,0x32,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,
+0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,
+0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,
+0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,
+0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x31,0x33,0x3a,0x20,0x6c,0x77,
+0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,
+0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,
+0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,
+0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,
+0x31,0x34,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,
+0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,
+0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,
+0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,
+0x67,0x72,0x61,0x70,0x68,0x20,0x31,0x35,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,
+0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,
+0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,
+0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,
+0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x31,0x36,0x3a,0x20,
+0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,
+0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,
+0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,
+0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,
+0x68,0x20,0x31,0x37,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,
+0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,
+0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,
+0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,
+0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x31,0x38,0x3a,0x20,0x6c,0x77,0x49,0x50,
+0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,
+0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,
+0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,
+0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x31,0x39,
+0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,
+0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,
+0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,
+0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,
+0x61,0x70,0x68,0x20,0x32,0x30,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,
+0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,
+0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,
+0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,
+0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x32,0x31,0x3a,0x20,0x6c,0x77,
+0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,
+0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,
+0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,
+0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,
+0x32,0x32,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,
+0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,
+0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,
+0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,
+0x67,0x72,0x61,0x70,0x68,0x20,0x32,0x33,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,
+0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,
+0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,
+0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,
+0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x32,0x34,0x3a,0x20,
+0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,
+0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,
+0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,
+0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,
+0x68,0x20,0x32,0x35,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,
+0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,
+0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,
+0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,
+0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x32,0x36,0x3a,0x20,0x6c,0x77,0x49,0x50,
+0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,
+0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,
+0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,
+0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x32,0x37,
+0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,
+0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,
+0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,
+0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,
+0x61,0x70,0x68,0x20,0x32,0x38,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,
+0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,
+0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,
+0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,
+0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x32,0x39,0x3a,0x20,0x6c,0x77,
+0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,
+0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,
+0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,
+0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,
+0x33,0x30,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,
+0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,
+0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,
+0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,
+0x67,0x72,0x61,0x70,0x68,0x20,0x33,0x31,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,
+0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,
+0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,
+0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,
+0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x33,0x32,0x3a,0x20,
+0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,
+0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,
+0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,
+0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,
+0x68,0x20,0x33,0x33,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,
+0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,
+0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,
+0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,
+0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x33,0x34,0x3a,0x20,0x6c,0x77,0x49,0x50,
+0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,
+0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,
+0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,
+0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x33,0x35,
+0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,
+0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,
+0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,
+0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,
+0x61,0x70,0x68,0x20,0x33,0x36,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,
+0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,
+0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,
+0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,
+0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,0x33,0x37,0x3a,0x20,0x6c,0x77,
+0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,
+0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,
+0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,
+0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,0x67,0x72,0x61,0x70,0x68,0x20,
+0x33,0x38,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,0x65,0x72,0x76,0x65,0x73,0x20,
+0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,0x73,0x65,0x64,0x20,0x76,0x61,
+0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,0x74,0x68,0x69,0x73,0x20,0x70,
+0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,0x70,0x3e,0x50,0x61,0x72,0x61,
+0x67,0x72,0x61,0x70,0x68,0x20,0x33,0x39,0x3a,0x20,0x6c,0x77,0x49,0x50,0x20,0x73,
+0x65,0x72,0x76,0x65,0x73,0x20,0x70,0x72,0x65,0x63,0x6f,0x6d,0x70,0x72,0x65,0x73,
+0x73,0x65,0x64,0x20,0x76,0x61,0x72,0x69,0x61,0x6e,0x74,0x73,0x20,0x6f,0x66,0x20,
+0x74,0x68,0x69,0x73,0x20,0x70,0x61,0x67,0x65,0x2e,0x3c,0x2f,0x70,0x3e,0x0a,0x3c,
+0x2f,0x62,0x6f,0x64,0x79,0x3e,0x3c,0x2f,0x68,0x74,0x6d,0x6c,0x3e,0x0a,};
+
+#if FSDATA_FILE_ALIGNMENT==1
+static const unsigned int dummy_align__style_css = 4;
+#endif
+static const unsigned char FSDATA_ALIGN_PRE data__style_css[] FSDATA_ALIGN_POST = {
+/* /style.css (11 chars) */
+0x2f,0x73,0x74,0x79,0x6c,0x65,0x2e,0x63,0x73,0x73,0x00,0x00,
+
+/* HTTP header */
+/* "HTTP/1.1 200 OK
+" (17 bytes) */
+0x48,0x54,0x54,0x50,0x2f,0x31,0x2e,0x31,0x20,0x32,0x30,0x30,0x20,0x4f,0x4b,0x0d,
+0x0a,
+/* "Server: lwIP/2.1.2 (http://savannah.nongnu.org/projects/lwip)
+" (63 bytes) */
+0x53,0x65,0x72,0x76,0x65,0x72,0x3a,0x20,0x6c,0x77,0x49,0x50,0x2f,0x32,0x2e,0x31,
+0x2e,0x32,0x20,0x28,0x68,0x74,0x74,0x70,0x3a,0x2f,0x2f,0x73,0x61,0x76,0x61,0x6e,
+0x6e,0x61,0x68,0x2e,0x6e,0x6f,0x6e,0x67,0x6e,0x75,0x2e,0x6f,0x72,0x67,0x2f,0x70,
+0x72,0x6f,0x6a,0x65,0x63,0x74,0x73,0x2f,0x6c,0x77,0x69,0x70,0x29,0x0d,0x0a,
+/* "Content-Length: 34
+" (18+ bytes) */
+0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x4c,0x65,0x6e,0x67,0x74,0x68,0x3a,0x20,
+0x33,0x34,0x0d,0x0a,
+/* "Connection: keep-alive
+" (24 bytes) */
+0x43,0x6f,0x6e,0x6e,0x65,0x63,0x74,0x69,0x6f,0x6e,0x3a,0x20,0x6b,0x65,0x65,0x70,
+0x2d,0x61,0x6c,0x69,0x76,0x65,0x0d,0x0a,
+/* "ETag: "3cd12149-22"
+" (21 bytes) */
+0x45,0x54,0x61,0x67,0x3a,0x20,0x22,0x33,0x63,0x64,0x31,0x32,0x31,0x34,0x39,0x2d,
+0x32,0x32,0x22,0x0d,0x0a,
+/* "Content-Type: text/css
+
+" (26 bytes) */
+0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x54,0x79,0x70,0x65,0x3a,0x20,0x74,0x65,
+0x78,0x74,0x2f,0x63,0x73,0x73,0x0d,0x0a,0x0d,0x0a,
+/* raw file data (34 bytes) */
+0x62,0x6f,0x64,0x79,0x20,0x7b,0x20,0x66,0x6f,0x6e,0x74,0x2d,0x66,0x61,0x6d,0x69,
+0x6c,0x79,0x3a,0x20,0x73,0x61,0x6e,0x73,0x2d,0x73,0x65,0x72,0x69,0x66,0x3b,0x20,
+0x7d,0x0a,};
+
+
+
+const struct fsdata_file file__404_html[] = { {
+file_NULL,
+data__404_html,
+data__404_html + 12,
+sizeof(data__404_html) - 12,
+FS_FILE_FLAGS_HEADER_INCLUDED | FS_FILE_FLAGS_HEADER_PERSISTENT | FS_FILE_FLAGS_HEADER_HTTPVER_1_1,
+#if HTTPD_PRECALCULATED_CHECKSUM
+0, NULL,
+#endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_PRECOMPRESSED
+file_NULL,
+NULL,
+FS_FILE_ENCODING_IDENTITY,
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+}};
+
+#if LWIP_HTTPD_PRECOMPRESSED
+const struct fsdata_file file__index_html_gz[] = { {
+file_NULL,
+data__index_html_gz,
+data__index_html_gz + 12,
+sizeof(data__index_html_gz) - 12,
+FS_FILE_FLAGS_HEADER_INCLUDED | FS_FILE_FLAGS_HEADER_PERSISTENT | FS_FILE_FLAGS_HEADER_HTTPVER_1_1,
+#if HTTPD_PRECALCULATED_CHECKSUM
+0, NULL,
+#endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_PRECOMPRESSED
+file_NULL,
+"\"ae99c29b-112\"",
+FS_FILE_ENCODING_GZIP,
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+}};
+
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+
+#if LWIP_HTTPD_PRECOMPRESSED
+const struct fsdata_file file__index_html_deflate[] = { {
+file_NULL,
+data__index_html_deflate,
+data__index_html_deflate + 12,
+sizeof(data__index_html_deflate) - 12,
+FS_FILE_FLAGS_HEADER_INCLUDED | FS_FILE_FLAGS_HEADER_PERSISTENT | FS_FILE_FLAGS_HEADER_HTTPVER_1_1,
+#if HTTPD_PRECALCULATED_CHECKSUM
+0, NULL,
+#endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_PRECOMPRESSED
+file__index_html_gz,
+"\"11383878-106\"",
+FS_FILE_ENCODING_DEFLATE,
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+}};
+
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+
+const struct fsdata_file file__index_html[] = { {
+file__404_html,
+data__index_html,
+data__index_html + 12,
+sizeof(data__index_html) - 12,
+FS_FILE_FLAGS_HEADER_INCLUDED | FS_FILE_FLAGS_HEADER_PERSISTENT | FS_FILE_FLAGS_HEADER_HTTPVER_1_1,
+#if HTTPD_PRECALCULATED_CHECKSUM
+0, NULL,
+#endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_PRECOMPRESSED
+file__index_html_deflate,
+"\"ff495129-b5e\"",
+FS_FILE_ENCODING_IDENTITY,
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+}};
+
+const struct fsdata_file file__style_css[] = { {
+file__index_html,
+data__style_css,
+data__style_css + 12,
+sizeof(data__style_css) - 12,
+FS_FILE_FLAGS_HEADER_INCLUDED | FS_FILE_FLAGS_HEADER_PERSISTENT | FS_FILE_FLAGS_HEADER_HTTPVER_1_1,
+#if HTTPD_PRECALCULATED_CHECKSUM
+0, NULL,
+#endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_PRECOMPRESSED
+file_NULL,
+"\"3cd12149-22\"",
+FS_FILE_ENCODING_IDENTITY,
+#endif /* LWIP_HTTPD_PRECOMPRESSED */
+}};
+
+#define FS_ROOT file__style_css
+#define FS_NUMFILES 3
+
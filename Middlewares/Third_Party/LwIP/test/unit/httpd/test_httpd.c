@@ -0,0 +1,452 @@
+#include "test_httpd.h"
+
+#include "lwip/apps/httpd.h"
+#include "lwip/apps/fs.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/tcp.h"
+#include "lwip/stats.h"
+#include "../tcp/tcp_helper.h"
+
+#if !LWIP_HTTPD_PRECOMPRESSED || !LWIP_HTTPD_SUPPORT_11_PIPELINING || !LWIP_IPV4
+#error "This tests needs LWIP_HTTPD_PRECOMPRESSED, LWIP_HTTPD_SUPPORT_11_PIPELINING and IPv4 enabled"
+#endif
+
+/* A client connection */
+struct test_httpd_conn {
+  u16_t port;
+  u32_t cli_nxt;
+  u32_t srv_nxt;
+  u16_t rx_len;
+  u8_t fin;
+  u8_t rst;
+};
+#define TEST_HTTPD_NUM_CONNS 4
+static struct test_httpd_conn conns[TEST_HTTPD_NUM_CONNS];
+
+/* Everything the server sent on all connections */
+static char rx_data[16384];
+static u16_t rx_len;
+/* File data that has to be sent by reference (not copied into the stack) */
+static const char *zc_data;
+static int zc_len;
+static u32_t zc_bytes;
+
+static u16_t cli_port;
+static struct netif test_netif;
+
+static struct test_httpd_conn *
+test_httpd_find_conn(u16_t port)
+{
+  int i;
+  for (i = 0; i < TEST_HTTPD_NUM_CONNS; i++) {
+    if (conns[i].port == port) {
+      return &conns[i];
+    }
+  }
+  return NULL;
+}
+
+static err_t
+test_httpd_netif_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  struct pbuf *q;
+  u16_t hdrlen, datalen, offset;
+  struct tcp_hdr tcphdr;
+  struct test_httpd_conn *conn;
+  u8_t iphdr_vhl;
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(ipaddr);
+
+  fail_unless(pbuf_copy_partial(p, &iphdr_vhl, 1, 0) == 1);
+  hdrlen = (u16_t)((iphdr_vhl & 0x0f) * 4);
+  fail_unless(pbuf_copy_partial(p, &tcphdr, sizeof(tcphdr), hdrlen) == sizeof(tcphdr));
+  hdrlen = (u16_t)(hdrlen + TCPH_HDRLEN_BYTES(&tcphdr));
+  datalen = (u16_t)(p->tot_len - hdrlen);
+  conn = test_httpd_find_conn(lwip_ntohs(tcphdr.dest));
+  if (TCPH_FLAGS(&tcphdr) & TCP_RST) {
+    /* killed connections of earlier requests are not tracked */
+    if (conn != NULL) {
+      conn->rst = 1;
+    }
+    return ERR_OK;
+  }
+  fail_unless(conn != NULL);
+  if (conn == NULL) {
+    return ERR_OK;
+  }
+  if (datalen > 0) {
+    fail_unless(rx_len + datalen < sizeof(rx_data));
+    fail_unless(pbuf_copy_partial(p, &rx_data[rx_len], datalen, hdrlen) == datalen);
+    rx_len = (u16_t)(rx_len + datalen);
+    conn->rx_len = (u16_t)(conn->rx_len + datalen);
+  }
+  conn->srv_nxt = lwip_ntohl(tcphdr.seqno) + datalen;
+  if (TCPH_FLAGS(&tcphdr) & (TCP_SYN | TCP_FIN)) {
+    conn->srv_nxt++;
+  }
+  if (TCPH_FLAGS(&tcphdr) & TCP_FIN) {
+    conn->fin = 1;
+  }
+  /* count the payload bytes referencing the file system data */
+  offset = 0;
+  for (q = p; q != NULL; q = q->next) {
+    if ((offset + q->len > hdrlen) && (zc_data != NULL) &&
+        ((const char *)q->payload >= zc_data) &&
+        ((const char *)q->payload + q->len <= zc_data + zc_len)) {
+      zc_bytes += q->len;
+    }
+    offset = (u16_t)(offset + q->len);
+  }
+  return ERR_OK;
+}
+
+static void
+test_httpd_send_ackno(struct test_httpd_conn *conn, const char *data, u8_t flags, u32_t ackno)
+{
+  size_t len = (data != NULL) ? strlen(data) : 0;
+  struct pbuf *p = tcp_create_segment((ip_addr_t *)&test_remote_ip, (ip_addr_t *)&test_local_ip,
+                                      conn->port, HTTPD_SERVER_PORT, (void *)data, len,
+                                      conn->cli_nxt, ackno, flags);
+  fail_unless(p != NULL);
+  conn->cli_nxt += (u32_t)len;
+  test_tcp_input(p, &test_netif);
+}
+
+/* Send data and acknowledge everything received */
+static void
+test_httpd_send(struct test_httpd_conn *conn, const char *data, u8_t flags)
+{
+  test_httpd_send_ackno(conn, data, flags, conn->srv_nxt);
+}
+
+/* Open a connection to the server */
+static void
+test_httpd_connect(struct test_httpd_conn *conn)
+{
+  memset(conn, 0, sizeof(*conn));
+  /* a new port for every connection, the last one may be in TIME_WAIT */
+  conn->port = ++cli_port;
+  conn->cli_nxt = 0x1000;
+  test_httpd_send(conn, NULL, TCP_SYN);
+  fail_unless(conn->srv_nxt != 0);
+  conn->cli_nxt++;
+  test_httpd_send(conn, NULL, TCP_ACK);
+}
+
+/* ACK the response until the server has sent everything */
+static void
+test_httpd_ack_all(struct test_httpd_conn *conn)
+{
+  u32_t acked;
+  int i;
+
+  for (i = 0; i < 100; i++) {
+    acked = conn->srv_nxt;
+    if (conn->fin) {
+      conn->cli_nxt++;
+      test_httpd_send(conn, NULL, TCP_ACK | TCP_FIN);
+      break;
+    }
+    test_httpd_send(conn, NULL, TCP_ACK);
+    if (conn->srv_nxt == acked) {
+      break;
+    }
+  }
+  rx_data[rx_len] = 0;
+}
+
+/* Connect to the server, send a request and ACK the response until the
+ * server has sent everything. Returns a pointer to the response body. */
+static const char *
+test_httpd_get(const char *request)
+{
+  char *body;
+
+  rx_len = 0;
+  zc_bytes = 0;
+  test_httpd_connect(&conns[0]);
+  test_httpd_send(&conns[0], request, TCP_ACK | TCP_PSH);
+  test_httpd_ack_all(&conns[0]);
+  body = strstr(rx_data, "\r\n\r\n");
+  fail_unless(body != NULL);
+  if (body == NULL) {
+    return "";
+  }
+  return body + 4;
+}
+
+/* Count the responses with the given status line received so far */
+static int
+test_httpd_count_responses(const char *status)
+{
+  int count = 0;
+  const char *r = rx_data;
+  while ((r = strstr(r, status)) != NULL) {
+    count++;
+    r++;
+  }
+  return count;
+}
+
+static u8_t
+test_httpd_has_header(const char *header)
+{
+  const char *body = strstr(rx_data, "\r\n\r\n");
+  const char *hdr = strstr(rx_data, header);
+  return (hdr != NULL) && (hdr < body);
+}
+
+/* Check the response body against the file system data of a variant */
+static void
+test_httpd_check_body(const char *body, const struct fs_file *file)
+{
+  const char *file_body = strstr(file->data, "\r\n\r\n") + 4;
+  int body_len = file->len - (int)(file_body - file->data);
+
+  fail_unless(rx_len - (body - rx_data) == body_len);
+  fail_unless(!memcmp(body, file_body, (size_t)body_len));
+}
+
+/* Setups/teardown functions */
+static struct netif *old_netif_list;
+static struct netif *old_netif_default;
+
+static void
+httpd_setup(void)
+{
+  old_netif_list = netif_list;
+  old_netif_default = netif_default;
+  netif_list = NULL;
+  netif_default = NULL;
+  tcp_remove_all();
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+
+  test_tcp_init_netif(&test_netif, NULL, &test_local_ip, &test_netmask);
+  test_netif.output = test_httpd_netif_output;
+  zc_data = NULL;
+  memset(conns, 0, sizeof(conns));
+  cli_port = TEST_REMOTE_PORT;
+  httpd_init();
+}
+
+static void
+httpd_teardown(void)
+{
+  struct tcp_pcb_listen *lpcb;
+  /* aborting a listening pcb is not allowed, so close the server first */
+  while ((lpcb = tcp_listen_pcbs.listen_pcbs) != NULL) {
+    fail_unless(tcp_close((struct tcp_pcb *)lpcb) == ERR_OK);
+  }
+  tcp_remove_all();
+  netif_list = NULL;
+  netif_default = NULL;
+  netif_list = old_netif_list;
+  netif_default = old_netif_default;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* Test functions */
+
+/** The smallest variant accepted by the client is sent by reference */
+START_TEST(test_httpd_precompressed_variants)
+{
+  struct fs_file file;
+  const char *body;
+  LWIP_UNUSED_ARG(_i);
+
+  /* deflate is the smallest variant */
+  fail_unless(fs_open_encoded(&file, "/index.html", FS_FILE_ENCODING_GZIP | FS_FILE_ENCODING_DEFLATE) == ERR_OK);
+  fail_unless(file.encoding == FS_FILE_ENCODING_DEFLATE);
+  fail_unless(file.flags & FS_FILE_FLAGS_VARIANTS);
+  zc_data = file.data;
+  zc_len = file.len;
+  body = test_httpd_get("GET /index.html HTTP/1.1\r\nAccept-Encoding: gzip, deflate, br\r\n\r\n");
+  fail_unless(test_httpd_has_header("Content-Encoding: deflate\r\n"));
+  fail_unless(test_httpd_has_header("Vary: Accept-Encoding\r\n"));
+  fail_unless(test_httpd_has_header(file.etag));
+  test_httpd_check_body(body, &file);
+  /* the complete response (including the prebuilt headers) was not copied */
+  fail_unless(zc_bytes == (u32_t)file.len);
+  fs_close(&file);
+
+  /* gzip only */
+  fail_unless(fs_open_encoded(&file, "/index.html", FS_FILE_ENCODING_GZIP) == ERR_OK);
+  fail_unless(file.encoding == FS_FILE_ENCODING_GZIP);
+  body = test_httpd_get("GET /index.html HTTP/1.1\r\nAccept-Encoding: x-gzip;q=0.5, deflate;q=0\r\n\r\n");
+  fail_unless(test_httpd_has_header("Content-Encoding: gzip\r\n"));
+  test_httpd_check_body(body, &file);
+  fs_close(&file);
+
+  /* no (accepted) content coding: identity */
+  fail_unless(fs_open(&file, "/index.html") == ERR_OK);
+  fail_unless(file.encoding == FS_FILE_ENCODING_IDENTITY);
+  body = test_httpd_get("GET /index.html HTTP/1.1\r\nAccept-Encoding: br, *;q=0\r\n\r\n");
+  fail_unless(!test_httpd_has_header("Content-Encoding:"));
+  fail_unless(test_httpd_has_header("Vary: Accept-Encoding\r\n"));
+  test_httpd_check_body(body, &file);
+  fs_close(&file);
+
+  /* a file without variants does not vary */
+  fail_unless(fs_open_encoded(&file, "/style.css", FS_FILE_ENCODING_GZIP) == ERR_OK);
+  fail_unless(!(file.flags & FS_FILE_FLAGS_VARIANTS));
+  body = test_httpd_get("GET /style.css HTTP/1.1\r\nACCEPT-ENCODING: gzip\r\n\r\n");
+  fail_unless(!test_httpd_has_header("Content-Encoding:"));
+  fail_unless(!test_httpd_has_header("Vary:"));
+  test_httpd_check_body(body, &file);
+  fs_close(&file);
+}
+END_TEST
+
+/** A matching If-None-Match is answered with "304 Not Modified" */
+START_TEST(test_httpd_not_modified)
+{
+  struct fs_file file;
+  char request[256];
+  const char *body;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(fs_open_encoded(&file, "/index.html", FS_FILE_ENCODING_GZIP) == ERR_OK);
+  fail_unless(file.etag != NULL);
+
+  snprintf(request, sizeof(request), "GET /index.html HTTP/1.1\r\nAccept-Encoding: gzip\r\n"
+           "If-None-Match: \"x\", W/%s\r\nConnection: close\r\n\r\n", file.etag);
+  body = test_httpd_get(request);
+  fail_unless(!strncmp(rx_data, "HTTP/1.0 304 Not Modified\r\n", 27));
+  fail_unless(test_httpd_has_header("Content-Encoding: gzip\r\n"));
+  fail_unless(test_httpd_has_header(file.etag));
+  fail_unless(*body == 0);
+  fail_unless(conns[0].fin);
+
+  /* the ETag of the gzip variant does not match the deflate variant */
+  snprintf(request, sizeof(request), "GET /index.html HTTP/1.1\r\nAccept-Encoding: deflate\r\n"
+           "If-None-Match: %s\r\n\r\n", file.etag);
+  body = test_httpd_get(request);
+  fail_unless(!strncmp(rx_data, "HTTP/1.1 200 OK\r\n", 17));
+  fail_unless(test_httpd_has_header("Content-Encoding: deflate\r\n"));
+  fail_unless(*body != 0);
+
+  /* error pages have no ETag */
+  body = test_httpd_get("GET /missing.html HTTP/1.1\r\nIf-None-Match: *\r\n\r\n");
+  fail_unless(!strncmp(rx_data, "HTTP/1.1 404", 12));
+  fail_unless(*body != 0);
+  fs_close(&file);
+}
+END_TEST
+
+/** Requests received while a response is sent are answered in order */
+START_TEST(test_httpd_pipelining)
+{
+  struct fs_file index, css;
+  struct test_httpd_conn *conn = &conns[0];
+  u32_t syn_ackno;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(fs_open(&index, "/index.html") == ERR_OK);
+  fail_unless(fs_open(&css, "/style.css") == ERR_OK);
+  rx_len = 0;
+  test_httpd_connect(conn);
+  syn_ackno = conn->srv_nxt;
+
+  /* the third response does not fit into the send buffer... */
+  fail_unless(3 * index.len > TCP_SND_BUF);
+  test_httpd_send(conn, "GET /index.html HTTP/1.1\r\n\r\n"
+                  "GET /index.html HTTP/1.1\r\n\r\n"
+                  "GET /index.html HTTP/1.1\r\n\r\n", TCP_ACK | TCP_PSH);
+  /* ...so this one has to be queued (nothing is ACKed yet) */
+  test_httpd_send_ackno(conn, "GET /style.css HTTP/1.1\r\nConnection: close\r\n\r\n",
+                        TCP_ACK | TCP_PSH, syn_ackno);
+  test_httpd_ack_all(conn);
+
+  fail_unless(test_httpd_count_responses("HTTP/1.1 200 OK\r\n") == 4);
+  fail_unless(rx_len == 3 * index.len + css.len);
+  fail_unless(!memcmp(rx_data, index.data, (size_t)index.len));
+  fail_unless(!memcmp(&rx_data[2 * index.len], index.data, (size_t)index.len));
+  fail_unless(!memcmp(&rx_data[3 * index.len], css.data, (size_t)css.len));
+  /* the connection is closed after the last request */
+  fail_unless(conn->fin);
+  fail_unless(!conn->rst);
+  fs_close(&index);
+  fs_close(&css);
+}
+END_TEST
+
+/** Requests split into several segments are parsed when complete */
+START_TEST(test_httpd_split_request)
+{
+  struct test_httpd_conn *conn = &conns[0];
+  LWIP_UNUSED_ARG(_i);
+
+  rx_len = 0;
+  test_httpd_connect(conn);
+  test_httpd_send(conn, "GET /style.css HT", TCP_ACK | TCP_PSH);
+  test_httpd_send(conn, "TP/1.1\r\nAccept-Encoding: gzip\r", TCP_ACK | TCP_PSH);
+  fail_unless(rx_len == 0);
+  /* the end of the first request and the start of the next one */
+  test_httpd_send(conn, "\n\r\nGET /index.html HTTP/1.1\r\nConn", TCP_ACK | TCP_PSH);
+  test_httpd_ack_all(conn);
+  fail_unless(test_httpd_count_responses("HTTP/1.1 200 OK\r\n") == 1);
+  fail_unless(!conn->fin);
+  test_httpd_send(conn, "ection: close\r\n", TCP_ACK | TCP_PSH);
+  test_httpd_send(conn, "\r\n", TCP_ACK | TCP_PSH);
+  test_httpd_ack_all(conn);
+  fail_unless(test_httpd_count_responses("HTTP/1.1 200 OK\r\n") == 2);
+  fail_unless(conn->fin);
+}
+END_TEST
+
+/** With all connection states in use, idle persistent connections are
+ * reclaimed before busy ones and every request is answered */
+START_TEST(test_httpd_reclaim_idle)
+{
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  rx_len = 0;
+  /* a connection waiting for its request (oldest) */
+  test_httpd_connect(&conns[0]);
+  /* idle persistent connections */
+  for (i = 1; i < MEMP_NUM_PARALLEL_HTTPD_CONNS; i++) {
+    test_httpd_connect(&conns[i]);
+    test_httpd_send(&conns[i], "GET /style.css HTTP/1.1\r\n\r\n", TCP_ACK | TCP_PSH);
+    test_httpd_ack_all(&conns[i]);
+    fail_unless(conns[i].rx_len != 0);
+    fail_unless(!conns[i].fin);
+  }
+  fail_unless(test_httpd_count_responses("HTTP/1.1 200 OK\r\n") == MEMP_NUM_PARALLEL_HTTPD_CONNS - 1);
+
+  /* no connection state left: the oldest idle connection is killed */
+  test_httpd_connect(&conns[MEMP_NUM_PARALLEL_HTTPD_CONNS]);
+  fail_unless(conns[1].rst);
+  fail_unless(!conns[0].rst);
+  for (i = 2; i <= MEMP_NUM_PARALLEL_HTTPD_CONNS; i++) {
+    fail_unless(!conns[i].rst);
+  }
+
+  /* the busy connection and the new one are served */
+  test_httpd_send(&conns[0], "GET /style.css HTTP/1.0\r\n\r\n", TCP_ACK | TCP_PSH);
+  test_httpd_ack_all(&conns[0]);
+  fail_unless(conns[0].rx_len != 0);
+  fail_unless(conns[0].fin);
+  i = MEMP_NUM_PARALLEL_HTTPD_CONNS;
+  test_httpd_send(&conns[i], "GET /style.css HTTP/1.1\r\nConnection: close\r\n\r\n", TCP_ACK | TCP_PSH);
+  test_httpd_ack_all(&conns[i]);
+  fail_unless(conns[i].rx_len != 0);
+  fail_unless(conns[i].fin);
+  fail_unless(test_httpd_count_responses("HTTP/1.") == MEMP_NUM_PARALLEL_HTTPD_CONNS + 1);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+httpd_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_httpd_precompressed_variants),
+    TESTFUNC(test_httpd_not_modified),
+    TESTFUNC(test_httpd_pipelining),
+    TESTFUNC(test_httpd_split_request),
+    TESTFUNC(test_httpd_reclaim_idle)
+  };
+  return create_suite("HTTPD", tests, sizeof(tests)/sizeof(testfunc), httpd_setup, httpd_teardown);
+}
@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_HTTPD_H
+#define LWIP_HDR_TEST_HTTPD_H
+
+#include "../lwip_check.h"
+
+Suite *httpd_suite(void);
+
+#endif
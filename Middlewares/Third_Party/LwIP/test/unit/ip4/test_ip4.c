@@ -1,6 +1,8 @@
 #include "test_ip4.h"
 
 #include "lwip/ip4.h"
+#include "lwip/ip4_frag.h"
+#include "lwip/udp.h"
 #include "lwip/inet_chksum.h"
 #include "lwip/stats.h"
 #include "lwip/prot/ip.h"
@@ -8,13 +10,19 @@
 
 #include "lwip/tcpip.h"
 
-#if !LWIP_IPV4 || !IP_REASSEMBLY || !MIB2_STATS || !IPFRAG_STATS
-#error "This tests needs LWIP_IPV4, IP_REASSEMBLY; MIB2- and IPFRAG-statistics enabled"
+#if !LWIP_IPV4 || !IP_REASSEMBLY || !MIB2_STATS || !IPFRAG_STATS || !IPREASS_STATS
+#error "This tests needs LWIP_IPV4, IP_REASSEMBLY; MIB2-, IPFRAG- and IPREASS-statistics enabled"
 #endif
 
+#if IP_REASS_TREE
+/* UDP datagram split into fragments by the tree tests */
+static u8_t reass_data[1200];
+static int reass_recv_count;
+#endif /* IP_REASS_TREE */
+
 /* Helper functions */
 static void
-create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
+create_ip4_input_fragment_from(u8_t src, u16_t ip_id, u16_t start, u16_t len, int last, const u8_t *data)
 {
   struct pbuf *p;
   struct netif *input_netif = netif_list; /* just use any netif */
@@ -27,6 +35,9 @@ create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
   if (p != NULL) {
     err_t err;
     struct ip_hdr *iphdr = (struct ip_hdr *)p->payload;
+    if (data != NULL) {
+      MEMCPY(iphdr + 1, data + start, len);
+    }
     IPH_VHL_SET(iphdr, 4, sizeof(struct ip_hdr) / 4);
     IPH_TOS_SET(iphdr, 0);
     IPH_LEN_SET(iphdr, lwip_htons(p->tot_len));
@@ -40,7 +51,7 @@ create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
     IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
     IPH_CHKSUM_SET(iphdr, 0);
     ip4_addr_copy(iphdr->src, *netif_ip4_addr(input_netif));
-    iphdr->src.addr = lwip_htonl(lwip_htonl(iphdr->src.addr) + 1);
+    iphdr->src.addr = lwip_htonl(lwip_htonl(iphdr->src.addr) + src);
     ip4_addr_copy(iphdr->dest, *netif_ip4_addr(input_netif));
     IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, sizeof(struct ip_hdr)));
 
@@ -52,6 +63,54 @@ create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
   }
 }
 
+static void
+create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
+{
+  create_ip4_input_fragment_from(1, ip_id, start, len, last, NULL);
+}
+
+#if IP_REASS_TREE
+static void
+reass_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(pcb);
+  LWIP_UNUSED_ARG(addr);
+  fail_unless(port == 1234);
+  fail_unless(p->tot_len == sizeof(reass_data) - UDP_HLEN);
+  fail_unless(pbuf_memcmp(p, 0, reass_data + UDP_HLEN, p->tot_len) == 0);
+  reass_recv_count++;
+  pbuf_free(p);
+}
+
+/* Fill reass_data with a UDP datagram (without checksum) to port 4321 */
+static struct udp_pcb *
+reass_setup_udp(void)
+{
+  struct udp_pcb *pcb;
+  u16_t i;
+
+  for (i = UDP_HLEN; i < sizeof(reass_data); i++) {
+    reass_data[i] = (u8_t)(i ^ (i >> 8));
+  }
+  reass_data[0] = 1234 >> 8;
+  reass_data[1] = 1234 & 0xff;
+  reass_data[2] = 4321 >> 8;
+  reass_data[3] = 4321 & 0xff;
+  reass_data[4] = (u8_t)(sizeof(reass_data) >> 8);
+  reass_data[5] = (u8_t)(sizeof(reass_data) & 0xff);
+  reass_data[6] = 0;
+  reass_data[7] = 0;
+  reass_recv_count = 0;
+
+  pcb = udp_new();
+  fail_unless(pcb != NULL);
+  fail_unless(udp_bind(pcb, IP4_ADDR_ANY, 4321) == ERR_OK);
+  udp_recv(pcb, reass_recv, NULL);
+  return pcb;
+}
+#endif /* IP_REASS_TREE */
+
 /* Setups/teardown functions */
 
 static void
@@ -148,6 +207,130 @@ START_TEST(test_ip4_reass)
 }
 END_TEST
 
+#if IP_REASS_TREE
+START_TEST(test_ip4_reass_overlap)
+{
+  const u16_t ip_id = 129;
+  struct udp_pcb *pcb;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&lwip_stats.mib2, 0, sizeof(lwip_stats.mib2));
+  memset(&lwip_stats.ip_frag, 0, sizeof(lwip_stats.ip_frag));
+  memset(&lwip_stats.ip_reass, 0, sizeof(lwip_stats.ip_reass));
+  pcb = reass_setup_udp();
+
+  create_ip4_input_fragment_from(1, ip_id, 400, 400, 0, reass_data);
+  /* tail trimmed to 0..400 */
+  create_ip4_input_fragment_from(1, ip_id, 0, 480, 0, reass_data);
+  fail_unless(lwip_stats.ip_reass.overlap == 1);
+  /* head trimmed to 400, replaces 400..800 */
+  create_ip4_input_fragment_from(1, ip_id, 360, 640, 0, reass_data);
+  fail_unless(lwip_stats.ip_reass.overlap == 3);
+  /* duplicate */
+  create_ip4_input_fragment_from(1, ip_id, 0, 400, 0, reass_data);
+  fail_unless(lwip_stats.ip_reass.overlap == 4);
+  fail_unless(lwip_stats.ip_frag.drop == 1);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 0);
+  fail_unless(reass_recv_count == 0);
+  /* last fragment, head trimmed to 1000 */
+  create_ip4_input_fragment_from(1, ip_id, 960, 240, 1, reass_data);
+  fail_unless(lwip_stats.ip_reass.overlap == 5);
+  fail_unless(lwip_stats.ip_frag.drop == 1);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 1);
+  fail_unless(lwip_stats.ip_reass.completed == 1);
+  fail_unless(reass_recv_count == 1);
+
+  udp_remove(pcb);
+}
+END_TEST
+
+START_TEST(test_ip4_reass_last_duplicate)
+{
+  const u16_t ip_id = 131;
+  struct udp_pcb *pcb;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&lwip_stats.mib2, 0, sizeof(lwip_stats.mib2));
+  memset(&lwip_stats.ip_reass, 0, sizeof(lwip_stats.ip_reass));
+  pcb = reass_setup_udp();
+
+  /* all data arrives with MF set */
+  create_ip4_input_fragment_from(1, ip_id, 0, 800, 0, reass_data);
+  create_ip4_input_fragment_from(1, ip_id, 800, 400, 0, reass_data);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 0);
+  fail_unless(reass_recv_count == 0);
+  /* the last fragment only repeats data, but completes the datagram */
+  create_ip4_input_fragment_from(1, ip_id, 1000, 200, 1, reass_data);
+  fail_unless(lwip_stats.ip_reass.overlap == 1);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 1);
+  fail_unless(lwip_stats.ip_reass.completed == 1);
+  fail_unless(reass_recv_count == 1);
+
+  udp_remove(pcb);
+}
+END_TEST
+
+START_TEST(test_ip4_reass_out_of_order)
+{
+  const u16_t ip_id = 130;
+  const u16_t frags = sizeof(reass_data) / 40;
+  struct udp_pcb *pcb;
+  u16_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&lwip_stats.mib2, 0, sizeof(lwip_stats.mib2));
+  memset(&lwip_stats.ip_frag, 0, sizeof(lwip_stats.ip_frag));
+  pcb = reass_setup_udp();
+
+  /* 30 fragments in a scattered order, the last one arriving first */
+  for (i = 0; i < frags; i++) {
+    u16_t n = (u16_t)((frags - 1 + i * 7) % frags);
+    create_ip4_input_fragment_from(1, ip_id, (u16_t)(n * 40), 40, n == frags - 1, reass_data);
+    fail_unless(reass_recv_count == ((i == frags - 1) ? 1 : 0));
+  }
+  fail_unless(lwip_stats.ip_frag.recv == frags);
+  fail_unless(lwip_stats.ip_frag.drop == 0);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 1);
+
+  udp_remove(pcb);
+}
+END_TEST
+
+#if IP_REASS_MAX_PBUFS_PER_SRC < IP_REASS_MAX_PBUFS
+START_TEST(test_ip4_reass_src_quota)
+{
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&lwip_stats.mib2, 0, sizeof(lwip_stats.mib2));
+  memset(&lwip_stats.ip_frag, 0, sizeof(lwip_stats.ip_frag));
+  memset(&lwip_stats.ip_reass, 0, sizeof(lwip_stats.ip_reass));
+
+  /* one source fills its share with two datagrams that never complete */
+  for (i = 0; i < IP_REASS_MAX_PBUFS_PER_SRC; i++) {
+    create_ip4_input_fragment_from(1, (u16_t)(200 + (i & 1)), (u16_t)(i * 16), 8, 0, NULL);
+  }
+  fail_unless(lwip_stats.ip_reass.quota == 0);
+  create_ip4_input_fragment_from(1, 202, 0, 8, 0, NULL);
+  fail_unless(lwip_stats.ip_reass.quota == 1);
+  fail_unless(lwip_stats.ip_frag.drop == 1);
+
+  /* other sources can still reassemble */
+  create_ip4_input_fragment_from(2, 200, 8, 8, 1, NULL);
+  create_ip4_input_fragment_from(2, 200, 0, 8, 0, NULL);
+  fail_unless(lwip_stats.ip_reass.quota == 1);
+  fail_unless(lwip_stats.ip_frag.drop == 1);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 1);
+
+  /* time out the incomplete datagrams */
+  for (i = 0; i <= IP_REASS_MAXAGE; i++) {
+    ip_reass_tmr();
+  }
+  fail_unless(lwip_stats.ip_reass.timeout == 2);
+}
+END_TEST
+#endif /* IP_REASS_MAX_PBUFS_PER_SRC < IP_REASS_MAX_PBUFS */
+#endif /* IP_REASS_TREE */
 
 /** Create the suite including all tests for this module */
 Suite *
@@ -155,6 +338,14 @@ ip4_suite(void)
 {
   testfunc tests[] = {
     TESTFUNC(test_ip4_reass),
+#if IP_REASS_TREE
+    TESTFUNC(test_ip4_reass_overlap),
+    TESTFUNC(test_ip4_reass_last_duplicate),
+    TESTFUNC(test_ip4_reass_out_of_order),
+#if IP_REASS_MAX_PBUFS_PER_SRC < IP_REASS_MAX_PBUFS
+    TESTFUNC(test_ip4_reass_src_quota),
+#endif
+#endif /* IP_REASS_TREE */
   };
   return create_suite("IPv4", tests, sizeof(tests)/sizeof(testfunc), ip4_setup, ip4_teardown);
 }
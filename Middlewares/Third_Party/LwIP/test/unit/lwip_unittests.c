@@ -5,16 +5,25 @@
 #include "udp/test_udp.h"
 #include "tcp/test_tcp.h"
 #include "tcp/test_tcp_oos.h"
+#include "tcp/test_tcp_cc.h"
+#include "tcp/test_tcp_sack.h"
 #include "core/test_def.h"
+#include "core/test_inet_chksum.h"
 #include "core/test_mem.h"
+#include "core/test_memp.h"
 #include "core/test_netif.h"
 #include "core/test_pbuf.h"
+#include "core/test_spsc_ring.h"
 #include "core/test_timers.h"
 #include "etharp/test_etharp.h"
 #include "dhcp/test_dhcp.h"
+#include "dns/test_dns.h"
 #include "mdns/test_mdns.h"
+#include "httpd/test_httpd.h"
 #include "mqtt/test_mqtt.h"
+#include "netif/test_bridgeif.h"
 #include "api/test_sockets.h"
+#include "api/test_tcpip.h"
 
 #include "lwip/init.h"
 #if !NO_SYS
@@ -67,16 +76,25 @@ int main(void)
     udp_suite,
     tcp_suite,
     tcp_oos_suite,
+    tcp_cc_suite,
+    tcp_sack_suite,
     def_suite,
+    inet_chksum_suite,
     mem_suite,
+    memp_suite,
     netif_suite,
     pbuf_suite,
+    spsc_ring_suite,
     timers_suite,
     etharp_suite,
     dhcp_suite,
+    dns_suite,
     mdns_suite,
+    httpd_suite,
     mqtt_suite,
-    sockets_suite
+    bridgeif_suite,
+    sockets_suite,
+    tcpip_suite
   };
   size_t num = sizeof(suites)/sizeof(void*);
   LWIP_ASSERT("No suites defined", num > 0);
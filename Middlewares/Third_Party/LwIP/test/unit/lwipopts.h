@@ -39,6 +39,9 @@
 #define LWIP_CHECKSUM_ON_COPY           1
 #define TCP_CHECKSUM_ON_COPY_SANITY_CHECK 1
 #define TCP_CHECKSUM_ON_COPY_SANITY_CHECK_FAIL(printfmsg) LWIP_ASSERT("TCP_CHECKSUM_ON_COPY_SANITY_CHECK_FAIL", 0)
+/* Test the 64-bit accumulator checksum and the fused copy-and-checksum */
+#define LWIP_CHKSUM_ALGORITHM           4
+#define LWIP_CHKSUM_COPY_ALGORITHM      2
 
 /* We link to special sys_arch.c (for basic non-waiting API layers unit tests) */
 #define NO_SYS                          0
@@ -46,13 +49,27 @@
 #define LWIP_NETCONN                    !NO_SYS
 #define LWIP_SOCKET                     !NO_SYS
 #define LWIP_NETCONN_FULLDUPLEX         LWIP_SOCKET
+/* Test the epoll-style readiness API */
+#define LWIP_SOCKET_EPOLL               LWIP_SOCKET
+/* recvmmsg/sendmmsg tests queue more than one batch of datagrams */
+#define MEMP_NUM_NETBUF                 16
 #define LWIP_NETBUF_RECVINFO            1
+/* Test zero-copy receive */
+#define LWIP_SOCKET_RECV_ZC             LWIP_SOCKET
 #define LWIP_HAVE_LOOPIF                1
 #define TCPIP_THREAD_TEST
+/* Handle several queued messages per tcpip_thread wakeup */
+#define TCPIP_MBOX_BATCH_SIZE           4
+/* Test the SPSC rings and tcpip_rxring */
+#define LWIP_SPSC_RING                  1
 
 /* Enable DHCP to test it, disable UDP checksum to easier inject packets */
 #define LWIP_DHCP                       1
 
+/* Test the DNS resolver cache against a fake server */
+#define LWIP_DNS                        1
+#define LWIP_DNS_CACHE                  1
+
 /* Minimal changes to opt.h required for tcp unit tests: */
 #define MEM_SIZE                        16000
 #define TCP_SND_QUEUELEN                40
@@ -63,18 +80,74 @@
 #define TCP_RCV_SCALE                   0
 #define PBUF_POOL_SIZE                  400 /* pbuf tests need ~200KByte */
 
+/* Demultiplex TCP segments through the pcb hash tables */
+#define TCP_PCB_HASH                    1
+
+/* Demultiplex UDP datagrams through the local-port index and test
+   spreading flows over SO_REUSEPORT groups */
+#define UDP_PCB_HASH                    1
+#define SO_REUSE_PORT                   1
+#define MEMP_NUM_UDP_PCB                16
+
+/* Merge received TCP segments before IP input */
+#define IP_GRO                          1
+
+/* Use the lock-free memp free lists */
+#define MEMP_LOCKFREE                   1
+
+/* Test the zero-copy tcp_write_zc() API */
+#define TCP_WRITE_ZEROCOPY              1
+
+/* Test the MQTT client publishing referenced payloads */
+#define MQTT_PUBLISH_ZEROCOPY           1
+
+/* Queue TCP super-segments and cut them at the netif */
+#define TCP_TSO                         1
+
+/* Per-pcb selectable congestion control (CUBIC, bbrlite) */
+#define LWIP_TCP_CC                     1
+
+/* Send SACKs and recover from loss with received SACKs */
+#define LWIP_TCP_SACK_OUT               1
+#define LWIP_TCP_SACK_IN                1
+
+/* Merge out-of-sequence data into ranges with a sorted index */
+#define TCP_OOSEQ_RANGES                8
+
 /* Enable IGMP and MDNS for MDNS tests */
 #define LWIP_IGMP                       1
 #define LWIP_MDNS_RESPONDER             1
 #define LWIP_NUM_NETIF_CLIENT_DATA      (LWIP_MDNS_RESPONDER)
 
+/* Limit learning of the bridge FDB per port */
+#define BRIDGEIF_FDB_PORT_MAX_ENTRIES   200
+#define BRIDGEIF_FDB_PORT_LEARN_RATE    50
+
 /* Minimal changes to opt.h required for etharp unit tests: */
 #define ETHARP_SUPPORT_STATIC_ENTRIES   1
+#define ETHARP_TABLE_HASH               1
 
-#define MEMP_NUM_SYS_TIMEOUT            (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 8)
+/* timer tests schedule thousands of timeouts on the timing wheel */
+#define LWIP_TIMERS_WHEEL               1
+#define MEMP_NUM_SYS_TIMEOUT            (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 2008)
 
 /* MIB2 stats are required to check IPv4 reassembly results */
 #define MIB2_STATS                      1
+/* Reassemble IPv4 fragments in a splay tree, limit the pbufs per source */
+#define IP_REASS_TREE                   1
+#define IP_REASS_MAX_PBUFS              64
+#define IP_REASS_MAX_PBUFS_PER_SRC      48
+
+/* httpd tests serve precompressed variants from a test file system */
+#define LWIP_HTTPD_DYNAMIC_HEADERS      1
+#define LWIP_HTTPD_PRECOMPRESSED        1
+#define HTTPD_FSDATA_FILE               "httpd/fsdata_test.c"
+/* httpd tests pipeline requests and exhaust the connection state pool */
+#define LWIP_HTTPD_SUPPORT_11_KEEPALIVE 1
+#define LWIP_HTTPD_SUPPORT_11_PIPELINING 1
+#define HTTPD_USE_MEM_POOL              1
+#define MEMP_NUM_PARALLEL_HTTPD_CONNS   3
+#define LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED 1
 
 /* netif tests want to test this, so enable: */
 #define LWIP_NETIF_EXT_STATUS_CALLBACK  1
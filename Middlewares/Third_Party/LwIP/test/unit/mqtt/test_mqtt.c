@@ -4,6 +4,12 @@
 #include "lwip/apps/mqtt.h"
 #include "lwip/apps/mqtt_priv.h"
 #include "lwip/netif.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/tcp.h"
+#include "lwip/timeouts.h"
+#include "arch/sys_arch.h"
+#include "../tcp/tcp_helper.h"
 
 const ip_addr_t test_mqtt_local_ip = IPADDR4_INIT_BYTES(192, 168, 1, 1);
 const ip_addr_t test_mqtt_remote_ip = IPADDR4_INIT_BYTES(192, 168, 1, 2);
@@ -36,9 +42,193 @@ test_mqtt_init_netif(struct netif *netif, const ip_addr_t *ip_addr, const ip_add
   netif_list = netif;
 }
 
+/* A stand-in broker on the other side of the netif: it records the stream
+ * sent by the client and acknowledges it on request */
+static struct netif broker_netif;
+static u8_t brk_rx[4096];
+static u16_t brk_rx_len;
+static u16_t brk_rx_parsed;
+/* number of data segments received */
+static u32_t brk_rx_segs;
+static u16_t cli_port;
+static u32_t cli_nxt;
+static u32_t brk_nxt;
+/* Payload that has to be sent by reference (not copied into the stack) */
+static const u8_t *zc_data;
+static u16_t zc_len;
+static u32_t zc_bytes;
+/* Packets kept referenced like a netif driver with a transmit queue would */
+static u8_t brk_hold;
+static struct pbuf *brk_held[8];
+static u16_t brk_held_num;
+
+static err_t
+test_mqtt_broker_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  struct pbuf *q;
+  u16_t hdrlen, datalen, offset;
+  struct tcp_hdr tcphdr;
+  u8_t iphdr_vhl;
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(ipaddr);
+
+  fail_unless(pbuf_copy_partial(p, &iphdr_vhl, 1, 0) == 1);
+  hdrlen = (u16_t)((iphdr_vhl & 0x0f) * 4);
+  fail_unless(pbuf_copy_partial(p, &tcphdr, sizeof(tcphdr), hdrlen) == sizeof(tcphdr));
+  hdrlen = (u16_t)(hdrlen + TCPH_HDRLEN_BYTES(&tcphdr));
+  datalen = (u16_t)(p->tot_len - hdrlen);
+  if (TCPH_FLAGS(&tcphdr) & TCP_RST) {
+    return ERR_OK;
+  }
+  if (TCPH_FLAGS(&tcphdr) & TCP_SYN) {
+    cli_port = lwip_ntohs(tcphdr.src);
+    cli_nxt = lwip_ntohl(tcphdr.seqno) + 1;
+    return ERR_OK;
+  }
+  /* no timers run, so there are no retransmissions */
+  fail_unless(lwip_ntohl(tcphdr.seqno) == cli_nxt);
+  if (datalen > 0) {
+    fail_unless(brk_rx_len + datalen <= sizeof(brk_rx));
+    fail_unless(pbuf_copy_partial(p, &brk_rx[brk_rx_len], datalen, hdrlen) == datalen);
+    brk_rx_len = (u16_t)(brk_rx_len + datalen);
+    brk_rx_segs++;
+  }
+  cli_nxt += datalen;
+  if (TCPH_FLAGS(&tcphdr) & TCP_FIN) {
+    cli_nxt++;
+  }
+  if (brk_hold) {
+    fail_unless(brk_held_num < LWIP_ARRAYSIZE(brk_held));
+    pbuf_ref(p);
+    brk_held[brk_held_num++] = p;
+  }
+  /* count the payload bytes referencing the application data */
+  offset = 0;
+  for (q = p; q != NULL; q = q->next) {
+    if ((offset + q->len > hdrlen) && (zc_data != NULL) &&
+        ((const u8_t *)q->payload >= zc_data) &&
+        ((const u8_t *)q->payload + q->len <= zc_data + zc_len)) {
+      zc_bytes += q->len;
+    }
+    offset = (u16_t)(offset + q->len);
+  }
+  return ERR_OK;
+}
+
+/* Send data from the broker, acknowledging everything received */
+static void
+test_mqtt_broker_send(const void *data, u16_t len, u8_t flags)
+{
+  struct pbuf *p = tcp_create_segment((ip_addr_t *)&test_mqtt_remote_ip, (ip_addr_t *)&test_mqtt_local_ip,
+                                      MQTT_PORT, cli_port, LWIP_CONST_CAST(void *, data), len,
+                                      brk_nxt, cli_nxt, flags);
+  fail_unless(p != NULL);
+  brk_nxt += len;
+  test_tcp_input(p, &broker_netif);
+}
+
+/* Acknowledge everything until the client has nothing more to send */
+static void
+test_mqtt_broker_ack_all(void)
+{
+  u32_t acked;
+  int i;
+  for (i = 0; i < 100; i++) {
+    acked = cli_nxt;
+    test_mqtt_broker_send(NULL, 0, TCP_ACK);
+    if (cli_nxt == acked) {
+      break;
+    }
+  }
+}
+
+/* Get the next complete MQTT packet received by the broker.
+ * Returns the first byte of the fixed header or 0 if there is none. */
+static u8_t
+test_mqtt_broker_next(const u8_t **body, u32_t *len)
+{
+  u16_t pos = (u16_t)(brk_rx_parsed + 1);
+  u32_t rem_len = 0;
+  u8_t shift = 0;
+  u8_t b;
+
+  do {
+    if (pos >= brk_rx_len) {
+      return 0;
+    }
+    b = brk_rx[pos++];
+    rem_len |= (u32_t)(b & 0x7f) << shift;
+    shift = (u8_t)(shift + 7);
+  } while (b & 0x80);
+  if (pos + rem_len > brk_rx_len) {
+    return 0;
+  }
+  *body = &brk_rx[pos];
+  *len = rem_len;
+  b = brk_rx[brk_rx_parsed];
+  brk_rx_parsed = (u16_t)(pos + rem_len);
+  if (brk_rx_parsed == brk_rx_len) {
+    /* everything was parsed, reuse the buffer (body stays valid until more is received) */
+    brk_rx_parsed = 0;
+    brk_rx_len = 0;
+  }
+  return b;
+}
+
+/* Check the next packet is a PUBLISH of payload to topic, returns its packet id */
+static u16_t
+test_mqtt_broker_check_publish(const char *topic, const void *payload, u16_t payload_len, u8_t qos)
+{
+  const u8_t *body = NULL;
+  u32_t len = 0;
+  u16_t topic_len = (u16_t)strlen(topic);
+  u16_t hdr_len = (u16_t)(2 + topic_len + (qos ? 2 : 0));
+  u16_t pkt_id = 0;
+  u8_t type = test_mqtt_broker_next(&body, &len);
+
+  fail_unless(type == (0x30 | (qos << 1)));
+  if (type != (0x30 | (qos << 1))) {
+    return 0;
+  }
+  fail_unless(len == (u32_t)hdr_len + payload_len);
+  fail_unless(((body[0] << 8) | body[1]) == topic_len);
+  fail_unless(!memcmp(&body[2], topic, topic_len));
+  if (qos) {
+    pkt_id = (u16_t)((body[2 + topic_len] << 8) | body[3 + topic_len]);
+  }
+  fail_unless(!memcmp(&body[hdr_len], payload, payload_len));
+  return pkt_id;
+}
+
+/* Acknowledge a publish with packet id by PUBACK */
+static void
+test_mqtt_broker_puback(u16_t pkt_id)
+{
+  u8_t puback[] = {0x40, 0x02, 0x00, 0x00};
+  puback[2] = (u8_t)(pkt_id >> 8);
+  puback[3] = (u8_t)pkt_id;
+  test_mqtt_broker_send(puback, sizeof(puback), TCP_ACK | TCP_PSH);
+}
+
+/* Let the MQTT cyclic timer run */
+static void
+test_mqtt_cyclic_timer(int count)
+{
+  while (count-- > 0) {
+    lwip_sys_now += MQTT_CYCLIC_TIMER_INTERVAL * 1000;
+    sys_check_timeouts();
+  }
+}
+
 /* Setups/teardown functions */
 static struct netif *old_netif_list;
 static struct netif *old_netif_default;
+/* only the timers of the client run in these tests */
+#if LWIP_TIMERS_WHEEL
+static struct sys_timeo_wheel old_wheel;
+#else
+static struct sys_timeo *old_list_head;
+#endif
 
 static void
 mqtt_setup(void)
@@ -48,16 +238,37 @@ mqtt_setup(void)
   netif_list = NULL;
   netif_default = NULL;
   lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+#if LWIP_TIMERS_WHEEL
+  old_wheel = *sys_timeouts_get_wheel();
+  memset(sys_timeouts_get_wheel(), 0, sizeof(old_wheel));
+#else
+  old_list_head = *sys_timeouts_get_next_timeout();
+  *sys_timeouts_get_next_timeout() = NULL;
+#endif
+  brk_rx_len = 0;
+  brk_rx_parsed = 0;
+  brk_rx_segs = 0;
+  cli_port = 0;
+  zc_data = NULL;
+  zc_bytes = 0;
+  brk_hold = 0;
+  brk_held_num = 0;
 }
 
 static void
 mqtt_teardown(void)
 {
+  tcp_remove_all();
   netif_list = NULL;
   netif_default = NULL;
   /* restore netif_list for next tests (e.g. loopif) */
   netif_list = old_netif_list;
   netif_default = old_netif_default;
+#if LWIP_TIMERS_WHEEL
+  *sys_timeouts_get_wheel() = old_wheel;
+#else
+  *sys_timeouts_get_next_timeout() = old_list_head;
+#endif
   lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
 }
 
@@ -68,6 +279,59 @@ static void test_mqtt_connection_cb(mqtt_client_t *client, void *arg, mqtt_conne
   LWIP_UNUSED_ARG(status);
 }
 
+static int test_mqtt_req_calls;
+static err_t test_mqtt_req_err;
+
+static void test_mqtt_request_cb(void *arg, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  test_mqtt_req_calls++;
+  test_mqtt_req_err = err;
+}
+
+/* Connect a (new or disconnected) client to the stand-in broker */
+static void
+test_mqtt_broker_connect_client(mqtt_client_t *client, u16_t receive_maximum)
+{
+  struct mqtt_connect_client_info_t client_info = {
+    "dumm",
+    NULL, NULL,
+    0,
+    NULL, NULL, 0, 0,
+    0
+  };
+  static const u8_t connack[] = {0x20, 0x02, 0x00, 0x00};
+  const u8_t *body;
+  u32_t len;
+
+  test_tcp_init_netif(&broker_netif, NULL, &test_mqtt_local_ip, &test_mqtt_netmask);
+  broker_netif.output = test_mqtt_broker_output;
+  test_mqtt_req_calls = 0;
+  client_info.receive_maximum = receive_maximum;
+  brk_rx_len = 0;
+  brk_rx_parsed = 0;
+  cli_port = 0;
+
+  fail_unless(mqtt_client_connect(client, &test_mqtt_remote_ip, MQTT_PORT, test_mqtt_connection_cb, NULL, &client_info) == ERR_OK);
+  fail_unless(cli_port != 0);
+  brk_nxt = 0x5000;
+  test_mqtt_broker_send(NULL, 0, TCP_SYN | TCP_ACK);
+  brk_nxt++;
+  fail_unless(test_mqtt_broker_next(&body, &len) == 0x10);
+  test_mqtt_broker_send(connack, sizeof(connack), TCP_ACK | TCP_PSH);
+  fail_unless(mqtt_client_is_connected(client));
+}
+
+/* Connect a new client to the stand-in broker */
+static mqtt_client_t *
+test_mqtt_broker_connect(u16_t receive_maximum)
+{
+  mqtt_client_t *client = mqtt_client_new();
+  fail_unless(client != NULL);
+  test_mqtt_broker_connect_client(client, receive_maximum);
+  return client;
+}
+
 START_TEST(basic_connect)
 {
   mqtt_client_t* client;
@@ -77,7 +341,8 @@ START_TEST(basic_connect)
     "dumm",
     NULL, NULL,
     10,
-    NULL, NULL, 0, 0
+    NULL, NULL, 0, 0,
+    0
   };
   struct pbuf *p;
   unsigned char rxbuf[] = {0x20, 0x02, 0x00, 0x00};
@@ -106,10 +371,289 @@ START_TEST(basic_connect)
 }
 END_TEST
 
+/** Referenced payloads are sent without copying and released when acknowledged */
+START_TEST(publish_ref)
+{
+  static u8_t payload[1000];
+  mqtt_client_t *client;
+  u8_t puback[] = {0x40, 0x02, 0x00, 0x00};
+  u16_t pkt_id;
+  u16_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < sizeof(payload); i++) {
+    payload[i] = (u8_t)i;
+  }
+  client = test_mqtt_broker_connect(0);
+  zc_data = payload;
+  zc_len = sizeof(payload);
+
+  /* QoS 0: the payload is larger than the output ring buffer */
+  fail_unless(sizeof(payload) > MQTT_OUTPUT_RINGBUF_SIZE);
+  fail_unless(mqtt_publish_ref(client, "big", payload, sizeof(payload), 0, 0, test_mqtt_request_cb, NULL) == ERR_OK);
+  fail_unless(test_mqtt_req_calls == 0);
+  test_mqtt_broker_ack_all();
+  fail_unless(test_mqtt_req_calls == 1);
+  fail_unless(test_mqtt_req_err == ERR_OK);
+  test_mqtt_broker_check_publish("big", payload, sizeof(payload), 0);
+  fail_unless(zc_bytes == sizeof(payload));
+
+  /* QoS 1: complete when acknowledged by PUBACK */
+  zc_bytes = 0;
+  fail_unless(mqtt_publish_ref(client, "big", payload, sizeof(payload), 1, 0, test_mqtt_request_cb, NULL) == ERR_OK);
+  test_mqtt_broker_ack_all();
+  fail_unless(test_mqtt_req_calls == 1);
+  pkt_id = test_mqtt_broker_check_publish("big", payload, sizeof(payload), 1);
+  fail_unless(zc_bytes == sizeof(payload));
+  puback[2] = (u8_t)(pkt_id >> 8);
+  puback[3] = (u8_t)pkt_id;
+  test_mqtt_broker_send(puback, sizeof(puback), TCP_ACK | TCP_PSH);
+  fail_unless(test_mqtt_req_calls == 2);
+  fail_unless(test_mqtt_req_err == ERR_OK);
+
+  mqtt_disconnect(client);
+  mqtt_client_free(client);
+}
+END_TEST
+
+/** Referenced payloads are released when the connection is closed */
+START_TEST(publish_ref_disconnect)
+{
+  static const u8_t payload[600] = {1, 2, 3};
+  mqtt_client_t *client;
+  LWIP_UNUSED_ARG(_i);
+
+  client = test_mqtt_broker_connect(0);
+  fail_unless(mqtt_publish_ref(client, "t", payload, sizeof(payload), 1, 0, test_mqtt_request_cb, NULL) == ERR_OK);
+  fail_unless(mqtt_publish_ref(client, "t", payload, sizeof(payload), 0, 0, test_mqtt_request_cb, NULL) == ERR_OK);
+  fail_unless(test_mqtt_req_calls == 0);
+  mqtt_disconnect(client);
+  fail_unless(test_mqtt_req_calls == 2);
+  fail_unless(test_mqtt_req_err == ERR_CONN);
+  mqtt_client_free(client);
+}
+END_TEST
+
+/** Referenced payloads still held by the netif driver when the connection is
+ * closed are given back only once the driver has released them */
+START_TEST(publish_ref_disconnect_held)
+{
+  static const u8_t payload[600] = {1, 2, 3};
+  mqtt_client_t *client;
+  u16_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  client = test_mqtt_broker_connect(0);
+  brk_hold = 1;
+  fail_unless(mqtt_publish_ref(client, "t", payload, sizeof(payload), 1, 0, test_mqtt_request_cb, NULL) == ERR_OK);
+  brk_hold = 0;
+  fail_unless(brk_held_num > 0);
+  mqtt_disconnect(client);
+  fail_unless(test_mqtt_req_calls == 0);
+  fail_unless(client->output_ref_list[0].state != 0);
+
+  /* reconnecting keeps the slot, so the driver's references stay valid */
+  test_mqtt_broker_connect_client(client, 0);
+  fail_unless(client->output_ref_list[0].state != 0);
+  lwip_sys_now += 1000;
+  sys_check_timeouts();
+  fail_unless(test_mqtt_req_calls == 0);
+
+  for (i = 0; i < brk_held_num; i++) {
+    pbuf_free(brk_held[i]);
+  }
+  brk_held_num = 0;
+  lwip_sys_now += 1000;
+  sys_check_timeouts();
+  fail_unless(test_mqtt_req_calls == 1);
+  fail_unless(test_mqtt_req_err == ERR_CONN);
+  fail_unless(client->output_ref_list[0].state == 0);
+
+  mqtt_disconnect(client);
+  mqtt_client_free(client);
+}
+END_TEST
+
+/** Batched messages are sent in one segment, also if the ring buffer wraps */
+START_TEST(publish_batch)
+{
+  static const char data[150] = "x";
+  struct mqtt_publish_msg_t msgs[MQTT_REQ_MAX_IN_FLIGHT + 2];
+  char payloads[LWIP_ARRAYSIZE(msgs)][32];
+  mqtt_client_t *client;
+  u32_t segs;
+  u16_t queued, i;
+  LWIP_UNUSED_ARG(_i);
+
+  client = test_mqtt_broker_connect(0);
+  /* move the ring buffer indexes to its middle */
+  fail_unless(mqtt_publish(client, "t", data, sizeof(data), 0, 0, NULL, NULL) == ERR_OK);
+  test_mqtt_broker_ack_all();
+  test_mqtt_broker_check_publish("t", data, sizeof(data), 0);
+
+  memset(msgs, 0, sizeof(msgs));
+  for (i = 0; i < LWIP_ARRAYSIZE(msgs); i++) {
+    memset(payloads[i], 'a' + i, sizeof(payloads[i]));
+    msgs[i].topic = "batch";
+    msgs[i].payload = payloads[i];
+    msgs[i].payload_length = sizeof(payloads[i]);
+    msgs[i].cb = test_mqtt_request_cb;
+  }
+  /* messages are queued until the requests run out */
+  segs = brk_rx_segs;
+  fail_unless(MQTT_REQ_MAX_IN_FLIGHT * (2 + 2 + 5 + 32) + sizeof(data) > MQTT_OUTPUT_RINGBUF_SIZE);
+  fail_unless(mqtt_publish_batch(client, msgs, LWIP_ARRAYSIZE(msgs), &queued) == ERR_MEM);
+  fail_unless(queued == MQTT_REQ_MAX_IN_FLIGHT);
+  fail_unless(brk_rx_segs == segs + 1);
+  test_mqtt_broker_ack_all();
+  fail_unless(test_mqtt_req_calls == MQTT_REQ_MAX_IN_FLIGHT);
+  fail_unless(mqtt_publish_batch(client, &msgs[queued], (u16_t)(LWIP_ARRAYSIZE(msgs) - queued), &queued) == ERR_OK);
+  fail_unless(queued == LWIP_ARRAYSIZE(msgs) - MQTT_REQ_MAX_IN_FLIGHT);
+  fail_unless(brk_rx_segs == segs + 2);
+  test_mqtt_broker_ack_all();
+  fail_unless(test_mqtt_req_calls == LWIP_ARRAYSIZE(msgs));
+
+  for (i = 0; i < LWIP_ARRAYSIZE(msgs); i++) {
+    test_mqtt_broker_check_publish("batch", payloads[i], sizeof(payloads[i]), 0);
+  }
+  mqtt_disconnect(client);
+  mqtt_client_free(client);
+}
+END_TEST
+
+/** Sustained QoS 1 publishing keeps the full window in flight, acknowledged in any order */
+START_TEST(publish_window)
+{
+  static const char payload[] = "0123456789";
+  static const u16_t receive_maximums[] = {0, 2};
+  u8_t suback[] = {0x90, 0x03, 0x00, 0x00, 0x01};
+  u8_t unsuback[] = {0xB0, 0x02, 0x00, 0x00};
+  u16_t in_flight[MQTT_REQ_MAX_IN_FLIGHT];
+  mqtt_client_t *client;
+  const u8_t *body;
+  u32_t len;
+  int published, rounds, n, i, j, k;
+  LWIP_UNUSED_ARG(_i);
+
+  for (k = 0; k < (int)LWIP_ARRAYSIZE(receive_maximums); k++) {
+    u16_t receive_maximum = receive_maximums[k];
+    int window = receive_maximum ? receive_maximum : MQTT_REQ_MAX_IN_FLIGHT;
+    client = test_mqtt_broker_connect(receive_maximum);
+    /* let packet identifiers wrap */
+    client->pkt_id_seq = 0xFFF0;
+    published = 0;
+    rounds = 0;
+    while (published < 200) {
+      /* fill the window */
+      n = 0;
+      while (mqtt_publish(client, "win", payload, sizeof(payload), 1, 0, test_mqtt_request_cb, NULL) == ERR_OK) {
+        n++;
+        published++;
+      }
+      fail_unless(n == window);
+      if (receive_maximum) {
+        /* other requests are not limited by the receive maximum */
+        fail_unless(mqtt_subscribe(client, "sub", 1, NULL, NULL) == ERR_OK);
+        fail_unless(mqtt_unsubscribe(client, "sub", NULL, NULL) == ERR_OK);
+      }
+      test_mqtt_broker_ack_all();
+      for (i = 0; i < n; i++) {
+        in_flight[i] = test_mqtt_broker_check_publish("win", payload, sizeof(payload), 1);
+        fail_unless(in_flight[i] != 0);
+        for (j = 0; j < i; j++) {
+          fail_unless(in_flight[i] != in_flight[j]);
+        }
+      }
+      /* acknowledge in reverse order */
+      for (i = n - 1; i >= 0; i--) {
+        test_mqtt_broker_puback(in_flight[i]);
+        /* acknowledging twice has no effect */
+        test_mqtt_broker_puback(in_flight[i]);
+      }
+      fail_unless(test_mqtt_req_calls == published);
+      fail_unless(test_mqtt_req_err == ERR_OK);
+      if (receive_maximum) {
+        fail_unless(test_mqtt_broker_next(&body, &len) == 0x82);
+        suback[2] = body[0];
+        suback[3] = body[1];
+        fail_unless(test_mqtt_broker_next(&body, &len) == 0xA2);
+        unsuback[2] = body[0];
+        unsuback[3] = body[1];
+        test_mqtt_broker_send(suback, sizeof(suback), TCP_ACK | TCP_PSH);
+        test_mqtt_broker_send(unsuback, sizeof(unsuback), TCP_ACK | TCP_PSH);
+      }
+      rounds++;
+    }
+    /* the throughput is a full window per round trip */
+    fail_unless(rounds == (200 + window - 1) / window);
+    fail_unless(client->pkt_id_seq < 0xFFF0);
+
+    mqtt_disconnect(client);
+    mqtt_client_free(client);
+    tcp_remove_all();
+    brk_rx_len = 0;
+    brk_rx_parsed = 0;
+  }
+}
+END_TEST
+
+/** Requests time out in order of creation, acknowledged ones are removed */
+START_TEST(request_timeout)
+{
+  static const u8_t data[] = "d";
+  mqtt_client_t *client;
+  u16_t id1, id2, id3;
+  LWIP_UNUSED_ARG(_i);
+
+  client = test_mqtt_broker_connect(0);
+  fail_unless(mqtt_publish(client, "t", data, sizeof(data), 1, 0, test_mqtt_request_cb, NULL) == ERR_OK);
+  fail_unless(mqtt_publish(client, "t", data, sizeof(data), 1, 0, test_mqtt_request_cb, NULL) == ERR_OK);
+  test_mqtt_broker_ack_all();
+  id1 = test_mqtt_broker_check_publish("t", data, sizeof(data), 1);
+  id2 = test_mqtt_broker_check_publish("t", data, sizeof(data), 1);
+  test_mqtt_cyclic_timer(MQTT_REQ_TIMEOUT / MQTT_CYCLIC_TIMER_INTERVAL / 2);
+  fail_unless(mqtt_publish(client, "t", data, sizeof(data), 1, 0, test_mqtt_request_cb, NULL) == ERR_OK);
+  test_mqtt_broker_ack_all();
+  id3 = test_mqtt_broker_check_publish("t", data, sizeof(data), 1);
+  fail_unless(test_mqtt_req_calls == 0);
+
+  /* the first request is acknowledged, the second one times out */
+  test_mqtt_broker_puback(id1);
+  fail_unless(test_mqtt_req_calls == 1);
+  fail_unless(test_mqtt_req_err == ERR_OK);
+  test_mqtt_cyclic_timer(MQTT_REQ_TIMEOUT / MQTT_CYCLIC_TIMER_INTERVAL - MQTT_REQ_TIMEOUT / MQTT_CYCLIC_TIMER_INTERVAL / 2 - 1);
+  fail_unless(test_mqtt_req_calls == 1);
+  test_mqtt_cyclic_timer(1);
+  fail_unless(test_mqtt_req_calls == 2);
+  fail_unless(test_mqtt_req_err == ERR_TIMEOUT);
+  /* a late acknowledge is ignored */
+  test_mqtt_broker_puback(id2);
+  fail_unless(test_mqtt_req_calls == 2);
+
+  /* the third request times out later */
+  test_mqtt_cyclic_timer(MQTT_REQ_TIMEOUT / MQTT_CYCLIC_TIMER_INTERVAL / 2 - 1);
+  fail_unless(test_mqtt_req_calls == 2);
+  test_mqtt_cyclic_timer(1);
+  fail_unless(test_mqtt_req_calls == 3);
+  fail_unless(test_mqtt_req_err == ERR_TIMEOUT);
+  test_mqtt_broker_puback(id3);
+  fail_unless(test_mqtt_req_calls == 3);
+
+  mqtt_disconnect(client);
+  mqtt_client_free(client);
+}
+END_TEST
+
 Suite* mqtt_suite(void)
 {
   testfunc tests[] = {
     TESTFUNC(basic_connect),
+    TESTFUNC(publish_ref),
+    TESTFUNC(publish_ref_disconnect),
+    TESTFUNC(publish_ref_disconnect_held),
+    TESTFUNC(publish_batch),
+    TESTFUNC(publish_window),
+    TESTFUNC(request_timeout),
   };
   return create_suite("MQTT", tests, sizeof(tests)/sizeof(testfunc), mqtt_setup, mqtt_teardown);
 }
@@ -0,0 +1,207 @@
+#include "test_bridgeif.h"
+
+#include "netif/bridgeif.h"
+#include "lwip/mem.h"
+#include "arch/sys_arch.h"
+
+#define TEST_FDB_ENTRIES  512
+#define TEST_FDB_PORTS    4
+#define TEST_FDB_TIMEOUT  (5 * 60 * 1000)
+
+#if !BRIDGEIF_FDB_PORT_MAX_ENTRIES || !BRIDGEIF_FDB_PORT_LEARN_RATE
+#error "This tests needs BRIDGEIF_FDB_PORT_MAX_ENTRIES and BRIDGEIF_FDB_PORT_LEARN_RATE"
+#endif
+
+/* Synthetic station addresses: a few vendors with sequential NIC parts */
+static void
+test_bridgeif_station(struct eth_addr *addr, u32_t station)
+{
+  addr->addr[0] = (u8_t)(((station % 3) << 2) & 0xfc);
+  addr->addr[1] = 0x11;
+  addr->addr[2] = (u8_t)(0x20 + station % 3);
+  addr->addr[3] = (u8_t)(station >> 16);
+  addr->addr[4] = (u8_t)(station >> 8);
+  addr->addr[5] = (u8_t)station;
+}
+
+static bridgeif_portmask_t
+test_bridgeif_lookup(void *fdb, u32_t station)
+{
+  struct eth_addr addr;
+  test_bridgeif_station(&addr, station);
+  return bridgeif_fdb_get_dst_ports(fdb, &addr);
+}
+
+static void
+test_bridgeif_learn(void *fdb, u32_t station, u8_t port)
+{
+  struct eth_addr addr;
+  test_bridgeif_station(&addr, station);
+  bridgeif_fdb_update_src(fdb, &addr, port);
+}
+
+/* Learn stations [first..first+count) on port (station % TEST_FDB_PORTS),
+   letting time pass so that the learning rate limit is not hit */
+static void
+test_bridgeif_learn_all(void *fdb, u32_t first, u32_t count)
+{
+  u32_t i;
+  for (i = 0; i < count; i++) {
+    if ((i % (BRIDGEIF_FDB_PORT_LEARN_RATE * TEST_FDB_PORTS)) == 0) {
+      lwip_sys_now += 1000;
+    }
+    test_bridgeif_learn(fdb, first + i, (u8_t)((first + i) % TEST_FDB_PORTS));
+  }
+}
+
+/* Setups/teardown functions */
+
+static void
+bridgeif_setup(void)
+{
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+bridgeif_teardown(void)
+{
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* Test functions */
+
+/** Forward a stream of frames between many stations, every frame is sent to the
+ * port its destination was learnt on */
+START_TEST(test_bridgeif_fdb_forward)
+{
+  void *fdb;
+  u32_t i, src, dst;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(TEST_FDB_ENTRIES / TEST_FDB_PORTS <= BRIDGEIF_FDB_PORT_MAX_ENTRIES);
+  fdb = bridgeif_fdb_init(TEST_FDB_ENTRIES);
+  fail_unless(fdb != NULL);
+
+  test_bridgeif_learn_all(fdb, 0, TEST_FDB_ENTRIES);
+  for (i = 0; i < 100000; i++) {
+    /* frame from src to dst, as bridgeif_input() does */
+    src = (i * 7919) % TEST_FDB_ENTRIES;
+    dst = (i * 104729 + 13) % TEST_FDB_ENTRIES;
+    test_bridgeif_learn(fdb, src, (u8_t)(src % TEST_FDB_PORTS));
+    fail_unless(test_bridgeif_lookup(fdb, dst) == (1 << (dst % TEST_FDB_PORTS)));
+  }
+  /* unknown stations are flooded */
+  fail_unless(test_bridgeif_lookup(fdb, TEST_FDB_ENTRIES) == BR_FLOOD);
+  /* the table is full: new stations are not learnt */
+  test_bridgeif_learn(fdb, TEST_FDB_ENTRIES, 0);
+  fail_unless(test_bridgeif_lookup(fdb, TEST_FDB_ENTRIES) == BR_FLOOD);
+  /* a station moves to another port */
+  test_bridgeif_learn(fdb, 5, 3);
+  fail_unless(test_bridgeif_lookup(fdb, 5) == (1 << 3));
+
+  mem_free(fdb);
+}
+END_TEST
+
+/** Entries expire when their station has not been seen for the timeout,
+ * expired entries are reused for new stations */
+START_TEST(test_bridgeif_fdb_aging)
+{
+  void *fdb;
+  u32_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  fdb = bridgeif_fdb_init(TEST_FDB_ENTRIES);
+  fail_unless(fdb != NULL);
+
+  test_bridgeif_learn_all(fdb, 0, TEST_FDB_ENTRIES);
+  lwip_sys_now += TEST_FDB_TIMEOUT / 2;
+  /* keep the first half alive */
+  for (i = 0; i < TEST_FDB_ENTRIES / 2; i++) {
+    test_bridgeif_learn(fdb, i, (u8_t)(i % TEST_FDB_PORTS));
+  }
+  lwip_sys_now += TEST_FDB_TIMEOUT / 2;
+  for (i = 0; i < TEST_FDB_ENTRIES; i++) {
+    fail_unless(test_bridgeif_lookup(fdb, i) == ((i < TEST_FDB_ENTRIES / 2) ? (1 << (i % TEST_FDB_PORTS)) : BR_FLOOD));
+  }
+  /* expired entries are reclaimed for new stations */
+  test_bridgeif_learn_all(fdb, TEST_FDB_ENTRIES, TEST_FDB_ENTRIES / 2);
+  for (i = 0; i < TEST_FDB_ENTRIES + TEST_FDB_ENTRIES / 2; i++) {
+    fail_unless(test_bridgeif_lookup(fdb, i) == ((i < TEST_FDB_ENTRIES / 2) || (i >= TEST_FDB_ENTRIES) ?
+                                                 (1 << (i % TEST_FDB_PORTS)) : BR_FLOOD));
+  }
+  /* the table is full again, until more entries expire */
+  test_bridgeif_learn(fdb, TEST_FDB_ENTRIES - 1, 1);
+  fail_unless(test_bridgeif_lookup(fdb, TEST_FDB_ENTRIES - 1) == BR_FLOOD);
+  lwip_sys_now += TEST_FDB_TIMEOUT;
+  test_bridgeif_learn(fdb, TEST_FDB_ENTRIES - 1, 1);
+  fail_unless(test_bridgeif_lookup(fdb, TEST_FDB_ENTRIES - 1) == (1 << 1));
+
+  mem_free(fdb);
+}
+END_TEST
+
+/** One port cannot learn more than its limits */
+START_TEST(test_bridgeif_fdb_learn_limits)
+{
+  void *fdb;
+  u32_t i, j, learnt;
+  LWIP_UNUSED_ARG(_i);
+
+  fdb = bridgeif_fdb_init(TEST_FDB_ENTRIES);
+  fail_unless(fdb != NULL);
+
+  /* a flood of new source addresses on port 0 is rate limited */
+  lwip_sys_now = (lwip_sys_now / 1000 + 1) * 1000;
+  for (i = 0; i < TEST_FDB_ENTRIES; i++) {
+    test_bridgeif_learn(fdb, i * TEST_FDB_PORTS, 0);
+  }
+  learnt = 0;
+  for (i = 0; i < TEST_FDB_ENTRIES; i++) {
+    if (test_bridgeif_lookup(fdb, i * TEST_FDB_PORTS) != BR_FLOOD) {
+      learnt++;
+    }
+  }
+  fail_unless(learnt == BRIDGEIF_FDB_PORT_LEARN_RATE);
+  /* other ports still learn */
+  test_bridgeif_learn(fdb, 1, 1);
+  fail_unless(test_bridgeif_lookup(fdb, 1) == (1 << 1));
+  /* known addresses are still updated */
+  test_bridgeif_learn(fdb, 0, 0);
+  fail_unless(test_bridgeif_lookup(fdb, 0) == (1 << 0));
+
+  /* over time, the number of addresses per port is limited */
+  for (j = 0; j < 10; j++) {
+    lwip_sys_now += 1000;
+    for (i = 0; i < TEST_FDB_ENTRIES; i++) {
+      test_bridgeif_learn(fdb, i * TEST_FDB_PORTS, 0);
+    }
+  }
+  learnt = 0;
+  for (i = 0; i < TEST_FDB_ENTRIES; i++) {
+    if (test_bridgeif_lookup(fdb, i * TEST_FDB_PORTS) != BR_FLOOD) {
+      learnt++;
+    }
+  }
+  fail_unless(learnt == BRIDGEIF_FDB_PORT_MAX_ENTRIES);
+  /* moving a station frees a place on its old port */
+  test_bridgeif_learn(fdb, 0, 1);
+  lwip_sys_now += 1000;
+  test_bridgeif_learn(fdb, (TEST_FDB_ENTRIES - 1) * TEST_FDB_PORTS, 0);
+  fail_unless(test_bridgeif_lookup(fdb, (TEST_FDB_ENTRIES - 1) * TEST_FDB_PORTS) == (1 << 0));
+
+  mem_free(fdb);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+bridgeif_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_bridgeif_fdb_forward),
+    TESTFUNC(test_bridgeif_fdb_aging),
+    TESTFUNC(test_bridgeif_fdb_learn_limits),
+  };
+  return create_suite("BRIDGEIF", tests, sizeof(tests)/sizeof(testfunc), bridgeif_setup, bridgeif_teardown);
+}
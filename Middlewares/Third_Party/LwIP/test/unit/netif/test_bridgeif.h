@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_BRIDGEIF_H
+#define LWIP_HDR_TEST_BRIDGEIF_H
+
+#include "../lwip_check.h"
+
+Suite *bridgeif_suite(void);
+
+#endif
@@ -5,6 +5,9 @@
 #include "lwip/pbuf.h"
 #include "lwip/inet_chksum.h"
 #include "lwip/ip_addr.h"
+#include "lwip/ip4.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/tcp.h"
 
 #if !LWIP_STATS || !TCP_STATS || !MEMP_STATS
 #error "This tests needs TCP- and MEMP-statistics enabled"
@@ -14,6 +17,8 @@ const ip_addr_t test_local_ip = IPADDR4_INIT_BYTES(192, 168, 1, 1);
 const ip_addr_t test_remote_ip = IPADDR4_INIT_BYTES(192, 168, 1, 2);
 const ip_addr_t test_netmask = IPADDR4_INIT_BYTES(255, 255, 255, 0);
 
+extern u32_t lwip_sys_now;
+
 /** Remove all pcbs on the given list. */
 static void
 tcp_remove(struct tcp_pcb* pcb_list)
@@ -46,21 +51,24 @@ tcp_remove_all(void)
 static struct pbuf*
 tcp_create_segment_wnd(ip_addr_t* src_ip, ip_addr_t* dst_ip,
                    u16_t src_port, u16_t dst_port, void* data, size_t data_len,
-                   u32_t seqno, u32_t ackno, u8_t headerflags, u16_t wnd)
+                   u32_t seqno, u32_t ackno, u8_t headerflags, u16_t wnd,
+                   const u8_t* opts, u8_t optlen)
 {
   struct pbuf *p, *q;
   struct ip_hdr* iphdr;
   struct tcp_hdr* tcphdr;
-  u16_t pbuf_len = (u16_t)(sizeof(struct ip_hdr) + sizeof(struct tcp_hdr) + data_len);
+  u16_t hdr_len = (u16_t)(sizeof(struct tcp_hdr) + optlen);
+  u16_t pbuf_len = (u16_t)(sizeof(struct ip_hdr) + hdr_len + data_len);
   LWIP_ASSERT("data_len too big", data_len <= 0xFFFF);
+  LWIP_ASSERT("optlen must be a multiple of 4", (optlen & 3) == 0);
 
   p = pbuf_alloc(PBUF_RAW, pbuf_len, PBUF_POOL);
   EXPECT_RETNULL(p != NULL);
   /* first pbuf must be big enough to hold the headers */
-  EXPECT_RETNULL(p->len >= (sizeof(struct ip_hdr) + sizeof(struct tcp_hdr)));
+  EXPECT_RETNULL(p->len >= (sizeof(struct ip_hdr) + hdr_len));
   if (data_len > 0) {
     /* first pbuf must be big enough to hold at least 1 data byte, too */
-    EXPECT_RETNULL(p->len > (sizeof(struct ip_hdr) + sizeof(struct tcp_hdr)));
+    EXPECT_RETNULL(p->len > (sizeof(struct ip_hdr) + hdr_len));
   }
 
   for(q = p; q != NULL; q = q->next) {
@@ -84,17 +92,20 @@ tcp_create_segment_wnd(ip_addr_t* src_ip, ip_addr_t* dst_ip,
   tcphdr->dest  = htons(dst_port);
   tcphdr->seqno = htonl(seqno);
   tcphdr->ackno = htonl(ackno);
-  TCPH_HDRLEN_SET(tcphdr, sizeof(struct tcp_hdr)/4);
+  TCPH_HDRLEN_SET(tcphdr, hdr_len/4);
   TCPH_FLAGS_SET(tcphdr, headerflags);
   tcphdr->wnd   = htons(wnd);
+  if (optlen > 0) {
+    MEMCPY(tcphdr + 1, opts, optlen);
+  }
 
   if (data_len > 0) {
     /* let p point to TCP data */
-    pbuf_header(p, -(s16_t)sizeof(struct tcp_hdr));
+    pbuf_header(p, -(s16_t)hdr_len);
     /* copy data */
     pbuf_take(p, data, (u16_t)data_len);
     /* let p point to TCP header again */
-    pbuf_header(p, sizeof(struct tcp_hdr));
+    pbuf_header(p, hdr_len);
   }
 
   /* calculate checksum */
@@ -114,7 +125,7 @@ tcp_create_segment(ip_addr_t* src_ip, ip_addr_t* dst_ip,
                    u32_t seqno, u32_t ackno, u8_t headerflags)
 {
   return tcp_create_segment_wnd(src_ip, dst_ip, src_port, dst_port, data,
-    data_len, seqno, ackno, headerflags, TCP_WND);
+    data_len, seqno, ackno, headerflags, TCP_WND, NULL, 0);
 }
 
 /** Create a TCP segment usable for passing to tcp_input
@@ -138,7 +149,21 @@ struct pbuf* tcp_create_rx_segment_wnd(struct tcp_pcb* pcb, void* data, size_t d
                    u32_t seqno_offset, u32_t ackno_offset, u8_t headerflags, u16_t wnd)
 {
   return tcp_create_segment_wnd(&pcb->remote_ip, &pcb->local_ip, pcb->remote_port, pcb->local_port,
-    data, data_len, pcb->rcv_nxt + seqno_offset, pcb->lastack + ackno_offset, headerflags, wnd);
+    data, data_len, pcb->rcv_nxt + seqno_offset, pcb->lastack + ackno_offset, headerflags, wnd, NULL, 0);
+}
+
+/** Create a TCP segment usable for passing to tcp_input
+ * - IP-addresses, ports, seqno and ackno are taken from pcb
+ * - seqno and ackno can be altered with an offset
+ * - TCP options are copied from 'opts' (optlen must be a multiple of 4)
+ */
+struct pbuf* tcp_create_rx_segment_opts(struct tcp_pcb* pcb, void* data, size_t data_len,
+                   u32_t seqno_offset, u32_t ackno_offset, u8_t headerflags,
+                   const u8_t* opts, u8_t optlen)
+{
+  return tcp_create_segment_wnd(&pcb->remote_ip, &pcb->local_ip, pcb->remote_port, pcb->local_port,
+    data, data_len, pcb->rcv_nxt + seqno_offset, pcb->lastack + ackno_offset, headerflags, TCP_WND,
+    opts, optlen);
 }
 
 /** Safely bring a tcp_pcb into the requested state */
@@ -158,22 +183,23 @@ tcp_set_state(struct tcp_pcb* pcb, enum tcp_state state, const ip_addr_t* local_
   pcb->lastack = iss;
   pcb->snd_lbb = iss;
   
+  /* register after setting addresses and ports (TCP_PCB_HASH indexes by them) */
   if (state == ESTABLISHED) {
-    TCP_REG(&tcp_active_pcbs, pcb);
     ip_addr_copy(pcb->local_ip, *local_ip);
     pcb->local_port = local_port;
     ip_addr_copy(pcb->remote_ip, *remote_ip);
     pcb->remote_port = remote_port;
+    TCP_REG(&tcp_active_pcbs, pcb);
   } else if(state == LISTEN) {
-    TCP_REG(&tcp_listen_pcbs.pcbs, pcb);
     ip_addr_copy(pcb->local_ip, *local_ip);
     pcb->local_port = local_port;
+    TCP_REG(&tcp_listen_pcbs.pcbs, pcb);
   } else if(state == TIME_WAIT) {
-    TCP_REG(&tcp_tw_pcbs, pcb);
     ip_addr_copy(pcb->local_ip, *local_ip);
     pcb->local_port = local_port;
     ip_addr_copy(pcb->remote_ip, *remote_ip);
     pcb->remote_port = remote_port;
+    TCP_REG(&tcp_tw_pcbs, pcb);
   } else {
     fail();
   }
@@ -317,3 +343,286 @@ void test_tcp_init_netif(struct netif *netif, struct test_tcp_txcounters *txcoun
   netif->next = NULL;
   netif_list = netif;
 }
+
+/* Deterministic link simulation: the sender (10.0.0.1 on netif 'a') talks to
+   10.0.0.2, the receiver (10.0.1.1 on netif 'b') sees it as 10.0.1.2. Each
+   direction is a link with propagation delay, a bottleneck rate, a drop-tail
+   queue and random loss; addresses are rewritten on delivery. Which data is
+   lost only depends on its position in the stream and the seed: the first
+   transmission of an MSS-sized block is dropped with the configured
+   probability, retransmissions always arrive. This way, runs compared with
+   each other lose the same data instead of whatever packets happen to meet
+   the same random numbers. */
+#define TEST_LINK_QLEN  32
+
+struct test_link {
+  struct netif *to;
+  ip_addr_t src, dst;
+  struct pbuf *q[TEST_LINK_QLEN];
+  u32_t due[TEST_LINK_QLEN];
+  u16_t head, count;
+  u32_t busy_until;
+  u32_t delay;
+  u32_t rate;
+  u16_t loss;
+  u32_t seed;
+  /* initial sequence number and next new sequence number sent */
+  u32_t isn, snd_max;
+  u32_t data, lost;
+};
+
+static struct test_link test_link_ab, test_link_ba;
+
+/* Decide whether the first transmission of the data at stream offset 'off'
+   is lost */
+static int
+test_link_lose(const struct test_link *link, u32_t off)
+{
+  u32_t r = (off / TCP_MSS + 1) * 2654435761UL + link->seed * 40503UL;
+  r ^= r >> 15;
+  r *= 2246822519UL;
+  r ^= r >> 13;
+  return ((r >> 16) % 1000) < link->loss;
+}
+
+static err_t
+test_link_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  struct test_link *link = (struct test_link *)netif->state;
+  struct ip_hdr *iphdr = (struct ip_hdr *)p->payload;
+  struct tcp_hdr *tcphdr = (struct tcp_hdr *)((u8_t *)p->payload + IPH_HL_BYTES(iphdr));
+  struct pbuf *q;
+  u32_t start, seqno;
+  u16_t len;
+  int lose;
+  LWIP_UNUSED_ARG(ipaddr);
+
+  len = (u16_t)(p->tot_len - IPH_HL_BYTES(iphdr) - TCPH_HDRLEN_BYTES(tcphdr));
+  seqno = lwip_ntohl(tcphdr->seqno);
+  if (TCPH_FLAGS(tcphdr) & TCP_SYN) {
+    link->isn = link->snd_max = seqno + 1;
+  }
+  link->data += len;
+  lose = (len > 0) && ((s32_t)(seqno - link->snd_max) >= 0) &&
+         test_link_lose(link, seqno - link->isn);
+  if ((len > 0) && ((s32_t)(seqno + len - link->snd_max) > 0)) {
+    link->snd_max = seqno + len;
+  }
+  if ((link->count == TEST_LINK_QLEN) || lose) {
+    link->lost += len;
+    return ERR_OK;
+  }
+  q = pbuf_clone(PBUF_RAW, PBUF_POOL, p);
+  fail_unless(q != NULL);
+  start = LWIP_MAX(lwip_sys_now, link->busy_until);
+  link->busy_until = start + p->tot_len / link->rate;
+  link->q[(link->head + link->count) % TEST_LINK_QLEN] = q;
+  link->due[(link->head + link->count) % TEST_LINK_QLEN] = link->busy_until + link->delay;
+  link->count++;
+  return ERR_OK;
+}
+
+static void
+test_link_deliver(struct test_link *link)
+{
+  while ((link->count > 0) && ((s32_t)(lwip_sys_now - link->due[link->head]) >= 0)) {
+    struct pbuf *p = link->q[link->head];
+    struct ip_hdr *iphdr = (struct ip_hdr *)p->payload;
+    struct tcp_hdr *tcphdr;
+    u16_t hlen = IPH_HL_BYTES(iphdr);
+
+    link->head = (u16_t)((link->head + 1) % TEST_LINK_QLEN);
+    link->count--;
+
+    ip4_addr_copy(iphdr->src, *ip_2_ip4(&link->src));
+    ip4_addr_copy(iphdr->dest, *ip_2_ip4(&link->dst));
+    IPH_CHKSUM_SET(iphdr, 0);
+    IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, hlen));
+    pbuf_remove_header(p, hlen);
+    tcphdr = (struct tcp_hdr *)p->payload;
+    tcphdr->chksum = 0;
+    tcphdr->chksum = ip_chksum_pseudo(p, IP_PROTO_TCP, p->tot_len, &link->src, &link->dst);
+    pbuf_add_header(p, hlen);
+    ip4_input(p, link->to);
+  }
+}
+
+static void
+test_link_flush(struct test_link *link)
+{
+  while (link->count > 0) {
+    pbuf_free(link->q[link->head]);
+    link->head = (u16_t)((link->head + 1) % TEST_LINK_QLEN);
+    link->count--;
+  }
+}
+
+static void
+test_link_netif(struct netif *netif, struct test_link *link, const char *addr, const char *mask)
+{
+  memset(netif, 0, sizeof(struct netif));
+  netif->state = link;
+  netif->output = test_link_output;
+  netif->mtu = 1500;
+  netif->flags = NETIF_FLAG_UP | NETIF_FLAG_LINK_UP;
+  ip4addr_aton(addr, ip_2_ip4(&netif->ip_addr));
+  ip4addr_aton(mask, ip_2_ip4(&netif->netmask));
+  netif->next = netif_list;
+  netif_list = netif;
+}
+
+#define TEST_SIM_PORT   5001
+
+static u8_t
+test_sim_byte(u32_t i)
+{
+  return (u8_t)(i ^ (i >> 8));
+}
+
+static void
+test_sim_write(struct test_tcp_sim *sim)
+{
+  u8_t buf[512];
+  while (sim->written < TEST_TCP_SIM_BYTES) {
+    u16_t i, len = (u16_t)LWIP_MIN(LWIP_MIN(sizeof(buf), tcp_sndbuf(sim->tx)), TEST_TCP_SIM_BYTES - sim->written);
+    if ((len == 0) || (tcp_sndqueuelen(sim->tx) >= TCP_SND_QUEUELEN - 2)) {
+      break;
+    }
+    for (i = 0; i < len; i++) {
+      buf[i] = test_sim_byte(sim->written + i);
+    }
+    if (tcp_write(sim->tx, buf, len, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+      break;
+    }
+    sim->written += len;
+  }
+  tcp_output(sim->tx);
+}
+
+static err_t
+test_sim_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+  LWIP_UNUSED_ARG(pcb);
+  LWIP_UNUSED_ARG(len);
+  test_sim_write((struct test_tcp_sim *)arg);
+  return ERR_OK;
+}
+
+static err_t
+test_sim_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+  struct test_tcp_sim *sim = (struct test_tcp_sim *)arg;
+  struct pbuf *q;
+  LWIP_UNUSED_ARG(err);
+  if (p == NULL) {
+    return ERR_OK;
+  }
+  for (q = p; q != NULL; q = q->next) {
+    u16_t i;
+    for (i = 0; i < q->len; i++) {
+      if (((u8_t *)q->payload)[i] != test_sim_byte(sim->received + i)) {
+        sim->corrupt = 1;
+      }
+    }
+    sim->received += q->len;
+  }
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static err_t
+test_sim_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+  struct test_tcp_sim *sim = (struct test_tcp_sim *)arg;
+  LWIP_UNUSED_ARG(err);
+  sim->rx = pcb;
+  tcp_arg(pcb, sim);
+  tcp_recv(pcb, test_sim_recv);
+  return ERR_OK;
+}
+
+/** Transfer TEST_TCP_SIM_BYTES over the simulated link described by 'sim',
+ * returns the goodput in bytes per second of simulated time */
+u32_t
+test_tcp_sim_run(struct test_tcp_sim *sim)
+{
+  struct netif a, b;
+  struct tcp_pcb *l;
+  ip_addr_t addr;
+  u32_t start;
+  u32_t cwnd_sum = 0, cwnd_samples = 0;
+
+  memset(&test_link_ab, 0, sizeof(test_link_ab));
+  memset(&test_link_ba, 0, sizeof(test_link_ba));
+  test_link_netif(&a, &test_link_ab, "10.0.0.1", "255.255.255.0");
+  test_link_netif(&b, &test_link_ba, "10.0.1.1", "255.255.255.0");
+  test_link_ab.to = &b;
+  IP_ADDR4(&test_link_ab.src, 10, 0, 1, 2);
+  IP_ADDR4(&test_link_ab.dst, 10, 0, 1, 1);
+  test_link_ba.to = &a;
+  IP_ADDR4(&test_link_ba.src, 10, 0, 0, 2);
+  IP_ADDR4(&test_link_ba.dst, 10, 0, 0, 1);
+  test_link_ab.delay = test_link_ba.delay = sim->delay;
+  test_link_ab.rate = test_link_ba.rate = sim->rate;
+  /* only data is lost, ACKs always arrive */
+  test_link_ab.loss = sim->loss;
+  test_link_ab.seed = sim->seed;
+
+  l = tcp_new();
+  fail_unless(l != NULL);
+  fail_unless(tcp_bind(l, &b.ip_addr, TEST_SIM_PORT) == ERR_OK);
+  l = tcp_listen(l);
+  fail_unless(l != NULL);
+  tcp_arg(l, sim);
+  tcp_accept(l, test_sim_accept);
+
+  sim->tx = tcp_new();
+  fail_unless(sim->tx != NULL);
+  if (sim->setup != NULL) {
+    sim->setup(sim);
+  }
+  tcp_arg(sim->tx, sim);
+  tcp_sent(sim->tx, test_sim_sent);
+  fail_unless(tcp_bind(sim->tx, &a.ip_addr, 0) == ERR_OK);
+  IP_ADDR4(&addr, 10, 0, 0, 2);
+  fail_unless(tcp_connect(sim->tx, &addr, TEST_SIM_PORT, NULL) == ERR_OK);
+
+  start = lwip_sys_now;
+  while ((sim->received < TEST_TCP_SIM_BYTES) && (lwip_sys_now - start < 600000)) {
+    lwip_sys_now++;
+    test_link_deliver(&test_link_ab);
+    test_link_deliver(&test_link_ba);
+    if ((sim->tx->state == ESTABLISHED) && (sim->written == 0)) {
+      if (sim->established != NULL) {
+        sim->established(sim);
+      }
+      test_sim_write(sim);
+    }
+    if (sim->written != 0) {
+      cwnd_sum += LWIP_MIN(sim->tx->cwnd, sim->tx->snd_wnd);
+      cwnd_samples++;
+    }
+    if ((lwip_sys_now - start) % TCP_TMR_INTERVAL == 0) {
+      tcp_tmr();
+    }
+  }
+  sim->elapsed = lwip_sys_now - start;
+  sim->tx_data = test_link_ab.data;
+  sim->tx_lost = test_link_ab.lost;
+  sim->cwnd_avg = cwnd_sum / LWIP_MAX(cwnd_samples, 1);
+  fail_unless(sim->received == TEST_TCP_SIM_BYTES);
+  fail_unless(!sim->corrupt);
+
+  tcp_abort(sim->tx);
+  sim->tx = NULL;
+  if (sim->rx != NULL) {
+    tcp_abort(sim->rx);
+    sim->rx = NULL;
+  }
+  tcp_close(l);
+  test_link_flush(&test_link_ab);
+  test_link_flush(&test_link_ba);
+  netif_list = NULL;
+  return (TEST_TCP_SIM_BYTES * 1000UL) / LWIP_MAX(sim->elapsed, 1);
+}
@@ -26,6 +26,31 @@ struct test_tcp_txcounters {
   struct pbuf *tx_packets;
 };
 
+/* A transfer over the deterministic link simulation, see test_tcp_sim_run() */
+#define TEST_TCP_SIM_BYTES  60000
+
+struct test_tcp_sim {
+  /* link (per direction): delay in ms, rate in bytes per ms,
+     random loss of newly sent data in 1/1000 */
+  u32_t delay;
+  u32_t rate;
+  u16_t loss;
+  /* seed of the loss pattern (0: default) */
+  u32_t seed;
+  /* optional: called for the sender pcb before connecting and once established */
+  void (*setup)(struct test_tcp_sim *sim);
+  void (*established)(struct test_tcp_sim *sim);
+  const void *arg;
+  /* state and results */
+  struct tcp_pcb *tx, *rx;
+  u32_t written, received;
+  u32_t elapsed;   /* ms */
+  u32_t tx_data;   /* payload bytes sent by the sender (including retransmissions) */
+  u32_t tx_lost;   /* payload bytes dropped by the link (random loss or full queue) */
+  u32_t cwnd_avg;  /* the sender's usable window (min(cwnd, snd_wnd)) averaged over the transfer */
+  u8_t corrupt;
+};
+
 extern const ip_addr_t test_local_ip;
 extern const ip_addr_t test_remote_ip;
 extern const ip_addr_t test_netmask;
@@ -42,6 +67,9 @@ struct pbuf* tcp_create_rx_segment(struct tcp_pcb* pcb, void* data, size_t data_
                    u32_t seqno_offset, u32_t ackno_offset, u8_t headerflags);
 struct pbuf* tcp_create_rx_segment_wnd(struct tcp_pcb* pcb, void* data, size_t data_len,
                    u32_t seqno_offset, u32_t ackno_offset, u8_t headerflags, u16_t wnd);
+struct pbuf* tcp_create_rx_segment_opts(struct tcp_pcb* pcb, void* data, size_t data_len,
+                   u32_t seqno_offset, u32_t ackno_offset, u8_t headerflags,
+                   const u8_t* opts, u8_t optlen);
 void tcp_set_state(struct tcp_pcb* pcb, enum tcp_state state, const ip_addr_t* local_ip,
                    const ip_addr_t* remote_ip, u16_t local_port, u16_t remote_port);
 void test_tcp_counters_err(void* arg, err_t err);
@@ -54,5 +82,7 @@ void test_tcp_input(struct pbuf *p, struct netif *inp);
 void test_tcp_init_netif(struct netif *netif, struct test_tcp_txcounters *txcounters,
                          const ip_addr_t *ip_addr, const ip_addr_t *netmask);
 
+u32_t test_tcp_sim_run(struct test_tcp_sim *sim);
+
 
 #endif
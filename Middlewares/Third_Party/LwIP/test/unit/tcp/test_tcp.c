@@ -4,6 +4,7 @@
 #include "lwip/stats.h"
 #include "tcp_helper.h"
 #include "lwip/inet_chksum.h"
+#include "lwip/ip4_gro.h"
 
 #ifdef _MSC_VER
 #pragma warning(disable: 4307) /* we explicitly wrap around TCP seqnos */
@@ -1088,8 +1089,6 @@ START_TEST(test_tcp_rto_tracking)
   EXPECT_RET(pcb != NULL);
   tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
   pcb->mss = TCP_MSS;
-  /* Set congestion window large enough to send all our segments */
-  pcb->cwnd = 5*TCP_MSS;
 
   /* send 5 mss-sized segments */
   for (i = 0; i < 5; i++) {
@@ -1097,6 +1096,9 @@ START_TEST(test_tcp_rto_tracking)
     EXPECT_RET(err == ERR_OK);
     sent_total += TCP_MSS;
   }
+  /* Set congestion window large enough to send all our segments (only now,
+     so that TCP_TSO does not merge them into super-segments) */
+  pcb->cwnd = 5*TCP_MSS;
   check_seqnos(pcb->unsent, 5, seqnos);
   EXPECT(pcb->unacked == NULL);
   err = tcp_output(pcb);
@@ -1664,6 +1666,701 @@ START_TEST(test_tcp_persist_split)
 }
 END_TEST
 
+#if TCP_PCB_HASH
+#define TEST_TCP_HASH_NUM_PCBS 1000
+static struct tcp_pcb test_tcp_hash_pcbs[TEST_TCP_HASH_NUM_PCBS];
+
+/** Register many (static) pcbs and check each one is found by its 4-tuple */
+START_TEST(test_tcp_pcb_hash_lookup)
+{
+  int i;
+  ip_addr_t remote_ip;
+  struct tcp_pcb *pcb;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(test_tcp_hash_pcbs, 0, sizeof(test_tcp_hash_pcbs));
+  for (i = 0; i < TEST_TCP_HASH_NUM_PCBS; i++) {
+    /* spread over remote addresses, ports and states */
+    IP_ADDR4(&remote_ip, 10, 0, (u8_t)(i >> 8), (u8_t)i);
+    tcp_set_state(&test_tcp_hash_pcbs[i], (i % 4) ? ESTABLISHED : TIME_WAIT,
+                  &test_local_ip, &remote_ip, TEST_LOCAL_PORT, (u16_t)(TEST_REMOTE_PORT + (i % 7)));
+  }
+
+  for (i = 0; i < TEST_TCP_HASH_NUM_PCBS; i++) {
+    IP_ADDR4(&remote_ip, 10, 0, (u8_t)(i >> 8), (u8_t)i);
+    pcb = tcp_pcb_hash_lookup(TEST_LOCAL_PORT, (u16_t)(TEST_REMOTE_PORT + (i % 7)),
+                              &test_local_ip, &remote_ip, NULL);
+    EXPECT(pcb == &test_tcp_hash_pcbs[i]);
+    /* wrong remote port must not match */
+    pcb = tcp_pcb_hash_lookup(TEST_LOCAL_PORT, (u16_t)(TEST_REMOTE_PORT + 7),
+                              &test_local_ip, &remote_ip, NULL);
+    EXPECT(pcb == NULL);
+  }
+
+  /* unregister every second pcb and check the rest are still found */
+  for (i = 0; i < TEST_TCP_HASH_NUM_PCBS; i += 2) {
+    struct tcp_pcb **pcbs = (i % 4) ? &tcp_active_pcbs : &tcp_tw_pcbs;
+    TCP_RMV(pcbs, &test_tcp_hash_pcbs[i]);
+  }
+  for (i = 0; i < TEST_TCP_HASH_NUM_PCBS; i++) {
+    IP_ADDR4(&remote_ip, 10, 0, (u8_t)(i >> 8), (u8_t)i);
+    pcb = tcp_pcb_hash_lookup(TEST_LOCAL_PORT, (u16_t)(TEST_REMOTE_PORT + (i % 7)),
+                              &test_local_ip, &remote_ip, NULL);
+    EXPECT(pcb == ((i & 1) ? &test_tcp_hash_pcbs[i] : NULL));
+  }
+  for (i = 1; i < TEST_TCP_HASH_NUM_PCBS; i += 2) {
+    struct tcp_pcb **pcbs = (i % 4) ? &tcp_active_pcbs : &tcp_tw_pcbs;
+    TCP_RMV(pcbs, &test_tcp_hash_pcbs[i]);
+  }
+  EXPECT(tcp_active_pcbs == NULL);
+  EXPECT(tcp_tw_pcbs == NULL);
+}
+END_TEST
+
+/** Check listening pcbs are found by port, preferring an exact local address */
+START_TEST(test_tcp_listen_pcb_hash_lookup)
+{
+  struct tcp_pcb any_pcb, exact_pcb, other_pcb;
+  ip_addr_t other_ip;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&any_pcb, 0, sizeof(any_pcb));
+  memset(&exact_pcb, 0, sizeof(exact_pcb));
+  memset(&other_pcb, 0, sizeof(other_pcb));
+  IP_ADDR4(&other_ip, 192, 168, 1, 3);
+
+  tcp_set_state(&any_pcb, LISTEN, IP4_ADDR_ANY, NULL, TEST_LOCAL_PORT, 0);
+  tcp_set_state(&other_pcb, LISTEN, &test_local_ip, NULL, (u16_t)(TEST_LOCAL_PORT + TCP_LISTEN_PCB_HASH_SIZE), 0);
+  EXPECT((struct tcp_pcb *)tcp_listen_pcb_hash_lookup(TEST_LOCAL_PORT, &test_local_ip, NULL) == &any_pcb);
+
+  tcp_set_state(&exact_pcb, LISTEN, &test_local_ip, NULL, TEST_LOCAL_PORT, 0);
+  EXPECT((struct tcp_pcb *)tcp_listen_pcb_hash_lookup(TEST_LOCAL_PORT, &test_local_ip, NULL) == &exact_pcb);
+  EXPECT((struct tcp_pcb *)tcp_listen_pcb_hash_lookup(TEST_LOCAL_PORT, &other_ip, NULL) == &any_pcb);
+  EXPECT((struct tcp_pcb *)tcp_listen_pcb_hash_lookup((u16_t)(TEST_LOCAL_PORT + TCP_LISTEN_PCB_HASH_SIZE),
+                                                     &test_local_ip, NULL) == &other_pcb);
+  EXPECT(tcp_listen_pcb_hash_lookup((u16_t)(TEST_LOCAL_PORT + 1), &test_local_ip, NULL) == NULL);
+
+  TCP_RMV(&tcp_listen_pcbs.pcbs, &exact_pcb);
+  EXPECT((struct tcp_pcb *)tcp_listen_pcb_hash_lookup(TEST_LOCAL_PORT, &test_local_ip, NULL) == &any_pcb);
+  TCP_RMV(&tcp_listen_pcbs.pcbs, &any_pcb);
+  TCP_RMV(&tcp_listen_pcbs.pcbs, &other_pcb);
+  EXPECT(tcp_listen_pcb_hash_lookup(TEST_LOCAL_PORT, &test_local_ip, NULL) == NULL);
+  EXPECT(tcp_listen_pcbs.pcbs == NULL);
+}
+END_TEST
+#endif /* TCP_PCB_HASH */
+
+#if TCP_WRITE_ZEROCOPY
+static u32_t test_tcp_zc_done_calls;
+
+static void
+test_tcp_zc_done(struct tcp_zc_write *zc, void *arg)
+{
+  EXPECT(arg == zc);
+  EXPECT(zc->refcnt == 0);
+  test_tcp_zc_done_calls++;
+}
+
+/** Enqueue 2.5 MSS scattered over 3 buffers and check the completion
+ * callback fires only after the last byte has been ACKed */
+START_TEST(test_tcp_write_zc_partial_ack)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_zc_write zc;
+  struct tcp_zc_iovec iov[3];
+  struct tcp_pcb* pcb;
+  struct pbuf* p;
+  err_t err;
+  u16_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < sizeof(tx_data); i++) {
+    tx_data[i] = (u8_t)i;
+  }
+  test_tcp_zc_done_calls = 0;
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  /* disable initial congestion window (we don't send a SYN here...) */
+  pcb->cwnd = pcb->snd_wnd;
+
+  /* buffers don't line up with segment boundaries */
+  iov[0].base = &tx_data[0];
+  iov[0].len = TCP_MSS / 2;
+  iov[1].base = &tx_data[TCP_MSS / 2];
+  iov[1].len = TCP_MSS + 10;
+  iov[2].base = &tx_data[TCP_MSS / 2 + TCP_MSS + 10];
+  iov[2].len = TCP_MSS - 10;
+  memset(&zc, 0, sizeof(zc));
+  zc.done_fn = test_tcp_zc_done;
+  zc.done_arg = &zc;
+
+  err = tcp_write_zc(pcb, &zc, iov, 3, 0);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(pcb->snd_buf == TCP_SND_BUF - (5 * TCP_MSS / 2));
+  /* segments are made of header, iov[0], iov[1] / iov[1], iov[2] / iov[2] */
+  EXPECT(pcb->snd_queuelen == 8);
+  EXPECT(zc.refcnt == 5);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_ZC_PBUF) == 5);
+
+  /* send the trailing half segment right away */
+  tcp_nagle_disable(pcb);
+  txcounters.copy_tx_packets = 1;
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT_RET(txcounters.num_tx_calls == 3);
+  EXPECT_RET(txcounters.num_tx_bytes == (5 * TCP_MSS / 2) + 3 * (sizeof(struct tcp_hdr) + sizeof(struct ip_hdr)));
+  /* check the payload of the segment spanning iov[1] and iov[2] */
+  EXPECT(pbuf_memcmp(txcounters.tx_packets, 2 * (sizeof(struct tcp_hdr) + sizeof(struct ip_hdr)) + TCP_MSS,
+                     &tx_data[TCP_MSS], TCP_MSS) == 0);
+  pbuf_free(txcounters.tx_packets);
+  memset(&txcounters, 0, sizeof(txcounters));
+
+  /* ACK the first segment and part of the second (ackno is relative to lastack) */
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, 1, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(test_tcp_zc_done_calls == 0);
+  EXPECT(zc.refcnt == 3);
+
+  /* ACK everything but the last byte */
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, (3 * TCP_MSS / 2) - 2, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(test_tcp_zc_done_calls == 0);
+  EXPECT(zc.refcnt == 1);
+
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, 1, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(test_tcp_zc_done_calls == 1);
+  EXPECT(pcb->unacked == NULL);
+  EXPECT(pcb->snd_queuelen == 0);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_ZC_PBUF) == 0);
+
+  /* make sure the pcb is freed */
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 1);
+  tcp_abort(pcb);
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
+/** Lose a zero-copy segment, check the RTO retransmission sends the same
+ * data again without completing the write, then abort with data queued */
+START_TEST(test_tcp_write_zc_rexmit)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_zc_write zc, zc2;
+  struct tcp_zc_iovec iov[2];
+  struct tcp_pcb* pcb;
+  struct pbuf* p;
+  err_t err;
+  u16_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < sizeof(tx_data); i++) {
+    tx_data[i] = (u8_t)(i * 3);
+  }
+  test_tcp_zc_done_calls = 0;
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  pcb->cwnd = pcb->snd_wnd;
+
+  /* more data than the send buffer holds is refused without side effects */
+  iov[0].base = tx_data;
+  iov[0].len = TCP_SND_BUF / 2;
+  iov[1].base = tx_data;
+  iov[1].len = TCP_SND_BUF / 2 + 1;
+  memset(&zc, 0, sizeof(zc));
+  zc.done_fn = test_tcp_zc_done;
+  zc.done_arg = &zc;
+  err = tcp_write_zc(pcb, &zc, iov, 2, 0);
+  EXPECT_RET(err == ERR_MEM);
+  EXPECT(pcb->unsent == NULL);
+  EXPECT(pcb->snd_queuelen == 0);
+  EXPECT(zc.refcnt == 0);
+
+  iov[0].len = 100;
+  iov[1].base = &tx_data[100];
+  iov[1].len = 200;
+  err = tcp_write_zc(pcb, &zc, iov, 2, 0);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT_RET(txcounters.num_tx_calls == 1);
+  memset(&txcounters, 0, sizeof(txcounters));
+
+  /* call the tcp timer until the segment is retransmitted */
+  txcounters.copy_tx_packets = 1;
+  for (i = 0; i < 20; i++) {
+    test_tcp_tmr();
+    if (txcounters.num_tx_calls != 0) {
+      break;
+    }
+  }
+  EXPECT_RET(txcounters.num_tx_calls == 1);
+  EXPECT_RET(txcounters.num_tx_bytes == 300 + sizeof(struct tcp_hdr) + sizeof(struct ip_hdr));
+  EXPECT(pbuf_memcmp(txcounters.tx_packets, sizeof(struct tcp_hdr) + sizeof(struct ip_hdr), tx_data, 300) == 0);
+  pbuf_free(txcounters.tx_packets);
+  memset(&txcounters, 0, sizeof(txcounters));
+  EXPECT(test_tcp_zc_done_calls == 0);
+  EXPECT(zc.refcnt == 2);
+
+  /* ACK the retransmission */
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, 300, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(test_tcp_zc_done_calls == 1);
+
+  /* data still queued when the connection is aborted is released, too */
+  memset(&zc2, 0, sizeof(zc2));
+  zc2.done_fn = test_tcp_zc_done;
+  zc2.done_arg = &zc2;
+  err = tcp_write_zc(pcb, &zc2, iov, 2, 0);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(test_tcp_zc_done_calls == 1);
+
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 1);
+  tcp_abort(pcb);
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+  EXPECT(test_tcp_zc_done_calls == 2);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_ZC_PBUF) == 0);
+}
+END_TEST
+#endif /* TCP_WRITE_ZEROCOPY */
+
+#if IP_GRO
+/** Create a segment that passes ip4_input (tcp_create_rx_segment leaves the
+ * IP protocol unset since it is meant for tcp_input) */
+static struct pbuf *
+test_tcp_gro_segment(struct tcp_pcb *pcb, char *data, u16_t len, u32_t seqno_offset, u8_t flags)
+{
+  struct pbuf *p = tcp_create_rx_segment(pcb, data, len, seqno_offset, 0, flags);
+  if (p != NULL) {
+    struct ip_hdr *iphdr = (struct ip_hdr *)p->payload;
+    IPH_PROTO_SET(iphdr, IP_PROTO_TCP);
+    IPH_TTL_SET(iphdr, 64);
+    IPH_CHKSUM_SET(iphdr, 0);
+    IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+  }
+  return p;
+}
+
+/** Check that in-order segments are merged into one and delivered with the
+ * correct data on flush or PSH */
+START_TEST(test_tcp_gro_merge)
+{
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  char data[400];
+  u16_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < sizeof(data); i++) {
+    data[i] = (char)(i * 7 + 3);
+  }
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+  counters.expected_data_len = sizeof(data);
+  counters.expected_data = data;
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+
+  /* odd segment sizes to check the byte-swapped checksum contribution */
+  ip4_gro_input(test_tcp_gro_segment(pcb, data, 101, 0, TCP_ACK), &netif);
+  ip4_gro_input(test_tcp_gro_segment(pcb, data + 101, 101, 101, TCP_ACK), &netif);
+  ip4_gro_input(test_tcp_gro_segment(pcb, data + 202, 101, 202, TCP_ACK), &netif);
+  EXPECT(counters.recv_calls == 0);
+  ip4_gro_flush();
+  EXPECT(counters.recv_calls == 1);
+  EXPECT(counters.recved_bytes == 303);
+
+  /* PSH delivers right away */
+  ip4_gro_input(test_tcp_gro_segment(pcb, data + 303, 50, 0, TCP_ACK), &netif);
+  ip4_gro_input(test_tcp_gro_segment(pcb, data + 353, 47, 50, TCP_ACK | TCP_PSH), &netif);
+  EXPECT(counters.recv_calls == 2);
+  EXPECT(counters.recved_bytes == sizeof(data));
+  EXPECT(counters.err_calls == 0);
+  ip4_gro_flush();
+  EXPECT(counters.recv_calls == 2);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
+/** Check that segments which cannot be merged keep their order and that a
+ * corrupted segment makes the merged packet fail the checksum */
+START_TEST(test_tcp_gro_no_merge)
+{
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+#if CHECKSUM_CHECK_TCP || IP_STATS
+  struct pbuf *p;
+#endif /* CHECKSUM_CHECK_TCP || IP_STATS */
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  char data[300];
+  u16_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < sizeof(data); i++) {
+    data[i] = (char)(i * 5 + 1);
+  }
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+  counters.expected_data_len = sizeof(data);
+  counters.expected_data = data;
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+
+  /* a gap flushes the first segment, the out-of-order one goes to ooseq */
+  ip4_gro_input(test_tcp_gro_segment(pcb, data, 100, 0, TCP_ACK), &netif);
+  ip4_gro_input(test_tcp_gro_segment(pcb, data + 200, 100, 200, TCP_ACK), &netif);
+  EXPECT(counters.recv_calls == 1);
+  EXPECT(counters.recved_bytes == 100);
+  ip4_gro_flush();
+  EXPECT(counters.recv_calls == 1);
+  EXPECT(pcb->ooseq != NULL);
+
+#if CHECKSUM_CHECK_TCP
+  /* a corrupted segment: the whole merged packet is dropped */
+  ip4_gro_input(test_tcp_gro_segment(pcb, data + 100, 50, 0, TCP_ACK), &netif);
+  p = test_tcp_gro_segment(pcb, data + 150, 50, 50, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  ((u8_t *)p->payload)[IP_HLEN + TCP_HLEN + 10] ^= 0x40;
+  ip4_gro_input(p, &netif);
+  ip4_gro_flush();
+  EXPECT(counters.recv_calls == 1);
+  EXPECT(counters.recved_bytes == 100);
+#endif /* CHECKSUM_CHECK_TCP */
+
+  /* a pure ACK flushes the held data before it is processed */
+  ip4_gro_input(test_tcp_gro_segment(pcb, data + 100, 100, 0, TCP_ACK), &netif);
+  ip4_gro_input(test_tcp_gro_segment(pcb, NULL, 0, 100, TCP_ACK), &netif);
+  EXPECT(counters.recv_calls == 2);
+  EXPECT(counters.recved_bytes == sizeof(data));
+  EXPECT(pcb->ooseq == NULL);
+  EXPECT(counters.err_calls == 0);
+
+#if IP_STATS
+  /* segments not addressed to us (to be forwarded or dropped) are not held */
+  p = test_tcp_gro_segment(pcb, data, 100, 300, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  {
+    struct ip_hdr *iphdr = (struct ip_hdr *)p->payload;
+    STAT_COUNTER drop = lwip_stats.ip.drop;
+    IP4_ADDR(&iphdr->dest, 192, 168, 1, 77);
+    IPH_CHKSUM_SET(iphdr, 0);
+    IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+    ip4_gro_input(p, &netif);
+    EXPECT(lwip_stats.ip.drop == drop + 1);
+  }
+#endif /* IP_STATS */
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+#endif /* IP_GRO */
+
+#if TCP_TSO
+static u32_t test_tcp_tso_tx_calls;
+static u16_t test_tcp_tso_last_mss;
+static u16_t test_tcp_tso_last_len;
+
+/** netif->output for a netif with NETIF_FLAG_TSO: records the super-segment */
+static err_t
+test_tcp_tso_netif_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(ipaddr);
+  test_tcp_tso_tx_calls++;
+  test_tcp_tso_last_mss = p->tso_mss;
+  test_tcp_tso_last_len = p->tot_len;
+  return ERR_OK;
+}
+
+/** Check one frame cut from a super-segment: lengths, id, sequence number,
+ * flags, checksums and payload */
+static void
+test_tcp_tso_check_frame(struct pbuf *q, u16_t id, u32_t seqno, u16_t datalen,
+                         u8_t flags, const u8_t *data)
+{
+  struct ip_hdr *iphdr = (struct ip_hdr *)q->payload;
+  struct tcp_hdr *tcphdr = (struct tcp_hdr *)((u8_t *)q->payload + IP_HLEN);
+#if CHECKSUM_GEN_TCP
+  struct pbuf *t;
+#endif /* CHECKSUM_GEN_TCP */
+
+  EXPECT_RET(q->len == IP_HLEN + TCP_HLEN + datalen);
+  EXPECT(lwip_ntohs(IPH_LEN(iphdr)) == IP_HLEN + TCP_HLEN + datalen);
+  EXPECT(lwip_ntohs(IPH_ID(iphdr)) == id);
+#if CHECKSUM_GEN_IP
+  EXPECT(inet_chksum(iphdr, IP_HLEN) == 0);
+#endif /* CHECKSUM_GEN_IP */
+  EXPECT(lwip_ntohl(tcphdr->seqno) == seqno);
+  EXPECT(TCPH_FLAGS(tcphdr) == flags);
+  EXPECT(memcmp((u8_t *)q->payload + IP_HLEN + TCP_HLEN, data, datalen) == 0);
+#if CHECKSUM_GEN_TCP
+  t = pbuf_alloc_reference(tcphdr, (u16_t)(TCP_HLEN + datalen), PBUF_REF);
+  EXPECT_RET(t != NULL);
+  EXPECT(ip_chksum_pseudo(t, IP_PROTO_TCP, t->tot_len, &test_local_ip, &test_remote_ip) == 0);
+  pbuf_free(t);
+#endif /* CHECKSUM_GEN_TCP */
+}
+
+/** Check that a super-segment queued by tcp_write() is cut into MSS sized
+ * frames at the netif, also when its payload is referenced in pieces of odd
+ * length */
+START_TEST(test_tcp_tso_split)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct pbuf *p, *q;
+  err_t err;
+  size_t i;
+  u16_t id;
+  u32_t seqno;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < sizeof(tx_data); i++) {
+    tx_data[i] = (u8_t)(i * 3 + 1);
+  }
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  txcounters.copy_tx_packets = 1;
+  memset(&counters, 0, sizeof(counters));
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  pcb->cwnd = 8 * TCP_MSS;
+  seqno = pcb->snd_nxt;
+
+#if LWIP_NETIF_TX_SINGLE_PBUF
+  /* all data of a segment has to be copied in one go */
+  err = tcp_write(pcb, tx_data, 4 * TCP_MSS, 0);
+  EXPECT_RET(err == ERR_OK);
+#else /* LWIP_NETIF_TX_SINGLE_PBUF */
+  /* two references of odd length end up in one segment of 4 frames */
+  err = tcp_write(pcb, tx_data, 1001, TCP_WRITE_FLAG_MORE);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_write(pcb, &tx_data[1001], 4 * TCP_MSS - 1001, 0);
+  EXPECT_RET(err == ERR_OK);
+#endif /* LWIP_NETIF_TX_SINGLE_PBUF */
+  EXPECT_RET(pcb->unsent != NULL);
+  EXPECT(pcb->unsent->next == NULL);
+  EXPECT(pcb->unsent->len == 4 * TCP_MSS);
+
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(txcounters.num_tx_calls == 4);
+  EXPECT(txcounters.num_tx_bytes == 4 * (TCP_MSS + 40U));
+  EXPECT(pcb->unsent == NULL);
+  EXPECT_RET(pcb->unacked != NULL);
+  EXPECT(pcb->unacked->len == 4 * TCP_MSS);
+  /* only the frames are checksummed, not the super-segment */
+  EXPECT(pcb->unacked->tcphdr->chksum == 0);
+
+  p = txcounters.tx_packets;
+  EXPECT_RET(p != NULL);
+  id = lwip_ntohs(IPH_ID((struct ip_hdr *)p->payload));
+  for (q = p, i = 0; (q != NULL) && (i < 4); q = q->next, i++) {
+    test_tcp_tso_check_frame(q, (u16_t)(id + i), seqno + (u32_t)i * TCP_MSS, TCP_MSS,
+                             (u8_t)((i == 3) ? (TCP_ACK | TCP_PSH) : TCP_ACK), &tx_data[i * TCP_MSS]);
+  }
+  EXPECT(i == 4);
+  EXPECT(q == NULL);
+  pbuf_free(txcounters.tx_packets);
+  txcounters.tx_packets = NULL;
+  txcounters.copy_tx_packets = 0;
+  /* the frames don't keep references to the segment */
+  EXPECT(pcb->unacked->p->ref == 1);
+  EXPECT(MEMP_STATS_GET(used, MEMP_FRAG_PBUF) == 0);
+
+  /* one ACK for the whole segment */
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, 4 * TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->unacked == NULL);
+  EXPECT(pcb->snd_queuelen == 0);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
+/** Check that a super-segment larger than the window is split when nothing is
+ * in flight, waits for ACKs otherwise, and that a netif with NETIF_FLAG_TSO
+ * gets it in one piece */
+START_TEST(test_tcp_tso_window)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct pbuf *p;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  pcb->cwnd = 8 * TCP_MSS;
+  err = tcp_write(pcb, tx_data, 4 * TCP_MSS, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_write(pcb, &tx_data[4 * TCP_MSS], 4 * TCP_MSS, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT_RET(pcb->unsent != NULL);
+  EXPECT(pcb->unsent->len == 4 * TCP_MSS);
+
+  /* the window only allows 2 frames: the first segment is split */
+  pcb->cwnd = 2 * TCP_MSS + 100;
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(txcounters.num_tx_calls == 2);
+  EXPECT_RET(pcb->unacked != NULL);
+  EXPECT(pcb->unacked->len == 2 * TCP_MSS);
+  EXPECT_RET(pcb->unsent != NULL);
+  EXPECT(pcb->unsent->len == 2 * TCP_MSS);
+  memset(&txcounters, 0, sizeof(txcounters));
+
+  /* data in flight: the rest of the first segment fits, the next one waits
+     for the window instead of being split */
+  pcb->cwnd = 5 * TCP_MSS;
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(txcounters.num_tx_calls == 2);
+  EXPECT_RET(pcb->unsent != NULL);
+  EXPECT(pcb->unsent->len == 4 * TCP_MSS);
+  memset(&txcounters, 0, sizeof(txcounters));
+
+  /* the hardware cuts the rest itself */
+  netif.flags |= NETIF_FLAG_TSO;
+  netif.output = test_tcp_tso_netif_output;
+  test_tcp_tso_tx_calls = 0;
+  pcb->cwnd = 8 * TCP_MSS;
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, 3 * TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(test_tcp_tso_tx_calls == 1);
+  EXPECT(test_tcp_tso_last_mss == TCP_MSS);
+  EXPECT(test_tcp_tso_last_len == 4 * TCP_MSS + 40U);
+  EXPECT(pcb->unsent == NULL);
+
+  /* cwnd shrinking does not cut the space reserved in the last segment */
+  err = tcp_write(pcb, tx_data, 100, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+  EXPECT_RET(err == ERR_OK);
+  pcb->cwnd = TCP_MSS;
+  err = tcp_write(pcb, &tx_data[100], TCP_MSS, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT_RET(pcb->unsent != NULL);
+  EXPECT(pcb->unsent->len + (pcb->unsent->next ? pcb->unsent->next->len : 0) == 100 + TCP_MSS);
+  EXPECT(counters.err_calls == 0);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
+/** Check that a partial ACK removes the acknowledged frames from an unacked
+ * super-segment (also without SACK), so a retransmission only carries the
+ * missing ones. The data is referenced (not copied), so the pbuf chain is
+ * trimmed. */
+START_TEST(test_tcp_tso_partial_ack)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct pbuf *p;
+  u32_t base;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  pcb->cwnd = 8 * TCP_MSS;
+  base = pcb->lastack;
+  err = tcp_write(pcb, tx_data, 4 * TCP_MSS, 0);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(txcounters.num_tx_calls == 4);
+  EXPECT_RET(pcb->unacked != NULL);
+  EXPECT(pcb->unacked->len == 4 * TCP_MSS);
+  EXPECT(!(pcb->flags & TF_SACK));
+
+  /* one frame and one odd byte */
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, 1, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT_RET(pcb->unacked != NULL);
+  EXPECT(lwip_ntohl(pcb->unacked->tcphdr->seqno) == base + TCP_MSS + 1);
+  EXPECT(pcb->unacked->len == 3 * TCP_MSS - 1);
+  EXPECT(pcb->unacked->p->tot_len == pcb->unacked->len + IP_HLEN + TCP_HLEN);
+  EXPECT(pcb->unacked->next == NULL);
+  EXPECT(pcb->snd_buf == TCP_SND_BUF - (3 * TCP_MSS - 1));
+
+  /* the retransmission starts at the first byte missing (the checksum is
+     verified by TCP_CHECKSUM_ON_COPY_SANITY_CHECK) */
+  memset(&txcounters, 0, sizeof(txcounters));
+  txcounters.copy_tx_packets = 1;
+  tcp_rexmit_rto(pcb);
+  EXPECT(txcounters.num_tx_calls == 3);
+  EXPECT(txcounters.num_tx_bytes == 3 * TCP_MSS - 1 + 3 * 40U);
+  EXPECT_RET(txcounters.tx_packets != NULL);
+  EXPECT(pbuf_memcmp(txcounters.tx_packets, 40, &tx_data[TCP_MSS + 1], TCP_MSS) == 0);
+  pbuf_free(txcounters.tx_packets);
+  memset(&txcounters, 0, sizeof(txcounters));
+  EXPECT(counters.err_calls == 0);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+#endif /* TCP_TSO */
+
 /** Create the suite including all tests for this module */
 Suite *
 tcp_suite(void)
@@ -1689,7 +2386,24 @@ tcp_suite(void)
     TESTFUNC(test_tcp_rto_timeout_syn_sent_link_down),
     TESTFUNC(test_tcp_zwp_timeout),
     TESTFUNC(test_tcp_zwp_timeout_link_down),
-    TESTFUNC(test_tcp_persist_split)
+    TESTFUNC(test_tcp_persist_split),
+#if TCP_PCB_HASH
+    TESTFUNC(test_tcp_pcb_hash_lookup),
+    TESTFUNC(test_tcp_listen_pcb_hash_lookup),
+#endif /* TCP_PCB_HASH */
+#if TCP_WRITE_ZEROCOPY
+    TESTFUNC(test_tcp_write_zc_partial_ack),
+    TESTFUNC(test_tcp_write_zc_rexmit),
+#endif /* TCP_WRITE_ZEROCOPY */
+#if IP_GRO
+    TESTFUNC(test_tcp_gro_merge),
+    TESTFUNC(test_tcp_gro_no_merge),
+#endif /* IP_GRO */
+#if TCP_TSO
+    TESTFUNC(test_tcp_tso_split),
+    TESTFUNC(test_tcp_tso_window),
+    TESTFUNC(test_tcp_tso_partial_ack),
+#endif /* TCP_TSO */
   };
   return create_suite("TCP", tests, sizeof(tests)/sizeof(testfunc), tcp_setup, tcp_teardown);
 }
@@ -0,0 +1,332 @@
+#include "test_tcp_cc.h"
+
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/tcp_cc.h"
+#include "lwip/stats.h"
+#include "tcp_helper.h"
+
+#if !LWIP_TCP_CC || !LWIP_IPV4
+#error "This tests needs LWIP_TCP_CC and IPv4 enabled"
+#endif
+
+extern u32_t lwip_sys_now;
+
+#define TEST_CC_MSS 1000
+
+/* Setups/teardown functions */
+static struct netif *old_netif_list;
+static struct netif *old_netif_default;
+
+static void
+tcp_cc_setup(void)
+{
+  old_netif_list = netif_list;
+  old_netif_default = netif_default;
+  netif_list = NULL;
+  netif_default = NULL;
+  tcp_remove_all();
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+tcp_cc_teardown(void)
+{
+  netif_list = NULL;
+  netif_default = NULL;
+  tcp_remove_all();
+  netif_list = old_netif_list;
+  netif_default = old_netif_default;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* A flow driving a congestion control algorithm directly: segments are
+   sent whenever cwnd allows and acked one by one after the round trip time,
+   spaced by the bottleneck rate (queueing when cwnd exceeds the
+   bandwidth-delay product) */
+#define TEST_CC_MAX_FLIGHT 2048
+
+struct test_cc_flow {
+  struct tcp_pcb *pcb;
+  u32_t sent[TEST_CC_MAX_FLIGHT];
+  u16_t head, count;
+  u32_t last_ack;
+};
+
+static struct test_cc_flow test_cc_flows[2];
+
+static struct tcp_pcb *
+test_cc_pcb(struct test_cc_flow *flow, const struct tcp_cc_ops *cc)
+{
+  struct tcp_pcb *pcb = tcp_new();
+  fail_unless(pcb != NULL);
+  memset(flow, 0, sizeof(*flow));
+  flow->pcb = pcb;
+  pcb->state = ESTABLISHED;
+  pcb->mss = TEST_CC_MSS;
+  pcb->snd_wnd = 1000 * TEST_CC_MSS;
+  pcb->ssthresh = 1000 * TEST_CC_MSS;
+  pcb->lastack = pcb->snd_nxt;
+  tcp_set_cc(pcb, cc);
+  fail_unless(pcb->cc == cc);
+  fail_unless(pcb->cwnd == LWIP_TCP_CALC_INITIAL_CWND(TEST_CC_MSS));
+  return pcb;
+}
+
+static void
+test_cc_pcb_free(struct tcp_pcb *pcb)
+{
+  pcb->state = CLOSED;
+  fail_unless(tcp_close(pcb) == ERR_OK);
+}
+
+static void
+test_cc_send(struct test_cc_flow *flow)
+{
+  struct tcp_pcb *pcb = flow->pcb;
+  while ((pcb->snd_nxt - pcb->lastack + TEST_CC_MSS <= pcb->cwnd) &&
+         (flow->count < TEST_CC_MAX_FLIGHT)) {
+    flow->sent[(flow->head + flow->count) % TEST_CC_MAX_FLIGHT] = lwip_sys_now;
+    flow->count++;
+    pcb->snd_nxt += TEST_CC_MSS;
+  }
+}
+
+/* run the flow for 'duration' ms */
+static void
+test_cc_run(struct test_cc_flow *flow, u32_t duration, u32_t rtt, u32_t rate)
+{
+  struct tcp_pcb *pcb = flow->pcb;
+  u32_t end = lwip_sys_now + duration;
+
+  test_cc_send(flow);
+  while (flow->count > 0) {
+    u32_t t = flow->sent[flow->head] + rtt;
+    if ((rate != 0) && (TCP_SEQ_LT(t, flow->last_ack + TEST_CC_MSS / rate))) {
+      t = flow->last_ack + TEST_CC_MSS / rate;
+    }
+    if (TCP_SEQ_GT(t, end)) {
+      break;
+    }
+    flow->head = (u16_t)((flow->head + 1) % TEST_CC_MAX_FLIGHT);
+    flow->count--;
+    flow->last_ack = lwip_sys_now = t;
+    pcb->lastack += TEST_CC_MSS;
+    pcb->cc->cong_avoid(pcb, TEST_CC_MSS);
+    test_cc_send(flow);
+  }
+  lwip_sys_now = end;
+}
+
+/* Test functions */
+
+START_TEST(test_tcp_cc_newreno)
+{
+  struct test_cc_flow *flow = &test_cc_flows[0];
+  struct tcp_pcb *pcb;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = test_cc_pcb(flow, &tcp_cc_newreno);
+  /* slow start: cwnd doubles every round */
+  pcb->cwnd = 10 * TEST_CC_MSS;
+  test_cc_run(flow, 100, 100, 0);
+  fail_unless(pcb->cwnd == 20 * TEST_CC_MSS);
+
+  /* fast retransmit: halve, inflate by 3 segments, deflate when recovered */
+  pcb->cc->loss(pcb, TCP_CC_LOSS_FAST);
+  fail_unless(pcb->ssthresh == 10 * TEST_CC_MSS);
+  fail_unless(pcb->cwnd == 13 * TEST_CC_MSS);
+  pcb->cc->recovered(pcb);
+  fail_unless(pcb->cwnd == 10 * TEST_CC_MSS);
+
+  /* congestion avoidance: one segment per round */
+  test_cc_run(flow, 500, 100, 0);
+  fail_unless(pcb->cwnd == 15 * TEST_CC_MSS);
+
+  /* timeout */
+  pcb->cc->loss(pcb, TCP_CC_LOSS_RTO);
+  fail_unless(pcb->ssthresh == (15 * TEST_CC_MSS) / 2);
+  fail_unless(pcb->cwnd == TEST_CC_MSS);
+  test_cc_pcb_free(pcb);
+}
+END_TEST
+
+/* After a loss on a long-RTT path, CUBIC regains the previous window after
+   a fixed time, Reno only after (cwnd / 2) round trips */
+START_TEST(test_tcp_cc_cubic)
+{
+  struct tcp_pcb *cubic, *reno;
+  u32_t start;
+  LWIP_UNUSED_ARG(_i);
+
+  cubic = test_cc_pcb(&test_cc_flows[0], &tcp_cc_cubic);
+  reno = test_cc_pcb(&test_cc_flows[1], &tcp_cc_newreno);
+  cubic->cwnd = reno->cwnd = 100 * TEST_CC_MSS;
+
+  cubic->cc->loss(cubic, TCP_CC_LOSS_FAST);
+  reno->cc->loss(reno, TCP_CC_LOSS_FAST);
+  /* beta is 0.7 for CUBIC */
+  fail_unless(cubic->ssthresh == (100 * TEST_CC_MSS * 717) / 1024);
+  fail_unless(reno->ssthresh == 50 * TEST_CC_MSS);
+  cubic->cc->recovered(cubic);
+  reno->cc->recovered(reno);
+
+  /* K = cbrt(30 / 0.4) = 4.2s: the window is concave up to there... */
+  start = lwip_sys_now;
+  test_cc_run(&test_cc_flows[0], 4000, 200, 0);
+  lwip_sys_now = start;
+  test_cc_run(&test_cc_flows[1], 4000, 200, 0);
+  fail_unless(cubic->cwnd > 90 * TEST_CC_MSS);
+  fail_unless(cubic->cwnd <= 101 * TEST_CC_MSS);
+  fail_unless(reno->cwnd == 70 * TEST_CC_MSS);
+  /* ...and convex (probing) after */
+  test_cc_run(&test_cc_flows[0], 4000, 200, 0);
+  fail_unless(cubic->cwnd > 110 * TEST_CC_MSS);
+
+  /* on a short RTT path, the cubic function grows slower than Reno: the
+     Reno-friendly estimate takes over */
+  cubic->cwnd = 100 * TEST_CC_MSS;
+  cubic->cc->loss(cubic, TCP_CC_LOSS_RTO);
+  fail_unless(cubic->cwnd == TEST_CC_MSS);
+  cubic->cwnd = cubic->ssthresh;
+  test_cc_run(&test_cc_flows[0], 80, 2, 0);
+  fail_unless(cubic->cwnd >= cubic->ssthresh + 15 * TEST_CC_MSS);
+
+  test_cc_pcb_free(cubic);
+  test_cc_pcb_free(reno);
+}
+END_TEST
+
+/* The cubic function and its inverse (K) are monotonic over the whole time
+   range they are evaluated for */
+START_TEST(test_tcp_cc_cubic_monotonic)
+{
+  static const u16_t mss[] = {536, TEST_CC_MSS, 0xffff};
+  size_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < LWIP_ARRAYSIZE(mss); i++) {
+    u32_t t, diff, prev = 0, prev_k = 0, max;
+    for (t = 0; t <= 25000; t++) {
+      u32_t delta = tcp_cubic_delta(t, mss[i]);
+      fail_unless(delta >= prev);
+      prev = delta;
+    }
+    /* C * 20^3 = 3200 segments at the end of the range */
+    max = tcp_cubic_delta(20000, mss[i]);
+    fail_unless(max == 3200UL * mss[i]);
+    for (diff = 0; diff <= max; diff += mss[i] / 4) {
+      u32_t k = tcp_cubic_k(diff, mss[i]);
+      fail_unless(k >= prev_k);
+      fail_unless(k <= 20000);
+      fail_unless(tcp_cubic_delta(k, mss[i]) >= diff);
+      fail_unless((k == 0) || (tcp_cubic_delta(k - 1, mss[i]) < diff));
+      prev_k = k;
+    }
+  }
+}
+END_TEST
+
+/* bbrlite sizes cwnd from the bandwidth-delay product and does not back
+   off on isolated losses */
+START_TEST(test_tcp_cc_bbrlite)
+{
+  struct test_cc_flow *flow = &test_cc_flows[0];
+  struct tcp_pcb *pcb;
+  u32_t bdp;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = test_cc_pcb(flow, &tcp_cc_bbrlite);
+  /* 100 ms, 500 bytes/ms: BDP is 50 segments */
+  bdp = 100 * 500;
+  test_cc_run(flow, 4000, 100, 500);
+  fail_unless(pcb->cwnd >= bdp);
+  fail_unless(pcb->cwnd <= (bdp * 5) / 4 + 2 * TEST_CC_MSS);
+
+  pcb->cc->loss(pcb, TCP_CC_LOSS_FAST);
+  pcb->cc->recovered(pcb);
+  fail_unless(pcb->cwnd >= bdp);
+
+  /* after a timeout, the window is regained within a round */
+  pcb->cc->loss(pcb, TCP_CC_LOSS_RTO);
+  fail_unless(pcb->cwnd == TEST_CC_MSS);
+  test_cc_run(flow, 300, 100, 500);
+  fail_unless(pcb->cwnd >= (bdp * 3) / 4);
+  test_cc_pcb_free(pcb);
+}
+END_TEST
+
+static void
+test_cc_sim_setup(struct test_tcp_sim *sim)
+{
+  tcp_set_cc(sim->tx, (const struct tcp_cc_ops *)sim->arg);
+}
+
+#if LWIP_TCP_SACK_IN
+static void
+test_cc_sim_established(struct test_tcp_sim *sim)
+{
+  /* compare the algorithms' reaction to loss, not SACK recovery (see test_tcp_sack.c) */
+  tcp_clear_flags(sim->tx, TF_SACK);
+}
+#endif /* LWIP_TCP_SACK_IN */
+
+/* Goodput over a simulated path with 80 ms RTT and 100 kB/s */
+static u32_t
+test_cc_sim_run(struct test_tcp_sim *sim, const struct tcp_cc_ops *cc, u16_t loss)
+{
+  memset(sim, 0, sizeof(*sim));
+  sim->delay = 40;
+  sim->rate = 100;
+  sim->loss = loss;
+  /* a loss pattern with single losses spread over the transfer */
+  sim->seed = 1;
+  sim->setup = test_cc_sim_setup;
+#if LWIP_TCP_SACK_IN
+  sim->established = test_cc_sim_established;
+#endif /* LWIP_TCP_SACK_IN */
+  sim->arg = cc;
+  return test_tcp_sim_run(sim);
+}
+
+/* Goodput and window of all algorithms over a clean and a lossy (2%) path
+   with 80 ms RTT. The test configuration's small windows keep all of them
+   window limited on the clean path; with loss, newreno halves its window
+   while bbrlite keeps it. Windows are compared to the same algorithm's
+   clean run, with a wide margin on both sides */
+START_TEST(test_tcp_cc_sim)
+{
+  static const struct tcp_cc_ops *const algs[] = {&tcp_cc_newreno, &tcp_cc_cubic, &tcp_cc_bbrlite};
+  u32_t clean[LWIP_ARRAYSIZE(algs)], lossy[LWIP_ARRAYSIZE(algs)];
+  u32_t clean_wnd[LWIP_ARRAYSIZE(algs)], lossy_wnd[LWIP_ARRAYSIZE(algs)];
+  struct test_tcp_sim sim;
+  size_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < LWIP_ARRAYSIZE(algs); i++) {
+    clean[i] = test_cc_sim_run(&sim, algs[i], 0);
+    clean_wnd[i] = sim.cwnd_avg;
+    lossy[i] = test_cc_sim_run(&sim, algs[i], 20);
+    lossy_wnd[i] = sim.cwnd_avg;
+    fail_unless(sim.tx_lost > 0);
+    fail_unless(lossy[i] < clean[i]);
+  }
+  /* window limited: TCP_WND per RTT, minus the handshake */
+  fail_unless(clean[0] > (TCP_WND * 1000UL) / 80 / 2);
+  fail_unless(lossy_wnd[0] * 4 < clean_wnd[0] * 3);
+  fail_unless(lossy_wnd[2] * 4 > clean_wnd[2] * 3);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+tcp_cc_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_tcp_cc_newreno),
+    TESTFUNC(test_tcp_cc_cubic),
+    TESTFUNC(test_tcp_cc_cubic_monotonic),
+    TESTFUNC(test_tcp_cc_bbrlite),
+    TESTFUNC(test_tcp_cc_sim)
+  };
+  return create_suite("TCP_CC", tests, sizeof(tests)/sizeof(testfunc), tcp_cc_setup, tcp_cc_teardown);
+}
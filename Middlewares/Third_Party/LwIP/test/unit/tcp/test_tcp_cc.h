@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_TCP_CC_H
+#define LWIP_HDR_TEST_TCP_CC_H
+
+#include "../lwip_check.h"
+
+Suite *tcp_cc_suite(void);
+
+#endif
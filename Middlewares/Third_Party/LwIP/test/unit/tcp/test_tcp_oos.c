@@ -22,6 +22,14 @@
 #define EXPECT_OOSEQ(x)
 #endif
 
+/** TCP_OOSEQ_RANGES merges contiguous segments into one segment per range:
+ * OOSEQ_LAYOUT selects the value expected for the layout in use */
+#if TCP_OOSEQ_RANGES
+#define OOSEQ_LAYOUT(segs, ranges) (ranges)
+#else
+#define OOSEQ_LAYOUT(segs, ranges) (segs)
+#endif
+
 /* helper functions */
 
 /** Get the numbers of segments on the ooseq list */
@@ -222,11 +230,18 @@ START_TEST(test_tcp_recv_ooseq_FIN_OOSEQ)
     EXPECT(counters.recved_bytes == 0);
     EXPECT(counters.err_calls == 0);
     /* check ooseq queue */
+#if TCP_OOSEQ_RANGES
+    /* merged with p_8_9 */
+    EXPECT_OOSEQ(tcp_oos_count(pcb) == 1);
+    EXPECT_OOSEQ(tcp_oos_seg_seqno(pcb, 0) == 4);
+    EXPECT_OOSEQ(tcp_oos_seg_tcplen(pcb, 0) == 13); /* includes FIN */
+#else /* TCP_OOSEQ_RANGES */
     EXPECT_OOSEQ(tcp_oos_count(pcb) == 2);
     EXPECT_OOSEQ(tcp_oos_seg_seqno(pcb, 0) == 4);
     EXPECT_OOSEQ(tcp_oos_seg_tcplen(pcb, 0) == 4);
     EXPECT_OOSEQ(tcp_oos_seg_seqno(pcb, 1) == 8);
     EXPECT_OOSEQ(tcp_oos_seg_tcplen(pcb, 1) == 9); /* includes FIN */
+#endif /* TCP_OOSEQ_RANGES */
 
     /* pass the segment to tcp_input */
     test_tcp_input(p_4_10, &netif);
@@ -236,11 +251,17 @@ START_TEST(test_tcp_recv_ooseq_FIN_OOSEQ)
     EXPECT(counters.recved_bytes == 0);
     EXPECT(counters.err_calls == 0);
     /* ooseq queue: unchanged */
+#if TCP_OOSEQ_RANGES
+    EXPECT_OOSEQ(tcp_oos_count(pcb) == 1);
+    EXPECT_OOSEQ(tcp_oos_seg_seqno(pcb, 0) == 4);
+    EXPECT_OOSEQ(tcp_oos_seg_tcplen(pcb, 0) == 13); /* includes FIN */
+#else /* TCP_OOSEQ_RANGES */
     EXPECT_OOSEQ(tcp_oos_count(pcb) == 2);
     EXPECT_OOSEQ(tcp_oos_seg_seqno(pcb, 0) == 4);
     EXPECT_OOSEQ(tcp_oos_seg_tcplen(pcb, 0) == 4);
     EXPECT_OOSEQ(tcp_oos_seg_seqno(pcb, 1) == 8);
     EXPECT_OOSEQ(tcp_oos_seg_tcplen(pcb, 1) == 9); /* includes FIN */
+#endif /* TCP_OOSEQ_RANGES */
 
     /* pass the segment to tcp_input */
     test_tcp_input(p_2_14, &netif);
@@ -382,12 +403,19 @@ START_TEST(test_tcp_recv_ooseq_FIN_INSEQ)
     EXPECT(counters.recved_bytes == 0);
     EXPECT(counters.err_calls == 0);
     /* check ooseq queue */
+#if TCP_OOSEQ_RANGES
+    /* p_3_11 has closed the gap between p_1_2 and p_4_8 */
+    EXPECT_OOSEQ(tcp_oos_count(pcb) == 1);
+    EXPECT_OOSEQ(tcp_oos_seg_seqno(pcb, 0) == 1);
+    EXPECT_OOSEQ(tcp_oos_seg_tcplen(pcb, 0) == 13);
+#else /* TCP_OOSEQ_RANGES */
     EXPECT_OOSEQ(tcp_oos_count(pcb) == 2);
     EXPECT_OOSEQ(tcp_oos_seg_seqno(pcb, 0) == 1);
     EXPECT_OOSEQ(tcp_oos_seg_tcplen(pcb, 0) == 2);
     /* p_3_11 has removed p_4_8 from ooseq */
     EXPECT_OOSEQ(tcp_oos_seg_seqno(pcb, 1) == 3);
     EXPECT_OOSEQ(tcp_oos_seg_tcplen(pcb, 1) == 11);
+#endif /* TCP_OOSEQ_RANGES */
 
     /* pass the segment to tcp_input */
     test_tcp_input(p_2_12, &netif);
@@ -397,11 +425,18 @@ START_TEST(test_tcp_recv_ooseq_FIN_INSEQ)
     EXPECT(counters.recved_bytes == 0);
     EXPECT(counters.err_calls == 0);
     /* check ooseq queue */
+#if TCP_OOSEQ_RANGES
+    /* p_2_12 is contained in the range: unchanged */
+    EXPECT_OOSEQ(tcp_oos_count(pcb) == 1);
+    EXPECT_OOSEQ(tcp_oos_seg_seqno(pcb, 0) == 1);
+    EXPECT_OOSEQ(tcp_oos_seg_tcplen(pcb, 0) == 13);
+#else /* TCP_OOSEQ_RANGES */
     EXPECT_OOSEQ(tcp_oos_count(pcb) == 2);
     EXPECT_OOSEQ(tcp_oos_seg_seqno(pcb, 0) == 1);
     EXPECT_OOSEQ(tcp_oos_seg_tcplen(pcb, 0) == 1);
     EXPECT_OOSEQ(tcp_oos_seg_seqno(pcb, 1) == 2);
     EXPECT_OOSEQ(tcp_oos_seg_tcplen(pcb, 1) == 12);
+#endif /* TCP_OOSEQ_RANGES */
 
     /* pass the segment to tcp_input */
     test_tcp_input(pinseq, &netif);
@@ -503,7 +538,8 @@ START_TEST(test_tcp_recv_ooseq_overrun_rxwin)
     EXPECT(counters.err_calls == 0);
     /* check ooseq queue */
     count = tcp_oos_count(pcb);
-    EXPECT_OOSEQ(count == k+1);
+    /* contiguous segments form one range */
+    EXPECT_OOSEQ(count == OOSEQ_LAYOUT(k+1, 1));
     datalen = tcp_oos_tcplen(pcb);
     if (i + TCP_MSS < TCP_WND) {
       expected_datalen = (k+1)*TCP_MSS;
@@ -511,7 +547,7 @@ START_TEST(test_tcp_recv_ooseq_overrun_rxwin)
       expected_datalen = TCP_WND - TCP_MSS;
     }
     if (datalen != expected_datalen) {
-      EXPECT_OOSEQ(datalen == expected_datalen);
+      EXPECT(datalen == expected_datalen);
     }
   }
 
@@ -526,9 +562,9 @@ START_TEST(test_tcp_recv_ooseq_overrun_rxwin)
   EXPECT(counters.recved_bytes == 0);
   EXPECT(counters.err_calls == 0);
   /* check ooseq queue */
-  EXPECT_OOSEQ(tcp_oos_count(pcb) == k);
+  EXPECT_OOSEQ(tcp_oos_count(pcb) == OOSEQ_LAYOUT(k, 1));
   datalen2 = tcp_oos_tcplen(pcb);
-  EXPECT_OOSEQ(datalen == datalen2);
+  EXPECT(datalen == datalen2);
 
   /* now pass inseq */
   test_tcp_input(pinseq, &netif);
@@ -590,7 +626,8 @@ START_TEST(test_tcp_recv_ooseq_overrun_rxwin_edge)
     EXPECT(counters.err_calls == 0);
     /* check ooseq queue */
     count = tcp_oos_count(pcb);
-    EXPECT_OOSEQ(count == k+1);
+    /* contiguous segments form one range */
+    EXPECT_OOSEQ(count == OOSEQ_LAYOUT(k+1, 1));
     datalen = tcp_oos_tcplen(pcb);
     if (i + TCP_MSS < TCP_WND) {
       expected_datalen = (k+1)*TCP_MSS;
@@ -598,7 +635,7 @@ START_TEST(test_tcp_recv_ooseq_overrun_rxwin_edge)
       expected_datalen = TCP_WND - TCP_MSS;
     }
     if (datalen != expected_datalen) {
-      EXPECT_OOSEQ(datalen == expected_datalen);
+      EXPECT(datalen == expected_datalen);
     }
   }
 
@@ -613,9 +650,9 @@ START_TEST(test_tcp_recv_ooseq_overrun_rxwin_edge)
   EXPECT(counters.recved_bytes == 0);
   EXPECT(counters.err_calls == 0);
   /* check ooseq queue */
-  EXPECT_OOSEQ(tcp_oos_count(pcb) == k);
+  EXPECT_OOSEQ(tcp_oos_count(pcb) == OOSEQ_LAYOUT(k, 1));
   datalen2 = tcp_oos_tcplen(pcb);
-  EXPECT_OOSEQ(datalen == datalen2);
+  EXPECT(datalen == datalen2);
 
   /* now pass inseq */
   test_tcp_input(pinseq, &netif);
@@ -692,7 +729,7 @@ START_TEST(test_tcp_recv_ooseq_max_bytes)
   EXPECT(counters.recved_bytes == 0);
   EXPECT(counters.err_calls == 0);
   /* check ooseq queue (ensure the new segment was not accepted) */
-  EXPECT_OOSEQ(tcp_oos_count(pcb) == (i-1));
+  EXPECT_OOSEQ(tcp_oos_count(pcb) == OOSEQ_LAYOUT(i-1, 1));
   datalen2 = tcp_oos_tcplen(pcb);
   EXPECT_OOSEQ(datalen2 == ((i-1) * TCP_MSS));
 
@@ -767,7 +804,7 @@ START_TEST(test_tcp_recv_ooseq_max_pbufs)
   EXPECT(counters.recved_bytes == 0);
   EXPECT(counters.err_calls == 0);
   /* check ooseq queue (ensure the new segment was not accepted) */
-  EXPECT_OOSEQ(tcp_oos_count(pcb) == (i-1));
+  EXPECT_OOSEQ(tcp_oos_count(pcb) == OOSEQ_LAYOUT(i-1, 1));
   datalen2 = tcp_oos_tcplen(pcb);
   EXPECT_OOSEQ(datalen2 == (i-1));
 
@@ -792,7 +829,7 @@ check_rx_counters(struct tcp_pcb *pcb, struct test_tcp_counters *counters, u32_t
   /* check that pbuf is queued in ooseq */
   EXPECT_OOSEQ(tcp_oos_count(pcb) == exp_oos_count);
   oos_len = tcp_oos_tcplen(pcb);
-  EXPECT_OOSEQ(exp_oos_len == oos_len);
+  EXPECT(exp_oos_len == oos_len);
 }
 
 /* this test uses 4 packets:
@@ -902,8 +939,8 @@ static void test_tcp_recv_ooseq_double_FINs(int delay_packet)
     if (first_dropped < 3) {
       /* already dropped packets, this one is ooseq */
       if (delay_packet & 2) {
-        /* correct FIN was ooseq */
-        exp_oos_pbufs++;
+        /* correct FIN was ooseq; a range takes it in after data-after-FIN */
+        exp_oos_pbufs += OOSEQ_LAYOUT(1, (delay_packet & 4) ? 1 : 0);
         exp_oos_tcplen++;
       }
     } else {
@@ -985,6 +1022,282 @@ FIN_TEST(test_tcp_recv_ooseq_double_FIN_13, 13)
 FIN_TEST(test_tcp_recv_ooseq_double_FIN_14, 14)
 FIN_TEST(test_tcp_recv_ooseq_double_FIN_15, 15)
 
+#if TCP_OOSEQ_RANGES && !TCP_OOSEQ_MAX_BYTES && !TCP_OOSEQ_MAX_PBUFS
+#define OOSEQ_RANGES_SEGS  40
+#define OOSEQ_RANGES_SEGLEN (TCP_WND / OOSEQ_RANGES_SEGS)
+
+/** Check that the ooseq index matches pcb->ooseq (sorted, not overlapping,
+ * contiguous segments merged) and return the number of ranges */
+static int
+tcp_oos_check_ranges(struct tcp_pcb* pcb)
+{
+  int num = 0;
+  struct tcp_seg* seg;
+
+  for (seg = pcb->ooseq; seg != NULL; seg = seg->next, num++) {
+    EXPECT_RETX(num < pcb->ooseq_num, -1);
+    EXPECT(pcb->ooseq_idx[num] == seg);
+    EXPECT(seg->p->tot_len == seg->len);
+    if (seg->next != NULL) {
+      EXPECT(TCP_SEQ_LT(seg->tcphdr->seqno + seg->len, seg->next->tcphdr->seqno));
+    }
+  }
+  EXPECT(num == pcb->ooseq_num);
+  return num;
+}
+
+/** Pass in the rest of the window in order and check that all data arrives */
+static void
+tcp_oos_recv_rest(struct tcp_pcb* pcb, struct test_tcp_counters* counters, struct netif* netif)
+{
+  while (counters->recved_bytes < TCP_WND) {
+    u32_t len = LWIP_MIN(TCP_MSS, TCP_WND - counters->recved_bytes);
+    struct pbuf *p = tcp_create_rx_segment(pcb, &data_full_wnd[counters->recved_bytes],
+                                           len, 0, 0, TCP_ACK);
+    u32_t before = counters->recved_bytes;
+    EXPECT_RET(p != NULL);
+    test_tcp_input(p, netif);
+    EXPECT_RET(counters->recved_bytes > before);
+  }
+  EXPECT(counters->recved_bytes == TCP_WND);
+  EXPECT(pcb->ooseq == NULL);
+  EXPECT(pcb->ooseq_num == 0);
+}
+
+static u32_t
+tcp_oos_rand(u32_t *seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 16;
+}
+#endif /* TCP_OOSEQ_RANGES && !TCP_OOSEQ_MAX_BYTES && !TCP_OOSEQ_MAX_PBUFS */
+
+/** pass segments in random order and check that the ooseq queue holds one
+ * segment per range, with the highest ranges dropped first if the index is full */
+START_TEST(test_tcp_recv_ooseq_ranges_reorder)
+{
+#if TCP_OOSEQ_RANGES && !TCP_OOSEQ_MAX_BYTES && !TCP_OOSEQ_MAX_PBUFS
+  struct test_tcp_counters counters;
+  struct tcp_pcb* pcb;
+  struct netif netif;
+  u8_t order[OOSEQ_RANGES_SEGS];
+  u8_t got[OOSEQ_RANGES_SEGS + 1];
+  u32_t seed = 0x1234;
+  int i, k;
+  LWIP_UNUSED_ARG(_i);
+
+  for(i = 0; i < (int)sizeof(data_full_wnd); i++) {
+    data_full_wnd[i] = (char)i;
+  }
+  test_tcp_init_netif(&netif, NULL, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+  counters.expected_data_len = TCP_WND;
+  counters.expected_data = data_full_wnd;
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->rcv_nxt = 0x8000;
+
+  /* shuffle all segments but the first one */
+  for (i = 0; i < OOSEQ_RANGES_SEGS; i++) {
+    order[i] = (u8_t)i;
+  }
+  for (i = OOSEQ_RANGES_SEGS - 1; i > 1; i--) {
+    u8_t tmp;
+    k = 1 + (int)(tcp_oos_rand(&seed) % (u32_t)i);
+    tmp = order[i];
+    order[i] = order[k];
+    order[k] = tmp;
+  }
+  memset(got, 0, sizeof(got));
+
+  for (i = 1; i < OOSEQ_RANGES_SEGS; i++) {
+    int seg = order[i];
+    int ranges = 0, bytes = 0, highest = 0;
+    struct pbuf *p = tcp_create_rx_segment(pcb, &data_full_wnd[seg * OOSEQ_RANGES_SEGLEN],
+                                           OOSEQ_RANGES_SEGLEN, (u32_t)(seg * OOSEQ_RANGES_SEGLEN), 0, TCP_ACK);
+    EXPECT_RET(p != NULL);
+    test_tcp_input(p, &netif);
+
+    /* model: a segment that does not touch a queued range needs a new one;
+       if the index is full, the highest range is dropped (or the segment) */
+    for (k = 1; k < OOSEQ_RANGES_SEGS; k++) {
+      if (got[k]) {
+        ranges += !got[k - 1];
+        highest = k;
+      }
+    }
+    if (got[seg - 1] || got[seg + 1] || ranges < TCP_OOSEQ_RANGES) {
+      got[seg] = 1;
+    } else if (seg < highest) {
+      for (k = highest; got[k]; k--) {
+        got[k] = 0;
+      }
+      got[seg] = 1;
+    }
+    ranges = 0;
+    for (k = 1; k < OOSEQ_RANGES_SEGS; k++) {
+      ranges += got[k] && !got[k - 1];
+      bytes += got[k] ? OOSEQ_RANGES_SEGLEN : 0;
+    }
+    EXPECT(tcp_oos_check_ranges(pcb) == ranges);
+    EXPECT(tcp_oos_tcplen(pcb) == bytes);
+    EXPECT(counters.recv_calls == 0);
+  }
+
+  tcp_oos_recv_rest(pcb, &counters, &netif);
+  EXPECT(counters.err_calls == 0);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+#else /* TCP_OOSEQ_RANGES && !TCP_OOSEQ_MAX_BYTES && !TCP_OOSEQ_MAX_PBUFS */
+  LWIP_UNUSED_ARG(_i);
+#endif /* TCP_OOSEQ_RANGES && !TCP_OOSEQ_MAX_BYTES && !TCP_OOSEQ_MAX_PBUFS */
+}
+END_TEST
+
+/** pass overlapping segments of random position and length */
+START_TEST(test_tcp_recv_ooseq_ranges_overlap)
+{
+#if TCP_OOSEQ_RANGES && !TCP_OOSEQ_MAX_BYTES && !TCP_OOSEQ_MAX_PBUFS
+  struct test_tcp_counters counters;
+  struct tcp_pcb* pcb;
+  struct netif netif;
+  u32_t seed = 0x4711;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  for(i = 0; i < (int)sizeof(data_full_wnd); i++) {
+    data_full_wnd[i] = (char)(i * 7);
+  }
+  test_tcp_init_netif(&netif, NULL, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+  counters.expected_data_len = TCP_WND;
+  counters.expected_data = data_full_wnd;
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->rcv_nxt = 0xffffffff - (TCP_WND / 2);
+
+  for (i = 0; i < 500; i++) {
+    /* segments may overrun the window by up to one mss */
+    u32_t off = 1 + tcp_oos_rand(&seed) % (TCP_WND - 1);
+    u32_t len = 1 + tcp_oos_rand(&seed) % TCP_MSS;
+    int ranges;
+    struct pbuf *p = tcp_create_rx_segment(pcb, &data_full_wnd[off], len, off, 0, TCP_ACK);
+    EXPECT_RET(p != NULL);
+    test_tcp_input(p, &netif);
+    ranges = tcp_oos_check_ranges(pcb);
+    EXPECT(ranges >= 1 && ranges <= TCP_OOSEQ_RANGES);
+    EXPECT(tcp_oos_tcplen(pcb) <= TCP_WND - 1);
+    EXPECT(counters.recv_calls == 0);
+  }
+
+  tcp_oos_recv_rest(pcb, &counters, &netif);
+  EXPECT(counters.err_calls == 0);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+#else /* TCP_OOSEQ_RANGES && !TCP_OOSEQ_MAX_BYTES && !TCP_OOSEQ_MAX_PBUFS */
+  LWIP_UNUSED_ARG(_i);
+#endif /* TCP_OOSEQ_RANGES && !TCP_OOSEQ_MAX_BYTES && !TCP_OOSEQ_MAX_PBUFS */
+}
+END_TEST
+
+/** fill the ooseq index, then merge, evict and free ranges tail-first */
+START_TEST(test_tcp_recv_ooseq_ranges_evict)
+{
+#if TCP_OOSEQ_RANGES >= 4 && !TCP_OOSEQ_MAX_BYTES && !TCP_OOSEQ_MAX_PBUFS && ((4 * TCP_OOSEQ_RANGES + 8) < TCP_WND)
+  struct test_tcp_counters counters;
+  struct tcp_pcb* pcb;
+  struct netif netif;
+  struct pbuf *p;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  for(i = 0; i < (int)sizeof(data_full_wnd); i++) {
+    data_full_wnd[i] = (char)i;
+  }
+  test_tcp_init_netif(&netif, NULL, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+  counters.expected_data_len = TCP_WND;
+  counters.expected_data = data_full_wnd;
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->rcv_nxt = 0x8000;
+#if LWIP_TCP_SACK_OUT
+  tcp_set_flags(pcb, TF_SACK);
+#endif /* LWIP_TCP_SACK_OUT */
+
+  /* one byte every 4 bytes fills the index */
+  for (i = 1; i <= TCP_OOSEQ_RANGES; i++) {
+    p = tcp_create_rx_segment(pcb, &data_full_wnd[4 * i], 1, (u32_t)(4 * i), 0, TCP_ACK);
+    EXPECT_RET(p != NULL);
+    test_tcp_input(p, &netif);
+  }
+  EXPECT(tcp_oos_check_ranges(pcb) == TCP_OOSEQ_RANGES);
+
+  /* a new range above all others is dropped */
+  p = tcp_create_rx_segment(pcb, &data_full_wnd[4 * i], 1, (u32_t)(4 * i), 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(tcp_oos_check_ranges(pcb) == TCP_OOSEQ_RANGES);
+  EXPECT(tcp_oos_tcplen(pcb) == TCP_OOSEQ_RANGES);
+
+  /* appending to [4,5) and prepending to [12,13) needs no new range */
+  p = tcp_create_rx_segment(pcb, &data_full_wnd[5], 1, 5, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  p = tcp_create_rx_segment(pcb, &data_full_wnd[11], 1, 11, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(tcp_oos_check_ranges(pcb) == TCP_OOSEQ_RANGES);
+  EXPECT(pcb->ooseq_idx[0]->len == 2);
+  EXPECT(pcb->ooseq_idx[2]->tcphdr->seqno == pcb->rcv_nxt + 11);
+
+  /* closing the hole between [8,9) and [11,13) frees a range */
+  p = tcp_create_rx_segment(pcb, &data_full_wnd[9], 2, 9, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(tcp_oos_check_ranges(pcb) == TCP_OOSEQ_RANGES - 1);
+  EXPECT(pcb->ooseq_idx[1]->len == 5);
+
+  /* a new range below the highest one evicts it */
+  p = tcp_create_rx_segment(pcb, &data_full_wnd[2], 1, 2, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  p = tcp_create_rx_segment(pcb, &data_full_wnd[18], 1, 18, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(tcp_oos_check_ranges(pcb) == TCP_OOSEQ_RANGES);
+  EXPECT(pcb->ooseq_idx[TCP_OOSEQ_RANGES - 1]->tcphdr->seqno == pcb->rcv_nxt + 4 * (TCP_OOSEQ_RANGES - 1));
+
+  /* memory pressure frees the highest range only */
+  tcp_free_ooseq_tail(pcb);
+  EXPECT(tcp_oos_check_ranges(pcb) == TCP_OOSEQ_RANGES - 1);
+  EXPECT(pcb->ooseq_idx[0]->tcphdr->seqno == pcb->rcv_nxt + 2);
+#if LWIP_TCP_SACK_OUT
+  for (i = 0; i < LWIP_TCP_MAX_SACK_NUM && LWIP_TCP_SACK_VALID(pcb, i); i++) {
+    EXPECT(TCP_SEQ_LEQ(pcb->rcv_sacks[i].right, pcb->rcv_nxt + 4 * (TCP_OOSEQ_RANGES - 2) + 1));
+  }
+  EXPECT(i > 0);
+#endif /* LWIP_TCP_SACK_OUT */
+
+  tcp_oos_recv_rest(pcb, &counters, &netif);
+  EXPECT(counters.err_calls == 0);
+
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+#else /* TCP_OOSEQ_RANGES >= 4 && !TCP_OOSEQ_MAX_BYTES && !TCP_OOSEQ_MAX_PBUFS && ((4 * TCP_OOSEQ_RANGES + 8) < TCP_WND) */
+  LWIP_UNUSED_ARG(_i);
+#endif /* TCP_OOSEQ_RANGES >= 4 && !TCP_OOSEQ_MAX_BYTES && !TCP_OOSEQ_MAX_PBUFS && ((4 * TCP_OOSEQ_RANGES + 8) < TCP_WND) */
+}
+END_TEST
+
 
 /** Create the suite including all tests for this module */
 Suite *
@@ -1012,7 +1325,10 @@ tcp_oos_suite(void)
     TESTFUNC(test_tcp_recv_ooseq_double_FIN_12),
     TESTFUNC(test_tcp_recv_ooseq_double_FIN_13),
     TESTFUNC(test_tcp_recv_ooseq_double_FIN_14),
-    TESTFUNC(test_tcp_recv_ooseq_double_FIN_15)
+    TESTFUNC(test_tcp_recv_ooseq_double_FIN_15),
+    TESTFUNC(test_tcp_recv_ooseq_ranges_reorder),
+    TESTFUNC(test_tcp_recv_ooseq_ranges_overlap),
+    TESTFUNC(test_tcp_recv_ooseq_ranges_evict)
   };
   return create_suite("TCP_OOS", tests, sizeof(tests)/sizeof(testfunc), tcp_oos_setup, tcp_oos_teardown);
 }
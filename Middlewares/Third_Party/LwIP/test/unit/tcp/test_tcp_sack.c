@@ -0,0 +1,357 @@
+#include "test_tcp_sack.h"
+
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/stats.h"
+#include "tcp_helper.h"
+
+#if !LWIP_TCP_SACK_IN || !LWIP_TCP_SACK_OUT || !LWIP_IPV4
+#error "This tests needs LWIP_TCP_SACK_IN, LWIP_TCP_SACK_OUT and IPv4 enabled"
+#endif
+
+extern u32_t lwip_sys_now;
+
+/* Setups/teardown functions */
+static struct netif *old_netif_list;
+static struct netif *old_netif_default;
+
+static void
+tcp_sack_setup(void)
+{
+  old_netif_list = netif_list;
+  old_netif_default = netif_default;
+  netif_list = NULL;
+  netif_default = NULL;
+  tcp_remove_all();
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+tcp_sack_teardown(void)
+{
+  netif_list = NULL;
+  netif_default = NULL;
+  tcp_remove_all();
+  netif_list = old_netif_list;
+  netif_default = old_netif_default;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* An established pcb with SACK permitted that has sent 'num' full segments */
+static struct tcp_pcb *
+test_sack_pcb(struct test_tcp_counters *counters, int num)
+{
+  static char data[TCP_MSS];
+  struct tcp_pcb *pcb;
+  int i;
+
+  memset(counters, 0, sizeof(*counters));
+  pcb = test_tcp_new_counters_pcb(counters);
+  fail_unless(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  /* disable initial congestion window (we don't send a SYN here...) */
+  pcb->cwnd = pcb->snd_wnd;
+  tcp_set_flags(pcb, TF_SACK);
+  tcp_nagle_disable(pcb);
+  /* write and send one by one so that every segment has TCP_MSS bytes */
+  for (i = 0; i < num; i++) {
+    fail_unless(tcp_write(pcb, data, TCP_MSS, TCP_WRITE_FLAG_COPY) == ERR_OK);
+    fail_unless(tcp_output(pcb) == ERR_OK);
+  }
+  fail_unless(pcb->unsent == NULL);
+  return pcb;
+}
+
+/* Receive an ACK for 'acked' bytes carrying one SACK block (relative to the
+   lastack before this ACK) */
+static void
+test_sack_input(struct tcp_pcb *pcb, struct netif *netif, u32_t acked, u32_t left, u32_t right)
+{
+  u8_t opts[12];
+  u32_t val;
+  struct pbuf *p;
+
+  opts[0] = LWIP_TCP_OPT_NOP;
+  opts[1] = LWIP_TCP_OPT_NOP;
+  opts[2] = LWIP_TCP_OPT_SACK;
+  opts[3] = 10;
+  val = lwip_htonl(pcb->lastack + left);
+  MEMCPY(&opts[4], &val, 4);
+  val = lwip_htonl(pcb->lastack + right);
+  MEMCPY(&opts[8], &val, 4);
+  p = tcp_create_rx_segment_opts(pcb, NULL, 0, 0, acked, TCP_ACK, opts, sizeof(opts));
+  fail_unless(p != NULL);
+  test_tcp_input(p, netif);
+}
+
+static u32_t
+test_sack_tx_seqno(struct pbuf *p)
+{
+  struct tcp_hdr tcphdr;
+  fail_unless(pbuf_copy_partial(p, &tcphdr, sizeof(tcphdr), IP_HLEN) == sizeof(tcphdr));
+  return lwip_ntohl(tcphdr.seqno);
+}
+
+/* Test functions */
+
+/** A SACK for everything but the 2nd segment retransmits exactly that one */
+START_TEST(test_tcp_sack_scoreboard)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct tcp_seg *seg;
+  struct pbuf *p;
+  u32_t base;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  pcb = test_sack_pcb(&counters, 6);
+  base = pcb->lastack;
+  EXPECT(txcounters.num_tx_calls == 6);
+
+  /* the 1st segment is acked, the 2nd is missing */
+  memset(&txcounters, 0, sizeof(txcounters));
+  txcounters.copy_tx_packets = 1;
+  lwip_sys_now += 20;
+  test_sack_input(pcb, &netif, TCP_MSS, 2 * TCP_MSS, 6 * TCP_MSS);
+  EXPECT(pcb->lastack == base + TCP_MSS);
+  EXPECT(pcb->rack_flags & TCP_RACK_VALID);
+  EXPECT(pcb->rack_rtt == 20);
+  EXPECT(pcb->flags & TF_INFR);
+  EXPECT(pcb->rack_flags & TCP_SACK_RECOVERY);
+  EXPECT(pcb->sack_recover == base + 6 * TCP_MSS);
+  EXPECT(txcounters.num_tx_calls == 1);
+  p = txcounters.tx_packets;
+  EXPECT_RET(p != NULL);
+  EXPECT(test_sack_tx_seqno(p) == base + TCP_MSS);
+  pbuf_free(p);
+  txcounters.tx_packets = NULL;
+  /* the retransmitted segment is sorted back into unacked */
+  EXPECT_RET(pcb->unacked != NULL);
+  EXPECT(lwip_ntohl(pcb->unacked->tcphdr->seqno) == base + TCP_MSS);
+  EXPECT(pcb->unacked->flags & TF_SEG_REXMIT);
+  for (seg = pcb->unacked->next; seg != NULL; seg = seg->next) {
+    EXPECT(seg->flags & TF_SEG_SACKED);
+  }
+  EXPECT(pcb->cwnd >= pcb->ssthresh + 4 * TCP_MSS);
+
+  /* the same SACK again does not retransmit */
+  memset(&txcounters, 0, sizeof(txcounters));
+  test_sack_input(pcb, &netif, 0, TCP_MSS, 5 * TCP_MSS);
+  EXPECT(txcounters.num_tx_calls == 0);
+
+  /* recovery ends with the ACK for everything sent before */
+  test_sack_input(pcb, &netif, 5 * TCP_MSS, 0, 0);
+  EXPECT(pcb->unacked == NULL);
+  EXPECT(!(pcb->flags & TF_INFR));
+  EXPECT(!(pcb->rack_flags & TCP_SACK_RECOVERY));
+  EXPECT(pcb->cwnd < pcb->ssthresh + 4 * TCP_MSS);
+  EXPECT(txcounters.num_tx_calls == 0);
+
+  tcp_abort(pcb);
+}
+END_TEST
+
+/** With few segments SACKed, loss is declared after the reordering window
+ * by the RACK timer */
+START_TEST(test_tcp_sack_rack_timer)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  u32_t base;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  pcb = test_sack_pcb(&counters, 4);
+  base = pcb->lastack;
+
+  /* 1st acked, 4th SACKed: reo_wnd is min_rtt/4 = 5 ms */
+  memset(&txcounters, 0, sizeof(txcounters));
+  lwip_sys_now += 20;
+  test_sack_input(pcb, &netif, TCP_MSS, 3 * TCP_MSS, 4 * TCP_MSS);
+  EXPECT(txcounters.num_tx_calls == 0);
+  EXPECT(pcb->rack_flags & TCP_RACK_TMR);
+  EXPECT(pcb->rack_tmr == lwip_sys_now + 5);
+  EXPECT(!(pcb->flags & TF_INFR));
+
+  /* not expired yet */
+  lwip_sys_now += 4;
+  tcp_fasttmr();
+  EXPECT(txcounters.num_tx_calls == 0);
+  EXPECT(pcb->rack_flags & TCP_RACK_TMR);
+
+  /* 2nd and 3rd are lost */
+  lwip_sys_now += 1;
+  tcp_fasttmr();
+  EXPECT(txcounters.num_tx_calls == 2);
+  EXPECT(!(pcb->rack_flags & TCP_RACK_TMR));
+  EXPECT(pcb->flags & TF_INFR);
+  EXPECT(pcb->sack_recover == base + 4 * TCP_MSS);
+
+  memset(&txcounters, 0, sizeof(txcounters));
+  test_sack_input(pcb, &netif, 3 * TCP_MSS, 0, 0);
+  EXPECT(pcb->unacked == NULL);
+  EXPECT(!(pcb->flags & TF_INFR));
+  EXPECT(txcounters.num_tx_calls == 0);
+
+  tcp_abort(pcb);
+}
+END_TEST
+
+/** A cumulative ACK for a segment sent before a SACKed one detects
+ * reordering, which keeps the reordering window open */
+START_TEST(test_tcp_sack_reorder)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  pcb = test_sack_pcb(&counters, 8);
+
+  /* the 2nd segment overtakes the 1st */
+  memset(&txcounters, 0, sizeof(txcounters));
+  lwip_sys_now += 20;
+  test_sack_input(pcb, &netif, 0, TCP_MSS, 2 * TCP_MSS);
+  EXPECT(pcb->rack_flags & TCP_RACK_TMR);
+  lwip_sys_now += 2;
+  test_sack_input(pcb, &netif, 2 * TCP_MSS, 0, 0);
+  EXPECT(pcb->rack_flags & TCP_RACK_REORDER);
+  EXPECT(txcounters.num_tx_calls == 0);
+
+  /* 3 segments SACKed would declare the 3rd lost at once without reordering */
+  test_sack_input(pcb, &netif, 0, TCP_MSS, 4 * TCP_MSS);
+  EXPECT(txcounters.num_tx_calls == 0);
+  EXPECT(!(pcb->flags & TF_INFR));
+  EXPECT(pcb->rack_flags & TCP_RACK_TMR);
+  lwip_sys_now += 5;
+  tcp_fasttmr();
+  EXPECT(txcounters.num_tx_calls == 1);
+  EXPECT(pcb->flags & TF_INFR);
+
+  tcp_abort(pcb);
+}
+END_TEST
+
+#if TCP_TSO
+/** A super-segment is split at the SACK edges, only the hole is resent */
+START_TEST(test_tcp_sack_split)
+{
+  static char data[4 * TCP_MSS];
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct pbuf *p;
+  u32_t base;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  pcb = test_sack_pcb(&counters, 0);
+  base = pcb->lastack;
+  err = tcp_write(pcb, data, sizeof(data), TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT_RET(pcb->unacked != NULL);
+  EXPECT_RET(pcb->unacked->len == sizeof(data));
+
+  /* the 1st frame of the super-segment is missing */
+  memset(&txcounters, 0, sizeof(txcounters));
+  txcounters.copy_tx_packets = 1;
+  lwip_sys_now += 20;
+  test_sack_input(pcb, &netif, 0, TCP_MSS, sizeof(data));
+  EXPECT(txcounters.num_tx_calls == 1);
+  p = txcounters.tx_packets;
+  EXPECT_RET(p != NULL);
+  EXPECT(test_sack_tx_seqno(p) == base);
+  EXPECT(p->tot_len == IP_HLEN + TCP_HLEN + TCP_MSS);
+  pbuf_free(p);
+  txcounters.tx_packets = NULL;
+  txcounters.copy_tx_packets = 0;
+
+  tcp_abort(pcb);
+}
+END_TEST
+#endif /* TCP_TSO */
+
+static void
+test_sack_sim_established(struct test_tcp_sim *sim)
+{
+  /* negotiated with the SYN/SYN-ACK */
+  fail_unless(sim->tx->flags & TF_SACK);
+  if (sim->arg == NULL) {
+    /* recover as without SACK (the receiver still sends them) */
+    tcp_clear_flags(sim->tx, TF_SACK);
+  }
+}
+
+static u32_t
+test_sack_sim_run(int sack, u16_t loss, u32_t seed, u32_t *redundant)
+{
+  struct test_tcp_sim sim;
+  u32_t goodput;
+  memset(&sim, 0, sizeof(sim));
+  sim.delay = 40;
+  sim.rate = 100;
+  sim.loss = loss;
+  sim.seed = seed;
+  sim.established = test_sack_sim_established;
+  sim.arg = sack ? &sim : NULL;
+  goodput = test_tcp_sim_run(&sim);
+  /* every byte lost has to be sent again, anything more is wasted */
+  fail_unless(sim.tx_data - TEST_TCP_SIM_BYTES >= sim.tx_lost);
+  *redundant = sim.tx_data - TEST_TCP_SIM_BYTES - sim.tx_lost;
+  return goodput;
+}
+
+/** Goodput and redundant retransmissions over a lossy path (80 ms RTT,
+ * 100 kB/s) with and without SACK based recovery, summed up over a few
+ * loss patterns (a single one may well end with a lost tail that only
+ * the RTO recovers) */
+START_TEST(test_tcp_sack_sim)
+{
+  static const u16_t losses[] = {20, 50};
+  u32_t goodput, goodput_nosack, redundant, redundant_nosack, val;
+  u32_t seed;
+  size_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < LWIP_ARRAYSIZE(losses); i++) {
+    goodput = goodput_nosack = redundant = redundant_nosack = 0;
+    for (seed = 1; seed <= 4; seed++) {
+      goodput += test_sack_sim_run(1, losses[i], seed, &val);
+      redundant += val;
+      goodput_nosack += test_sack_sim_run(0, losses[i], seed, &val);
+      redundant_nosack += val;
+    }
+    /* only the lost data is retransmitted */
+    EXPECT(redundant == 0);
+    EXPECT(redundant <= redundant_nosack);
+    EXPECT(goodput > goodput_nosack);
+  }
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+tcp_sack_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_tcp_sack_scoreboard),
+    TESTFUNC(test_tcp_sack_rack_timer),
+    TESTFUNC(test_tcp_sack_reorder),
+#if TCP_TSO
+    TESTFUNC(test_tcp_sack_split),
+#endif /* TCP_TSO */
+    TESTFUNC(test_tcp_sack_sim)
+  };
+  return create_suite("TCP_SACK", tests, sizeof(tests)/sizeof(testfunc), tcp_sack_setup, tcp_sack_teardown);
+}
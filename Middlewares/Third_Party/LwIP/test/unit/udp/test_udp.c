@@ -169,7 +169,8 @@ static void test_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
 }
 
 static struct pbuf *
-test_udp_create_test_packet(u16_t length, u16_t port, u32_t dst_addr)
+test_udp_create_test_packet_from(u16_t length, u32_t src_addr, u16_t src_port,
+                                 u32_t dst_addr, u16_t dst_port)
 {
   err_t err;
   u8_t ret;
@@ -192,13 +193,15 @@ test_udp_create_test_packet(u16_t length, u16_t port, u32_t dst_addr)
   fail_unless(!ret);
   uh = (struct udp_hdr *)p->payload;
   uh->chksum = 0;
-  uh->dest = uh->src = lwip_htons(port);
+  uh->src = lwip_htons(src_port);
+  uh->dest = lwip_htons(dst_port);
   uh->len = lwip_htons(p->tot_len);
   /* add IPv4 header */
   ret = pbuf_add_header(p, sizeof(struct ip_hdr));
   fail_unless(!ret);
   ih = (struct ip_hdr *)p->payload;
   memset(ih, 0, sizeof(*ih));
+  ih->src.addr = src_addr;
   ih->dest.addr = dst_addr;
   ih->_len = lwip_htons(p->tot_len);
   ih->_ttl = 32;
@@ -208,6 +211,12 @@ test_udp_create_test_packet(u16_t length, u16_t port, u32_t dst_addr)
   return p;
 }
 
+static struct pbuf *
+test_udp_create_test_packet(u16_t length, u16_t port, u32_t dst_addr)
+{
+  return test_udp_create_test_packet_from(length, 0, port, dst_addr, port);
+}
+
 /* bind 2 pcbs to specific netif IP and test which one gets broadcasts */
 START_TEST(test_udp_broadcast_rx_with_2_netifs)
 {
@@ -335,13 +344,183 @@ START_TEST(test_udp_broadcast_rx_with_2_netifs)
 }
 END_TEST
 
+/* bind many pcbs to different ports (some sharing a hash bucket) and check
+   every datagram reaches its pcb, also after rebinding and removing pcbs */
+START_TEST(test_udp_demux_many_ports)
+{
+#define TEST_UDP_DEMUX_PCBS 12
+  struct udp_pcb *pcbs[TEST_UDP_DEMUX_PCBS];
+  struct test_udp_rxdata ctrs[TEST_UDP_DEMUX_PCBS];
+  struct pbuf *p;
+  err_t err;
+  int i, j;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < TEST_UDP_DEMUX_PCBS; i++) {
+    pcbs[i] = udp_new();
+    fail_unless(pcbs[i] != NULL);
+    /* ports 16 apart end up in the same bucket for power-of-two tables */
+    err = udp_bind(pcbs[i], NULL, (u16_t)(5000 + (i % 2) + 16 * i));
+    fail_unless(err == ERR_OK);
+    memset(&ctrs[i], 0, sizeof(ctrs[i]));
+    ctrs[i].pcb = pcbs[i];
+    udp_recv(pcbs[i], test_recv, &ctrs[i]);
+  }
+  /* the same port may not be bound twice */
+  err = udp_bind(pcbs[0], NULL, pcbs[1]->local_port);
+  fail_unless(err == ERR_USE);
+
+  for (i = 0; i < TEST_UDP_DEMUX_PCBS; i++) {
+    p = test_udp_create_test_packet_from(16, 0, 1234, test_ipaddr1.addr, pcbs[i]->local_port);
+    EXPECT_RET(p != NULL);
+    err = ip4_input(p, &test_netif1);
+    fail_unless(err == ERR_OK);
+    for (j = 0; j < TEST_UDP_DEMUX_PCBS; j++) {
+      fail_unless(ctrs[j].rx_cnt == ((j <= i) ? 1U : 0U));
+    }
+  }
+
+  /* rebind: the old port is gone, the new one is found */
+  err = udp_bind(pcbs[3], NULL, 7000);
+  fail_unless(err == ERR_OK);
+  p = test_udp_create_test_packet_from(16, 0, 1234, test_ipaddr1.addr, 7000);
+  EXPECT_RET(p != NULL);
+  err = ip4_input(p, &test_netif1);
+  fail_unless(err == ERR_OK);
+  fail_unless(ctrs[3].rx_cnt == 2);
+  p = test_udp_create_test_packet_from(16, 0, 1234, test_ipaddr1.addr, 5000 + 1 + 16 * 3);
+  EXPECT_RET(p != NULL);
+  err = ip4_input(p, &test_netif1);
+  fail_unless(err == ERR_OK);
+  for (j = 0; j < TEST_UDP_DEMUX_PCBS; j++) {
+    fail_unless(ctrs[j].rx_cnt == ((j == 3) ? 2U : 1U));
+  }
+
+  /* remove every other pcb, the remaining ones must still be found */
+  for (i = 0; i < TEST_UDP_DEMUX_PCBS; i += 2) {
+    udp_remove(pcbs[i]);
+    pcbs[i] = NULL;
+  }
+  for (i = 1; i < TEST_UDP_DEMUX_PCBS; i += 2) {
+    p = test_udp_create_test_packet_from(16, 0, 1234, test_ipaddr1.addr, pcbs[i]->local_port);
+    EXPECT_RET(p != NULL);
+    err = ip4_input(p, &test_netif1);
+    fail_unless(err == ERR_OK);
+    fail_unless(ctrs[i].rx_cnt == ((i == 3) ? 3U : 2U));
+  }
+#undef TEST_UDP_DEMUX_PCBS
+}
+END_TEST
+
+#if SO_REUSE_PORT
+/* spread flows over a SO_REUSEPORT group by their remote address/port */
+START_TEST(test_udp_reuseport)
+{
+#define TEST_UDP_REUSEPORT_PCBS 4
+#define TEST_UDP_REUSEPORT_FLOWS 64
+  struct udp_pcb *pcbs[TEST_UDP_REUSEPORT_PCBS];
+  struct test_udp_rxdata ctrs[TEST_UDP_REUSEPORT_PCBS];
+  u8_t flow_pcb[TEST_UDP_REUSEPORT_FLOWS];
+  struct udp_pcb *conn;
+  struct test_udp_rxdata ctr_conn;
+  ip_addr_t remote;
+  const u16_t port = 4242;
+  const u32_t src_addr = PP_HTONL(LWIP_MAKEU32(192,168,0,2));
+  struct pbuf *p;
+  err_t err;
+  u32_t total;
+  int i, j;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < TEST_UDP_REUSEPORT_PCBS; i++) {
+    pcbs[i] = udp_new();
+    fail_unless(pcbs[i] != NULL);
+    memset(&ctrs[i], 0, sizeof(ctrs[i]));
+    ctrs[i].pcb = pcbs[i];
+    udp_recv(pcbs[i], test_recv, &ctrs[i]);
+  }
+  err = udp_bind(pcbs[0], NULL, port);
+  fail_unless(err == ERR_OK);
+  /* without SOF_REUSEPORT on both pcbs, the port is in use */
+  ip_set_option(pcbs[1], SOF_REUSEPORT);
+  err = udp_bind(pcbs[1], NULL, port);
+  fail_unless(err == ERR_USE);
+  ip_set_option(pcbs[0], SOF_REUSEPORT);
+  for (i = 1; i < TEST_UDP_REUSEPORT_PCBS; i++) {
+    ip_set_option(pcbs[i], SOF_REUSEPORT);
+    err = udp_bind(pcbs[i], NULL, port);
+    fail_unless(err == ERR_OK);
+  }
+
+  /* every flow goes to exactly one pcb, all pcbs get some flows */
+  for (i = 0; i < TEST_UDP_REUSEPORT_FLOWS; i++) {
+    p = test_udp_create_test_packet_from(16, src_addr, (u16_t)(10000 + i), test_ipaddr1.addr, port);
+    EXPECT_RET(p != NULL);
+    err = ip4_input(p, &test_netif1);
+    fail_unless(err == ERR_OK);
+    total = 0;
+    flow_pcb[i] = 0xff;
+    for (j = 0; j < TEST_UDP_REUSEPORT_PCBS; j++) {
+      total += ctrs[j].rx_cnt;
+      if (ctrs[j].rx_bytes != 0) {
+        flow_pcb[i] = (u8_t)j;
+        ctrs[j].rx_bytes = 0;
+      }
+    }
+    fail_unless(total == (u32_t)(i + 1));
+    fail_unless(flow_pcb[i] != 0xff);
+  }
+  for (j = 0; j < TEST_UDP_REUSEPORT_PCBS; j++) {
+    fail_unless(ctrs[j].rx_cnt > 0);
+  }
+
+  /* a flow sticks to its pcb */
+  for (i = 0; i < TEST_UDP_REUSEPORT_FLOWS; i++) {
+    p = test_udp_create_test_packet_from(16, src_addr, (u16_t)(10000 + i), test_ipaddr1.addr, port);
+    EXPECT_RET(p != NULL);
+    err = ip4_input(p, &test_netif1);
+    fail_unless(err == ERR_OK);
+    fail_unless(ctrs[flow_pcb[i]].rx_bytes == 16);
+    ctrs[flow_pcb[i]].rx_bytes = 0;
+  }
+
+  /* a connected pcb still gets its own flow */
+  conn = udp_new();
+  fail_unless(conn != NULL);
+  ip_set_option(conn, SOF_REUSEPORT);
+  err = udp_bind(conn, NULL, port);
+  fail_unless(err == ERR_OK);
+  ip_addr_set_ip4_u32_val(remote, src_addr);
+  err = udp_connect(conn, &remote, 10000);
+  fail_unless(err == ERR_OK);
+  memset(&ctr_conn, 0, sizeof(ctr_conn));
+  ctr_conn.pcb = conn;
+  udp_recv(conn, test_recv, &ctr_conn);
+  p = test_udp_create_test_packet_from(16, src_addr, 10000, test_ipaddr1.addr, port);
+  EXPECT_RET(p != NULL);
+  err = ip4_input(p, &test_netif1);
+  fail_unless(err == ERR_OK);
+  fail_unless(ctr_conn.rx_cnt == 1);
+  for (j = 0; j < TEST_UDP_REUSEPORT_PCBS; j++) {
+    fail_unless(ctrs[j].rx_bytes == 0);
+  }
+#undef TEST_UDP_REUSEPORT_PCBS
+#undef TEST_UDP_REUSEPORT_FLOWS
+}
+END_TEST
+#endif /* SO_REUSE_PORT */
+
 /** Create the suite including all tests for this module */
 Suite *
 udp_suite(void)
 {
   testfunc tests[] = {
     TESTFUNC(test_udp_new_remove),
-    TESTFUNC(test_udp_broadcast_rx_with_2_netifs)
+    TESTFUNC(test_udp_broadcast_rx_with_2_netifs),
+    TESTFUNC(test_udp_demux_many_ports),
+#if SO_REUSE_PORT
+    TESTFUNC(test_udp_reuseport),
+#endif /* SO_REUSE_PORT */
   };
   return create_suite("UDP", tests, sizeof(tests)/sizeof(testfunc), udp_setup, udp_teardown);
 }